@@ -0,0 +1,130 @@
+/**
+ * @file Async_output_buffer.cpp
+ * @author Jérôme Borme <jerome.borme@inl.int>
+ * @version 1.0
+ * @brief Implementation of class Async_output_buffer
+ * @date 2026-10-14 Jérôme Borme: Initial version
+ * @copyright
+ * This Source Code Form is subject to the terms of the Mozilla Public
+ * License, v. 2.0. If a copy of the MPL was not distributed with this
+ * file, You can obtain one at http://mozilla.org/MPL/2.0/.
+ */
+
+#include <algorithm>
+
+#include "Async_output_buffer.hh"
+
+const long_unsigned_int dpps::Async_output_buffer::block_size ;
+const long_unsigned_int dpps::Async_output_buffer::default_queue_depth ;
+
+dpps::Async_output_buffer::Async_output_buffer (
+    std::streambuf *destination,
+    const long_unsigned_int queue_depth) :
+    destination (destination),
+    queue_depth (std::max<long_unsigned_int> (queue_depth, 1)) {
+    filling. resize (block_size) ;
+    setp (filling. data (), filling. data () + filling. size ()) ;
+}
+
+dpps::Async_output_buffer::~Async_output_buffer () {
+    finish () ;
+}
+
+bool dpps::Async_output_buffer::write_block (const char *data,
+                                             const long_unsigned_int length) {
+    std::streamsize n {static_cast<std::streamsize> (length)} ;
+    return destination-> sputn (data, n) == n ;
+}
+
+bool dpps::Async_output_buffer::write_end () {
+    return destination-> pubsync () == 0 ;
+}
+
+void dpps::Async_output_buffer::run () {
+    std::unique_lock<std::mutex> lock (mutex) ;
+    while (true) {
+        condition. wait (lock, [this] {return !queue. empty () || stopping ;}) ;
+        if (!queue. empty ()) {
+            // The formatting thread only adds blocks at the back, so the
+            // front one is ours until it is removed.
+            std::vector<char> &block = queue. front () ;
+            busy = true ;
+            bool skip {failed} ;
+            lock. unlock () ;
+            bool ok {skip || write_block (block. data (), block. size ())} ;
+            lock. lock () ;
+            if (!ok)
+                failed = true ;
+            busy = false ;
+            spare. push_back (std::move (queue. front ())) ;
+            queue. pop_front () ;
+            condition. notify_all () ;
+        } else {
+            if (!failed) {
+                lock. unlock () ;
+                bool ok {write_end ()} ;
+                lock. lock () ;
+                if (!ok)
+                    failed = true ;
+            }
+            return ;
+        }
+    }
+}
+
+bool dpps::Async_output_buffer::hand_block () {
+    // The thread is started here rather than in the constructor, so that it
+    // never runs before the derived classes are built.
+    if (!worker. joinable ())
+        worker = std::thread (&Async_output_buffer::run, this) ;
+    std::unique_lock<std::mutex> lock (mutex) ;
+    condition. wait (lock, [this] {return queue. size () < queue_depth ;}) ;
+    if (failed)
+        return false ;
+    filling. resize (pptr () - pbase ()) ;
+    queue. push_back (std::move (filling)) ;
+    if (spare. empty ())
+        filling = std::vector<char> () ;
+    else {
+        // the capacity of a written block is kept
+        filling = std::move (spare. back ()) ;
+        spare. pop_back () ;
+    }
+    condition. notify_all () ;
+    lock. unlock () ;
+    filling. resize (block_size) ;
+    setp (filling. data (), filling. data () + filling. size ()) ;
+    return true ;
+}
+
+int dpps::Async_output_buffer::overflow (int c) {
+    if (finished || !hand_block ())
+        return traits_type::eof () ;
+    if (!traits_type::eq_int_type (c, traits_type::eof ())) {
+        *pptr () = traits_type::to_char_type (c) ;
+        pbump (1) ;
+    }
+    return traits_type::not_eof (c) ;
+}
+
+int dpps::Async_output_buffer::sync () {
+    // Handing a block at each flush would make the writers which end their
+    // lines with std::endl write one line at a time: the data reaches the
+    // destination with the next full block, or with finish().
+    return 0 ;
+}
+
+bool dpps::Async_output_buffer::finish () {
+    if (finished)
+        return !failed ;
+    bool ok {hand_block ()} ;
+    finished = true ;
+    {
+        std::lock_guard<std::mutex> lock (mutex) ;
+        stopping = true ;
+    }
+    condition. notify_all () ;
+    worker. join () ;
+    setp (nullptr, nullptr) ;
+    return ok && !failed ;
+}
@@ -0,0 +1,116 @@
+/**
+ * @file Async_output_buffer.hh
+ * @author Jérôme Borme <jerome.borme@inl.int>
+ * @version 1.0
+ * @brief Header file for class Async_output_buffer, a stream buffer which
+ * writes on a thread of its own
+ * @date 2026-10-14 Jérôme Borme: Initial version
+ * @copyright
+ * This Source Code Form is subject to the terms of the Mozilla Public
+ * License, v. 2.0. If a copy of the MPL was not distributed with this
+ * file, You can obtain one at http://mozilla.org/MPL/2.0/.
+ */
+#ifndef DPPS_ASYNC_OUTPUT_BUFFER
+#define DPPS_ASYNC_OUTPUT_BUFFER
+
+#include <condition_variable>
+#include <deque>
+#include <mutex>
+#include <streambuf>
+#include <thread>
+#include <vector>
+
+#include "common.hh"
+
+namespace dpps {
+/** @brief A stream buffer which passes what is written to it to another
+ * stream buffer, from a thread of its own.
+ *
+ * Writer installs it in front of the std::filebuf of its file when
+ * Writer::set_asynchronous() is called, so that the derived classes format
+ * the next block while the previous ones are written.
+ *
+ * The characters are collected in blocks of block_size. A full block is
+ * queued for the output thread; when queue_depth blocks are already
+ * waiting, the formatting thread waits, so that the memory stays bounded.
+ * finish() is the barrier which writes everything out: it must be called
+ * before the destination is closed.
+ *
+ * Flushing the stream does not force the data out, so that the writers which
+ * end their lines with std::endl still write whole blocks.
+ *
+ * Derived classes transform the blocks before they reach the destination by
+ * overriding write_block() and write_end(), such as Gzip_output_buffer. */
+class Async_output_buffer: public std::streambuf {
+protected:
+    std::streambuf *destination ;
+
+    /** @brief the block being filled, which is the put area. */
+    std::vector<char> filling ;
+
+    /** @brief the blocks waiting for the output thread, oldest first. */
+    std::deque<std::vector<char>> queue ;
+
+    /** @brief blocks already written, kept to reuse their memory. */
+    std::vector<std::vector<char>> spare ;
+
+    long_unsigned_int queue_depth ;
+
+    std::thread worker ;
+    std::mutex mutex ;
+    std::condition_variable condition ;
+
+    /** @brief whether the thread is writing a block taken from queue. */
+    bool busy {false} ;
+
+    /** @brief whether the thread has to write the end of the stream once
+     * queue is empty, then stop. */
+    bool stopping {false} ;
+
+    /** @brief whether write_block(), write_end() or the destination failed.
+     * The blocks queued afterwards are dropped. */
+    bool failed {false} ;
+
+    bool finished {false} ;
+
+    /** @brief the loop of the output thread. */
+    void run () ;
+
+    /** @brief writes length characters of data to destination. Called by the
+     * output thread only. Returns false on failure. */
+    virtual bool write_block (const char *data,
+                              const long_unsigned_int length) ;
+
+    /** @brief called by the output thread after the last block. By default,
+     * flushes destination. Returns false on failure. */
+    virtual bool write_end () ;
+
+    /** @brief waits until there is room in queue, then queues the put area.
+     * Starts the output thread the first time. */
+    bool hand_block () ;
+
+    int overflow (int c) ;
+    int sync () ;
+public:
+    /** @brief the size of the blocks handed to the output thread. */
+    static const long_unsigned_int block_size {1 << 20} ;
+
+    /** @brief the default number of blocks which may wait for the output
+     * thread. */
+    static const long_unsigned_int default_queue_depth {2} ;
+
+    /** @brief starts passing the data to destination. queue_depth must be at
+     * least 1, otherwise it is taken as 1. */
+    Async_output_buffer (std::streambuf *destination,
+        const long_unsigned_int queue_depth = default_queue_depth) ;
+
+    /** @brief calls finish() if it was not called. Derived classes call it
+     * in their own destructor, as the output thread uses their overrides. */
+    virtual ~Async_output_buffer () ;
+
+    /** @brief writes what remains and the end of the stream, and stops the
+     * thread. Returns false if anything could not be written. */
+    bool finish () ;
+} ;
+} // namespace dpps
+#endif
@@ -0,0 +1,46 @@
+/**
+ * @file Counter_random.cpp
+ * @author Jérôme Borme <jerome.borme@inl.int>
+ * @version 1.0
+ * @brief Implementation of class Counter_random
+ * @date 2026-10-14 Jérôme Borme: Initial version
+ * @copyright
+ * This Source Code Form is subject to the terms of the Mozilla Public
+ * License, v. 2.0. If a copy of the MPL was not distributed with this
+ * file, You can obtain one at http://mozilla.org/MPL/2.0/.
+ */
+
+#include "Counter_random.hh"
+
+// The constants of Philox4x32, from the reference given in the header.
+static const uint32_t philox_m0 {0xD2511F53} ;
+static const uint32_t philox_m1 {0xCD9E8D57} ;
+static const uint32_t philox_w0 {0x9E3779B9} ;
+static const uint32_t philox_w1 {0xBB67AE85} ;
+static const unsigned int philox_rounds {10} ;
+
+dpps::Counter_random::Counter_random (const uint64_t seed,
+                                      const uint64_t stream,
+                                      const uint32_t pass):
+    key {{static_cast<uint32_t> (seed), static_cast<uint32_t> (seed >> 32)}},
+    counter {{0, pass, static_cast<uint32_t> (stream),
+              static_cast<uint32_t> (stream >> 32)}} {
+}
+
+void dpps::Counter_random::generate_block () {
+    std::array<uint32_t, 4> c (counter) ;
+    std::array<uint32_t, 2> k (key) ;
+    for (unsigned int r {0} ; r < philox_rounds ; r++) {
+        uint64_t product0 {static_cast<uint64_t> (philox_m0) * c[0]} ;
+        uint64_t product1 {static_cast<uint64_t> (philox_m1) * c[2]} ;
+        c = {{static_cast<uint32_t> (product1 >> 32) ^ c[1] ^ k[0],
+              static_cast<uint32_t> (product1),
+              static_cast<uint32_t> (product0 >> 32) ^ c[3] ^ k[1],
+              static_cast<uint32_t> (product0)}} ;
+        k[0] += philox_w0 ;
+        k[1] += philox_w1 ;
+    }
+    block = c ;
+    // A stream has 2^32 blocks, far more than any polyline needs.
+    counter[0]++ ;
+}
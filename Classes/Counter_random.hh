@@ -0,0 +1,141 @@
+/**
+ * @file Counter_random.hh
+ * @author Jérôme Borme <jerome.borme@inl.int>
+ * @version 1.0
+ * @brief Header file for class Counter_random, a counter-based pseudorandom
+ * generator, and for Random_distributions
+ * @date 2026-10-14 Jérôme Borme: Initial version
+ * @copyright
+ * This Source Code Form is subject to the terms of the Mozilla Public
+ * License, v. 2.0. If a copy of the MPL was not distributed with this
+ * file, You can obtain one at http://mozilla.org/MPL/2.0/.
+ */
+#ifndef DPPS_COUNTER_RANDOM
+#define DPPS_COUNTER_RANDOM
+
+#include <array>
+#include <cstdint>
+#include <random>
+
+#include "common.hh"
+// for enum_distribution
+#include "Pattern.hh"
+
+namespace dpps {
+/** @brief A counter-based pseudorandom generator, Philox4x32-10.
+ *
+ * The numbers are a function of a key (the seed) and of a counter, so each
+ * stream (for instance each polyline) has its own generator, whose values do
+ * not depend on how many numbers were drawn from the other streams, nor in
+ * which order. Patterns can therefore be drawn in parallel and still be the
+ * same whatever the number of threads.
+ *
+ * It satisfies the requirements of a uniform random bit generator, so it
+ * can be used with the distributions of the standard library.
+ *
+ * Reference: J. K. Salmon, M. A. Moraes, R. O. Dror and D. E. Shaw,
+ * Parallel random numbers: as easy as 1, 2, 3, Proceedings of SC11 (2011).
+ * http://dx.doi.org/10.1145/2063384.2063405
+ */
+class Counter_random {
+public:
+    typedef uint32_t result_type ;
+    static constexpr result_type min () { return 0 ; }
+    static constexpr result_type max () { return 0xffffffff ; }
+protected:
+    std::array<uint32_t, 2> key ;
+    /** @brief the number of the next block in counter[0], then the pass and
+     * the stream. */
+    std::array<uint32_t, 4> counter ;
+    std::array<uint32_t, 4> block ;
+    unsigned int used {4} ;
+
+    /** @brief computes the block of the current counter and increments
+     * it. */
+    void generate_block () ;
+public:
+    /** @brief Constructor. pass allows several independent sets of streams
+     * with the same seed, for instance one for each call of a function. */
+    Counter_random (const uint64_t seed, const uint64_t stream,
+                    const uint32_t pass = 0) ;
+
+    result_type operator() () {
+        if (used == 4) {
+            generate_block () ;
+            used = 0 ;
+        }
+        return block[used++] ;
+    }
+} ;
+
+/** @brief The distributions of enum_distribution, to draw from any
+ * generator.
+ *
+ * The parametres are those of Pattern_random::generate() and
+ * Pattern::random_update_property(): p1 and p2, except for the uniform
+ * distribution, and for the location and scale of the normal and lognormal
+ * distributions, which are given separately.
+ */
+struct Random_distributions {
+    std::uniform_real_distribution<double> d0 ;
+    // Normal-type
+    std::normal_distribution<double> d1 ;
+    std::lognormal_distribution<double> d2 ;
+    std::chi_squared_distribution<double> d3 ;    // n
+    std::cauchy_distribution<double> d4 ;         // a, b
+    std::fisher_f_distribution<double> d5 ;       // m, n
+    std::student_t_distribution<double> d6 ;      // n
+    // Poisson-type
+    std::exponential_distribution<double> d7 ;    // lambda
+    std::gamma_distribution<double> d8 ;          // alpha, beta
+    std::weibull_distribution<double> d9 ;        // a, b
+
+    Random_distributions (const double p1, const double p2,
+                          const double uniform_min, const double uniform_max,
+                          const double location, const double scale):
+        d0 (uniform_min, uniform_max),
+        d1 (location, scale),
+        d2 (location, scale),
+        d3 (p1), d4 (p1, p2), d5 (p1, p2), d6 (p1),
+        d7 (p1), d8 (p1, p2), d9 (p1, p2) {
+    }
+
+    /** @brief makes the next values independent of the previous ones, which
+     * some distributions keep. */
+    void reset () {
+        d0. reset () ; d1. reset () ; d2. reset () ; d3. reset () ;
+        d4. reset () ; d5. reset () ; d6. reset () ; d7. reset () ;
+        d8. reset () ; d9. reset () ;
+    }
+
+    /** @brief draws a value from the distribution type. */
+    template <class Generator>
+    double draw (const enum_distribution type, Generator &generator) {
+        switch (type) {
+            case type_uniform_real_distribution: // 0
+                return d0 (generator) ;
+            case type_normal_distribution: // 1
+                return d1 (generator) ;
+            case type_lognormal_distribution: // 2
+                return d2 (generator) ;
+            case type_chi_squared_distribution: // 3
+                return d3 (generator) ;
+            case type_cauchy_distribution: // 4
+                return d4 (generator) ;
+            case type_fisher_f_distribution: // 5
+                return d5 (generator) ;
+            case type_student_t_distribution: // 6
+                return d6 (generator) ;
+            case type_exponential_distribution: // 7
+                return d7 (generator) ;
+            case type_gamma_distribution: // 8
+                return d8 (generator) ;
+            case type_weibull_distribution: // 9
+                return d9 (generator) ;
+            default:
+                return 0.0 ;
+        }
+    }
+} ;
+} // namespace dpps
+#endif
@@ -0,0 +1,124 @@
+/**
+ * @file Gzip_buffer.cpp
+ * @author Jérôme Borme <jerome.borme@inl.int>
+ * @version 1.0
+ * @brief Implementation of classes Gzip_output_buffer and Gzip_input_buffer
+ * @date 2026-10-14 Jérôme Borme: Initial version
+ * @copyright
+ * This Source Code Form is subject to the terms of the Mozilla Public
+ * License, v. 2.0. If a copy of the MPL was not distributed with this
+ * file, You can obtain one at http://mozilla.org/MPL/2.0/.
+ */
+
+#include <cstring>
+#include <string>
+
+#include "Gzip_buffer.hh"
+#include "bad_io.hh"
+
+const long_unsigned_int dpps::Gzip_input_buffer::block_size ;
+
+dpps::Gzip_output_buffer::Gzip_output_buffer (std::streambuf *destination,
+                                              const int level) :
+    Async_output_buffer (destination) {
+    std::memset (&stream, 0, sizeof (stream)) ;
+    // 16 added to the window size selects the gzip format.
+    if (deflateInit2 (&stream, level, Z_DEFLATED, 15 + 16, 8,
+                      Z_DEFAULT_STRATEGY) != Z_OK) {
+        // nothing to write for the destructor of Async_output_buffer
+        finished = true ;
+        std::string reason {"Gzip_output_buffer: zlib could not start the "
+                            "compression at level " + std::to_string (level)} ;
+        throw bad_io (reason. c_str ()) ;
+    }
+    compressed. resize (block_size / 4) ;
+}
+
+dpps::Gzip_output_buffer::~Gzip_output_buffer () {
+    finish () ;
+    deflateEnd (&stream) ;
+}
+
+bool dpps::Gzip_output_buffer::deflate_block (const char *data,
+                                              const long_unsigned_int length,
+                                              const int flush) {
+    stream. next_in = reinterpret_cast<Bytef *> (const_cast<char *> (data)) ;
+    stream. avail_in = static_cast<uInt> (length) ;
+    // deflate() is called until it leaves room in the output, which means
+    // that it took all the input (and wrote the end for Z_FINISH).
+    do {
+        stream. next_out = reinterpret_cast<Bytef *> (compressed. data ()) ;
+        stream. avail_out = static_cast<uInt> (compressed. size ()) ;
+        if (deflate (&stream, flush) == Z_STREAM_ERROR)
+            return false ;
+        std::streamsize produced {static_cast<std::streamsize> (
+            compressed. size () - stream. avail_out)} ;
+        if ((produced > 0) &&
+            (destination-> sputn (compressed. data (), produced) != produced))
+            return false ;
+    } while (stream. avail_out == 0) ;
+    return true ;
+}
+
+bool dpps::Gzip_output_buffer::write_block (const char *data,
+                                            const long_unsigned_int length) {
+    return deflate_block (data, length, Z_NO_FLUSH) ;
+}
+
+bool dpps::Gzip_output_buffer::write_end () {
+    return deflate_block (nullptr, 0, Z_FINISH) &&
+           Async_output_buffer::write_end () ;
+}
+
+dpps::Gzip_input_buffer::Gzip_input_buffer (std::streambuf *source) :
+    source (source) {
+    std::memset (&stream, 0, sizeof (stream)) ;
+    // 32 added to the window size accepts the gzip and zlib headers.
+    if (inflateInit2 (&stream, 15 + 32) != Z_OK)
+        throw bad_io ("Gzip_input_buffer: zlib could not start the "
+                      "decompression") ;
+    input. resize (block_size) ;
+    output. resize (block_size) ;
+    setg (output. data (), output. data (), output. data ()) ;
+}
+
+dpps::Gzip_input_buffer::~Gzip_input_buffer () {
+    inflateEnd (&stream) ;
+}
+
+int dpps::Gzip_input_buffer::underflow () {
+    if (gptr () < egptr ())
+        return traits_type::to_int_type (*gptr ()) ;
+    while (true) {
+        if ((stream. avail_in == 0) && !source_end) {
+            std::streamsize n {source-> sgetn (input. data (), input. size ())} ;
+            if (n <= 0)
+                source_end = true ;
+            stream. next_in = reinterpret_cast<Bytef *> (input. data ()) ;
+            stream. avail_in = static_cast<uInt> (n > 0 ? n : 0) ;
+        }
+        if ((stream. avail_in == 0) && source_end) {
+            if (inside_member)
+                throw bad_io ("Gzip_input_buffer: the compressed file ends "
+                              "before the end of its data") ;
+            return traits_type::eof () ;
+        }
+        stream. next_out = reinterpret_cast<Bytef *> (output. data ()) ;
+        stream. avail_out = static_cast<uInt> (output. size ()) ;
+        int result {inflate (&stream, Z_NO_FLUSH)} ;
+        if (result == Z_STREAM_END) {
+            // another gzip member may follow
+            inflateReset (&stream) ;
+            inside_member = false ;
+        } else if ((result == Z_OK) || (result == Z_BUF_ERROR))
+            inside_member = true ;
+        else
+            throw bad_io ("Gzip_input_buffer: the compressed data is not "
+                          "valid") ;
+        long_unsigned_int produced {output. size () - stream. avail_out} ;
+        if (produced > 0) {
+            setg (output. data (), output. data (), output. data () + produced) ;
+            return traits_type::to_int_type (*gptr ()) ;
+        }
+    }
+}
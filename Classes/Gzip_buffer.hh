@@ -0,0 +1,92 @@
+/**
+ * @file Gzip_buffer.hh
+ * @author Jérôme Borme <jerome.borme@inl.int>
+ * @version 1.0
+ * @brief Header file for the stream buffers which compress and decompress
+ * the .gz files
+ * @date 2026-10-14 Jérôme Borme: Initial version
+ * @copyright
+ * This Source Code Form is subject to the terms of the Mozilla Public
+ * License, v. 2.0. If a copy of the MPL was not distributed with this
+ * file, You can obtain one at http://mozilla.org/MPL/2.0/.
+ */
+#ifndef DPPS_GZIP_BUFFER
+#define DPPS_GZIP_BUFFER
+
+#include <streambuf>
+#include <vector>
+
+#include <zlib.h>
+
+#include "common.hh"
+#include "Async_output_buffer.hh"
+
+namespace dpps {
+/** @brief A stream buffer which compresses what is written to it in the gzip
+ * format, and passes the result to another stream buffer.
+ *
+ * Writer installs it in front of the std::filebuf of its file when the file
+ * name ends with .gz, so that the derived classes write to file as usual.
+ *
+ * As in Async_output_buffer, the blocks are deflated by the output thread
+ * while the next ones are being formatted. finish() must be called before
+ * the destination is closed. */
+class Gzip_output_buffer: public Async_output_buffer {
+protected:
+    z_stream stream ;
+
+    /** @brief the output of deflate(). */
+    std::vector<char> compressed ;
+
+    /** @brief deflates length characters of data with flush, and writes the
+     * result to destination. Called by the output thread only. */
+    bool deflate_block (const char *data, const long_unsigned_int length,
+                        const int flush) ;
+
+    bool write_block (const char *data, const long_unsigned_int length) ;
+    bool write_end () ;
+public:
+    /** @brief starts the compression to destination, with level from 1
+     * (fastest) to 9 (smallest). Throws bad_io if zlib cannot start. */
+    Gzip_output_buffer (std::streambuf *destination, const int level = 6) ;
+
+    /** @brief calls finish() if it was not called. */
+    ~Gzip_output_buffer () ;
+} ;
+
+/** @brief A stream buffer which decompresses the gzip data read from another
+ * stream buffer.
+ *
+ * Reader installs it in front of the std::filebuf of its file when the file
+ * name ends with .gz. Files made of several gzip members, as written by
+ * Writer in append mode, are read to the end. Invalid or truncated data
+ * throws bad_io. */
+class Gzip_input_buffer: public std::streambuf {
+protected:
+    std::streambuf *source ;
+    z_stream stream ;
+
+    /** @brief the compressed data read from source. */
+    std::vector<char> input ;
+
+    /** @brief the decompressed data, which is the get area. */
+    std::vector<char> output ;
+
+    /** @brief whether source has no more data. */
+    bool source_end {false} ;
+
+    /** @brief whether a gzip member was started and not ended. */
+    bool inside_member {false} ;
+
+    int underflow () ;
+public:
+    /** @brief the size of the blocks read and decompressed at once. */
+    static const long_unsigned_int block_size {1 << 20} ;
+
+    /** @brief Throws bad_io if zlib cannot start. */
+    Gzip_input_buffer (std::streambuf *source) ;
+
+    ~Gzip_input_buffer () ;
+} ;
+} // namespace dpps
+#endif
@@ -0,0 +1,163 @@
+/**
+ * @file Lattice_cells.cpp
+ * @author Jérôme Borme <jerome.borme@inl.int>
+ * @version 1.0
+ * @brief Implementation of class Lattice_cells
+ * @date 2026-10-14 Jérôme Borme: Initial version
+ * @copyright
+ * This Source Code Form is subject to the terms of the Mozilla Public
+ * License, v. 2.0. If a copy of the MPL was not distributed with this
+ * file, You can obtain one at http://mozilla.org/MPL/2.0/.
+ */
+
+#include <cmath>
+
+#include "Lattice_cells.hh"
+
+// The index from which value is at least estimate, clamped to [0, n], as a
+// starting point: the callers then correct it on the exact bounds.
+static long_unsigned_int clamped_index (const double estimate,
+                                        const long_unsigned_int n) {
+    if (!(estimate > 0))
+        return 0 ;
+    if (estimate >= n)
+        return n ;
+    return static_cast<long_unsigned_int> (estimate) ;
+}
+
+void dpps::Lattice_cells::Axis::range (const double minimum,
+                                       const double maximum,
+                                       long_unsigned_int &first,
+                                       long_unsigned_int &last) const {
+    if (absolute) {
+        bool inside {(low >= minimum) && (high <= maximum)} ;
+        first = 0 ;
+        last = inside ? number : 0 ;
+        return ;
+    }
+    // lower () and upper () increase with i, so that the cells inside are
+    // the ones from the first whose lower bound is above minimum to the last
+    // whose upper bound is below maximum. The estimates are only off by
+    // rounding.
+    first = clamped_index (ceil ((minimum - origin - low) / period), number) ;
+    while ((first > 0) && (lower (first - 1) >= minimum))
+        first-- ;
+    while ((first < number) && (lower (first) < minimum))
+        first++ ;
+    last = clamped_index (floor ((maximum - origin - high) / period) + 1,
+                          number) ;
+    while ((last < number) && (upper (last) <= maximum))
+        last++ ;
+    while ((last > first) && (upper (last - 1) > maximum))
+        last-- ;
+    if (last < first)
+        last = first ;
+}
+
+long_unsigned_int dpps::Lattice_cells::number_positions (const double minimum,
+                                                         const double maximum,
+                                                         const double period) {
+    long_unsigned_int n {static_cast<long_unsigned_int> (
+        ceil ((maximum - minimum) / period))} ;
+    // The division may be rounded either way.
+    while ((n > 0) && (minimum + (n - 1) * period >= maximum))
+        n-- ;
+    while (minimum + n * period < maximum)
+        n++ ;
+    return n ;
+}
+
+void dpps::Lattice_cells::set (const Axis &set_x, const Axis &set_y) {
+    x = set_x ;
+    y = set_y ;
+    materialized. clear () ;
+    number_materialized = 0 ;
+}
+
+long_unsigned_int dpps::Lattice_cells::total () const {
+    return x. number * y. number ;
+}
+
+long_unsigned_int dpps::Lattice_cells::size () const {
+    return total () - number_materialized ;
+}
+
+bool dpps::Lattice_cells::is_implicit (const long_unsigned_int i,
+                                       const long_unsigned_int j) const {
+    return materialized. empty () || !materialized[i * y. number + j] ;
+}
+
+bool dpps::Lattice_cells::limits (double &xmin, double &ymin,
+                                  double &xmax, double &ymax) const {
+    if (size () == 0)
+        return false ;
+    if (number_materialized == 0) {
+        xmin = x. lower (0) ;
+        ymin = y. lower (0) ;
+        xmax = x. upper (x. number - 1) ;
+        ymax = y. upper (y. number - 1) ;
+        return true ;
+    }
+    // The first and last columns and rows which still have implicit cells.
+    long_unsigned_int imin {x. number}, imax {0} ;
+    long_unsigned_int jmin {y. number}, jmax {0} ;
+    for_each_implicit ([&] (long_unsigned_int i, long_unsigned_int j) {
+        if (i < imin) imin = i ;
+        if (i > imax) imax = i ;
+        if (j < jmin) jmin = j ;
+        if (j > jmax) jmax = j ;
+    }) ;
+    xmin = x. lower (imin) ;
+    ymin = y. lower (jmin) ;
+    xmax = x. upper (imax) ;
+    ymax = y. upper (jmax) ;
+    return true ;
+}
+
+long_unsigned_int dpps::Lattice_cells::size_in_window (const double xmin,
+                                                       const double ymin,
+                                                       const double xmax,
+                                                       const double ymax)
+    const {
+    long_unsigned_int i0 {0}, i1 {0}, j0 {0}, j1 {0} ;
+    x. range (xmin, xmax, i0, i1) ;
+    y. range (ymin, ymax, j0, j1) ;
+    long_unsigned_int result {(i1 - i0) * (j1 - j0)} ;
+    if (number_materialized == 0)
+        return result ;
+    for (long_unsigned_int i {i0} ; i < i1 ; i++)
+        for (long_unsigned_int j {j0} ; j < j1 ; j++)
+            result -= !is_implicit (i, j) ;
+    return result ;
+}
+
+void dpps::Lattice_cells::materialize_window (const double xmin,
+                                              const double ymin,
+                                              const double xmax,
+                                              const double ymax,
+    const std::function<void (long_unsigned_int, long_unsigned_int)>
+        &function) {
+    long_unsigned_int i0 {0}, i1 {0}, j0 {0}, j1 {0} ;
+    x. range (xmin, xmax, i0, i1) ;
+    y. range (ymin, ymax, j0, j1) ;
+    if ((i0 == i1) || (j0 == j1))
+        return ;
+    if (materialized. empty ())
+        materialized. resize (total (), false) ;
+    for (long_unsigned_int i {i0} ; i < i1 ; i++)
+        for (long_unsigned_int j {j0} ; j < j1 ; j++)
+            if (!materialized[i * y. number + j]) {
+                function (i, j) ;
+                materialized[i * y. number + j] = true ;
+                number_materialized++ ;
+            }
+}
+
+void dpps::Lattice_cells::for_each_implicit (
+    const std::function<void (long_unsigned_int, long_unsigned_int)>
+        &function) const {
+    for (long_unsigned_int i {0} ; i < x. number ; i++)
+        for (long_unsigned_int j {0} ; j < y. number ; j++)
+            if (is_implicit (i, j))
+                function (i, j) ;
+}
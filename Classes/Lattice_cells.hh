@@ -0,0 +1,122 @@
+/**
+ * @file Lattice_cells.hh
+ * @author Jérôme Borme <jerome.borme@inl.int>
+ * @version 1.0
+ * @brief Header file for class Lattice_cells, the implicit cells of a
+ * procedural lattice
+ * @date 2026-10-14 Jérôme Borme: Initial version
+ * @copyright
+ * This Source Code Form is subject to the terms of the Mozilla Public
+ * License, v. 2.0. If a copy of the MPL was not distributed with this
+ * file, You can obtain one at http://mozilla.org/MPL/2.0/.
+ */
+#ifndef DPPS_LATTICE_CELLS
+#define DPPS_LATTICE_CELLS
+
+#include <functional>
+#include <vector>
+
+#include "common.hh"
+
+namespace dpps {
+/** @brief The cells of a lattice described by a few numbers, for the
+ * procedural mode of Pattern_rectangular_lattice and Pattern_grating.
+ *
+ * Cell (i, j), for i < x. number and j < y. number, has the bounding box
+ * from (x. lower (i), y. lower (j)) to (x. upper (i), y. upper (j)), which
+ * are computed with the same operations as the vertices of its polyline, so
+ * that the queries on windows give the same result as Pattern::select_window()
+ * on the polylines. The cells are numbered i * y. number + j, in the order
+ * in which the generators append them.
+ *
+ * The cells are implicit until they are materialized, i.e. appended as
+ * polylines to the pattern. Only the materialized cells use memory, one bit
+ * each once the first one is, and the queries are answered by index
+ * arithmetic while none is.
+ */
+class Lattice_cells {
+public:
+    /** @brief The positions of the cells along one axis: the cell i starts
+     * at origin + i period, and its bounding box goes from low to high
+     * relative to it. If absolute is set, all the cells go from low to high.
+     */
+    struct Axis {
+        double origin {0.0} ;
+        double period {1.0} ;
+        long_unsigned_int number {0} ;
+        double low {0.0} ;
+        double high {0.0} ;
+        bool absolute {false} ;
+
+        double start (const long_unsigned_int i) const {
+            return origin + i * period ;
+        }
+        double lower (const long_unsigned_int i) const {
+            if (absolute)
+                return low ;
+            // start + 0 is start, as in the polylines
+            return start (i) + low ;
+        }
+        double upper (const long_unsigned_int i) const {
+            if (absolute)
+                return high ;
+            return start (i) + high ;
+        }
+
+        /** @brief sets [first, last) to the cells whose bounding box is
+         * between minimum and maximum, included. */
+        void range (const double minimum, const double maximum,
+                    long_unsigned_int &first, long_unsigned_int &last) const ;
+    } ;
+
+    Axis x ;
+    Axis y ;
+
+protected:
+    /** @brief which cells are materialized, empty while none is. */
+    std::vector<bool> materialized ;
+    long_unsigned_int number_materialized {0} ;
+
+public:
+    /** @brief Number of positions minimum + i * period which are smaller
+     * than maximum, computed so that it does not depend on rounding. */
+    static long_unsigned_int number_positions (const double minimum,
+                                               const double maximum,
+                                               const double period) ;
+
+    /** @brief sets the axes, and makes all the cells implicit again. */
+    void set (const Axis &set_x, const Axis &set_y) ;
+
+    /** @brief the number of cells, implicit or not. */
+    long_unsigned_int total () const ;
+
+    /** @brief the number of implicit cells. */
+    long_unsigned_int size () const ;
+
+    bool is_implicit (const long_unsigned_int i,
+                      const long_unsigned_int j) const ;
+
+    /** @brief sets the limits of the implicit cells. Returns false, leaving
+     * them unchanged, if there is none. */
+    bool limits (double &xmin, double &ymin, double &xmax, double &ymax) const ;
+
+    /** @brief the number of implicit cells whose bounding box is inside the
+     * window. */
+    long_unsigned_int size_in_window (const double xmin, const double ymin,
+                                      const double xmax, const double ymax)
+        const ;
+
+    /** @brief calls function on the implicit cells whose bounding box is
+     * inside the window, in their order, and materializes them. */
+    void materialize_window (const double xmin, const double ymin,
+                             const double xmax, const double ymax,
+        const std::function<void (long_unsigned_int, long_unsigned_int)>
+            &function) ;
+
+    /** @brief calls function on the implicit cells, in their order. */
+    void for_each_implicit (
+        const std::function<void (long_unsigned_int, long_unsigned_int)>
+            &function) const ;
+} ;
+} // namespace dpps
+#endif
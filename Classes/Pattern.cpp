@@ -19,16 +19,30 @@
  */
 
 #include <algorithm>
+#include <cctype>
+#include <cstdlib>
 #include <functional>
 #include <iostream>
 #include <limits>
 #include <chrono>
 #include <cmath>
 #include <array>
+#include <deque>
+#include <exception>
+#include <iterator>
+#include <map>
+#include <sstream>
 
+#include "configure.h"
 #include "common.hh"
 #include "Pattern.hh"
 #include "Pattern_factory.hh"
+#include "Pattern_cache.hh"
+#include "Polygon_boolean.hh"
+#include "Prepared_polygon.hh"
+#include "Counter_random.hh"
+#include "Vertex_grid.hh"
+#include "Writer.hh"
 #include "bad_parametre.hh"
 
 dpps::Pattern::Pattern () {
@@ -46,37 +60,132 @@ dpps::Pattern::Pattern () {
 dpps::Pattern::~Pattern () {
 }
 
+void dpps::Pattern::set_random_seed (const long_unsigned_int seed) {
+    time_seed = seed ;
+    pseudorandom_generator. seed (time_seed) ;
+    counter_based_passes = 0 ;
+}
+
+void dpps::Pattern::set_counter_based_random (const bool counter_based) {
+    counter_based_random = counter_based ;
+}
+
 dpps::Pattern::Pattern (const Pattern &source):
     polylines (source. polylines),
+    cells (source. cells),
+    instances (source. instances),
     pseudorandom_generator (source. pseudorandom_generator),
-    time_seed (source. time_seed) {
+    time_seed (source. time_seed),
+    counter_based_random (source. counter_based_random),
+    counter_based_passes (source. counter_based_passes),
+    spatial_index_enabled (source. spatial_index_enabled) {
 }
 
 dpps::Pattern::Pattern (Pattern &&source):
     polylines (std::move (source. polylines)),
+    cells (std::move (source. cells)),
+    instances (std::move (source. instances)),
     pseudorandom_generator (
         std::move (source. pseudorandom_generator)),
-    time_seed (std::move (source. time_seed)) {
+    time_seed (std::move (source. time_seed)),
+    counter_based_random (source. counter_based_random),
+    counter_based_passes (source. counter_based_passes),
+    spatial_index_enabled (source. spatial_index_enabled),
+    spatial_index (std::move (source. spatial_index)) {
 }
 
 dpps::Pattern &dpps::Pattern::operator= (dpps::Pattern &&source) {
     if (this != &source) {
         polylines = std::move (source. polylines) ;
+        cells = std::move (source. cells) ;
+        instances = std::move (source. instances) ;
         pseudorandom_generator = source. pseudorandom_generator ;
         time_seed = source. time_seed ;
+        counter_based_random = source. counter_based_random ;
+        counter_based_passes = source. counter_based_passes ;
+        spatial_index_enabled = source. spatial_index_enabled ;
+        spatial_index = std::move (source. spatial_index) ;
     }
     return *this ;
 }
 
 dpps::Pattern &dpps::Pattern::operator= (const dpps::Pattern &source) {
     polylines = source. polylines ;
+    cells = source. cells ;
+    instances = source. instances ;
     pseudorandom_generator = source. pseudorandom_generator ;
     time_seed = source. time_seed ;
+    counter_based_random = source. counter_based_random ;
+    counter_based_passes = source. counter_based_passes ;
+    spatial_index_enabled = source. spatial_index_enabled ;
+    spatial_index. reset () ;
     return *this ;
 }
 
 void dpps::Pattern::generate () {}
 
+void dpps::Pattern::generate_each (
+    const std::function<void (const Polyline &)> &function) {
+    long_unsigned_int first {polylines. size ()} ;
+    generate () ;
+    for (long_unsigned_int i {first} ; i < polylines. size () ; i++)
+        function (polylines[i]) ;
+    polylines. resize (first) ;
+}
+
+long_unsigned_int dpps::Pattern::stream (Writer &writer,
+                                         const bool with_polylines) {
+    long_unsigned_int number_written {0} ;
+    writer. begin_stream () ;
+    if (with_polylines) {
+        // the reference &p is used to avoid copy
+        for (const Polyline &p: polylines)
+            writer. write_Polyline_stream (p) ;
+        number_written = polylines. size () ;
+    }
+    generate_each ([&] (const Polyline &p) {
+        writer. write_Polyline_stream (p) ;
+        number_written++ ;
+    }) ;
+    writer. end_stream () ;
+    return number_written ;
+}
+
+void dpps::Pattern::generate_cached (
+    const std::string &class_name,
+    const std::vector<bool> &vbool,
+    const std::vector<long_unsigned_int> &vint,
+    const std::vector<double> &vdouble,
+    const std::vector<std::string> &vstring,
+    const bool uses_random,
+    const std::function<void ()> &generator) {
+    if (!Pattern_cache::enabled ()) {
+        generator () ;
+        return ;
+    }
+    // Without random numbers, the seed must not prevent two runs from
+    // sharing the result.
+    std::ostringstream state_before ;
+    if (uses_random)
+        state_before << pseudorandom_generator ;
+    std::string key {Pattern_cache::key (class_name, vbool, vint, vdouble,
+                                         vstring, uses_random ? time_seed : 0,
+                                         state_before. str ())} ;
+    std::string state_after ;
+    if (Pattern_cache::load (key, *this, state_after)) {
+        invalidate_spatial_index () ;
+        if (uses_random)
+            std::istringstream (state_after) >> pseudorandom_generator ;
+        return ;
+    }
+    long_unsigned_int first {polylines. size ()} ;
+    generator () ;
+    std::ostringstream state ;
+    if (uses_random)
+        state << pseudorandom_generator ;
+    Pattern_cache::store (key, *this, first, state. str ()) ;
+}
+
 void dpps::Pattern::set_parametres (
                      const std::vector<bool> &vbool,
                      const std::vector<long_unsigned_int> &vint,
@@ -99,35 +208,40 @@ void dpps::Pattern::set_parametres (
 // Selection functions
 //////////////////////
 
+// The selection registers are combined as words of 64 polylines (see
+// Polyline_vector::selection_words()), whose bits past the last polyline
+// are kept to zero so that size() can count whole words.
+static void clear_trailing_bits (std::vector<uint64_t> &words,
+                                 const long_unsigned_int n) {
+    if ((n % 64 != 0) && (words. size () > 0))
+        words. back () &= (uint64_t {1} << (n % 64)) - 1 ;
+}
+
 void dpps::Pattern::select (
     const enum_logical_action action,
     const selection_t selection) {
 check_selection_not_negative_not_too_high(selection) ; ;
+    long_unsigned_int n {polylines. size ()} ;
     switch (action) {
-        case logical_action_all: // 0
-            std::for_each (polylines. begin (), polylines. end(),
-                [=] (Polyline &p) {
-                    p. selected [selection] = true ;
-                }) ;
-//             for (auto &p : polylines)
-//                 p. selected [selection] = true ;
+        case logical_action_all: { // 0
+            std::vector<uint64_t> &words =
+                polylines. modified_selection_words (selection, false) ;
+            std::fill (words. begin (), words. end (), ~uint64_t {0}) ;
+            clear_trailing_bits (words, n) ;
             break ;
+        }
         case logical_action_none: // 1
-            std::for_each (polylines. begin (), polylines. end(),
-                [=] (Polyline &p) {
-                    p. selected [selection] = false ;
-                }) ;
-//             for (auto &p : polylines)
-//                 p. selected [selection] = false ;
+            // the words are zero
+            polylines. modified_selection_words (selection, false) ;
             break ;
-        case logical_action_toggle: // 2
-            std::for_each (polylines. begin (), polylines. end(),
-                [=] (Polyline &p) {
-                    p. selected [selection] = !(p. selected [selection]) ;
-                }) ;
-//             for (auto &p : polylines)
-//                 p. selected [selection] = !(p. selected[selection]) ;
+        case logical_action_toggle: { // 2
+            std::vector<uint64_t> &words =
+                polylines. modified_selection_words (selection) ;
+            for (auto &w : words)
+                w = ~w ;
+            clear_trailing_bits (words, n) ;
             break ;
+        }
         // no need of default:, we did the whole enum.
     }
 }
@@ -167,6 +281,27 @@ void dpps::Pattern::select_window (const double xmin, const double ymin,
                         const bool dots_as_circles,
                         const selection_t selection) {
 check_selection_not_negative_not_too_high(selection) ;
+    if (spatial_index_enabled) {
+        // A dot drawn as a circle inside the window has its centre inside,
+        // so that it is among the candidates, and only its circle remains to
+        // be checked.
+        std::vector<long_unsigned_int> candidates ;
+        get_spatial_index (). inside (xmin, ymin, xmax, ymax, candidates) ;
+        for (auto i : candidates) {
+            // the reference &p is used to avoid copy
+            Polyline &p = polylines[i] ;
+            if (dots_as_circles && (p. size () == 1)) {
+                double radius {fabs (p. dose)} ;
+                if ((p. vertices[0]. x - radius < xmin) ||
+                    (p. vertices[0]. x + radius > xmax) ||
+                    (p. vertices[0]. y - radius < ymin) ||
+                    (p. vertices[0]. y + radius > ymax))
+                    continue ;
+            }
+            p. selected [selection] = true ;
+        }
+        return ;
+    }
     double temp_min_x {0.0} ;
     double temp_min_y {0.0} ;
     double temp_max_x {0.0} ;
@@ -202,6 +337,65 @@ void dpps::Pattern::select_window (const Vertex &min, const Vertex &max,
                         const selection_t selection) {
     select_window (min. x, min. y, max. x, max. y, dots_as_circles, selection) ;
 }
+
+long_unsigned_int dpps::Pattern::nearest_polyline (const Vertex &v,
+    const selection_t selection) const {
+check_selection_not_too_high(selection) ;
+    auto distance = [&] (const long_unsigned_int i) -> double {
+        if ((selection >= 0) && !polylines[i]. selected[selection])
+            return std::numeric_limits<double>::infinity () ;
+        return polylines[i]. distance_to (v) ;
+    } ;
+    if (spatial_index_enabled)
+        return get_spatial_index (). nearest (v, distance) ;
+    long_unsigned_int result {polylines. size ()} ;
+    double minimum {std::numeric_limits<double>::infinity ()} ;
+    for (long_unsigned_int i {0} ; i < polylines. size () ; i++) {
+        double d {distance (i)} ;
+        if (d < minimum) {
+            minimum = d ;
+            result = i ;
+        }
+    }
+    return result ;
+}
+
+void dpps::Pattern::set_spatial_index (const bool use) {
+    spatial_index_enabled = use ;
+    if (!use)
+        spatial_index. reset () ;
+}
+
+void dpps::Pattern::invalidate_spatial_index () {
+    spatial_index. reset () ;
+}
+
+const dpps::Polyline_index &dpps::Pattern::get_spatial_index () const {
+    if ((!spatial_index) || (spatial_index-> size () != polylines. size ()))
+        spatial_index. reset (new Polyline_index (polylines)) ;
+    return *spatial_index ;
+}
+
+void dpps::Pattern::select_inside (const Polyline &outline,
+                                   const selection_t selection) {
+check_selection_not_negative_not_too_high(selection) ;
+    Prepared_polygon polygon {outline} ;
+    for_each_selected (-1,
+        [&] (Polyline &p) {
+            if (polygon. contains (p))
+                p. selected[selection] = true ;
+        }) ;
+}
+
+void dpps::Pattern::select_self_crossing (const selection_t selection) {
+check_selection_not_negative_not_too_high(selection) ;
+    for_each_selected (-1,
+        [=] (Polyline &p) {
+            if (p. is_self_crossing ())
+                p. selected[selection] = true ;
+        }) ;
+}
+
 void dpps::Pattern::selection_next (const selection_t origin_selection,
                            const selection_t destination_selection,
                            const bool unselect_origin) {
@@ -332,21 +526,382 @@ check_selection_not_negative_not_too_high(selection) ;
 //     }
 }
 
+// The properties which select_where() knows, by name.
+struct Where_property_name {
+    const char *name ;
+    bool integer ;
+    dpps::enum_double_property double_property ;
+    dpps::enum_integer_property integer_property ;
+    bool parametre ;
+} ;
+
+static const std::array<Where_property_name, 20> where_property_names {{
+    {"minimum_x", false, dpps::double_property_minimum_x,
+        dpps::integer_property_position, false},
+    {"maximum_x", false, dpps::double_property_maximum_x,
+        dpps::integer_property_position, false},
+    {"minimum_y", false, dpps::double_property_minimum_y,
+        dpps::integer_property_position, false},
+    {"maximum_y", false, dpps::double_property_maximum_y,
+        dpps::integer_property_position, false},
+    {"centre_x", false, dpps::double_property_geometrical_centre_x,
+        dpps::integer_property_position, false},
+    {"centre_y", false, dpps::double_property_geometrical_centre_y,
+        dpps::integer_property_position, false},
+    {"distance_to_centre", false, dpps::double_property_distance_to_centre,
+        dpps::integer_property_position, false},
+    {"horizontal_size", false, dpps::double_property_horizontal_size,
+        dpps::integer_property_position, false},
+    {"vertical_size", false, dpps::double_property_vertical_size,
+        dpps::integer_property_position, false},
+    {"minimum_distance", false, dpps::double_property_minimum_distance,
+        dpps::integer_property_position, false},
+    {"maximum_distance", false, dpps::double_property_maximum_distance,
+        dpps::integer_property_position, false},
+    {"orientation", false, dpps::double_property_orientation_at_vertex,
+        dpps::integer_property_position, true},
+    {"turning_angle", false, dpps::double_property_turning_angle_at_vertex,
+        dpps::integer_property_position, true},
+    {"area", false, dpps::double_property_area,
+        dpps::integer_property_position, false},
+    {"perimeter", false, dpps::double_property_perimeter,
+        dpps::integer_property_position, false},
+    {"dose", false, dpps::double_property_dose,
+        dpps::integer_property_position, false},
+    {"vertices", true, dpps::double_property_minimum_x,
+        dpps::integer_property_number_vertices, false},
+    {"vertices_modulo", true, dpps::double_property_minimum_x,
+        dpps::integer_property_number_vertices_modulo, true},
+    {"closed", true, dpps::double_property_minimum_x,
+        dpps::integer_property_closeness, false},
+    {"reference", true, dpps::double_property_minimum_x,
+        dpps::integer_property_reference, false}
+}} ;
+
+// A property needed by an expression, computed once per polyline.
+struct Where_property {
+    long_unsigned_int name ;
+    long_unsigned_int parametre ;
+} ;
+
+// A comparison of the value of a property with a constant.
+struct Where_comparison {
+    long_unsigned_int property ;
+    dpps::enum_comparison_operator comparison_operator ;
+    double constant ;
+} ;
+
+// The expression is compiled to a postfix program: a comparison pushes its
+// result, and the operators pop their operands and push their result.
+typedef enum {
+    where_compare,
+    where_and,
+    where_or,
+    where_not
+} enum_where_instruction ;
+
+struct Where_instruction {
+    enum_where_instruction instruction ;
+    long_unsigned_int comparison ;
+} ;
+
+// A recursive descent parser of the expressions of select_where(), with
+// `or` binding less than `and`, which binds less than `not`.
+class Where_parser {
+public:
+    std::vector<Where_property> properties ;
+    std::vector<Where_comparison> comparisons ;
+    std::vector<Where_instruction> program ;
+
+    Where_parser (const std::string &set_expression) :
+        expression (set_expression) {
+        skip_spaces () ;
+        if (position == expression. size ())
+            fail ("the expression is empty") ;
+        parse_or () ;
+        if (position != expression. size ())
+            fail ("unexpected character") ;
+    }
+
+private:
+    const std::string &expression ;
+    std::string::size_type position {0} ;
+
+    [[noreturn]] void fail (const std::string &message) const {
+        std::string reason {"Pattern::select_where, " + message +
+            " at position " + std::to_string (position + 1) + " of \"" +
+            expression + "\"."} ;
+        throw dpps::bad_parametre (reason. c_str ()) ;
+    }
+
+    void skip_spaces () {
+        while ((position < expression. size ()) &&
+               isspace (static_cast<unsigned char> (expression[position])))
+            position++ ;
+    }
+
+    // Consumes symbol if the expression continues with it. Words only
+    // match when they are not the beginning of a longer name.
+    bool accept (const std::string &symbol) {
+        if (expression. compare (position, symbol. size (), symbol) != 0)
+            return false ;
+        std::string::size_type end {position + symbol. size ()} ;
+        if (isalpha (static_cast<unsigned char> (symbol[0])) &&
+            (end < expression. size ()) &&
+            (isalnum (static_cast<unsigned char> (expression[end])) ||
+             (expression[end] == '_')))
+            return false ;
+        position = end ;
+        skip_spaces () ;
+        return true ;
+    }
+
+    void parse_or () {
+        parse_and () ;
+        while (accept ("or") || accept ("||")) {
+            parse_and () ;
+            program. push_back ({where_or, 0}) ;
+        }
+    }
+
+    void parse_and () {
+        parse_not () ;
+        while (accept ("and") || accept ("&&")) {
+            parse_not () ;
+            program. push_back ({where_and, 0}) ;
+        }
+    }
+
+    void parse_not () {
+        // "!=" is not a negation, but it cannot start a comparison.
+        if (accept ("not") ||
+            ((expression. compare (position, 2, "!=") != 0) && accept ("!"))) {
+            parse_not () ;
+            program. push_back ({where_not, 0}) ;
+        } else if (accept ("(")) {
+            parse_or () ;
+            if (!accept (")"))
+                fail ("\")\" expected") ;
+        } else
+            parse_comparison () ;
+    }
+
+    double parse_number () {
+        const char *begin {expression. c_str () + position} ;
+        char *end {nullptr} ;
+        double result {strtod (begin, &end)} ;
+        if (end == begin)
+            fail ("number expected") ;
+        position += end - begin ;
+        skip_spaces () ;
+        return result ;
+    }
+
+    long_unsigned_int parse_property () {
+        std::string::size_type begin {position} ;
+        while ((position < expression. size ()) &&
+               (isalnum (static_cast<unsigned char> (expression[position])) ||
+                (expression[position] == '_')))
+            position++ ;
+        std::string name {expression. substr (begin, position - begin)} ;
+        long_unsigned_int found {0} ;
+        while ((found < where_property_names. size ()) &&
+               (name != where_property_names[found]. name))
+            found++ ;
+        if (found == where_property_names. size ()) {
+            position = begin ;
+            fail ("property expected") ;
+        }
+        skip_spaces () ;
+        Where_property property {found, 0} ;
+        if (where_property_names[found]. parametre) {
+            if (!accept ("("))
+                fail ("\"(\" expected after " + name) ;
+            double parametre {parse_number ()} ;
+            if ((parametre < 0) || (parametre != floor (parametre)))
+                fail ("the parametre of " + name + " must be an integer") ;
+            property. parametre = static_cast<long_unsigned_int> (parametre) ;
+            if ((where_property_names[found]. integer_property ==
+                    dpps::integer_property_number_vertices_modulo) &&
+                (property. parametre == 0))
+                fail ("vertices_modulo(0) is not defined") ;
+            if (!accept (")"))
+                fail ("\")\" expected") ;
+        }
+        // The same property is only computed once.
+        for (long_unsigned_int i {0} ; i < properties. size () ; i++)
+            if ((properties[i]. name == property. name) &&
+                (properties[i]. parametre == property. parametre))
+                return i ;
+        properties. push_back (property) ;
+        return properties. size () - 1 ;
+    }
+
+    // Returns the operator, or if swapped the one with its sides exchanged.
+    dpps::enum_comparison_operator parse_operator (const bool swapped) {
+        if (accept ("==") || accept ("="))
+            return dpps::comparison_operator_equal ;
+        if (accept ("!="))
+            return dpps::comparison_operator_different ;
+        if (accept ("<="))
+            return swapped ? dpps::comparison_operator_greater_equal :
+                             dpps::comparison_operator_lower_equal ;
+        if (accept (">="))
+            return swapped ? dpps::comparison_operator_lower_equal :
+                             dpps::comparison_operator_greater_equal ;
+        if (accept ("<"))
+            return swapped ? dpps::comparison_operator_strictly_greater :
+                             dpps::comparison_operator_strictly_lower ;
+        if (accept (">"))
+            return swapped ? dpps::comparison_operator_strictly_lower :
+                             dpps::comparison_operator_strictly_greater ;
+        fail ("comparison operator expected") ;
+    }
+
+    void parse_comparison () {
+        Where_comparison comparison ;
+        if (position == expression. size ())
+            fail ("comparison expected") ;
+        if ((position < expression. size ()) &&
+            (isalpha (static_cast<unsigned char> (expression[position])))) {
+            comparison. property = parse_property () ;
+            comparison. comparison_operator = parse_operator (false) ;
+            comparison. constant = parse_number () ;
+        } else {
+            comparison. constant = parse_number () ;
+            comparison. comparison_operator = parse_operator (true) ;
+            comparison. property = parse_property () ;
+        }
+        program. push_back ({where_compare, comparisons. size ()}) ;
+        comparisons. push_back (comparison) ;
+    }
+} ;
+
+void dpps::Pattern::select_where (const std::string &expression,
+                                  const double tolerance,
+                                  const selection_t selection) {
+check_selection_not_negative_not_too_high(selection) ;
+    Where_parser parser {expression} ;
+    const std::vector<Where_property> &properties {parser. properties} ;
+    const std::vector<Where_comparison> &comparisons {parser. comparisons} ;
+    const std::vector<Where_instruction> &program {parser. program} ;
+
+    // The double properties are computed by groups of the same parametre,
+    // so that get_double_properties() shares their passes on the vertices.
+    std::vector<long_unsigned_int> group_parametres ;
+    std::vector<std::vector<enum_double_property>> group_properties ;
+    std::vector<std::vector<long_unsigned_int>> group_indices ;
+    for (long_unsigned_int i {0} ; i < properties. size () ; i++) {
+        const Where_property_name &name {
+            where_property_names[properties[i]. name]} ;
+        if (name. integer)
+            continue ;
+        long_unsigned_int g {0} ;
+        while ((g < group_parametres. size ()) &&
+               (group_parametres[g] != properties[i]. parametre))
+            g++ ;
+        if (g == group_parametres. size ()) {
+            group_parametres. push_back (properties[i]. parametre) ;
+            group_properties. emplace_back () ;
+            group_indices. emplace_back () ;
+        }
+        group_properties[g]. push_back (name. double_property) ;
+        group_indices[g]. push_back (i) ;
+    }
+
+    long_unsigned_int n {polylines. size ()} ;
+    // The threads set the selection, so the shared polylines are duplicated
+    // here, once, and not by each thread.
+    polylines. detach () ;
+#ifdef OPENMP_FOUND
+    #pragma omp parallel if (n > 256)
+#endif
+    {
+        // The buffers of each thread, reused for all its polylines.
+        std::vector<double> values (properties. size ()) ;
+        std::vector<double> group_values ;
+        std::vector<bool> stack ;
+        stack. reserve (program. size ()) ;
+#ifdef OPENMP_FOUND
+        #pragma omp for schedule(dynamic, 64)
+#endif
+        for (long_unsigned_int k = 0 ; k < n ; k++) {
+            Polyline &p = polylines[k] ;
+            for (long_unsigned_int g {0} ; g < group_parametres. size () ; g++) {
+                p. get_double_properties (group_properties[g],
+                                          group_parametres[g], group_values) ;
+                for (long_unsigned_int j {0} ; j < group_indices[g]. size () ; j++)
+                    values[group_indices[g][j]] = group_values[j] ;
+            }
+            for (long_unsigned_int i {0} ; i < properties. size () ; i++)
+                if (where_property_names[properties[i]. name]. integer)
+                    values[i] = p. get_integer_property (
+                        where_property_names[properties[i]. name].
+                            integer_property,
+                        properties[i]. parametre) ;
+
+            stack. clear () ;
+            // the reference &instruction is used to avoid copy
+            for (const Where_instruction &instruction: program) {
+                if (instruction. instruction == where_not) {
+                    stack. back () = !stack. back () ;
+                    continue ;
+                }
+                if (instruction. instruction != where_compare) {
+                    bool q {stack. back ()} ;
+                    stack. pop_back () ;
+                    if (instruction. instruction == where_and)
+                        stack. back () = stack. back () && q ;
+                    else
+                        stack. back () = stack. back () || q ;
+                    continue ;
+                }
+                const Where_comparison &comparison {
+                    comparisons[instruction. comparison]} ;
+                double compared {values[comparison. property]} ;
+                // The integer properties are compared exactly.
+                double used_tolerance {
+                    where_property_names[properties[comparison. property].
+                        name]. integer ? 0.0 : tolerance} ;
+                bool result {false} ;
+                switch (comparison. comparison_operator) {
+                    case comparison_operator_equal:
+                        result = (fabs (compared - comparison. constant) <=
+                                  used_tolerance) ;
+                        break ;
+                    case comparison_operator_lower_equal:
+                        result = (compared <= comparison. constant) ;
+                        break ;
+                    case comparison_operator_greater_equal:
+                        result = (compared >= comparison. constant) ;
+                        break ;
+                    case comparison_operator_strictly_lower:
+                        result = (compared < comparison. constant) ;
+                        break ;
+                    case comparison_operator_strictly_greater:
+                        result = (compared > comparison. constant) ;
+                        break ;
+                    case comparison_operator_different:
+                        result = (fabs (compared - comparison. constant) >
+                                  used_tolerance) ;
+                        break ;
+                }
+                stack. push_back (result) ;
+            }
+            p. selected [selection] = stack. back () ;
+        }
+    }
+}
+
 void dpps::Pattern::selection_swap (const selection_t selection_p,
                                     const selection_t selection_q) {
 check_selection_not_negative_not_too_high(selection_p) ;
 check_selection_not_negative_not_too_high(selection_q) ;
-    std::for_each (polylines. begin (), polylines. end(),
-        [=] (Polyline &p) {
-            long_unsigned_int p_old {p. selected [selection_p]} ;
-            p. selected [selection_p] = p. selected [selection_q] ;
-            p. selected [selection_q] = p_old ;
-        }) ;
-//     for (auto &p : polylines) {
-//         long_unsigned_int p_old {p. selected [selection_p]} ;
-//         p. selected [selection_p] = p. selected [selection_q] ;
-//         p. selected [selection_q] = p_old ;
-//     }
+    if (selection_p == selection_q)
+        return ;
+    std::vector<uint64_t> &words_p =
+        polylines. modified_selection_words (selection_p) ;
+    words_p. swap (polylines. modified_selection_words (selection_q)) ;
 }
 
 void dpps::Pattern::selection_logical_operation (
@@ -357,19 +912,32 @@ void dpps::Pattern::selection_logical_operation (
 check_selection_not_negative_not_too_high(selection_p) ;
 check_selection_not_negative_not_too_high(selection_q) ;
 check_selection_not_negative_not_too_high(destination_selection) ;
-
-    std::for_each (polylines. begin (), polylines. end(),
-        [=] (Polyline &p) {
-            p. selected [destination_selection] =
-                logical_operation (p. selected [selection_p],
-                                p. selected [selection_q],
-                                logical_operator) ;
-        }) ;
-//     for (auto &p : polylines)
-//         p. selected [destination_selection] =
-//             logical_operation (p. selected [selection_p],
-//                                p. selected [selection_q],
-//                                logical_operator) ;
+    // The truth table of the operator, as masks of 64 bits, so that any of
+    // the operators is a combination of whole words. Index is 2*p+q.
+    std::array<uint64_t, 4> truth_table ;
+    for (unsigned short int k {0} ; k < 4 ; k++)
+        truth_table[k] = logical_operation (k >= 2, k % 2 == 1,
+                                            logical_operator) ?
+                         ~uint64_t {0} : uint64_t {0} ;
+    long_unsigned_int n {polylines. size ()} ;
+    const std::vector<uint64_t> &words_p =
+        polylines. selection_words (selection_p) ;
+    const std::vector<uint64_t> &words_q =
+        polylines. selection_words (selection_q) ;
+    std::vector<uint64_t> &destination =
+        polylines. modified_selection_words (destination_selection,
+            (destination_selection == selection_p) ||
+            (destination_selection == selection_q)) ;
+    // destination may be one of p and q, each word is read before it is
+    // written.
+    for (long_unsigned_int k {0} ; k < destination. size () ; k++) {
+        uint64_t p {words_p[k]}, q {words_q[k]} ;
+        destination[k] = (truth_table[0] & ~p & ~q) |
+                         (truth_table[1] & ~p &  q) |
+                         (truth_table[2] &  p & ~q) |
+                         (truth_table[3] &  p &  q) ;
+    }
+    clear_trailing_bits (destination, n) ;
 }
 
 void dpps::Pattern::select_uniform_pseudorandom (const double fraction,
@@ -389,22 +957,52 @@ check_selection_not_negative_not_too_high(selection) ;
 long_unsigned_int dpps::Pattern::size (
     const selection_t selection) const {
 check_selection_not_too_high(selection) ;
+    if (selection < 0)
+        return polylines. size () ;
     long_unsigned_int n {0} ;
-    // the reference &p is used to avoid copy
-    for (auto &p : polylines)
-        if ((selection < 0) || (p. selected[selection]))
-            n++ ;
+    for (auto w : polylines. selection_words (selection))
+        n += __builtin_popcountll (w) ;
     return n ;
 }
 
 // Iterated functions from Polyline
 ///////////////////////////////////
+void dpps::Pattern::for_each_selected (const selection_t selection,
+    const std::function<void (Polyline &)> &f) {
+    long_unsigned_int n {polylines. size ()} ;
+    if ((selection >= 0) && polylines. has_selection_words (selection)) {
+        // After the operations on whole registers, the words of the
+        // selection are at hand and the empty ones are skipped. They are
+        // copied, as detach() gives the registers back to the polylines.
+        std::vector<uint64_t> words {polylines. selection_words (selection)} ;
+        long_unsigned_int m {words. size ()} ;
+        // The shared polylines are duplicated here, not by the threads.
+        polylines. detach () ;
+#ifdef OPENMP_FOUND
+        #pragma omp parallel for schedule(dynamic, 1) if (n > 256)
+#endif
+        for (long_unsigned_int k = 0 ; k < m ; k++)
+            for (uint64_t w {words[k]} ; w != 0 ; w &= w - 1)
+                f (polylines[64 * k + __builtin_ctzll (w)]) ;
+        return ;
+    }
+    // The shared polylines are duplicated here, not by the threads.
+    polylines. detach () ;
+    // Small patterns are not worth starting threads.
+#ifdef OPENMP_FOUND
+    #pragma omp parallel for schedule(dynamic, 64) if (n > 256)
+#endif
+    for (long_unsigned_int i = 0 ; i < n ; i++)
+        if ((selection < 0) || polylines[i]. selected[selection])
+            f (polylines[i]) ;
+}
+
 void dpps::Pattern::symmetry_x (const double y0, const selection_t selection) {
 check_selection_not_too_high(selection) ;
-    std::for_each (polylines. begin (), polylines. end(),
+    invalidate_spatial_index () ;
+    for_each_selected (selection,
         [=] (Polyline &p) {
-            if ((selection < 0) || p. selected[selection])
-                p. symmetry_x (y0) ;
+            p. symmetry_x (y0) ;
         }) ;
 //     for (auto &p: polylines)
 //         if (p. selected[selection])
@@ -413,10 +1011,10 @@ check_selection_not_too_high(selection) ;
 
 void dpps::Pattern::symmetry_y (const double x0, const selection_t selection) {
 check_selection_not_too_high(selection) ;
-    std::for_each (polylines. begin (), polylines. end(),
+    invalidate_spatial_index () ;
+    for_each_selected (selection,
         [=] (Polyline &p) {
-            if ((selection < 0) || p. selected[selection])
-                p. symmetry_y (x0) ;
+            p. symmetry_y (x0) ;
         }) ;
 //     for (auto &p: polylines)
 //         if (p. selected[selection])
@@ -425,17 +1023,19 @@ check_selection_not_too_high(selection) ;
 
 void dpps::Pattern::symmetry_x_centred (const selection_t selection) {
 check_selection_not_too_high(selection) ;
-    for (auto &p: polylines)
-        if ((selection < 0) || p. selected[selection])
+    invalidate_spatial_index () ;
+    for_each_selected (selection,
+        [=] (Polyline &p) {
             p. symmetry_x_centred () ;
+        }) ;
 }
 
 void dpps::Pattern::symmetry_y_centred (const selection_t selection) {
 check_selection_not_too_high(selection) ;
-    std::for_each (polylines. begin (), polylines. end(),
+    invalidate_spatial_index () ;
+    for_each_selected (selection,
         [=] (Polyline &p) {
-            if ((selection < 0) || p. selected[selection])
-                p. symmetry_y_centred () ;
+            p. symmetry_y_centred () ;
         }) ;
 //     for (auto &p: polylines)
 //         if (p. selected[selection])
@@ -443,58 +1043,84 @@ check_selection_not_too_high(selection) ;
 }
 
 
+// Adds value to sum, keeping in compensation the rounding errors, with the
+// Kahan-Babuška (Neumaier) variant of compensated summation.
+static void compensated_add (double &sum, double &compensation,
+                             const double value) {
+    double t {sum + value} ;
+    if (fabs (sum) >= fabs (value))
+        compensation += (sum - t) + value ;
+    else
+        compensation += (value - t) + sum ;
+    sum = t ;
+}
+
+double dpps::Pattern::sum_selected (const selection_t selection,
+    const std::function<double (const Polyline &)> &f) const {
+    // The chunks do not depend on the number of threads.
+    const long_unsigned_int chunk_size {4096} ;
+    long_unsigned_int n {polylines. size ()} ;
+    long_unsigned_int chunks {(n + chunk_size - 1) / chunk_size} ;
+    std::vector<double> sums (chunks, 0.0) ;
+    std::vector<double> compensations (chunks, 0.0) ;
+#ifdef OPENMP_FOUND
+    #pragma omp parallel for schedule(dynamic, 1) if (chunks > 1)
+#endif
+    for (long_unsigned_int c = 0 ; c < chunks ; c++) {
+        long_unsigned_int end {std::min (n, (c + 1) * chunk_size)} ;
+        for (long_unsigned_int i {c * chunk_size} ; i < end ; i++)
+            if ((selection < 0) || polylines[i]. selected[selection])
+                compensated_add (sums[c], compensations[c], f (polylines[i])) ;
+    }
+    double sum {0.0} ;
+    double compensation {0.0} ;
+    for (long_unsigned_int c {0} ; c < chunks ; c++) {
+        compensated_add (sum, compensation, sums[c]) ;
+        compensated_add (sum, compensation, compensations[c]) ;
+    }
+    return sum + compensation ;
+}
+
 double dpps::Pattern::area (const selection_t selection) const {
 check_selection_not_too_high(selection) ;
-    double result {0.0} ;
-    for (auto &p: polylines)
-        if ((selection < 0) || p. selected[selection])
-            result += p. area () ;
-    return result ;
+    return sum_selected (selection, [] (const Polyline &p) {
+        return p. area () ;
+    }) ;
 }
 
 double dpps::Pattern::algebraic_area (const selection_t selection) const {
 check_selection_not_too_high(selection) ;
-    double result {0.0} ;
-    for (auto &p: polylines)
-        if ((selection < 0) || p. selected[selection])
-            result += p. algebraic_area () ;
-    return result ;
+    return sum_selected (selection, [] (const Polyline &p) {
+        return p. algebraic_area () ;
+    }) ;
 }
 
 double dpps::Pattern::perimeter (const selection_t selection) const {
 check_selection_not_too_high(selection) ;
-    double result {0.0} ;
-    for (auto &p: polylines)
-        if ((selection < 0) || p. selected[selection])
-            result += p. perimeter () ;
-    return result ;
+    return sum_selected (selection, [] (const Polyline &p) {
+        return p. perimeter () ;
+    }) ;
 }
 
 double dpps::Pattern::algebraic_perimeter (const selection_t selection) const {
 check_selection_not_too_high(selection) ;
-    double result {0.0} ;
-    for (auto &p: polylines)
-        if ((selection < 0) || p. selected[selection])
-            result += p. algebraic_perimeter () ;
-    return result ;
+    return sum_selected (selection, [] (const Polyline &p) {
+        return p. algebraic_perimeter () ;
+    }) ;
 }
 
 double dpps::Pattern::length (const selection_t selection) const {
 check_selection_not_too_high(selection) ;
-    double result {0.0} ;
-    for (auto &p: polylines)
-        if ((selection < 0) || p. selected[selection])
-            result += p. length () ;
-    return result ;
+    return sum_selected (selection, [] (const Polyline &p) {
+        return p. length () ;
+    }) ;
 }
 
 double dpps::Pattern::algebraic_length (const selection_t selection) const {
 check_selection_not_too_high(selection) ;
-    double result {0.0} ;
-    for (auto &p: polylines)
-        if ((selection < 0) || p. selected[selection])
-            result += p. algebraic_length () ;
-    return result ;
+    return sum_selected (selection, [] (const Polyline &p) {
+        return p. algebraic_length () ;
+    }) ;
 }
 
 /*long_unsigned_int dpps::Pattern::count (selection_t selection) const {
@@ -636,11 +1262,15 @@ double dpps::Pattern::vertical_size (const selection_t selection) const {
 
 long_unsigned_int dpps::Pattern::vertices_size (const selection_t selection) const {
 check_selection_not_too_high(selection) ;
+    long_unsigned_int n {polylines. size ()} ;
     long_unsigned_int count {0} ;
-    for (auto &p : polylines) {
-        if ((selection < 0) || p. selected[selection])
-            count += p. size () ;
-    }
+    // An integer sum does not depend on the order of the additions.
+#ifdef OPENMP_FOUND
+    #pragma omp parallel for schedule(static) reduction(+:count) if (n > 65536)
+#endif
+    for (long_unsigned_int i = 0 ; i < n ; i++)
+        if ((selection < 0) || polylines[i]. selected[selection])
+            count += polylines[i]. size () ;
     return count ;
 }
 
@@ -658,10 +1288,10 @@ check_selection_not_too_high(selection) ;
 
 void dpps::Pattern::scale_centred (const double fx, const double fy, const selection_t selection) {
 check_selection_not_too_high(selection) ;
-    std::for_each (polylines. begin (), polylines. end(),
+    invalidate_spatial_index () ;
+    for_each_selected (selection,
         [=] (Polyline &p) {
-            if ((selection < 0) || p. selected[selection])
-                p. scale_centred (fx, fy) ;
+            p. scale_centred (fx, fy) ;
         }) ;
 //     for (auto &p : polylines)
 //         if (p. selected[selection])
@@ -674,10 +1304,10 @@ void dpps::Pattern::scale_centred (const double f, const selection_t selection)
 
 void dpps::Pattern::scale (const Vertex &v, const double fx, const double fy, const selection_t selection) {
 check_selection_not_too_high(selection) ;
-    std::for_each (polylines. begin (), polylines. end(),
+    invalidate_spatial_index () ;
+    for_each_selected (selection,
         [=] (Polyline &p) {
-            if ((selection < 0) || p. selected[selection])
-                p. scale (v, fx, fy) ;
+            p. scale (v, fx, fy) ;
         }) ;
 //     for (auto &p : polylines)
 //         if (p. selected[selection])
@@ -699,10 +1329,10 @@ void dpps::Pattern::scale (const double x, const double y, const double f, const
 
 void dpps::Pattern::rotate_centred (const double angle, const selection_t selection) {
 check_selection_not_too_high(selection) ;
-    std::for_each (polylines. begin (), polylines. end(),
+    invalidate_spatial_index () ;
+    for_each_selected (selection,
         [=] (Polyline &p) {
-            if ((selection < 0) || p. selected[selection])
-                p. rotate_centred (angle) ;
+            p. rotate_centred (angle) ;
         }) ;
 //     for (auto &p : polylines)
 //         if (p. selected[selection])
@@ -711,10 +1341,10 @@ check_selection_not_too_high(selection) ;
 
 void dpps::Pattern::rotate (const Vertex &v, const double angle, const selection_t selection) {
 check_selection_not_too_high(selection) ;
-    std::for_each (polylines. begin (), polylines. end(),
+    invalidate_spatial_index () ;
+    for_each_selected (selection,
         [=] (Polyline &p) {
-            if ((selection < 0) || p. selected[selection])
-                p. rotate (v, angle) ;
+            p. rotate (v, angle) ;
         }) ;
 //     for (auto &p : polylines)
 //         if (p. selected[selection])
@@ -729,10 +1359,10 @@ void dpps::Pattern::rotate (const double x, const double y,
 
 void dpps::Pattern::transpose (const selection_t selection) {
 check_selection_not_too_high(selection) ;
-    std::for_each (polylines. begin (), polylines. end(),
+    invalidate_spatial_index () ;
+    for_each_selected (selection,
         [=] (Polyline &p) {
-            if ((selection < 0) || p. selected[selection])
-                p. transpose () ;
+            p. transpose () ;
         }) ;
 //     for (auto &p : polylines)
 //         if (p. selected[selection])
@@ -741,10 +1371,10 @@ check_selection_not_too_high(selection) ;
 
 void dpps::Pattern::translate (const Vertex &v, const selection_t selection) {
 check_selection_not_too_high(selection) ;
-    std::for_each (polylines. begin (), polylines. end(),
+    invalidate_spatial_index () ;
+    for_each_selected (selection,
         [=] (Polyline &p) {
-            if ((selection < 0) || p. selected[selection])
-                p. translate (v) ;
+            p. translate (v) ;
         }) ;
 //     for (auto &p : polylines)
 //         if (p. selected[selection])
@@ -758,10 +1388,10 @@ void dpps::Pattern::translate (const double x, const double y, const selection_t
 void dpps::Pattern::remove_consecutive_duplicated_vertices (
     const double precision, const selection_t selection) {
 check_selection_not_too_high(selection) ;
-    std::for_each (polylines. begin (), polylines. end(),
+    invalidate_spatial_index () ;
+    for_each_selected (selection,
         [=] (Polyline &p) {
-            if ((selection < 0) || p. selected[selection])
-                p. remove_consecutive_duplicated_vertices (precision) ;
+            p. remove_consecutive_duplicated_vertices (precision) ;
         }) ;
 //     for (auto &p : polylines)
 //         if (p. selected[selection])
@@ -770,10 +1400,10 @@ check_selection_not_too_high(selection) ;
 
 void dpps::Pattern::remove_duplicated_vertices (const double precision, const selection_t selection) {
 check_selection_not_too_high(selection) ;
-    std::for_each (polylines. begin (), polylines. end(),
+    invalidate_spatial_index () ;
+    for_each_selected (selection,
         [=] (Polyline &p) {
-            if ((selection < 0) || p. selected[selection])
-                p. remove_duplicated_vertices (precision) ;
+            p. remove_duplicated_vertices (precision) ;
         }) ;
 //     for (auto &p : polylines)
 //         if (p. selected[selection])
@@ -785,6 +1415,7 @@ void dpps::Pattern::replace_by (const Polyline &polyline,
                                 const bool keep_initial_properties,
                                 const selection_t selection) {
 check_selection_not_too_high(selection) ;
+    invalidate_spatial_index () ;
     std::for_each (polylines. begin (), polylines. end(),
         [=] (Polyline &p) {
             if ((selection < 0) || p. selected[selection]) {
@@ -808,6 +1439,7 @@ void dpps::Pattern::replace_polyline_by_pattern (const Pattern &pat,
                                                  const bool keep_initial_properties,
                                                  const selection_t selection) {
 check_selection_not_too_high(selection) ;
+    invalidate_spatial_index () ;
     std::vector<Polyline> result ;
     Vertex pattern_centre (0,0) ;
     if (centre)
@@ -830,11 +1462,210 @@ check_selection_not_too_high(selection) ;
     polylines = result ;
 }
 
+static dpps::Vertex placed_by (const dpps::Pattern::Instance &instance,
+                               const dpps::Vertex &v) {
+    double cos_angle {cos (instance. angle)},
+           sin_angle {sin (instance. angle)} ;
+    return dpps::Vertex (
+        instance. position. x +
+            instance. scale * (v. x * cos_angle - v. y * sin_angle),
+        instance. position. y +
+            instance. scale * (v. x * sin_angle + v. y * cos_angle)) ;
+}
+
+static std::string unique_cell_name (
+    const std::vector<dpps::Pattern::Cell> &cells,
+    const std::string &name) {
+    auto used = [&cells] (const std::string &s) {
+        return std::any_of (cells. begin (), cells. end (),
+            [&s] (const dpps::Pattern::Cell &c) {
+                return c. name == s ;
+            }) ;
+    } ;
+    std::string result {name} ;
+    for (long_unsigned_int i {1} ; used (result) ; i++)
+        result = name + "_" + std::to_string (i) ;
+    return result ;
+}
+
+dpps::Pattern::Instance dpps::Pattern::compose_instances (
+    const Instance &outer, const Instance &inner) {
+    Instance result (inner) ;
+    result. position = placed_by (outer, inner. position) ;
+    result. angle = outer. angle + inner. angle ;
+    result. scale = outer. scale * inner. scale ;
+    if (outer. override_properties) {
+        result. override_properties = true ;
+        result. properties = outer. properties ;
+    }
+    return result ;
+}
+
+void dpps::Pattern::expand_instance (const Instance &instance,
+    const std::function<void (const Polyline &)> &f) const {
+    const Cell &cell = cells[instance. cell] ;
+    // q is reused so that its vertices are not allocated for each polyline
+    Polyline q ;
+    for (auto &p: cell. polylines) {
+        q = p ;
+        if (instance. scale != 1)
+            q. scale (0, 0, instance. scale) ;
+        if (instance. angle != 0)
+            q. rotate (0, 0, instance. angle) ;
+        q. translate (instance. position) ;
+        if (instance. override_properties)
+            q. set_metadata_from (instance. properties) ;
+        f (q) ;
+    }
+    for (auto &i: cell. instances)
+        expand_instance (compose_instances (instance, i), f) ;
+}
+
+long_unsigned_int dpps::Pattern::add_cell (const std::string &name,
+                                           const Pattern &pattern) {
+    // Copied first, in case pattern is this pattern.
+    std::vector<Cell> added (pattern. cells) ;
+    Cell cell {name, pattern. polylines, pattern. instances} ;
+    long_unsigned_int offset {cells. size ()} ;
+    for (auto &c: added) {
+        for (auto &i: c. instances)
+            i. cell += offset ;
+        c. name = unique_cell_name (cells, c. name) ;
+        cells. push_back (std::move (c)) ;
+    }
+    for (auto &i: cell. instances)
+        i. cell += offset ;
+    cell. name = unique_cell_name (cells, name) ;
+    cells. push_back (std::move (cell)) ;
+    return cells. size () - 1 ;
+}
+
+void dpps::Pattern::add_instance (const long_unsigned_int cell,
+                                  const Vertex &position,
+                                  const double angle,
+                                  const double scale) {
+    if (cell >= cells. size ()) {
+        std::string reason {"Pattern::add_instance, there is no cell " +
+            std::to_string (cell) + ", the pattern has " +
+            std::to_string (cells. size ()) + " cells."} ;
+        throw bad_parametre (reason. c_str ()) ;
+    }
+    instances. push_back (Instance {cell, position, angle, scale, false,
+                                    Polyline ()}) ;
+}
+
+void dpps::Pattern::add_instance (const long_unsigned_int cell,
+                                  const double x, const double y,
+                                  const double angle,
+                                  const double scale) {
+    add_instance (cell, Vertex (x, y), angle, scale) ;
+}
+
+void dpps::Pattern::replace_polyline_by_instance (const Pattern &p,
+    const std::string &cell_name,
+    const bool centre,
+    const bool keep_initial_properties,
+    const selection_t selection) {
+check_selection_not_too_high(selection) ;
+    invalidate_spatial_index () ;
+    Vertex pattern_centre (0,0) ;
+    if (centre)
+        pattern_centre = p. geometrical_centre_polylines () ;
+    long_unsigned_int cell {add_cell (cell_name, p)} ;
+    auto replaced = [=] (const Polyline &q) {
+        return (selection < 0) || q. selected[selection] ;
+    } ;
+    for (auto &q : polylines)
+        if (replaced (q)) {
+            Instance instance {cell, Vertex (0, 0), 0, 1,
+                               keep_initial_properties, Polyline ()} ;
+            if (centre)
+                instance. position = q. geometrical_centre () - pattern_centre ;
+            instance. properties. set_metadata_from (q) ;
+            instances. push_back (instance) ;
+        }
+    polylines. erase (std::remove_if (polylines. begin (), polylines. end (),
+                                      replaced),
+                      polylines. end ()) ;
+}
+
+void dpps::Pattern::flatten (const selection_t selection) {
+    invalidate_spatial_index () ;
+    for_each_instance_polyline (
+        [this] (const Polyline &p) {
+            polylines. push_back (p) ;
+        }, selection) ;
+    instances. erase (std::remove_if (instances. begin (), instances. end (),
+        [=] (const Instance &i) {
+            return (selection < 0) || i. properties. selected[selection] ;
+        }), instances. end ()) ;
+}
+
+void dpps::Pattern::for_each_instance_polyline (
+    const std::function<void (const Polyline &)> &f,
+    const selection_t selection) const {
+check_selection_not_too_high(selection) ;
+    // the reference &i is used to avoid copy
+    for (auto &i: instances)
+        if ((selection < 0) || i. properties. selected[selection])
+            expand_instance (i, f) ;
+}
+
+bool dpps::Pattern::instances_limits (Vertex &min, Vertex &max,
+                                      const selection_t selection) const {
+check_selection_not_too_high(selection) ;
+    min = Vertex (std::numeric_limits<double>::max (),
+                  std::numeric_limits<double>::max ()) ;
+    max = Vertex (std::numeric_limits<double>::lowest (),
+                  std::numeric_limits<double>::lowest ()) ;
+    std::vector<Vertex> cell_min (cells. size (), min) ;
+    std::vector<Vertex> cell_max (cells. size (), max) ;
+    std::vector<bool> cell_found (cells. size (), false) ;
+    auto add_instance_limits = [&] (const Instance &i,
+                                    Vertex &box_min, Vertex &box_max) {
+        if (!cell_found[i. cell])
+            return false ;
+        const Vertex &a = cell_min[i. cell] ;
+        const Vertex &b = cell_max[i. cell] ;
+        for (auto &corner: {Vertex (a. x, a. y), Vertex (b. x, a. y),
+                            Vertex (b. x, b. y), Vertex (a. x, b. y)}) {
+            Vertex v {placed_by (i, corner)} ;
+            box_min. x = std::min (box_min. x, v. x) ;
+            box_min. y = std::min (box_min. y, v. y) ;
+            box_max. x = std::max (box_max. x, v. x) ;
+            box_max. y = std::max (box_max. y, v. y) ;
+        }
+        return true ;
+    } ;
+    // The instances of a cell only refer to the cells before it, whose
+    // limits are therefore known.
+    for (long_unsigned_int c {0} ; c < cells. size () ; c++) {
+        for (auto &p: cells[c]. polylines)
+            if (!p. vertices. empty ()) {
+                cell_found[c] = true ;
+                cell_min[c]. x = std::min (cell_min[c]. x, p. minimum_x ()) ;
+                cell_min[c]. y = std::min (cell_min[c]. y, p. minimum_y ()) ;
+                cell_max[c]. x = std::max (cell_max[c]. x, p. maximum_x ()) ;
+                cell_max[c]. y = std::max (cell_max[c]. y, p. maximum_y ()) ;
+            }
+        for (auto &i: cells[c]. instances)
+            if (add_instance_limits (i, cell_min[c], cell_max[c]))
+                cell_found[c] = true ;
+    }
+    bool found {false} ;
+    for (auto &i: instances)
+        if ((selection < 0) || i. properties. selected[selection])
+            if (add_instance_limits (i, min, max))
+                found = true ;
+    return found ;
+}
+
 void dpps::Pattern::replace_by_regular_polygon (
     const long_unsigned_int number_vertices,
     const double diametre,
     const bool keep_initial_properties,
     const selection_t selection) {
+    invalidate_spatial_index () ;
     // We create the polyline and then iterate on Polyline::replace_by()
     // instead of iterating on Polyline::replace_by_regular_polygon() in order
     // to create the polyline just one time and save on expensive cos() and
@@ -846,31 +1677,40 @@ void dpps::Pattern::replace_by_regular_polygon (
 void dpps::Pattern::explode_in_vertices (const bool keep_initial,
                                          const selection_t selection) {
 check_selection_not_too_high(selection) ;
-    std::vector<Polyline> result ;
+    invalidate_spatial_index () ;
     long_unsigned_int current_size {polylines. size ()} ;
     if (current_size == 0)
         return ;
+    long_unsigned_int number {0} ;
+    for (long_unsigned_int i {0} ; i < current_size ; i++)
+        if ((selection < 0) || polylines[i]. selected[selection])
+            number += polylines[i]. size () ;
+    std::vector<Polyline> result ;
+    result. reserve (number) ;
     for (long_unsigned_int i {0} ; i < current_size ; i++) {
         if ((selection < 0) || polylines[i]. selected[selection]) {
-        //if (polylines[i]. selected[selection]) {
-            Polyline p {polylines[i]} ;
-            // p. selected [selection] = false ;
-            long_unsigned_int number_vertices {p. size ()} ;
-            for (long_unsigned_int j {0} ; j < number_vertices ; j++) {
-                p. vertices. clear () ;
-                p. vertices. push_back (polylines[i]. vertices[j]) ;
-                result. push_back (p) ;
+            // The copies of the emptied model have all the properties of
+            // the polyline, and only allocate their own vertex.
+            Polyline model {polylines[i]} ;
+            model. vertices. clear () ;
+            // the reference &v is used to avoid copy
+            for (auto &v : polylines[i]. vertices) {
+                result. push_back (model) ;
+                result. back (). vertices. push_back (v) ;
             }
         }
     }
     if (!keep_initial)
         erase (selection) ;
-    polylines. insert (polylines. end (), result. begin(), result. end()) ;
+    polylines. insert (polylines. end (),
+                      std::make_move_iterator (result. begin ()),
+                      std::make_move_iterator (result. end ())) ;
 }
 
 void dpps::Pattern::explode (const bool keep_initial,
                                          const selection_t selection) {
 check_selection_not_too_high(selection) ;
+    invalidate_spatial_index () ;
     std::vector<Polyline> result ;
     long_unsigned_int current_size {polylines. size ()} ;
     if (current_size == 0)
@@ -879,96 +1719,426 @@ check_selection_not_too_high(selection) ;
         if ((selection < 0) || (polylines[i]. selected[selection])) {
             Pattern q {Pattern_factory::explode (polylines[i])} ;
             result. insert (result. end (),
-                            q. polylines. cbegin (),
-                            q. polylines. cend ()) ;
+                            std::make_move_iterator (q. polylines. begin ()),
+                            std::make_move_iterator (q. polylines. end ())) ;
         }
     }
     if (!keep_initial)
         erase (selection) ;
-    polylines. insert (polylines. end (), result. begin(), result. end()) ;
+    polylines. insert (polylines. end (),
+                      std::make_move_iterator (result. begin ()),
+                      std::make_move_iterator (result. end ())) ;
 }
 
-void dpps::Pattern::fill_with_lines (
-    const double angle,
-    const double spacing,
+void dpps::Pattern::replace_selected (
+    const std::function<Pattern (const Polyline &)> &f,
     const bool keep_initial,
     const selection_t selection) {
-check_selection_not_too_high(selection) ;
+    invalidate_spatial_index () ;
+    long_unsigned_int n {polylines. size ()} ;
+    // f gets the polylines from the non-const operator[] in the threads,
+    // so the shared polylines are duplicated here, not by each thread.
+    polylines. detach () ;
+    std::vector<Pattern> replacements (n) ;
+    std::vector<std::exception_ptr> errors (n) ;
+#ifdef OPENMP_FOUND
+    #pragma omp parallel for schedule(dynamic, 1) if (n > 16)
+#endif
+    for (long_unsigned_int i = 0 ; i < n ; i++)
+        if ((selection < 0) || polylines[i]. selected[selection]) {
+            try {
+                replacements[i] = f (polylines[i]) ;
+            } catch (...) {
+                errors[i] = std::current_exception () ;
+            }
+        }
+    long_unsigned_int number {0} ;
+    for (long_unsigned_int i = 0 ; i < n ; i++) {
+        if (errors[i])
+            std::rethrow_exception (errors[i]) ;
+        if ((selection < 0) || polylines[i]. selected[selection])
+            number += replacements[i]. polylines. size () +
+                      (keep_initial ? 1 : 0) ;
+        else
+            number++ ;
+    }
     std::vector<Polyline> result ;
-    for (auto &i : polylines)
-        if ((selection < 0) || (i. selected[selection])) {
-            Pattern p {Pattern_factory::fill_with_lines (i, angle, spacing)} ;
+    result. reserve (number) ;
+    for (long_unsigned_int i = 0 ; i < n ; i++)
+        if ((selection < 0) || polylines[i]. selected[selection]) {
             if (keep_initial)
-                polylines. push_back (i) ;
-            polylines. insert (polylines. end (),
-                               p. polylines. begin(),
-                               p. polylines. end()) ;
-
-        } else
-            result. push_back (i) ;
-/*    long_unsigned_int initial_size {polylines. size ()} ;
-    for (long_unsigned_int i {0} ; i < initial_size ; i++) {
-        Polyline element = *(polylines. begin ()) ;
-        polylines. pop_front () ;
-        // we remove a polyline from the front, it will be processed and
-        // then added to the back.
-        if (element. selected[selection]) {
-            // If the polyline was selected, we transform it and insert the
-            // resulting vector of polylines at the end of the vector.
-            // Resulting polylines are selected
-            Pattern result {Pattern_factory::fill_with_lines
-                                                    (element, angle, spacing)} ;
-            polylines. insert (polylines. end (),
-                               result. polylines. begin(),
-                               result. polylines. end()) ;
-            if (keep_initial) {
-                // To keep the initial polylines, we just put it back in the end
-                polylines. push_back (element) ;
-            }
+                result. push_back (std::move (polylines[i])) ;
+            std::move (replacements[i]. polylines. begin (),
+                       replacements[i]. polylines. end (),
+                       std::back_inserter (result)) ;
         } else
-            // if polyline was not selected, we just put it
-            // at the other end of the vector.
-            polylines. push_back (element) ;
-    }*/
+            result. push_back (std::move (polylines[i])) ;
+    polylines = std::move (result) ;
+}
+
+void dpps::Pattern::fill_with_lines (
+    const double angle,
+    const double spacing,
+    const bool keep_initial,
+    const selection_t selection,
+    const enum_fill_rule fill_rule) {
+check_selection_not_too_high(selection) ;
+    invalidate_spatial_index () ;
+    replace_selected (
+        [=] (const Polyline &p) {
+            return Pattern_factory::fill_with_lines (p, angle, spacing,
+                                                     fill_rule) ;
+        }, keep_initial, selection) ;
 }
 
 void dpps::Pattern::fill_with_lines_first_angle (
     const double spacing,
     const bool keep_initial,
+    const selection_t selection,
+    const enum_fill_rule fill_rule) {
+check_selection_not_too_high(selection) ;
+    invalidate_spatial_index () ;
+    replace_selected (
+        [=] (const Polyline &p) {
+            return Pattern_factory::fill_with_lines_first_angle (
+                p, spacing, fill_rule) ;
+        }, keep_initial, selection) ;
+}
+
+void dpps::Pattern::fill_with_dashes (
+            const double angle,
+            const double spacing_longitudinal,
+            const double spacing_transversal,
+            const double duty_cycle,
+            const double phase_initial,
+            const double phase_increment,
+            const enum_partial_dash_policy partial_dash_policy,
+            const bool keep_initial,
+            const selection_t selection,
+            const enum_fill_rule fill_rule) {
+check_selection_not_too_high(selection) ;
+    invalidate_spatial_index () ;
+    replace_selected (
+        [=] (const Polyline &p) {
+            return Pattern_factory::fill_with_dashes
+                  (p, angle, spacing_longitudinal, spacing_transversal,
+                   duty_cycle, phase_initial, phase_increment,
+                   partial_dash_policy, fill_rule) ;
+        }, keep_initial, selection) ;
+}
+
+void dpps::Pattern::fill_with_dashes_first_angle (
+           const double spacing_longitudinal,
+           const double spacing_transversal,
+           const double duty_cycle,
+           const double phase_initial,
+           const double phase_increment,
+           const enum_partial_dash_policy partial_dash_policy,
+           const bool keep_initial,
+           const selection_t selection,
+           const enum_fill_rule fill_rule) {
+check_selection_not_too_high(selection) ;
+    invalidate_spatial_index () ;
+    replace_selected (
+        [=] (const Polyline &p) {
+            return Pattern_factory::fill_with_dashes_first_angle (
+                    p, spacing_longitudinal, spacing_transversal,
+                    duty_cycle, phase_initial, phase_increment,
+                    partial_dash_policy, fill_rule) ;
+        }, keep_initial, selection) ;
+}
+
+void dpps::Pattern::fill_region_with_lines (
+    const double angle,
+    const double spacing,
+    const enum_fill_rule fill_rule,
+    const bool keep_initial,
     const selection_t selection) {
 check_selection_not_too_high(selection) ;
-    std::vector<Polyline> result ;
-    for (auto &i : polylines)
-        if ((selection < 0) || (i. selected[selection])) {
-            Pattern p {Pattern_factory::fill_with_lines_first_angle (
-                                i, spacing)} ;
-            if (keep_initial)
-                polylines. push_back (i) ;
-            polylines. insert (polylines. end (),
-                               p. polylines. begin(),
-                               p. polylines. end()) ;
+    invalidate_spatial_index () ;
+    Pattern lines {Pattern_factory::fill_region_with_lines (
+        *this, angle, spacing, fill_rule, selection)} ;
+    if (!keep_initial)
+        erase (selection) ;
+    append_from (lines) ;
+}
+
+void dpps::Pattern::boolean_operation (
+    const enum_boolean_operation operation,
+    const selection_t selection_a,
+    const selection_t selection_b,
+    const bool keep_initial) {
+check_selection_not_too_high(selection_a) ;
+check_selection_not_too_high(selection_b) ;
+    invalidate_spatial_index () ;
+    Pattern result {Pattern_factory::boolean_operation (
+        *this, operation, selection_a, selection_b)} ;
+    if (!keep_initial)
+        polylines. erase (std::remove_if (polylines. begin (), polylines. end (),
+            [=] (const Polyline &p) {
+                return p. closed && (p. size () >= 3) &&
+                    ((selection_a < 0) || (selection_b < 0) ||
+                     p. selected[selection_a] || p. selected[selection_b]) ;
+            }), polylines. end ()) ;
+    append_from (result) ;
+}
+
+void dpps::Pattern::boolean_union (const selection_t selection) {
+    boolean_operation (boolean_operation_union, selection, selection) ;
+}
+
+void dpps::Pattern::boolean_intersection (const selection_t selection_a,
+                                          const selection_t selection_b) {
+    boolean_operation (boolean_operation_intersection, selection_a, selection_b) ;
+}
+
+void dpps::Pattern::boolean_difference (const selection_t selection_a,
+                                        const selection_t selection_b) {
+    boolean_operation (boolean_operation_difference, selection_a, selection_b) ;
+}
+
+void dpps::Pattern::boolean_xor (const selection_t selection_a,
+                                 const selection_t selection_b) {
+    boolean_operation (boolean_operation_xor, selection_a, selection_b) ;
+}
+
+// Liang and Barsky: restricts a + t (b - a), t in [0, 1], to the rectangle,
+// and returns false if nothing is left.
+static bool clip_segment (const dpps::Vertex &a, const dpps::Vertex &b,
+                          const double xmin, const double ymin,
+                          const double xmax, const double ymax,
+                          double &t0, double &t1) {
+    const double p[4] {a. x - b. x, b. x - a. x, a. y - b. y, b. y - a. y} ;
+    const double q[4] {a. x - xmin, xmax - a. x, a. y - ymin, ymax - a. y} ;
+    t0 = 0.0 ;
+    t1 = 1.0 ;
+    for (int k {0} ; k < 4 ; k++) {
+        if (p[k] == 0.0) {
+            if (q[k] < 0.0)
+                return false ;
+            continue ;
+        }
+        double r {q[k] / p[k]} ;
+        if (p[k] < 0.0) {
+            if (r > t1)
+                return false ;
+            if (r > t0)
+                t0 = r ;
+        } else {
+            if (r < t0)
+                return false ;
+            if (r < t1)
+                t1 = r ;
+        }
+    }
+    return true ;
+}
+
+// Appends to pieces the parts of p inside the rectangle, with the metadata
+// of p.
+static void clip_to_field (const dpps::Polyline &p,
+                           const double xmin, const double ymin,
+                           const double xmax, const double ymax,
+                           std::vector<dpps::Polyline> &pieces) {
+    dpps::Polyline empty ;
+    empty. set_metadata_from (p) ;
+    if (p. closed && (p. size () >= 3)) {
+        dpps::Polyline field {empty} ;
+        field. push_back (dpps::Vertex (xmin, ymin)) ;
+        field. push_back (dpps::Vertex (xmax, ymin)) ;
+        field. push_back (dpps::Vertex (xmax, ymax)) ;
+        field. push_back (dpps::Vertex (xmin, ymax)) ;
+        dpps::Polygon_boolean computed {{&p}, {&field},
+            dpps::boolean_operation_intersection} ;
+        // the reference &contour is used to avoid copy
+        for (auto &contour: computed. contours ()) {
+            pieces. push_back (empty) ;
+            pieces. back (). vertices = contour ;
+        }
+        return ;
+    }
+    // A closed polyline of two vertices goes back along the same segment.
+    empty. closed = false ;
+    dpps::Polyline piece {empty} ;
+    auto flush = [&] {
+        if ((piece. size () > 2) || ((piece. size () == 2) &&
+            ((piece. vertices[0]. x != piece. vertices[1]. x) ||
+             (piece. vertices[0]. y != piece. vertices[1]. y))))
+            pieces. push_back (piece) ;
+        piece = empty ;
+    } ;
+    double t0 {0.0}, t1 {1.0} ;
+    for (long_unsigned_int k {0} ; k + 1 < p. size () ; k++) {
+        const dpps::Vertex &a = p. vertices[k] ;
+        const dpps::Vertex &b = p. vertices[k + 1] ;
+        if (!clip_segment (a, b, xmin, ymin, xmax, ymax, t0, t1)) {
+            flush () ;
+            continue ;
+        }
+        if ((piece. size () == 0) || (t0 > 0.0)) {
+            flush () ;
+            piece. push_back (dpps::Vertex (a. x + t0 * (b. x - a. x),
+                                            a. y + t0 * (b. y - a. y))) ;
+        }
+        piece. push_back (dpps::Vertex (a. x + t1 * (b. x - a. x),
+                                        a. y + t1 * (b. y - a. y))) ;
+        if (t1 < 1.0)
+            flush () ;
+    }
+    flush () ;
+}
+
+dpps::Pattern::Partition dpps::Pattern::partition (
+    const Vertex &origin,
+    const double field_size_x,
+    const double field_size_y,
+    const double overlap,
+    const bool clip,
+    const selection_t selection) {
+check_selection_not_too_high(selection) ;
+    if ((field_size_x <= 0) || (field_size_y <= 0) || (overlap < 0)) {
+        std::string reason {"Pattern::partition, the fields must have a \
+positive size and the overlap must not be negative, got " +
+            std::to_string (field_size_x) + " × " +
+            std::to_string (field_size_y) + " and " +
+            std::to_string (overlap) + "."} ;
+        throw bad_parametre (reason. c_str ()) ;
+    }
+    // the const reference is used so that nothing is duplicated
+    const Polyline_vector &all = polylines ;
+    long_unsigned_int n {all. size ()} ;
+    // 0: not partitioned, 1: fits in its field, 2: crosses.
+    std::vector<char> state (n, 0) ;
+    std::vector<long signed int> field_i (n, 0), field_j (n, 0) ;
+#ifdef OPENMP_FOUND
+    #pragma omp parallel for schedule(dynamic, 64) if (n > 256)
+#endif
+    for (long_unsigned_int k = 0 ; k < n ; k++) {
+        const Polyline &p = all[k] ;
+        if (((selection >= 0) && !p. selected[selection]) || (p. size () == 0))
+            continue ;
+        double xmin {0.0}, ymin {0.0}, xmax {0.0}, ymax {0.0} ;
+        p. limits (xmin, ymin, xmax, ymax) ;
+        long signed int i {static_cast<long signed int> (floor (
+            ((xmin + xmax) / 2 - origin. x) / field_size_x))} ;
+        long signed int j {static_cast<long signed int> (floor (
+            ((ymin + ymax) / 2 - origin. y) / field_size_y))} ;
+        field_i[k] = i ;
+        field_j[k] = j ;
+        bool fits {
+            (xmin >= origin. x + i * field_size_x - overlap) &&
+            (xmax <= origin. x + (i + 1) * field_size_x + overlap) &&
+            (ymin >= origin. y + j * field_size_y - overlap) &&
+            (ymax <= origin. y + (j + 1) * field_size_y + overlap)} ;
+        state[k] = fits ? 1 : 2 ;
+    }
+    std::map<std::pair<long signed int, long signed int>,
+             std::vector<long_unsigned_int>> bins ;
+    Partition result ;
+    bool any_crossing {std::find (state. begin (), state. end (), 2) !=
+                       state. end ()} ;
+    if (!clip || !any_crossing) {
+        for (long_unsigned_int k {0} ; k < n ; k++)
+            if (state[k] == 1)
+                bins[std::make_pair (field_i[k], field_j[k])]. push_back (k) ;
+            else if (state[k] == 2)
+                result. crossing. push_back (k) ;
+    } else {
+        invalidate_spatial_index () ;
+        std::vector<std::vector<Polyline>> pieces (n) ;
+        std::vector<std::vector<std::pair<long signed int, long signed int>>>
+            piece_fields (n) ;
+        std::vector<std::exception_ptr> errors (n) ;
+#ifdef OPENMP_FOUND
+        #pragma omp parallel for schedule(dynamic, 1)
+#endif
+        for (long_unsigned_int k = 0 ; k < n ; k++) {
+            if (state[k] != 2)
+                continue ;
+            try {
+                const Polyline &p = all[k] ;
+                double xmin {0.0}, ymin {0.0}, xmax {0.0}, ymax {0.0} ;
+                p. limits (xmin, ymin, xmax, ymax) ;
+                long signed int i_min {static_cast<long signed int> (
+                    floor ((xmin - origin. x) / field_size_x))} ;
+                long signed int i_max {static_cast<long signed int> (
+                    floor ((xmax - origin. x) / field_size_x))} ;
+                long signed int j_min {static_cast<long signed int> (
+                    floor ((ymin - origin. y) / field_size_y))} ;
+                long signed int j_max {static_cast<long signed int> (
+                    floor ((ymax - origin. y) / field_size_y))} ;
+                for (long signed int i {i_min} ; i <= i_max ; i++)
+                    for (long signed int j {j_min} ; j <= j_max ; j++) {
+                        clip_to_field (p,
+                            origin. x + i * field_size_x,
+                            origin. y + j * field_size_y,
+                            origin. x + (i + 1) * field_size_x,
+                            origin. y + (j + 1) * field_size_y, pieces[k]) ;
+                        piece_fields[k]. resize (pieces[k]. size (),
+                                                 std::make_pair (i, j)) ;
+                    }
+            } catch (...) {
+                errors[k] = std::current_exception () ;
+            }
+        }
+        long_unsigned_int number {0} ;
+        for (long_unsigned_int k {0} ; k < n ; k++) {
+            if (errors[k])
+                std::rethrow_exception (errors[k]) ;
+            number += (state[k] == 2) ? pieces[k]. size () : 1 ;
+        }
+        std::vector<Polyline> clipped ;
+        clipped. reserve (number) ;
+        for (long_unsigned_int k {0} ; k < n ; k++) {
+            if (state[k] == 2) {
+                for (long_unsigned_int l {0} ; l < pieces[k]. size () ; l++) {
+                    bins[piece_fields[k][l]]. push_back (clipped. size ()) ;
+                    clipped. push_back (std::move (pieces[k][l])) ;
+                }
+                continue ;
+            }
+            if (state[k] == 1)
+                bins[std::make_pair (field_i[k], field_j[k])]. push_back (
+                    clipped. size ()) ;
+            clipped. push_back (std::move (polylines[k])) ;
+        }
+        polylines = std::move (clipped) ;
+    }
+    result. fields. reserve (bins. size ()) ;
+    // the reference &bin is used to avoid copy
+    for (auto &bin: bins)
+        result. fields. push_back (Field {bin. first. first, bin. first. second,
+                                          std::move (bin. second)}) ;
+    return result ;
+}
 
-        } else
-            result. push_back (i) ;
-/*    long_unsigned_int initial_size {polylines. size ()} ;
-    for (long_unsigned_int i {0} ; i < initial_size ; i++) {
-        Polyline element = *(polylines. begin ()) ;
-        polylines. pop_front () ;
-        if (element. selected[selection]) {
-            Pattern result {
-                Pattern_factory::fill_with_lines_first_angle (
-                    element, spacing)} ;
-            polylines. insert (polylines. end (),
-                               result. polylines. begin(),
-                               result. polylines. end()) ;
-            if (keep_initial)
-                polylines. push_back (element) ;
-        } else
-            polylines. push_back (element) ;
-    }*/
+void dpps::Pattern::select_field (const Partition &partition,
+                                  const long_unsigned_int field,
+                                  const selection_t result_selection) {
+check_selection_not_negative_not_too_high(result_selection) ;
+    if (field > partition. fields. size ()) {
+        std::string reason {"Pattern::select_field, there is no field " +
+            std::to_string (field) + ", the partition has " +
+            std::to_string (partition. fields. size ()) + " fields."} ;
+        throw bad_parametre (reason. c_str ()) ;
+    }
+    // the reference &numbers is used to avoid copy
+    const std::vector<long_unsigned_int> &numbers =
+        (field == partition. fields. size ()) ? partition. crossing :
+                                                partition. fields[field]. polylines ;
+    for (auto k: numbers)
+        if (k >= polylines. size ()) {
+            std::string reason {"Pattern::select_field, the partition refers \
+to polyline " + std::to_string (k) + ", but the pattern has " +
+                std::to_string ((long_unsigned_int) polylines. size ()) +
+                " polylines."} ;
+            throw bad_parametre (reason. c_str ()) ;
+        }
+    for (auto k: numbers)
+        polylines[k]. selected[result_selection] = true ;
 }
 
-void dpps::Pattern::fill_with_dashes (
+void dpps::Pattern::fill_region_with_dashes (
             const double angle,
             const double spacing_longitudinal,
             const double spacing_transversal,
@@ -976,83 +2146,18 @@ void dpps::Pattern::fill_with_dashes (
             const double phase_initial,
             const double phase_increment,
             const enum_partial_dash_policy partial_dash_policy,
+            const enum_fill_rule fill_rule,
             const bool keep_initial,
             const selection_t selection) {
 check_selection_not_too_high(selection) ;
-    std::vector<Polyline> result ;
-    for (auto &i : polylines)
-        if ((selection < 0) || (i. selected[selection])) {
-            Pattern p {Pattern_factory::fill_with_dashes
-                  (i, angle, spacing_longitudinal, spacing_transversal,
-                   duty_cycle, phase_initial, phase_increment,
-                   partial_dash_policy)} ;
-            if (keep_initial)
-                polylines. push_back (i) ;
-            polylines. insert (polylines. end (),
-                               p. polylines. begin(),
-                               p. polylines. end()) ;
-
-        } else
-            result. push_back (i) ;
-/*    long_unsigned_int initial_size {polylines. size ()} ;
-    for (long_unsigned_int i {0} ; i < initial_size ; i++) {
-        Polyline element = *(polylines. begin ()) ;
-        polylines. pop_front () ;
-        if (element. selected[selection]) {
-            Pattern result {} ;
-            polylines. insert (polylines. end (),
-                               result. polylines. begin(),
-                               result. polylines. end()) ;
-            if (keep_initial)
-                polylines. push_back (element) ;
-        } else
-            polylines. push_back (element) ;
-    }*/
-}
-
-void dpps::Pattern::fill_with_dashes_first_angle (
-           const double spacing_longitudinal,
-           const double spacing_transversal,
-           const double duty_cycle,
-           const double phase_initial,
-           const double phase_increment,
-           const enum_partial_dash_policy partial_dash_policy,
-           const bool keep_initial,
-           const selection_t selection) {
-check_selection_not_too_high(selection) ;
-    std::vector<Polyline> result ;
-    for (auto &i : polylines)
-        if ((selection < 0) || (i. selected[selection])) {
-            Pattern p {Pattern_factory::fill_with_dashes_first_angle (
-                    i, spacing_longitudinal, spacing_transversal,
-                    duty_cycle, phase_initial, phase_increment,
-                    partial_dash_policy)} ;
-            if (keep_initial)
-                polylines. push_back (i) ;
-            polylines. insert (polylines. end (),
-                               p. polylines. begin(),
-                               p. polylines. end()) ;
-
-        } else
-            result. push_back (i) ;
-/*    long_unsigned_int initial_size {polylines. size ()} ;
-    for (long_unsigned_int i {0} ; i < initial_size ; i++) {
-        Polyline element = *(polylines. begin ()) ;
-        polylines. pop_front () ;
-        if ((selection < 0) || (element. selected[selection])) {
-            Pattern result {
-                Pattern_factory::fill_with_dashes_first_angle (
-                    element, spacing_longitudinal, spacing_transversal,
-                    duty_cycle, phase_initial, phase_increment,
-                    partial_dash_policy)} ;
-            polylines. insert (polylines. end (),
-                               result. polylines. begin(),
-                               result. polylines. end()) ;
-            if (keep_initial)
-                polylines. push_back (element) ;
-        } else
-            polylines. push_back (element) ;
-    }*/
+    invalidate_spatial_index () ;
+    Pattern dashes {Pattern_factory::fill_region_with_dashes (
+        *this, angle, spacing_longitudinal, spacing_transversal, duty_cycle,
+        phase_initial, phase_increment, partial_dash_policy, fill_rule,
+        selection)} ;
+    if (!keep_initial)
+        erase (selection) ;
+    append_from (dashes) ;
 }
 
 void dpps::Pattern::display (const selection_t selection) const {
@@ -1111,6 +2216,7 @@ check_selection_not_too_high(selection) ;
 
 void dpps::Pattern::duplicate (const selection_t selection) {
 check_selection_not_too_high(selection) ;
+    invalidate_spatial_index () ;
     long_unsigned_int initial_size {polylines. size ()} ;
     for (long_unsigned_int i {0} ; i < initial_size ; i++)
         if ((selection < 0) || (polylines[i]. selected[selection])) {
@@ -1135,6 +2241,7 @@ check_selection_not_too_high(selection) ;
 void dpps::Pattern::overwrite_selected (const Pattern &p,
     const selection_t selection) {
 check_selection_not_too_high(selection) ;
+    invalidate_spatial_index () ;
     if ((size (selection) == 0) || (size (-1) == 0))
         return ;
     long_unsigned_int j {0} ;
@@ -1151,6 +2258,7 @@ void dpps::Pattern::remove_consecutive_duplicated_polylines (
     const double precision,
     const selection_t selection) {
 check_selection_not_too_high(selection) ;
+    invalidate_spatial_index () ;
     if (size (selection) <= 1) return ;
     std::vector<dpps::Polyline> result ;
     result. push_back (polylines[0]) ;
@@ -1189,20 +2297,46 @@ check_selection_not_too_high(selection) ;
 void dpps::Pattern::remove_duplicated_polylines (const double precision,
     const selection_t selection) {
 check_selection_not_too_high(selection) ;
+    invalidate_spatial_index () ;
+    if (size (selection) <= 1)
+        return ;
+    // Two equal polylines have their first vertices equal, therefore
+    // the kept polylines are indexed by their first vertex.
+    double maximum {0.0} ;
+    for (auto &p : polylines)
+        if (p. size () > 0)
+            maximum = std::max (maximum, std::max (
+                fabs (p. vertices. front (). x),
+                fabs (p. vertices. front (). y))) ;
+    Vertex_grid grid (precision, maximum) ;
+    bool empty_kept {false} ;
+    std::vector<long_unsigned_int> candidates ;
     std::vector<dpps::Polyline> result ;
-    result. push_back (polylines. front()) ;
-    for (long_unsigned_int i {1} ; i < polylines. size () ; i++) {
+    result. reserve (polylines. size ()) ;
+    for (auto &p : polylines) {
+        if ((selection >= 0) && !p. selected[selection]) {
+            result. push_back (std::move (p)) ;
+            continue ;
+        }
         bool duplicated {false} ;
-        for (long_unsigned_int j {0} ; j < result. size () ; j++) {
-            if (polylines[i]. equals_to (result[j], precision)) {
-                duplicated = true ;
-                break ;
-            }
+        if (p. size () == 0) {
+            // all empty polylines are equal, only the first one is kept.
+            duplicated = empty_kept ;
+            empty_kept = true ;
+        } else {
+            grid. neighbours (p. vertices. front (), candidates) ;
+            for (auto j: candidates)
+                if (p. equals_to (result[j], precision)) {
+                    duplicated = true ;
+                    break ;
+                }
+            if (!duplicated)
+                grid. insert (p. vertices. front (), result. size ()) ;
         }
         if (!duplicated)
-            result. push_back (polylines[i]) ;
+            result. push_back (std::move (p)) ;
     }
-    polylines = result ;
+    polylines = std::move (result) ;
 }
 
 void dpps::Pattern::set_dose (const double dose_value,
@@ -1273,21 +2407,18 @@ check_selection_not_too_high(selection) ;
 }
 
 void dpps::Pattern::erase (const selection_t selection) {
+    invalidate_spatial_index () ;
     check_selection_not_too_high(selection) ;
     if (selection < 0) {
         polylines. clear () ;
         return ;
     }
-    long_unsigned_int number = size (selection) ;
-    if (number == 0)
-        return ;
-    // get all except this selection
-    select (logical_action_toggle, selection) ;
-    Pattern q {dpps::Pattern_factory::Pattern_from_selected (*this, selection)} ;
-    select (logical_action_none, selection) ;
-
-    polylines. clear () ;
-    polylines = std::move (q. polylines);
+    // The polylines which are kept are moved in place, in their order, as
+    // with std::remove_if(), instead of copying them to another Pattern.
+    polylines. erase (std::remove_if (polylines. begin (), polylines. end (),
+        [=] (const Polyline &p) {
+            return p. selected[selection] ;
+        }), polylines. end ()) ;
 
 // Algorithm below is exponential.
 //     (For example we define a square lattice, select the dots outside a circle
@@ -1307,6 +2438,19 @@ void dpps::Pattern::erase (const selection_t selection) {
 //     }
 }
 
+void dpps::Pattern::compact () {
+    std::vector<Polyline> compacted ;
+    compacted. reserve (polylines. size ()) ;
+    // The moves keep the vertex buffers, which are then replaced one by one
+    // by exact copies (none for the vertices kept inline).
+    for (auto &p : polylines) {
+        compacted. push_back (std::move (p)) ;
+        Vertex_vector (compacted. back (). vertices). swap (
+            compacted. back (). vertices) ;
+    }
+    polylines = std::move (compacted) ;
+}
+
 void dpps::Pattern::set_reference (const long_unsigned_int set_reference_value,
     const selection_t selection) {
 check_selection_not_too_high(selection) ;
@@ -1392,10 +2536,63 @@ check_selection_not_too_high(selection) ;
 }
 
 void dpps::Pattern::push_back (const Polyline &p) {
+    invalidate_spatial_index () ;
     polylines. push_back (p) ;
 }
 
+void dpps::Pattern::push_back_coordinates (
+    const std::vector<double> &coordinates,
+    const std::vector<long_unsigned_int> &sizes) {
+    long_unsigned_int total {0} ;
+    for (auto s : sizes)
+        total += s ;
+    if (2 * total != coordinates. size ()) {
+        std::string reason {"Pattern::push_back_coordinates, sizes add up to " +
+            std::to_string (total) + " vertices, which need " +
+            std::to_string (2 * total) + " coordinates, but " +
+            std::to_string (coordinates. size ()) + " were given."} ;
+        throw bad_parametre (reason. c_str ()) ;
+    }
+    invalidate_spatial_index () ;
+    polylines. reserve (polylines. size () + sizes. size ()) ;
+    long_unsigned_int k {0} ;
+    for (auto s : sizes) {
+        Polyline p ;
+        p. vertices. reserve (s) ;
+        for (long_unsigned_int i {0} ; i < s ; i++, k += 2)
+            p. vertices. push_back (Vertex (coordinates[k], coordinates[k + 1])) ;
+        polylines. push_back (std::move (p)) ;
+    }
+}
+
+std::vector<double> dpps::Pattern::get_coordinates (
+    const selection_t selection) const {
+check_selection_not_too_high(selection) ;
+    std::vector<double> result ;
+    result. reserve (2 * vertices_size (selection)) ;
+    // the reference &p is used to avoid copy
+    for (auto &p : polylines)
+        if ((selection < 0) || (p. selected[selection]))
+            for (auto &v : p. vertices) {
+                result. push_back (v. x) ;
+                result. push_back (v. y) ;
+            }
+    return result ;
+}
+
+std::vector<long_unsigned_int> dpps::Pattern::get_sizes (
+    const selection_t selection) const {
+check_selection_not_too_high(selection) ;
+    std::vector<long_unsigned_int> result ;
+    // the reference &p is used to avoid copy
+    for (auto &p : polylines)
+        if ((selection < 0) || (p. selected[selection]))
+            result. push_back (p. size ()) ;
+    return result ;
+}
+
 dpps::Polyline dpps::Pattern::pop_back () {
+    invalidate_spatial_index () ;
     Polyline result ;
     if (polylines. size () >= 1) {
         result = polylines[polylines. size()-1] ;
@@ -1407,6 +2604,7 @@ dpps::Polyline dpps::Pattern::pop_back () {
 void dpps::Pattern::append_from (const Pattern &pattern,
                                  const selection_t selection) {
 check_selection_not_too_high(selection) ;
+    invalidate_spatial_index () ;
     if (selection < 0)
         polylines. insert (polylines. end (),
                        pattern. polylines. begin (),
@@ -1417,27 +2615,16 @@ check_selection_not_too_high(selection) ;
                 polylines. push_back (p) ;
 }
 
-void dpps::Pattern::random_update_property (
-                  const enum_random_property property,
-                  const enum_distribution random_distribution,
-                  const double p1,
-                  const double p2,
-                  const selection_t selection) {
-check_selection_not_too_high(selection) ;
-    std::uniform_real_distribution<double> d0 (p1, p2) ; // min, max
-    std::uniform_real_distribution<double> d_angle (0, 2*M_PI) ;
-    // Normal-type
-    std::normal_distribution<double> d1 (p1, p2) ;    // average = p1, sigma
-    std::lognormal_distribution<double> d2 (p1, p2) ; // average = p1, m
-    std::chi_squared_distribution<double> d3 (p1) ;    // n
-    std::cauchy_distribution<double> d4 (p1, p2) ;     // a, b
-    std::fisher_f_distribution<double> d5 (p1, p2) ;   // m, n
-    std::student_t_distribution<double> d6 (p1) ;      // n
-    // Poisson-type
-    std::exponential_distribution<double> d7 (p1) ;    // lambda
-    std::gamma_distribution<double> d8 (p1, p2) ;      // alpha, beta
-    std::weibull_distribution<double> d9 (p1, p2) ;    // a, b
-
+// Draws the numbers for property from distributions and generator, and
+// changes polyline p accordingly.
+template <class Generator>
+static void random_update_polyline (dpps::Polyline &p,
+    const dpps::enum_random_property property,
+    const dpps::enum_distribution random_distribution,
+    dpps::Random_distributions &distributions,
+    std::uniform_real_distribution<double> &d_angle,
+    Generator &generator) {
+    using namespace dpps ;
     short unsigned int number_repeat {1} ;
     constexpr const short unsigned int maxproperties {2} ;
     // Here we decide how many numbers we need to acquire depending on the
@@ -1454,123 +2641,137 @@ check_selection_not_too_high(selection) ;
     }
     std::array<double, maxproperties> x ;
     constexpr const double two_pi {2*M_PI} ;
-
-    std::for_each (polylines. begin (), polylines. end(),
-        [&] (Polyline &p) {
-        Polyline q ;
-    //for (auto &p : polylines) {
-        if ((selection < 0) || (p. selected[selection])) {
-            // First we acquire as many pseudo-random numbers as needed.
-            for (short unsigned int i {0} ; i < number_repeat ; i++) {
-                switch (random_distribution) {
-                    case type_uniform_real_distribution: // 0
-                        x[i] = d0 (pseudorandom_generator) ;
-                        break ;
-                    case type_normal_distribution: // 1
-                        x[i] = d1 (pseudorandom_generator) ;
-                        break ;
-                    case type_lognormal_distribution: // 2
-                        x[i] = d2 (pseudorandom_generator) ;
-                        break ;
-                    case type_chi_squared_distribution: // 3
-                        x[i] = d3 (pseudorandom_generator) ;
-                        break ;
-                    case type_cauchy_distribution: // 4
-                        x[i] = d4 (pseudorandom_generator) ;
-                        break ;
-                    case type_fisher_f_distribution: // 5
-                        x[i] = d5 (pseudorandom_generator) ;
-                        break ;
-                    case type_student_t_distribution: // 6
-                        x[i] = d6 (pseudorandom_generator) ;
-                        break ;
-                    case type_exponential_distribution: // 7
-                        x[i] = d7 (pseudorandom_generator) ;
-                        break ;
-                    case type_gamma_distribution: // 8
-                        x[i] = d8 (pseudorandom_generator) ;
-                        break ;
-                    case type_weibull_distribution: // 9
-                        x[i] = d9 (pseudorandom_generator) ;
-                        break ;
-                    default:
-                        break ;
-                }
-            }
-            // Then we use these numbers to set a property.
-            // Make sure that the property in question acquires enough numbers when
-            // adding new properties.
-            long_unsigned_int n ;
-            double area,
-                target_size {1.0} ;
-            switch (property) {
-                case random_property_position_xy: // 0 bivariate
-                { // grouping because of the variable declaration.
-                    double angle {d_angle (pseudorandom_generator)} ;
-                    p. translate (Vertex (x[0]*cos (angle), x[1]*sin (angle))) ;
-                    break ;
-                }
-                case random_property_position_x: // 1
-                    p. translate (Vertex (x[0], 0.0)) ;
-                    break ;
-                case random_property_position_y: // 2
-                    p. translate (Vertex (0.0, x[0])) ;
-                    break ;
-                case random_property_rotation_centred: // 3
-                    p. rotate_centred (x[0]) ;
-                    break ;
-                case random_property_scale_centred_xy: // 4
-                    p. scale_centred (x[0], x[1]) ;
-                    break ;
-                case random_property_scale_centred_isotropic: // 5
-                    p. scale_centred (x[0]) ;
-                    break ;
-                case random_property_scale_centred_x: // 6
-                    p. scale_centred (x[0], 1.0) ;
-                    break ;
-                case random_property_scale_centred_y: // 7
-                    p. scale_centred (1.0, x[0]) ;
+    Polyline q ;
+    // First we acquire as many pseudo-random numbers as needed.
+    for (short unsigned int i {0} ; i < number_repeat ; i++)
+        x[i] = distributions. draw (random_distribution, generator) ;
+    // Then we use these numbers to set a property.
+    // Make sure that the property in question acquires enough numbers when
+    // adding new properties.
+    long_unsigned_int n ;
+    double area,
+        target_size {1.0} ;
+    switch (property) {
+        case random_property_position_xy: // 0 bivariate
+        { // grouping because of the variable declaration.
+            double angle {d_angle (generator)} ;
+            p. translate (Vertex (x[0]*cos (angle), x[1]*sin (angle))) ;
+            break ;
+        }
+        case random_property_position_x: // 1
+            p. translate (Vertex (x[0], 0.0)) ;
+            break ;
+        case random_property_position_y: // 2
+            p. translate (Vertex (0.0, x[0])) ;
+            break ;
+        case random_property_rotation_centred: // 3
+            p. rotate_centred (x[0]) ;
+            break ;
+        case random_property_scale_centred_xy: // 4
+            p. scale_centred (x[0], x[1]) ;
+            break ;
+        case random_property_scale_centred_isotropic: // 5
+            p. scale_centred (x[0]) ;
+            break ;
+        case random_property_scale_centred_x: // 6
+            p. scale_centred (x[0], 1.0) ;
+            break ;
+        case random_property_scale_centred_y: // 7
+            p. scale_centred (1.0, x[0]) ;
+            break ;
+        case random_property_replace_polygon_random_vertice_number: // 8
+            n = static_cast<long_unsigned_int> (
+                std::nearbyint (fabs (x[0]))) ;
+            // Area of a regular polygon of n vertices and radius R
+            // (here R = 1/2)
+            // http://www.mathwords.com/a/area_regular_polygon.htm
+            // area = (n/2)*R^2*sin(2pi/n) where
+            area = (1.0 * n) / 8.0 * sin (two_pi / n) ;
+            switch (n) {
+                case 0:
+                case 1:
+                    // target_size has no meaning
                     break ;
-                case random_property_replace_polygon_random_vertice_number: // 8
-                    n = static_cast<long_unsigned_int> (
-                        std::nearbyint (fabs (x[0]))) ;
-                    // Area of a regular polygon of n vertices and radius R
-                    // (here R = 1/2)
-                    // http://www.mathwords.com/a/area_regular_polygon.htm
-                    // area = (n/2)*R^2*sin(2pi/n) where
-                    area = (1.0 * n) / 8.0 * sin (two_pi / n) ;
-                    switch (n) {
-                        case 0:
-                        case 1:
-                            // target_size has no meaning
-                            break ;
-                        case 2:
-                            target_size = p. maximum_distance () ;
-                            break ;
-                        default:
-                            target_size = sqrt (p. area () / area) ;
-                            break ;
-                    }
-                    q. replace_by_regular_polygon (n, target_size, true) ;
-                    //FIXME: true ????
-                    p. replace_by (q, true) ;
-                    //FIXME: true ????
+                case 2:
+                    target_size = p. maximum_distance () ;
                     break ;
                 default:
+                    target_size = sqrt (p. area () / area) ;
                     break ;
             }
-        }
-    //}
-    }) ;
+            q. replace_by_regular_polygon (n, target_size, true) ;
+            //FIXME: true ????
+            p. replace_by (q, true) ;
+            //FIXME: true ????
+            break ;
+        default:
+            break ;
+    }
+}
+
+void dpps::Pattern::random_update_property (
+                  const enum_random_property property,
+                  const enum_distribution random_distribution,
+                  const double p1,
+                  const double p2,
+                  const selection_t selection) {
+check_selection_not_too_high(selection) ;
+    if (random_distribution == type_Poisson_disk_distribution) {
+        std::string reason {"Pattern::random_update_property, the Poisson \
+disk distribution draws positions, not numbers, and can only be used by \
+Pattern_random."} ;
+        throw bad_parametre (reason. c_str ()) ;
+    }
+    invalidate_spatial_index () ;
+    // uniform: min, max ; normal: average = p1, sigma ;
+    // lognormal: average = p1, m
+    Random_distributions distributions (p1, p2, p1, p2, p1, p2) ;
+    std::uniform_real_distribution<double> d_angle (0, 2*M_PI) ;
 
+    if (!counter_based_random) {
+        for (auto &p : polylines)
+            if ((selection < 0) || (p. selected[selection]))
+                random_update_polyline (p, property, random_distribution,
+                    distributions, d_angle, pseudorandom_generator) ;
+        return ;
+    }
+    // Each polyline draws from its own stream, so the polylines are updated
+    // in parallel, with the same result whatever the number of threads.
+    uint32_t pass {static_cast<uint32_t> (counter_based_passes++)} ;
+    long_unsigned_int n {polylines. size ()} ;
+    // The threads move the vertices, so the shared polylines are duplicated
+    // here, once, and not by each thread.
+    polylines. detach () ;
+    std::vector<std::exception_ptr> errors (n) ;
+#ifdef OPENMP_FOUND
+    #pragma omp parallel for schedule(dynamic, 64) if (n > 256) firstprivate(distributions, d_angle)
+#endif
+    for (long_unsigned_int i = 0 ; i < n ; i++) {
+        Polyline &p = polylines[i] ;
+        if ((selection >= 0) && (!p. selected[selection]))
+            continue ;
+        try {
+            Counter_random generator (time_seed, i, pass) ;
+            distributions. reset () ;
+            d_angle. reset () ;
+            random_update_polyline (p, property, random_distribution,
+                distributions, d_angle, generator) ;
+        } catch (...) {
+            errors[i] = std::current_exception () ;
+        }
+    }
+    // the reference &e is used to avoid copy
+    for (auto &e: errors)
+        if (e)
+            std::rethrow_exception (e) ;
 }
 
 void dpps::Pattern::round_to (const double precision, const selection_t selection) {
 check_selection_not_too_high(selection) ;
-    std::for_each (polylines. begin (), polylines. end(),
+    invalidate_spatial_index () ;
+    for_each_selected (selection,
         [=] (Polyline &p) {
-            if ((selection < 0) || (p. selected[selection]))
-                p. round_to (precision) ;
+            p. round_to (precision) ;
         }) ;
 //     for (auto &p : polylines)
 //         if (p. selected[selection]) {
@@ -1661,6 +2862,7 @@ void dpps::Pattern::sort (
     const std::vector <enum_double_property> &properties,
     const bool increasing,
     const selection_t selection) {
+    invalidate_spatial_index () ;
     //NOTE: double_property_dose: keep in sync with the maximum value
     // of the enum.
 
@@ -1680,48 +2882,89 @@ same criterion as sorting parametre"} ;
                 throw bad_parametre (reason. c_str ()) ;
             }
         }
-    Pattern p {Pattern_factory::Pattern_from_selected (*this, selection)} ;
-    if (p. size (-1) == 0)
+    // Each property is evaluated only once per polyline and stored in a
+    // table of keys, with one row of properties. size () values per polyline.
+    // Indices to the rows are sorted, and the polylines are finally moved
+    // once to their new position.
+    std::vector<long_unsigned_int> position {selected_indices (selection)} ;
+    if (position. size () <= 1)
         return ;
-    std::stable_sort (
-        p. polylines. begin (),
-        p. polylines. end (),
-        // this will call param_1. multicriteria_less_than(param_2, properties)
-        // where param_1 and param_2 are the two arguments passed by stable_sort
-        // to the function returned by std::bind.
-        // See M. Josuttis (2011), section 10.2.2 Function adapters and binders,
-        // pages 491-492, Calling Member Functions.
-        std::bind (&Polyline::multicriteria_less_than,
-            std::placeholders::_1,
-            std::placeholders::_2,
-            properties,
-            increasing)) ;
-     overwrite_selected (p, selection) ;
+    const long_unsigned_int n {position. size ()} ;
+    const long_unsigned_int m {properties. size ()} ;
+    std::vector<double> keys (n * m) ;
+    std::vector<double> row ;
+    for (long_unsigned_int i {0} ; i < n ; i++) {
+        // The limits and the centre are calculated once per polyline
+        // whatever the number of properties using them.
+        polylines[position[i]]. get_double_properties (properties, 0, row) ;
+        std::copy (row. begin (), row. end (), keys. begin () + i*m) ;
+    }
+    std::vector<long_unsigned_int> order (n) ;
+    for (long_unsigned_int i {0} ; i < n ; i++)
+        order[i] = i ;
+    // Same criterion as Polyline::multicriteria_less_than(): the first
+    // property differing by more than epsilon decides.
+    std::stable_sort (order. begin (), order. end (),
+        [&keys, m, increasing] (const long_unsigned_int a,
+                                const long_unsigned_int b) {
+            for (long_unsigned_int j {0} ; j < m ; j++) {
+                double ka {keys[a*m + j]} ;
+                double kb {keys[b*m + j]} ;
+                if (fabs (ka - kb) > std::numeric_limits<double>::epsilon())
+                    return (increasing ? (ka < kb) : (ka > kb)) ;
+            }
+            return false ;
+        }) ;
+    permute_polylines (position, order) ;
+}
+
+std::vector<long_unsigned_int> dpps::Pattern::selected_indices (
+    const selection_t selection) const {
+check_selection_not_too_high(selection) ;
+    std::vector<long_unsigned_int> result ;
+    for (long_unsigned_int i {0} ; i < polylines. size () ; i++)
+        if ((selection < 0) || (polylines[i]. selected[selection]))
+            result. push_back (i) ;
+    return result ;
+}
+
+void dpps::Pattern::permute_polylines (
+    const std::vector<long_unsigned_int> &indices,
+    const std::vector<long_unsigned_int> &order) {
+    invalidate_spatial_index () ;
+    // Following the cycles of the permutation moves each polyline once,
+    // without a copy of all of them.
+    std::vector<bool> done (order. size (), false) ;
+    for (long_unsigned_int i {0} ; i < order. size () ; i++) {
+        if (done[i])
+            continue ;
+        Polyline first {std::move (polylines[indices[i]])} ;
+        long_unsigned_int j {i} ;
+        while (order[j] != i) {
+            polylines[indices[j]] = std::move (polylines[indices[order[j]]]) ;
+            done[j] = true ;
+            j = order[j] ;
+        }
+        polylines[indices[j]] = std::move (first) ;
+        done[j] = true ;
+    }
 }
 
 void dpps::Pattern::shuffle (const selection_t selection) {
 check_selection_not_too_high(selection) ;
-    Pattern p {Pattern_factory::Pattern_from_selected (*this, selection)} ;
-    if (size (-1) == 0)
+    invalidate_spatial_index () ;
+    std::vector<long_unsigned_int> position {selected_indices (selection)} ;
+    if (position. size () <= 1)
         return ;
-    std::shuffle (p. polylines. begin (),
-               p. polylines. end (),
+    // The indices are shuffled as the polylines themselves were, so that
+    // the order is the same for a given seed.
+    std::vector<long_unsigned_int> order (position. size ()) ;
+    for (long_unsigned_int i {0} ; i < order. size () ; i++)
+        order[i] = i ;
+    std::shuffle (order. begin (),
+               order. end (),
                std::default_random_engine(time_seed)) ;
-    long_unsigned_int j {0} ;
-
-//     std::for_each (polylines. begin (), polylines. end(),
-//         [&] (Polyline &i) {
-//             if (i. selected[selection]) {
-//                 i = p. polylines [j] ;
-//                 j++ ;
-//             }
-//         }) ;
-
-    for (auto &i : polylines)
-        if ((selection < 0) || (i. selected[selection])) {
-            i = p. polylines [j] ;
-            j++ ;
-        }
+    permute_polylines (position, order) ;
 }
 
 /*
@@ -1752,6 +2995,7 @@ void dpps::Pattern::distribute (
     const long_unsigned_int parametre,
     const selection_t selection) {
 check_selection_not_too_high(selection) ;
+    invalidate_spatial_index () ;
     double minimum {0.0},
            maximum {0.0} ;
     long_unsigned_int i {0} ;
@@ -1824,13 +3068,12 @@ check_selection_not_too_high(selection) ;
         minimum = std::numeric_limits<double>::max () ;
         maximum = std::numeric_limits<double>::lowest () ;
         for (auto &p : polylines) {
-            double temporary_value ;
-            if (((selection < 0) || (p. selected[selection])) &&
-                ((temporary_value = p. get_double_property (property, parametre))) < minimum)
-                minimum = temporary_value ;
-            if (((selection < 0) || (p. selected[selection])) &&
-                ((temporary_value = p. get_double_property (property, parametre))) > maximum)
-                maximum = temporary_value ;
+            if ((selection >= 0) && (!p. selected[selection]))
+                continue ;
+            // the property is calculated once for both limits
+            double temporary_value {p. get_double_property (property, parametre)} ;
+            minimum = std::min (minimum, temporary_value) ;
+            maximum = std::max (maximum, temporary_value) ;
         }
     }
 }
@@ -1903,6 +3146,7 @@ void dpps::Pattern::update_double_property (
         const double value,
         const selection_t selection) {
 check_selection_not_too_high(selection) ;
+    invalidate_spatial_index () ;
     std::for_each (polylines. begin (), polylines. end(),
         [=] (Polyline &i) {
             if ((selection < 0) || i. selected[selection])
@@ -1912,10 +3156,10 @@ check_selection_not_too_high(selection) ;
 
 void dpps::Pattern::reverse_order (const selection_t selection) {
 check_selection_not_too_high(selection) ;
-    Pattern p {Pattern_factory::Pattern_from_selected (*this)} ;
-    std::reverse (p. polylines. begin (), p. polylines. end ()) ;
-    // replace polylines of a pattern by the new ones
-    overwrite_selected (p, selection) ;
+    invalidate_spatial_index () ;
+    std::vector<long_unsigned_int> position {selected_indices (selection)} ;
+    for (long_unsigned_int i {0}, j {position. size ()} ; i + 1 < j ; i++, j--)
+        std::swap (polylines[position[i]], polylines[position[j - 1]]) ;
 }
 
 bool dpps::Pattern::is_convex (const selection_t selection) const {
@@ -1931,24 +3175,37 @@ check_selection_not_too_high(selection) ;
 void dpps::Pattern::remove_aligned_vertices (const double precision,
                                              const selection_t selection) {
 check_selection_not_too_high(selection) ;
-    for (auto &i : polylines)
-        if ((selection < 0) || (i. selected[selection]))
-            i. remove_aligned_vertices (precision) ;
+    invalidate_spatial_index () ;
+    for_each_selected (selection,
+        [=] (Polyline &p) {
+            p. remove_aligned_vertices (precision) ;
+        }) ;
 }
 
 void dpps::Pattern::join_successive_intersecting_lines (
         const double precision, const selection_t selection) {
 check_selection_not_too_high(selection) ;
+    invalidate_spatial_index () ;
+    if (polylines. size () <= 1)
+        return ;
     Pattern result ;
     Polyline current ;
+    // closes current if its ends meet, and moves it to result.
+    auto flush_current = [&] () {
+        if (current. vertices. back(). equals_to (
+                current. vertices. front (), precision)) {
+            current. closed = true ;
+            current. vertices. pop_back () ;
+        }
+        result. polylines. push_back (std::move (current)) ;
+        current. vertices. clear () ;
+    } ;
     for (long_unsigned_int i{0} ; i < polylines. size ()-1 ; i++) {
-        // std::cout << "We are at " << i << " and polyline is " << polylines[i]. display_string () << "\n" ;
         bool selected_i {(selection < 0) || (polylines[i]. selected[selection])} ;
         bool selected_iplus1 {
             // It is always safe to refer to i+1 in this loop, since
             // i < polylines. size ()-1
             ((selection < 0) || (polylines[i+1]. selected[selection]))} ;
-        // std::cout << "selected i " << selected_i << " selected next " << selected_iplus1 << "\n" ;
         if (selected_i &&
             selected_iplus1 &&
             polylines[i]. vertices. size() >= 2 &&
@@ -1956,126 +3213,161 @@ check_selection_not_too_high(selection) ;
             polylines[i]. vertices. back(). equals_to (
                 polylines[i+1]. vertices. front(), precision)) {
             if (current. vertices. size () == 0)
-                current = polylines[i] ;
+                current = std::move (polylines[i]) ;
             current. vertices. insert (current. vertices. end (),
                 polylines[i+1]. vertices. cbegin ()+1,
                 polylines[i+1]. vertices. cend ()) ;
-            // std::cout << "Adding to polyline, current = " << current. display_string() << "\n" ;
         } else {
-            // std::cout << "not okay\n" ;
-            if (current. vertices. size () != 0) {
-                // std::cout << "We had a polyline " << current. display_string() << "\n" ;
-                if (current. vertices. back(). equals_to (
-                        current. vertices. front (), precision)) {
-                    current. closed = true ;
-                    current. vertices. pop_back () ;
-                    //erase (current. vertices. end () - 1) ;
-                    // std::cout << "closing polyline " << current. display_string() << "\n" ;
-                }
-                result. push_back (current) ;
-                current. vertices. clear () ;
-            } else
-                result. push_back (polylines[i]) ;
+            if (current. vertices. size () != 0)
+                flush_current () ;
+            else
+                result. polylines. push_back (std::move (polylines[i])) ;
             // When i is at the one before the last, and we cannot join them,
             // then we need to push also the last, otherwise it would ignored,
             // as the for loop never passes through the last
             if (i == polylines. size () - 2)
-                result. push_back (polylines[i+1]) ;
+                result. polylines. push_back (std::move (polylines[i+1])) ;
         }
     }
+    // If the last polylines were joined, the result is still in current.
+    if (current. vertices. size () != 0)
+        flush_current () ;
     polylines = std::move (result. polylines) ;
 }
 
 void dpps::Pattern::join_intersecting_lines (
     const double precision, const selection_t selection) {
 check_selection_not_too_high(selection) ;
-    Pattern result ;
-    Polyline current ;
-    //std::cout << "Polylines are: " << display_string (-1) << "\n" ;
+    invalidate_spatial_index () ;
+    // Polylines are taken from the back and joined with the first remaining
+    // polyline (in the order of the pattern) that has an end equal to one of
+    // the ends of the current one, until no polyline can be joined.
+    //
+    // Ends of the polylines that can be joined are indexed in a Vertex_grid,
+    // with index 2*i for the front of polylines[i] and 2*i+1 for its back.
+    // Polylines already used are marked in used instead of being erased.
+    const long_unsigned_int n {polylines. size ()} ;
+    std::vector<bool> joinable (n, false) ;
+    std::vector<bool> used (n, false) ;
+    double maximum {0.0} ;
+    for (long_unsigned_int i {0} ; i < n ; i++) {
+        joinable[i] = ((selection < 0) || (polylines[i]. selected[selection])) &&
+                      (polylines[i]. vertices. size () >= 2) ;
+        if (joinable[i])
+            maximum = std::max (maximum,
+                Vertex_grid::maximum_coordinate (polylines[i]. vertices)) ;
+    }
+    Vertex_grid grid (precision, maximum) ;
+    for (long_unsigned_int i {0} ; i < n ; i++)
+        if (joinable[i]) {
+            grid. insert (polylines[i]. vertices. front (), 2*i) ;
+            grid. insert (polylines[i]. vertices. back (), 2*i+1) ;
+        }
 
-    while (polylines. size () > 0) {
-        current = polylines. back () ;
-        polylines. pop_back () ;
-        //std::cout << "Main loop starting with polyline " << current.display_string () << "\n";
-        //std::cout << "Polylines to be processed are: \n" << display_string (-1) << "\n" ;
-        //std::cout << "Result: \n" << result. display_string (-1) << "\n" ;
-        bool selected {(selection < 0) || (current. selected[selection])} ;
-        if ((!selected) || current. vertices. size () < 2 || polylines. size () == 0) {
-            //std::cout << "No selected, go to next\n" ;
-            result. push_back (current) ;
+    std::vector<Polyline> result ;
+    std::vector<long_unsigned_int> candidates, sorted ;
+    // The vertices of the polyline being built. Since vertices are added at
+    // both ends, a deque is used, read in reverse order when flipped is set,
+    // which avoids actually reversing it.
+    std::deque<Vertex> chain ;
+    bool flipped {false} ;
+    auto chain_front = [&] () -> const Vertex & {
+        return flipped ? chain. back () : chain. front () ;
+    } ;
+    auto chain_back = [&] () -> const Vertex & {
+        return flipped ? chain. front () : chain. back () ;
+    } ;
+    auto push_chain_front = [&] (const Vertex &v) {
+        if (flipped) chain. push_back (v) ; else chain. push_front (v) ;
+    } ;
+    auto push_chain_back = [&] (const Vertex &v) {
+        if (flipped) chain. push_front (v) ; else chain. push_back (v) ;
+    } ;
+
+    for (long_unsigned_int k {n} ; k > 0 ; k--) {
+        long_unsigned_int c {k-1} ;
+        if (used[c])
+            continue ;
+        used[c] = true ;
+        if (!joinable[c]) {
+            result. push_back (std::move (polylines[c])) ;
             continue ;
         }
+        chain. assign (polylines[c]. vertices. begin (),
+                       polylines[c]. vertices. end ()) ;
+        flipped = false ;
         bool something_was_done {true} ;
         while (something_was_done) {
-            //std::cout << "Checking loop\n" ;
-            if (polylines. size () == 0) {
-                //std::cout << "going away\n" ;
-                break ;
-            }
-            long_unsigned_int i {0} ;
             something_was_done = false ;
-            while (!something_was_done && i < polylines. size ()) {
-                //std::cout << "Action loop at i=" << i << " probing " << polylines[i]. display_string () << "\n" ;
-                //std::cout << "Polylines are: " << display_string (-1) << "\n" ;
-                bool selected_i {(selection < 0) || (polylines[i]. selected[selection])} ;
-                if (selected_i && (polylines[i]. vertices. size () >= 2)) {
-                    if (current. vertices. front (). equals_to (polylines[i]. vertices. front (), precision)) {
-                        //std::cout << "case 1 front=front, current= " << current. display_string() << ", probe= " << polylines[i]. display_string () << "\n" ;
-                        current. reverse_vertices () ;
-                        current. vertices. insert (
-                            current. vertices. end (),
-                            polylines[i]. vertices. cbegin () + 1,
-                            polylines[i]. vertices. cend ()) ;
-                        //std::cout << "Now current: " << current. display_string () << "\n" ;
-                        something_was_done = true ;
-                    } else {
-                        if (current. vertices. front (). equals_to (polylines[i]. vertices. back (), precision)) {
-                            //std::cout << "case 2 front=back, current= " << current. display_string() << ", probe= " << polylines[i]. display_string () << "\n" ;
-                            current. vertices. insert (
-                                current. vertices. begin (),
-                                polylines[i]. vertices. cbegin (),
-                                polylines[i]. vertices. cend () - 1) ;
-                            //std::cout << "Now current: " << current. display_string () << "\n" ;
-                            something_was_done = true ;
-                        } else {
-                            if (current. vertices. back (). equals_to (polylines[i]. vertices. back (), precision)) {
-                                //std::cout << "case 3 back=back, current= " << current. display_string() << ", probe= " << polylines[i]. display_string () << "\n" ;
-                                polylines[i]. reverse_vertices () ;
-                                current. vertices. insert (
-                                    current. vertices. end (),
-                                    polylines[i]. vertices. cbegin () + 1,
-                                    polylines[i]. vertices. cend ()) ;
-                                //std::cout << "Now current: " << current. display_string () << "\n" ;
-                                something_was_done = true ;
-                            } else {
-                                if (current. vertices. back (). equals_to (polylines[i]. vertices. front (), precision)) {
-                                    //std::cout << "case 4 back=front, current= " << current. display_string() << ", probe= " << polylines[i]. display_string () << "\n" ;
-                                    current. vertices. insert (
-                                        current. vertices. end (),
-                                        polylines[i]. vertices. cbegin () + 1,
-                                        polylines[i]. vertices. cend ()) ;
-                                    //std::cout << "Now current: " << current. display_string () << "\n" ;
-                                    something_was_done = true ;
-                                }
-                            }
-                        }
-                    }
-               }
-               if (something_was_done)
-                   polylines. erase (polylines. begin () + i) ;
-               i++ ;
+            // The polylines with an end close to one of ours are the
+            // candidates. They are tested starting from the smallest index,
+            // and the first one with an equal end is joined.
+            grid. neighbours (chain_front (), sorted) ;
+            grid. neighbours (chain_back (), candidates) ;
+            sorted. insert (sorted. end (), candidates. begin (), candidates. end ()) ;
+            for (auto &j: sorted)
+                j /= 2 ;
+            std::sort (sorted. begin (), sorted. end ()) ;
+            sorted. erase (std::unique (sorted. begin (), sorted. end ()),
+                          sorted. end ()) ;
+            for (auto i: sorted) {
+                if (used[i])
+                    continue ;
+                const Vertex_vector &w = polylines[i]. vertices ;
+                if (chain_front (). equals_to (w. front (), precision)) {
+                    // reverse the chain, then append w but its first vertex
+                    flipped = !flipped ;
+                    for (auto v = w. cbegin () + 1 ; v != w. cend () ; v++)
+                        push_chain_back (*v) ;
+                    something_was_done = true ;
+                } else if (chain_front (). equals_to (w. back (), precision)) {
+                    // prepend w but its last vertex
+                    for (auto v = w. crbegin () + 1 ; v != w. crend () ; v++)
+                        push_chain_front (*v) ;
+                    something_was_done = true ;
+                } else if (chain_back (). equals_to (w. back (), precision)) {
+                    // append reversed w but its last vertex
+                    for (auto v = w. crbegin () + 1 ; v != w. crend () ; v++)
+                        push_chain_back (*v) ;
+                    something_was_done = true ;
+                } else if (chain_back (). equals_to (w. front (), precision)) {
+                    // append w but its first vertex
+                    for (auto v = w. cbegin () + 1 ; v != w. cend () ; v++)
+                        push_chain_back (*v) ;
+                    something_was_done = true ;
+                }
+                if (something_was_done) {
+                    used[i] = true ;
+                    break ;
+                }
             }
         }
-        result. push_back (current) ;
+        Polyline &current {polylines[c]} ;
+        if (flipped)
+            current. vertices. assign (chain. rbegin (), chain. rend ()) ;
+        else
+            current. vertices. assign (chain. begin (), chain. end ()) ;
+        result. push_back (std::move (current)) ;
     }
-    polylines = result. polylines ;
+    polylines = std::move (result) ;
 }
 
 void dpps::Pattern::subdivide (const double distance, const selection_t selection) {
 check_selection_not_too_high(selection) ;
-    for (auto &i : polylines)
-        if ((selection < 0) || (i. selected[selection]))
-            i. subdivide (distance) ;
+    invalidate_spatial_index () ;
+    for_each_selected (selection,
+        [=] (Polyline &p) {
+            p. subdivide (distance) ;
+        }) ;
+}
+
+void dpps::Pattern::simplify (const double tolerance, const selection_t selection) {
+check_selection_not_too_high(selection) ;
+    invalidate_spatial_index () ;
+    for_each_selected (selection,
+        [=] (Polyline &p) {
+            p. simplify (tolerance) ;
+        }) ;
 }
 
 void dpps::Pattern::reorder_vertices_by_angle(const selection_t selection) {
@@ -2088,19 +3380,113 @@ check_selection_not_too_high(selection) ;
 #ifdef GSL_FOUND
 void dpps::Pattern::apply_matrix (Matrix3x3 &matrix, const selection_t selection) {
 check_selection_not_too_high(selection) ;
-    for (auto &i : polylines)
-        if ((selection < 0) || (i. selected[selection]))
-            i. apply_matrix(matrix) ;
+    invalidate_spatial_index () ;
+    for_each_selected (selection,
+        [&] (Polyline &p) {
+            p. apply_matrix(matrix) ;
+        }) ;
 }
 
 void dpps::Pattern::apply_homography (Matrix3x3 &matrix, const selection_t selection) {
 check_selection_not_too_high(selection) ;
-    for (auto &i : polylines)
-        if ((selection < 0) || (i. selected[selection]))
-            i. apply_homography(matrix) ;
+    invalidate_spatial_index () ;
+    for_each_selected (selection,
+        [&] (Polyline &p) {
+            p. apply_homography(matrix) ;
+        }) ;
 }
 #endif
 
+void dpps::Pattern::map_vertices (
+    const std::function<void (std::vector<double> &)> &f,
+    long_unsigned_int batch_size,
+    const bool thread_safe,
+    const selection_t selection) {
+check_selection_not_too_high(selection) ;
+    invalidate_spatial_index () ;
+    // The selected vertices are numbered one polyline after the other, and
+    // offsets[k] is the number of the first vertex of polyline indices[k].
+    std::vector<long_unsigned_int> indices {selected_indices (selection)} ;
+    long_unsigned_int m {indices. size ()} ;
+    std::vector<long_unsigned_int> offsets (m + 1, 0) ;
+    for (long_unsigned_int k {0} ; k < m ; k++)
+        offsets[k + 1] = offsets[k] + polylines[indices[k]]. size () ;
+    long_unsigned_int total {offsets[m]} ;
+    if (total == 0)
+        return ;
+    if ((batch_size == 0) || (batch_size > total))
+        batch_size = total ;
+    long_unsigned_int batches {(total + batch_size - 1) / batch_size} ;
+    std::vector<std::exception_ptr> errors (batches) ;
+    // The threads write the vertices, so the shared polylines are duplicated
+    // here, once, and not by each thread.
+    polylines. detach () ;
+#ifdef OPENMP_FOUND
+    #pragma omp parallel for schedule(dynamic, 1) if (thread_safe && (batches > 1))
+#else
+    (void) thread_safe ;
+#endif
+    for (long_unsigned_int b = 0 ; b < batches ; b++) {
+        long_unsigned_int first {b * batch_size} ;
+        long_unsigned_int count {std::min (batch_size, total - first)} ;
+        // the last polyline starting at or before first, which is not
+        // empty since it contains vertex first
+        long_unsigned_int k_first {static_cast<long_unsigned_int> (
+            std::upper_bound (offsets. begin (), offsets. end (), first) -
+            offsets. begin ()) - 1} ;
+        std::vector<double> coordinates (2 * count) ;
+        long_unsigned_int k {k_first} ;
+        long_unsigned_int i {first - offsets[k_first]} ;
+        for (long_unsigned_int j {0} ; j < count ; j++, i++) {
+            while (i == polylines[indices[k]]. size ()) {
+                k++ ;
+                i = 0 ;
+            }
+            // the reference &v is used to avoid copy
+            const Vertex &v = polylines[indices[k]]. vertices[i] ;
+            coordinates[2*j] = v. x ;
+            coordinates[2*j + 1] = v. y ;
+        }
+        try {
+            f (coordinates) ;
+            if (coordinates. size () != 2 * count) {
+                std::string reason {"Pattern::map_vertices, the function \
+returned " + std::to_string (coordinates. size ()) + " coordinates for a \
+batch of " + std::to_string (count) + " vertices."} ;
+                throw bad_parametre (reason. c_str ()) ;
+            }
+        } catch (...) {
+            errors[b] = std::current_exception () ;
+            continue ;
+        }
+        k = k_first ;
+        i = first - offsets[k_first] ;
+        for (long_unsigned_int j {0} ; j < count ; j++, i++) {
+            while (i == polylines[indices[k]]. size ()) {
+                k++ ;
+                i = 0 ;
+            }
+            polylines[indices[k]]. vertices[i] =
+                Vertex (coordinates[2*j], coordinates[2*j + 1]) ;
+        }
+    }
+    for (auto &e: errors)
+        if (e)
+            std::rethrow_exception (e) ;
+}
+
+void dpps::Pattern::apply_transform (const Affine_transform &transform,
+                                     const selection_t selection) {
+check_selection_not_too_high(selection) ;
+    invalidate_spatial_index () ;
+    if (transform. is_identity ())
+        return ;
+    for_each_selected (selection,
+        [&] (Polyline &p) {
+            p. apply_transform (transform) ;
+        }) ;
+}
+
 void dpps::Pattern::cycle (long_unsigned_int val,
                            const bool forward, const selection_t selection) {
 check_selection_not_too_high(selection) ;
@@ -2115,6 +3501,7 @@ void dpps::Pattern::cut_into (Polyline p,
                    const bool reverse_auto,
                    const selection_t selection) {
 check_selection_not_too_high(selection) ;
+    invalidate_spatial_index () ;
     for (auto &i : polylines)
         if ((selection < 0) || (i. selected[selection]))
             i. cut_into (p, pos_this, pos_p, reverse_auto) ;
@@ -2124,11 +3511,25 @@ void dpps::Pattern::cut_into (Polyline p,
                    const bool reverse_auto,
                    const selection_t selection) {
 check_selection_not_too_high(selection) ;
+    invalidate_spatial_index () ;
     for (auto &i : polylines)
         if ((selection < 0) || (i. selected[selection]))
             i. cut_into (p, reverse_auto) ;
 }
 
+void dpps::Pattern::cut_into (const Pattern &holes,
+                   const bool reverse_auto,
+                   const selection_t selection) {
+check_selection_not_too_high(selection) ;
+    invalidate_spatial_index () ;
+    // The copy shares the polylines, so that modifying ours does not change
+    // them if holes is *this.
+    Polyline_vector hole_polylines {holes. polylines} ;
+    for (auto &i : polylines)
+        if ((selection < 0) || (i. selected[selection]))
+            i. cut_into (hole_polylines, reverse_auto) ;
+}
+
 void dpps::Pattern::check_closed(const double precision, const selection_t selection) {
 check_selection_not_too_high(selection) ;
     for (auto &i : polylines)
@@ -29,11 +29,15 @@
 #define DPPS_PATTERN
 
 #include <array>
+#include <functional>
+#include <memory>
 #include <random>
 
 #include "common.hh"
 #include "util.hh"
 #include "Polyline.hh"
+#include "Polyline_vector.hh"
+#include "Polyline_index.hh"
 
 namespace dpps {
     typedef enum {
@@ -42,6 +46,30 @@ namespace dpps {
         partial_dash_policy_fit
     } enum_partial_dash_policy ;
 
+    /** @brief How the lines of Pattern_factory::fill_with_lines() and
+     * fill_with_dashes() are limited by the polylines.
+     *
+     * fill_rule_extent draws each line from its first to its last crossing
+     * with the polyline, which is only meaningful for convex shapes.
+     * fill_rule_even_odd keeps the parts of lines inside an odd number of
+     * edges, fill_rule_nonzero those around which the polylines turn a
+     * nonzero number of times. */
+    typedef enum {
+        fill_rule_extent,
+        fill_rule_even_odd,
+        fill_rule_nonzero
+    } enum_fill_rule ;
+
+    /** @brief The operations of Pattern::boolean_operation(), between the
+     * closed polylines of two selections A and B: the parts inside A or B,
+     * inside both, inside A but not B, and inside only one of them. */
+    typedef enum {
+        boolean_operation_union,
+        boolean_operation_intersection,
+        boolean_operation_difference,
+        boolean_operation_xor
+    } enum_boolean_operation ;
+
     typedef enum {
         type_uniform_real_distribution,
         type_normal_distribution,
@@ -52,7 +80,8 @@ namespace dpps {
         type_student_t_distribution,
         type_exponential_distribution,
         type_gamma_distribution,
-        type_weibull_distribution
+        type_weibull_distribution,
+        type_Poisson_disk_distribution
     } enum_distribution ;
 
     typedef enum {
@@ -82,6 +111,8 @@ namespace dpps {
         logical_action_toggle
     } enum_logical_action ;
 
+class Writer ;
+
  /** @brief Pattern is an base class for various types of patterns that
  * can be drawn. Users willing to add more patterns can make them derive from
  * this one.
@@ -111,8 +142,68 @@ public:
     /* @brief generated is set to true when generation is complete */
     // bool generated ;
 
-    /** @brief The pattern is a vector of Polylines. */
-    std::vector<Polyline> polylines ;
+    /** @brief The pattern is a vector of Polylines.
+     *
+     * The copies of a pattern share its polylines until one of them is
+     * modified, see Polyline_vector. */
+    Polyline_vector polylines ;
+
+    /** @brief A reference to one of the cells, placed in the pattern by a
+     * transform: the polylines of the cell are scaled by scale and rotated
+     * by angle (in radians) around the origin, then translated by position.
+     *
+     * The selections of properties are those of the instance. If
+     * override_properties is true, all the polylines drawn by the instance
+     * take the metadata of properties (dose, reference, closure and
+     * selections), as with Polyline::set_metadata_from(). The vertices of
+     * properties are not used. */
+    struct Instance {
+        long_unsigned_int cell ;
+        Vertex position ;
+        double angle ;
+        double scale ;
+        bool override_properties ;
+        Polyline properties ;
+    } ;
+
+    /** @brief A named group of polylines and of instances of the cells added
+     * before it, which is kept once in memory however many times it is
+     * placed. */
+    struct Cell {
+        std::string name ;
+        std::vector<Polyline> polylines ;
+        std::vector<Instance> instances ;
+    } ;
+
+    /** @brief A write field of partition(), the rectangle from
+     * origin + (i field_size_x, j field_size_y) to
+     * origin + ((i + 1) field_size_x, (j + 1) field_size_y), and the numbers
+     * in polylines of the polylines written in it, in increasing order. */
+    struct Field {
+        long signed int i ;
+        long signed int j ;
+        std::vector<long_unsigned_int> polylines ;
+    } ;
+
+    /** @brief The result of partition(): the fields which are not empty,
+     * ordered by i then by j, and the numbers of the polylines which fit in
+     * no field. */
+    struct Partition {
+        std::vector<Field> fields ;
+        std::vector<long_unsigned_int> crossing ;
+    } ;
+
+    /** @brief The library of cells referred to by the instances. */
+    std::vector<Cell> cells ;
+
+    /** @brief The instances of cells, which are part of the pattern after
+     * polylines.
+     *
+     * The Writer derivatives draw them after the polylines, expanding them
+     * one polyline at a time. The other functions of Pattern only act on
+     * polylines, flatten() converts the instances to polylines.
+     */
+    std::vector<Instance> instances ;
 
 protected:
     /** @brief A struct to pass encapsulate metadata used by Writer derivatives.
@@ -126,7 +217,86 @@ protected:
     std::default_random_engine pseudorandom_generator ;
     long_unsigned_int time_seed ;
 
+    /** @brief whether random_update_property() and Pattern_random::generate()
+     * use a Counter_random generator instead of pseudorandom_generator. */
+    bool counter_based_random {false} ;
+
+    /** @brief the number of calls which used a Counter_random since the seed
+     * was set, so that each call draws different numbers. */
+    long_unsigned_int counter_based_passes {0} ;
+
+    /** @brief whether select_window() and nearest_polyline() use
+     * spatial_index. */
+    bool spatial_index_enabled {false} ;
+
+    /** @brief the index of the bounding boxes of polylines, built when
+     * first needed and deleted by the functions which move or modify the
+     * polylines. It is not copied with the pattern. */
+    mutable std::unique_ptr<Polyline_index> spatial_index ;
+
+    /** @brief returns spatial_index, building it if it was deleted or if the
+     * number of polylines changed since it was built. */
+    const Polyline_index &get_spatial_index () const ;
+
     bool compare_polylines (const Polyline &p1, const Polyline &p2) ;
+
+    /** @brief calls f on each selected polyline.
+     *
+     * When compiled with OpenMP (cmake option USE_OPENMP), the polylines are
+     * distributed over get_number_threads() threads. f must therefore only
+     * modify the polyline it receives, and must not throw. */
+    void for_each_selected (const selection_t selection,
+                            const std::function<void (Polyline &)> &f) ;
+
+    /** @brief returns the sum of f over the selected polylines.
+     *
+     * The polylines are cut into chunks of a fixed number of polylines, each
+     * summed by one thread with a compensated summation, and the sums of the
+     * chunks are then added in their order, compensated as well. The result
+     * is therefore the same whatever the number of threads, and far more
+     * accurate than a plain sum over millions of polylines. f must not
+     * throw. */
+    double sum_selected (const selection_t selection,
+        const std::function<double (const Polyline &)> &f) const ;
+
+    /** @brief replaces each selected polyline by the pattern returned by f,
+     * after itself if keep_initial is true.
+     *
+     * f is called in parallel on the polylines when compiled with OpenMP. */
+    void replace_selected (const std::function<Pattern (const Polyline &)> &f,
+                           const bool keep_initial,
+                           const selection_t selection) ;
+
+    /** @brief moves the polyline at indices[order[i]] to indices[i], for
+     * each i. order must be a permutation of the positions in indices. */
+    void permute_polylines (const std::vector<long_unsigned_int> &indices,
+                            const std::vector<long_unsigned_int> &order) ;
+
+    /** @brief returns inner, in a cell placed by outer, as an instance of
+     * the pattern. */
+    static Instance compose_instances (const Instance &outer,
+                                       const Instance &inner) ;
+
+    /** @brief calls f on a copy of each polyline drawn by instance. */
+    void expand_instance (const Instance &instance,
+        const std::function<void (const Polyline &)> &f) const ;
+
+    /** @brief calls generator, which appends polylines, unless Pattern_cache
+     * holds the polylines it appended with the same parametres and random
+     * state.
+     *
+     * class_name and the vectors, as passed to set_parametres(), describe
+     * the generation. If uses_random is true, the seed and the state of
+     * pseudorandom_generator describe it too, and after a generation read
+     * from the cache, pseudorandom_generator is in the state generator would
+     * have left it. */
+    void generate_cached (const std::string &class_name,
+                          const std::vector<bool> &vbool,
+                          const std::vector<long_unsigned_int> &vint,
+                          const std::vector<double> &vdouble,
+                          const std::vector<std::string> &vstring,
+                          const bool uses_random,
+                          const std::function<void ()> &generator) ;
 public:
     Pattern () ;
 
@@ -151,6 +321,22 @@ public:
      */
     virtual ~Pattern () ;
 
+    /** @brief sets the seed of the pseudorandom generators, which is
+     * otherwise taken from the clock, so that the random functions give the
+     * same results at each launch. */
+    void set_random_seed (const long_unsigned_int seed) ;
+
+    /** @brief whether the random functions which support it draw from a
+     * Counter_random generator.
+     *
+     * Each polyline (or each attempt in Pattern_random::generate()) then has
+     * its own stream of numbers, keyed by the seed and by its index. These
+     * functions are run in parallel when compiled with OpenMP, and their
+     * results only depend on the seed and on the calls made since it was
+     * set, not on the number of threads. The numbers are different from the
+     * ones of the default generator. */
+    void set_counter_based_random (const bool counter_based) ;
+
     /** @brief Function to pass metadata to set-up the Writer.
      *
      * To allow the main program to pass generically the arguments that
@@ -177,6 +363,26 @@ public:
      */ // and set generated = true when it finishes.
     virtual void generate () ;
 
+    /** @brief Calls function with each polyline generate() would append, in
+     * the same order, instead of appending it.
+     *
+     * The generators which override it only keep what the next polylines
+     * depend on, not the polylines, so that a pattern can be written (see
+     * stream()) or passed to a Pipeline with a memory which does not depend
+     * on its size. By default, generate() appends the polylines, function is
+     * called on each and they are erased again. */
+    virtual void generate_each (
+        const std::function<void (const Polyline &)> &function) ;
+
+    /** @brief writes the polylines of generate_each() to writer, between
+     * Writer::begin_stream() and Writer::end_stream(), without appending
+     * them. If with_polylines is set, the polylines of the pattern are
+     * written first, for instance the ones materialized from a procedural
+     * Pattern_rectangular_lattice. Returns the number of polylines
+     * written. */
+    long_unsigned_int stream (Writer &writer,
+                              const bool with_polylines = false) ;
+
     //virtual void write_to (Writer &file) ;
 
     //virtual void write_selected_to (Writer &file) ;
@@ -217,7 +423,11 @@ public:
     void toggle_all (const selection_t selection = -1) ;
 
     /** @brief selects entities whose bounding box is entirely contained within
-     *  the window. */
+     *  the window.
+     *
+     * With set_spatial_index (true), only the polylines near the window are
+     * looked at, which is faster for repeated selections in a large pattern.
+     * Empty polylines are then never selected. */
     void select_window (const double xmin, const double ymin,
                         const double xmax, const double ymax,
                         const bool dots_as_circles = true,
@@ -232,6 +442,44 @@ public:
                         const bool dots_as_circles,
                         const selection_t selection) ;
 
+    /** @brief returns the number of the selected polyline nearest to v, which
+     * is the first one for equal distances, or polylines. size () if no
+     * polyline is selected.
+     *
+     * The distance is measured to the segments of the polylines, see
+     * Polyline::distance_to(). With set_spatial_index (true), only the
+     * polylines whose bounding box is closer than the result are looked at,
+     * otherwise all the polylines are. */
+    long_unsigned_int nearest_polyline (const Vertex &v,
+                                        const selection_t selection = -1) const ;
+
+    /** @brief sets whether select_window() and nearest_polyline() use a
+     * spatial index of the bounding boxes of the polylines (a Polyline_index).
+     *
+     * The index takes O(n log n) to build, and is built again at the next
+     * query after the polylines have been modified by the functions of
+     * Pattern. After modifying polylines directly in place, without changing
+     * their number, invalidate_spatial_index() must be called. */
+    void set_spatial_index (const bool use) ;
+
+    /** @brief deletes the spatial index, so that it is built again when
+     * needed. */
+    void invalidate_spatial_index () ;
+
+    /** @brief selects the polylines whose vertices are all inside outline,
+     * which is taken to be closed.
+     *
+     * The outline is prepared once with Prepared_polygon, so that clipping
+     * a large pattern to an outline of many vertices stays fast. Only the
+     * vertices are tested: an edge of a polyline may still cross a concave
+     * outline. */
+    void select_inside (const Polyline &outline,
+                        const selection_t selection = 0) ;
+
+    /** @brief selects the polylines which are self-crossing, see
+     * Polyline::is_self_crossing(). */
+    void select_self_crossing (const selection_t selection = 0) ;
+
     /** @brief Adds to the current selection a range of polylines in the Pattern
      * with their number. Minimum range value is 1, maximum value is size().
      *
@@ -268,13 +516,43 @@ public:
                   const double comparison_value,
                   double tolerance,
                   const selection_t selection = 0) ;
+
+    /** @brief Selects the polylines for which expression is true, in a
+     * single pass, instead of one select_double_property() or
+     * select_integer_property() per comparison and a
+     * selection_logical_operation() to combine them.
+     *
+     * The expression is made of comparisons of a property with a number, for
+     * example `area > 2 and centre_x < 100 and vertices == 4`, combined with
+     * `and`, `or`, `not` (or `&&`, `||`, `!`) and parentheses. The comparison
+     * operators are `==` (or `=`), `!=`, `<`, `<=`, `>` and `>=`, and the
+     * number may also be on the left.
+     *
+     * The double properties are minimum_x, maximum_x, minimum_y, maximum_y,
+     * centre_x, centre_y, distance_to_centre, horizontal_size,
+     * vertical_size, minimum_distance, maximum_distance, orientation(i),
+     * turning_angle(i), area, perimeter and dose, where i is the vertex
+     * of the parametre. Their `==` and `!=` use tolerance, as
+     * select_double_property() does. The integer properties are vertices,
+     * vertices_modulo(n), closed (0 or 1) and reference, compared exactly.
+     *
+     * Each property is computed once per polyline, the ones sharing a pass
+     * on the vertices together (see Polyline::get_double_properties()).
+     * Selection is erased and replaced. Throws bad_parametre if the
+     * expression cannot be parsed. */
+    void select_where (const std::string &expression,
+                       const double tolerance = 0.0,
+                       const selection_t selection = 0) ;
+
     void select_uniform_pseudorandom (const double fraction,
                                       const selection_t selection = 0) ;
 
     /** @brief Apply a logical operation to selections.
      *
      * This method applies to all polylines, not only members of some
-     * selection.
+     * selection. The registers are combined 64 polylines at a time (see
+     * Polyline_vector::selection_words()), and a chain of these operations
+     * only writes its result back to the polylines once.
      */
     void selection_logical_operation (
                   const selection_t destination_selection,
@@ -344,7 +622,10 @@ public:
     void symmetry_y_centred (const selection_t selection = -1) ;
 
     /** @brief Returns the sum of areas of the selected polylines, calling
-     * Polyline::area() */
+     * Polyline::area().
+     *
+     * As the other sums below, it is compensated and does not depend on
+     * the number of threads. */
     double area (const selection_t selection = -1) const ;
 
     /** @brief Returns the sum of signed areas of the selected polylines,
@@ -551,8 +832,11 @@ public:
      *
      * Duplicated polylines are evaluated to a specific precision. By default,
      * this precision is the machine default for the double type. This function
-     * removes all duplicated polylines and is O(n^2) in commplexity, where n
-     * is the number of polylines in the pattern.
+     * removes all duplicated polylines, keeping the first occurrence. Only
+     * selected polylines are removed, and only when equal to another selected
+     * polyline. Polylines are indexed by their first vertex in a Vertex_grid,
+     * so that expected complexity is O(n), where n is the number of polylines
+     * in the pattern.
      * */
     void remove_duplicated_polylines (
         const double precision = std::numeric_limits<double>::epsilon(),
@@ -608,6 +892,72 @@ public:
      * */
     void replace_polyline_by_pattern (const Pattern &p, const bool centre = true, const bool keep_initial_properties = true, const selection_t selection = -1) ;
 
+    // Cells and instances
+    //////////////////////
+
+    /** @brief Adds to cells a cell named name, made of the polylines and
+     * instances of pattern, and returns its index.
+     *
+     * The cells of pattern are added first, as the instances refer to them.
+     * If name is already used by a cell, a number is appended to it so that
+     * the names are unique. */
+    long_unsigned_int add_cell (const std::string &name,
+                                const Pattern &pattern) ;
+
+    /** @brief Adds an instance of cell number cell, with the default
+     * properties of a Polyline.
+     *
+     * @sa Instance */
+    void add_instance (const long_unsigned_int cell,
+                       const Vertex &position,
+                       const double angle = 0,
+                       const double scale = 1) ;
+
+    void add_instance (const long_unsigned_int cell,
+                       const double x, const double y,
+                       const double angle = 0,
+                       const double scale = 1) ;
+
+    /** @brief Does what replace_polyline_by_pattern() does, but with
+     * instances instead of copies of p.
+     *
+     * p is added once as a cell named cell_name, and each selected polyline
+     * is replaced by an instance of it, which has the properties of the
+     * polyline. If keep_initial_properties is true, the instances override
+     * the properties of the polylines they draw.
+     *
+     * Writing the pattern then gives the same polylines as after
+     * replace_polyline_by_pattern(), but p is kept only once in memory.
+     * Writer_DXF_R12 can also write it once, as a block.
+     * */
+    void replace_polyline_by_instance (const Pattern &p,
+                                       const std::string &cell_name,
+                                       const bool centre = true,
+                                       const bool keep_initial_properties = true,
+                                       const selection_t selection = -1) ;
+
+    /** @brief Replaces the selected instances by the polylines they draw,
+     * appended to polylines. The cells are kept. */
+    void flatten (const selection_t selection = -1) ;
+
+    /** @brief calls f on each polyline drawn by the selected instances.
+     *
+     * The polylines are computed one at a time, so that they do not need to
+     * be all in memory at the same time. */
+    void for_each_instance_polyline (
+        const std::function<void (const Polyline &)> &f,
+        const selection_t selection = -1) const ;
+
+    /** @brief sets min and max to the corners of a box containing the
+     * polylines drawn by the selected instances, and returns whether there
+     * are such polylines.
+     *
+     * The box is found from the ones of the cells, without drawing the
+     * instances. For instances which are rotated, it may therefore be larger
+     * than the smallest box. */
+    bool instances_limits (Vertex &min, Vertex &max,
+                           const selection_t selection = -1) const ;
+
     /** @brief Replaces each polyline by a regular polygon, calling replace_by()
      * and the Polyline constructor with two arguments.
      *
@@ -624,10 +974,17 @@ public:
 
     /** @brief Function which converts each selected closed Polyline into a
      * vector of two-vertices Polyline that can be drawn along a line.
+     *
+     * Each selected polyline is replaced by its lines, after itself if
+     * keep_initial is true. The polylines are filled in parallel when
+     * compiled with OpenMP.
+     *
+     * @sa Pattern_factory::fill_with_lines()
      */
     void fill_with_lines (const double angle, const double spacing,
                           const bool keep_initial,
-                          const selection_t selection = -1) ;
+                          const selection_t selection = -1,
+                          const enum_fill_rule fill_rule = fill_rule_extent) ;
 
     /** @brief Function which converts each selected closed Polyline into a
      * vector of two-vertices Polyline that can be drawn along a line. The angle
@@ -644,7 +1001,21 @@ public:
      */
     void fill_with_lines_first_angle (const double spacing,
                                       const bool keep_initial,
-                                      const selection_t selection = -1) ;
+                                      const selection_t selection = -1,
+                                      const enum_fill_rule fill_rule =
+                                          fill_rule_extent) ;
+
+    /** @brief Fills the region made by all the selected closed polylines
+     * with lines, the polylines inside others making holes.
+     *
+     * The selected polylines are removed unless keep_initial is true.
+     *
+     * @sa Pattern_factory::fill_region_with_lines()
+     */
+    void fill_region_with_lines (const double angle, const double spacing,
+                                 const enum_fill_rule fill_rule,
+                                 const bool keep_initial,
+                                 const selection_t selection = -1) ;
 
     /** @brief Function which converts each selected closed Polyline into a
      * a vector of single dots, filling the area of the polyline (which is
@@ -660,7 +1031,8 @@ public:
                     const double phase_increment,
                     const enum_partial_dash_policy partial_policy,
                     const bool keep_initial,
-                    const selection_t selection = -1) ;
+                    const selection_t selection = -1,
+                    const enum_fill_rule fill_rule = fill_rule_extent) ;
 
     /** @brief Variant of fill_with_dash which uses the first angle as the
      * longitudinal direction.
@@ -675,7 +1047,85 @@ public:
                 const double phase_increment,
                 const enum_partial_dash_policy partial_policy,
                 const bool keep_initial,
-                const selection_t selection = -1) ;
+                const selection_t selection = -1,
+                const enum_fill_rule fill_rule = fill_rule_extent) ;
+
+    /** @brief fill_with_dashes() on the region made by all the selected
+     * closed polylines, see fill_region_with_lines(). */
+    void fill_region_with_dashes (const double angle,
+                    const double spacing_longitudinal,
+                    const double spacing_transversal,
+                    const double duty_cycle,
+                    const double phase_initial,
+                    const double phase_increment,
+                    const enum_partial_dash_policy partial_policy,
+                    const enum_fill_rule fill_rule,
+                    const bool keep_initial,
+                    const selection_t selection = -1) ;
+
+    /** @brief Replaces the closed polylines of selection_a and selection_b
+     * by the result of operation between them, see
+     * Pattern_factory::boolean_operation(). The open polylines are kept, and
+     * the result is added at the end.
+     *
+     * The polylines used are removed unless keep_initial is true. */
+    void boolean_operation (const enum_boolean_operation operation,
+                            const selection_t selection_a,
+                            const selection_t selection_b,
+                            const bool keep_initial = false) ;
+
+    /** @brief Merges the selected closed polylines into the contours of their
+     * union, see boolean_operation(). */
+    void boolean_union (const selection_t selection = -1) ;
+
+    /** @brief Replaces the closed polylines of selection_a and selection_b
+     * by their intersection, see boolean_operation(). */
+    void boolean_intersection (const selection_t selection_a,
+                               const selection_t selection_b) ;
+
+    /** @brief Replaces the closed polylines of selection_a and selection_b
+     * by the parts of selection_a outside selection_b, see
+     * boolean_operation(). */
+    void boolean_difference (const selection_t selection_a,
+                             const selection_t selection_b) ;
+
+    /** @brief Replaces the closed polylines of selection_a and selection_b
+     * by the parts inside only one of them, see boolean_operation(). */
+    void boolean_xor (const selection_t selection_a,
+                      const selection_t selection_b) ;
+
+    /** @brief Distributes the selected polylines into write fields of
+     * field_size_x × field_size_y, the field (0, 0) starting at origin.
+     *
+     * Each polyline goes to the field which contains the centre of its
+     * bounding box, if its bounding box lies inside that field enlarged by
+     * overlap on each side, or otherwise to the crossing polylines. The
+     * bounding boxes are computed in parallel and the polylines are sorted
+     * in one pass, which is O(n log f) for f fields.
+     *
+     * If clip is true, the crossing polylines are replaced, at their place
+     * in polylines, by their parts inside each field they meet, with their
+     * metadata: closed polylines of at least three vertices by their
+     * intersection with the field (see Polygon_boolean), the other ones by
+     * the parts of their segments inside the field. The parts then go to
+     * their field, and crossing is empty. Dots never cross, and empty
+     * polylines are in no field.
+     *
+     * The numbers of the result refer to polylines as they are after the
+     * call, and only stay valid until they are modified. */
+    Partition partition (const Vertex &origin,
+                         const double field_size_x,
+                         const double field_size_y,
+                         const double overlap = 0.0,
+                         const bool clip = false,
+                         const selection_t selection = -1) ;
+
+    /** @brief selects in result_selection the polylines of the field number
+     * field of a partition() of this pattern. If field is partition. fields.
+     * size (), the crossing polylines are selected. */
+    void select_field (const Partition &partition,
+                       const long_unsigned_int field,
+                       const selection_t result_selection = 0) ;
 
     /** @brief Duplicates the selected polylines. The initial polyline are
      * unselected from selection 0, the newly created are selected in 0.
@@ -744,13 +1194,22 @@ public:
 
     /** @brief Erases the selected polylines.
      *
-     * This function can cost time if selected polylines are located very far
-     * from the end of the vector. This is because it calls std::vector::erase()
-     * on each selected Polyline, whose complexity is linear with the distance
-     * between the element to be erased and the end of the vector.
+     * The other polylines are moved in place, keeping their order, so that
+     * the time is linear in the number of polylines and no copy of them is
+     * made.
      */
     void erase (const selection_t selection = -1) ;
 
+    /** @brief Gives back the memory left unused by the previous operations.
+     *
+     * Each polyline gets a new vertex buffer of exactly its size, allocated
+     * in the order of the polylines, and the vector of polylines is reduced
+     * to its size. After heavy editing (explode(), erase(), simplify()...)
+     * this returns the slack of the vectors to the system, and places the
+     * vertices of consecutive polylines close in memory for the next passes.
+     */
+    void compact () ;
+
     /** @brief Set the selected polylines to closed (true) or open (false). */
     void set_closure (const bool closure_value,
         const selection_t selection = -1) ;
@@ -761,6 +1220,27 @@ public:
     /** @brief Appends one polyline to the pattern. */
     void push_back (const Polyline &p) ;
 
+    /** @brief Appends sizes. size () polylines to the pattern, the first one
+     * with the first sizes[0] vertices of coordinates, the next one with the
+     * next sizes[1] vertices, etc.
+     *
+     * The coordinates are in the order x0, y0, x1, y1, etc., as in
+     * Polyline::push_back_coordinates(), for all the polylines one after
+     * the other. This allows a script to build a whole pattern in one call.
+     * Throws bad_parametre if coordinates does not have two values for each
+     * vertex of sizes. */
+    void push_back_coordinates (const std::vector<double> &coordinates,
+                                const std::vector<long_unsigned_int> &sizes) ;
+
+    /** @brief Returns the coordinates of the vertices of the selected
+     * polylines, one polyline after the other, as push_back_coordinates()
+     * takes them. */
+    std::vector<double> get_coordinates (const selection_t selection = -1) const ;
+
+    /** @brief Returns the number of vertices of each selected polyline, as
+     * push_back_coordinates() takes them. */
+    std::vector<long_unsigned_int> get_sizes (const selection_t selection = -1) const ;
+
     /* @brief Prepends one polyline to the pattern.
     void push_front (const Polyline &p) ;*/
 
@@ -775,6 +1255,15 @@ public:
      * argument.
     void append_to (Pattern &p) const ;*/
 
+    /** @brief returns the indices in polylines of the polylines of
+     * selection (all of them if selection is negative), in their order.
+     *
+     * This is a view of the selection which, as opposed to
+     * Pattern_factory::Pattern_from_selected(), does not copy the polylines.
+     * It is valid until polylines is modified. */
+    std::vector<long_unsigned_int> selected_indices (
+        const selection_t selection = -1) const ;
+
     /** @brief Appends the pattern passed as argument to the current
      * instance. */
     void append_from (const Pattern &p, const selection_t selection = -1) ;
@@ -791,6 +1280,8 @@ public:
      * angle, etc. according to several random distributions.
      *
      * Note that property 0 is bivariate, while all other are monovariate.
+     * type_Poisson_disk_distribution, which only applies to
+     * Pattern_random, is refused.
      */
     void random_update_property (const enum_random_property property,
                   const enum_distribution random_distribution,
@@ -974,11 +1465,41 @@ public:
         const selection_t selection = -1) ;
 
     void subdivide (const double distance, const selection_t selection = -1) ;
+
+    /** @brief calls Polyline::simplify() on each selected polyline. */
+    void simplify (const double tolerance, const selection_t selection = -1) ;
     void reorder_vertices_by_angle(const selection_t selection = -1) ;
 #ifdef GSL_FOUND
     void apply_matrix (Matrix3x3 &matrix, const selection_t selection = -1) ;
     void apply_homography (Matrix3x3 &matrix, const selection_t selection = -1) ;
 #endif
+    /** @brief Calls f on the coordinates of the vertices of the selected
+     * polylines, batch_size vertices at a time, and moves the vertices to
+     * the coordinates f leaves.
+     *
+     * The coordinates are in the order x0, y0, x1, y1, etc., as in
+     * get_coordinates(), and a batch can contain the end of a polyline and
+     * the beginning of the next. f must leave the same number of values.
+     * This allows any deformation, such as a distortion correction, with one
+     * call per batch instead of one per vertex, which matters when f is a
+     * Lua function. If batch_size is 0, all the vertices are in a single
+     * batch.
+     *
+     * If thread_safe is true and dpps was compiled with OpenMP, the batches
+     * are distributed over threads, so f must then not modify anything but
+     * its argument. Lua functions are always called one batch at a time. */
+    void map_vertices (const std::function<void (std::vector<double> &)> &f,
+                       long_unsigned_int batch_size = 65536,
+                       const bool thread_safe = false,
+                       const selection_t selection = -1) ;
+
+    /** @brief Applies transform to the selected polylines.
+     *
+     * transform can chain any number of translations, rotations, scalings
+     * and symmetries, which are then applied in a single pass over the
+     * vertices. See Affine_transform. */
+    void apply_transform (const Affine_transform &transform,
+                          const selection_t selection = -1) ;
     /** @brief performs a cycle (french permutation circulaire) or rotation
      * on the vertices of each selected polyline. */
     void cycle (long_unsigned_int val, const bool forward = true,
@@ -995,6 +1516,11 @@ public:
      * polyline in the pattern */
     void cut_into (Polyline p, const bool reverse_auto = true,
         const selection_t selection = -1) ;
+    /** @brief cuts all the polylines of holes into each selected polyline in
+     * the pattern at once, see Polyline::cut_into() with a vector of holes.
+     * holes may be the pattern itself. */
+    void cut_into (const Pattern &holes, const bool reverse_auto = true,
+        const selection_t selection = -1) ;
 
     /** @brief Check if selected polylines have a last vertex identical to the
      * first (which is sometimes used as a visual way to close a polyline),
@@ -18,10 +18,30 @@
  */
 
 #include <vector>
+#include <cmath>
 
+#include "common.hh"
 #include "Pattern_Fibonacci.hh"
 #include "bad_parametre.hh"
 
+// floor (sqrt (x)), exactly.
+static uint64_t integer_square_root (const uint64_t x) {
+    uint64_t r {static_cast<uint64_t> (std::sqrt (static_cast<long double> (x)))} ;
+    while (r * r > x)
+        r-- ;
+    while ((r + 1) * (r + 1) <= x)
+        r++ ;
+    return r ;
+}
+
+// floor (n / golden_ratio), which is floor (n * (sqrt (5) - 1) / 2), computed
+// on integers: as n * sqrt (5) is not an integer for n > 0, it is
+// floor ((floor (n * sqrt (5)) - n) / 2). The division by a double would be
+// wrong for some large n close to a Fibonacci number.
+static uint64_t floor_by_golden_ratio (const uint64_t n) {
+    return (integer_square_root (5 * n * n) - n) / 2 ;
+}
+
 dpps::Pattern_Fibonacci::Pattern_Fibonacci (): Pattern () {
 }
 
@@ -91,73 +111,129 @@ void dpps::Pattern_Fibonacci::set_parametres (
 }
 
 void dpps::Pattern_Fibonacci::generate () {
-    if (pattern_settings. bidimentionnal)
-        generate_2d () ;
-    else
-        generate_1d () ;
+    generate_cached ("Pattern_Fibonacci",
+        {pattern_settings. bidimentionnal},
+        {pattern_settings. generation},
+        {pattern_settings. x0, pattern_settings. y0, pattern_settings. size},
+        {},
+        false,
+        [this] {
+            if (pattern_settings. bidimentionnal)
+                generate_2d () ;
+            else
+                generate_1d () ;
+        }) ;
+}
+
+void dpps::Pattern_Fibonacci::generate_each (
+    const std::function<void (const Polyline &)> &function) {
+    // Only the sequence is kept, one byte per element, the polylines are
+    // made one at a time in the order of generate_1d() and generate_2d().
+    std::vector<char> fibonacci_sequence ;
+    generate_Fibonacci_sequence (pattern_settings. generation,
+                                 fibonacci_sequence) ;
+    long_unsigned_int number {fibonacci_sequence. size ()} ;
+    double half_size {(0.5*number) * pattern_settings. size} ;
+    double minx {pattern_settings. x0 - half_size} ;
+    double miny {pattern_settings. y0 - half_size} ;
+    Polyline p ;
+    p. closed = true ;
+    if (!pattern_settings. bidimentionnal) {
+        double maxy {pattern_settings. y0 + half_size} ;
+        for (long_unsigned_int i {0} ; i < number ; i++) {
+            if (fibonacci_sequence[i] != true_)
+                continue ;
+            double startx {minx + i * pattern_settings. size} ;
+            double endx {startx + pattern_settings. size * linear_ratio} ;
+            p. vertices. clear () ;
+            p. push_back (Vertex (startx, miny)) ;
+            p. push_back (Vertex (startx, maxy)) ;
+            p. push_back (Vertex (endx, maxy)) ;
+            p. push_back (Vertex (endx, miny)) ;
+            function (p) ;
+        }
+        return ;
+    }
+    double side {pattern_settings. size * area_ratio} ;
+    for (long_unsigned_int i {0} ; i < number ; i++) {
+        double startx {minx + i * pattern_settings. size} ;
+        for (long_unsigned_int j {0} ; j < number ; j++) {
+            if (fibonacci_sequence[i] != fibonacci_sequence[j])
+                continue ;
+            double starty {miny + j * pattern_settings. size} ;
+            p. vertices. clear () ;
+            p. push_back (Vertex (startx, starty)) ;
+            p. push_back (Vertex (startx + side, starty)) ;
+            p. push_back (Vertex (startx + side, starty + side)) ;
+            p. push_back (Vertex (startx, starty + side)) ;
+            function (p) ;
+        }
+    }
+}
+
+long_unsigned_int dpps::Pattern_Fibonacci::Fibonacci_length (
+    const long_unsigned_int generation) {
+    if (generation > maximum_generation) {
+        std::string reason {"Pattern_Fibonacci: generation is at most " +
+            std::to_string (maximum_generation) + ", but value provided is " +
+            std::to_string (generation)} ;
+        throw bad_parametre (reason. c_str ()) ;
+    }
+    if (generation < 3)
+        return generation ;
+    // The length increases as the Fibonacci numbers, minus one.
+    long_unsigned_int previous {1} ;
+    long_unsigned_int current {1} ;
+    for (long_unsigned_int i {1} ; i <= generation ; i++) {
+        long_unsigned_int next {previous + current} ;
+        previous = current ;
+        current = next ;
+    }
+    return previous + 1 ;
+}
+
+bool dpps::Pattern_Fibonacci::Fibonacci_element (const long_unsigned_int n) {
+    // The first element stays L, and is followed by the Fibonacci word,
+    // whose element k is L if floor ((k+2)/golden_ratio) -
+    // floor ((k+1)/golden_ratio) is 1, see for instance
+    // https://en.wikipedia.org/wiki/Fibonacci_word
+    if (n == 0)
+        return true ;
+    return floor_by_golden_ratio (n + 1) - floor_by_golden_ratio (n) == 1 ;
 }
 
 void dpps::Pattern_Fibonacci::generate_Fibonacci_sequence (
     long_unsigned_int generation, std::vector<char> &result) {
+// S -> L, L -> LS | false -> true ; true  -> true,false
+// C Janot. Quasicrystals, a primer, Oxford University Press,
+// 2nd Ed (1994), p. 23.
+// 'A'=='L' == true, 'B'=='S' == false
+//
+// The substitutions, starting from LS, were applied to all the elements but
+// the first one. Rather than applying them, which took 17 s at generation
+// 30, each element is computed directly by Fibonacci_element().
+//
 // Note that vector<bool> is a C++11 specialization of vector<> with
 // few differences to allow working on individual bits while packing them by
 // byte in memory (occupying 8 times less memory). It is much slower to
 // use so we decided for a vector<char>.
-// To give an example, at iteration 26 there are 196419 elements.
-// Generation takes 22 s with vector<bool> and 0.35 s with vector<char>
-// (gcc-4.9.0-alpha20140126, -O9)
 // See also Nicolai M. Josuttis, the C++ Standard Library 2nd Ed., section 7.3.6
 // p. 281, Addison-Wesley.
-//
-// Counter-intuitively, we measure that reserve () incrases slightly the process
-// time. At generation 30 with 1 346 270 elements, program takes
-// 17.08 s with reserve, 16.79 without. Still we keep it as difference is small
-// and believe that reserve() is somehow the good thing to do.
-//
-// S -> L, L -> LS | false -> true ; true  -> true,false
-// C Janot. Quasicrystals, a primer, Oxford University Press,
-// 2nd Ed (1994), p. 23.
-// 'A'=='L' == true, 'B'=='S' == false
-    result. clear () ;
-    switch (generation) {
-        case 0:
-            break ;
-        case 1:
-            result. push_back (true_) ;
-            break ;
-        case 2:
-            result. push_back (true_) ;
-            result. push_back (false_) ;
-            break ;
-        default:
-            // At gen. 30 there are 1'346'270 elements, and we know the increase
-            // rate is the golen ratio.
-            long_unsigned_int prevision {static_cast<long_unsigned_int> (
-                round (1346270.0 * pow (golden_ratio, 1.0 *
-                                        generation - 30.0)))} ;
-            // std::cout << prevision << std::endl ;
-            result. reserve (prevision) ;
-            result. push_back (true_) ;
-            result. push_back (false_) ;
-            for (long_unsigned_int j = 0 ; j < generation ; j++) {
-                for (long_unsigned_int i = result. size () - 1 ; i > 0 ; i--) {
-                    if (result [i] == true_) {
-                        // L -> LS: we insert S (false_) after position i.
-                        // NOTE: gcc allows cbegin() here, but clang does not.
-                        result. insert (result. begin () + i + 1, false_) ;
-                    }
-                    else // S -> L
-                        result [i] = true_ ;
-                }
-            }
-            break ;
+    long_unsigned_int n {Fibonacci_length (generation)} ;
+    // Generation 2 is LS, before the first substitution.
+    if (generation == 2) {
+        result. assign ({true_, false_}) ;
+        return ;
     }
+    result. resize (n) ;
+#ifdef OPENMP_FOUND
+    #pragma omp parallel for schedule(static) if (n > 65536)
+#endif
+    for (long_unsigned_int i = 0 ; i < n ; i++)
+        result[i] = Fibonacci_element (i) ? true_ : false_ ;
 }
 
 void dpps::Pattern_Fibonacci::generate_1d () {
-    Vertex v ;
-    Polyline p ;
-    p. closed = true ;
     std::vector<char> fibonacci_sequence ;
     generate_Fibonacci_sequence (pattern_settings. generation,
                                  fibonacci_sequence) ;
@@ -166,27 +242,28 @@ void dpps::Pattern_Fibonacci::generate_1d () {
     double minx {pattern_settings. x0 - half_size} ;
     double miny {pattern_settings. y0 - half_size} ;
     double maxy {pattern_settings. y0 + half_size} ;
-    double startx {minx} ;
-    //std::cout << "number : " << pattern_settings. generation << " " << number << std::endl ;
-    for (long_unsigned_int i = 0 ; i < number ; i++) {
-        // https://en.wikipedia.org/wiki/Truth_table
-        // https://en.wikipedia.org/wiki/Logical_biconditional
-        // std::cout << i << " " ;
-        if (fibonacci_sequence. at (i) == true_)  {
-            //std::cout << "*" ;
-            v. x = startx ;
-            v. y = miny ;
-            p. push_back (v) ;
-            v. y = maxy ;
-            p. push_back (v) ;
-            v. x = startx + pattern_settings. size * linear_ratio ;
-            p. push_back (v) ;
-            v. y = miny ;
-            p. push_back (v) ;
-            polylines. push_back (p) ;
-            p. vertices. clear () ; // does not change that p. closed == true ;
-        }
-        startx += pattern_settings. size ;
+    // The elements with a line are listed first, so that the lines can be
+    // made in parallel, each one at its place.
+    std::vector<long_unsigned_int> lines ;
+    for (long_unsigned_int i = 0 ; i < number ; i++)
+        if (fibonacci_sequence[i] == true_)
+            lines. push_back (i) ;
+    long_unsigned_int first {polylines. size ()} ;
+    long_unsigned_int n {lines. size ()} ;
+    polylines. resize (first + n) ;
+#ifdef OPENMP_FOUND
+    #pragma omp parallel for schedule(static) if (n > 4096)
+#endif
+    for (long_unsigned_int k = 0 ; k < n ; k++) {
+        Polyline &p = polylines[first + k] ;
+        p. closed = true ;
+        p. vertices. reserve (4) ;
+        double startx {minx + lines[k] * pattern_settings. size} ;
+        double endx {startx + pattern_settings. size * linear_ratio} ;
+        p. push_back (Vertex (startx, miny)) ;
+        p. push_back (Vertex (startx, maxy)) ;
+        p. push_back (Vertex (endx, maxy)) ;
+        p. push_back (Vertex (endx, miny)) ;
     }
 }
 
@@ -202,9 +279,6 @@ void dpps::Pattern_Fibonacci::generate_2d () {
     // Actually we don't use their fA/fB method which turns out complex to
     // implement with 2D vectors. But we do use their figure 1b to build
     // a really simple way.
-    Vertex v ;
-    Polyline p ;
-    p. closed = true ;
     std::vector <char> fibonacci_sequence ;
     generate_Fibonacci_sequence (pattern_settings. generation,
                                  fibonacci_sequence) ;
@@ -212,27 +286,40 @@ void dpps::Pattern_Fibonacci::generate_2d () {
     double half_size {(0.5*number) * pattern_settings. size} ;
     double minx {pattern_settings. x0 - half_size} ;
     double miny {pattern_settings. y0 - half_size} ;
-    double startx {minx} ;
+    double side {pattern_settings. size * area_ratio} ;
+
+    // X XNOR Y = Biconditional = X IFF Y, NOT (X XOR Y), X == Y
+    // We output a square where fi XNOR fj. A row of L elements has as many
+    // squares as there are L, and a row of S as many as there are S, so the
+    // first square of each row is known and the rows are made in parallel.
+    long_unsigned_int number_L {0} ;
+    for (long_unsigned_int i = 0 ; i < number ; i++)
+        if (fibonacci_sequence[i] == true_)
+            number_L++ ;
+    std::vector<long_unsigned_int> row_start (number + 1) ;
+    row_start[0] = polylines. size () ;
+    for (long_unsigned_int i = 0 ; i < number ; i++)
+        row_start[i+1] = row_start[i] + (fibonacci_sequence[i] == true_ ?
+                                         number_L : number - number_L) ;
+    polylines. resize (row_start[number]) ;
+#ifdef OPENMP_FOUND
+    #pragma omp parallel for schedule(dynamic, 16) if (number > 64)
+#endif
     for (long_unsigned_int i = 0 ; i < number ; i++) {
-        double starty {miny} ;
+        double startx {minx + i * pattern_settings. size} ;
+        long_unsigned_int k {row_start[i]} ;
         for (long_unsigned_int j = 0 ; j < number ; j++) {
-            // X XNOR Y = Biconditional = X IFF Y, NOT (X XOR Y), X == Y
-            // We output a square where fi XNOR fj
-            if (fibonacci_sequence [i] == fibonacci_sequence [j])  {
-                v. x = startx ;
-                v. y = starty ;
-                p. push_back (v) ;
-                v. x += pattern_settings. size * area_ratio ;
-                p. push_back (v) ;
-                v. y += pattern_settings. size * area_ratio ;
-                p. push_back (v) ;
-                v. x = startx ;
-                p. push_back (v) ;
-                polylines. push_back (p) ;
-                p. vertices. clear () ;
+            if (fibonacci_sequence[i] == fibonacci_sequence[j]) {
+                double starty {miny + j * pattern_settings. size} ;
+                Polyline &p = polylines[k] ;
+                p. closed = true ;
+                p. vertices. reserve (4) ;
+                p. push_back (Vertex (startx, starty)) ;
+                p. push_back (Vertex (startx + side, starty)) ;
+                p. push_back (Vertex (startx + side, starty + side)) ;
+                p. push_back (Vertex (startx, starty + side)) ;
+                k++ ;
             }
-            starty += pattern_settings. size ;
         }
-        startx += pattern_settings. size ;
     }
-}
\ No newline at end of file
+}
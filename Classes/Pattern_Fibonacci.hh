@@ -63,9 +63,12 @@ protected:
     const char true_ = 'T' ;
     const char false_ = 'F' ;
 
-    /** @brief Returns a vector containing at least n elements of
-     * a Fibonacci sequence. The boolean answer uses true for L, false for S
-     */
+    /** @brief the largest generation, for which the sequence has
+     * 1836311904 elements. */
+    static const long_unsigned_int maximum_generation {45} ;
+
+    /** @brief Returns a vector containing the Fibonacci sequence of the
+     * generation, true_ for L, false_ for S. */
     void generate_Fibonacci_sequence (long_unsigned_int n,
                                       std::vector<char> &result) ;
     //void generate_Fibonacci_array (long_unsigned_int n,
@@ -76,6 +79,17 @@ protected:
 //     void modify_column_B (std::vector <bool> &result) ;
 
 public:
+    /** @brief the number of elements of the sequence of the generation. */
+    static long_unsigned_int Fibonacci_length (
+        const long_unsigned_int generation) ;
+
+    /** @brief whether element n of the sequence is L (true) or S (false).
+     *
+     * Each element is computed directly: apart from generation 2, which is
+     * LS, the sequence of each generation is the beginning of the one of the
+     * next generation. */
+    static bool Fibonacci_element (const long_unsigned_int n) ;
+
     /** @brief the default constructor */
     Pattern_Fibonacci () ;
 
@@ -104,6 +118,11 @@ public:
                          const std::vector<std::string> &vstring) ;
 
     void generate () ;
+
+    /** @brief see Pattern::generate_each(). The polylines are not read from
+     * or added to Pattern_cache. */
+    void generate_each (
+        const std::function<void (const Polyline &)> &function) ;
     void generate_1d () ;
     void generate_2d () ;
 
@@ -92,11 +92,35 @@ P1.........P3      .....A.....      .....1   1      2.....1
  */
 
 #include <vector>
+#include <algorithm>
 
 #include "common.hh"
 #include "Pattern_Penrose_tiling.hh"
+#include "Writer.hh"
 #include "bad_parametre.hh"
 
+// height of the obtuse Robinson triangle, where base is 1.
+#ifdef __GNUC__
+#ifndef __clang__
+// gcc allows to calculate those, although sqrt is not
+// constexpr by the standard
+constexpr const double h_obtuse_gnomon {tan (M_PI/5.0)/2.0} ;
+constexpr const double h_acute_gnomon  {tan (M_PI/2.5)/2.0} ;
+constexpr const double Phi {(sqrt(5.0) - 1.0)/2.0} ;
+#define CONSTEXPR_OK
+#endif
+#endif
+#ifndef CONSTEXPR_OK
+// for other compilers, we provide an approximation.
+constexpr const double h_obtuse_gnomon {0.363271264} ;
+constexpr const double h_acute_gnomon  {1.538841769} ;
+constexpr const double Phi {0.618033988} ;
+#endif
+constexpr const double Phi2 {Phi * Phi} ;
+constexpr const double phi {1.0/Phi} ; // == Phi+1
+// constexpr const double Phi3 {Phi2 * Phi} ;
+// constexpr const double two_thirds {2.0 / 3.0} ;
+
 dpps::Pattern_Penrose_tiling::Pattern_Penrose_tiling (): Pattern () {
 }
 
@@ -176,49 +200,100 @@ tiles), 3 (two large tiles), but value provided is" +
 }
 
 void dpps::Pattern_Penrose_tiling::generate () {
-    //if (pattern_settings. P3)
-        generate_P3 () ;
-    //else
-    //    generate_P2 () ;
+    // The window is not a parametre, but it changes the result.
+    generate_cached ("Pattern_Penrose_tiling",
+        {pattern_settings. window},
+        {pattern_settings. generation,
+         static_cast<long_unsigned_int> (pattern_settings. start_tile)},
+        {pattern_settings. x0, pattern_settings. y0, pattern_settings. size,
+         pattern_settings. window_xmin, pattern_settings. window_ymin,
+         pattern_settings. window_xmax, pattern_settings. window_ymax},
+        {},
+        false,
+        [this] {
+            //if (pattern_settings. P3)
+                generate_P3 () ;
+            //else
+            //    generate_P2 () ;
+        }) ;
 }
 
 
-void dpps::Pattern_Penrose_tiling::generate_P3 () {
-    // Following deflation method from:
-    // http://tartarus.org/simon/20110412-penrose/penrose.xhtml
-    //
-    // We build a pattern based on triangles. It would be possible from later
-    // identify reflected tiles and join them, in a O(n^2) algorithm. but
-    // actually we don't really care. If all we want is to draw inside the small
-    // or the large tiles, we can just use the triangle pattern.
+void dpps::Pattern_Penrose_tiling::set_window (const double xmin,
+                                               const double ymin,
+                                               const double xmax,
+                                               const double ymax) {
+    if ((xmin > xmax) || (ymin > ymax)) {
+        std::string reason {"Pattern_Penrose_tiling::set_window, the \
+minimum coordinates must not be larger than the maximum ones."} ;
+        throw bad_parametre (reason. c_str ()) ;
+    }
+    pattern_settings. window = true ;
+    pattern_settings. window_xmin = xmin ;
+    pattern_settings. window_ymin = ymin ;
+    pattern_settings. window_xmax = xmax ;
+    pattern_settings. window_ymax = ymax ;
+}
 
-    // height of the obtuse Robinson triangle, where base is 1.
-#ifdef __GNUC__
-#ifndef __clang__
-    // gcc allows to calculate those, although sqrt is not
-    // constexpr by the standard
-    constexpr const double h_obtuse_gnomon {tan (M_PI/5.0)/2.0} ;
-    constexpr const double h_acute_gnomon  {tan (M_PI/2.5)/2.0} ;
-    constexpr const double Phi {(sqrt(5.0) - 1.0)/2.0} ;
-#define CONSTEXPR_OK
-#endif
-#endif
-#ifndef CONSTEXPR_OK
-    // for other compilers, we provide an approximation.
-    constexpr const double h_obtuse_gnomon {0.363271264} ;
-    constexpr const double h_acute_gnomon  {1.538841769} ;
-    constexpr const double Phi {0.618033988} ;
-#endif
-    constexpr const double Phi2 {Phi * Phi} ;
-    constexpr const double phi {1.0/Phi} ; // == Phi+1
-    // constexpr const double Phi3 {Phi2 * Phi} ;
-    // constexpr const double two_thirds {2.0 / 3.0} ;
+void dpps::Pattern_Penrose_tiling::clear_window () {
+    pattern_settings. window = false ;
+}
+
+bool dpps::Pattern_Penrose_tiling::meets_window (const Vertex &p1,
+                                                 const Vertex &p2,
+                                                 const Vertex &p3) const {
+    if (!pattern_settings. window)
+        return true ;
+    return (std::max (std::max (p1. x, p2. x), p3. x) >=
+                pattern_settings. window_xmin) &&
+           (std::min (std::min (p1. x, p2. x), p3. x) <=
+                pattern_settings. window_xmax) &&
+           (std::max (std::max (p1. y, p2. y), p3. y) >=
+                pattern_settings. window_ymin) &&
+           (std::min (std::min (p1. y, p2. y), p3. y) <=
+                pattern_settings. window_ymax) ;
+}
+
+void dpps::Pattern_Penrose_tiling::deflate (const Vertex &P1,
+    const Vertex &P2,
+    const Vertex &P3,
+    const bool obtuse,
+    const long_unsigned_int remaining,
+    Polyline &triangle,
+    const std::function<void (const Polyline &)> &output) const {
+    // The smaller triangles lie inside the larger one, so none of them
+    // meets the window if it does not.
+    if (!meets_window (P1, P2, P3))
+        return ;
+    if (remaining == 0) {
+        triangle. vertices. clear () ;
+        triangle. push_back (P1) ;
+        triangle. push_back (P2) ;
+        triangle. push_back (P3) ;
+        triangle. reference = obtuse ? 1 : 0 ;
+        output (triangle) ;
+        return ;
+    }
+    if (obtuse) {
+        // We have an obtuse Robinson triangle.
+        Vertex A = P3 + ((P1 - P3) * Phi2) ;
+        Vertex B = P2 + ((P1 - P2) * Phi2) ;
+        deflate (P3, A, P2, true, remaining - 1, triangle, output) ;
+        deflate (A, B, P1, true, remaining - 1, triangle, output) ;
+        deflate (A, B, P2, false, remaining - 1, triangle, output) ;
+    } else { // acute Robinson triangle
+        Vertex C = P2 + ((P1 - P2) * Phi2) ;
+        deflate (P3, C, P1, true, remaining - 1, triangle, output) ;
+        deflate (P3, C, P2, false, remaining - 1, triangle, output) ;
+    }
+}
+
+std::vector<dpps::Polyline>
+dpps::Pattern_Penrose_tiling::start_triangles () const {
     Vertex v ;
     Polyline p ;
     p. closed = true ;
-
-    if (pattern_settings. generation == 0)
-        return ;
+    std::vector<Polyline> start ;
     // One gnomon. By convention we'll set the obtuse to reference 1,
     // and the acute to 0 (the default). That's just to be
     // able to find them later.
@@ -246,7 +321,7 @@ void dpps::Pattern_Penrose_tiling::generate_P3 () {
         v. x = x0 + 0.5 * pattern_settings. size * phi ;
         v. y = y0 ;
         p. push_back (v) ;
-        polylines. push_back (p) ;
+        start. push_back (p) ;
         if (pattern_settings. start_tile == start_tile_two_large) {
             p. vertices. clear () ;
             v. x = x0 -0.5 * pattern_settings. size * phi ;
@@ -258,7 +333,7 @@ void dpps::Pattern_Penrose_tiling::generate_P3 () {
             v. x = x0 + 0.5 * pattern_settings. size * phi ;
             v. y = y0 ;
             p. push_back (v) ;
-            polylines. push_back (p) ;
+            start. push_back (p) ;
         }
     } else { // start_tile_thin or start_tile_two_thin
         //std::cout << "We have 0 or 2" << std::endl ;
@@ -272,7 +347,7 @@ void dpps::Pattern_Penrose_tiling::generate_P3 () {
         v. x = x0 ;
         v. y = y0 - 0.5 * Phi * pattern_settings. size ;
         p. push_back (v) ;
-        polylines. push_back (p) ;
+        start. push_back (p) ;
         if (pattern_settings. start_tile == start_tile_two_thin) {
             p. vertices. clear () ;
             v. x = x0 + h_acute_gnomon * pattern_settings. size * Phi ;
@@ -284,84 +359,76 @@ void dpps::Pattern_Penrose_tiling::generate_P3 () {
             v. x = x0 ;
             v. y = y0 - 0.5 * Phi * pattern_settings. size ;
             p. push_back (v) ;
-            polylines. push_back (p) ;
+            start. push_back (p) ;
         }
     }
-//     if (pattern_settings. generation == 1)
-//         return ;
-    for (long_unsigned_int gen = 1 ;
-         gen < pattern_settings. generation ; gen++) {
-        long_unsigned_int current_size {polylines. size ()} ;
-        // here we do the most classical loop so we make sure no stange border
-        // effects when we change the number of elements.
-//         std::cout << "initial size is " << polylines. size ()<< std::endl ;
-        for (long unsigned i = 0 ; i < current_size ; i++) {
-            if (polylines[i]. reference == 1) { // obtuse Robinson triangle
-                // std::cout << "obtuse" <<std::endl ;
-                // We have an obtuse Robinson triangle.
-                Vertex P3P1 = polylines[i]. vertices[1-1] -
-                              polylines[i]. vertices[3-1] ;
-                Vertex P2P1 = polylines[i]. vertices[1-1] -
-                              polylines[i]. vertices[2-1] ;
-                //std::cout << "norm (P2P1) =" << P2P1. norm2 () << std::endl ;
-                //std::cout << "norm (P3P1) =" << P3P1. norm2 () << std::endl ;
-                // std::cout << "vertex 3" ;
-                //polylines[i]. vertices[3-1]. display () ;
-                Vertex A = polylines[i]. vertices[3-1] + (P3P1 * Phi2) ;
-                //std::cout << "vertex A = " ;
-                //A. display () ;
-                //std::cout << std::endl ;
-                Vertex B = polylines[i]. vertices[2-1] + (P2P1 * Phi2) ;
-                //std::cout << "vertex B = " ;
-                //B. display () ;
-                //std::cout << std::endl ;
-                //Vertex test = polylines[i]. vertices[2-1]-B ;
-                //std::cout << "norm test = " << test. norm2 () << std::endl ;
-                //std::cout << "Phi 1 2 3 = " << Phi << " " << Phi2 << " " << Phi3 << std::endl ;
+    return start ;
+}
 
-                p. vertices. clear () ;
-                p. push_back (polylines[i]. vertices[3-1]) ;
-                p. push_back (A) ;
-                p. push_back (polylines[i]. vertices[2-1]) ;
-                p. reference = 1 ;
-                polylines. push_back (p) ;
-                p. vertices. clear () ;
-                p. push_back (A) ;
-                p. push_back (B) ;
-                p. push_back (polylines[i]. vertices[1-1]) ;
-                // p. reference = 1 ; // obtuse ; still true, no need to do it.
-                polylines. push_back (p) ;
-                p. vertices. clear () ;
-                p. push_back (A) ;
-                p. push_back (B) ;
-                p. push_back (polylines[i]. vertices[2-1]) ;
-                p. reference = 0 ; // acute
-                polylines. push_back (p) ;
-            } else { // acute Robinson triangle
-                // std::cout << "acute" <<std::endl ;
-                Vertex P2P1 = polylines[i]. vertices[1-1] -
-                              polylines[i]. vertices[2-1] ;
-                Vertex C = polylines[i]. vertices[2-1] + (P2P1 * Phi2) ;
-                p. vertices. clear () ;
-                p. push_back (polylines[i]. vertices[3-1]) ;
-                p. push_back (C) ;
-                p. push_back (polylines[i]. vertices[1-1]) ;
-                p. reference = 1 ;
-                polylines. push_back (p) ;
-                p. vertices. clear () ;
-                p. push_back (polylines[i]. vertices[3-1]) ;
-                p. push_back (C) ;
-                p. push_back (polylines[i]. vertices[2-1]) ;
-                p. reference = 0 ;
-                polylines. push_back (p) ;
-            }
+void dpps::Pattern_Penrose_tiling::generate_P3 () {
+    // Following deflation method from:
+    // http://tartarus.org/simon/20110412-penrose/penrose.xhtml
+    //
+    // We build a pattern based on triangles. It would be possible from later
+    // identify reflected tiles and join them, in a O(n^2) algorithm. but
+    // actually we don't really care. If all we want is to draw inside the small
+    // or the large tiles, we can just use the triangle pattern.
+    if (pattern_settings. generation == 0)
+        return ;
+    // Each triangle is deflated down to the last generation before the next
+    // one, which gives the same order as deflating all the triangles of
+    // each generation in turn, but only keeps one triangle per generation.
+    // Without window, the number of triangles is known: each obtuse one
+    // gives two obtuse and one acute, each acute one gives one of each.
+    if (!pattern_settings. window) {
+        long_unsigned_int obtuse {0} ;
+        long_unsigned_int acute {0} ;
+        // the reference &t is used to avoid copy
+        for (auto &t: start_triangles ())
+            (t. reference == 1 ? obtuse : acute)++ ;
+        for (long_unsigned_int gen = 1 ;
+             gen < pattern_settings. generation ; gen++) {
+            long_unsigned_int next_obtuse {2 * obtuse + acute} ;
+            acute += obtuse ;
+            obtuse = next_obtuse ;
         }
-//         std::cout << "after gen " << gen << "size is " << polylines. size ()<< std::endl ;
-        // NOTE: that gcc allows cbegin() here, but clang does not.
-        polylines. erase (polylines. begin (),
-                          polylines. begin () + current_size) ;
-//         std::cout << "after erase, size is " << polylines. size ()<< std::endl ;
+        polylines. reserve (polylines. size () + obtuse + acute) ;
     }
+    Polyline triangle ;
+    triangle. closed = true ;
+    // the reference &t is used to avoid copy
+    for (auto &t: start_triangles ())
+        deflate (t. vertices[0], t. vertices[1], t. vertices[2],
+                 t. reference == 1, pattern_settings. generation - 1, triangle,
+                 [this] (const Polyline &p) {
+                     polylines. push_back (p) ;
+                 }) ;
+}
+
+void dpps::Pattern_Penrose_tiling::stream_P3 (Writer &writer) const {
+    writer. begin_stream () ;
+    deflate_P3 ([&writer] (const Polyline &p) {
+        writer. write_Polyline_stream (p) ;
+    }) ;
+    writer. end_stream () ;
+}
+
+void dpps::Pattern_Penrose_tiling::deflate_P3 (
+    const std::function<void (const Polyline &)> &function) const {
+    if (pattern_settings. generation == 0)
+        return ;
+    Polyline triangle ;
+    triangle. closed = true ;
+    // the reference &t is used to avoid copy
+    for (auto &t: start_triangles ())
+        deflate (t. vertices[0], t. vertices[1], t. vertices[2],
+                 t. reference == 1, pattern_settings. generation - 1,
+                 triangle, function) ;
+}
+
+void dpps::Pattern_Penrose_tiling::generate_each (
+    const std::function<void (const Polyline &)> &function) {
+    deflate_P3 (function) ;
 }
 
 //void dpps::Pattern_Penrose_tiling::generate_P2 () {
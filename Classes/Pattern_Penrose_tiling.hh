@@ -13,9 +13,13 @@
 #ifndef DPPS_PATTERN_PENROSE_TILING
 #define DPPS_PATTERN_PENROSE_TILING
 
+#include <functional>
+
 #include "Pattern.hh"
 
 namespace dpps {
+class Writer ;
+
     typedef enum {
         start_tile_thin,
         start_tile_large,
@@ -73,11 +77,44 @@ public:
          * two small tiles make a dart. (P2 is unimplemented yet.)
          */
         enum_start_tile start_tile {start_tile_thin} ;
+
+        /** @brief whether only the triangles meeting a window are generated,
+         * see set_window(). */
+        bool window {false} ;
+        double window_xmin {0.0} ;
+        double window_ymin {0.0} ;
+        double window_xmax {0.0} ;
+        double window_ymax {0.0} ;
     } ;
 
 protected:
     Pattern_Penrose_tiling_settings pattern_settings ;
 
+    /** @brief the triangles of the first generation. */
+    std::vector<Polyline> start_triangles () const ;
+
+    /** @brief whether the bounding box of the triangle meets the window, if
+     * any. */
+    bool meets_window (const Vertex &p1, const Vertex &p2,
+                       const Vertex &p3) const ;
+
+    /** @brief deflates the triangle (P1, P2, P3), obtuse or acute, remaining
+     * more times, depth first, and passes to output each triangle of the
+     * last generation which meets the window.
+     *
+     * triangle is used to hold the triangle passed to output, so that its
+     * vertices are only allocated once. */
+    void deflate (const Vertex &P1, const Vertex &P2, const Vertex &P3,
+                  const bool obtuse,
+                  const long_unsigned_int remaining,
+                  Polyline &triangle,
+                  const std::function<void (const Polyline &)> &output) const ;
+
+    /** @brief passes to function the triangles of generate_P3(), deflated
+     * depth first. */
+    void deflate_P3 (
+        const std::function<void (const Polyline &)> &function) const ;
+
 public:
     /** @brief the default constructor */
     Pattern_Penrose_tiling () ;
@@ -102,6 +139,33 @@ public:
     void generate () ;
     //void generate_P2 () ;
     void generate_P3 () ;
+
+    /** @brief writes the triangles of generate_P3() to writer, between
+     * Writer::begin_stream() and Writer::end_stream(), without keeping them.
+     *
+     * The triangles are deflated depth first, so that the memory does not
+     * depend on the generation. */
+    void stream_P3 (Writer &writer) const ;
+
+    /** @brief see Pattern::generate_each(). The triangles are not read from
+     * or added to Pattern_cache. */
+    void generate_each (
+        const std::function<void (const Polyline &)> &function) ;
+
+    /** @brief only generates the triangles whose bounding box meets the
+     * window.
+     *
+     * The triangles which do not meet the window are discarded at the
+     * generation where they leave it, with all the smaller triangles they
+     * would give, so that a small window can be generated at high
+     * generations. Triangles crossing the border of the window are kept,
+     * so that the window is covered; Pattern::select_window() can then
+     * keep those inside. */
+    void set_window (const double xmin, const double ymin,
+                     const double xmax, const double ymax) ;
+
+    /** @brief generates all the triangles again, see set_window(). */
+    void clear_window () ;
     Pattern_Penrose_tiling (
         const long_unsigned_int generation,
         const enum_start_tile start_tile,
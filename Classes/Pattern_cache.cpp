@@ -0,0 +1,164 @@
+/**
+ * @file Pattern_cache.cpp
+ * @author Jérôme Borme <jerome.borme@inl.int>
+ * @version 1.0
+ * @brief Implementation of class Pattern_cache
+ * @date 2026-10-14 Jérôme Borme: Initial version
+ * @copyright
+ * This Source Code Form is subject to the terms of the Mozilla Public
+ * License, v. 2.0. If a copy of the MPL was not distributed with this
+ * file, You can obtain one at http://mozilla.org/MPL/2.0/.
+ */
+
+#include <cstdio> // snprintf, rename, remove
+#include <cstdlib> // getenv
+#include <fstream>
+#include <iterator>
+#include <random>
+#include <stdexcept>
+
+#include "configure.h"
+#include "Pattern_cache.hh"
+#include "Pattern.hh"
+#include "Reader_dpps.hh"
+#include "Writer_dpps.hh"
+
+std::string &dpps::Pattern_cache::directory () {
+    static std::string result {[] {
+        const char *value {getenv ("DPPS_CACHE_DIRECTORY")} ;
+        return std::string (value == nullptr ? "" : value) ;
+    } ()} ;
+    return result ;
+}
+
+void dpps::Pattern_cache::set_directory (const std::string &new_directory) {
+    directory () = new_directory ;
+}
+
+std::string dpps::Pattern_cache::get_directory () {
+    return directory () ;
+}
+
+bool dpps::Pattern_cache::enabled () {
+    return !directory (). empty () ;
+}
+
+uint64_t dpps::Pattern_cache::hash (const std::string &text) {
+    uint64_t result {14695981039346656037ULL} ;
+    for (unsigned char c: text) {
+        result ^= c ;
+        result *= 1099511628211ULL ;
+    }
+    return result ;
+}
+
+std::string dpps::Pattern_cache::key (
+    const std::string &class_name,
+    const std::vector<bool> &vbool,
+    const std::vector<long_unsigned_int> &vint,
+    const std::vector<double> &vdouble,
+    const std::vector<std::string> &vstring,
+    const long_unsigned_int seed,
+    const std::string &random_state) {
+    // One field per line. The strings are preceded by their length, so that
+    // they may contain anything.
+    std::string result {"dpps " + std::to_string (dpps_VERSION_MAJOR) + "." +
+                        std::to_string (dpps_VERSION_MINOR) + "." +
+                        std::to_string (dpps_VERSION_PATCH) + " format " +
+                        std::to_string (Writer_dpps::version) + "\n" +
+                        class_name + "\nbool" } ;
+    for (bool b: vbool)
+        result += b ? " 1" : " 0" ;
+    result += "\nint" ;
+    for (auto i: vint)
+        result += " " + std::to_string (i) ;
+    result += "\ndouble" ;
+    for (auto d: vdouble) {
+        // %a writes the exact value.
+        char buffer[32] ;
+        snprintf (buffer, sizeof (buffer), " %a", d) ;
+        result += buffer ;
+    }
+    result += "\nstring" ;
+    // the reference &s is used to avoid copy
+    for (auto &s: vstring)
+        result += " " + std::to_string (s. size ()) + ":" + s ;
+    result += "\nseed " + std::to_string (seed) + "\nrandom " + random_state ;
+    return result ;
+}
+
+std::string dpps::Pattern_cache::file_stem (const std::string &key) {
+    char buffer[17] ;
+    snprintf (buffer, sizeof (buffer), "%016llx",
+              static_cast<unsigned long long> (hash (key))) ;
+    return directory () + "/" + buffer ;
+}
+
+bool dpps::Pattern_cache::load (const std::string &key, Pattern &pattern,
+                                std::string &random_state) {
+    if (!enabled ())
+        return false ;
+    std::string stem {file_stem (key)} ;
+    std::ifstream key_file (stem + ".key", std::ios_base::in|std::ios_base::binary) ;
+    if (!key_file. is_open ())
+        return false ;
+    std::string contents ((std::istreambuf_iterator<char> (key_file)),
+                          std::istreambuf_iterator<char> ()) ;
+    // The key, an empty line, then the state after the generation.
+    std::string separator {"\n\n"} ;
+    if ((contents. size () < key. size () + separator. size ()) ||
+        (contents. compare (0, key. size (), key) != 0) ||
+        (contents. compare (key. size (), separator. size (), separator) != 0))
+        return false ;
+    Pattern result ;
+    try {
+        Reader_dpps reader (stem + ".dpps") ;
+        result. polylines. reserve (reader. size ()) ;
+        reader. append_to_pattern (result) ;
+    } catch (std::exception &) {
+        return false ;
+    }
+    random_state = contents. substr (key. size () + separator. size ()) ;
+    pattern. polylines. insert (pattern. polylines. end (),
+                                result. polylines. begin (),
+                                result. polylines. end ()) ;
+    return true ;
+}
+
+bool dpps::Pattern_cache::store (const std::string &key,
+                                 const Pattern &pattern,
+                                 const long_unsigned_int first,
+                                 const std::string &random_state) {
+    if (!enabled ())
+        return false ;
+    std::string stem {file_stem (key)} ;
+    // Written under another name, then renamed, so that another run never
+    // reads a file being written.
+    std::string temporary {stem + ".tmp" +
+                           std::to_string (std::random_device () ())} ;
+    try {
+        {
+            Writer_dpps writer (temporary) ;
+            for (long_unsigned_int i {first} ; i < pattern. polylines. size () ;
+                 i++)
+                writer. write_Polyline (pattern. polylines[i]) ;
+            writer. close () ;
+        }
+        if (std::rename (temporary. c_str (), (stem + ".dpps"). c_str ()) != 0)
+            throw std::runtime_error ("rename") ;
+        {
+            std::ofstream key_file (temporary,
+                std::ios_base::out|std::ios_base::trunc|std::ios_base::binary) ;
+            key_file << key << "\n\n" << random_state ;
+            key_file. close () ;
+            if (!key_file)
+                throw std::runtime_error ("write") ;
+        }
+        if (std::rename (temporary. c_str (), (stem + ".key"). c_str ()) != 0)
+            throw std::runtime_error ("rename") ;
+    } catch (std::exception &) {
+        std::remove (temporary. c_str ()) ;
+        return false ;
+    }
+    return true ;
+}
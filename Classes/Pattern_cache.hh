@@ -0,0 +1,91 @@
+/**
+ * @file Pattern_cache.hh
+ * @author Jérôme Borme <jerome.borme@inl.int>
+ * @version 1.0
+ * @brief Header file for class Pattern_cache, which keeps the generated
+ * patterns on disk
+ * @date 2026-10-14 Jérôme Borme: Initial version
+ * @copyright
+ * This Source Code Form is subject to the terms of the Mozilla Public
+ * License, v. 2.0. If a copy of the MPL was not distributed with this
+ * file, You can obtain one at http://mozilla.org/MPL/2.0/.
+ */
+#ifndef DPPS_PATTERN_CACHE
+#define DPPS_PATTERN_CACHE
+
+#include <cstdint>
+#include <string>
+#include <vector>
+
+#include "common.hh"
+
+namespace dpps {
+class Pattern ;
+
+/** @brief A cache on disk of the polylines made by the generators, so that
+ * a script which is run again does not generate them again.
+ *
+ * The generators whose result only depends on their parametres and on the
+ * state of the random generator (Pattern_Fibonacci, Pattern_Penrose_tiling,
+ * Pattern_hard_sphere_random_packing and Pattern_text) describe a
+ * generation by a key, made of the name of the class, the parametres as
+ * passed to set_parametres(), the version of dpps and, for the generators
+ * which draw random numbers, the seed and the state of the random
+ * generator. The polylines are stored in the binary dpps format (see
+ * Writer_dpps) in a file named after a hash of the key, and are read back
+ * by the next generation with the same key.
+ *
+ * Next to it, a text file holds the whole key, so that two keys with the
+ * same hash are not mixed up, and the state of the random generator after
+ * the generation, so that what follows draws the same numbers as without
+ * the cache.
+ *
+ * The cache is disabled by default. It is enabled by set_directory(), or
+ * by the environment variable DPPS_CACHE_DIRECTORY, with a directory which
+ * must exist. The files are never removed: the directory can be emptied at
+ * any time. A file which cannot be read or written is ignored, so that the
+ * cache never stops a generation.
+ */
+class Pattern_cache {
+protected:
+    static std::string &directory () ;
+
+    /** @brief the path of the files for key, without extension. */
+    static std::string file_stem (const std::string &key) ;
+
+public:
+    /** @brief sets the directory of the cache, or disables the cache if it
+     * is empty. */
+    static void set_directory (const std::string &new_directory) ;
+
+    static std::string get_directory () ;
+
+    static bool enabled () ;
+
+    /** @brief returns the key of a generation, see the description of the
+     * class. The doubles are written exactly. */
+    static std::string key (const std::string &class_name,
+                            const std::vector<bool> &vbool,
+                            const std::vector<long_unsigned_int> &vint,
+                            const std::vector<double> &vdouble,
+                            const std::vector<std::string> &vstring,
+                            const long_unsigned_int seed,
+                            const std::string &random_state) ;
+
+    /** @brief returns the FNV-1a hash of text. */
+    static uint64_t hash (const std::string &text) ;
+
+    /** @brief appends to pattern the polylines stored for key, and sets
+     * random_state to the state stored with them. Returns false, without
+     * changing pattern, if there are none. */
+    static bool load (const std::string &key, Pattern &pattern,
+                      std::string &random_state) ;
+
+    /** @brief stores the polylines of pattern from first to the end, and
+     * random_state, for key. Returns false if they could not be written. */
+    static bool store (const std::string &key, const Pattern &pattern,
+                       const long_unsigned_int first,
+                       const std::string &random_state) ;
+} ;
+} // namespace dpps
+#endif
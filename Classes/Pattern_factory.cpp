@@ -12,7 +12,12 @@
 #include <limits>
 #include <cmath>
 #include <iostream>
+#include <algorithm>
+#include <map>
 #include "Pattern_factory.hh"
+#include "Polygon_boolean.hh"
+#include "Vertex_grid.hh"
+#include "bad_parametre.hh"
 
 dpps::Pattern dpps::Pattern_factory::explode (
     const Polyline &polyline) {
@@ -38,108 +43,274 @@ dpps::Pattern dpps::Pattern_factory::explode (
     return result ;
 }
 
+// A part of a hatch line, in the referential rotated by -angle, and the
+// number of its line from the top.
+struct Hatch_segment {
+    double x_start ;
+    double x_end ;
+    double y ;
+    long_unsigned_int line ;
+} ;
+
+// An edge of a polyline rotated by -angle, from w1 to w2.
+struct Hatch_edge {
+    dpps::Vertex w1 ;
+    dpps::Vertex w2 ;
+    double top ;
+    double bottom ;
+} ;
+
+// Returns the parts of the horizontal lines, spaced by spacing, which are
+// inside the closed polylines rotated by -angle around centre.
+//
+// The edges are sorted by their top and enter the list of active edges as
+// the lines go down, and leave it once the lines are below them, so that
+// each line only computes its crossings with the edges it meets.
+static std::vector<Hatch_segment> hatch_polylines (
+    const std::vector<const dpps::Polyline *> &polylines,
+    const dpps::Vertex &centre,
+    const double angle,
+    const double spacing,
+    const dpps::enum_fill_rule fill_rule) {
+    using namespace dpps ;
+    if (spacing <= 0)
+        throw bad_parametre ("Pattern_factory: the spacing of the lines \
+must be positive.") ;
+    std::vector<Hatch_edge> edges ;
+    double miny {std::numeric_limits<double>::max ()},
+           maxy {std::numeric_limits<double>::lowest ()} ;
+    for (auto p: polylines) {
+        Polyline rotated (*p) ;
+        rotated. rotate (centre, -angle) ;
+        miny = std::min (miny, rotated. lower_left (). y) ;
+        maxy = std::max (maxy, rotated. upper_right (). y) ;
+        long_unsigned_int n {rotated. vertices. size ()} ;
+        for (long_unsigned_int i = 0 ; i < n ; i++) {
+            const Vertex &w1 {rotated. vertices[i]} ;
+            const Vertex &w2 {rotated. vertices[(i+1) % n]} ;
+            edges. push_back ({w1, w2, std::max (w1. y, w2. y),
+                                       std::min (w1. y, w2. y)}) ;
+        }
+    }
+    std::vector<Hatch_segment> result ;
+    std::vector<long_unsigned_int> order (edges. size ()) ;
+    for (long_unsigned_int i = 0 ; i < order. size () ; i++)
+        order[i] = i ;
+    std::sort (order. begin (), order. end (),
+        [&] (const long_unsigned_int i, const long_unsigned_int j) {
+            return edges[i]. top > edges[j]. top ;
+        }) ;
+    std::vector<long_unsigned_int> active ;
+    std::vector<std::pair<double, int>> crossings ;
+    long_unsigned_int next {0} ;
+    long_unsigned_int line {0} ;
+    // We place the first line located at one spacing below the maximum.
+    // If we do not pass this condition right from the start, it means the
+    // structure is smaller than the vertical spacing. It will not be exposed.
+    for (double current_y {maxy - spacing} ; current_y >= miny ;
+         current_y -= spacing, line++) {
+        while ((next < order. size ()) &&
+               (edges[order[next]]. top >= current_y)) {
+            active. push_back (order[next]) ;
+            next++ ;
+        }
+        // if both w1 and w2 are too high, no intersection for this edge,
+        // nor for the next lines.
+        active. erase (std::remove_if (active. begin (), active. end (),
+            [&] (const long_unsigned_int i) {
+                return edges[i]. bottom > current_y ;
+            }), active. end ()) ;
+        if (fill_rule == fill_rule_extent) {
+            double minx {std::numeric_limits<double>::max ()},
+                   maxx {std::numeric_limits<double>::lowest ()} ;
+            for (auto i: active) {
+                const Vertex &w1 {edges[i]. w1} ;
+                const Vertex &w2 {edges[i]. w2} ;
+                double current_x ;
+                // In the equality case, we take both ends (w2 being the
+                // first end of the next edge).
+                if ((fabs (w1. y - current_y) <
+                               std::numeric_limits<double>::epsilon()) &&
+                    (fabs (w2. y - current_y) <
+                               std::numeric_limits<double>::epsilon()))
+                    current_x = w1. x ;
+                else
+                    // At this point there must be a unique intersection
+                    // between the current_y y-level and the (w1, w2) line
+                    // segment.
+                    current_x = w1. x +
+                       (w2. x - w1. x) / (w2. y - w1. y) * (current_y - w1. y) ;
+                minx = std::min (minx, current_x) ;
+                maxx = std::max (maxx, current_x) ;
+            }
+            if (!active. empty ())
+                result. push_back ({minx, maxx, current_y, line}) ;
+            continue ;
+        }
+        // An edge crosses the line if its ends are on both sides, the
+        // bottom end being included, so that a vertex on the line is
+        // counted once and horizontal edges are not counted.
+        crossings. clear () ;
+        for (auto i: active) {
+            const Vertex &w1 {edges[i]. w1} ;
+            const Vertex &w2 {edges[i]. w2} ;
+            if ((w1. y > current_y) != (w2. y > current_y))
+                crossings. push_back (std::make_pair (w1. x +
+                    (w2. x - w1. x) / (w2. y - w1. y) * (current_y - w1. y),
+                    w2. y > w1. y ? 1 : -1)) ;
+        }
+        std::sort (crossings. begin (), crossings. end ()) ;
+        int winding {0} ;
+        double start {0.0} ;
+        for (long_unsigned_int k = 0 ; k < crossings. size () ; k++) {
+            bool inside_before, inside_after ;
+            if (fill_rule == fill_rule_even_odd) {
+                inside_before = (k % 2) == 1 ;
+                inside_after = !inside_before ;
+            } else {
+                inside_before = winding != 0 ;
+                winding += crossings[k]. second ;
+                inside_after = winding != 0 ;
+            }
+            if (!inside_before && inside_after)
+                start = crossings[k]. first ;
+            if (inside_before && !inside_after &&
+                (crossings[k]. first > start))
+                result. push_back ({start, crossings[k]. first, current_y,
+                                    line}) ;
+        }
+    }
+    return result ;
+}
+
+// Returns the segments as polylines with the properties of model, rotated
+// back by angle around centre.
+static dpps::Pattern lines_from_segments (
+    const std::vector<Hatch_segment> &segments,
+    const dpps::Polyline &model,
+    const dpps::Vertex &centre,
+    const double angle) {
+    using namespace dpps ;
+    Pattern result ;
+    result. polylines. reserve (segments. size ()) ;
+    // The copy makes sure we get all properties of the initial polyline (dose,
+    // reference, selection), even if more properties are later added.
+    Polyline current {model} ;
+    // the reference &s is used to avoid copy
+    for (auto &s: segments) {
+        current. vertices. clear () ;
+        current. push_back (Vertex (s. x_start, s. y)) ;
+        current. push_back (Vertex (s. x_end, s. y)) ;
+        // We calculated everything in the referential rotated by -angle, so
+        // we rotate back.
+        current. rotate (centre, angle) ;
+        result. push_back (current) ;
+    }
+    return result ;
+}
+
+// Returns the closed polylines of pattern in selection, and sets centre to
+// the centre of their bounding box.
+static std::vector<const dpps::Polyline *> region_polylines (
+    const dpps::Pattern &pattern,
+    const selection_t selection,
+    dpps::Vertex &centre) {
+    using namespace dpps ;
+    std::vector<const Polyline *> result ;
+    double minx {std::numeric_limits<double>::max ()},
+           miny {std::numeric_limits<double>::max ()},
+           maxx {std::numeric_limits<double>::lowest ()},
+           maxy {std::numeric_limits<double>::lowest ()} ;
+    // the reference &p is used to avoid copy
+    for (auto &p: pattern. polylines)
+        if (((selection < 0) || p. selected[selection]) && p. closed &&
+            (p. size () > 0)) {
+            result. push_back (&p) ;
+            Vertex ll {p. lower_left ()}, ur {p. upper_right ()} ;
+            minx = std::min (minx, ll. x) ;
+            miny = std::min (miny, ll. y) ;
+            maxx = std::max (maxx, ur. x) ;
+            maxy = std::max (maxy, ur. y) ;
+        }
+    centre = Vertex ((minx + maxx) / 2.0, (miny + maxy) / 2.0) ;
+    return result ;
+}
+
 dpps::Pattern dpps::Pattern_factory::fill_with_lines (
                                             const Polyline &polyline,
                                             const double angle,
-                                            const double spacing) {
-    //if (!polyline. is_convex ())
-
+                                            const double spacing,
+                                            const enum_fill_rule fill_rule) {
     Pattern result ;
-    Polyline copied_polyline (polyline) ;
     if (! polyline. closed) {
-        result. push_back (copied_polyline) ;
+        result. push_back (polyline) ;
         return result ;
     }
     // the starting point must be the most to the top
     // in the referential of the polyline.
     Vertex polyline_centre {polyline. geometrical_centre ()} ;
+    std::vector<Hatch_segment> segments {hatch_polylines (
+        {&polyline}, polyline_centre, angle, spacing, fill_rule)} ;
+    return lines_from_segments (segments, polyline, polyline_centre, angle) ;
+}
 
-    copied_polyline. rotate_centred (-angle) ;
-    Vertex ll {copied_polyline. lower_left ()},
-           ur {copied_polyline. upper_right ()} ;
-    double minx {ll. x},
-           miny {ll. y},
-           maxx {ur. x},
-           maxy {ur. y};
-    double current_x ;
-    // We place the first polyline located at one spacing below the maximum.
-    double current_y {maxy - spacing} ;
-    // If we do not pass this condition right from the start, it means the
-    // structure is smaller than the vertical spacing. It will not be exposed.
-    Vertex v, w1, w2 ;
-    // The copy makes sure we get all properties of the initial polyline (dose,
-    // reference, selection), even if more properties are later added.
-    Polyline current {copied_polyline} ;
-    current. vertices. clear () ;
-    while (current_y >= miny) {
-        minx = std::numeric_limits<double>::max () ;
-        maxx = std::numeric_limits<double>::lowest () ;
-        for (long_unsigned_int i = 0 ;
-             i < copied_polyline. vertices. size () ;
-             i++) {
-            // We want to know where the vector (w1 -> w2) crosses current_y
-            w1 = copied_polyline. vertices. at (i) ;
-            w2 = copied_polyline. vertices. at ((i+1) %
-                                         (copied_polyline. vertices. size ())) ;
-            // if both w1 and w2 are either too high or too low, no intersection
-            // for this pair of vertices.
-            if ((w1. y > current_y) && (w2. y > current_y)) {
-                continue ;
-            }
-            if ((w1. y < current_y) && (w2. y < current_y)) {
-                continue ;
-            }
-            // In the equality case, we take both ends
-            if ((fabs (w1. y - current_y) <
-                           std::numeric_limits<double>::epsilon()) &&
-                (fabs (w2. y - current_y) <
-                           std::numeric_limits<double>::epsilon())) {
-                if (w1. x < minx)
-                    minx = w1. x ;
-                if (w1. x > maxx)
-                    maxx = w1. x ;
-                if (w1. y < miny)
-                    miny = w1. y ;
-                if (w1. y > maxy)
-                    maxy = w1. y ;
-                continue ;
-            }
-            // At this point there must be a unique intersection between the
-            // current_y y-level and the (w1, w2) line segment.
-            // The division should always be safe, as equality case in the
-            // denominator should have been caught in either of the three if
-            // above.
-            current_x = w1. x +
-                       (w2. x - w1. x) / (w2. y - w1. y) * (current_y - w1. y) ;
-            if (current_x < minx)
-                minx = current_x ;
-            if (current_x > maxx)
-                maxx = current_x ;
-        }
-        // NOTE: that gcc allows cbegin() and cend() here, but clang does not.
-        current. vertices. erase (current. vertices. begin (),
-                                  current. vertices. end ()) ;
-        //current. dose = polyline. dose ;
-        v. y = current_y ;
-        v. x = minx ;
-        current. push_back (v) ;
-        v. x = maxx ;
-        current. push_back (v) ;
-        // We calculated everything in the referential rotated by -angle, so
-        // we rotate back.
+dpps::Pattern dpps::Pattern_factory::fill_region_with_lines (
+                                            const Pattern &pattern,
+                                            const double angle,
+                                            const double spacing,
+                                            const enum_fill_rule fill_rule,
+                                            const selection_t selection) {
+check_selection_not_too_high(selection) ;
+    Vertex centre ;
+    std::vector<const Polyline *> region {region_polylines (
+        pattern, selection, centre)} ;
+    if (region. empty ())
+        return Pattern () ;
+    std::vector<Hatch_segment> segments {hatch_polylines (
+        region, centre, angle, spacing, fill_rule)} ;
+    return lines_from_segments (segments, *region[0], centre, angle) ;
+}
 
-        current. rotate (polyline_centre, angle) ;
-        result. push_back (current) ;
-        current_y -= spacing ;
+dpps::Pattern dpps::Pattern_factory::boolean_operation (
+                                const Pattern &pattern,
+                                const enum_boolean_operation operation,
+                                const selection_t selection_a,
+                                const selection_t selection_b) {
+check_selection_not_too_high(selection_a) ;
+check_selection_not_too_high(selection_b) ;
+    std::vector<const Polyline *> a, b ;
+    // the reference &p is used to avoid copy
+    for (auto &p: pattern. polylines) {
+        if (!p. closed || (p. size () < 3))
+            continue ;
+        if ((selection_a < 0) || p. selected[selection_a])
+            a. push_back (&p) ;
+        if ((selection_b < 0) || p. selected[selection_b])
+            b. push_back (&p) ;
+    }
+    if ((operation == boolean_operation_union) && (selection_a == selection_b))
+        b. clear () ;
+    Pattern result ;
+    const Polyline *model {a. empty () ? (b. empty () ? nullptr : b[0]) : a[0]} ;
+    if (model == nullptr)
+        return result ;
+    Polygon_boolean computed {a, b, operation} ;
+    // the reference &contour is used to avoid copy
+    for (auto &contour: computed. contours ()) {
+        Polyline p {*model} ;
+        p. vertices = contour ;
+        p. closed = true ;
+        result. push_back (p) ;
     }
     return result ;
 }
 
 dpps::Pattern dpps::Pattern_factory::
             fill_with_lines_first_angle (const Polyline &polyline,
-                                         const double spacing) {
+                                         const double spacing,
+                                         const enum_fill_rule fill_rule) {
     return fill_with_lines (polyline, polyline. orientation_at_vertex (0),
-                            spacing) ;
+                            spacing, fill_rule) ;
 }
 
 dpps::Pattern dpps::Pattern_factory::fill_with_dashes_first_angle (
@@ -149,11 +320,12 @@ dpps::Pattern dpps::Pattern_factory::fill_with_dashes_first_angle (
                     const double duty_cycle,
                     const double phase_initial,
                     const double phase_increment,
-                    const enum_partial_dash_policy partial_dash_policy) {
+                    const enum_partial_dash_policy partial_dash_policy,
+                    const enum_fill_rule fill_rule) {
     return fill_with_dashes (polyline, polyline. orientation_at_vertex (0),
                             period_longitudinal, spacing_transversal,
                             duty_cycle, phase_initial, phase_increment,
-                            partial_dash_policy) ;
+                            partial_dash_policy, fill_rule) ;
 }
 
 static dpps::Pattern decompose_line_in_dashes (
@@ -287,6 +459,51 @@ static dpps::Pattern decompose_line_in_dashes (
     return result ;
 }
 
+// Decomposes the lines, line k being the line number numbers[k] of the hatch,
+// and sets the properties of model to the dashes.
+static dpps::Pattern dashes_from_lines (
+                    const dpps::Pattern &lines,
+                    const std::vector<long_unsigned_int> &numbers,
+                    const dpps::Polyline &model,
+                    const double angle,
+                    const double period_longitudinal,
+                    const double spacing_transversal,
+                    const double duty_cycle,
+                    const double phase_initial,
+                    const double phase_increment,
+                    const dpps::enum_partial_dash_policy partial_dash_policy) {
+    using namespace dpps ;
+    constexpr const double pi_over_two {M_PI / 2.0} ;
+    Pattern result ;
+    if (lines. polylines. empty ())
+        return result ;
+    // v0: all dash will be referred to the first vertex of the first line
+    Vertex v0 {lines. polylines[0]. vertices[0]} ;
+    // v1: the direction in which the lines are spaced.
+    Vertex v1 {cos (angle - pi_over_two)*spacing_transversal,
+                     sin (angle - pi_over_two)*spacing_transversal} ;
+    double phase {phase_initial} ;
+    long_unsigned_int line {numbers[0]} ;
+    for (long_unsigned_int k = 0 ; k < lines. polylines. size () ; k++) {
+        const Polyline &l {lines. polylines[k]} ;
+        // The phase changes from a line to the next, not between the parts
+        // of a line.
+        for ( ; line < numbers[k] ; line++)
+            phase = fmod (phase + phase_increment, 1.0) ;
+        Vertex v {v0 - (v1 * (1.0*(numbers[k] - numbers[0])))} ;
+        Pattern m {
+            decompose_line_in_dashes (l. vertices[0], l. vertices[1],
+                period_longitudinal, v, duty_cycle, phase,
+                partial_dash_policy)} ;
+        result. polylines. insert (result. polylines. end (),
+                                   m. polylines. begin (),
+                                   m. polylines. end ()) ;
+    }
+    for (auto &i: result. polylines)
+        i. set_metadata_from (model) ;
+    return result ;
+}
+
 dpps::Pattern dpps::Pattern_factory::fill_with_dashes (
                     const Polyline &polyline,
                     const double angle,
@@ -295,8 +512,8 @@ dpps::Pattern dpps::Pattern_factory::fill_with_dashes (
                     const double duty_cycle,
                     const double phase_initial,
                     const double phase_increment,
-                    const enum_partial_dash_policy partial_dash_policy) {
-    constexpr const double pi_over_two {M_PI / 2.0} ;
+                    const enum_partial_dash_policy partial_dash_policy,
+                    const enum_fill_rule fill_rule) {
     double phase {phase_initial} ;
 
     Pattern result ;
@@ -319,35 +536,56 @@ dpps::Pattern dpps::Pattern_factory::fill_with_dashes (
 //             i. set_metadata_from (polyline) ;
         return result ;
     }
-//     Vertex ll {polyline. lower_left ()},
-//            ur {polyline. upper_right ()} ;
-//     double minx {ll. x},
-//            miny {ll. y},
-//            maxx {ur. x},
-//            maxy {ur. y};
-    Pattern lines {fill_with_lines (
-        polyline, angle, spacing_transversal)} ;
-    // v0: all dash will be referred to the first vertex of the first line
-    Vertex v0 {lines. polylines[0]. vertices[0]} ;
-    // v1: the direction in which the lines are spaced.
-    Vertex v1 {cos (angle - pi_over_two)*spacing_transversal,
-                     sin (angle - pi_over_two)*spacing_transversal} ;
-    long_unsigned_int i {0} ;
-    for (auto &l : lines. polylines) {
-        Vertex v {v0 - (v1 * (1.0*i))} ;
-        Pattern m {
-            decompose_line_in_dashes (l. vertices[0], l. vertices[1],
-                period_longitudinal, v, duty_cycle, phase,
-                partial_dash_policy)} ;
-        result. polylines. insert (result. polylines. end (),
-                                   m. polylines. begin (),
-                                   m. polylines. end ()) ;
-        phase = fmod (phase + phase_increment, 1.0) ;
-        i++ ;
+    Pattern lines ;
+    std::vector<long_unsigned_int> numbers ;
+    if (polyline. closed) {
+        Vertex polyline_centre {polyline. geometrical_centre ()} ;
+        std::vector<Hatch_segment> segments {hatch_polylines (
+            {&polyline}, polyline_centre, angle, spacing_transversal,
+            fill_rule)} ;
+        lines = lines_from_segments (segments, polyline, polyline_centre,
+                                     angle) ;
+        // the reference &s is used to avoid copy
+        for (auto &s: segments)
+            numbers. push_back (s. line) ;
+    } else {
+        // As fill_with_lines (), only the first segment is used.
+        lines. push_back (polyline) ;
+        numbers. push_back (0) ;
     }
-    for (auto &i: result. polylines)
-        i. set_metadata_from (polyline) ;
-    return result ;
+    return dashes_from_lines (lines, numbers, polyline, angle,
+        period_longitudinal, spacing_transversal, duty_cycle, phase_initial,
+        phase_increment, partial_dash_policy) ;
+}
+
+dpps::Pattern dpps::Pattern_factory::fill_region_with_dashes (
+                    const Pattern &pattern,
+                    const double angle,
+                    const double period_longitudinal,
+                    const double spacing_transversal,
+                    const double duty_cycle,
+                    const double phase_initial,
+                    const double phase_increment,
+                    const enum_partial_dash_policy partial_dash_policy,
+                    const enum_fill_rule fill_rule,
+                    const selection_t selection) {
+check_selection_not_too_high(selection) ;
+    Vertex centre ;
+    std::vector<const Polyline *> region {region_polylines (
+        pattern, selection, centre)} ;
+    if (region. empty ())
+        return Pattern () ;
+    std::vector<Hatch_segment> segments {hatch_polylines (
+        region, centre, angle, spacing_transversal, fill_rule)} ;
+    Pattern lines {lines_from_segments (segments, *region[0], centre,
+                                        angle)} ;
+    std::vector<long_unsigned_int> numbers ;
+    // the reference &s is used to avoid copy
+    for (auto &s: segments)
+        numbers. push_back (s. line) ;
+    return dashes_from_lines (lines, numbers, *region[0], angle,
+        period_longitudinal, spacing_transversal, duty_cycle, phase_initial,
+        phase_increment, partial_dash_policy) ;
 }
 
 dpps::Pattern dpps::Pattern_factory::from_initialization_list (
@@ -400,9 +638,11 @@ check_selection_not_negative_not_too_high(selection_only_new) ;
         // empty set
         return result ;
     }
-    // writeable copies only for the useful selected parts
-    Pattern pat_old (Pattern_from_selected (pattern_old, selection_old)) ;
-    if (pat_old. polylines. size () == 0) {
+    // The selected polylines are referred to by their indices, and only
+    // the differing ones are copied to the result.
+    std::vector<long_unsigned_int> old_indices {
+        pattern_old. selected_indices (selection_old)} ;
+    if (old_indices. size () == 0) {
         // edge case with an empty selection in old pattern
         // all (selected) polylines in the new pattern are differing,
         // therefore all become part of selection_only_new
@@ -414,31 +654,92 @@ check_selection_not_negative_not_too_high(selection_only_new) ;
                 result. select (logical_action_none, i) ;
         return result ;
     }
-    Pattern pat_new (Pattern_from_selected (pattern_new, selection_new)) ;
-    pat_old. select_all (false) ;
-    pat_new. select_all (false) ;
-    for (auto &pnew : pat_new. polylines) {
+    std::vector<long_unsigned_int> new_indices {
+        pattern_new. selected_indices (selection_new)} ;
+    // whether each polyline is identical to another, which excludes it
+    std::vector<bool> old_identical (old_indices. size (), false) ;
+    std::vector<bool> new_identical (new_indices. size (), false) ;
+    // Identical polylines have the same number of vertices, and the lower
+    // left corners of their bounding boxes are closer than precision. The
+    // old polylines are therefore put in a Vertex_grid of these corners for
+    // each number of vertices, and each pnew is only compared to the
+    // polylines around its own corner instead of all of them.
+    auto corner = [] (const Polyline &p) {
+        return p. vertices. empty () ? Vertex (0, 0) :
+                   Vertex (p. minimum_x (), p. minimum_y ()) ;
+    } ;
+    std::vector<Vertex> old_corners ;
+    old_corners. reserve (old_indices. size ()) ;
+    for (auto i: old_indices)
+        old_corners. push_back (corner (pattern_old. polylines[i])) ;
+    std::vector<Vertex> new_corners ;
+    new_corners. reserve (new_indices. size ()) ;
+    for (auto i: new_indices)
+        new_corners. push_back (corner (pattern_new. polylines[i])) ;
+    double maximum_coordinate {std::max (
+        Vertex_grid::maximum_coordinate (old_corners),
+        Vertex_grid::maximum_coordinate (new_corners))} ;
+    // Vertex::equals_to() uses epsilon for a null precision, the cells are
+    // made twice larger so that rounding cannot exclude a candidate.
+    double range {2 * std::max (precision,
+                                std::numeric_limits<double>::epsilon ())} ;
+    std::map<long_unsigned_int, Vertex_grid> grids ;
+    for (long_unsigned_int i {0} ; i < old_indices. size () ; i++) {
+        long_unsigned_int size {
+            pattern_old. polylines[old_indices[i]]. vertices. size ()} ;
+        auto grid = grids. find (size) ;
+        if (grid == grids. end ())
+            grid = grids. insert (std::make_pair (size,
+                Vertex_grid (range, maximum_coordinate))). first ;
+        grid-> second. insert (old_corners[i], i) ;
+    }
+    long_unsigned_int none {std::numeric_limits<long_unsigned_int>::max ()} ;
+    std::vector<long_unsigned_int> candidates ;
+    for (long_unsigned_int n {0} ; n < new_indices. size () ; n++) {
+        // the reference &pnew is used to avoid copy
+        const Polyline &pnew = pattern_new. polylines[new_indices[n]] ;
         // std::cerr << "New: " << pnew.display_string() <<std::endl;
-        for (auto &pold : pat_old. polylines) {
-            if (!pold. selected[1]) { // selected means excluded due to be identical to another
-                // std::cerr << "to : " << pold.display_string() <<std::endl;
-                if (!( ((ignore_references == false) && (pnew. reference != pold. reference)) ||
-                        ((ignore_dose == false) && (fabs (pnew. dose - pold. dose) < precision))  ||
-                        (!pnew. equals_to (pold, precision))
-                    )) { // they are identical, we mark them. This pold will be skipped from now
-                        // std::cerr << "identical " << std::endl ;
-                        pold. selected[1] = 1 ;
-                        pnew. selected[2] = 1 ;
-                        // we found an identical to pnew, no need to scan more pat_old
-                        break ;
-                }
-            }
+        auto grid = grids. find (pnew. vertices. size ()) ;
+        if (grid == grids. end ())
+            continue ;
+        grid-> second. neighbours (new_corners[n], candidates) ;
+        // As with a scan of all the old polylines, the first identical pold
+        // is used.
+        long_unsigned_int found {none} ;
+        for (auto k: candidates) {
+            if ((k > found) || old_identical[k])
+                continue ;
+            // the reference &pold is used to avoid copy
+            const Polyline &pold = pattern_old. polylines[old_indices[k]] ;
+            // std::cerr << "to : " << pold.display_string() <<std::endl;
+            if (!( ((ignore_references == false) && (pnew. reference != pold. reference)) ||
+                    ((ignore_dose == false) && (fabs (pnew. dose - pold. dose) > precision))  ||
+                    (!pnew. equals_to (pold, precision))
+                )) // they are identical
+                    found = k ;
+        }
+        if (found != none) {
+            // we mark them. This pold will be skipped from now
+            // std::cerr << "identical " << std::endl ;
+            old_identical[found] = true ;
+            new_identical[n] = true ;
         }
     }
-    // We want the differing, not the identical, so we toggle the selection.
-    pat_old. toggle (1) ;
-    pat_new. toggle (2) ;
-    result = Pattern_from_selected (pat_old, 1) ;
-    result. append_from (Pattern_from_selected (pat_new, 2)) ;
+    // The differing polylines are only in selection 1 if they are in the
+    // old pattern, 2 if they are in the new one.
+    for (long_unsigned_int i {0} ; i < old_indices. size () ; i++)
+        if (!old_identical[i]) {
+            Polyline p (pattern_old. polylines[old_indices[i]]) ;
+            p. selected. reset () ;
+            p. selected[1] = 1 ;
+            result. polylines. push_back (std::move (p)) ;
+        }
+    for (long_unsigned_int i {0} ; i < new_indices. size () ; i++)
+        if (!new_identical[i]) {
+            Polyline p (pattern_new. polylines[new_indices[i]]) ;
+            p. selected. reset () ;
+            p. selected[2] = 1 ;
+            result. polylines. push_back (std::move (p)) ;
+        }
     return result ;
 }
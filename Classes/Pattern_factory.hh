@@ -49,20 +49,36 @@ public:
     /** @brief Function which converts a closed Polyline into a vector of
      * two-vertices Polyline that can be drawn along a line.
      *
-     * The algorithm will only produce meaningful results if the Polyline
-     * describes a convex shape. Concave shapes should be first fractured
-     * in convex elements. Given the complexity of the general fracturing
-     * problem and the large number of different algorithm which are
-     * optimized for different kinds of lithography, fracturing was not
-     * implemented in this package. It is let to the user to make a design
-     * already fractured the way which optimizes better for the application.
+     * With fill_rule_extent, the default, the algorithm will only produce
+     * meaningful results if the Polyline describes a convex shape, as each
+     * line goes from its first to its last crossing with the polyline.
+     * Concave shapes are filled with fill_rule_even_odd or fill_rule_nonzero,
+     * which may give several polylines per line.
+     *
+     * The edges are sorted once and each line only meets the edges which
+     * cross it, so the time grows as (edges + lines) log (edges) rather than
+     * as their product.
      *
      * If the line is open then it is not altered
      */
     static dpps::Pattern fill_with_lines (
                             const Polyline &polyline,
                             const double angle,
-                            const double spacing) ;
+                            const double spacing,
+                            const enum_fill_rule fill_rule = fill_rule_extent) ;
+
+    /** @brief Similar to fill_with_lines(), but treats all the closed
+     * polylines of selection as the edges of a single region, so that
+     * polylines inside others make holes, according to fill_rule.
+     *
+     * The lines have the properties of the first polyline of the region.
+     */
+    static dpps::Pattern fill_region_with_lines (
+                            const Pattern &pattern,
+                            const double angle,
+                            const double spacing,
+                            const enum_fill_rule fill_rule = fill_rule_even_odd,
+                            const selection_t selection = -1) ;
 
     /** @brief Function which converts a closed Polyline into a vector of
      * two-vertices Polyline that can be drawn along a line. The angle
@@ -71,7 +87,8 @@ public:
      */
     static dpps::Pattern fill_with_lines_first_angle (
                             const Polyline &polyline,
-                            const double spacing) ;
+                            const double spacing,
+                            const enum_fill_rule fill_rule = fill_rule_extent) ;
 
     // designed for C++ code, not for Lua bindings.
     static dpps::Pattern from_initialization_list (shape list) ;
@@ -84,7 +101,8 @@ public:
                          const double duty_cycle,
                          const double phase_initial,
                          const double phase_increment,
-                         const enum_partial_dash_policy partial_dash_policy) ;
+                         const enum_partial_dash_policy partial_dash_policy,
+                         const enum_fill_rule fill_rule = fill_rule_extent) ;
     static dpps::Pattern fill_with_dashes_first_angle (
                             const Polyline &polyline,
                             const double period_longitudinal,
@@ -92,7 +110,35 @@ public:
                             const double duty_cycle,
                             const double phase_initial,
                             const double phase_increment,
-                            const enum_partial_dash_policy partial_dash_policy) ;
+                            const enum_partial_dash_policy partial_dash_policy,
+                            const enum_fill_rule fill_rule = fill_rule_extent) ;
+
+    /** @brief fill_with_dashes() on the region made by the closed polylines
+     * of selection, see fill_region_with_lines(). */
+    static dpps::Pattern fill_region_with_dashes (
+                         const Pattern &pattern,
+                         const double angle,
+                         const double period_longitudinal,
+                         const double spacing_transversal,
+                         const double duty_cycle,
+                         const double phase_initial,
+                         const double phase_increment,
+                         const enum_partial_dash_policy partial_dash_policy,
+                         const enum_fill_rule fill_rule = fill_rule_even_odd,
+                         const selection_t selection = -1) ;
+
+    /** @brief Computes operation between the closed polylines of
+     * selection_a and those of selection_b, see Polygon_boolean.
+     *
+     * The result is made of closed counterclockwise polylines, with the
+     * properties of the first polyline used. Its holes are joined to the
+     * contour around them by a horizontal cut. The union of a selection
+     * with itself takes each of its polylines once. */
+    static dpps::Pattern boolean_operation (
+                         const Pattern &pattern,
+                         const enum_boolean_operation operation,
+                         const selection_t selection_a,
+                         const selection_t selection_b) ;
 
     static dpps::Pattern Pattern_from_selected (const Pattern &p, const selection_t selection = 0) ;
 
@@ -126,6 +172,11 @@ public:
      * The returned pattern contains the differing polylines, selection 1 for
      * those present in old and not in new, selection 2 for those in new and
      * not in 1.
+     *
+     * The old polylines are indexed by their number of vertices and the
+     * lower left corner of their bounding box, so that each new polyline is
+     * only compared to the few old ones which can be identical to it, and
+     * the time grows about linearly with the number of polylines.
      */
     static dpps::Pattern compare (const Pattern &pattern_old,
                 const Pattern &pattern_new,
@@ -0,0 +1,251 @@
+/**
+ * @file Pattern_fixed.cpp
+ * @author Jérôme Borme <jerome.borme@inl.int>
+ * @version 1.0
+ * @brief Implementation of class Pattern_fixed
+ * @date 2026-10-14 Jérôme Borme: Initial version
+ * @copyright
+ * This Source Code Form is subject to the terms of the Mozilla Public
+ * License, v. 2.0. If a copy of the MPL was not distributed with this
+ * file, You can obtain one at http://mozilla.org/MPL/2.0/.
+ */
+
+#include <cmath>
+#include <limits>
+#include <algorithm>
+
+#include "Pattern_fixed.hh"
+#include "bad_parametre.hh"
+
+constexpr double dpps::Pattern_fixed::default_unit ;
+
+dpps::Pattern_fixed::Pattern_fixed (const double unit) : unit (unit) {
+    if (!(unit > 0.0) || !std::isfinite (unit)) {
+        std::string reason {"Pattern_fixed: the unit must be strictly "
+                            "positive, but it is " + std::to_string (unit)} ;
+        throw bad_parametre (reason. c_str ()) ;
+    }
+}
+
+dpps::Pattern_fixed::Pattern_fixed (const Pattern &p, const double unit) :
+    Pattern_fixed (unit) {
+    assign (p) ;
+}
+
+double dpps::Pattern_fixed::get_unit () const {
+    return unit ;
+}
+
+double dpps::Pattern_fixed::maximum_error () const {
+    return unit / 2.0 ;
+}
+
+int32_t dpps::Pattern_fixed::to_fixed (const double coordinate) const {
+    double steps {std::round (coordinate / unit)} ;
+    // Also false for NaN.
+    if (!((steps >= std::numeric_limits<int32_t>::min ()) &&
+          (steps <= std::numeric_limits<int32_t>::max ()))) {
+        std::string reason {"Pattern_fixed: the coordinate " +
+                            std::to_string (coordinate) +
+                            " cannot be stored with a unit of " +
+                            std::to_string (unit)} ;
+        throw bad_parametre (reason. c_str ()) ;
+    }
+    return static_cast<int32_t> (steps) ;
+}
+
+void dpps::Pattern_fixed::clear () {
+    x. clear () ;
+    y. clear () ;
+    offsets. assign (1, 0) ;
+    closed. clear () ;
+    dose. clear () ;
+    reference. clear () ;
+    selected. clear () ;
+}
+
+void dpps::Pattern_fixed::reserve (const long_unsigned_int number_polylines,
+                                   const long_unsigned_int number_vertices) {
+    x. reserve (number_vertices) ;
+    y. reserve (number_vertices) ;
+    offsets. reserve (number_polylines + 1) ;
+    closed. reserve (number_polylines) ;
+    dose. reserve (number_polylines) ;
+    reference. reserve (number_polylines) ;
+    selected. reserve (number_polylines) ;
+}
+
+void dpps::Pattern_fixed::assign (const Pattern &p) {
+    clear () ;
+    reserve (p. polylines. size (), p. vertices_size (-1)) ;
+    // the reference &q is used to avoid copy
+    for (auto &q: p. polylines)
+        push_back (q) ;
+}
+
+void dpps::Pattern_fixed::push_back (const Polyline &p) {
+    long_unsigned_int n {x. size ()} ;
+    try {
+        // the reference &v is used to avoid copy
+        for (auto &v: p. vertices) {
+            x. push_back (to_fixed (v. x)) ;
+            y. push_back (to_fixed (v. y)) ;
+        }
+    } catch (bad_parametre &) {
+        x. resize (n) ;
+        y. resize (n) ;
+        throw ;
+    }
+    offsets. push_back (x. size ()) ;
+    closed. push_back (p. closed) ;
+    dose. push_back (p. dose) ;
+    reference. push_back (p. reference) ;
+    selected. push_back (static_cast<uint16_t> (p. selected. to_ulong ())) ;
+}
+
+dpps::Polyline dpps::Pattern_fixed::get_polyline (
+    const long_unsigned_int i) const {
+    Polyline result ;
+    result. vertices. reserve (polyline_size (i)) ;
+    for (long_unsigned_int j {offsets[i]} ; j < offsets[i+1] ; j++)
+        result. vertices. push_back (Vertex (x[j] * unit, y[j] * unit)) ;
+    result. closed = closed[i] ;
+    result. dose = dose[i] ;
+    result. reference = reference[i] ;
+    result. selected = std::bitset<polyline_max_selection> (selected[i]) ;
+    return result ;
+}
+
+dpps::Pattern dpps::Pattern_fixed::to_Pattern (
+    const selection_t selection) const {
+check_selection_not_too_high(selection) ;
+    Pattern result ;
+    result. polylines. reserve (size (selection)) ;
+    for (long_unsigned_int i {0} ; i < dose. size () ; i++)
+        if (is_selected (i, selection))
+            result. polylines. push_back (get_polyline (i)) ;
+    return result ;
+}
+
+bool dpps::Pattern_fixed::is_selected (const long_unsigned_int i,
+                                       const selection_t selection) const {
+    if (selection < 0)
+        return true ;
+    return (selected[i] >> selection) & 1 ;
+}
+
+long_unsigned_int dpps::Pattern_fixed::size (
+    const selection_t selection) const {
+check_selection_not_too_high(selection) ;
+    if (selection < 0)
+        return dose. size () ;
+    long_unsigned_int n {0} ;
+    for (long_unsigned_int i {0} ; i < dose. size () ; i++)
+        if (is_selected (i, selection))
+            n++ ;
+    return n ;
+}
+
+long_unsigned_int dpps::Pattern_fixed::polyline_size (
+    const long_unsigned_int i) const {
+    return offsets[i+1] - offsets[i] ;
+}
+
+long_unsigned_int dpps::Pattern_fixed::vertices_size (
+    const selection_t selection) const {
+check_selection_not_too_high(selection) ;
+    if (selection < 0)
+        return x. size () ;
+    long_unsigned_int n {0} ;
+    for (long_unsigned_int i {0} ; i < dose. size () ; i++)
+        if (is_selected (i, selection))
+            n += polyline_size (i) ;
+    return n ;
+}
+
+DPPS_MULTIVERSION
+void dpps::Pattern_fixed::translate (const double x0, const double y0,
+                                     const selection_t selection) {
+check_selection_not_too_high(selection) ;
+    int32_t dx {to_fixed (x0)} ;
+    int32_t dy {to_fixed (y0)} ;
+    // Checked first, so that a failure leaves the coordinates unchanged.
+    // The range includes 0, which does no harm since dx and dy fit.
+    int64_t minx {0}, miny {0}, maxx {0}, maxy {0} ;
+    for (long_unsigned_int i {0} ; i < dose. size () ; i++)
+        if (is_selected (i, selection))
+            for (long_unsigned_int j {offsets[i]} ; j < offsets[i+1] ; j++) {
+                minx = std::min<int64_t> (minx, x[j]) ;
+                maxx = std::max<int64_t> (maxx, x[j]) ;
+                miny = std::min<int64_t> (miny, y[j]) ;
+                maxy = std::max<int64_t> (maxy, y[j]) ;
+            }
+    if ((minx + dx < std::numeric_limits<int32_t>::min ()) ||
+        (maxx + dx > std::numeric_limits<int32_t>::max ()) ||
+        (miny + dy < std::numeric_limits<int32_t>::min ()) ||
+        (maxy + dy > std::numeric_limits<int32_t>::max ())) {
+        std::string reason {"Pattern_fixed::translate: the translated "
+                            "coordinates cannot be stored with a unit of " +
+                            std::to_string (unit)} ;
+        throw bad_parametre (reason. c_str ()) ;
+    }
+    if (selection < 0) {
+        for (auto &v: x)
+            v += dx ;
+        for (auto &v: y)
+            v += dy ;
+        return ;
+    }
+    for (long_unsigned_int i {0} ; i < dose. size () ; i++)
+        if (is_selected (i, selection))
+            for (long_unsigned_int j {offsets[i]} ; j < offsets[i+1] ; j++) {
+                x[j] += dx ;
+                y[j] += dy ;
+            }
+}
+
+void dpps::Pattern_fixed::set_dose (const double dose_value,
+                                    const selection_t selection) {
+check_selection_not_too_high(selection) ;
+    for (long_unsigned_int i {0} ; i < dose. size () ; i++)
+        if (is_selected (i, selection))
+            dose[i] = dose_value ;
+}
+
+dpps::Vertex dpps::Pattern_fixed::lower_left (
+    const selection_t selection) const {
+check_selection_not_too_high(selection) ;
+    int32_t minx {std::numeric_limits<int32_t>::max ()} ;
+    int32_t miny {std::numeric_limits<int32_t>::max ()} ;
+    bool done {false} ;
+    for (long_unsigned_int i {0} ; i < dose. size () ; i++)
+        if (is_selected (i, selection))
+            for (long_unsigned_int j {offsets[i]} ; j < offsets[i+1] ; j++) {
+                done = true ;
+                minx = std::min (minx, x[j]) ;
+                miny = std::min (miny, y[j]) ;
+            }
+    if (done)
+        return Vertex (minx * unit, miny * unit) ;
+    else
+        return Vertex (0.0, 0.0) ;
+}
+
+dpps::Vertex dpps::Pattern_fixed::upper_right (
+    const selection_t selection) const {
+check_selection_not_too_high(selection) ;
+    int32_t maxx {std::numeric_limits<int32_t>::lowest ()} ;
+    int32_t maxy {std::numeric_limits<int32_t>::lowest ()} ;
+    bool done {false} ;
+    for (long_unsigned_int i {0} ; i < dose. size () ; i++)
+        if (is_selected (i, selection))
+            for (long_unsigned_int j {offsets[i]} ; j < offsets[i+1] ; j++) {
+                done = true ;
+                maxx = std::max (maxx, x[j]) ;
+                maxy = std::max (maxy, y[j]) ;
+            }
+    if (done)
+        return Vertex (maxx * unit, maxy * unit) ;
+    else
+        return Vertex (0.0, 0.0) ;
+}
@@ -0,0 +1,145 @@
+/**
+ * @file Pattern_fixed.hh
+ * @author Jérôme Borme <jerome.borme@inl.int>
+ * @version 1.0
+ * @brief Header file for class Pattern_fixed, a storage of polylines with
+ * fixed-point coordinates
+ * @date 2026-10-14 Jérôme Borme: Initial version
+ * @copyright
+ * This Source Code Form is subject to the terms of the Mozilla Public
+ * License, v. 2.0. If a copy of the MPL was not distributed with this
+ * file, You can obtain one at http://mozilla.org/MPL/2.0/.
+ */
+#ifndef DPPS_PATTERN_FIXED
+#define DPPS_PATTERN_FIXED
+
+#include <vector>
+#include <cstdint>
+
+#include "common.hh"
+#include "util.hh"
+#include "Vertex.hh"
+#include "Polyline.hh"
+#include "Pattern.hh"
+
+namespace dpps {
+/** @brief A Pattern stored as a structure of arrays, with the coordinates in
+ * 32-bit fixed point.
+ *
+ * It is organised as Pattern_packed, but each coordinate is stored as a
+ * signed 32-bit integer number of unit, which halves the memory taken by the
+ * vertices. With the default unit of 0.001 (1 nm if the coordinates are in
+ * µm, the resolution of Writer_witec), the coordinates can reach ±2 m.
+ *
+ * The coordinates are rounded to the nearest multiple of unit when the
+ * polylines are added, so that they differ by at most maximum_error() from
+ * the original ones. This is the only rounding: the polylines returned by
+ * get_polyline() and to_Pattern() have coordinates which are exact
+ * multiples of unit, and translate() works on the integers. A coordinate
+ * which does not fit in 32 bits throws bad_parametre.
+ *
+ * The selections are kept in one word per polyline, with bit s for the
+ * selection register s. */
+class Pattern_fixed {
+protected:
+    /** @brief the length of one step of the coordinates. */
+    double unit ;
+
+    /** @brief returns the number of unit nearest to coordinate, and throws
+     * bad_parametre if it does not fit in 32 bits. */
+    int32_t to_fixed (const double coordinate) const ;
+public:
+    /** @brief the default unit, see Writer_witec::movement_unit. */
+    static const constexpr double default_unit {0.001} ;
+
+    /** @brief x coordinates of all the vertices, as numbers of unit. */
+    std::vector<int32_t> x ;
+
+    /** @brief y coordinates of all the vertices, as numbers of unit. */
+    std::vector<int32_t> y ;
+
+    /** @brief position in x and y of the first vertex of each polyline, plus
+     * the total number of vertices as last element. */
+    std::vector<long_unsigned_int> offsets {0} ;
+
+    /** @brief Polyline::closed of each polyline. */
+    std::vector<bool> closed ;
+
+    /** @brief Polyline::dose of each polyline. */
+    std::vector<double> dose ;
+
+    /** @brief Polyline::reference of each polyline. */
+    std::vector<long_unsigned_int> reference ;
+
+    /** @brief Polyline::selected of each polyline, bit s for selection
+     * register s. */
+    std::vector<uint16_t> selected ;
+
+    /** @brief creates an empty Pattern_fixed. Throws bad_parametre if unit is
+     * not strictly positive. */
+    Pattern_fixed (const double unit = default_unit) ;
+
+    /** @brief creates a Pattern_fixed with the polylines of p, including
+     * their selections. */
+    Pattern_fixed (const Pattern &p, const double unit = default_unit) ;
+
+    /** @brief returns the unit of the coordinates. */
+    double get_unit () const ;
+
+    /** @brief returns the largest difference between a coordinate given to
+     * push_back() and the one stored, which is unit/2. */
+    double maximum_error () const ;
+
+    /** @brief replaces the contents by the polylines of p. */
+    void assign (const Pattern &p) ;
+
+    /** @brief returns a Pattern with the selected polylines. */
+    Pattern to_Pattern (const selection_t selection = -1) const ;
+
+    /** @brief removes all the polylines. */
+    void clear () ;
+
+    /** @brief preallocates memory for number_polylines polylines having
+     * number_vertices vertices in total. */
+    void reserve (const long_unsigned_int number_polylines,
+                  const long_unsigned_int number_vertices) ;
+
+    /** @brief adds a polyline at the end, with its selections. Nothing is
+     * added if one of its coordinates does not fit. */
+    void push_back (const Polyline &p) ;
+
+    /** @brief returns polyline number i as a Polyline object. */
+    Polyline get_polyline (const long_unsigned_int i) const ;
+
+    /** @brief whether polyline i belongs to selection, or true if selection
+     * is negative. */
+    bool is_selected (const long_unsigned_int i,
+                      const selection_t selection) const ;
+
+    /** @brief number of selected polylines. */
+    long_unsigned_int size (const selection_t selection = -1) const ;
+
+    /** @brief number of vertices in the selected polylines. */
+    long_unsigned_int vertices_size (const selection_t selection = -1) const ;
+
+    /** @brief number of vertices of polyline i. */
+    long_unsigned_int polyline_size (const long_unsigned_int i) const ;
+
+    /** @brief see Pattern::translate(). x0 and y0 are rounded to the nearest
+     * multiple of unit, so that the translation itself is exact. Throws
+     * bad_parametre, without moving anything, if a coordinate would not
+     * fit. */
+    void translate (const double x0, const double y0,
+                    const selection_t selection = -1) ;
+
+    /** @brief see Pattern::set_dose(). */
+    void set_dose (const double dose_value, const selection_t selection = -1) ;
+
+    /** @brief see Pattern::lower_left(). */
+    Vertex lower_left (const selection_t selection = -1) const ;
+
+    /** @brief see Pattern::upper_right(). */
+    Vertex upper_right (const selection_t selection = -1) const ;
+} ;
+} // namespace dpps
+#endif
@@ -10,6 +10,9 @@
  * file, You can obtain one at http://mozilla.org/MPL/2.0/.
  */
 
+#include <algorithm>
+#include <limits>
+
 #include "Pattern_grating.hh"
 #include "bad_parametre.hh"
 
@@ -18,12 +21,14 @@ dpps::Pattern_grating::Pattern_grating (): Pattern () {
 
 dpps::Pattern_grating::Pattern_grating (const Pattern_grating &source):
     Pattern (source),
-    pattern_settings (source. pattern_settings) {
+    pattern_settings (source. pattern_settings),
+    lattice_cells (source. lattice_cells) {
 }
 
 dpps::Pattern_grating::Pattern_grating (Pattern_grating &&source):
     Pattern (source),
-    pattern_settings (source. pattern_settings) {
+    pattern_settings (source. pattern_settings),
+    lattice_cells (source. lattice_cells) {
 }
 
 dpps::Pattern_grating::Pattern_grating (
@@ -42,6 +47,7 @@ dpps::Pattern_grating &dpps::Pattern_grating::operator= (
     if (this != &source) {
         Pattern::operator=(source) ;
         pattern_settings = source. pattern_settings ;
+        lattice_cells = source. lattice_cells ;
     }
     return *this ;
 }
@@ -50,6 +56,7 @@ dpps::Pattern_grating &dpps::Pattern_grating::operator= (
     const dpps::Pattern_grating &source) {
     Pattern::operator=(source) ;
     pattern_settings = source. pattern_settings ;
+    lattice_cells = source. lattice_cells ;
     return *this ;
 }
 
@@ -85,7 +92,7 @@ void dpps::Pattern_grating::set_parametres (
                         vdouble[3], vdouble[4], vdouble[5]) ;
 }
 
-void dpps::Pattern_grating::generate () {
+long_unsigned_int dpps::Pattern_grating::count_lines () const {
     double minx {pattern_settings. coordinates[0]} ;
     double miny {pattern_settings. coordinates[1]} ;
     double maxx {pattern_settings. coordinates[2]} ;
@@ -96,32 +103,122 @@ minimum_x.") ;
     if (maxy <= miny) throw bad_parametre
        ("Pattern_grating::generate, maximum_y is smaller or equal than the \
 minimum_y.") ;
-    double startx {minx} ;
-    Vertex v ;
-    Polyline p ;
+    if (pattern_settings. period <= 0) throw bad_parametre
+       ("Pattern_grating::generate, the period must be positive.") ;
+    return Lattice_cells::number_positions (minx, maxx,
+                                            pattern_settings. period) ;
+}
+
+void dpps::Pattern_grating::fill_line (const long_unsigned_int i,
+                                       Polyline &p) const {
+    // The positions are computed from the index, so that they do not drift
+    // along large gratings.
+    double startx {pattern_settings. coordinates[0] +
+                   i * pattern_settings. period} ;
+    double endx {startx + pattern_settings. period *
+                          pattern_settings. area_ratio} ;
     p. closed = true ;
-    while (startx < maxx) {
-        // Vertex and Polyline are passed as parametre and inserted in vectors
-        // by copy, so we can always push_back the same variable.
-        v. x = startx ;
-        v. y = miny ;
-        p. push_back (v) ;
-        // v. x = startx ;
-        v. y = maxy ;
-        p. push_back (v) ;
-        v. x = startx + pattern_settings. period *
-                        pattern_settings. area_ratio ;
-        //v. y = maxy ;
-        p. push_back (v) ;
-        // v. x = startx + pattern_settings. period *
-        // pattern_settings. area_ratio ;
-        v. y = miny ;
-        p. push_back (v) ;
+    p. vertices. reserve (4) ;
+    p. push_back (Vertex (startx, pattern_settings. coordinates[1])) ;
+    p. push_back (Vertex (startx, pattern_settings. coordinates[3])) ;
+    p. push_back (Vertex (endx, pattern_settings. coordinates[3])) ;
+    p. push_back (Vertex (endx, pattern_settings. coordinates[1])) ;
+}
+
+void dpps::Pattern_grating::generate () {
+    if (pattern_settings. procedural) {
+        // The bounding box of a line is the one of its vertices.
+        double width {pattern_settings. period * pattern_settings. area_ratio} ;
+        Lattice_cells::Axis x, y ;
+        x. origin = pattern_settings. coordinates[0] ;
+        x. period = pattern_settings. period ;
+        x. number = count_lines () ;
+        x. low = std::min (0.0, width) ;
+        x. high = std::max (0.0, width) ;
+        y. number = 1 ;
+        y. low = pattern_settings. coordinates[1] ;
+        y. high = pattern_settings. coordinates[3] ;
+        y. absolute = true ;
+        lattice_cells. set (x, y) ;
+        return ;
+    }
+    long_unsigned_int number {count_lines ()} ;
+    polylines. reserve (polylines. size () + number) ;
+    Polyline p ;
+    for (long_unsigned_int i {0} ; i < number ; i++) {
+        p. vertices. clear () ;
+        fill_line (i, p) ;
         polylines. push_back (p) ;
+    }
+}
+
+void dpps::Pattern_grating::generate_each (
+    const std::function<void (const Polyline &)> &function) {
+    // The same polyline is filled again for each line.
+    Polyline p ;
+    if (pattern_settings. procedural) {
+        lattice_cells. for_each_implicit (
+            [&] (long_unsigned_int i, long_unsigned_int) {
+                p. vertices. clear () ;
+                fill_line (i, p) ;
+                function (p) ;
+            }) ;
+        return ;
+    }
+    long_unsigned_int number {count_lines ()} ;
+    for (long_unsigned_int i {0} ; i < number ; i++) {
+        p. vertices. clear () ;
+        fill_line (i, p) ;
+        function (p) ;
+    }
+}
+
+void dpps::Pattern_grating::set_procedural (const bool procedural) {
+    pattern_settings. procedural = procedural ;
+    lattice_cells. set (Lattice_cells::Axis (), Lattice_cells::Axis ()) ;
+}
 
-        // preparing for next iteration
-        p. vertices. clear () ; // does not change that p. closed == true ;
-        startx += pattern_settings. period ;
-    } ;
+long_unsigned_int dpps::Pattern_grating::implicit_size () const {
+    return lattice_cells. size () ;
+}
+
+double dpps::Pattern_grating::implicit_area () const {
+    // All the lines have the same area.
+    return lattice_cells. size () *
+           (lattice_cells. x. high - lattice_cells. x. low) *
+           (lattice_cells. y. high - lattice_cells. y. low) ;
+}
 
-}
\ No newline at end of file
+bool dpps::Pattern_grating::implicit_limits (double &xmin, double &ymin,
+                                             double &xmax, double &ymax) const {
+    return lattice_cells. limits (xmin, ymin, xmax, ymax) ;
+}
+
+long_unsigned_int dpps::Pattern_grating::implicit_size_in_window (
+    const double xmin, const double ymin,
+    const double xmax, const double ymax) const {
+    return lattice_cells. size_in_window (xmin, ymin, xmax, ymax) ;
+}
+
+void dpps::Pattern_grating::materialize_window (
+    const double xmin, const double ymin,
+    const double xmax, const double ymax,
+    const selection_t selection) {
+check_selection_not_negative_not_too_high(selection) ;
+    Polyline p ;
+    p. selected[selection] = true ;
+    lattice_cells. materialize_window (xmin, ymin, xmax, ymax,
+        [&] (long_unsigned_int i, long_unsigned_int) {
+            p. vertices. clear () ;
+            fill_line (i, p) ;
+            polylines. push_back (p) ;
+        }) ;
+}
+
+void dpps::Pattern_grating::materialize (const selection_t selection) {
+    materialize_window (-std::numeric_limits<double>::infinity (),
+                        -std::numeric_limits<double>::infinity (),
+                        std::numeric_limits<double>::infinity (),
+                        std::numeric_limits<double>::infinity (),
+                        selection) ;
+}
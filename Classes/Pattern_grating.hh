@@ -14,6 +14,7 @@
 #define PATTERN_GRATING
 
 #include "Pattern.hh"
+#include "Lattice_cells.hh"
 
 namespace dpps {
 /** @brief Pattern_grating is a Pattern derivative that generates a diffraction
@@ -21,6 +22,10 @@ namespace dpps {
  *
  * The grating is made of long and thin rectangles whose long direction is along
  * the y axis.
+ *
+ * In the procedural mode (see set_procedural()), generate() does not append
+ * the lines: they stay implicit, as for Pattern_rectangular_lattice, and
+ * are only appended to polylines by materialize_window() and materialize().
  */
 class Pattern_grating: public Pattern {
 public:
@@ -44,11 +49,23 @@ public:
          * the left instead of to the right.
          */
         double area_ratio {0.5} ;
+
+        /** @brief whether generate() keeps the lines implicit. */
+        bool procedural {false} ;
     } ;
 
 protected:
     Pattern_grating_settings pattern_settings ;
 
+    /** @brief the implicit lines of the procedural mode, along x only. */
+    Lattice_cells lattice_cells ;
+
+    /** @brief checks the settings and returns the number of lines. */
+    long_unsigned_int count_lines () const ;
+
+    /** @brief appends to p the vertices of line i. */
+    void fill_line (const long_unsigned_int i, Polyline &p) const ;
+
 public:
     /** @brief the default constructor */
     Pattern_grating () ;
@@ -80,6 +97,43 @@ public:
 
     void generate () ;
 
+    /** @brief see Pattern::generate_each(). In the procedural mode, only
+     * the implicit lines are passed. */
+    void generate_each (
+        const std::function<void (const Polyline &)> &function) ;
+
+    /** @brief sets whether the next generate() keeps the lines implicit,
+     * see Pattern_rectangular_lattice::set_procedural(). */
+    void set_procedural (const bool procedural) ;
+
+    /** @brief the number of implicit lines. */
+    long_unsigned_int implicit_size () const ;
+
+    /** @brief the sum of the areas of the implicit lines. */
+    double implicit_area () const ;
+
+    /** @brief sets the limits of the implicit lines. Returns false, leaving
+     * them unchanged, if there is none. */
+    bool implicit_limits (double &xmin, double &ymin,
+                          double &xmax, double &ymax) const ;
+
+    /** @brief the number of implicit lines which Pattern::select_window()
+     * would select in the window if they were polylines. */
+    long_unsigned_int implicit_size_in_window (const double xmin,
+                                               const double ymin,
+                                               const double xmax,
+                                               const double ymax) const ;
+
+    /** @brief appends to polylines the implicit lines inside the window, and
+     * adds them to the selection. They are no longer implicit. */
+    void materialize_window (const double xmin, const double ymin,
+                             const double xmax, const double ymax,
+                             const selection_t selection = 0) ;
+
+    /** @brief appends to polylines all the implicit lines, and adds them to
+     * the selection. */
+    void materialize (const selection_t selection = 0) ;
+
     void set_all_parametres (
         const double minx,
         const double miny,
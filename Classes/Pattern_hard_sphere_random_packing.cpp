@@ -11,10 +11,17 @@
  * file, You can obtain one at http://mozilla.org/MPL/2.0/.
  */
 
+#include <algorithm>
 #include <iostream>
+#include <cmath>
+#include <chrono>
+#include <exception>
+#include <limits>
 
+#include "configure.h"
 #include "common.hh"
 #include "Pattern_hard_sphere_random_packing.hh"
+#include "Counter_random.hh"
 #include "bad_parametre.hh"
 
 // Included class hard_sphere
@@ -44,6 +51,60 @@ double dpps::Pattern_hard_sphere_random_packing::hard_sphere::squared_distance (
 }
 /////////////////////////////
 
+// Included class sphere_grid
+/////////////////////////////
+dpps::Pattern_hard_sphere_random_packing::sphere_grid::sphere_grid (
+    const double set_cell_size, const double x0, const double y0):
+            cell_size (set_cell_size), x_origin (x0), y_origin (y0) {
+}
+
+void dpps::Pattern_hard_sphere_random_packing::sphere_grid::get_cell (
+    long signed int &i, long signed int &j,
+    const double x, const double y) const {
+    i = static_cast<long signed int> (floor ((x - x_origin) / cell_size)) ;
+    j = static_cast<long signed int> (floor ((y - y_origin) / cell_size)) ;
+}
+
+long_unsigned_int dpps::Pattern_hard_sphere_random_packing::sphere_grid::
+    cell_key (const long signed int i, const long signed int j) {
+    // Two different cells may happen to share the same key. This only
+    // means that some more spheres are tested for distance, the result
+    // of overlaps() is not affected.
+    return (static_cast<long_unsigned_int> (i) * 73856093u) ^
+           (static_cast<long_unsigned_int> (j) * 19349663u) ;
+}
+
+void dpps::Pattern_hard_sphere_random_packing::sphere_grid::insert (
+    const hard_sphere &s, const long_unsigned_int n) {
+    long signed int i, j ;
+    get_cell (i, j, s. x, s. y) ;
+    cells[cell_key (i, j)]. push_back (n) ;
+}
+
+bool dpps::Pattern_hard_sphere_random_packing::sphere_grid::overlaps (
+    const hard_sphere &s,
+    const std::vector<hard_sphere> &spheres,
+    const double squared_diametre,
+    const long_unsigned_int excluded) const {
+    long signed int i, j ;
+    get_cell (i, j, s. x, s. y) ;
+    for (long signed int di = -1 ; di <= 1 ; di++)
+        for (long signed int dj = -1 ; dj <= 1 ; dj++) {
+            auto cell = cells. find (cell_key (i + di, j + dj)) ;
+            if (cell == cells. end ())
+                continue ;
+            // the reference &n is used to avoid copy
+            for (auto &n: cell-> second) {
+                if (n == excluded)
+                    continue ;
+                if (spheres[n]. squared_distance (s) < squared_diametre)
+                    return true ;
+            }
+        }
+    return false ;
+}
+/////////////////////////////
+
 dpps::Pattern_hard_sphere_random_packing::Pattern_hard_sphere_random_packing (): Pattern () {
 }
 
@@ -128,54 +189,113 @@ set_parametres",
                         vdouble[2], vdouble[3], vdouble[4]) ;
 }
 
+void dpps::Pattern_hard_sphere_random_packing::set_report_throughput (
+    const bool report_throughput) {
+    pattern_settings. report_throughput = report_throughput ;
+}
+
+void dpps::Pattern_hard_sphere_random_packing::set_tiles (
+    const long_unsigned_int tiles_x,
+    const long_unsigned_int tiles_y) {
+    if ((tiles_x == 0) || (tiles_y == 0)) {
+        std::string reason {"Pattern_hard_sphere_random_packing::set_tiles, \
+there must be at least one tile along x and y, but values provided were " +
+            std::to_string (tiles_x) + " and " + std::to_string (tiles_y)} ;
+        throw bad_parametre (reason. c_str ()) ;
+    }
+    pattern_settings. tiles_x = tiles_x ;
+    pattern_settings. tiles_y = tiles_y ;
+}
+
+std::string dpps::Pattern_hard_sphere_random_packing::
+    get_throughput_string () const {
+    std::string result {"Pattern_hard_sphere_random_packing: " +
+        std::to_string (throughput_spheres) + " spheres placed in " +
+        std::to_string (throughput_duration) + " s"} ;
+    if (throughput_duration > 0)
+        result += ", " + std::to_string (throughput_spheres /
+                                         throughput_duration) + " spheres/s" ;
+    if (throughput_spheres > 0)
+        result += ", " + std::to_string (
+            static_cast<double> (throughput_rejections) /
+            static_cast<double> (throughput_spheres)) + " rejections/sphere" ;
+    return result ;
+}
+
 void dpps::Pattern_hard_sphere_random_packing::generate () {
-    constexpr const static short unsigned int max_angle_iterations {50} ;
-    constexpr const static double two_pi {2*M_PI} ;
+    throughput_spheres = 0 ;
+    throughput_rejections = 0 ;
+    throughput_duration = 0.0 ;
+    generate_cached ("Pattern_hard_sphere_random_packing",
+        {},
+        {pattern_settings. number_total, pattern_settings. number_random,
+         pattern_settings. tiles_x, pattern_settings. tiles_y},
+        {pattern_settings. x0, pattern_settings. y0,
+         pattern_settings. lx, pattern_settings. ly,
+         pattern_settings. diametre},
+        {},
+        true,
+        [this] {
+            generate_packing () ;
+        }) ;
+}
+
+template <class Generator>
+void dpps::Pattern_hard_sphere_random_packing::nucleate (
+    std::vector<hard_sphere> &spheres,
+    sphere_grid &grid,
+    std::vector<long_unsigned_int> &open_spheres,
+    const long_unsigned_int number_random,
+    const double minx, const double miny,
+    const double maxx, const double maxy,
+    Generator &generator,
+    long_unsigned_int &rejections) const {
     constexpr const static long_unsigned_int factor_maximum_trials {3} ;
-    if (pattern_settings. number_total == 0)
-        return ;
-    if (pattern_settings. number_random > pattern_settings. number_total)
-        pattern_settings. number_random = pattern_settings. number_total ;
-    std::vector<hard_sphere> open_spheres, full_spheres ;
-    hard_sphere s ;
+    constexpr const static long_unsigned_int no_exclusion {
+        std::numeric_limits<long_unsigned_int>::max ()} ;
+    const double squared_diametre {
+        pattern_settings. diametre * pattern_settings. diametre} ;
+    std::uniform_real_distribution<double> dx (minx, maxx) ;
+    std::uniform_real_distribution<double> dy (miny, maxy) ;
+    long_unsigned_int i {0} ;
     bool finished {false} ;
-
-    // s. diametre = pattern_settings. diametre ;
-    if (pattern_settings. number_random == 0)
-        open_spheres. push_back (s) ;
-    else {
-        std::uniform_real_distribution<double> dx (
-            pattern_settings. x0 - pattern_settings. lx /2.0,   // min
-            pattern_settings. x0 + pattern_settings. lx /2.0) ; // max
-        std::uniform_real_distribution<double> dy (
-            pattern_settings. y0 - pattern_settings. ly /2.0,
-            pattern_settings. y0 + pattern_settings. ly /2.0) ;
-        long_unsigned_int i {0} ;
-        while (!finished) {
-            i++ ;
-            hard_sphere possible_place (dx (pseudorandom_generator),
-                                        dy (pseudorandom_generator),
-                                        true) ;
-            bool already_a_sphere_here {false} ;
-            for (long_unsigned_int j = 0 ;
-                    j < open_spheres. size () ; j++) {
-                if (open_spheres[j]. squared_distance (possible_place) <
-                    pattern_settings. diametre*pattern_settings. diametre) {
-                    already_a_sphere_here = true ;
-                    break ;
-                }
-            }
-            if (already_a_sphere_here)
-                continue ;
-            open_spheres. push_back (possible_place) ;
-            finished = ((open_spheres. size () >=
-                            pattern_settings. number_random) ||
-                        (i > pattern_settings. number_random *
-                             factor_maximum_trials)) ;
+    while (!finished) {
+        i++ ;
+        hard_sphere possible_place (dx (generator),
+                                    dy (generator),
+                                    true) ;
+        if (grid. overlaps (possible_place, spheres, squared_diametre,
+                            no_exclusion))
+            rejections++ ;
+        else {
+            grid. insert (possible_place, spheres. size ()) ;
+            open_spheres. push_back (spheres. size ()) ;
+            spheres. push_back (possible_place) ;
         }
+        // Tested at every trial, so that we also stop when the surface is
+        // too crowded to place number_random spheres.
+        finished = ((open_spheres. size () >= number_random) ||
+                    (i > number_random * factor_maximum_trials)) ;
     }
-    finished = (full_spheres. size () + open_spheres. size ()
-                >= pattern_settings. number_total) ;
+}
+
+template <class Generator>
+void dpps::Pattern_hard_sphere_random_packing::grow (
+    std::vector<hard_sphere> &spheres,
+    sphere_grid &grid,
+    std::vector<long_unsigned_int> &open_spheres,
+    std::vector<long_unsigned_int> &full_spheres,
+    const long_unsigned_int number_total,
+    const double minx, const double miny,
+    const double maxx, const double maxy,
+    Generator &generator,
+    long_unsigned_int &rejections) const {
+    constexpr const static short unsigned int max_angle_iterations {50} ;
+    constexpr const static double two_pi {2*M_PI} ;
+    const double squared_diametre {
+        pattern_settings. diametre * pattern_settings. diametre} ;
+    bool finished {(spheres. size () >= number_total) ||
+                   (open_spheres. size () == 0)} ;
     std::uniform_int_distribution<long_unsigned_int> d_int ;
     std::uniform_real_distribution<double> d_real (0, two_pi) ;
     while (!finished) {
@@ -184,84 +304,239 @@ void dpps::Pattern_hard_sphere_random_packing::generate () {
         // Nokilai Josuttis, The C++ Standard Library 2nd Ed., §17.1.4 p. 919
         std::uniform_int_distribution<long_unsigned_int>::param_type
                 param (0, open_spheres.size () - 1) ;
-        long_unsigned_int pos {d_int (pseudorandom_generator, param)} ;
-        s = open_spheres. at (pos) ;
-        bool already_a_sphere_here {false} ;
+        long_unsigned_int pos {d_int (generator, param)} ;
+        long_unsigned_int centre {open_spheres[pos]} ;
+        hard_sphere s {spheres[centre]} ;
+        bool placed {false} ;
         // We choose one angle and see if there is space to add a new sphere
         // at this angle around the one already selected.
         // We repeat many times as finding a suitable angle might not be easy.
         for (short unsigned int i = 0 ; i < max_angle_iterations ; i++) {
             // We try to locate a sphere at angle (from x) in contact with the
             // chose sphere.
-            double angle {d_real (pseudorandom_generator)} ;
+            double angle {d_real (generator)} ;
             double x1 {s. x+(pattern_settings. diametre * cos (angle))} ;
             double y1 {s. y+(pattern_settings. diametre * sin (angle))} ;
             hard_sphere possible_place (x1, y1, true) ;
-            // std::cout << "i " ;
-            if ((x1 < pattern_settings. x0 - (pattern_settings. lx / 2.0)) ||
-                (y1 < pattern_settings. y0 - (pattern_settings. ly / 2.0)) ||
-                (x1 > pattern_settings. x0 + (pattern_settings. lx / 2.0)) ||
-                (y1 > pattern_settings. y0 + (pattern_settings. ly / 2.0)))
+            if ((x1 < minx) || (y1 < miny) || (x1 > maxx) || (y1 > maxy)) {
+                rejections++ ;
                 continue ;
-            already_a_sphere_here = false ;
-            // We see if there is any open sphere in the close vicinity,
-            // exlcuding the one we considered intitially at [pos]
-
-            for (long_unsigned_int j = 0 ; j < open_spheres. size () ; j++) {
-                if (j == pos)
-                    continue ;
-                if (open_spheres[j]. squared_distance (possible_place) <
-                    pattern_settings. diametre*pattern_settings. diametre) {
-                    already_a_sphere_here = true ;
-                    break ;
-                }
             }
-            if (already_a_sphere_here)
+            // We see if there is any sphere in the close vicinity, excluding
+            // the one we considered intitially, which is in contact.
+            if (grid. overlaps (possible_place, spheres, squared_diametre,
+                                centre)) {
+                rejections++ ;
                 continue ;
-            // Now for closed spheres... we do not to check for equality to pos.
-            for (long_unsigned_int j = 0 ; j < full_spheres. size () ; j++) {
-                if (full_spheres[j]. squared_distance (possible_place) <
-                    pattern_settings. diametre*pattern_settings. diametre) {
-                    already_a_sphere_here = true ;
-                    break ;
-                }
             }
-            // We found a sphere, we add it.
-            if (already_a_sphere_here)
-                continue ;
             // If we are here, (x1, y1) is not too close from another sphere.
-            //std::cout << "On ajoute la sphere " ;
-            // s. x = x1 ;
-            // s. y = y1 ;
-            open_spheres. push_back (possible_place) ;
+            grid. insert (possible_place, spheres. size ()) ;
+            open_spheres. push_back (spheres. size ()) ;
+            spheres. push_back (possible_place) ;
+            placed = true ;
             break ;
         }
-        if (already_a_sphere_here) {
+        if (!placed) {
             // We got out the for loop without finding a suitable place
-            // so classify the selected sphere as full.
-            full_spheres. push_back (open_spheres[pos]) ;
-            // NOTE: gcc allows cbegin() here, but clang does not.
-            open_spheres. erase (open_spheres. begin () + pos) ;
+            // so classify the selected sphere as full. The order of
+            // open_spheres does not matter, as it is drawn from at random,
+            // so we replace it by the last one instead of erasing it.
+            full_spheres. push_back (centre) ;
+            open_spheres[pos] = open_spheres. back () ;
+            open_spheres. pop_back () ;
         }
         // End criterion
-        if (full_spheres. size () + open_spheres. size ()
-            >= pattern_settings. number_total) {
+        if (spheres. size () >= number_total) {
             finished = true ;
         }
         else
             finished = (open_spheres. size () == 0) ;
     }
+}
+
+void dpps::Pattern_hard_sphere_random_packing::pack_tiles (
+    std::vector<hard_sphere> &spheres,
+    std::vector<long_unsigned_int> &open_spheres,
+    std::vector<long_unsigned_int> &full_spheres,
+    const long_unsigned_int tiles_x,
+    const long_unsigned_int tiles_y) {
+    const double diametre {pattern_settings. diametre} ;
+    const double minx {pattern_settings. x0 - pattern_settings. lx / 2.0} ;
+    const double maxx {pattern_settings. x0 + pattern_settings. lx / 2.0} ;
+    const double miny {pattern_settings. y0 - pattern_settings. ly / 2.0} ;
+    const double maxy {pattern_settings. y0 + pattern_settings. ly / 2.0} ;
+    const double tile_lx {pattern_settings. lx / tiles_x} ;
+    const double tile_ly {pattern_settings. ly / tiles_y} ;
+    // Two spheres on each side of an edge are at least one diametre apart.
+    const double guard {diametre / 2.0} ;
+    const long_unsigned_int number_tiles {tiles_x * tiles_y} ;
+    const long_unsigned_int number_total {pattern_settings. number_total} ;
+    const long_unsigned_int number_random {pattern_settings. number_random} ;
+    // Each tile draws from its own stream, so the tiles are packed in
+    // parallel, with the same result whatever the number of threads. The
+    // pass is drawn from pseudorandom_generator, so that the result depends
+    // on its state as with one tile.
+    uint32_t pass {static_cast<uint32_t> (pseudorandom_generator ())} ;
+    std::vector<std::vector<hard_sphere>> tile_spheres (number_tiles) ;
+    std::vector<std::vector<long_unsigned_int>> tile_open (number_tiles) ;
+    std::vector<std::vector<long_unsigned_int>> tile_full (number_tiles) ;
+    std::vector<long_unsigned_int> tile_rejections (number_tiles, 0) ;
+    std::vector<std::exception_ptr> errors (number_tiles) ;
+#ifdef OPENMP_FOUND
+    #pragma omp parallel for schedule(dynamic)
+#endif
+    for (long_unsigned_int t = 0 ; t < number_tiles ; t++) {
+        try {
+            long_unsigned_int ix {t % tiles_x} ;
+            long_unsigned_int iy {t / tiles_x} ;
+            double tile_minx {minx + ix * tile_lx} ;
+            double tile_maxx {ix + 1 < tiles_x ? tile_minx + tile_lx : maxx} ;
+            double tile_miny {miny + iy * tile_ly} ;
+            double tile_maxy {iy + 1 < tiles_y ? tile_miny + tile_ly : maxy} ;
+            if (ix > 0)
+                tile_minx += guard ;
+            if (ix + 1 < tiles_x)
+                tile_maxx -= guard ;
+            if (iy > 0)
+                tile_miny += guard ;
+            if (iy + 1 < tiles_y)
+                tile_maxy -= guard ;
+            long_unsigned_int tile_total {number_total * (t + 1) / number_tiles -
+                                          number_total * t / number_tiles} ;
+            long_unsigned_int tile_random {
+                number_random * (t + 1) / number_tiles -
+                number_random * t / number_tiles} ;
+            if (tile_total == 0)
+                continue ;
+            Counter_random generator (time_seed, t, pass) ;
+            sphere_grid grid (diametre, minx, miny) ;
+            std::vector<hard_sphere> &s = tile_spheres[t] ;
+            if (tile_random == 0) {
+                hard_sphere centre ((tile_minx + tile_maxx) / 2.0,
+                                    (tile_miny + tile_maxy) / 2.0, false) ;
+                s. push_back (centre) ;
+                grid. insert (centre, 0) ;
+                tile_open[t]. push_back (0) ;
+            }
+            else
+                nucleate (s, grid, tile_open[t], tile_random, tile_minx,
+                          tile_miny, tile_maxx, tile_maxy, generator,
+                          tile_rejections[t]) ;
+            grow (s, grid, tile_open[t], tile_full[t], tile_total, tile_minx,
+                  tile_miny, tile_maxx, tile_maxy, generator,
+                  tile_rejections[t]) ;
+        } catch (...) {
+            errors[t] = std::current_exception () ;
+        }
+    }
+    // the reference &e is used to avoid copy
+    for (auto &e: errors)
+        if (e)
+            std::rethrow_exception (e) ;
+
+    // The tiles are joined in their order. The spheres near an inner edge
+    // may have been stopped by the guard band, so they are open again.
+    long_unsigned_int n {0} ;
+    for (long_unsigned_int t = 0 ; t < number_tiles ; t++)
+        n += tile_spheres[t]. size () ;
+    spheres. reserve (n) ;
+    sphere_grid grid (diametre, minx, miny) ;
+    const double stitch_distance {2.0 * diametre} ;
+    auto near_edge = [stitch_distance] (const double x, const double min,
+                                        const double tile_l,
+                                        const long_unsigned_int tiles) {
+        // k is the nearest edge, 0 and tiles being the outer ones.
+        double k {std::round ((x - min) / tile_l)} ;
+        return (k >= 1) && (k <= tiles - 1) &&
+               (std::abs (x - (min + k * tile_l)) < stitch_distance) ;
+    } ;
+    for (long_unsigned_int t = 0 ; t < number_tiles ; t++) {
+        long_unsigned_int offset {spheres. size ()} ;
+        // the reference &s is used to avoid copy
+        for (auto &s: tile_spheres[t]) {
+            grid. insert (s, spheres. size ()) ;
+            spheres. push_back (s) ;
+        }
+        for (auto i: tile_open[t])
+            open_spheres. push_back (offset + i) ;
+        for (auto i: tile_full[t]) {
+            const hard_sphere &s = spheres[offset + i] ;
+            if (near_edge (s. x, minx, tile_lx, tiles_x) ||
+                near_edge (s. y, miny, tile_ly, tiles_y))
+                open_spheres. push_back (offset + i) ;
+            else
+                full_spheres. push_back (offset + i) ;
+        }
+        throughput_rejections += tile_rejections[t] ;
+        std::vector<hard_sphere> ().swap (tile_spheres[t]) ;
+    }
+    Counter_random generator (time_seed, number_tiles, pass) ;
+    grow (spheres, grid, open_spheres, full_spheres, number_total, minx, miny,
+          maxx, maxy, generator, throughput_rejections) ;
+}
+
+void dpps::Pattern_hard_sphere_random_packing::generate_packing () {
+    constexpr const static double minimum_tile_diametres {4.0} ;
+    std::chrono::steady_clock::time_point start {
+        std::chrono::steady_clock::now ()} ;
+    if (pattern_settings. number_total == 0)
+        return ;
+    if (pattern_settings. number_random > pattern_settings. number_total)
+        pattern_settings. number_random = pattern_settings. number_total ;
+    const double minx {pattern_settings. x0 - pattern_settings. lx / 2.0} ;
+    const double maxx {pattern_settings. x0 + pattern_settings. lx / 2.0} ;
+    const double miny {pattern_settings. y0 - pattern_settings. ly / 2.0} ;
+    const double maxy {pattern_settings. y0 + pattern_settings. ly / 2.0} ;
+    const double minimum_tile {
+        minimum_tile_diametres * pattern_settings. diametre} ;
+    long_unsigned_int tiles_x {std::max<long_unsigned_int> (1, std::min (
+        pattern_settings. tiles_x,
+        static_cast<long_unsigned_int> (pattern_settings. lx / minimum_tile)))} ;
+    long_unsigned_int tiles_y {std::max<long_unsigned_int> (1, std::min (
+        pattern_settings. tiles_y,
+        static_cast<long_unsigned_int> (pattern_settings. ly / minimum_tile)))} ;
+
+    // All the spheres are stored once in spheres, open_spheres and
+    // full_spheres only hold indices into it. The grid gives access to the
+    // neighbours of a position, so that the overlap test does not depend on
+    // the number of spheres already placed.
+    std::vector<hard_sphere> spheres ;
+    std::vector<long_unsigned_int> open_spheres, full_spheres ;
+    if ((tiles_x > 1) || (tiles_y > 1))
+        pack_tiles (spheres, open_spheres, full_spheres, tiles_x, tiles_y) ;
+    else {
+        sphere_grid grid (pattern_settings. diametre, minx, miny) ;
+        // s. diametre = pattern_settings. diametre ;
+        if (pattern_settings. number_random == 0) {
+            hard_sphere s ;
+            spheres. push_back (s) ;
+            grid. insert (s, 0) ;
+            open_spheres. push_back (0) ;
+        }
+        else
+            nucleate (spheres, grid, open_spheres,
+                      pattern_settings. number_random, minx, miny, maxx, maxy,
+                      pseudorandom_generator, throughput_rejections) ;
+        grow (spheres, grid, open_spheres, full_spheres,
+              pattern_settings. number_total, minx, miny, maxx, maxy,
+              pseudorandom_generator, throughput_rejections) ;
+    }
     // To perform just one iteration, we will join the two vectors.
     // NOTE: gcc allows cbegin() and cend() here, but clang does not.
     full_spheres. insert (full_spheres. end (), open_spheres. begin (),
         open_spheres. end ()) ;
     // the reference &i is used to avoid copy
+    polylines. reserve (polylines. size () + full_spheres. size ()) ;
     Polyline q ;
     q. dose = pattern_settings. diametre / 2.0 ;
     for (auto &i: full_spheres) {
-        q. push_back (Vertex (i. x, i. y)) ;
+        q. push_back (Vertex (spheres[i]. x, spheres[i]. y)) ;
         polylines. push_back (q) ;
         q. vertices. clear () ;
     }
+    throughput_spheres = full_spheres. size () ;
+    throughput_duration = std::chrono::duration<double> (
+        std::chrono::steady_clock::now () - start). count () ;
+    if (pattern_settings. report_throughput)
+        std::cout << get_throughput_string () << std::endl ;
 }
-
@@ -14,6 +14,9 @@
 #ifndef DPPS_PATTERN_HARD_SPHERE_RANDOM_PACKING
 #define DPPS_PATTERN_HARD_SPHERE_RANDOM_PACKING
 
+#include <unordered_map>
+#include <vector>
+
 #include "Pattern.hh"
 
 namespace dpps {
@@ -75,6 +78,20 @@ protected:
          * of spheres too close from each other.
          */
         long_unsigned_int number_random {0} ;
+
+        /** @brief whether generate() reports its throughput on standard output.
+         *
+         * When set, the number of spheres placed per second and the average
+         * number of rejected positions per placed sphere are displayed at the
+         * end of generate(). Values are also kept and available through
+         * get_throughput_string(). */
+        bool report_throughput {false} ;
+
+        /** @brief the number of tiles along x and y packed in parallel, see
+         * set_tiles(). With one tile, the whole surface grows from the same
+         * spheres. */
+        long_unsigned_int tiles_x {1} ;
+        long_unsigned_int tiles_y {1} ;
     } ;
 
     /** @brief A class to encapsulate a monoatomic position. It is used during
@@ -126,9 +143,96 @@ protected:
          */
         double squared_distance (const hard_sphere &s) const ;
     };
+
+    /** @brief A uniform grid used to find the neighbours of a position.
+     *
+     * The plane is divided into square cells whose side is the diametre of
+     * the spheres, and each cell records the indices of the spheres whose
+     * centre lies inside. Two spheres closer than one diametre are always
+     * in the same cell or in adjacent cells, so that an overlap test only
+     * needs to look at the 3×3 cells around the candidate position, instead
+     * of all the spheres already placed.
+     *
+     * Cells are stored in a hash table, so that only non-empty cells use
+     * memory, whatever the size of the pattern compared to the diametre.
+     */
+    class sphere_grid {
+    protected:
+        double cell_size {1.0} ;
+        double x_origin {0.0} ;
+        double y_origin {0.0} ;
+        std::unordered_map<long_unsigned_int,
+                           std::vector<long_unsigned_int>> cells ;
+        void get_cell (long signed int &i, long signed int &j,
+                       const double x, const double y) const ;
+        static long_unsigned_int cell_key (const long signed int i,
+                                           const long signed int j) ;
+    public:
+        /** @brief constructor setting the cell size and the position of the
+         * corner of cell (0, 0). */
+        sphere_grid (const double set_cell_size, const double x0,
+                     const double y0) ;
+
+        /** @brief records that sphere of index n is located at s. */
+        void insert (const hard_sphere &s, const long_unsigned_int n) ;
+
+        /** @brief returns true if a sphere from spheres, other than the one of
+         * index excluded, is at a squared distance lower than squared_diametre
+         * from position s. */
+        bool overlaps (const hard_sphere &s,
+                       const std::vector<hard_sphere> &spheres,
+                       const double squared_diametre,
+                       const long_unsigned_int excluded) const ;
+    } ;
+
 protected:
     Pattern_hard_sphere_random_packing_settings pattern_settings ;
 
+    /** @brief number of spheres placed at the last call of generate() */
+    long_unsigned_int throughput_spheres {0} ;
+
+    /** @brief number of rejected positions at the last call of generate() */
+    long_unsigned_int throughput_rejections {0} ;
+
+    /** @brief duration in seconds of the last call of generate() */
+    double throughput_duration {0.0} ;
+
+    /** @brief places the spheres, see generate(), which may read them from
+     * Pattern_cache instead. */
+    void generate_packing () ;
+
+    /** @brief places up to number_random spheres at random positions in
+     * the rectangle, without overlap, as open spheres. */
+    template <class Generator>
+    void nucleate (std::vector<hard_sphere> &spheres, sphere_grid &grid,
+                   std::vector<long_unsigned_int> &open_spheres,
+                   const long_unsigned_int number_random,
+                   const double minx, const double miny,
+                   const double maxx, const double maxy,
+                   Generator &generator,
+                   long_unsigned_int &rejections) const ;
+
+    /** @brief adds spheres in contact with the open spheres, inside the
+     * rectangle, until spheres holds number_total spheres or none is open.
+     * The spheres which have no room left are moved to full_spheres. */
+    template <class Generator>
+    void grow (std::vector<hard_sphere> &spheres, sphere_grid &grid,
+               std::vector<long_unsigned_int> &open_spheres,
+               std::vector<long_unsigned_int> &full_spheres,
+               const long_unsigned_int number_total,
+               const double minx, const double miny,
+               const double maxx, const double maxy,
+               Generator &generator,
+               long_unsigned_int &rejections) const ;
+
+    /** @brief packs the tiles in parallel, then fills the space left between
+     * them, see set_tiles(). */
+    void pack_tiles (std::vector<hard_sphere> &spheres,
+                     std::vector<long_unsigned_int> &open_spheres,
+                     std::vector<long_unsigned_int> &full_spheres,
+                     const long_unsigned_int tiles_x,
+                     const long_unsigned_int tiles_y) ;
+
 public:
     /** @brief the default constructor */
     Pattern_hard_sphere_random_packing () ;
@@ -168,6 +272,38 @@ public:
         const double lx,
         const double ly,
         const double diametre) ;
+
+    /** @brief Sets whether generate() displays its throughput.
+     *
+     * See Pattern_hard_sphere_random_packing_settings::report_throughput.
+     */
+    void set_report_throughput (const bool report_throughput) ;
+
+    /** @brief Sets the number of tiles along x and y, which are packed in
+     * parallel.
+     *
+     * The surface is divided into tiles_x × tiles_y tiles, each one grown
+     * from its own nucleation centres (its share of number_random, or its
+     * centre if number_random is 0) with its own stream of random numbers,
+     * until it holds its share of number_total or is full. A guard band of
+     * half a diametre along the inner edges of each tile keeps the spheres
+     * of two tiles apart, and a last pass, on one thread, grows the spheres
+     * along the edges into the gaps between the tiles, until number_total
+     * spheres are placed.
+     *
+     * The result does not depend on the number of threads, but it differs
+     * from the one of a single tile: it is meant for surfaces which are
+     * filled, when number_total is larger than the number of spheres that
+     * fit. Tiles are not made smaller than four diametres, their number is
+     * reduced if needed. The default is one tile.
+     */
+    void set_tiles (const long_unsigned_int tiles_x,
+                    const long_unsigned_int tiles_y) ;
+
+    /** @brief Returns a description of the throughput of the last call of
+     * generate(): number of spheres placed, duration, spheres placed per
+     * second and rejected positions per sphere. */
+    std::string get_throughput_string () const ;
 } ;
 } // namespace dpps
 #endif
@@ -0,0 +1,456 @@
+/**
+ * @file Pattern_packed.cpp
+ * @author Jérôme Borme <jerome.borme@inl.int>
+ * @version 1.0
+ * @brief Implementation of class Pattern_packed
+ * @date 2026-10-14 Jérôme Borme: Initial version
+ * @copyright
+ * This Source Code Form is subject to the terms of the Mozilla Public
+ * License, v. 2.0. If a copy of the MPL was not distributed with this
+ * file, You can obtain one at http://mozilla.org/MPL/2.0/.
+ */
+
+#include <cmath>
+#include <limits>
+#include <algorithm>
+
+#include "Pattern_packed.hh"
+
+dpps::Pattern_packed::Pattern_packed () {
+}
+
+dpps::Pattern_packed::Pattern_packed (const Pattern &p) {
+    assign (p) ;
+}
+
+bool dpps::Pattern_packed::is_selected (const long_unsigned_int i,
+                                        const selection_t selection) const {
+    if (selection < 0)
+        return true ;
+    return (selection_words[selection][i / 64] >> (i % 64)) & 1 ;
+}
+
+void dpps::Pattern_packed::set_selected (const long_unsigned_int i,
+                                         const selection_t selection,
+                                         const bool value) {
+    if (value)
+        selection_words[selection][i / 64] |= (uint64_t {1} << (i % 64)) ;
+    else
+        selection_words[selection][i / 64] &= ~(uint64_t {1} << (i % 64)) ;
+}
+
+void dpps::Pattern_packed::clear () {
+    x. clear () ;
+    y. clear () ;
+    offsets. assign (1, 0) ;
+    closed. clear () ;
+    dose. clear () ;
+    reference. clear () ;
+    for (auto &w: selection_words)
+        w. clear () ;
+}
+
+void dpps::Pattern_packed::reserve (const long_unsigned_int number_polylines,
+                                    const long_unsigned_int number_vertices) {
+    x. reserve (number_vertices) ;
+    y. reserve (number_vertices) ;
+    offsets. reserve (number_polylines + 1) ;
+    closed. reserve (number_polylines) ;
+    dose. reserve (number_polylines) ;
+    reference. reserve (number_polylines) ;
+    for (auto &w: selection_words)
+        w. reserve (number_polylines / 64 + 1) ;
+}
+
+void dpps::Pattern_packed::assign (const Pattern &p) {
+    clear () ;
+    reserve (p. polylines. size (), p. vertices_size (-1)) ;
+    // the reference &q is used to avoid copy
+    for (auto &q: p. polylines)
+        push_back (q) ;
+}
+
+void dpps::Pattern_packed::push_back (const Polyline &p) {
+    long_unsigned_int n {dose. size ()} ;
+    // the reference &v is used to avoid copy
+    for (auto &v: p. vertices) {
+        x. push_back (v. x) ;
+        y. push_back (v. y) ;
+    }
+    offsets. push_back (x. size ()) ;
+    closed. push_back (p. closed) ;
+    dose. push_back (p. dose) ;
+    reference. push_back (p. reference) ;
+    if (n % 64 == 0)
+        for (auto &w: selection_words)
+            w. push_back (0) ;
+    for (selection_t s {0} ; s < polyline_max_selection ; s++)
+        if (p. selected[s])
+            set_selected (n, s, true) ;
+}
+
+dpps::Polyline dpps::Pattern_packed::get_polyline (
+    const long_unsigned_int i) const {
+    Polyline result ;
+    result. vertices. reserve (polyline_size (i)) ;
+    for (long_unsigned_int j {offsets[i]} ; j < offsets[i+1] ; j++)
+        result. vertices. push_back (Vertex (x[j], y[j])) ;
+    result. closed = closed[i] ;
+    result. dose = dose[i] ;
+    result. reference = reference[i] ;
+    for (selection_t s {0} ; s < polyline_max_selection ; s++)
+        result. selected[s] = is_selected (i, s) ;
+    return result ;
+}
+
+dpps::Pattern dpps::Pattern_packed::to_Pattern (
+    const selection_t selection) const {
+check_selection_not_too_high(selection) ;
+    Pattern result ;
+    result. polylines. reserve (size (selection)) ;
+    for_each_selected_index (selection, [&] (const long_unsigned_int i) {
+        result. polylines. push_back (get_polyline (i)) ;
+    }) ;
+    return result ;
+}
+
+long_unsigned_int dpps::Pattern_packed::size (
+    const selection_t selection) const {
+check_selection_not_too_high(selection) ;
+    if (selection < 0)
+        return dose. size () ;
+    long_unsigned_int n {0} ;
+    for (auto w: selection_words[selection])
+        n += __builtin_popcountll (w) ;
+    return n ;
+}
+
+long_unsigned_int dpps::Pattern_packed::polyline_size (
+    const long_unsigned_int i) const {
+    return offsets[i+1] - offsets[i] ;
+}
+
+long_unsigned_int dpps::Pattern_packed::vertices_size (
+    const selection_t selection) const {
+check_selection_not_too_high(selection) ;
+    if (selection < 0)
+        return x. size () ;
+    long_unsigned_int n {0} ;
+    for_each_selected_index (selection, [&] (const long_unsigned_int i) {
+        n += polyline_size (i) ;
+    }) ;
+    return n ;
+}
+
+void dpps::Pattern_packed::select (const enum_logical_action action,
+                                   const selection_t selection) {
+check_selection_not_negative_not_too_high(selection) ;
+    std::vector<uint64_t> &words {selection_words[selection]} ;
+    switch (action) {
+        case logical_action_all:
+            std::fill (words. begin (), words. end (), ~uint64_t {0}) ;
+            break ;
+        case logical_action_none:
+            std::fill (words. begin (), words. end (), uint64_t {0}) ;
+            break ;
+        case logical_action_toggle:
+            for (auto &w: words)
+                w = ~w ;
+            break ;
+    }
+    clear_trailing_bits (selection) ;
+}
+
+void dpps::Pattern_packed::clear_trailing_bits (const selection_t selection) {
+    std::vector<uint64_t> &words {selection_words[selection]} ;
+    // bits beyond the last polyline are kept to zero so that size() can
+    // count whole words.
+    if ((dose. size () % 64 != 0) && (words. size () > 0))
+        words. back () &= (uint64_t {1} << (dose. size () % 64)) - 1 ;
+}
+
+void dpps::Pattern_packed::selection_logical_operation (
+                  const selection_t destination_selection,
+                  const selection_t selection_p,
+                  const selection_t selection_q,
+                  const enum_logical_operator logical_operator) {
+check_selection_not_negative_not_too_high(selection_p) ;
+check_selection_not_negative_not_too_high(selection_q) ;
+check_selection_not_negative_not_too_high(destination_selection) ;
+    // The truth table of the operator, as masks of 64 bits, so that any of
+    // the operators is a combination of whole words. Index is 2*p+q.
+    std::array<uint64_t, 4> truth_table ;
+    for (unsigned short int k {0} ; k < 4 ; k++)
+        truth_table[k] = logical_operation (k >= 2, k % 2 == 1,
+                                            logical_operator) ?
+                         ~uint64_t {0} : uint64_t {0} ;
+    const std::vector<uint64_t> &words_p {selection_words[selection_p]} ;
+    const std::vector<uint64_t> &words_q {selection_words[selection_q]} ;
+    std::vector<uint64_t> &destination {selection_words[destination_selection]} ;
+    // destination may be one of p and q, each word is read before it is
+    // written.
+    for (long_unsigned_int k {0} ; k < destination. size () ; k++) {
+        uint64_t p {words_p[k]}, q {words_q[k]} ;
+        destination[k] = (truth_table[0] & ~p & ~q) |
+                         (truth_table[1] & ~p &  q) |
+                         (truth_table[2] &  p & ~q) |
+                         (truth_table[3] &  p &  q) ;
+    }
+    clear_trailing_bits (destination_selection) ;
+}
+
+void dpps::Pattern_packed::selection_swap (const selection_t selection_p,
+                                           const selection_t selection_q) {
+check_selection_not_negative_not_too_high(selection_p) ;
+check_selection_not_negative_not_too_high(selection_q) ;
+    selection_words[selection_p]. swap (selection_words[selection_q]) ;
+}
+
+void dpps::Pattern_packed::polyline_limits (const long_unsigned_int i,
+    double &minx, double &miny, double &maxx, double &maxy) const {
+    if (polyline_size (i) == 0)
+        return ;
+    minx = std::numeric_limits<double>::max () ;
+    maxx = std::numeric_limits<double>::lowest () ;
+    miny = std::numeric_limits<double>::max () ;
+    maxy = std::numeric_limits<double>::lowest () ;
+    for (long_unsigned_int j {offsets[i]} ; j < offsets[i+1] ; j++) {
+        if (x[j] < minx)
+            minx = x[j] ;
+        if (x[j] > maxx)
+            maxx = x[j] ;
+        if (y[j] < miny)
+            miny = y[j] ;
+        if (y[j] > maxy)
+            maxy = y[j] ;
+    }
+}
+
+void dpps::Pattern_packed::select_window (const double xmin, const double ymin,
+                        const double xmax, const double ymax,
+                        const bool dots_as_circles,
+                        const selection_t selection) {
+check_selection_not_negative_not_too_high(selection) ;
+    double temp_min_x {0.0} ;
+    double temp_min_y {0.0} ;
+    double temp_max_x {0.0} ;
+    double temp_max_y {0.0} ;
+    for (long_unsigned_int i {0} ; i < dose. size () ; i++) {
+        if (dots_as_circles && (polyline_size (i) == 1)) {
+            long_unsigned_int j {offsets[i]} ;
+            temp_min_x = x[j] - dose[i] ;
+            temp_min_y = y[j] - dose[i] ;
+            temp_max_x = x[j] + dose[i] ;
+            temp_max_y = y[j] + dose[i] ;
+        } else
+            polyline_limits (i, temp_min_x, temp_min_y, temp_max_x, temp_max_y) ;
+        if ((temp_min_x >= xmin) && (temp_min_x <= xmax) &&
+            (temp_min_y >= ymin) && (temp_min_y <= ymax) &&
+            (temp_max_x >= xmin) && (temp_max_x <= xmax) &&
+            (temp_max_y >= ymin) && (temp_max_y <= ymax))
+            set_selected (i, selection, true) ;
+    }
+}
+
+DPPS_MULTIVERSION
+void dpps::Pattern_packed::translate (const double x0, const double y0,
+                                      const selection_t selection) {
+check_selection_not_too_high(selection) ;
+    if (selection < 0) {
+        for (auto &v: x)
+            v += x0 ;
+        for (auto &v: y)
+            v += y0 ;
+        return ;
+    }
+    for (long_unsigned_int i {0} ; i < dose. size () ; i++)
+        if (is_selected (i, selection))
+            for (long_unsigned_int j {offsets[i]} ; j < offsets[i+1] ; j++) {
+                x[j] += x0 ;
+                y[j] += y0 ;
+            }
+}
+
+DPPS_MULTIVERSION
+void dpps::Pattern_packed::scale (const double x0, const double y0,
+                                  const double fx, const double fy,
+                                  const selection_t selection) {
+check_selection_not_too_high(selection) ;
+    for (long_unsigned_int i {0} ; i < dose. size () ; i++)
+        if (is_selected (i, selection))
+            for (long_unsigned_int j {offsets[i]} ; j < offsets[i+1] ; j++) {
+                x[j] = x0 + fx * (x[j] - x0) ;
+                y[j] = y0 + fy * (y[j] - y0) ;
+            }
+}
+
+DPPS_MULTIVERSION
+void dpps::Pattern_packed::rotate (const double x0, const double y0,
+                                   const double angle,
+                                   const selection_t selection) {
+check_selection_not_too_high(selection) ;
+    double cos_angle {cos (angle)},
+           sin_angle {sin (angle)} ;
+    for (long_unsigned_int i {0} ; i < dose. size () ; i++)
+        if (is_selected (i, selection))
+            for (long_unsigned_int j {offsets[i]} ; j < offsets[i+1] ; j++) {
+                double x1 {x[j] - x0} ;
+                double y1 {y[j] - y0} ;
+                x[j] = x1 * cos_angle - y1 * sin_angle + x0 ;
+                y[j] = x1 * sin_angle + y1 * cos_angle + y0 ;
+            }
+}
+
+#ifdef GSL_FOUND
+void dpps::Pattern_packed::apply_matrix (const Matrix3x3 &matrix,
+                                         const selection_t selection) {
+check_selection_not_too_high(selection) ;
+    if (selection < 0) {
+        matrix. apply (x. data (), y. data (), x. size ()) ;
+        return ;
+    }
+    for_each_selected_index (selection, [&] (const long_unsigned_int i) {
+        matrix. apply (x. data () + offsets[i], y. data () + offsets[i],
+                       offsets[i+1] - offsets[i]) ;
+    }) ;
+}
+
+void dpps::Pattern_packed::apply_homography (const Matrix3x3 &matrix,
+                                             const selection_t selection) {
+check_selection_not_too_high(selection) ;
+    if (selection < 0) {
+        matrix. apply_homography (x. data (), y. data (), x. size ()) ;
+        return ;
+    }
+    for_each_selected_index (selection, [&] (const long_unsigned_int i) {
+        matrix. apply_homography (x. data () + offsets[i],
+                                  y. data () + offsets[i],
+                                  offsets[i+1] - offsets[i]) ;
+    }) ;
+}
+#endif
+
+void dpps::Pattern_packed::set_dose (const double dose_value,
+                                     const selection_t selection) {
+check_selection_not_too_high(selection) ;
+    for_each_selected_index (selection, [&] (const long_unsigned_int i) {
+        dose[i] = dose_value ;
+    }) ;
+}
+
+double dpps::Pattern_packed::polyline_algebraic_area (
+    const long_unsigned_int i) const {
+    // Same formula as Polyline::algebraic_area()
+    long_unsigned_int begin {offsets[i]},
+                      end {offsets[i+1]} ;
+    if (end - begin <= 2)
+        return 0.0 ;
+    double s {0.0},
+           t {0.0} ;
+    for (long_unsigned_int j {begin} ; j < end - 1 ; j++) {
+        s += x[j] * y[j+1] ;
+        t += y[j] * x[j+1] ;
+    }
+    s += x[end-1] * y[begin] ;
+    t += y[end-1] * x[begin] ;
+    return ((s-t)/2.0) ;
+}
+
+double dpps::Pattern_packed::polyline_length (const long_unsigned_int i) const {
+    long_unsigned_int begin {offsets[i]},
+                      end {offsets[i+1]} ;
+    if (end - begin <= 1)
+        return 0.0 ;
+    double s {0.0} ;
+    for (long_unsigned_int j {begin} ; j < end - 1 ; j++) {
+        double dx {x[j+1] - x[j]} ;
+        double dy {y[j+1] - y[j]} ;
+        s += sqrt (dx*dx + dy*dy) ;
+    }
+    return s ;
+}
+
+double dpps::Pattern_packed::polyline_perimeter (
+    const long_unsigned_int i) const {
+    long_unsigned_int begin {offsets[i]},
+                      end {offsets[i+1]} ;
+    if (end - begin <= 1)
+        return 0.0 ;
+    double dx {x[begin] - x[end-1]} ;
+    double dy {y[begin] - y[end-1]} ;
+    return polyline_length (i) + sqrt (dx*dx + dy*dy) ;
+}
+
+double dpps::Pattern_packed::area (const selection_t selection) const {
+check_selection_not_too_high(selection) ;
+    double result {0.0} ;
+    for_each_selected_index (selection, [&] (const long_unsigned_int i) {
+        result += fabs (polyline_algebraic_area (i)) ;
+    }) ;
+    return result ;
+}
+
+double dpps::Pattern_packed::algebraic_area (const selection_t selection) const {
+check_selection_not_too_high(selection) ;
+    double result {0.0} ;
+    for_each_selected_index (selection, [&] (const long_unsigned_int i) {
+        result += polyline_algebraic_area (i) ;
+    }) ;
+    return result ;
+}
+
+double dpps::Pattern_packed::perimeter (const selection_t selection) const {
+check_selection_not_too_high(selection) ;
+    double result {0.0} ;
+    for_each_selected_index (selection, [&] (const long_unsigned_int i) {
+        result += polyline_perimeter (i) ;
+    }) ;
+    return result ;
+}
+
+double dpps::Pattern_packed::length (const selection_t selection) const {
+check_selection_not_too_high(selection) ;
+    double result {0.0} ;
+    for_each_selected_index (selection, [&] (const long_unsigned_int i) {
+        result += polyline_length (i) ;
+    }) ;
+    return result ;
+}
+
+dpps::Vertex dpps::Pattern_packed::lower_left (
+    const selection_t selection) const {
+check_selection_not_too_high(selection) ;
+    double minx {std::numeric_limits<double>::max ()} ;
+    double miny {std::numeric_limits<double>::max ()} ;
+    bool done {false} ;
+    for_each_selected_index (selection, [&] (const long_unsigned_int i) {
+        for (long_unsigned_int j {offsets[i]} ; j < offsets[i+1] ; j++) {
+            done = true ;
+            minx = std::min (minx, x[j]) ;
+            miny = std::min (miny, y[j]) ;
+        }
+    }) ;
+    if (done)
+        return Vertex (minx, miny) ;
+    else
+        return Vertex (0.0, 0.0) ;
+}
+
+dpps::Vertex dpps::Pattern_packed::upper_right (
+    const selection_t selection) const {
+check_selection_not_too_high(selection) ;
+    double maxx {std::numeric_limits<double>::lowest ()} ;
+    double maxy {std::numeric_limits<double>::lowest ()} ;
+    bool done {false} ;
+    for_each_selected_index (selection, [&] (const long_unsigned_int i) {
+        for (long_unsigned_int j {offsets[i]} ; j < offsets[i+1] ; j++) {
+            done = true ;
+            maxx = std::max (maxx, x[j]) ;
+            maxy = std::max (maxy, y[j]) ;
+        }
+    }) ;
+    if (done)
+        return Vertex (maxx, maxy) ;
+    else
+        return Vertex (0.0, 0.0) ;
+}
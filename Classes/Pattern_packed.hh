@@ -0,0 +1,233 @@
+/**
+ * @file Pattern_packed.hh
+ * @author Jérôme Borme <jerome.borme@inl.int>
+ * @version 1.0
+ * @brief Header file for class Pattern_packed, a compact storage of polylines
+ * @date 2026-10-14 Jérôme Borme: Initial version
+ * @copyright
+ * This Source Code Form is subject to the terms of the Mozilla Public
+ * License, v. 2.0. If a copy of the MPL was not distributed with this
+ * file, You can obtain one at http://mozilla.org/MPL/2.0/.
+ */
+#ifndef DPPS_PATTERN_PACKED
+#define DPPS_PATTERN_PACKED
+
+#include <vector>
+#include <array>
+#include <cstdint>
+#include <limits>
+
+#include "common.hh"
+#include "util.hh"
+#include "Vertex.hh"
+#include "Polyline.hh"
+#include "Pattern.hh"
+
+namespace dpps {
+/** @brief A Pattern stored as a structure of arrays.
+ *
+ * A Pattern holds a vector of Polyline, each of which owns its own vector of
+ * vertices. For patterns made of millions of polylines with few vertices
+ * (lattices of dots, gratings), this means millions of small allocations
+ * and poor memory locality.
+ *
+ * Pattern_packed stores the same information in a few contiguous arrays:
+ * * the coordinates of all the vertices, in x and y;
+ * * for each polyline, the position of its first vertex in x and y, in
+ *   offsets, which has one more element than the number of polylines so that
+ *   polyline i has the vertices from offsets[i] to offsets[i+1]-1;
+ * * one column for each property of the polylines: closed, dose, reference;
+ * * for each selection register, a bitmap of the selected polylines packed
+ *   in 64-bit words.
+ *
+ * The geometrical transformations, the selection by window and the
+ * measurements work directly on these arrays, with the same meaning as their
+ * counterparts in Pattern. A Pattern_packed can be converted from and to a
+ * Pattern for all other operations, or for writing.
+ */
+class Pattern_packed {
+    // They read and write the selection bitmaps directly.
+    friend class Writer_dpps ;
+    friend class Reader_dpps ;
+protected:
+    /** @brief selection bitmaps, one per selection register, with bit i%64
+     * of word i/64 for polyline i. */
+    std::array<std::vector<uint64_t>, polyline_max_selection> selection_words ;
+
+    /** @brief whether polyline i belongs to selection, or true if selection
+     * is negative. */
+    bool is_selected (const long_unsigned_int i,
+                      const selection_t selection) const ;
+
+    /** @brief sets whether polyline i belongs to selection. */
+    void set_selected (const long_unsigned_int i,
+                       const selection_t selection,
+                       const bool value) ;
+
+    /** @brief sets to zero the bits of selection beyond the last polyline,
+     * so that the bitmaps can be counted and combined by whole words. */
+    void clear_trailing_bits (const selection_t selection) ;
+
+    /** @brief calls f (i) for each polyline i of selection, in their order,
+     * skipping the words of the bitmap where none is selected. */
+    template <typename Function>
+    void for_each_selected_index (const selection_t selection,
+                                  Function f) const {
+        long_unsigned_int n {dose. size ()} ;
+        if (selection < 0) {
+            for (long_unsigned_int i {0} ; i < n ; i++)
+                f (i) ;
+            return ;
+        }
+        const std::vector<uint64_t> &words = selection_words[selection] ;
+        for (long_unsigned_int k {0} ; k < words. size () ; k++)
+            for (uint64_t w {words[k]} ; w != 0 ; w &= w - 1) {
+                long_unsigned_int i {64 * k + __builtin_ctzll (w)} ;
+                if (i >= n)
+                    return ;
+                f (i) ;
+            }
+    }
+public:
+    /** @brief x coordinates of all the vertices. */
+    std::vector<double> x ;
+
+    /** @brief y coordinates of all the vertices. */
+    std::vector<double> y ;
+
+    /** @brief position in x and y of the first vertex of each polyline, plus
+     * the total number of vertices as last element. */
+    std::vector<long_unsigned_int> offsets {0} ;
+
+    /** @brief Polyline::closed of each polyline. */
+    std::vector<bool> closed ;
+
+    /** @brief Polyline::dose of each polyline. */
+    std::vector<double> dose ;
+
+    /** @brief Polyline::reference of each polyline. */
+    std::vector<long_unsigned_int> reference ;
+
+    /** @brief the default constructor, creates an empty Pattern_packed. */
+    Pattern_packed () ;
+
+    /** @brief creates a Pattern_packed with the polylines of p, including
+     * their selections. */
+    Pattern_packed (const Pattern &p) ;
+
+    /** @brief replaces the contents by the polylines of p. */
+    void assign (const Pattern &p) ;
+
+    /** @brief returns a Pattern with the selected polylines. */
+    Pattern to_Pattern (const selection_t selection = -1) const ;
+
+    /** @brief removes all the polylines. */
+    void clear () ;
+
+    /** @brief preallocates memory for number_polylines polylines having
+     * number_vertices vertices in total. */
+    void reserve (const long_unsigned_int number_polylines,
+                  const long_unsigned_int number_vertices) ;
+
+    /** @brief adds a polyline at the end, with its selections. */
+    void push_back (const Polyline &p) ;
+
+    /** @brief returns polyline number i as a Polyline object. */
+    Polyline get_polyline (const long_unsigned_int i) const ;
+
+    /** @brief number of selected polylines. */
+    long_unsigned_int size (const selection_t selection = -1) const ;
+
+    /** @brief number of vertices in the selected polylines. */
+    long_unsigned_int vertices_size (const selection_t selection = -1) const ;
+
+    /** @brief number of vertices of polyline i. */
+    long_unsigned_int polyline_size (const long_unsigned_int i) const ;
+
+    /** @brief see Pattern::select(). */
+    void select (const enum_logical_action action,
+                 const selection_t selection) ;
+
+    /** @brief see Pattern::selection_logical_operation(). The registers are
+     * combined 64 polylines at a time. */
+    void selection_logical_operation (
+                  const selection_t destination_selection,
+                  const selection_t selection_p,
+                  const selection_t selection_q,
+                  const enum_logical_operator logical_operator) ;
+
+    /** @brief see Pattern::selection_swap(). The bitmaps are exchanged
+     * without going through the polylines. */
+    void selection_swap (const selection_t selection_p,
+                         const selection_t selection_q) ;
+
+    /** @brief see Pattern::select_window(). */
+    void select_window (const double xmin, const double ymin,
+                        const double xmax, const double ymax,
+                        const bool dots_as_circles = true,
+                        const selection_t selection = 0) ;
+
+    /** @brief see Pattern::translate(). */
+    void translate (const double x0, const double y0,
+                    const selection_t selection = -1) ;
+
+    /** @brief see Pattern::scale(). */
+    void scale (const double x0, const double y0,
+                const double fx, const double fy,
+                const selection_t selection = -1) ;
+
+    /** @brief see Pattern::rotate(). */
+    void rotate (const double x0, const double y0, const double angle,
+                 const selection_t selection = -1) ;
+
+#ifdef GSL_FOUND
+    /** @brief see Pattern::apply_matrix(). Without selection, all the
+     * coordinates are transformed in one loop. */
+    void apply_matrix (const Matrix3x3 &matrix,
+                       const selection_t selection = -1) ;
+
+    /** @brief see Pattern::apply_homography(). */
+    void apply_homography (const Matrix3x3 &matrix,
+                           const selection_t selection = -1) ;
+#endif
+
+    /** @brief see Pattern::set_dose(). */
+    void set_dose (const double dose_value, const selection_t selection = -1) ;
+
+    /** @brief see Pattern::area(). */
+    double area (const selection_t selection = -1) const ;
+
+    /** @brief see Pattern::algebraic_area(). */
+    double algebraic_area (const selection_t selection = -1) const ;
+
+    /** @brief see Pattern::perimeter(). */
+    double perimeter (const selection_t selection = -1) const ;
+
+    /** @brief see Pattern::length(). */
+    double length (const selection_t selection = -1) const ;
+
+    /** @brief see Pattern::lower_left(). */
+    Vertex lower_left (const selection_t selection = -1) const ;
+
+    /** @brief see Pattern::upper_right(). */
+    Vertex upper_right (const selection_t selection = -1) const ;
+
+    /** @brief returns the algebraic area of polyline i, see
+     * Polyline::algebraic_area(). */
+    double polyline_algebraic_area (const long_unsigned_int i) const ;
+
+    /** @brief returns the length of polyline i, see Polyline::length(). */
+    double polyline_length (const long_unsigned_int i) const ;
+
+    /** @brief returns the perimeter of polyline i, see
+     * Polyline::perimeter(). */
+    double polyline_perimeter (const long_unsigned_int i) const ;
+
+    /** @brief sets minx to maxy to the bounding box of polyline i. Nothing is
+     * done if polyline i has no vertex. */
+    void polyline_limits (const long_unsigned_int i,
+                          double &minx, double &miny,
+                          double &maxx, double &maxy) const ;
+} ;
+} // namespace dpps
+#endif
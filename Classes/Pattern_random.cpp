@@ -12,9 +12,12 @@
  */
 
 #include <limits>
+#include <algorithm>
+#include <cmath>
 //#include <iostream>
 
 #include "Pattern_random.hh"
+#include "Counter_random.hh"
 #include "bad_parametre.hh"
 
 dpps::Pattern_random::Pattern_random (): Pattern () {
@@ -100,9 +103,9 @@ void dpps::Pattern_random::set_parametres (
             1, 3, 7, 0,
             vbool. size (), vint. size (), vdouble. size (), vstring. size ()) ;
     }
-    if (vint[0] >= 10) {
+    if (vint[0] >= 11) {
         std::string reason {"Pattern_random::set_parametres, parametre called \
-type is an enum which is valued 0-9, got " + std::to_string (vint[0])} ;
+type is an enum which is valued 0-10, got " + std::to_string (vint[0])} ;
         throw bad_parametre (reason. c_str ()) ;
     }
     set_all_parametres (static_cast<enum_distribution> (vint[0]),
@@ -111,15 +114,30 @@ type is an enum which is valued 0-9, got " + std::to_string (vint[0])} ;
 }
 
 void dpps::Pattern_random::generate () {
-    // We have do declare them all. We cannot do a switch of if,
-    // because distributions would get out of scope.
-    // The only other possibility would be to place the switch inside
-    // the loop, but it would be very inefficient to call the constructor
-    // everytime.
-    // So we have to pay for overhead and initialize them all in te beginning.
-    // It's probably a negligible amount of time and memory as compared to the
-    // loop.
+    generate_each ([this] (const Polyline &p) {
+        polylines. push_back (p) ;
+    }) ;
+}
 
+void dpps::Pattern_random::generate_each (
+    const std::function<void (const Polyline &)> &function) {
+    if (pattern_settings. max_attempts < pattern_settings. number)
+        pattern_settings. max_attempts =
+            std::numeric_limits<long_unsigned_int>::max () ;
+    if (pattern_settings. type == type_Poisson_disk_distribution) {
+        if (counter_based_random) {
+            uint32_t pass {static_cast<uint32_t> (counter_based_passes++)} ;
+            Counter_random generator (time_seed, 0, pass) ;
+            generate_Poisson_disk (generator, function) ;
+        }
+        else
+            generate_Poisson_disk (pseudorandom_generator, function) ;
+        return ;
+    }
+    if (counter_based_random) {
+        generate_counter_based (function) ;
+        return ;
+    }
     // signification of parametres depends on the engine. Some engines
     // need only one parametre.
     // For all user-changeable values (p1 and p2), 1.0 would have been the
@@ -127,101 +145,217 @@ void dpps::Pattern_random::generate () {
     // user as well.
     const double p1 {pattern_settings. p1} ;
     const double p2 {pattern_settings. p2} ;
-
-    std::uniform_real_distribution<double> d0 (-p1, p1) ; // min, max
-    // Normal-type
-    std::normal_distribution<double> d1 (0.0, p1) ;    // average = 0, sigma
-    std::lognormal_distribution<double> d2 (0.0, p1) ; // average = 0, m
-    std::chi_squared_distribution<double> d3 (p1) ;    // n
-    std::cauchy_distribution<double> d4 (p1, p2) ;     // a, b
-    std::fisher_f_distribution<double> d5 (p1, p2) ;   // m, n
-    std::student_t_distribution<double> d6 (p1) ;      // n
-    // Poisson-type
-    std::exponential_distribution<double> d7 (p1) ;    // lambda
-    std::gamma_distribution<double> d8 (p1, p2) ;      // alpha, beta
-    std::weibull_distribution<double> d9 (p1, p2) ;    // a, b
+    // uniform: min, max ; normal: average = 0, sigma ; lognormal: average = 0, m
+    Random_distributions distributions (p1, p2, -p1, p1, 0.0, p1) ;
 
     Polyline p ;
     p. closed = true ;
+    // The polylines already present are compared to, not the ones appended
+    // after them, which may not be kept.
+    long_unsigned_int first {polylines. size ()} ;
+    std::vector<Vertex> placed ;
     double x {0.0}, y {0.0} ;
     long_unsigned_int i {0}, attempts {0} ;
-    //const double s {pattern_settings. side / 2.0} ;
-    if (pattern_settings. max_attempts < pattern_settings. number)
-        pattern_settings. max_attempts =
-            std::numeric_limits<long_unsigned_int>::max () ;
-    //std::cout << "hello" << i << " " << pattern_settings. number << " " <<  attempts << " " << pattern_settings. max_attempts << std::endl ;
     while ((i < pattern_settings. number) &&
            (attempts < pattern_settings. max_attempts)) {
-        bool overlap = false ;
-        switch (pattern_settings. type) {
-            case type_uniform_real_distribution: // 0
-                x = d0 (pseudorandom_generator) ;
-                y = d0 (pseudorandom_generator) ;
-                //std::cout << "alea 0 : " << x << " " << y << std::endl ;
-                break ;
-            case type_normal_distribution: // 1
-                x = d1 (pseudorandom_generator) ;
-                y = d1 (pseudorandom_generator) ;
-                break ;
-            case type_lognormal_distribution: // 2
-                x = d2 (pseudorandom_generator) ;
-                y = d2 (pseudorandom_generator) ;
-                break ;
-            case type_chi_squared_distribution: // 3
-                x = d3 (pseudorandom_generator) ;
-                y = d3 (pseudorandom_generator) ;
-                break ;
-            case type_cauchy_distribution: // 4
-                x = d4 (pseudorandom_generator) ;
-                y = d4 (pseudorandom_generator) ;
-                break ;
-            case type_fisher_f_distribution: // 5
-                x = d5 (pseudorandom_generator) ;
-                y = d5 (pseudorandom_generator) ;
-                break ;
-            case type_student_t_distribution: // 6
-                x = d6 (pseudorandom_generator) ;
-                y = d6 (pseudorandom_generator) ;
-                break ;
-            case type_exponential_distribution: // 7
-                x = d7 (pseudorandom_generator) ;
-                y = d7 (pseudorandom_generator) ;
-                break ;
-            case type_gamma_distribution: // 8
-                x = d8 (pseudorandom_generator) ;
-                y = d8 (pseudorandom_generator) ;
-                break ;
-            case type_weibull_distribution: // 9
-                x = d9 (pseudorandom_generator) ;
-                y = d9 (pseudorandom_generator) ;
-                break ;
-            default:
-                break ;
-        }
-        if (pattern_settings. avoid_overlap) {
-            for (long_unsigned_int j = 0 ; j < polylines. size () ; j++) {
-                if ((polylines[j]. vertices[0] - Vertex(x, y)).norm2_square() <
-                    pattern_settings. diametre*pattern_settings. diametre) {
-                    overlap = true ;
-                    break ;
-                 }
-            }
-        }
-
-        bool within_limits =
-            (((fabs (x - pattern_settings. x0) < pattern_settings. lx / 2.0) ||
-             (pattern_settings. lx <= 0)) &&
-            ((fabs (y - pattern_settings. y0) < pattern_settings. ly / 2.0) ||
-             (pattern_settings. ly <= 0))) ;
-
+        x = distributions. draw (pattern_settings. type, pseudorandom_generator) ;
+        y = distributions. draw (pattern_settings. type, pseudorandom_generator) ;
         // Either we are inside lx, or user set it to negative to disable it.
-        if  (within_limits && !overlap) {
+        if (within_limits (x, y) && !overlaps (x, y, first, placed)) {
             p. push_back (Vertex (x, y)) ;
             p. dose = pattern_settings. diametre ;
-            polylines. push_back (p) ;
+            if (pattern_settings. avoid_overlap)
+                placed. push_back (Vertex (x, y)) ;
+            function (p) ;
             p. vertices. clear () ; // does not change that p. closed == true ;
             i++ ;
         }
         attempts++ ;
     }
 }
+
+bool dpps::Pattern_random::within_limits (const double x,
+                                          const double y) const {
+    return ((fabs (x - pattern_settings. x0) < pattern_settings. lx / 2.0) ||
+            (pattern_settings. lx <= 0)) &&
+           ((fabs (y - pattern_settings. y0) < pattern_settings. ly / 2.0) ||
+            (pattern_settings. ly <= 0)) ;
+}
+
+bool dpps::Pattern_random::overlaps (const double x, const double y,
+                                     const long_unsigned_int first,
+                                     const std::vector<Vertex> &placed) const {
+    if (!pattern_settings. avoid_overlap)
+        return false ;
+    for (long_unsigned_int j = 0 ; j < first ; j++)
+        if ((polylines[j]. vertices[0] - Vertex(x, y)). norm2_square () <
+            pattern_settings. diametre*pattern_settings. diametre)
+            return true ;
+    // the reference &v is used to avoid copy
+    for (auto &v: placed)
+        if ((v - Vertex(x, y)). norm2_square () <
+            pattern_settings. diametre*pattern_settings. diametre)
+            return true ;
+    return false ;
+}
+
+void dpps::Pattern_random::generate_counter_based (
+    const std::function<void (const Polyline &)> &function) {
+    const double p1 {pattern_settings. p1} ;
+    const double p2 {pattern_settings. p2} ;
+    Random_distributions distributions (p1, p2, -p1, p1, 0.0, p1) ;
+    uint32_t pass {static_cast<uint32_t> (counter_based_passes++)} ;
+    const long_unsigned_int number {pattern_settings. number} ;
+    const long_unsigned_int max_attempts {pattern_settings. max_attempts} ;
+
+    // Attempt k draws from stream k, so the candidates are drawn in parallel
+    // by chunks, then kept in the order of the attempts until enough of them
+    // are found. Drawing more candidates than needed does not change the
+    // result.
+    std::vector<Vertex> candidates ;
+    std::vector<char> inside ;
+    Polyline p ;
+    p. closed = true ;
+    p. dose = pattern_settings. diametre ;
+    long_unsigned_int first {polylines. size ()} ;
+    std::vector<Vertex> placed ;
+    long_unsigned_int i {0}, attempts {0} ;
+    while ((i < number) && (attempts < max_attempts)) {
+        long_unsigned_int chunk {std::min (max_attempts - attempts,
+            std::max (number - i, static_cast<long_unsigned_int> (1024)))} ;
+        chunk = std::min (chunk, static_cast<long_unsigned_int> (1 << 20)) ;
+        candidates. resize (chunk) ;
+        inside. resize (chunk) ;
+#ifdef OPENMP_FOUND
+        #pragma omp parallel for schedule(static) if (chunk > 4096) firstprivate(distributions)
+#endif
+        for (long_unsigned_int k = 0 ; k < chunk ; k++) {
+            Counter_random generator (time_seed, attempts + k, pass) ;
+            distributions. reset () ;
+            double x {distributions. draw (pattern_settings. type, generator)} ;
+            double y {distributions. draw (pattern_settings. type, generator)} ;
+            candidates[k] = Vertex (x, y) ;
+            inside[k] = within_limits (x, y) ;
+        }
+        for (long_unsigned_int k = 0 ; (k < chunk) && (i < number) ; k++) {
+            attempts++ ;
+            if (inside[k] && !overlaps (candidates[k]. x, candidates[k]. y,
+                                        first, placed)) {
+                p. vertices. assign (1, candidates[k]) ;
+                if (pattern_settings. avoid_overlap)
+                    placed. push_back (candidates[k]) ;
+                function (p) ;
+                i++ ;
+            }
+        }
+    }
+}
+
+template <class Generator>
+void dpps::Pattern_random::generate_Poisson_disk (Generator &generator,
+    const std::function<void (const Polyline &)> &function) {
+    constexpr const static short unsigned int candidates {30} ;
+    constexpr const static double two_pi {2*M_PI} ;
+    const double spacing {pattern_settings. p1} ;
+    const double lx {pattern_settings. lx} ;
+    const double ly {pattern_settings. ly} ;
+    if ((spacing <= 0) || (lx <= 0) || (ly <= 0)) {
+        std::string reason {"Pattern_random::generate, the Poisson disk \
+distribution needs a positive spacing p1 and positive lengths lx and ly, \
+got p1 = " + std::to_string (spacing) + ", lx = " + std::to_string (lx) +
+            ", ly = " + std::to_string (ly)} ;
+        throw bad_parametre (reason. c_str ()) ;
+    }
+    if (pattern_settings. number == 0)
+        return ;
+    const double minx {pattern_settings. x0 - lx / 2.0} ;
+    const double miny {pattern_settings. y0 - ly / 2.0} ;
+    const double squared_spacing {spacing * spacing} ;
+    // A cell is small enough that its diagonal is the spacing, so it holds
+    // at most one dot, and the dots closer than the spacing from a position
+    // are in the 5×5 cells around it.
+    const double cell_size {spacing / std::sqrt (2.0)} ;
+    const long_unsigned_int nx {
+        static_cast<long_unsigned_int> (std::ceil (lx / cell_size))} ;
+    const long_unsigned_int ny {
+        static_cast<long_unsigned_int> (std::ceil (ly / cell_size))} ;
+    constexpr const static long_unsigned_int empty {
+        std::numeric_limits<long_unsigned_int>::max ()} ;
+    std::vector<long_unsigned_int> grid (nx * ny, empty) ;
+    std::vector<Vertex> dots ;
+    std::vector<long_unsigned_int> active ;
+    auto cell_of = [&] (const Vertex &v, long_unsigned_int &i,
+                        long_unsigned_int &j) {
+        i = std::min (static_cast<long_unsigned_int> ((v. x - minx) /
+                                                      cell_size), nx - 1) ;
+        j = std::min (static_cast<long_unsigned_int> ((v. y - miny) /
+                                                      cell_size), ny - 1) ;
+    } ;
+    auto add = [&] (const Vertex &v) {
+        long_unsigned_int i, j ;
+        cell_of (v, i, j) ;
+        grid[j * nx + i] = dots. size () ;
+        active. push_back (dots. size ()) ;
+        dots. push_back (v) ;
+    } ;
+    auto too_close = [&] (const Vertex &v) {
+        long_unsigned_int i, j ;
+        cell_of (v, i, j) ;
+        long_unsigned_int imin {i < 2 ? 0 : i - 2} ;
+        long_unsigned_int jmin {j < 2 ? 0 : j - 2} ;
+        long_unsigned_int imax {std::min (i + 2, nx - 1)} ;
+        long_unsigned_int jmax {std::min (j + 2, ny - 1)} ;
+        for (long_unsigned_int b = jmin ; b <= jmax ; b++)
+            for (long_unsigned_int a = imin ; a <= imax ; a++) {
+                long_unsigned_int n {grid[b * nx + a]} ;
+                if ((n != empty) &&
+                    ((dots[n] - v). norm2_square () < squared_spacing))
+                    return true ;
+            }
+        return false ;
+    } ;
+
+    std::uniform_real_distribution<double> dx (minx, minx + lx) ;
+    std::uniform_real_distribution<double> dy (miny, miny + ly) ;
+    // The radius is drawn so that the positions are uniform over the ring.
+    std::uniform_real_distribution<double> d_ring (1.0, 4.0) ;
+    std::uniform_real_distribution<double> d_angle (0, two_pi) ;
+    std::uniform_int_distribution<long_unsigned_int> d_int ;
+    double x {dx (generator)} ;
+    double y {dy (generator)} ;
+    add (Vertex (x, y)) ;
+    while ((dots. size () < pattern_settings. number) && !active. empty ()) {
+        std::uniform_int_distribution<long_unsigned_int>::param_type
+                param (0, active. size () - 1) ;
+        long_unsigned_int pos {d_int (generator, param)} ;
+        const Vertex centre {dots[active[pos]]} ;
+        bool placed {false} ;
+        for (short unsigned int k = 0 ; k < candidates ; k++) {
+            double radius {spacing * std::sqrt (d_ring (generator))} ;
+            double angle {d_angle (generator)} ;
+            Vertex v {centre. x + radius * cos (angle),
+                      centre. y + radius * sin (angle)} ;
+            if ((v. x < minx) || (v. y < miny) ||
+                (v. x >= minx + lx) || (v. y >= miny + ly) ||
+                too_close (v))
+                continue ;
+            add (v) ;
+            placed = true ;
+            break ;
+        }
+        if (!placed) {
+            // The order of active does not matter, as it is drawn from at
+            // random, so we replace it by the last one instead of erasing it.
+            active[pos] = active. back () ;
+            active. pop_back () ;
+        }
+    }
+    Polyline p ;
+    p. closed = true ;
+    p. dose = pattern_settings. diametre ;
+    // the reference &v is used to avoid copy
+    for (auto &v: dots) {
+        p. vertices. assign (1, v) ;
+        function (p) ;
+    }
+}
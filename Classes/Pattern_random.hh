@@ -22,6 +22,18 @@ namespace dpps {
  * the most important of which are the uniform distribution and the normal
  * distribution. Elements are a single dot. The user can call
  * Pattern::replace_by() to replace the dots by the element of his choice.
+ *
+ * With type_Poisson_disk_distribution, the dots fill the rectangle lx × ly
+ * centred on (x0, y0), no two of them closer than p1, by the algorithm of
+ * Bridson, in a time proportional to the number of dots: each new dot is
+ * drawn around one already placed, between p1 and 2 p1 from it, and a grid
+ * of cells of side p1/√2, which hold at most one dot each, gives the
+ * neighbours to compare with. A dot around which 30 attempts fail is no
+ * longer used. The generation stops when number dots are placed or the
+ * rectangle is full. max_attempts, avoid_overlap and p2 are not used.
+ * Reference: R. Bridson, Fast Poisson disk sampling in arbitrary
+ * dimensions, SIGGRAPH 2007 sketches.
+ * http://dx.doi.org/10.1145/1278780.1278807
  */
 class Pattern_random: public Pattern {
 public:
@@ -81,6 +93,27 @@ protected:
 
     Pattern_random_settings pattern_settings ;
 
+    /** @brief whether (x, y) is inside the cutoff lengths lx and ly. */
+    bool within_limits (const double x, const double y) const ;
+
+    /** @brief whether avoid_overlap is set and (x, y) is closer than
+     * diametre to one of the first polylines already present, or to one of
+     * the placed elements. */
+    bool overlaps (const double x, const double y,
+                   const long_unsigned_int first,
+                   const std::vector<Vertex> &placed) const ;
+
+    /** @brief generate_each() with a Counter_random generator, see
+     * Pattern::set_counter_based_random(). */
+    void generate_counter_based (
+        const std::function<void (const Polyline &)> &function) ;
+
+    /** @brief generate_each() with type_Poisson_disk_distribution, drawing
+     * from generator. */
+    template <class Generator>
+    void generate_Poisson_disk (Generator &generator,
+        const std::function<void (const Polyline &)> &function) ;
+
 public:
     /** @brief the default constructor */
     Pattern_random () ;
@@ -115,6 +148,12 @@ public:
                          const std::vector<std::string> &vstring) ;
 
     void generate () ;
+
+    /** @brief see Pattern::generate_each(). With avoid_overlap, the
+     * positions of the elements are kept, as the next ones are compared to
+     * them, but not their polylines. */
+    void generate_each (
+        const std::function<void (const Polyline &)> &function) ;
     void set_all_parametres (
         const enum_distribution type,
         const long_unsigned_int number,
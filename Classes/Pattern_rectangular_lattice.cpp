@@ -10,6 +10,7 @@
  * file, You can obtain one at http://mozilla.org/MPL/2.0/.
  */
 
+#include <algorithm>
 #include <cmath>
 #include <limits>
 
@@ -23,14 +24,16 @@ dpps::Pattern_rectangular_lattice::Pattern_rectangular_lattice (const Pattern_re
     Pattern (source),
     side_x (source. side_x),
     side_y (source. side_y),
-    pattern_settings (source. pattern_settings) {
+    pattern_settings (source. pattern_settings),
+    lattice_cells (source. lattice_cells) {
 }
 
 dpps::Pattern_rectangular_lattice::Pattern_rectangular_lattice (Pattern_rectangular_lattice &&source):
     Pattern (source),
     side_x (source. side_x),
     side_y (source. side_y),
-    pattern_settings (source. pattern_settings) {
+    pattern_settings (source. pattern_settings),
+    lattice_cells (source. lattice_cells) {
 }
 
 dpps::Pattern_rectangular_lattice &dpps::Pattern_rectangular_lattice::operator= (
@@ -40,6 +43,7 @@ dpps::Pattern_rectangular_lattice &dpps::Pattern_rectangular_lattice::operator=
         side_x = source. side_x ;
         side_y = source. side_y ;
         pattern_settings = source. pattern_settings ;
+        lattice_cells = source. lattice_cells ;
     }
     return *this ;
 }
@@ -50,6 +54,7 @@ dpps::Pattern_rectangular_lattice &dpps::Pattern_rectangular_lattice::operator=
     side_x = source. side_x ;
     side_y = source. side_y ;
     pattern_settings = source. pattern_settings ;
+    lattice_cells = source. lattice_cells ;
     return *this ;
 }
 
@@ -104,7 +109,8 @@ void dpps::Pattern_rectangular_lattice::set_parametres (
                         vdouble[4], vdouble[5], vdouble[6]) ;
 }
 
-void dpps::Pattern_rectangular_lattice::generate () {
+void dpps::Pattern_rectangular_lattice::count_cells (
+    long_unsigned_int &number_x, long_unsigned_int &number_y) const {
     double minx {pattern_settings. coordinates[0]} ;
     double miny {pattern_settings. coordinates[1]} ;
     double maxx {pattern_settings. coordinates[2]} ;
@@ -115,38 +121,143 @@ the minimum_x.") ;
     if (maxy <= miny) throw bad_parametre
        ("Pattern_rectangular_lattice::generate, maximum_y is smaller or equal than \
 the minimum_y.") ;
-    Vertex v ;
-    Polyline p ;
+    if ((pattern_settings. period_x <= 0) || (pattern_settings. period_y <= 0))
+        throw bad_parametre
+       ("Pattern_rectangular_lattice::generate, the periods must be positive.") ;
+    number_x = Lattice_cells::number_positions (minx, maxx,
+                                                pattern_settings. period_x) ;
+    number_y = Lattice_cells::number_positions (miny, maxy,
+                                                pattern_settings. period_y) ;
+}
+
+void dpps::Pattern_rectangular_lattice::fill_cell (
+    const long_unsigned_int i, const long_unsigned_int j, Polyline &p) const {
+    double startx {pattern_settings. coordinates[0] +
+                   i * pattern_settings. period_x} ;
+    double starty {pattern_settings. coordinates[1] +
+                   j * pattern_settings. period_y} ;
     p. closed = true ;
-    double startx {minx} ;
-    while (startx < maxx) {
-        double starty {miny} ;
-        while (starty < maxy) {
-            if (fabs (pattern_settings. area_ratio) < std::numeric_limits<double>::epsilon ()) {
-                // If zero was passed, then we create a vertex lattice,
-                // instead of a lattice of rectangulars.
-                v. x = startx ;
-                v. y = starty ;
-                p. push_back (v) ;
-            } else {
-                // Vertex and Polyline are passed as parametre and inserted in
-                // vectors by copy, so we can always push_back the same variable.
-                v. x = startx ;
-                v. y = starty ;
-                p. push_back (v) ;
-                v. x += side_x ;
-                p. push_back (v) ;
-                v. y += side_y ;
-                p. push_back (v) ;
-                v. x = startx ;
-                p. push_back (v) ;
-            }
-            polylines. push_back (p) ;
+    // If zero was passed, then we create a vertex lattice, instead of a
+    // lattice of rectangulars.
+    if (fabs (pattern_settings. area_ratio) <
+        std::numeric_limits<double>::epsilon ()) {
+        p. push_back (Vertex (startx, starty)) ;
+    } else {
+        p. vertices. reserve (4) ;
+        p. push_back (Vertex (startx, starty)) ;
+        p. push_back (Vertex (startx + side_x, starty)) ;
+        p. push_back (Vertex (startx + side_x, starty + side_y)) ;
+        p. push_back (Vertex (startx, starty + side_y)) ;
+    }
+}
 
-            // preparing for next iteration
-            p. vertices. clear () ; // does not change that p. closed == true ;
-            starty += pattern_settings. period_y ;
+void dpps::Pattern_rectangular_lattice::generate () {
+    // The number of cells is known, so all the polylines are created at once
+    // and filled in parallel, one column at a time. Positions are computed
+    // from the indices, so that they do not drift along large lattices.
+    long_unsigned_int number_x {0} ;
+    long_unsigned_int number_y {0} ;
+    count_cells (number_x, number_y) ;
+    if (pattern_settings. procedural) {
+        // The bounding box of a rectangular is the one of its vertices.
+        Lattice_cells::Axis x, y ;
+        x. origin = pattern_settings. coordinates[0] ;
+        x. period = pattern_settings. period_x ;
+        x. number = number_x ;
+        y. origin = pattern_settings. coordinates[1] ;
+        y. period = pattern_settings. period_y ;
+        y. number = number_y ;
+        if (fabs (pattern_settings. area_ratio) >=
+            std::numeric_limits<double>::epsilon ()) {
+            x. low = std::min (0.0, side_x) ;
+            x. high = std::max (0.0, side_x) ;
+            y. low = std::min (0.0, side_y) ;
+            y. high = std::max (0.0, side_y) ;
         }
-        startx += pattern_settings. period_x ;
+        lattice_cells. set (x, y) ;
+        return ;
     }
-}
\ No newline at end of file
+    long_unsigned_int first {polylines. size ()} ;
+    polylines. resize (first + number_x * number_y) ;
+#ifdef OPENMP_FOUND
+    #pragma omp parallel for schedule(static) if (number_x * number_y > 16384)
+#endif
+    for (long_unsigned_int i = 0 ; i < number_x ; i++)
+        for (long_unsigned_int j = 0 ; j < number_y ; j++)
+            fill_cell (i, j, polylines[first + i * number_y + j]) ;
+}
+
+void dpps::Pattern_rectangular_lattice::generate_each (
+    const std::function<void (const Polyline &)> &function) {
+    // The same polyline is filled again for each cell.
+    Polyline p ;
+    if (pattern_settings. procedural) {
+        lattice_cells. for_each_implicit (
+            [&] (long_unsigned_int i, long_unsigned_int j) {
+                p. vertices. clear () ;
+                fill_cell (i, j, p) ;
+                function (p) ;
+            }) ;
+        return ;
+    }
+    long_unsigned_int number_x {0} ;
+    long_unsigned_int number_y {0} ;
+    count_cells (number_x, number_y) ;
+    for (long_unsigned_int i {0} ; i < number_x ; i++)
+        for (long_unsigned_int j {0} ; j < number_y ; j++) {
+            p. vertices. clear () ;
+            fill_cell (i, j, p) ;
+            function (p) ;
+        }
+}
+
+void dpps::Pattern_rectangular_lattice::set_procedural (const bool procedural) {
+    pattern_settings. procedural = procedural ;
+    lattice_cells. set (Lattice_cells::Axis (), Lattice_cells::Axis ()) ;
+}
+
+long_unsigned_int dpps::Pattern_rectangular_lattice::implicit_size () const {
+    return lattice_cells. size () ;
+}
+
+double dpps::Pattern_rectangular_lattice::implicit_area () const {
+    // All the rectangulars have the same area, 0 for dots.
+    return lattice_cells. size () *
+           (lattice_cells. x. high - lattice_cells. x. low) *
+           (lattice_cells. y. high - lattice_cells. y. low) ;
+}
+
+bool dpps::Pattern_rectangular_lattice::implicit_limits (
+    double &xmin, double &ymin, double &xmax, double &ymax) const {
+    return lattice_cells. limits (xmin, ymin, xmax, ymax) ;
+}
+
+long_unsigned_int dpps::Pattern_rectangular_lattice::implicit_size_in_window (
+    const double xmin, const double ymin,
+    const double xmax, const double ymax) const {
+    return lattice_cells. size_in_window (xmin, ymin, xmax, ymax) ;
+}
+
+void dpps::Pattern_rectangular_lattice::materialize_window (
+    const double xmin, const double ymin,
+    const double xmax, const double ymax,
+    const selection_t selection) {
+check_selection_not_negative_not_too_high(selection) ;
+    Polyline p ;
+    p. selected[selection] = true ;
+    lattice_cells. materialize_window (xmin, ymin, xmax, ymax,
+        [&] (long_unsigned_int i, long_unsigned_int j) {
+            p. vertices. clear () ;
+            fill_cell (i, j, p) ;
+            polylines. push_back (p) ;
+        }) ;
+}
+
+void dpps::Pattern_rectangular_lattice::materialize (
+    const selection_t selection) {
+    materialize_window (-std::numeric_limits<double>::infinity (),
+                        -std::numeric_limits<double>::infinity (),
+                        std::numeric_limits<double>::infinity (),
+                        std::numeric_limits<double>::infinity (),
+                        selection) ;
+}
@@ -14,6 +14,7 @@
 #define DPPS_PATTERN_SQUARE_LATTICE
 
 #include "Pattern.hh"
+#include "Lattice_cells.hh"
 
 namespace dpps {
 /** @brief Pattern_rectangular_lattice is a Pattern derivative that generates a
@@ -21,6 +22,14 @@ namespace dpps {
  *
  * One can choose the period of the pattern and the area percentage covered
  * by the inside of the rectangulars.
+ *
+ * In the procedural mode (see set_procedural()), generate() does not append
+ * the rectangulars: they stay implicit, and the implicit_ functions count
+ * them, sum their area and find their limits by index arithmetic.
+ * materialize_window() appends to polylines the ones inside a window, which
+ * can then be edited as any polyline, and generate_each() passes the ones
+ * which are still implicit, so that Pattern::stream() with with_polylines
+ * writes the whole pattern.
  */
 class Pattern_rectangular_lattice: public Pattern {
     /** @brief A derived structure to encapsulate data defining the pattern. */
@@ -45,12 +54,27 @@ class Pattern_rectangular_lattice: public Pattern {
          * the left and to the top instead of to the right and to the bottom.
          */
         double area_ratio = 0.5 ;
+
+        /** @brief whether generate() keeps the rectangulars implicit. */
+        bool procedural = false ;
     } ;
 protected:
     double side_x {0.0} ;
     double side_y {0.0} ;
     Pattern_rectangular_lattice_settings pattern_settings ;
 
+    /** @brief the implicit rectangulars of the procedural mode. */
+    Lattice_cells lattice_cells ;
+
+    /** @brief checks the settings and sets the number of columns and of
+     * rows of the lattice. */
+    void count_cells (long_unsigned_int &number_x,
+                      long_unsigned_int &number_y) const ;
+
+    /** @brief appends to p the vertices of the cell of column i and row j. */
+    void fill_cell (const long_unsigned_int i, const long_unsigned_int j,
+                    Polyline &p) const ;
+
 public:
     /** @brief the default constructor */
     Pattern_rectangular_lattice () ;
@@ -81,6 +105,46 @@ public:
                          const std::vector<std::string> &vstring) ;
 
     void generate () ;
+
+    /** @brief see Pattern::generate_each(). In the procedural mode, only
+     * the implicit rectangulars are passed. */
+    void generate_each (
+        const std::function<void (const Polyline &)> &function) ;
+
+    /** @brief sets whether the next generate() keeps the rectangulars
+     * implicit, see the description of the class. The rectangulars already
+     * appended are not changed. */
+    void set_procedural (const bool procedural) ;
+
+    /** @brief the number of implicit rectangulars. */
+    long_unsigned_int implicit_size () const ;
+
+    /** @brief the sum of the areas of the implicit rectangulars. */
+    double implicit_area () const ;
+
+    /** @brief sets the limits of the implicit rectangulars. Returns false,
+     * leaving them unchanged, if there is none. */
+    bool implicit_limits (double &xmin, double &ymin,
+                          double &xmax, double &ymax) const ;
+
+    /** @brief the number of implicit rectangulars which
+     * Pattern::select_window() would select in the window if they were
+     * polylines. */
+    long_unsigned_int implicit_size_in_window (const double xmin,
+                                               const double ymin,
+                                               const double xmax,
+                                               const double ymax) const ;
+
+    /** @brief appends to polylines the implicit rectangulars inside the
+     * window, as Pattern::select_window() finds them, and adds them to
+     * the selection. They are no longer implicit. */
+    void materialize_window (const double xmin, const double ymin,
+                             const double xmax, const double ymax,
+                             const selection_t selection = 0) ;
+
+    /** @brief appends to polylines all the implicit rectangulars, and adds
+     * them to the selection. */
+    void materialize (const selection_t selection = 0) ;
     void set_all_parametres (
         const double minx,
         const double miny,
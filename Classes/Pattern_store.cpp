@@ -0,0 +1,277 @@
+/**
+ * @file Pattern_store.cpp
+ * @author Jérôme Borme <jerome.borme@inl.int>
+ * @version 1.0
+ * @brief Implementation of class Pattern_store
+ * @date 2026-10-14 Jérôme Borme: Initial version
+ * @copyright
+ * This Source Code Form is subject to the terms of the Mozilla Public
+ * License, v. 2.0. If a copy of the MPL was not distributed with this
+ * file, You can obtain one at http://mozilla.org/MPL/2.0/.
+ */
+
+#include <cstdio> // rename, remove
+#include <limits>
+#include <random>
+
+#include "Pattern_store.hh"
+#include "Reader_dpps.hh"
+#include "Writer_dpps.hh"
+#include "bad_io.hh"
+#include "bad_parametre.hh"
+
+dpps::Pattern_store::Pattern_store (const std::string &set_directory,
+                                    const long_unsigned_int set_chunk_size):
+    directory (set_directory), chunk_size (set_chunk_size) {
+    if (chunk_size == 0) {
+        std::string reason {"Pattern_store, the chunks must have at least \
+one polyline."} ;
+        throw bad_parametre (reason. c_str ()) ;
+    }
+    prefix = directory + "/dpps_store_" +
+             std::to_string (std::random_device () ()) + "_" ;
+}
+
+dpps::Pattern_store::~Pattern_store () {
+    // the reference &chunk is used to avoid copy
+    for (auto &chunk: chunks)
+        std::remove (chunk. filename. c_str ()) ;
+}
+
+void dpps::Pattern_store::write_chunk (Chunk &chunk, const Pattern_packed &p) {
+    std::string temporary {chunk. filename + ".tmp"} ;
+    {
+        Writer_dpps writer (temporary) ;
+        writer. write_Pattern_packed (p) ;
+        writer. close () ;
+    }
+    if (std::rename (temporary. c_str (), chunk. filename. c_str ()) != 0) {
+        std::remove (temporary. c_str ()) ;
+        std::string reason {"Pattern_store, file " + chunk. filename +
+                            " could not be written."} ;
+        throw bad_io (reason. c_str ()) ;
+    }
+    chunk. size = p. size () ;
+    chunk. vertices_size = p. x. size () ;
+    chunk. minimum_x = std::numeric_limits<double>::max () ;
+    chunk. minimum_y = std::numeric_limits<double>::max () ;
+    chunk. maximum_x = std::numeric_limits<double>::lowest () ;
+    chunk. maximum_y = std::numeric_limits<double>::lowest () ;
+    for (long_unsigned_int i {0} ; i < p. size () ; i++) {
+        double minx {std::numeric_limits<double>::max ()} ;
+        double miny {std::numeric_limits<double>::max ()} ;
+        double maxx {std::numeric_limits<double>::lowest ()} ;
+        double maxy {std::numeric_limits<double>::lowest ()} ;
+        p. polyline_limits (i, minx, miny, maxx, maxy) ;
+        if (minx < chunk. minimum_x)
+            chunk. minimum_x = minx ;
+        if (miny < chunk. minimum_y)
+            chunk. minimum_y = miny ;
+        if (maxx > chunk. maximum_x)
+            chunk. maximum_x = maxx ;
+        if (maxy > chunk. maximum_y)
+            chunk. maximum_y = maxy ;
+    }
+}
+
+void dpps::Pattern_store::check_chunk (const long_unsigned_int i) const {
+    if (i >= chunks. size ()) {
+        std::string reason {"Pattern_store, there is no chunk " +
+            std::to_string (i) + ", the store has " +
+            std::to_string (chunks. size ()) + " chunks."} ;
+        throw bad_parametre (reason. c_str ()) ;
+    }
+}
+
+bool dpps::Pattern_store::chunk_meets_window (const long_unsigned_int i,
+    const double xmin, const double ymin,
+    const double xmax, const double ymax) const {
+    // the reference &chunk is used to avoid copy
+    const Chunk &chunk = chunks[i] ;
+    return (chunk. minimum_x <= xmax) && (chunk. maximum_x >= xmin) &&
+           (chunk. minimum_y <= ymax) && (chunk. maximum_y >= ymin) ;
+}
+
+void dpps::Pattern_store::push_back (const Polyline &p) {
+    pending. push_back (p) ;
+    if (pending. size () >= chunk_size)
+        flush () ;
+}
+
+void dpps::Pattern_store::append (const Pattern &p) {
+    // the reference &q is used to avoid copy
+    for (auto &q: p. polylines)
+        push_back (q) ;
+}
+
+void dpps::Pattern_store::append (const Pattern_packed &p) {
+    for (long_unsigned_int i {0} ; i < p. size () ; i++)
+        push_back (p. get_polyline (i)) ;
+}
+
+void dpps::Pattern_store::flush () {
+    if (pending. size () == 0)
+        return ;
+    Chunk chunk {prefix + std::to_string (next_file) + ".dpps", 0, 0,
+                 0.0, 0.0, 0.0, 0.0} ;
+    next_file++ ;
+    write_chunk (chunk, pending) ;
+    chunks. push_back (chunk) ;
+    pending. clear () ;
+}
+
+void dpps::Pattern_store::clear () {
+    // the reference &chunk is used to avoid copy
+    for (auto &chunk: chunks)
+        std::remove (chunk. filename. c_str ()) ;
+    chunks. clear () ;
+    pending. clear () ;
+}
+
+long_unsigned_int dpps::Pattern_store::size () const {
+    long_unsigned_int result {pending. size ()} ;
+    // the reference &chunk is used to avoid copy
+    for (auto &chunk: chunks)
+        result += chunk. size ;
+    return result ;
+}
+
+long_unsigned_int dpps::Pattern_store::vertices_size () const {
+    long_unsigned_int result {pending. x. size ()} ;
+    // the reference &chunk is used to avoid copy
+    for (auto &chunk: chunks)
+        result += chunk. vertices_size ;
+    return result ;
+}
+
+long_unsigned_int dpps::Pattern_store::number_chunks () {
+    flush () ;
+    return chunks. size () ;
+}
+
+const dpps::Pattern_store::Chunk &dpps::Pattern_store::get_chunk (
+    const long_unsigned_int i) {
+    flush () ;
+check_chunk (i) ;
+    return chunks[i] ;
+}
+
+void dpps::Pattern_store::limits (double &minimum_x, double &minimum_y,
+                                  double &maximum_x, double &maximum_y) {
+    flush () ;
+    bool found {false} ;
+    // the reference &chunk is used to avoid copy
+    for (auto &chunk: chunks) {
+        if (chunk. vertices_size == 0)
+            continue ;
+        if (!found || (chunk. minimum_x < minimum_x))
+            minimum_x = chunk. minimum_x ;
+        if (!found || (chunk. minimum_y < minimum_y))
+            minimum_y = chunk. minimum_y ;
+        if (!found || (chunk. maximum_x > maximum_x))
+            maximum_x = chunk. maximum_x ;
+        if (!found || (chunk. maximum_y > maximum_y))
+            maximum_y = chunk. maximum_y ;
+        found = true ;
+    }
+}
+
+dpps::Pattern_packed dpps::Pattern_store::load_chunk (
+    const long_unsigned_int i) {
+    flush () ;
+check_chunk (i) ;
+    Pattern_packed result ;
+    Reader_dpps reader (chunks[i]. filename) ;
+    result. reserve (reader. size (), reader. vertices_size ()) ;
+    reader. append_to_pattern_packed (result) ;
+    reader. close () ;
+    return result ;
+}
+
+void dpps::Pattern_store::replace_chunk (const long_unsigned_int i,
+                                         const Pattern_packed &p) {
+    flush () ;
+check_chunk (i) ;
+    write_chunk (chunks[i], p) ;
+}
+
+void dpps::Pattern_store::modify_chunks (
+    const std::function<void (Pattern_packed &)> &f) {
+    flush () ;
+    for (long_unsigned_int i {0} ; i < chunks. size () ; i++) {
+        Pattern_packed p {load_chunk (i)} ;
+        f (p) ;
+        write_chunk (chunks[i], p) ;
+    }
+}
+
+void dpps::Pattern_store::read_chunks (
+    const std::function<void (const Pattern_packed &)> &f) {
+    flush () ;
+    for (long_unsigned_int i {0} ; i < chunks. size () ; i++)
+        f (load_chunk (i)) ;
+}
+
+void dpps::Pattern_store::translate (const double x0, const double y0,
+                                     const selection_t selection) {
+check_selection_not_too_high(selection) ;
+    modify_chunks ([=] (Pattern_packed &p) {
+        p. translate (x0, y0, selection) ;
+    }) ;
+}
+
+void dpps::Pattern_store::set_dose (const double dose_value,
+                                    const selection_t selection) {
+check_selection_not_too_high(selection) ;
+    modify_chunks ([=] (Pattern_packed &p) {
+        p. set_dose (dose_value, selection) ;
+    }) ;
+}
+
+void dpps::Pattern_store::select_window (const double xmin, const double ymin,
+                                         const double xmax, const double ymax,
+                                         const selection_t selection) {
+check_selection_not_negative_not_too_high(selection) ;
+    flush () ;
+    for (long_unsigned_int i {0} ; i < chunks. size () ; i++) {
+        if (!chunk_meets_window (i, xmin, ymin, xmax, ymax))
+            continue ;
+        Pattern_packed p {load_chunk (i)} ;
+        long_unsigned_int selected {p. size (selection)} ;
+        p. select_window (xmin, ymin, xmax, ymax, false, selection) ;
+        if (p. size (selection) != selected)
+            write_chunk (chunks[i], p) ;
+    }
+}
+
+void dpps::Pattern_store::append_window_to_pattern (Pattern &p,
+    const double xmin, const double ymin,
+    const double xmax, const double ymax) {
+    flush () ;
+    for (long_unsigned_int i {0} ; i < chunks. size () ; i++) {
+        if (!chunk_meets_window (i, xmin, ymin, xmax, ymax))
+            continue ;
+        Reader_dpps reader (chunks[i]. filename) ;
+        reader. append_window_to_pattern (p, xmin, ymin, xmax, ymax) ;
+        reader. close () ;
+    }
+}
+
+void dpps::Pattern_store::write_to (Writer &writer) {
+    flush () ;
+    writer. begin_stream () ;
+    // the reference &chunk is used to avoid copy
+    for (auto &chunk: chunks) {
+        Reader_dpps reader (chunk. filename) ;
+        bool ok {true} ;
+        while (ok) {
+            // A new polyline each time, see Pipeline::run().
+            Polyline p ;
+            ok = reader. read_polyline (p) ;
+            if (ok)
+                writer. write_Polyline_stream (p) ;
+        }
+        reader. close () ;
+    }
+    writer. end_stream () ;
+}
@@ -0,0 +1,172 @@
+/**
+ * @file Pattern_store.hh
+ * @author Jérôme Borme <jerome.borme@inl.int>
+ * @version 1.0
+ * @brief Header file for class Pattern_store, which keeps the polylines of
+ * a pattern too large for the memory in files
+ * @date 2026-10-14 Jérôme Borme: Initial version
+ * @copyright
+ * This Source Code Form is subject to the terms of the Mozilla Public
+ * License, v. 2.0. If a copy of the MPL was not distributed with this
+ * file, You can obtain one at http://mozilla.org/MPL/2.0/.
+ */
+#ifndef DPPS_PATTERN_STORE
+#define DPPS_PATTERN_STORE
+
+#include <functional>
+#include <string>
+#include <vector>
+
+#include "common.hh"
+#include "Polyline.hh"
+#include "Pattern.hh"
+#include "Pattern_packed.hh"
+#include "Writer.hh"
+
+namespace dpps {
+/** @brief A sequence of polylines kept on disk, in chunks of a fixed number
+ * of polylines, so that a pattern larger than the memory can be built,
+ * modified and written.
+ *
+ * Each chunk is a file of the binary dpps format (see Writer_dpps), with the
+ * bounding box of each polyline, which Reader_dpps maps in memory where the
+ * system allows it. Only the directory of the chunks is kept in memory: the
+ * name of the file, the numbers of polylines and vertices, and the bounding
+ * box of the chunk. The operations go through the chunks one after the
+ * other, as a Pattern_packed, so that at most one chunk is in memory at a
+ * time, and the chunks whose bounding box shows that they are not concerned
+ * are not read at all.
+ *
+ * The polylines are added with push_back() or append(), and are kept in
+ * memory until a chunk is full or until flush(), which every other
+ * operation calls first. The files are created in the directory given to
+ * the constructor, which must exist, and removed by the destructor.
+ */
+class Pattern_store {
+public:
+    /** @brief what is kept in memory of a chunk. A chunk without vertex has
+     * minimum values larger than its maximum values. */
+    struct Chunk {
+        std::string filename ;
+        long_unsigned_int size ;
+        long_unsigned_int vertices_size ;
+        double minimum_x ;
+        double minimum_y ;
+        double maximum_x ;
+        double maximum_y ;
+    } ;
+
+protected:
+    std::string directory ;
+
+    /** @brief the start of the names of the files, unique to this store. */
+    std::string prefix ;
+
+    long_unsigned_int chunk_size ;
+
+    /** @brief the number given to the next file. */
+    long_unsigned_int next_file {0} ;
+
+    std::vector<Chunk> chunks ;
+
+    /** @brief the polylines not yet written to a chunk. */
+    Pattern_packed pending ;
+
+    /** @brief writes p to the file of chunk, and sets its summary. The
+     * file is written under another name, then renamed. */
+    void write_chunk (Chunk &chunk, const Pattern_packed &p) ;
+
+    /** @brief throws bad_parametre if there is no chunk i. */
+    void check_chunk (const long_unsigned_int i) const ;
+
+    /** @brief whether chunk i may have polylines inside the window. */
+    bool chunk_meets_window (const long_unsigned_int i,
+                             const double xmin, const double ymin,
+                             const double xmax, const double ymax) const ;
+
+public:
+    /** @brief Constructor, for an empty store whose files are written in
+     * set_directory, in chunks of set_chunk_size polylines. */
+    Pattern_store (const std::string &set_directory,
+                   const long_unsigned_int set_chunk_size = 1048576) ;
+
+    Pattern_store (const Pattern_store &) = delete ;
+
+    Pattern_store &operator= (const Pattern_store &) = delete ;
+
+    /** @brief Destructor, removes the files. */
+    ~Pattern_store () ;
+
+    /** @brief adds a polyline at the end, with its selections. */
+    void push_back (const Polyline &p) ;
+
+    /** @brief adds the polylines of p at the end. */
+    void append (const Pattern &p) ;
+
+    /** @brief adds the polylines of p at the end. */
+    void append (const Pattern_packed &p) ;
+
+    /** @brief writes the pending polylines to a chunk. */
+    void flush () ;
+
+    /** @brief removes all the polylines and their files. */
+    void clear () ;
+
+    /** @brief number of polylines, including the pending ones. */
+    long_unsigned_int size () const ;
+
+    /** @brief number of vertices, including the pending ones. */
+    long_unsigned_int vertices_size () const ;
+
+    /** @brief number of chunks, after flush(). */
+    long_unsigned_int number_chunks () ;
+
+    const Chunk &get_chunk (const long_unsigned_int i) ;
+
+    /** @brief sets minimum_x to maximum_y to the bounding box of all the
+     * polylines, from the summaries of the chunks. They are left unchanged
+     * if there is no vertex. */
+    void limits (double &minimum_x, double &minimum_y,
+                 double &maximum_x, double &maximum_y) ;
+
+    /** @brief returns the polylines of chunk i. */
+    Pattern_packed load_chunk (const long_unsigned_int i) ;
+
+    /** @brief replaces the polylines of chunk i by p, which need not have
+     * the same number of polylines. */
+    void replace_chunk (const long_unsigned_int i, const Pattern_packed &p) ;
+
+    /** @brief calls f on each chunk in turn, and writes it back. */
+    void modify_chunks (const std::function<void (Pattern_packed &)> &f) ;
+
+    /** @brief calls f on each chunk in turn, without writing them back. */
+    void read_chunks (const std::function<void (const Pattern_packed &)> &f) ;
+
+    /** @brief see Pattern::translate(). The chunks are all rewritten. */
+    void translate (const double x0, const double y0,
+                    const selection_t selection = -1) ;
+
+    /** @brief see Pattern::set_dose(). The chunks are all rewritten. */
+    void set_dose (const double dose_value, const selection_t selection = -1) ;
+
+    /** @brief see Pattern::select_window() with dots_as_circles false. Only
+     * the chunks whose bounding box meets the window are read, and only
+     * those in which a polyline was selected are rewritten. */
+    void select_window (const double xmin, const double ymin,
+                        const double xmax, const double ymax,
+                        const selection_t selection = 0) ;
+
+    /** @brief appends to p the polylines lying entirely inside the window,
+     * see Reader_dpps::append_window_to_pattern(). Only the chunks whose
+     * bounding box meets the window are read. */
+    void append_window_to_pattern (Pattern &p,
+                                   const double xmin, const double ymin,
+                                   const double xmax, const double ymax) ;
+
+    /** @brief writes all the polylines with writer, one at a time as
+     * Pipeline does, between Writer::begin_stream() and
+     * Writer::end_stream(). The writer is not closed. */
+    void write_to (Writer &writer) ;
+} ;
+} // namespace dpps
+#endif
@@ -16,10 +16,15 @@
 
 #include <limits>
 #include <chrono>
+#include <fstream>
+#include <iterator>
+#include <string>
+#include <vector>
 
 #include <iostream> // debug only
 
 #include "util.hh"
+#include "Pattern_cache.hh"
 #include "Pattern_text.hh"
 //#include "font_Vollkorn.hh"
 //#include "font_Source_Sans_Pro.hh"
@@ -181,6 +186,22 @@ is an enum valued 0-3, got " + std::to_string (vint[2])} ;
                         vstring[0], vstring[1]) ;
 }
 
+// Appends to strings the name of filename and the hash of its contents, or
+// only its name if it cannot be read, in which case it returns false.
+static bool append_file_hash (const std::string &filename,
+                              std::vector<std::string> &strings) {
+    std::ifstream file (filename, std::ios_base::in|std::ios_base::binary) ;
+    if (!file. is_open ()) {
+        strings. push_back (filename) ;
+        return false ;
+    }
+    std::string contents ((std::istreambuf_iterator<char> (file)),
+                          std::istreambuf_iterator<char> ()) ;
+    strings. push_back (filename + " " + std::to_string (
+        dpps::Pattern_cache::hash (contents))) ;
+    return true ;
+}
+
 void dpps::Pattern_text::generate () {
     if (pattern_settings. text. empty ())
         return ;
@@ -204,6 +225,34 @@ void dpps::Pattern_text::generate () {
 
 //    replace_string (pattern_settings. text, "${space}", " ") ;
 //    replace_string (pattern_settings. text, "${comma}", ",") ;
+    // The characters are read from the font files of the working directory,
+    // so that their contents are part of the key. Without the strokes, the
+    // text is not cached, and generate_text() reports the missing file.
+    std::vector<std::string> key_strings {pattern_settings. font_name,
+                                          pattern_settings. text} ;
+    if ((!Pattern_cache::enabled ()) ||
+        (!append_file_hash (Typeface::font_file (pattern_settings. font_name),
+                            key_strings))) {
+        generate_text () ;
+        return ;
+    }
+    append_file_hash (Typeface::composition_file (pattern_settings. font_name),
+                      key_strings) ;
+    generate_cached ("Pattern_text",
+        {pattern_settings. utf8},
+        {static_cast<long_unsigned_int> (pattern_settings. stroke),
+         pattern_settings. variant,
+         static_cast<long_unsigned_int> (pattern_settings. align_x),
+         static_cast<long_unsigned_int> (pattern_settings. align_y)},
+        {pattern_settings. x0, pattern_settings. y0, pattern_settings. ex},
+        key_strings,
+        false,
+        [this] {
+            generate_text () ;
+        }) ;
+}
+
+void dpps::Pattern_text::generate_text () {
     std::string copy ;
     if (pattern_settings. utf8)
         copy = utf8toiso8859_1 (pattern_settings. text) ;
@@ -217,52 +266,50 @@ void dpps::Pattern_text::generate () {
         font. load () ;
     }
 
+    const Typeface::Glyphs &glyphs {*font. glyphs} ;
     double bottom {std::numeric_limits<double>::max()} ;
     double top {std::numeric_limits<double>::lowest()} ;
     double width {0.0} ;
     double caret {0.0} ;
-    double ratio {pattern_settings. ex / font. ex} ;
+    double ratio {pattern_settings. ex / glyphs. ex} ;
     Pattern left_aligned_text ;
-    // We first build a pattern with the text left-aligned.
+    long_unsigned_int number_polylines {0} ;
+    for (long_unsigned_int i = 0 ; i < copy. size () ; i++)
+        number_polylines += glyphs. font[static_cast<unsigned char> (copy [i])]. size () ;
+    left_aligned_text. polylines. reserve (number_polylines) ;
+    // We first build a pattern with the text left-aligned. The characters
+    // are shared by all the typefaces, so each one is copied, then placed.
     // std::cout << "copy: " << copy << "\n" ;
     for (long_unsigned_int i = 0 ; i < copy. size () ; i++) {
         // we want c in 0-255
         unsigned char c = copy [i] ;
         // Since c is 0-255, we avoid integer promotion problems when converting
         short unsigned int ic = static_cast<short unsigned int> (c) ;
-        character letter {font. get_character (c)} ;
+        // the reference &letter is used to avoid copy
+        const character &letter {glyphs. font [ic]} ;
         if ((c == ' ') || (static_cast<short unsigned int>(c) == 128)) {
             // if we have a space or a non-breaking space, we just move the caret.
-            caret += ratio * font. en ;
+            caret += ratio * glyphs. en ;
             continue ;
         }
         if (letter. size () == 0)
             continue ;
-//             {            std::string reason {"on character number " + std::to_string (i) +
-//             "of the argument, which is character number " +
-//             std::to_string(static_cast<short unsigned int> (c)) +
-//             "(" + std::to_string(c) + "), we got an empty Polyline from
-// Typeface, indicating that the font is not complete, which is inconsistent
-// with not having other exception before this one. This definitely should not
-// have happened and indicates an internal bug."} ;
-//             throw bad_parametre (reason. c_str ()) ;
-//         }
-        if (font. top [ic] > top)
-            top = font. top [ic] ;
-        if (font. bottom [ic] < bottom)
-            bottom = font. bottom [ic] ;
-        double left_letter {std::numeric_limits<double>::max()} ;
-        for (auto p: letter) {
-            double x0 {p. minimum_x ()} ;
-            if (x0 < left_letter)
-                left_letter = x0 ;
-        }
-        for (auto p: letter) {
-            p = ((p + Vertex (-left_letter, 0)) * ratio) + Vertex (caret, 0.0) ;
-            left_aligned_text. push_back (p) ;
+        if (glyphs. top [ic] > top)
+            top = glyphs. top [ic] ;
+        if (glyphs. bottom [ic] < bottom)
+            bottom = glyphs. bottom [ic] ;
+        const double left_letter {glyphs. left [ic]} ;
+        // the reference &p is used to avoid copy
+        for (auto &p: letter) {
+            left_aligned_text. polylines. push_back (p) ;
+            // the reference &v is used to avoid copy
+            for (auto &v: left_aligned_text. polylines. back (). vertices) {
+                v. x = (v. x - left_letter) * ratio + caret ;
+                v. y = v. y * ratio ;
+            }
         }
-        width = caret + ratio * font. right [ic] ;
-        caret = width + (ratio * font. em * space_size_em) ;
+        width = caret + ratio * glyphs. right [ic] ;
+        caret = width + (ratio * glyphs. em * space_size_em) ;
     }
     // Now we align this text
     double shift_x {0.0},
@@ -125,6 +125,10 @@ protected:
 
     /** @brief we will use a space of 0.2 em */
     double space_size_em {0.2} ;
+
+    /** @brief draws the text, once the ${...} sequences are replaced, see
+     * generate(), which may read it from Pattern_cache instead. */
+    void generate_text () ;
 public:
     /** @brief the default constructor */
     Pattern_text () ;
@@ -0,0 +1,162 @@
+/**
+ * @file Pipeline.cpp
+ * @author Jérôme Borme <jerome.borme@inl.int>
+ * @version 1.0
+ * @brief Implementation of class Pipeline
+ * @date 2026-10-14 Jérôme Borme: Initial version
+ * @copyright
+ * This Source Code Form is subject to the terms of the Mozilla Public
+ * License, v. 2.0. If a copy of the MPL was not distributed with this
+ * file, You can obtain one at http://mozilla.org/MPL/2.0/.
+ */
+
+#include "Pipeline.hh"
+
+dpps::Pipeline::Pipeline (Reader &set_reader, Writer &set_writer):
+    reader (&set_reader), writer (set_writer) {
+}
+
+dpps::Pipeline::Pipeline (Pattern &set_generator, Writer &set_writer):
+    generator (&set_generator), writer (set_writer) {
+}
+
+void dpps::Pipeline::flush_pending_transform () {
+    if (pending_transform. is_identity ())
+        return ;
+    Affine_transform transform {pending_transform} ;
+    stages. push_back ([transform] (Polyline &p) {
+        p. apply_transform (transform) ;
+        return true ;
+    }) ;
+    pending_transform. clear () ;
+}
+
+void dpps::Pipeline::add_stage (
+    const std::function<bool (Polyline &)> &stage) {
+    flush_pending_transform () ;
+    stages. push_back (stage) ;
+}
+
+void dpps::Pipeline::translate (const double x, const double y) {
+    pending_transform. translate (x, y) ;
+}
+
+void dpps::Pipeline::rotate (const double x, const double y,
+                             const double angle) {
+    pending_transform. rotate (x, y, angle) ;
+}
+
+void dpps::Pipeline::scale (const double x, const double y,
+                            const double fx, const double fy) {
+    pending_transform. scale (x, y, fx, fy) ;
+}
+
+void dpps::Pipeline::symmetry_x (const double y0) {
+    pending_transform. symmetry_x (y0) ;
+}
+
+void dpps::Pipeline::symmetry_y (const double x0) {
+    pending_transform. symmetry_y (x0) ;
+}
+
+void dpps::Pipeline::apply_transform (const Affine_transform &transform) {
+    pending_transform. then (transform) ;
+}
+
+void dpps::Pipeline::round_to (const double precision) {
+    add_stage ([precision] (Polyline &p) {
+        p. round_to (precision) ;
+        return true ;
+    }) ;
+}
+
+void dpps::Pipeline::subdivide (const double distance) {
+    add_stage ([distance] (Polyline &p) {
+        p. subdivide (distance) ;
+        return true ;
+    }) ;
+}
+
+void dpps::Pipeline::simplify (const double tolerance) {
+    add_stage ([tolerance] (Polyline &p) {
+        p. simplify (tolerance) ;
+        return true ;
+    }) ;
+}
+
+void dpps::Pipeline::set_dose (const double dose_value) {
+    add_stage ([dose_value] (Polyline &p) {
+        p. set_dose (dose_value) ;
+        return true ;
+    }) ;
+}
+
+void dpps::Pipeline::multiply_dose (const double multiplication_factor) {
+    add_stage ([multiplication_factor] (Polyline &p) {
+        p. multiply_dose (multiplication_factor) ;
+        return true ;
+    }) ;
+}
+
+void dpps::Pipeline::set_reference (
+    const long_unsigned_int reference_value) {
+    add_stage ([reference_value] (Polyline &p) {
+        p. set_reference (reference_value) ;
+        return true ;
+    }) ;
+}
+
+void dpps::Pipeline::keep_references (const long_unsigned_int minimum,
+                                      const long_unsigned_int maximum) {
+    add_stage ([minimum, maximum] (Polyline &p) {
+        return (p. reference >= minimum) && (p. reference <= maximum) ;
+    }) ;
+}
+
+void dpps::Pipeline::keep_minimum_size (
+    const long_unsigned_int minimum_size) {
+    add_stage ([minimum_size] (Polyline &p) {
+        return p. size () >= minimum_size ;
+    }) ;
+}
+
+void dpps::Pipeline::clear () {
+    stages. clear () ;
+    pending_transform. clear () ;
+}
+
+long_unsigned_int dpps::Pipeline::run () {
+    flush_pending_transform () ;
+    long_unsigned_int number_written {0} ;
+    auto process = [&] (Polyline &p) {
+        bool keep {true} ;
+        for (long_unsigned_int i {0} ; keep && (i < stages. size ()) ; i++)
+            keep = stages[i] (p) ;
+        if (keep) {
+            writer. write_Polyline_stream (p) ;
+            number_written++ ;
+        }
+    } ;
+    writer. begin_stream () ;
+    if (generator != nullptr) {
+        // The stages modify the polyline, which generate_each() passes as
+        // const, so it is copied into the same one each time.
+        Polyline p ;
+        generator-> generate_each ([&] (const Polyline &generated) {
+            p = generated ;
+            process (p) ;
+        }) ;
+    } else {
+        bool ok {true} ;
+        while (ok) {
+            // A new polyline each time, as in Reader::append_to_pattern(), as
+            // read_polyline() expects an empty one.
+            Polyline p ;
+            ok = reader-> read_polyline (p) ;
+            if (ok)
+                process (p) ;
+        }
+    }
+    writer. end_stream () ;
+    return number_written ;
+}
@@ -0,0 +1,139 @@
+/**
+ * @file Pipeline.hh
+ * @author Jérôme Borme <jerome.borme@inl.int>
+ * @version 1.0
+ * @brief Header file for class Pipeline, a streaming Reader to Writer chain
+ * @date 2026-10-14 Jérôme Borme: Initial version
+ * @copyright
+ * This Source Code Form is subject to the terms of the Mozilla Public
+ * License, v. 2.0. If a copy of the MPL was not distributed with this
+ * file, You can obtain one at http://mozilla.org/MPL/2.0/.
+ */
+#ifndef DPPS_PIPELINE
+#define DPPS_PIPELINE
+
+#include <vector>
+#include <functional>
+
+#include "common.hh"
+#include "Polyline.hh"
+#include "Affine_transform.hh"
+#include "Reader.hh"
+#include "Writer.hh"
+
+namespace dpps {
+/** @brief Converts a file polyline by polyline, without building a Pattern.
+ *
+ * A conversion usually reads the whole file into a Pattern with
+ * Reader::append_to_pattern(), transforms it, then writes it with
+ * Writer::write_Pattern(). For large files, the Pattern may not fit in
+ * memory. A Pipeline instead reads one polyline with Reader::read_polyline(),
+ * passes it through a list of stages, then sends it to the Writer with
+ * Writer::write_Polyline_stream(), so that only one polyline is in memory
+ * at a time on this side. The Writer may still have to keep its formatted
+ * output until it is closed, when the header depends on the whole file (see
+ * Writer::body).
+ *
+ * Stages are run in the order they are added. Consecutive geometrical
+ * transformations are composed into a single Affine_transform, applied
+ * in one pass over the vertices.
+ *
+ * The polylines may also come from a generator, through
+ * Pattern::generate_each(), so that a generated pattern is transformed and
+ * written without being kept.
+ *
+ * Polylines need to be processed one at a time, so operations involving
+ * several polylines (sorting, merging, removing duplicates) are not
+ * available.
+ */
+class Pipeline {
+protected:
+    /** @brief the source of the polylines, either reader or generator. */
+    Reader *reader {nullptr} ;
+    Pattern *generator {nullptr} ;
+    Writer &writer ;
+
+    /** @brief the stages, each returning whether the polyline is kept. */
+    std::vector<std::function<bool (Polyline &)>> stages ;
+
+    /** @brief the geometrical transformations added since the last stage,
+     * not yet in stages. */
+    Affine_transform pending_transform ;
+
+    /** @brief adds pending_transform to stages, if it is not the
+     * identity, and resets it. */
+    void flush_pending_transform () ;
+
+    /** @brief adds a stage after the pending transformation. */
+    void add_stage (const std::function<bool (Polyline &)> &stage) ;
+public:
+    /** @brief Constructor. The reader and the writer must be open, and they
+     * must outlive the Pipeline. */
+    Pipeline (Reader &set_reader, Writer &set_writer) ;
+
+    /** @brief Constructor taking the polylines from
+     * Pattern::generate_each() of set_generator instead of a reader. The
+     * writer must be open, and both must outlive the Pipeline. */
+    Pipeline (Pattern &set_generator, Writer &set_writer) ;
+
+    /** @brief see Polyline::translate(). */
+    void translate (const double x, const double y) ;
+
+    /** @brief see Polyline::rotate(). */
+    void rotate (const double x, const double y, const double angle) ;
+
+    /** @brief see Polyline::scale(). */
+    void scale (const double x, const double y,
+                const double fx, const double fy) ;
+
+    /** @brief see Polyline::symmetry_x(). */
+    void symmetry_x (const double y0) ;
+
+    /** @brief see Polyline::symmetry_y(). */
+    void symmetry_y (const double x0) ;
+
+    /** @brief see Polyline::apply_transform(). */
+    void apply_transform (const Affine_transform &transform) ;
+
+    /** @brief see Polyline::round_to(). */
+    void round_to (const double precision) ;
+
+    /** @brief see Polyline::subdivide(). */
+    void subdivide (const double distance) ;
+
+    /** @brief see Polyline::simplify(). */
+    void simplify (const double tolerance) ;
+
+    /** @brief see Polyline::set_dose(). */
+    void set_dose (const double dose_value) ;
+
+    /** @brief see Polyline::multiply_dose(). */
+    void multiply_dose (const double multiplication_factor) ;
+
+    /** @brief see Polyline::set_reference(). */
+    void set_reference (const long_unsigned_int reference_value) ;
+
+    /** @brief only keeps the polylines whose reference is between minimum
+     * and maximum, included.
+     *
+     * With Reader_DXF_R12 and set_reference_from_layer, the reference is the
+     * layer number, so this also filters layers. */
+    void keep_references (const long_unsigned_int minimum,
+                          const long_unsigned_int maximum) ;
+
+    /** @brief only keeps the polylines having at least minimum_size
+     * vertices. */
+    void keep_minimum_size (const long_unsigned_int minimum_size) ;
+
+    /** @brief removes all the stages. */
+    void clear () ;
+
+    /** @brief reads all the remaining polylines, or generates them, passes
+     * them through the stages and writes those which were kept, between
+     * Writer::begin_stream() and Writer::end_stream().
+     *
+     * Returns the number of polylines written. The writer is not closed. */
+    long_unsigned_int run () ;
+} ;
+} // namespace dpps
+#endif
@@ -0,0 +1,880 @@
+/**
+ * @file Polygon_boolean.cpp
+ * @author Jérôme Borme <jerome.borme@inl.int>
+ * @version 1.0
+ * @brief Class Polygon_boolean, which computes the union, intersection,
+ * difference and exclusive or of sets of polygons
+ * @date 2026-10-14 Jérôme Borme: Initial version
+ * @copyright
+ * This Source Code Form is subject to the terms of the Mozilla Public
+ * License, v. 2.0. If a copy of the MPL was not distributed with this
+ * file, You can obtain one at http://mozilla.org/MPL/2.0/.
+ */
+
+#include <cmath>
+#include <limits>
+#include <algorithm>
+#include <exception>
+#include <functional>
+#include <queue>
+#include <set>
+
+#include "configure.h"
+#include "Polygon_boolean.hh"
+
+// Above this number of edges, the plane is divided into bands of about this
+// number of edges, swept in parallel. The bands do not depend on the number
+// of threads, so neither does the result.
+static const long_unsigned_int edges_per_band {50000} ;
+static const long_unsigned_int maximum_bands {256} ;
+
+// Cutting edges at their crossings moves them by rounding errors, which may
+// make them cross other edges. This is how many times, on average, the
+// neighbours of an edge are compared again after such a cut at each ordinate.
+static const long_unsigned_int maximum_crossing_passes {64} ;
+
+// Vertices closer than this to an edge, relative to their coordinates, are
+// taken to be on it. Consecutive parts of a contour at angles below this, in
+// radians, are joined, and contours thinner than this relative to their size
+// are removed: they come from rounding errors.
+static const double relative_tolerance {1e-12} ;
+
+static bool before (const dpps::Vertex &v, const dpps::Vertex &w) {
+    return (v. x < w. x) || ((v. x == w. x) && (v. y < w. y)) ;
+}
+
+// Container is a std::vector<Vertex> or the Vertex_vector of a Polyline.
+template <class Container>
+static double contour_area (const Container &contour) {
+    double result {0} ;
+    long_unsigned_int n {contour. size ()} ;
+    for (long_unsigned_int i {0} ; i < n ; i++) {
+        const dpps::Vertex &v {contour[i]}, &w {contour[(i + 1) % n]} ;
+        result += v. x * w. y - w. x * v. y ;
+    }
+    return result / 2.0 ;
+}
+
+// Removes the repeated vertices, and the vertices on a straight line between
+// their neighbours.
+static void simplify_contour (std::vector<dpps::Vertex> &contour) {
+    using dpps::Vertex ;
+    auto straight = [] (const Vertex &u, const Vertex &v, const Vertex &w) {
+        double ax {v. x - u. x}, ay {v. y - u. y} ;
+        double bx {w. x - v. x}, by {w. y - v. y} ;
+        // the middle vertex is repeated or between the others
+        if (((ax == 0) && (ay == 0)) || ((bx == 0) && (by == 0)))
+            return true ;
+        return (fabs (ax * by - ay * bx) <= relative_tolerance *
+                    sqrt ((ax * ax + ay * ay) * (bx * bx + by * by))) &&
+               (ax * bx + ay * by > 0) ;
+    } ;
+    std::vector<Vertex> result ;
+    result. reserve (contour. size ()) ;
+    // the reference &v is used to avoid copy
+    for (auto &v: contour) {
+        while ((result. size () >= 2) &&
+               straight (result[result. size () - 2], result. back (), v))
+            result. pop_back () ;
+        if (result. empty () || (result. back () != v))
+            result. push_back (v) ;
+    }
+    // the same around the first vertex
+    bool changed {true} ;
+    while (changed && (result. size () >= 3)) {
+        changed = false ;
+        long_unsigned_int n {result. size ()} ;
+        if (straight (result[n - 2], result[n - 1], result[0])) {
+            result. pop_back () ;
+            changed = true ;
+        } else if (straight (result[n - 1], result[0], result[1])) {
+            result. erase (result. begin ()) ;
+            changed = true ;
+        }
+    }
+    contour = std::move (result) ;
+}
+
+double dpps::Polygon_boolean::x_at (const Edge &e, const double y) {
+    if (y == e. bottom. y)
+        return e. bottom. x ;
+    if (y == e. top. y)
+        return e. top. x ;
+    return e. bottom. x + (y - e. bottom. y) * (e. top. x - e. bottom. x) /
+                          (e. top. y - e. bottom. y) ;
+}
+
+void dpps::Polygon_boolean::add_polyline (const Polyline &polyline,
+                                          const bool set_b) {
+    long_unsigned_int n {polyline. size ()} ;
+    if (n < 3)
+        return ;
+    double area {contour_area (polyline. vertices)} ;
+    if (area == 0)
+        return ;
+    // with the polyline counterclockwise
+    int8_t down {static_cast<int8_t> ((area > 0) ? 1 : -1)} ;
+    for (long_unsigned_int i {0} ; i < n ; i++) {
+        // the last vertex is followed by the first one
+        const Vertex &v {polyline. vertices[i]}, &w {polyline. vertices[(i + 1) % n]} ;
+        if (v. y == w. y) {
+            if (v. x != w. x)
+                horizontals. push_back (Horizontal {v. y, std::min (v. x, w. x),
+                                                    std::max (v. x, w. x)}) ;
+            continue ;
+        }
+        if (v. y > w. y)
+            edges. push_back (Edge {w, v, down, set_b}) ;
+        else
+            edges. push_back (Edge {v, w, static_cast<int8_t> (-down), set_b}) ;
+    }
+}
+
+bool dpps::Polygon_boolean::inside (const long int a, const long int b) const {
+    bool in_a {a > 0}, in_b {b > 0} ;
+    switch (operation) {
+        case boolean_operation_union:
+            return in_a || in_b ;
+        case boolean_operation_intersection:
+            return in_a && in_b ;
+        case boolean_operation_difference:
+            return in_a && !in_b ;
+        case boolean_operation_xor:
+            return in_a != in_b ;
+        default:
+            return false ;
+    }
+}
+
+void dpps::Polygon_boolean::sweep_band (std::vector<Edge> &band_edges,
+    const std::vector<Horizontal> &band_horizontals,
+    const double bottom, const double top, Band_result &band) const {
+    // The sweep line is ordered by the abscissas at y, then by the
+    // direction of the edges. The probe, at abscissa probe_x, comes after
+    // the edges at the same abscissa.
+    const long_unsigned_int probe {std::numeric_limits<long_unsigned_int>::max ()} ;
+    double y {0}, probe_x {0} ;
+    auto abscissa = [&] (const long_unsigned_int i) {
+        return (i == probe) ? probe_x : x_at (band_edges[i], y) ;
+    } ;
+    auto left_of = [&] (const long_unsigned_int i, const long_unsigned_int j) {
+        double xi {abscissa (i)}, xj {abscissa (j)} ;
+        if (xi != xj)
+            return xi < xj ;
+        if ((i == probe) || (j == probe))
+            return j == probe ;
+        const Edge &e {band_edges[i]}, &f {band_edges[j]} ;
+        double turn {(e. top. x - e. bottom. x) * (f. top. y - f. bottom. y) -
+                     (f. top. x - f. bottom. x) * (e. top. y - e. bottom. y)} ;
+        if (turn != 0)
+            return turn < 0 ;
+        return i < j ;
+    } ;
+    typedef std::set<long_unsigned_int, std::function<bool (
+        long_unsigned_int, long_unsigned_int)>> Sweep_line ;
+    Sweep_line line (left_of) ;
+
+    // the edges not yet reached, the lowest first, and the edges of the
+    // line by their top, which an edge may have several times when it is
+    // cut
+    auto higher = [&band_edges] (const long_unsigned_int i,
+                                 const long_unsigned_int j) {
+        return band_edges[i]. bottom. y > band_edges[j]. bottom. y ;
+    } ;
+    std::priority_queue<long_unsigned_int, std::vector<long_unsigned_int>,
+                        std::function<bool (long_unsigned_int,
+                                            long_unsigned_int)>> waiting (higher) ;
+    std::priority_queue<std::pair<double, long_unsigned_int>,
+                        std::vector<std::pair<double, long_unsigned_int>>,
+                        std::greater<std::pair<double, long_unsigned_int>>> ending ;
+    std::set<double> ordinates ;
+
+    // For each edge, its place in the line, the winding numbers on its
+    // left, whether it is on the contour, going up (1) or down (-1), and
+    // where this part of the contour started.
+    std::vector<Sweep_line::iterator> place ;
+    std::vector<bool> in_line ;
+    std::vector<long int> left_a, left_b ;
+    std::vector<int8_t> state ;
+    std::vector<Vertex> start ;
+    std::vector<bool> marked ;
+    auto add_edge = [&] (const Edge &e) {
+        band_edges. push_back (e) ;
+        place. push_back (line. end ()) ;
+        in_line. push_back (false) ;
+        left_a. push_back (0) ;
+        left_b. push_back (0) ;
+        state. push_back (0) ;
+        start. push_back (Vertex ()) ;
+        marked. push_back (false) ;
+        waiting. push (band_edges. size () - 1) ;
+        if (e. bottom. y > y)
+            ordinates. insert (e. bottom. y) ;
+        ordinates. insert (e. top. y) ;
+    } ;
+    y = std::numeric_limits<double>::lowest () ;
+    std::vector<Edge> initial ;
+    initial. swap (band_edges) ;
+    band_edges. reserve (initial. size ()) ;
+    // the reference &e is used to avoid copy
+    for (auto &e: initial)
+        add_edge (e) ;
+    initial. clear () ;
+
+    auto end_part = [&] (const long_unsigned_int i) {
+        if (state[i] == 0)
+            return ;
+        Vertex end {x_at (band_edges[i], y), y} ;
+        if (state[i] > 0)
+            band. segments. push_back (Segment {start[i], end}) ;
+        else
+            band. segments. push_back (Segment {end, start[i]}) ;
+        state[i] = 0 ;
+    } ;
+    // the winding numbers on the right of edge i
+    auto right_a = [&] (const long_unsigned_int i) {
+        const Edge &e {band_edges[i]} ;
+        return left_a[i] + (e. set_b ? 0 : e. winding) ;
+    } ;
+    auto right_b = [&] (const long_unsigned_int i) {
+        const Edge &e {band_edges[i]} ;
+        return left_b[i] + (e. set_b ? e. winding : 0) ;
+    } ;
+    // the parts of [x1, x2] inside the result, on the current line
+    auto covered = [&] (const double x1, const double x2, Intervals &result) {
+        result. clear () ;
+        probe_x = x1 ;
+        Sweep_line::iterator p {line. upper_bound (probe)} ;
+        bool in {(p == line. begin ()) ? inside (0, 0) :
+                 inside (right_a (*std::prev (p)), right_b (*std::prev (p)))} ;
+        double from {x1} ;
+        for ( ; (p != line. end ()) && (abscissa (*p) < x2) ; p++) {
+            bool now {inside (right_a (*p), right_b (*p))} ;
+            if (now == in)
+                continue ;
+            if (now)
+                from = abscissa (*p) ;
+            else
+                result. push_back (std::make_pair (from, abscissa (*p))) ;
+            in = now ;
+        }
+        if (in)
+            result. push_back (std::make_pair (from, x2)) ;
+    } ;
+    // Cuts edge i at v, above y, the part above v waiting to be inserted.
+    auto cut = [&] (const long_unsigned_int i, const Vertex &v) {
+        Edge upper {band_edges[i]} ;
+        upper. bottom = v ;
+        // The edge keeps the same abscissa at y.
+        if (band_edges[i]. bottom. y < y)
+            band_edges[i]. bottom = Vertex (x_at (band_edges[i], y), y) ;
+        band_edges[i]. top = v ;
+        ending. push (std::make_pair (v. y, i)) ;
+        add_edge (upper) ;
+    } ;
+    // Cuts edges i and j, i being on the left, where they cross, and
+    // returns whether they cross.
+    auto cross = [&] (const long_unsigned_int i, const long_unsigned_int j) {
+        const Edge &e {band_edges[i]}, &f {band_edges[j]} ;
+        double y_max {std::min (e. top. y, f. top. y)} ;
+        double xi_top {x_at (e, y_max)}, xj_top {x_at (f, y_max)} ;
+        if (xi_top <= xj_top)
+            return false ;
+        double xi {x_at (e, y)}, xj {x_at (f, y)} ;
+        // i is on the left at y and on the right at y_max, so t is between
+        // 0 and 1
+        double t {(xj > xi) ? (xj - xi) / ((xj - xi) + (xi_top - xj_top)) : 0} ;
+        Vertex v {xi + t * (xi_top - xi), y + t * (y_max - y)} ;
+        v. y = std::max (v. y, std::nextafter (y,
+                         std::numeric_limits<double>::max ())) ;
+        if (v. y >= y_max) {
+            // The edges meet where one of them ends.
+            if ((e. top. y == y_max) && (f. top. y != y_max))
+                v = e. top ;
+            else if ((f. top. y == y_max) && (e. top. y != y_max))
+                v = f. top ;
+            else {
+                v. y = std::nextafter (y_max, std::numeric_limits<double>::lowest ()) ;
+                if (v. y <= y)
+                    return false ;
+            }
+        }
+        bool cut_i {v. y < e. top. y}, cut_j {v. y < f. top. y} ;
+        if (cut_i)
+            cut (i, v) ;
+        if (cut_j)
+            cut (j, v) ;
+        return true ;
+    } ;
+
+    std::vector<long_unsigned_int> ended, started, dirty, check ;
+    std::vector<Vertex> vertices ;
+    std::vector<std::pair<double, double>> ranges ;
+    std::vector<Intervals> below_ranges ;
+    Intervals above_range ;
+    long_unsigned_int next_horizontal {0} ;
+    while (!ordinates. empty ()) {
+        y = *ordinates. begin () ;
+        ordinates. erase (ordinates. begin ()) ;
+        ended. clear () ;
+        started. clear () ;
+        while (!ending. empty () && (ending. top (). first <= y)) {
+            long_unsigned_int i {ending. top (). second} ;
+            ending. pop () ;
+            // an edge which has been cut since
+            if (!in_line[i] || (band_edges[i]. top. y != y) || marked[i])
+                continue ;
+            marked[i] = true ;
+            ended. push_back (i) ;
+        }
+        auto take_waiting = [&] () {
+            while (!waiting. empty () &&
+                   (band_edges[waiting. top ()]. bottom. y <= y)) {
+                started. push_back (waiting. top ()) ;
+                waiting. pop () ;
+            }
+        } ;
+        take_waiting () ;
+        // The edges going through a vertex, within rounding errors, are cut
+        // there.
+        vertices. clear () ;
+        for (auto i: ended)
+            vertices. push_back (band_edges[i]. top) ;
+        for (auto i: started)
+            vertices. push_back (band_edges[i]. bottom) ;
+        std::sort (vertices. begin (), vertices. end (), before) ;
+        vertices. erase (std::unique (vertices. begin (), vertices. end (),
+            [] (const Vertex &v, const Vertex &w) {
+                return (v. x == w. x) && (v. y == w. y) ;
+            }), vertices. end ()) ;
+        // the reference &v is used to avoid copy
+        for (auto &v: vertices) {
+            double tolerance {relative_tolerance * (fabs (v. x) + fabs (y))} ;
+            probe_x = v. x - tolerance ;
+            for (Sweep_line::iterator p {line. upper_bound (probe)} ;
+                 (p != line. end ()) && (abscissa (*p) <= v. x + tolerance) ;
+                 p++) {
+                long_unsigned_int i {*p} ;
+                if (marked[i])
+                    continue ;
+                Edge upper {band_edges[i]} ;
+                upper. bottom = v ;
+                band_edges[i]. top = v ;
+                add_edge (upper) ;
+                marked[i] = true ;
+                ended. push_back (i) ;
+            }
+        }
+        take_waiting () ;
+        // The parts of the contour along the horizontal edges are found by
+        // comparing what is covered below and above them.
+        ranges. clear () ;
+        while ((next_horizontal < band_horizontals. size ()) &&
+               (band_horizontals[next_horizontal]. y <= y)) {
+            const Horizontal &h {band_horizontals[next_horizontal++]} ;
+            if (!ranges. empty () && (h. x1 <= ranges. back (). second))
+                ranges. back (). second = std::max (ranges. back (). second,
+                                                    h. x2) ;
+            else
+                ranges. push_back (std::make_pair (h. x1, h. x2)) ;
+        }
+        dirty. clear () ;
+        below_ranges. resize (ranges. size ()) ;
+        for (long_unsigned_int k {0} ; k < ranges. size () ; k++) {
+            covered (ranges[k]. first, ranges[k]. second, below_ranges[k]) ;
+            // the edges crossing a horizontal edge have other winding
+            // numbers above it
+            probe_x = ranges[k]. first ;
+            for (Sweep_line::iterator p {line. upper_bound (probe)} ;
+                 (p != line. end ()) && (abscissa (*p) < ranges[k]. second) ;
+                 p++)
+                if (!marked[*p]) {
+                    marked[*p] = true ;
+                    dirty. push_back (*p) ;
+                }
+        }
+        if (y == top)
+            covered (std::numeric_limits<double>::lowest (),
+                     std::numeric_limits<double>::max (), band. top) ;
+        check. clear () ;
+        for (auto i: ended) {
+            end_part (i) ;
+            if (place[i] != line. begin ())
+                check. push_back (*std::prev (place[i])) ;
+            line. erase (place[i]) ;
+            in_line[i] = false ;
+            marked[i] = false ;
+        }
+        for (auto i: started) {
+            place[i] = line. insert (i). first ;
+            in_line[i] = true ;
+            ending. push (std::make_pair (band_edges[i]. top. y, i)) ;
+            dirty. push_back (i) ;
+            check. push_back (i) ;
+            if (place[i] != line. begin ())
+                check. push_back (*std::prev (place[i])) ;
+        }
+        // the winding numbers of the edges inserted or crossing a horizontal
+        // edge, from left to right
+        std::sort (dirty. begin (), dirty. end (), left_of) ;
+        for (auto i: dirty) {
+            marked[i] = false ;
+            if (place[i] == line. begin ()) {
+                left_a[i] = 0 ;
+                left_b[i] = 0 ;
+            } else {
+                long_unsigned_int l {*std::prev (place[i])} ;
+                left_a[i] = right_a (l) ;
+                left_b[i] = right_b (l) ;
+            }
+        }
+        // Edges from the same vertex in the same direction are on the
+        // contour together, which the first one stands for.
+        auto together = [&] (const long_unsigned_int i, const long_unsigned_int j) {
+            const Edge &e {band_edges[i]}, &f {band_edges[j]} ;
+            return (e. bottom. x == f. bottom. x) && (e. bottom. y == f. bottom. y) &&
+                   ((e. top. x - e. bottom. x) * (f. top. y - f. bottom. y) ==
+                    (f. top. x - f. bottom. x) * (e. top. y - e. bottom. y)) ;
+        } ;
+        for (auto i: dirty) {
+            int8_t wanted {0} ;
+            if ((place[i] == line. begin ()) ||
+                !together (*std::prev (place[i]), i)) {
+                Sweep_line::iterator last {place[i]} ;
+                for (Sweep_line::iterator p {std::next (last)} ;
+                     (p != line. end ()) && together (i, *p) ; p++)
+                    last = p ;
+                bool in {inside (left_a[i], left_b[i])} ;
+                bool now {inside (right_a (*last), right_b (*last))} ;
+                // the result is on the left of the contour
+                if (now != in)
+                    wanted = now ? -1 : 1 ;
+            }
+            end_part (i) ;
+            state[i] = wanted ;
+            start[i] = Vertex (x_at (band_edges[i], y), y) ;
+        }
+        if (y == bottom)
+            covered (std::numeric_limits<double>::lowest (),
+                     std::numeric_limits<double>::max (), band. bottom) ;
+        for (long_unsigned_int k {0} ; k < ranges. size () ; k++) {
+            covered (ranges[k]. first, ranges[k]. second, above_range) ;
+            horizontal_segments (below_ranges[k], above_range, y,
+                                 band. segments) ;
+        }
+        // The edges which are new neighbours are compared. When edges are
+        // cut, they are compared with their neighbours again, which is only
+        // repeated many times in pathological cases.
+        long_unsigned_int remaining {maximum_crossing_passes * (check. size () + 1)} ;
+        while (!check. empty () && (remaining > 0)) {
+            remaining-- ;
+            long_unsigned_int i {check. back ()} ;
+            check. pop_back () ;
+            if (!in_line[i])
+                continue ;
+            Sweep_line::iterator next {std::next (place[i])} ;
+            if (next == line. end ())
+                continue ;
+            long_unsigned_int j {*next} ;
+            if (cross (i, j)) {
+                if (place[i] != line. begin ())
+                    check. push_back (*std::prev (place[i])) ;
+                check. push_back (j) ;
+            }
+        }
+    }
+}
+
+void dpps::Polygon_boolean::horizontal_segments (const Intervals &below,
+    const Intervals &above, const double y, std::vector<Segment> &segments) {
+    // the limits of the intervals, with which side changes there
+    std::vector<std::pair<double, int>> limits ;
+    limits. reserve (2 * (below. size () + above. size ())) ;
+    // the reference &i is used to avoid copy
+    for (auto &i: below) {
+        limits. push_back (std::make_pair (i. first, 1)) ;
+        limits. push_back (std::make_pair (i. second, 1)) ;
+    }
+    for (auto &i: above) {
+        limits. push_back (std::make_pair (i. first, 2)) ;
+        limits. push_back (std::make_pair (i. second, 2)) ;
+    }
+    std::sort (limits. begin (), limits. end ()) ;
+    int covered {0} ;
+    for (long_unsigned_int k {0} ; k < limits. size () ; ) {
+        double x {limits[k]. first} ;
+        for ( ; (k < limits. size ()) && (limits[k]. first == x) ; k++)
+            covered ^= limits[k]. second ;
+        if (k == limits. size ())
+            break ;
+        double next {limits[k]. first} ;
+        // The result is below the segment if it goes to negative x.
+        if (covered == 1)
+            segments. push_back (Segment {Vertex (next, y), Vertex (x, y)}) ;
+        if (covered == 2)
+            segments. push_back (Segment {Vertex (x, y), Vertex (next, y)}) ;
+    }
+}
+
+std::vector<std::vector<dpps::Vertex>> dpps::Polygon_boolean::join_segments (
+    const std::vector<Segment> &segments) {
+    long_unsigned_int n {segments. size ()} ;
+    std::vector<long_unsigned_int> by_start (n) ;
+    for (long_unsigned_int i {0} ; i < n ; i++)
+        by_start[i] = i ;
+    std::sort (by_start. begin (), by_start. end (),
+        [&] (const long_unsigned_int i, const long_unsigned_int j) {
+            return before (segments[i]. start, segments[j]. start) ;
+        }) ;
+    std::vector<bool> used (n, false) ;
+    std::vector<std::vector<Vertex>> result ;
+    for (long_unsigned_int s {0} ; s < n ; s++) {
+        if (used[s])
+            continue ;
+        std::vector<Vertex> contour ;
+        long_unsigned_int current {s} ;
+        while (true) {
+            used[current] = true ;
+            contour. push_back (segments[current]. start) ;
+            const Vertex &v {segments[current]. end} ;
+            if ((v. x == segments[s]. start. x) && (v. y == segments[s]. start. y))
+                break ;
+            // Where several segments start from v, the one turning most to
+            // the left is taken, so that contours touching at a vertex stay
+            // separate.
+            auto range = std::equal_range (by_start. begin (), by_start. end (),
+                n, [&] (const long_unsigned_int i, const long_unsigned_int j) {
+                    const Vertex &a {(i == n) ? v : segments[i]. start} ;
+                    const Vertex &b {(j == n) ? v : segments[j]. start} ;
+                    return before (a, b) ;
+                }) ;
+            const Vertex &u {segments[current]. start} ;
+            double back {atan2 (u. y - v. y, u. x - v. x)} ;
+            double best_turn {std::numeric_limits<double>::max ()} ;
+            long_unsigned_int best {n} ;
+            for (auto p = range. first ; p != range. second ; p++) {
+                if (used[*p])
+                    continue ;
+                const Vertex &w {segments[*p]. end} ;
+                double turn {back - atan2 (w. y - v. y, w. x - v. x)} ;
+                while (turn <= 0)
+                    turn += 2 * M_PI ;
+                while (turn > 2 * M_PI)
+                    turn -= 2 * M_PI ;
+                if (turn < best_turn) {
+                    best_turn = turn ;
+                    best = *p ;
+                }
+            }
+            // This only happens if rounding errors left the contour open.
+            if (best == n)
+                break ;
+            current = best ;
+        }
+        simplify_contour (contour) ;
+        if (contour. size () < 3)
+            continue ;
+        // contours thinner than rounding errors
+        double minx {contour[0]. x}, maxx {minx}, miny {contour[0]. y},
+               maxy {miny} ;
+        // the reference &v is used to avoid copy
+        for (auto &v: contour) {
+            minx = std::min (minx, v. x) ;
+            maxx = std::max (maxx, v. x) ;
+            miny = std::min (miny, v. y) ;
+            maxy = std::max (maxy, v. y) ;
+        }
+        double size {std::max (maxx - minx, maxy - miny)} ;
+        if (fabs (contour_area (contour)) <= relative_tolerance * size * size)
+            continue ;
+        result. push_back (std::move (contour)) ;
+    }
+    return result ;
+}
+
+std::vector<std::vector<dpps::Vertex>> dpps::Polygon_boolean::join_holes (
+    std::vector<std::vector<Vertex>> &contours) {
+    long_unsigned_int number_contours {contours. size ()} ;
+    std::vector<bool> hole (number_contours) ;
+    // where the contours start: the leftmost vertex for the holes
+    std::vector<long_unsigned_int> first (number_contours, 0) ;
+    for (long_unsigned_int c {0} ; c < number_contours ; c++) {
+        hole[c] = contour_area (contours[c]) < 0 ;
+        if (hole[c])
+            for (long_unsigned_int i {1} ; i < contours[c]. size () ; i++)
+                if (before (contours[c][i], contours[c][first[c]]))
+                    first[c] = i ;
+    }
+    // For each hole, the first edge on the left of its leftmost vertex is
+    // found with a sweep line, with the edges taken from their lowest
+    // ordinate included to their highest excluded.
+    struct Contour_edge {
+        Vertex low ;
+        Vertex high ;
+        long_unsigned_int contour ;
+        long_unsigned_int index ;
+    } ;
+    std::vector<Contour_edge> all_edges ;
+    for (long_unsigned_int c {0} ; c < number_contours ; c++) {
+        long_unsigned_int n {contours[c]. size ()} ;
+        for (long_unsigned_int i {0} ; i < n ; i++) {
+            const Vertex &a {contours[c][i]}, &b {contours[c][(i + 1) % n]} ;
+            if (a. y < b. y)
+                all_edges. push_back (Contour_edge {a, b, c, i}) ;
+            else if (a. y > b. y)
+                all_edges. push_back (Contour_edge {b, a, c, i}) ;
+        }
+    }
+    long_unsigned_int number_edges {all_edges. size ()} ;
+    std::vector<long_unsigned_int> by_low (number_edges), by_high (number_edges) ;
+    for (long_unsigned_int i {0} ; i < number_edges ; i++) {
+        by_low[i] = i ;
+        by_high[i] = i ;
+    }
+    std::sort (by_low. begin (), by_low. end (),
+        [&] (const long_unsigned_int i, const long_unsigned_int j) {
+            return all_edges[i]. low. y < all_edges[j]. low. y ;
+        }) ;
+    std::sort (by_high. begin (), by_high. end (),
+        [&] (const long_unsigned_int i, const long_unsigned_int j) {
+            return all_edges[i]. high. y < all_edges[j]. high. y ;
+        }) ;
+    std::vector<long_unsigned_int> holes ;
+    for (long_unsigned_int c {0} ; c < number_contours ; c++)
+        if (hole[c])
+            holes. push_back (c) ;
+    std::sort (holes. begin (), holes. end (),
+        [&] (const long_unsigned_int g, const long_unsigned_int h) {
+            return contours[g][first[g]]. y < contours[h][first[h]]. y ;
+        }) ;
+    const long_unsigned_int probe {std::numeric_limits<long_unsigned_int>::max ()} ;
+    double y {0}, probe_x {0} ;
+    auto abscissa = [&] (const long_unsigned_int i) {
+        if (i == probe)
+            return probe_x ;
+        const Contour_edge &e {all_edges[i]} ;
+        if (y == e. low. y)
+            return e. low. x ;
+        return e. low. x + (y - e. low. y) * (e. high. x - e. low. x) /
+                           (e. high. y - e. low. y) ;
+    } ;
+    // The contours do not cross, so the order does not change.
+    auto left_of = [&] (const long_unsigned_int i, const long_unsigned_int j) {
+        double xi {abscissa (i)}, xj {abscissa (j)} ;
+        if (xi != xj)
+            return xi < xj ;
+        if ((i == probe) || (j == probe))
+            return j == probe ;
+        const Contour_edge &e {all_edges[i]}, &f {all_edges[j]} ;
+        double turn {(e. high. x - e. low. x) * (f. high. y - f. low. y) -
+                     (f. high. x - f. low. x) * (e. high. y - e. low. y)} ;
+        if (turn != 0)
+            return turn < 0 ;
+        return i < j ;
+    } ;
+    std::set<long_unsigned_int, std::function<bool (
+        long_unsigned_int, long_unsigned_int)>> line (left_of) ;
+    std::vector<decltype (line. begin ())> place (number_edges, line. end ()) ;
+
+    // the cuts from each contour to the holes, by the edge where they start
+    // counted from the start of the contour, and along the edge
+    struct Cut {
+        long_unsigned_int edge ;
+        double along ;
+        Vertex at ;
+        long_unsigned_int hole ;
+    } ;
+    std::vector<std::vector<Cut>> cuts (number_contours) ;
+    long_unsigned_int next_low {0}, next_high {0} ;
+    for (auto h: holes) {
+        const Vertex &v {contours[h][first[h]]} ;
+        y = v. y ;
+        while ((next_high < number_edges) &&
+               (all_edges[by_high[next_high]]. high. y <= y)) {
+            long_unsigned_int i {by_high[next_high++]} ;
+            if (place[i] != line. end ()) {
+                line. erase (place[i]) ;
+                place[i] = line. end () ;
+            }
+        }
+        while ((next_low < number_edges) &&
+               (all_edges[by_low[next_low]]. low. y <= y)) {
+            long_unsigned_int i {by_low[next_low++]} ;
+            if (all_edges[i]. high. y > y)
+                place[i] = line. insert (i). first ;
+        }
+        probe_x = v. x ;
+        auto p = line. upper_bound (probe) ;
+        // the edges of the hole itself start at v
+        while ((p != line. begin ()) &&
+               (all_edges[*std::prev (p)]. contour == h))
+            p-- ;
+        // This only happens if rounding errors put the hole outside, and it
+        // is then left out.
+        if (p == line. begin ())
+            continue ;
+        const Contour_edge &e {all_edges[*std::prev (p)]} ;
+        Vertex at {abscissa (*std::prev (p)), y} ;
+        long_unsigned_int n {contours[e. contour]. size ()} ;
+        const Vertex &a {contours[e. contour][e. index]} ;
+        cuts[e. contour]. push_back (Cut {(e. index + n - first[e. contour]) % n,
+            fabs (at. x - a. x) + fabs (at. y - a. y), at, h}) ;
+    }
+    // the reference &c is used to avoid copy
+    for (auto &c: cuts)
+        std::sort (c. begin (), c. end (), [] (const Cut &u, const Cut &w) {
+            return (u. edge < w. edge) ||
+                   ((u. edge == w. edge) && (u. along < w. along)) ;
+        }) ;
+
+    // Each outer contour is written with its holes, and their own holes,
+    // each hole going from the cut around the hole and back to the cut.
+    struct Position {
+        long_unsigned_int contour ;
+        long_unsigned_int step ;
+        long_unsigned_int next_cut ;
+        Vertex at ;
+    } ;
+    std::vector<std::vector<Vertex>> result ;
+    std::vector<Position> stack ;
+    for (long_unsigned_int o {0} ; o < number_contours ; o++) {
+        if (hole[o])
+            continue ;
+        std::vector<Vertex> ring ;
+        stack. push_back (Position {o, 0, 0, Vertex ()}) ;
+        while (!stack. empty ()) {
+            Position &p {stack. back ()} ;
+            const std::vector<Vertex> &c {contours[p. contour]} ;
+            long_unsigned_int n {c. size ()} ;
+            // the cuts from the edge after the last vertex written
+            if ((p. next_cut < cuts[p. contour]. size ()) &&
+                (cuts[p. contour][p. next_cut]. edge < p. step)) {
+                const Cut &cut {cuts[p. contour][p. next_cut++]} ;
+                ring. push_back (cut. at) ;
+                stack. push_back (Position {cut. hole, 0, 0, cut. at}) ;
+                continue ;
+            }
+            // The holes come back to their first vertex.
+            if (p. step < (hole[p. contour] ? n + 1 : n)) {
+                ring. push_back (c[(first[p. contour] + p. step) % n]) ;
+                p. step++ ;
+                continue ;
+            }
+            if (hole[p. contour])
+                ring. push_back (p. at) ;
+            stack. pop_back () ;
+        }
+        std::vector<Vertex> simple ;
+        simple. reserve (ring. size ()) ;
+        // the reference &v is used to avoid copy
+        for (auto &v: ring)
+            if (simple. empty () || (simple. back (). x != v. x) ||
+                (simple. back (). y != v. y))
+                simple. push_back (v) ;
+        while ((simple. size () > 1) && (simple. back (). x == simple. front (). x) &&
+               (simple. back (). y == simple. front (). y))
+            simple. pop_back () ;
+        result. push_back (std::move (simple)) ;
+    }
+    return result ;
+}
+
+dpps::Polygon_boolean::Polygon_boolean (
+    const std::vector<const Polyline *> &a,
+    const std::vector<const Polyline *> &b,
+    const enum_boolean_operation set_operation):
+    operation (set_operation) {
+    // the reference &p is used to avoid copy
+    for (auto &p: a)
+        add_polyline (*p, false) ;
+    for (auto &p: b)
+        add_polyline (*p, true) ;
+    if (edges. empty ())
+        return ;
+    // The bands are limited by ordinates of vertices, with about the same
+    // number of edges starting in each band.
+    long_unsigned_int number_bands {std::min (
+        edges. size () / edges_per_band + 1, maximum_bands)} ;
+    std::vector<double> limits ;
+    if (number_bands > 1) {
+        std::vector<double> bottoms ;
+        bottoms. reserve (edges. size ()) ;
+        // the reference &e is used to avoid copy
+        for (auto &e: edges)
+            bottoms. push_back (e. bottom. y) ;
+        std::sort (bottoms. begin (), bottoms. end ()) ;
+        for (long_unsigned_int k {1} ; k < number_bands ; k++) {
+            double y {bottoms[k * bottoms. size () / number_bands]} ;
+            if (limits. empty () || (y > limits. back ()))
+                limits. push_back (y) ;
+        }
+        number_bands = limits. size () + 1 ;
+    }
+    // The edges are cut at the limits of the bands, so that each band can
+    // be swept on its own.
+    std::vector<std::vector<Edge>> band_edges (number_bands) ;
+    // the reference &e is used to avoid copy
+    for (auto &e: edges) {
+        long_unsigned_int k (std::upper_bound (limits. begin (), limits. end (),
+                                               e. bottom. y) - limits. begin ()) ;
+        Edge part {e} ;
+        for ( ; (k < limits. size ()) && (limits[k] < e. top. y) ; k++) {
+            Vertex cut {x_at (e, limits[k]), limits[k]} ;
+            part. top = cut ;
+            band_edges[k]. push_back (part) ;
+            part. bottom = cut ;
+        }
+        part. top = e. top ;
+        band_edges[k]. push_back (part) ;
+    }
+    // The horizontal edges at the limits are taken into account when the
+    // bands are joined.
+    std::sort (horizontals. begin (), horizontals. end (),
+        [] (const Horizontal &h, const Horizontal &g) {
+            return (h. y < g. y) || ((h. y == g. y) && (h. x1 < g. x1)) ;
+        }) ;
+    std::vector<std::vector<Horizontal>> band_horizontals (number_bands) ;
+    // the reference &h is used to avoid copy
+    for (auto &h: horizontals) {
+        long_unsigned_int k (std::lower_bound (limits. begin (), limits. end (),
+                                               h. y) - limits. begin ()) ;
+        if ((k == limits. size ()) || (limits[k] != h. y))
+            band_horizontals[k]. push_back (h) ;
+    }
+    std::vector<Band_result> bands (number_bands) ;
+    std::vector<std::exception_ptr> errors (number_bands) ;
+    // Bands are not the same size, so they are distributed one by one.
+#ifdef OPENMP_FOUND
+    #pragma omp parallel for schedule(dynamic, 1) if (number_bands > 1)
+#endif
+    for (long_unsigned_int k = 0 ; k < number_bands ; k++) {
+        try {
+            double bottom {(k == 0) ? std::numeric_limits<double>::lowest () :
+                                      limits[k-1]} ;
+            double top {(k == number_bands - 1) ?
+                        std::numeric_limits<double>::max () : limits[k]} ;
+            sweep_band (band_edges[k], band_horizontals[k], bottom, top,
+                        bands[k]) ;
+        } catch (...) {
+            errors[k] = std::current_exception () ;
+        }
+    }
+    for (auto &e: errors)
+        if (e)
+            std::rethrow_exception (e) ;
+    std::vector<Segment> segments ;
+    for (long_unsigned_int k {0} ; k < number_bands ; k++) {
+        segments. insert (segments. end (), bands[k]. segments. begin (),
+                          bands[k]. segments. end ()) ;
+        if (k > 0)
+            horizontal_segments (bands[k-1]. top, bands[k]. bottom,
+                                 limits[k-1], segments) ;
+    }
+    std::vector<std::vector<Vertex>> joined {join_segments (segments)} ;
+    result = join_holes (joined) ;
+}
+
+const std::vector<std::vector<dpps::Vertex>> &
+    dpps::Polygon_boolean::contours () const {
+    return result ;
+}
@@ -0,0 +1,148 @@
+/**
+ * @file Polygon_boolean.hh
+ * @author Jérôme Borme <jerome.borme@inl.int>
+ * @version 1.0
+ * @brief Header file for class Polygon_boolean, which computes the union,
+ * intersection, difference and exclusive or of sets of polygons
+ * @date 2026-10-14 Jérôme Borme: Initial version
+ * @copyright
+ * This Source Code Form is subject to the terms of the Mozilla Public
+ * License, v. 2.0. If a copy of the MPL was not distributed with this
+ * file, You can obtain one at http://mozilla.org/MPL/2.0/.
+ */
+#ifndef DPPS_POLYGON_BOOLEAN
+#define DPPS_POLYGON_BOOLEAN
+
+#include <cstdint>
+#include <utility>
+#include <vector>
+
+#include "common.hh"
+#include "Vertex.hh"
+#include "Polyline.hh"
+// for enum_boolean_operation
+#include "Pattern.hh"
+
+namespace dpps {
+/** @brief Computes a boolean operation between two sets of polygons, A and
+ * B.
+ *
+ * A point is inside a set when it is inside at least one of its polygons.
+ * Each polyline is taken to be closed, and is oriented counterclockwise
+ * before the operation, so the orientation of the polygons does not matter.
+ * The polygons should not be self-crossing: the parts of a self-crossing
+ * polygon turning in the other direction than the larger part are outside.
+ *
+ * The plane is swept from bottom to top, with the edges crossing the sweep
+ * line kept in order from left to right. As in the algorithm of Bentley and
+ * Ottmann (J. L. Bentley and T. A. Ottmann, Algorithms for reporting and
+ * counting geometric intersections, IEEE Transactions on Computers C-28
+ * (1979)), only neighbouring edges are compared, and edges are cut where
+ * they cross. Between its cuts, each part of an edge has the same winding
+ * numbers of A and B on its left, which are taken from its left neighbour
+ * when it is inserted and tell whether it is on the contour of the result.
+ * These parts are then joined into contours. The time is O((n + k) log n)
+ * for n edges and k crossings. When compiled with OpenMP, the plane is
+ * divided into horizontal bands which are swept in parallel.
+ *
+ * Vertices closer than rounding errors to an edge are taken to be on it,
+ * and the edge is cut there.
+ *
+ * The result is made of counterclockwise contours. As the polylines of dpps
+ * cannot have holes, each hole is joined to the contour around it by a
+ * horizontal cut going from the leftmost vertex of the hole to the left, so
+ * that the result can be exposed directly.
+ */
+class Polygon_boolean {
+protected:
+    /** @brief an edge, from its lower to its upper vertex. winding is +1 if
+     * the polygon goes down along the edge, so that its inside is on the
+     * right, and -1 otherwise. */
+    struct Edge {
+        Vertex bottom ;
+        Vertex top ;
+        int8_t winding ;
+        bool set_b ;
+    } ;
+
+    /** @brief a part of the contour of the result, going from start to end
+     * with the result on its left. */
+    struct Segment {
+        Vertex start ;
+        Vertex end ;
+    } ;
+
+    /** @brief a horizontal edge, which does not change the winding
+     * numbers but may be on the contour. */
+    struct Horizontal {
+        double y ;
+        double x1 ;
+        double x2 ;
+    } ;
+
+    /** @brief covered parts of a horizontal line, sorted in x. */
+    typedef std::vector<std::pair<double, double>> Intervals ;
+
+    /** @brief what a horizontal band leaves to join with its neighbours:
+     * the covered parts just above its lowest ordinate, and just below
+     * its highest. */
+    struct Band_result {
+        std::vector<Segment> segments ;
+        Intervals bottom ;
+        Intervals top ;
+    } ;
+
+    enum_boolean_operation operation ;
+
+    std::vector<Edge> edges ;
+
+    std::vector<Horizontal> horizontals ;
+
+    std::vector<std::vector<Vertex>> result ;
+
+    /** @brief abscissa of edge e at ordinate y, exactly its vertices at their
+     * ordinates. */
+    static double x_at (const Edge &e, const double y) ;
+
+    /** @brief adds the edges of polyline, oriented counterclockwise. */
+    void add_polyline (const Polyline &polyline, const bool set_b) ;
+
+    /** @brief whether a point inside a polygons of A and b polygons of B is
+     * in the result. */
+    bool inside (const long int a, const long int b) const ;
+
+    /** @brief sweeps the edges of a band between bottom and top, which are
+     * all inside it. The horizontal edges are those strictly inside, sorted
+     * by y. */
+    void sweep_band (std::vector<Edge> &band_edges,
+                     const std::vector<Horizontal> &band_horizontals,
+                     const double bottom, const double top,
+                     Band_result &band) const ;
+
+    /** @brief adds to segments the horizontal parts of the contour at y,
+     * between the parts covered just below and just above. */
+    static void horizontal_segments (const Intervals &below,
+                                     const Intervals &above, const double y,
+                                     std::vector<Segment> &segments) ;
+
+    /** @brief joins the segments into closed contours. */
+    static std::vector<std::vector<Vertex>> join_segments (
+        const std::vector<Segment> &segments) ;
+
+    /** @brief joins each clockwise contour, which is a hole, to the
+     * contour around it. */
+    static std::vector<std::vector<Vertex>> join_holes (
+        std::vector<std::vector<Vertex>> &contours) ;
+public:
+    /** @brief Constructor, which computes the result. The polylines with
+     * less than three vertices are ignored. */
+    Polygon_boolean (const std::vector<const Polyline *> &a,
+                     const std::vector<const Polyline *> &b,
+                     const enum_boolean_operation set_operation) ;
+
+    /** @brief the contours of the result, counterclockwise, without the
+     * first vertex repeated at the end. */
+    const std::vector<std::vector<Vertex>> &contours () const ;
+} ;
+} // namespace dpps
+#endif
@@ -18,13 +18,19 @@
 #include <limits>
 #include <errno.h>
 #include <algorithm> // std::reverse
+#include <functional>
+#include <iterator>
+#include <set>
+#include <utility>
 
 #include <iostream> // debug
 
 #include "configure.h"
 #include "common.hh"
 #include "Polyline.hh"
+#include "Vertex_grid.hh"
 #include "bad_math.hh"
+#include "bad_parametre.hh"
 
 dpps::Polyline::Polyline () {
 }
@@ -232,6 +238,29 @@ void dpps::Polyline::push_back (const dpps::Polyline& p) {
                       p. vertices. end()) ;
 }
 
+void dpps::Polyline::push_back_coordinates (
+    const std::vector<double> &coordinates) {
+    if (coordinates. size () % 2 != 0) {
+        std::string reason {"Polyline::push_back_coordinates, coordinates \
+go by pairs x, y, but " + std::to_string (coordinates. size ()) + " were given."} ;
+        throw bad_parametre (reason. c_str ()) ;
+    }
+    long_unsigned_int n {coordinates. size () / 2} ;
+    vertices. reserve (vertices. size () + n) ;
+    for (long_unsigned_int i {0} ; i < n ; i++)
+        vertices. push_back (Vertex (coordinates[2*i], coordinates[2*i + 1])) ;
+}
+
+std::vector<double> dpps::Polyline::get_coordinates () const {
+    std::vector<double> result ;
+    result. reserve (2 * vertices. size ()) ;
+    for (auto &v : vertices) {
+        result. push_back (v. x) ;
+        result. push_back (v. y) ;
+    }
+    return result ;
+}
+
 /////////////////////////////////
 // const informative functions //
 /////////////////////////////////
@@ -360,16 +389,17 @@ dpps::Vertex dpps::Polyline::geometrical_centre () const {
                    cy {0},
                    factor {0},
                    six_area {6*q. algebraic_area ()} ;
-            q. push_back (q. vertices. front ()) ;
+            const Vertex *v {q. vertices. data ()} ;
 //             std::cout << "6area=" << six_area << "\n" ;
             for (long_unsigned_int i {0} ; i < s ; i++) {
 //                 std::cout << "We use vertice_i " << q. vertices[i].display_string() << "\n" ;
 //                 std::cout << "We use vertice_i+1 " << q. vertices[i+1].display_string() << "\n" ;
-                factor = ((q. vertices[i].x   * q. vertices[i+1].y) -
-                          (q. vertices[i+1].x * q. vertices[i].y)) ;
+                // the last vertex is followed by the first one
+                long_unsigned_int j {(i + 1 == s) ? 0 : i + 1} ;
+                factor = ((v[i].x * v[j].y) - (v[j].x * v[i].y)) ;
 //                 std::cout << "factor=" << factor << "\n" ;
-                cx += (q. vertices[i].x + q. vertices[i+1].x) * factor ;
-                cy += (q. vertices[i].y + q. vertices[i+1].y) * factor ;
+                cx += (v[i].x + v[j].x) * factor ;
+                cy += (v[i].y + v[j].y) * factor ;
 //                 std::cout << "cx=" << cx << "\n" ;
 //                 std::cout << "cy=" << cy << "\n" ;
             }
@@ -381,35 +411,34 @@ dpps::Vertex dpps::Polyline::geometrical_centre () const {
     }
 }
 
+// The reductions below are written with std::min and std::max rather than
+// with a test and an assignment, so that the compiler can turn them into
+// vector instructions.
 double dpps::Polyline::minimum_x () const {
     double minx {std::numeric_limits<double>::max ()} ;
     for (auto &v : vertices)
-        if (v. x < minx)
-            minx = v. x ;
+        minx = std::min (minx, v. x) ;
     return minx ;
 }
 
 double dpps::Polyline::maximum_x () const {
     double maxx {std::numeric_limits<double>::lowest ()} ;
     for (auto &v : vertices)
-        if (v. x > maxx)
-            maxx = v. x ;
+        maxx = std::max (maxx, v. x) ;
     return maxx ;
 }
 
 double dpps::Polyline::minimum_y () const {
     double miny {std::numeric_limits<double>::max ()} ;
     for (auto &v : vertices)
-        if (v. y < miny)
-            miny = v. y ;
+        miny = std::min (miny, v. y) ;
     return miny ;
 }
 
 double dpps::Polyline::maximum_y () const {
     double maxy {std::numeric_limits<double>::lowest ()} ;
     for (auto &v : vertices)
-        if (v. y > maxy)
-            maxy = v. y ;
+        maxy = std::max (maxy, v. y) ;
     return maxy ;
 }
 
@@ -422,14 +451,10 @@ void dpps::Polyline::limits (double &minx, double &miny,
     miny = std::numeric_limits<double>::max () ;
     maxy = std::numeric_limits<double>::lowest () ;
     for (auto &v : vertices) {
-        if (v. x < minx)
-            minx = v. x ;
-        if (v. x > maxx)
-            maxx = v. x ;
-        if (v. y < miny)
-            miny = v. y ;
-        if (v. y > maxy)
-            maxy = v. y ;
+        minx = std::min (minx, v. x) ;
+        maxx = std::max (maxx, v. x) ;
+        miny = std::min (miny, v. y) ;
+        maxy = std::max (maxy, v. y) ;
     }
 }
 
@@ -437,10 +462,8 @@ dpps::Vertex dpps::Polyline::lower_left () const {
     double minx {std::numeric_limits<double>::max ()} ;
     double miny {std::numeric_limits<double>::max ()} ;
     for (auto &v : vertices) {
-        if (v. x < minx)
-            minx = v. x ;
-        if (v. y < miny)
-            miny = v. y ;
+        minx = std::min (minx, v. x) ;
+        miny = std::min (miny, v. y) ;
     }
     return Vertex (minx, miny) ;
 }
@@ -449,10 +472,8 @@ dpps::Vertex dpps::Polyline::upper_right () const {
     double maxx {std::numeric_limits<double>::lowest ()} ;
     double maxy {std::numeric_limits<double>::lowest ()} ;
     for (auto &v : vertices) {
-        if (v. x > maxx)
-            maxx = v. x ;
-        if (v. y > maxy)
-            maxy = v. y ;
+        maxx = std::max (maxx, v. x) ;
+        maxy = std::max (maxy, v. y) ;
     }
     return Vertex (maxx, maxy) ;
 }
@@ -497,12 +518,44 @@ double dpps::Polyline::minimum_distance () const {
     return sqrt (mind2) ;
 }
 
+namespace {
+// square of the distance from v to the segment from a to b
+double segment_distance_square (const dpps::Vertex &v, const dpps::Vertex &a,
+                                const dpps::Vertex &b) {
+    dpps::Vertex ab {b - a} ;
+    dpps::Vertex av {v - a} ;
+    double l2 {ab. norm2_square ()} ;
+    double t {(l2 > 0) ? (av * ab) / l2 : 0.0} ;
+    if (t < 0)
+        t = 0 ;
+    else if (t > 1)
+        t = 1 ;
+    return (av - ab * t). norm2_square () ;
+}
+} // namespace
+
+double dpps::Polyline::distance_to (const Vertex &v) const {
+    if (vertices. empty ())
+        return std::numeric_limits<double>::infinity () ;
+    double mind2 {(vertices. front () - v). norm2_square ()} ;
+    long_unsigned_int n {vertices. size ()} ;
+    // the closing segment is the one from the last vertex to the first
+    long_unsigned_int segments {(closed && (n > 2)) ? n : n - 1} ;
+    for (long_unsigned_int i = 0 ; i < segments ; i++) {
+        double d2 {segment_distance_square (v, vertices[i],
+                                            vertices[(i + 1) % n])} ;
+        if (d2 < mind2)
+            mind2 = d2 ;
+    }
+    return sqrt (mind2) ;
+}
+
 double dpps::Polyline::perimeter () const {
     if (vertices. size () <= 1)
         return 0.0 ;
     double s {length ()} ;
-    double dx {vertices. at (0). x - vertices. at (vertices. size ()-1). x} ;
-    double dy {vertices. at (0). y - vertices. at (vertices. size ()-1). y} ;
+    double dx {vertices. front (). x - vertices. back (). x} ;
+    double dy {vertices. front (). y - vertices. back (). y} ;
     s += sqrt (dx*dx + dy*dy) ;
     return s ;
 }
@@ -512,9 +565,11 @@ double dpps::Polyline::length () const {
         return 0.0 ;
     double s {0.0},
            dx, dy ;
-    for (long_unsigned_int i = 0 ; i < vertices. size () - 1 ; i++) {
-        dx = vertices. at (i+1). x - vertices. at (i). x ;
-        dy = vertices. at (i+1). y - vertices. at (i). y ;
+    const Vertex *v {vertices. data ()} ;
+    long_unsigned_int n {vertices. size () - 1} ;
+    for (long_unsigned_int i = 0 ; i < n ; i++) {
+        dx = v[i+1]. x - v[i]. x ;
+        dy = v[i+1]. y - v[i]. y ;
         s += sqrt (dx*dx + dy*dy) ;
     }
     return s ;
@@ -539,25 +594,27 @@ double dpps::Polyline::algebraic_perimeter () const {
 
 // http://www.wikihow.com/Calculate-the-Area-of-a-Polygon
 double dpps::Polyline::algebraic_area () const {
-    Polyline q {*this} ;
-    //std::cout << "We calculate area of " << q. display_string () << "\n" ;
+    //std::cout << "We calculate area of " << display_string () << "\n" ;
 //    if (is_self_crossing())  {
         //q. reorder_vertices_by_angle() ;
 //         std::cout << "Now in order : " << q. display_string () << "\n" ;
 //    }
 
-    if (q. vertices. size () <= 2)
+    if (vertices. size () <= 2)
         return 0.0 ;
+    // No copy of the polyline, and a single pass over the vertices. s and t
+    // are still summed separately and in the same order, so that the result
+    // does not change.
     double s {0.0},
            t {0.0} ;
-    for (long_unsigned_int i = 0 ; i < q. vertices. size () - 1 ; i++) {
-        s += q. vertices. at (i). x * q. vertices. at (i+1). y ;
+    const Vertex *v {vertices. data ()} ;
+    long_unsigned_int n {vertices. size () - 1} ;
+    for (long_unsigned_int i = 0 ; i < n ; i++) {
+        s += v[i]. x * v[i+1]. y ;
+        t += v[i]. y * v[i+1]. x ;
     }
-    s += q. vertices. at (q. vertices. size () - 1). x * q. vertices. at (0). y ;
-    for (long_unsigned_int i = 0 ; i < q. vertices. size () - 1 ; i++) {
-        t += q. vertices. at (i). y * q. vertices. at (i+1). x ;
-    }
-    t += q. vertices. at (q. vertices. size () - 1). y * q. vertices. at (0). x ;
+    s += v[n]. x * v[0]. y ;
+    t += v[n]. y * v[0]. x ;
     return ((s-t)/2.0) ;
 }
 
@@ -752,18 +809,24 @@ void dpps::Polyline::remove_consecutive_duplicated_vertices (
 void dpps::Polyline::remove_duplicated_vertices (double precision) {
 //     if (precision <= 0)
 //         precision = std::numeric_limits<double>::epsilon() ;
+    if (vertices. size () <= 1)
+        return ;
     std::vector<dpps::Vertex> result ;
-    result. push_back (vertices. at (0)) ;
-    for (long unsigned i = 1 ; i < vertices. size () ; i++) {
+    Vertex_grid grid (precision, Vertex_grid::maximum_coordinate (vertices)) ;
+    std::vector<long_unsigned_int> candidates ;
+    // the reference &v is used to avoid copy
+    for (auto &v: vertices) {
         bool duplicated {false} ;
-        for (long unsigned j = 0 ; j < result. size () ; j++) {
-            if (vertices[i]. equals_to (result[j], precision)) {
+        grid. neighbours (v, candidates) ;
+        for (auto j: candidates)
+            if (v. equals_to (result[j], precision)) {
                 duplicated = true ;
                 break ;
             }
+        if (!duplicated) {
+            grid. insert (v, result. size ()) ;
+            result. push_back (v) ;
         }
-        if (!duplicated)
-            result. push_back (vertices[i]) ;
     }
     vertices = std::move(result) ;
 }
@@ -926,6 +989,78 @@ double dpps::Polyline::get_double_property (
     return 0.0 ;
 }
 
+void dpps::Polyline::get_double_properties (
+                const std::vector<enum_double_property> &properties,
+                const long_unsigned_int parametre,
+                std::vector<double> &values) const {
+    values. resize (properties. size ()) ;
+    // Same values as minimum_x () etc. for an empty polyline.
+    double minx {std::numeric_limits<double>::max ()} ;
+    double miny {std::numeric_limits<double>::max ()} ;
+    double maxx {std::numeric_limits<double>::lowest ()} ;
+    double maxy {std::numeric_limits<double>::lowest ()} ;
+    Vertex centre {0.0, 0.0} ;
+    bool have_limits {false} ;
+    bool have_centre {false} ;
+    for (long_unsigned_int i {0} ; i < properties. size () ; i++) {
+        switch (properties[i]) {
+            case double_property_minimum_x:
+            case double_property_maximum_x:
+            case double_property_minimum_y:
+            case double_property_maximum_y:
+            case double_property_horizontal_size:
+            case double_property_vertical_size:
+                if (!have_limits) {
+                    limits (minx, miny, maxx, maxy) ;
+                    have_limits = true ;
+                }
+                break ;
+            case double_property_geometrical_centre_x:
+            case double_property_geometrical_centre_y:
+            case double_property_distance_to_centre:
+                if (!have_centre) {
+                    centre = geometrical_centre () ;
+                    have_centre = true ;
+                }
+                break ;
+            default:
+                break ;
+        }
+        switch (properties[i]) {
+            case double_property_minimum_x:
+                values[i] = minx ;
+                break ;
+            case double_property_maximum_x:
+                values[i] = maxx ;
+                break ;
+            case double_property_minimum_y:
+                values[i] = miny ;
+                break ;
+            case double_property_maximum_y:
+                values[i] = maxy ;
+                break ;
+            case double_property_horizontal_size:
+                values[i] = maxx - minx ;
+                break ;
+            case double_property_vertical_size:
+                values[i] = maxy - miny ;
+                break ;
+            case double_property_geometrical_centre_x:
+                values[i] = centre. x ;
+                break ;
+            case double_property_geometrical_centre_y:
+                values[i] = centre. y ;
+                break ;
+            case double_property_distance_to_centre:
+                values[i] = centre. norm2 () ;
+                break ;
+            default:
+                values[i] = get_double_property (properties[i], parametre) ;
+                break ;
+        }
+    }
+}
+
 long_unsigned_int dpps::Polyline::get_integer_property (
                 const enum_integer_property property,
                 const long_unsigned_int parametre) const {
@@ -1020,58 +1155,59 @@ bool dpps::Polyline::multicriteria_less_than (
 //     p1. display() ;
 //     std::cout << "p2 :\n" ;
 //     p2. display() ;
-    std::array<dpps::Polyline, 2> polys {{*this, p}} ;
+    // pointers, so that the two polylines are not copied.
+    std::array<const dpps::Polyline *, 2> polys {{this, &p}} ;
     std::array<double, 2> res ;
     for (auto property : sort_order) {
         for (int i = 0 ; i < 2 ; i++) {
             switch (property) {
                 case dpps::double_property_minimum_x:
-                    res[i] = polys[i]. minimum_x () ;
+                    res[i] = polys[i]-> minimum_x () ;
                     break ;
                 case dpps::double_property_maximum_x:
-                    res[i] = polys[i]. maximum_x () ;
+                    res[i] = polys[i]-> maximum_x () ;
                     break ;
                 case dpps::double_property_minimum_y:
-                    res[i] = polys[i]. minimum_y () ;
+                    res[i] = polys[i]-> minimum_y () ;
                     break ;
                 case dpps::double_property_maximum_y:
-                    res[i] = polys[i]. maximum_y () ;
+                    res[i] = polys[i]-> maximum_y () ;
                     break ;
                 case dpps::double_property_geometrical_centre_x:
-                    res[i] = polys[i]. geometrical_centre (). x ;
+                    res[i] = polys[i]-> geometrical_centre (). x ;
                     break ;
                 case dpps::double_property_geometrical_centre_y:
-                    res[i] = polys[i]. geometrical_centre (). y ;
+                    res[i] = polys[i]-> geometrical_centre (). y ;
                     break ;
                 case dpps::double_property_distance_to_centre:
-                    res[i] = polys[i]. geometrical_centre (). norm2() ;
+                    res[i] = polys[i]-> geometrical_centre (). norm2() ;
                     break ;
                 case dpps::double_property_horizontal_size:
-                    res[i] = polys[i]. horizontal_size () ;
+                    res[i] = polys[i]-> horizontal_size () ;
                     break ;
                 case dpps::double_property_vertical_size:
-                    res[i] = polys[i]. vertical_size () ;
+                    res[i] = polys[i]-> vertical_size () ;
                     break ;
                 case dpps::double_property_minimum_distance:
-                    res[i] = polys[i]. minimum_distance () ;
+                    res[i] = polys[i]-> minimum_distance () ;
                     break ;
                 case dpps::double_property_maximum_distance:
-                    res[i] = polys[i]. maximum_distance () ;
+                    res[i] = polys[i]-> maximum_distance () ;
                     break ;
                 case dpps::double_property_orientation_at_vertex:
-                    res[i] = polys[i]. orientation_at_vertex (0) ;
+                    res[i] = polys[i]-> orientation_at_vertex (0) ;
                     break ;
                 case dpps::double_property_turning_angle_at_vertex:
-                    res[i] = polys[i]. turning_angle_at_vertex (0) ;
+                    res[i] = polys[i]-> turning_angle_at_vertex (0) ;
                     break ;
                 case dpps::double_property_area:
-                    res[i] = polys[i]. area () ;
+                    res[i] = polys[i]-> area () ;
                     break ;
                 case dpps::double_property_perimeter:
-                    res[i] = polys[i]. perimeter () ;
+                    res[i] = polys[i]-> perimeter () ;
                     break ;
                 case dpps::double_property_dose:
-                    res[i] = polys[i]. dose ;
+                    res[i] = polys[i]-> dose ;
                 //default:
                     break ;
             }
@@ -1115,34 +1251,198 @@ bool dpps::Polyline::is_convex () const {
     return true ;
 }
 
+// A segment of is_self_crossing(), from its lowest vertex in (x, y) order to
+// the other one. number is the position of the segment in the polyline.
+struct Sweep_segment {
+    dpps::Vertex left ;
+    dpps::Vertex right ;
+    long_unsigned_int number ;
+} ;
+
+// Ordinate of s on the sweep line at (x, y). Vertical segments are taken at
+// the ordinate of the sweep, so that they are above the segments they cross
+// only after the point where they cross them.
+static double sweep_ordinate (const Sweep_segment &s,
+                              const double x, const double y) {
+    if (s. left. x == s. right. x)
+        return std::min (std::max (y, s. left. y), s. right. y) ;
+    // the vertices are used exactly, so that segments joining at a vertex
+    // are at the same ordinate there
+    if (x == s. left. x)
+        return s. left. y ;
+    if (x == s. right. x)
+        return s. right. y ;
+    return s. left. y + (x - s. left. x) * (s. right. y - s. left. y) /
+                        (s. right. x - s. left. x) ;
+}
+
+static double sweep_slope (const Sweep_segment &s) {
+    if (s. left. x == s. right. x)
+        return std::numeric_limits<double>::infinity () ;
+    return (s. right. y - s. left. y) / (s. right. x - s. left. x) ;
+}
+
+// Whether the segments have a common point, other than a common vertex.
+// The turns are those of Vertex::intersects(), which also returns true for
+// collinear segments that do not overlap.
+static bool sweep_segments_cross (const Sweep_segment &s,
+                                  const Sweep_segment &t) {
+    const dpps::Vertex &u {s. left}, &v {s. right}, &w {t. left}, &z {t. right} ;
+    if (u. equals_to (w) || u. equals_to (z) ||
+        v. equals_to (w) || v. equals_to (z))
+        return false ;
+    short signed int uvw {v. turn (u, w)} ;
+    short signed int uvz {v. turn (u, z)} ;
+    if (uvw * uvz > 0)
+        return false ;
+    short signed int uzw {z. turn (w, u)} ;
+    short signed int wzv {z. turn (w, v)} ;
+    if (uzw * wzv > 0)
+        return false ;
+    if ((uvw != 0) || (uvz != 0) || (uzw != 0) || (wzv != 0))
+        return true ;
+    // collinear: the segments are ordered in (x, y) order
+    return !((t. right. x < s. left. x) ||
+             ((t. right. x == s. left. x) && (t. right. y < s. left. y)) ||
+             (s. right. x < t. left. x) ||
+             ((s. right. x == t. left. x) && (s. right. y < t. left. y))) ;
+}
+
 bool dpps::Polyline::is_self_crossing () const {
-    // We'll use the simple O(n^2) approach determining if segments have
-    // intersection. We need to know whether segments intersect, but
-    // we do not need to know where.
-    // There is a simpler solution than computing the position of the
-    // intersection. I found this mentioned here:
-    // http://math.stackexchange.com/questions/80798/detecting-polygon-self-intersection
-    // So Vertex::intersect() was implemented by comparison of determinants,
-    // following http://algs4.cs.princeton.edu/91primitives/
+    // Shamos and Hoey sweep line, in O(n log n): the segments are sorted
+    // along a line swept in x, and only segments which are neighbours on
+    // the sweep line are tested. If some segments cross, the first crossing
+    // is found before the sweep line passes it.
+    // M. I. Shamos and D. Hoey, Geometric intersection problems,
+    // 17th Annual Symposium on Foundations of Computer Science (1976).
     if (size() <= 3)
         return false ;
-    Polyline q{*this} ;
-    q. remove_consecutive_duplicated_vertices() ;
-    if (closed)
-        q. push_back (vertices. front()) ;
-    long_unsigned_int s1{q.size ()-2} ;
-    long_unsigned_int s2{q.size ()-1} ;
-    for (long_unsigned_int i {0} ; i < s1 ; i++) {
-        for (long_unsigned_int j {i+2} ; j < s2 ; j++) {
-            bool intersect = Vertex::intersects (
-                q.vertices[i], q.vertices[i+1], q.vertices[j], q.vertices[j+1]) ;
-           if ((!q. vertices[i+1].   equals_to (q. vertices[j])) &&
-                (!q. vertices[i].   equals_to (q. vertices[j+1])) &&
-                (!q. vertices[i+1]. equals_to (q. vertices[j])) &&
-                (!q. vertices[i+1]. equals_to (q. vertices[j+1])) &&
-                intersect)
+    // the vertices, without consecutive duplicates, and the first one again
+    // at the end if closed, as with remove_consecutive_duplicated_vertices()
+    std::vector<const Vertex *> kept ;
+    kept. reserve (size () + 1) ;
+    for (auto &v: vertices)
+        if (kept. empty () || !v. equals_to (*kept. back ()))
+            kept. push_back (&v) ;
+    if (closed) {
+        if ((kept. size () > 1) && kept. front ()-> equals_to (*kept. back ()))
+            kept. pop_back () ;
+        kept. push_back (kept. front ()) ;
+    }
+    if (kept. size () < 4)
+        return false ;
+    long_unsigned_int n {kept. size () - 1} ;
+    std::vector<Sweep_segment> segments ;
+    segments. reserve (n) ;
+    auto before = [] (const Vertex &a, const Vertex &b) {
+        return (a. x < b. x) || ((a. x == b. x) && (a. y < b. y)) ;
+    } ;
+    for (long_unsigned_int i {0} ; i < n ; i++) {
+        const Vertex &a {*kept[i]}, &b {*kept[i+1]} ;
+        if (before (b, a))
+            segments. push_back (Sweep_segment {b, a, i}) ;
+        else
+            segments. push_back (Sweep_segment {a, b, i}) ;
+    }
+    // events: 2*i+1 inserts segment i at its left vertex, 2*i removes it at
+    // its right vertex. At the same vertex, removals come first, so that
+    // segments joining there are not compared.
+    std::vector<long_unsigned_int> events (2 * n) ;
+    for (long_unsigned_int i {0} ; i < 2 * n ; i++)
+        events[i] = i ;
+    auto event_vertex = [&] (const long_unsigned_int e) -> const Vertex & {
+        return (e % 2) ? segments[e/2]. left : segments[e/2]. right ;
+    } ;
+    std::sort (events. begin (), events. end (),
+        [&] (const long_unsigned_int e, const long_unsigned_int f) {
+            const Vertex &a {event_vertex (e)}, &b {event_vertex (f)} ;
+            if (before (a, b))
                 return true ;
+            if (before (b, a))
+                return false ;
+            return e < f ;
+        }) ;
+    // Segments whose ordinate at a vertex is this close to it are taken as
+    // passing through the vertex.
+    double minx, miny, maxx, maxy ;
+    limits (minx, miny, maxx, maxy) ;
+    double tolerance {1e-12 * std::max ({fabs (minx), fabs (maxx),
+                                         fabs (miny), fabs (maxy)})} ;
+    // segment n is a probe, a single point used to find positions on the
+    // sweep line, which comes before the segments at the same ordinate.
+    segments. push_back (Sweep_segment {Vertex (), Vertex (), n}) ;
+    double sweep_x {0}, sweep_y {0} ;
+    auto below = [&] (const long_unsigned_int i, const long_unsigned_int j) {
+        double yi {sweep_ordinate (segments[i], sweep_x, sweep_y)} ;
+        double yj {sweep_ordinate (segments[j], sweep_x, sweep_y)} ;
+        if (yi != yj)
+            return yi < yj ;
+        if ((i == n) || (j == n))
+            return i == n ;
+        double si {sweep_slope (segments[i])}, sj {sweep_slope (segments[j])} ;
+        if (si != sj)
+            return si < sj ;
+        return i < j ;
+    } ;
+    typedef std::set<long_unsigned_int, std::function<bool (
+        long_unsigned_int, long_unsigned_int)>> Sweep_line ;
+    Sweep_line sweep_line (below) ;
+    std::vector<Sweep_line::iterator> position (n) ;
+    // Segments joining at a vertex are not compared, so when they overlap,
+    // they may hide from each other the other segments touching them at the
+    // vertex. All the segments passing through the vertex, and their first
+    // neighbours, are therefore compared with each other.
+    std::vector<long_unsigned_int> through ;
+    auto cross_through = [&] (const Vertex &v) {
+        segments[n]. left = segments[n]. right = Vertex (v. x, v. y - tolerance) ;
+        Sweep_line::iterator p {sweep_line. lower_bound (n)} ;
+        through. clear () ;
+        if (p != sweep_line. begin ())
+            through. push_back (*std::prev (p)) ;
+        for ( ; p != sweep_line. end () ; p++) {
+            through. push_back (*p) ;
+            if (sweep_ordinate (segments[*p], v. x, v. y) > v. y + tolerance)
+                break ;
+        }
+        for (long_unsigned_int k {0} ; k < through. size () ; k++)
+            for (long_unsigned_int l {k + 1} ; l < through. size () ; l++)
+                if (sweep_segments_cross (segments[through[k]],
+                                          segments[through[l]]))
+                    return true ;
+        return false ;
+    } ;
+    for (long_unsigned_int k {0} ; k < 2 * n ; ) {
+        const Vertex &v {event_vertex (events[k])} ;
+        sweep_x = v. x ;
+        sweep_y = v. y ;
+        if (cross_through (v))
+            return true ;
+        for ( ; (k < 2 * n) && (event_vertex (events[k]). x == v. x) &&
+                (event_vertex (events[k]). y == v. y) ; k++) {
+            long_unsigned_int e {events[k]} ;
+            long_unsigned_int i {e / 2} ;
+            if (e % 2) {
+                Sweep_line::iterator p {sweep_line. insert (i). first} ;
+                position[i] = p ;
+                if ((p != sweep_line. begin ()) &&
+                    sweep_segments_cross (segments[*std::prev (p)],
+                                          segments[i]))
+                    return true ;
+                if ((std::next (p) != sweep_line. end ()) &&
+                    sweep_segments_cross (segments[*std::next (p)],
+                                          segments[i]))
+                    return true ;
+            } else {
+                Sweep_line::iterator next {sweep_line. erase (position[i])} ;
+                if ((next != sweep_line. begin ()) &&
+                    (next != sweep_line. end ()) &&
+                    sweep_segments_cross (segments[*std::prev (next)],
+                                          segments[*next]))
+                    return true ;
+            }
         }
+        if (cross_through (v))
+            return true ;
     }
     return false ;
 }
@@ -1193,18 +1493,82 @@ void dpps::Polyline::remove_aligned_vertices (double precision) {
     }
 }
 
+void dpps::Polyline::simplify (const double tolerance) {
+    long_unsigned_int n {size ()} ;
+    if (n < 3)
+        return ;
+    if (tolerance < std::numeric_limits<double>::epsilon())
+        return ;
+    const double tolerance2 {tolerance * tolerance} ;
+    std::vector<bool> keep (n, false) ;
+    // Ranges of vertices to simplify, between two kept vertices. The end
+    // of a range can be n, which stands for vertex 0 once more, so that
+    // the closing segment of a closed polyline is a range like the others.
+    std::vector<std::pair<long_unsigned_int, long_unsigned_int>> ranges ;
+    keep[0] = true ;
+    if (closed) {
+        long_unsigned_int farthest {0} ;
+        double maximum {0.0} ;
+        for (long_unsigned_int i {1} ; i < n ; i++) {
+            double d2 {(vertices[i] - vertices[0]). norm2_square ()} ;
+            if (d2 > maximum) {
+                maximum = d2 ;
+                farthest = i ;
+            }
+        }
+        if (farthest == 0)
+            farthest = n - 1 ;
+        keep[farthest] = true ;
+        ranges. push_back (std::make_pair (0, farthest)) ;
+        ranges. push_back (std::make_pair (farthest, n)) ;
+    } else {
+        keep[n - 1] = true ;
+        ranges. push_back (std::make_pair (0, n - 1)) ;
+    }
+    while (!ranges. empty ()) {
+        long_unsigned_int first {ranges. back (). first} ;
+        long_unsigned_int last {ranges. back (). second} ;
+        ranges. pop_back () ;
+        // the reference &a is used to avoid copy
+        const Vertex &a = vertices[first] ;
+        const Vertex &b = vertices[last % n] ;
+        long_unsigned_int farthest {first} ;
+        double maximum {tolerance2} ;
+        for (long_unsigned_int i {first + 1} ; i < last ; i++) {
+            double d2 {segment_distance_square (vertices[i], a, b)} ;
+            if (d2 > maximum) {
+                maximum = d2 ;
+                farthest = i ;
+            }
+        }
+        if (farthest == first)
+            continue ;
+        keep[farthest] = true ;
+        ranges. push_back (std::make_pair (first, farthest)) ;
+        ranges. push_back (std::make_pair (farthest, last)) ;
+    }
+    long_unsigned_int j {0} ;
+    for (long_unsigned_int i {0} ; i < n ; i++)
+        if (keep[i])
+            vertices[j++] = vertices[i] ;
+    vertices. resize (j) ;
+}
+
 #ifdef GSL_FOUND
 void dpps::Polyline::apply_matrix (Matrix3x3 &matrix) {
-    for (auto &i: vertices)
-        i = matrix. apply (i) ;
+    matrix. apply (vertices. data (), vertices. size ()) ;
 }
 
 void dpps::Polyline::apply_homography (Matrix3x3 &matrix) {
-    for (auto &i: vertices)
-        i = matrix.apply_homography(i) ;
+    matrix. apply_homography (vertices. data (), vertices. size ()) ;
 }
 #endif
 
+void dpps::Polyline::apply_transform (const Affine_transform &transform) {
+    for (auto &i: vertices)
+        i = transform. apply (i) ;
+}
+
 void dpps::Polyline::subdivide (const double distance) {
     if (size () <= 1)
         return ;
@@ -1476,6 +1840,191 @@ void dpps::Polyline::cut_into (Polyline p, const bool reverse_auto) {
     cut_into (p, pos_this, pos_p, reverse_auto) ;
 }
 
+void dpps::Polyline::cut_into (const std::vector<Polyline> &holes,
+                               const bool reverse_auto) {
+    bool general_case {vertices. size () >= 3} ;
+    long_unsigned_int total {vertices. size ()} ;
+    // the reference &h is used to avoid copy
+    for (auto &h: holes) {
+        if ((h. vertices. size () == 1) || (h. vertices. size () == 2))
+            general_case = false ;
+        total += h. vertices. size () ;
+    }
+    if (!general_case) {
+        // the reference &h is used to avoid copy
+        for (auto &h: holes)
+            cut_into (h, reverse_auto) ;
+        return ;
+    }
+    // The vertices are numbered as they will appear: first the ones of
+    // *this, then each hole after its cycle and reversal, without the copies
+    // of vertices closing the bridges. Each one keeps the vertex before it in
+    // the Polyline being built, whose copies all have the same position, as
+    // cut_into() inserts after the vertex where a hole is joined.
+    const long_unsigned_int none {std::numeric_limits<long_unsigned_int>::max ()} ;
+    std::vector<Vertex> position ;
+    std::vector<Vertex> before ;
+    // The holes joined to each vertex, the last joined first, as in the
+    // Polyline being built, chained through next_hole.
+    std::vector<long_unsigned_int> first_hole ;
+    std::vector<long_unsigned_int> next_hole ;
+    std::vector<long_unsigned_int> hole_begin ;
+    std::vector<long_unsigned_int> hole_end ;
+    position. reserve (total) ;
+    before. reserve (total) ;
+    first_hole. reserve (total) ;
+    double minx {std::numeric_limits<double>::max ()} ;
+    double miny {std::numeric_limits<double>::max ()} ;
+    double maxx {std::numeric_limits<double>::lowest ()} ;
+    double maxy {std::numeric_limits<double>::lowest ()} ;
+    double maximum {Vertex_grid::maximum_coordinate (vertices)} ;
+    auto extend = [&] (const Vertex &v) {
+        minx = std::min (minx, v. x) ;
+        miny = std::min (miny, v. y) ;
+        maxx = std::max (maxx, v. x) ;
+        maxy = std::max (maxy, v. y) ;
+    } ;
+    for (auto &v: vertices)
+        extend (v) ;
+    // the reference &h is used to avoid copy
+    for (auto &h: holes) {
+        for (auto &v: h. vertices)
+            extend (v) ;
+        maximum = std::max (maximum,
+                            Vertex_grid::maximum_coordinate (h. vertices)) ;
+    }
+    // About one vertex per cell.
+    double width {std::max (maxx - minx, maxy - miny)} ;
+    double cell {std::max (sqrt ((maxx - minx) * (maxy - miny) / total),
+                           width / total)} ;
+    Vertex_grid grid (cell, maximum) ;
+    cell = grid. get_cell_size () ;
+    long_unsigned_int last_ring {
+        static_cast<long_unsigned_int> (ceil (width / cell)) + 1} ;
+    // v and b are copies, as they may be vertices of position.
+    auto add_vertex = [&] (const Vertex v, const Vertex b) {
+        grid. insert (v, position. size ()) ;
+        position. push_back (v) ;
+        before. push_back (b) ;
+        first_hole. push_back (none) ;
+    } ;
+    for (long_unsigned_int i {0} ; i < vertices. size () ; i++)
+        add_vertex (vertices[i], vertices[(i == 0) ? vertices. size () - 1
+                                                   : i - 1]) ;
+
+    // Smallest (squared distance, number) of the vertices to v.
+    std::vector<long_unsigned_int> found ;
+    auto nearest = [&] (const Vertex &v) {
+        std::pair<double, long_unsigned_int> best {
+            std::numeric_limits<double>::max (), none} ;
+        auto try_vertex = [&] (const long_unsigned_int e) {
+            std::pair<double, long_unsigned_int> candidate {
+                (position[e] - v). norm2_square (), e} ;
+            if (candidate < best)
+                best = candidate ;
+        } ;
+        long_unsigned_int cells_seen {0} ;
+        for (long_unsigned_int r {0} ; r <= last_ring ; r++) {
+            // the vertices of ring r are at least (r - 1) * cell away
+            double bound {(r >= 1) ? (r - 1) * cell : 0.0} ;
+            if ((r >= 1) && (best. first < bound * bound))
+                break ;
+            cells_seen += (r == 0) ? 1 : 8 * r ;
+            if (cells_seen > 2 * position. size ()) {
+                for (long_unsigned_int e {0} ; e < position. size () ; e++)
+                    try_vertex (e) ;
+                break ;
+            }
+            grid. ring (v, r, found) ;
+            for (long_unsigned_int e: found)
+                try_vertex (e) ;
+        }
+        return best ;
+    } ;
+
+    Polyline p ;
+    // the reference &h is used to avoid copy
+    for (auto &h: holes) {
+        if (h. vertices. size () == 0)
+            continue ;
+        // Same choice as cut_into(): the smallest distance, then the first
+        // vertex joined, then the first vertex of the hole.
+        std::pair<double, long_unsigned_int> best {
+            std::numeric_limits<double>::max (), none} ;
+        long_unsigned_int pos_p {0} ;
+        for (long_unsigned_int j {0} ; j < h. vertices. size () ; j++) {
+            std::pair<double, long_unsigned_int> candidate {
+                nearest (h. vertices[j])} ;
+            if (candidate < best) {
+                best = candidate ;
+                pos_p = j ;
+            }
+        }
+        long_unsigned_int joined {best. second} ;
+        p. vertices = h. vertices ;
+        p. cycle (pos_p, false) ;
+        bool reverse {false} ;
+        if (reverse_auto)
+            reverse = Vertex::intersects (
+                position[joined], p. vertices. front (),
+                before[joined], p. vertices[p. vertices. size () - 2]) ;
+        // The hole is inserted as its first vertex, then the others in
+        // order, or the others in reverse order.
+        long_unsigned_int k {hole_begin. size ()} ;
+        hole_begin. push_back (position. size ()) ;
+        add_vertex (p. vertices. front (), position[joined]) ;
+        for (long_unsigned_int t {1} ; t < p. vertices. size () ; t++)
+            add_vertex (p. vertices[reverse ? p. vertices. size () - t : t],
+                        position. back ()) ;
+        hole_end. push_back (position. size ()) ;
+        next_hole. push_back (first_hole[joined]) ;
+        first_hole[joined] = k ;
+    }
+    if (hole_begin. empty ())
+        return ;
+
+    // Each vertex is followed by its holes, each one closed by a copy of its
+    // first vertex and by a copy of the vertex it is joined to. The holes
+    // are walked with a stack, as they can be joined to the vertices of
+    // other holes.
+    struct Frame {
+        long_unsigned_int begin ;
+        long_unsigned_int current ;
+        long_unsigned_int end ;
+        long_unsigned_int hole ;
+    } ;
+    Vertex_vector result ;
+    result. reserve (total + 2 * hole_begin. size ()) ;
+    std::vector<Frame> stack ;
+    result. push_back (position[0]) ;
+    stack. push_back (Frame {0, 0, vertices. size (), first_hole[0]}) ;
+    while (!stack. empty ()) {
+        Frame &f = stack. back () ;
+        if (f. hole != none) {
+            long_unsigned_int k {f. hole} ;
+            f. hole = next_hole[k] ;
+            result. push_back (position[hole_begin[k]]) ;
+            stack. push_back (Frame {hole_begin[k], hole_begin[k],
+                                     hole_end[k],
+                                     first_hole[hole_begin[k]]}) ;
+            continue ;
+        }
+        f. current++ ;
+        if (f. current < f. end) {
+            result. push_back (position[f. current]) ;
+            f. hole = first_hole[f. current] ;
+            continue ;
+        }
+        long_unsigned_int begin {f. begin} ;
+        stack. pop_back () ;
+        if (!stack. empty ()) {
+            result. push_back (position[begin]) ;
+            result. push_back (position[stack. back (). current]) ;
+        }
+    }
+    vertices = std::move (result) ;
+}
+
 void dpps::Polyline::cycle (long_unsigned_int val, const bool forward) {
     // The cycle is equivalent through modulus of vertice size.
     val = val % vertices. size () ;
@@ -1502,21 +2051,12 @@ bool dpps::Polyline::contains (const Vertex &v, const double minx, const double
   // the last and the first point.
   // https://secure.wikimedia.org/wikipedia/en/wiki/Point_in_polygon#Ray_casting_algorithm
   //
-  long_unsigned_int i ;
-  long_unsigned_int c {0} ;
-  long_unsigned_int l {size()};
   if ((v. x < minx) || (v. y < miny) || (v. x > maxx) || (v. y > maxy))
       return false ;
-  // We consider the consecutive segments
-  for (i = 0 ; i < l ; i++) {
-    if (i == l-1) {
-      c += (Vertex::segments_intersect (Vertex(vertices[i].x, vertices[i].y), Vertex(vertices[0].x, vertices[0].y), Vertex(minx, v.y), Vertex(v.x, v.y)) >= 1) ;
-    }
-    else  {
-      c += (Vertex::segments_intersect (Vertex(vertices[i].x, vertices[i].y), Vertex(vertices[i+1].x, vertices[i+1].y), Vertex(minx, v.y), Vertex(v.x, v.y)) >= 1) ;
-    }
-  }
-  return (bool) (c % 2) ;
+  const Vertex ray_start {minx, v. y} ;
+  // We consider the consecutive segments, the last one closing the polygon,
+  // all at once.
+  return (Vertex::count_segments_intersect (vertices, true, ray_start, v) % 2) == 1 ;
 }
 
 bool dpps::Polyline::contains (const Vertex &v) const {
@@ -23,7 +23,9 @@
 
 #include "common.hh"
 #include "Vertex.hh"
+#include "Vertex_vector.hh"
 #include "Matrix3x3.hh"
+#include "Affine_transform.hh"
 #include "util.hh" // dpps_to_string
 
 namespace dpps {
@@ -66,7 +68,7 @@ namespace dpps {
 class Polyline {
 public:
      /** @brief vector of x/y positions. */
-    std::vector<Vertex> vertices ;
+    Vertex_vector vertices ;
 
     /** @brief Whether the polyline is to be considered a closed (filled)
      * polygon or an open path. */
@@ -241,6 +243,19 @@ public:
      * in relative coordinates */
     void push_back_relative (const double x, const double y) ;
 
+    /** @brief Grows the Polyline by the vertices whose coordinates are
+     * listed in coordinates, in the order x0, y0, x1, y1, etc.
+     *
+     * This is the bulk version of push_back (x, y), so that a script can
+     * pass all the vertices at once. Throws bad_parametre if the number of
+     * values is odd, as Pattern::push_back_coordinates() does when the
+     * counts do not match. */
+    void push_back_coordinates (const std::vector<double> &coordinates) ;
+
+    /** @brief Returns the coordinates of the vertices in the order x0, y0,
+     * x1, y1, etc., as push_back_coordinates() takes them. */
+    std::vector<double> get_coordinates () const ;
+
     // const informative functions //
     /////////////////////////////////
 
@@ -360,6 +375,13 @@ public:
      * This function runs in O(vertices. size ()^2) */
     double minimum_distance () const ;
 
+    /** @brief The distance from v to the nearest point of the segments of
+     * the polyline, including the closing segment if it is closed, or to its
+     * vertex if it has only one. It is infinite for an empty polyline.
+     *
+     * This function runs in O(vertices. size ()) */
+    double distance_to (const Vertex &v) const ;
+
     /** @brief Returns the area of the closed polygon described by the Polyline.
      *
      * The value is the same whether the Polyline is set to closed or not.
@@ -493,11 +515,34 @@ public:
     void remove_aligned_vertices (
         double precision = std::numeric_limits<double>::epsilon ()) ;
 
+    /** @brief Modifying function that removes the vertices which are not
+     * needed to follow the polyline within tolerance.
+     *
+     * This is the algorithm of Douglas and Peucker (D. H. Douglas and
+     * T. K. Peucker, Algorithms for the reduction of the number of points
+     * required to represent a digitized line or its caricature, Cartographica
+     * 10 (1973)): the vertex farthest from the segment joining the ends is
+     * kept if it is farther than tolerance, and both sides are simplified
+     * again. Each removed vertex is within tolerance of the new polyline.
+     * As opposed to remove_aligned_vertices(), which only removes vertices at
+     * a straight angle, this also removes the small steps of a finely
+     * sampled curve.
+     *
+     * The first and last vertices are kept. If the polyline is closed, the
+     * vertex farthest from the first one is also kept, and both halves are
+     * simplified. If tolerance is negative or positive smaller than machine
+     * epsilon, nothing is done.
+     *
+     * The time is O(n log n) for most polylines, O(n^2) in the worst case.
+     * */
+    void simplify (const double tolerance) ;
+
     /** @brief Modifying function that removes duplicated vertices
      *
      * This function will remove all duplicated vertices, to the specified
-     * precision. It needs to compare all vertices two by two so it has O(n^2)
-     * complexity, with n the number of vertices.
+     * precision, keeping the first occurrence. Vertices are indexed in a
+     * Vertex_grid so that each one is only compared to its close neighbours,
+     * which gives an expected O(n) complexity, with n the number of vertices.
      * */
     void remove_duplicated_vertices (
         double precision = std::numeric_limits<double>::epsilon ()) ;
@@ -593,6 +638,19 @@ public:
                     const enum_integer_property property,
                     const long_unsigned_int parametre) const ;
 
+    /** @brief Sets values to the double properties of the polyline, in the
+     * order of properties, as get_double_property() would.
+     *
+     * The quantities needed by several properties are calculated only once:
+     * the four limits of the vertices in a single pass for minimum_x,
+     * maximum_x, minimum_y, maximum_y, horizontal_size and vertical_size,
+     * and the geometrical centre for geometrical_centre_x,
+     * geometrical_centre_y and distance_to_centre. */
+    void get_double_properties (
+                    const std::vector<enum_double_property> &properties,
+                    const long_unsigned_int parametre,
+                    std::vector<double> &values) const ;
+
     /** @brief Transforms the polyline in a way to match the set value
      * of a double property.
      *
@@ -657,9 +715,13 @@ public:
      *
      * @note Duplicate vertices, different lines are joining at the same place
      * do not count as intersection. Only line segments crossing strictly inside
-     * (not at their extremities) will cause true.
+     * (not at their extremities) will cause true. A vertex lying on another
+     * segment, or collinear segments overlapping without a common vertex,
+     * count as intersection.
      *
      * Polylines with 0, 1, 2 or 3 vertices will always return false.
+     *
+     * The segments are compared with a sweep line, in O(n log n).
      */
     bool is_self_crossing () const ;
 
@@ -678,6 +740,10 @@ public:
 
     void apply_homography (Matrix3x3 &matrix) ;
 #endif
+
+    /** @brief Applies transform to all vertices, in a single pass. */
+    void apply_transform (const Affine_transform &transform) ;
+
     /** @brief Subdivides the polyline by inserting vertices at every distance
      * as specified by the parameter, starting counting at each original vertex.
      *
@@ -804,6 +870,24 @@ public:
      */
     void cut_into (Polyline p, const bool reverse_auto = true) ;
 
+    /** @brief cuts all the holes into the current Polyline, as cut_into()
+     * at the location of least distance does for each of them in turn.
+     *
+     * Each hole is joined to the nearest vertex of the current Polyline or
+     * of the holes before it, found with a Vertex_grid, and the vertices are
+     * put together once, at the end, instead of being inserted for each hole.
+     * This runs in about O(n) for n vertices in total, instead of O(n^2), as
+     * for a membrane with thousands of holes.
+     *
+     * Among vertices at equal distances, the ones of the current Polyline are
+     * chosen before the ones of the holes, where cut_into() chooses the first
+     * one along the Polyline being built, so that the result may differ when
+     * there are such ties. If the current Polyline or one of the holes has
+     * one or two vertices, the holes are cut into one after the other.
+     */
+    void cut_into (const std::vector<Polyline> &holes,
+                   const bool reverse_auto = true) ;
+
     /** @brief performs a cycle (french permutation circulaire) or rotation
      * on the elements of the vectors. The first argument indicates the number
      * of times the cycle will be done. The second argument indicates the
@@ -10,10 +10,13 @@
  * file, You can obtain one at http://mozilla.org/MPL/2.0/.
  */
 
+#include <algorithm>
 #include <cmath>
+#include <string>
 
 #include "common.hh"
 #include "Polyline_factory.hh"
+#include "bad_parametre.hh"
 
 /*
 dpps::Polyline dpps::Polyline_factory::cut_into (Polyline outer,
@@ -233,3 +236,62 @@ dpps::Polyline dpps::Polyline_factory::crossing_star_polygon (
     return polyline ;
 }
 
+long_unsigned_int dpps::Polyline_factory::number_vertices_for_tolerance (
+    const double diametre,
+    const double tolerance) {
+    if (tolerance <= 0) {
+        std::string reason {"Polyline_factory::number_vertices_for_tolerance, \
+tolerance must be positive, but it is " + std::to_string (tolerance)} ;
+        throw bad_parametre (reason. c_str ()) ;
+    }
+    double radius {fabs (diametre) / 2.0} ;
+    if (radius <= tolerance)
+        return 3 ;
+    // With the sine rather than 1 - cos (pi/n), small tolerances do not
+    // lose their precision.
+    double half_step {asin (sqrt (tolerance / (2.0 * radius)))} ;
+    long_unsigned_int n {static_cast<long_unsigned_int> (
+        ceil (M_PI / (2.0 * half_step)))} ;
+    return (n < 3) ? 3 : n ;
+}
+
+dpps::Polyline dpps::Polyline_factory::circle (const double diametre,
+                                               const double tolerance) {
+    Polyline result (number_vertices_for_tolerance (diametre, tolerance),
+                     diametre) ;
+    result. closed = true ;
+    return result ;
+}
+
+dpps::Polyline dpps::Polyline_factory::ellipse (const double major_axis,
+                                                const double minor_axis,
+                                                const double angle_x,
+                                                const double tolerance) {
+    double largest_axis {std::max (fabs (major_axis), fabs (minor_axis))} ;
+    Polyline result (number_vertices_for_tolerance (largest_axis, tolerance),
+                     major_axis, minor_axis, angle_x) ;
+    result. closed = true ;
+    return result ;
+}
+
+dpps::Polyline dpps::Polyline_factory::arc (const double diametre,
+                                            const double start_angle,
+                                            const double end_angle,
+                                            const double tolerance) {
+    constexpr const double two_pi {M_PI*2.0} ;
+    long_unsigned_int full_circle {
+        number_vertices_for_tolerance (diametre, tolerance)} ;
+    double sweep {end_angle - start_angle} ;
+    long_unsigned_int segments {static_cast<long_unsigned_int> (
+        ceil (fabs (sweep) / two_pi * full_circle))} ;
+    if (segments == 0)
+        segments = 1 ;
+    double radius {diametre / 2.0} ;
+    Polyline result ;
+    result. vertices. reserve (segments + 1) ;
+    for (long_unsigned_int i {0} ; i <= segments ; i++) {
+        double angle {start_angle + sweep * i / segments} ;
+        result. push_back (Vertex (radius * cos (angle), radius * sin (angle))) ;
+    }
+    return result ;
+}
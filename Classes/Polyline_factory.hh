@@ -53,6 +53,41 @@ public:
         const double inner_minor_axis,
         const double inner_angle_x) ;
 
+    /** @brief The number of vertices of a regular polygon inscribed in a
+     * circle of diametre, so that no point of the circle is farther than
+     * tolerance from the polygon, and at least 3.
+     *
+     * The largest distance is in the middle of each side, and is
+     * r (1 - cos (pi/n)) = 2 r sin^2 (pi/2n) for n vertices and radius r.
+     * Throws bad_parametre if tolerance is not positive. */
+    static long_unsigned_int number_vertices_for_tolerance (
+        const double diametre,
+        const double tolerance) ;
+
+    /** @brief A circle of diametre centred on (0, 0), approximated by the
+     * regular polygon with the fewest vertices which is within tolerance,
+     * see number_vertices_for_tolerance(). The polyline is closed. */
+    static Polyline circle (const double diametre, const double tolerance) ;
+
+    /** @brief An ellipse centred on (0, 0), within tolerance.
+     *
+     * The ellipse is the image of the circle of diametre major_axis by a
+     * contraction along the minor axis, which does not increase the
+     * distances, so the number of vertices of that circle is used. The
+     * polyline is closed. */
+    static Polyline ellipse (const double major_axis,
+                             const double minor_axis,
+                             const double angle_x,
+                             const double tolerance) ;
+
+    /** @brief An open arc of the circle of diametre centred on (0, 0), from
+     * start_angle to end_angle (counterclockwise if end_angle is larger),
+     * within tolerance. The angles are in radians, and both ends are
+     * vertices. */
+    static Polyline arc (const double diametre,
+                         const double start_angle,
+                         const double end_angle,
+                         const double tolerance) ;
 } ;
 } // namespace dpps
 #endif
\ No newline at end of file
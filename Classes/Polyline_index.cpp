@@ -0,0 +1,195 @@
+/**
+ * @file Polyline_index.cpp
+ * @author Jérôme Borme <jerome.borme@inl.int>
+ * @version 1.0
+ * @brief Implementation of class Polyline_index
+ * @date 2026-10-14 Jérôme Borme: Initial version
+ * @copyright
+ * This Source Code Form is subject to the terms of the Mozilla Public
+ * License, v. 2.0. If a copy of the MPL was not distributed with this
+ * file, You can obtain one at http://mozilla.org/MPL/2.0/.
+ */
+
+#include <cmath>
+#include <limits>
+#include <algorithm>
+#include <queue>
+
+#include "Polyline_index.hh"
+
+const long_unsigned_int dpps::Polyline_index::node_capacity ;
+
+dpps::Polyline_index::Polyline_index (const std::vector<Polyline> &polylines) {
+    number_polylines = polylines. size () ;
+    entries. reserve (number_polylines) ;
+    for (long_unsigned_int i {0} ; i < number_polylines ; i++) {
+        if (polylines[i]. size () == 0)
+            continue ;
+        Node entry {{0.0, 0.0, 0.0, 0.0}, i, 0} ;
+        polylines[i]. limits (entry. box. min_x, entry. box. min_y,
+                              entry. box. max_x, entry. box. max_y) ;
+        entries. push_back (entry) ;
+    }
+    if (entries. empty ())
+        return ;
+    order_by_tiles (entries) ;
+    nodes = parents_of (entries, 0) ;
+    leaves = nodes. size () ;
+    // Each level is tiled again before grouping it, then the nodes of the
+    // level above refer to it by its offset in nodes.
+    long_unsigned_int level_start {0} ;
+    while (nodes. size () - level_start > 1) {
+        std::vector<Node> level (nodes. begin () + level_start, nodes. end ()) ;
+        order_by_tiles (level) ;
+        std::copy (level. begin (), level. end (), nodes. begin () + level_start) ;
+        std::vector<Node> parents {parents_of (level, level_start)} ;
+        level_start = nodes. size () ;
+        nodes. insert (nodes. end (), parents. begin (), parents. end ()) ;
+    }
+}
+
+void dpps::Polyline_index::order_by_tiles (std::vector<Node> &items) {
+    const long_unsigned_int groups {
+        (items. size () + node_capacity - 1) / node_capacity} ;
+    const long_unsigned_int slices {static_cast<long_unsigned_int> (
+        ceil (sqrt (static_cast<double> (groups))))} ;
+    const long_unsigned_int slice_size {slices * node_capacity} ;
+    // Comparing the sums of the limits is comparing the centres.
+    std::sort (items. begin (), items. end (),
+        [] (const Node &a, const Node &b) {
+            return a. box. min_x + a. box. max_x < b. box. min_x + b. box. max_x ;
+        }) ;
+    for (long_unsigned_int start {0} ; start < items. size () ;
+         start += slice_size) {
+        long_unsigned_int end {std::min (start + slice_size, items. size ())} ;
+        std::sort (items. begin () + start, items. begin () + end,
+            [] (const Node &a, const Node &b) {
+                return a. box. min_y + a. box. max_y < b. box. min_y + b. box. max_y ;
+            }) ;
+    }
+}
+
+std::vector<dpps::Polyline_index::Node> dpps::Polyline_index::parents_of (
+    const std::vector<Node> &items, const long_unsigned_int offset) {
+    std::vector<Node> parents ;
+    parents. reserve ((items. size () + node_capacity - 1) / node_capacity) ;
+    for (long_unsigned_int start {0} ; start < items. size () ;
+         start += node_capacity) {
+        long_unsigned_int end {std::min (start + node_capacity, items. size ())} ;
+        Node parent {items[start]. box, offset + start, end - start} ;
+        for (long_unsigned_int i {start + 1} ; i < end ; i++) {
+            const Box &b = items[i]. box ;
+            parent. box. min_x = std::min (parent. box. min_x, b. min_x) ;
+            parent. box. min_y = std::min (parent. box. min_y, b. min_y) ;
+            parent. box. max_x = std::max (parent. box. max_x, b. max_x) ;
+            parent. box. max_y = std::max (parent. box. max_y, b. max_y) ;
+        }
+        parents. push_back (parent) ;
+    }
+    return parents ;
+}
+
+double dpps::Polyline_index::distance (const Box &box, const Vertex &v) {
+    double dx {0.0} ;
+    double dy {0.0} ;
+    if (v. x < box. min_x)
+        dx = box. min_x - v. x ;
+    else if (v. x > box. max_x)
+        dx = v. x - box. max_x ;
+    if (v. y < box. min_y)
+        dy = box. min_y - v. y ;
+    else if (v. y > box. max_y)
+        dy = v. y - box. max_y ;
+    return sqrt (dx*dx + dy*dy) ;
+}
+
+long_unsigned_int dpps::Polyline_index::size () const {
+    return number_polylines ;
+}
+
+void dpps::Polyline_index::inside (const double xmin, const double ymin,
+                                   const double xmax, const double ymax,
+                                   std::vector<long_unsigned_int> &result) const {
+    result. clear () ;
+    if (nodes. empty ())
+        return ;
+    std::vector<long_unsigned_int> stack {nodes. size () - 1} ;
+    while (!stack. empty ()) {
+        // the reference &node is used to avoid copy
+        const Node &node = nodes[stack. back ()] ;
+        bool is_leaf {stack. back () < leaves} ;
+        stack. pop_back () ;
+        if ((node. box. max_x < xmin) || (node. box. min_x > xmax) ||
+            (node. box. max_y < ymin) || (node. box. min_y > ymax))
+            continue ;
+        if (!is_leaf) {
+            for (long_unsigned_int i {0} ; i < node. count ; i++)
+                stack. push_back (node. first + i) ;
+            continue ;
+        }
+        for (long_unsigned_int i {node. first} ; i < node. first + node. count ;
+             i++) {
+            const Box &b = entries[i]. box ;
+            if ((b. min_x >= xmin) && (b. max_x <= xmax) &&
+                (b. min_y >= ymin) && (b. max_y <= ymax))
+                result. push_back (entries[i]. first) ;
+        }
+    }
+}
+
+namespace {
+// kind is 0 for a node, 1 for a polyline whose distance is that of its box,
+// and 2 for a polyline whose distance is exact.
+struct Candidate {
+    double key ;
+    int kind ;
+    long_unsigned_int number ;
+} ;
+
+// The order of a priority queue is reversed: the smallest key comes out
+// first and, for equal keys, the items not yet resolved come out before the
+// exact distances, so that no equal distance is missed.
+struct Candidate_after {
+    bool operator() (const Candidate &a, const Candidate &b) const {
+        if (a. key != b. key)
+            return a. key > b. key ;
+        if (a. kind != b. kind)
+            return a. kind > b. kind ;
+        return a. number > b. number ;
+    }
+} ;
+} // namespace
+
+long_unsigned_int dpps::Polyline_index::nearest (const Vertex &v,
+        const std::function<double (const long_unsigned_int)> &distance) const {
+    if (nodes. empty ())
+        return number_polylines ;
+    std::priority_queue<Candidate, std::vector<Candidate>, Candidate_after>
+        queue ;
+    queue. push ({Polyline_index::distance (nodes. back (). box, v), 0,
+                  nodes. size () - 1}) ;
+    while (!queue. empty ()) {
+        Candidate c {queue. top ()} ;
+        queue. pop () ;
+        if (c. kind == 2)
+            return c. number ;
+        if (c. kind == 1) {
+            double d {distance (c. number)} ;
+            if (d != std::numeric_limits<double>::infinity ())
+                queue. push ({d, 2, c. number}) ;
+            continue ;
+        }
+        // the reference &node is used to avoid copy
+        const Node &node = nodes[c. number] ;
+        for (long_unsigned_int i {node. first} ; i < node. first + node. count ;
+             i++) {
+            if (c. number < leaves)
+                queue. push ({Polyline_index::distance (entries[i]. box, v), 1,
+                              entries[i]. first}) ;
+            else
+                queue. push ({Polyline_index::distance (nodes[i]. box, v), 0,
+                              i}) ;
+        }
+    }
+    return number_polylines ;
+}
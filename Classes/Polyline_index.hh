@@ -0,0 +1,109 @@
+/**
+ * @file Polyline_index.hh
+ * @author Jérôme Borme <jerome.borme@inl.int>
+ * @version 1.0
+ * @brief Header file for class Polyline_index, a spatial index of the
+ * bounding boxes of polylines
+ * @date 2026-10-14 Jérôme Borme: Initial version
+ * @copyright
+ * This Source Code Form is subject to the terms of the Mozilla Public
+ * License, v. 2.0. If a copy of the MPL was not distributed with this
+ * file, You can obtain one at http://mozilla.org/MPL/2.0/.
+ */
+#ifndef DPPS_POLYLINE_INDEX
+#define DPPS_POLYLINE_INDEX
+
+#include <functional>
+#include <vector>
+
+#include "common.hh"
+#include "Vertex.hh"
+#include "Polyline.hh"
+
+namespace dpps {
+/** @brief An R-tree of the bounding boxes of a vector of polylines, to find
+ * quickly the polylines inside a window or the nearest to a position.
+ *
+ * The tree is built once from all the polylines, with the Sort-Tile-Recursive
+ * packing of S. T. Leutenegger, M. A. Lopez and J. Edgington (STR: a simple
+ * and efficient algorithm for R-tree packing, Proceedings of the 13th
+ * International Conference on Data Engineering, 1997): the boxes are sorted
+ * in vertical slices by their centres, each slice is sorted vertically, and
+ * groups of node_capacity boxes form the nodes of the next level. It cannot
+ * be modified afterwards, and refers to the polylines by their position in
+ * the vector, so that it is only valid as long as they are not moved or
+ * modified. Empty polylines are not part of it.
+ */
+class Polyline_index {
+protected:
+    struct Box {
+        double min_x ;
+        double min_y ;
+        double max_x ;
+        double max_y ;
+    } ;
+
+    /** @brief a node of the tree, whose children are nodes first to
+     * first + count - 1, or, for a leaf, entries first to first + count - 1.
+     * For an entry, first is the position of the polyline and count is 0. */
+    struct Node {
+        Box box ;
+        long_unsigned_int first ;
+        long_unsigned_int count ;
+    } ;
+
+    /** @brief the bounding boxes of the polylines, in the order of the
+     * leaves. */
+    std::vector<Node> entries ;
+
+    /** @brief the nodes, level by level from the leaves, the root last. */
+    std::vector<Node> nodes ;
+
+    /** @brief the number of leaves, which are the first nodes. */
+    long_unsigned_int leaves {0} ;
+
+    /** @brief the number of polylines indexed, empty ones included. */
+    long_unsigned_int number_polylines {0} ;
+
+    /** @brief sorts items in slices of increasing centre abscissa, each one
+     * by increasing centre ordinate, so that each group of node_capacity
+     * consecutive items is close together. */
+    static void order_by_tiles (std::vector<Node> &items) ;
+
+    /** @brief returns the nodes of the groups of node_capacity consecutive
+     * items, which are numbered from offset. */
+    static std::vector<Node> parents_of (const std::vector<Node> &items,
+                                         const long_unsigned_int offset) ;
+
+    /** @brief distance from v to box, 0 if v is inside. */
+    static double distance (const Box &box, const Vertex &v) ;
+public:
+    /** @brief the maximum number of children of a node. */
+    static const long_unsigned_int node_capacity {16} ;
+
+    /** @brief Constructor, which indexes polylines. */
+    Polyline_index (const std::vector<Polyline> &polylines) ;
+
+    /** @brief the number of polylines passed to the constructor, empty ones
+     * included. */
+    long_unsigned_int size () const ;
+
+    /** @brief Sets result to the positions of the polylines whose bounding
+     * box is inside the window, limits included, in no particular order. */
+    void inside (const double xmin, const double ymin,
+                 const double xmax, const double ymax,
+                 std::vector<long_unsigned_int> &result) const ;
+
+    /** @brief returns the position of the polyline for which distance is
+     * the smallest, or size () if it is infinite for all of them.
+     *
+     * distance (n) must be at least the distance from v to the bounding box
+     * of polyline n, such as the distance from v to the polyline, or be
+     * infinite to exclude it. It is only called for the polylines whose box
+     * is closer to v than the result. For equal distances, the first polyline
+     * is returned. */
+    long_unsigned_int nearest (const Vertex &v,
+        const std::function<double (const long_unsigned_int)> &distance) const ;
+} ;
+} // namespace dpps
+#endif
@@ -0,0 +1,291 @@
+/**
+ * @file Polyline_vector.cpp
+ * @author Jérôme Borme <jerome.borme@inl.int>
+ * @version 1.0
+ * @brief Implementation of class Polyline_vector
+ * @date 2026-10-14 Jérôme Borme: Initial version
+ * @copyright
+ * This Source Code Form is subject to the terms of the Mozilla Public
+ * License, v. 2.0. If a copy of the MPL was not distributed with this
+ * file, You can obtain one at http://mozilla.org/MPL/2.0/.
+ */
+
+#include <utility> // std::swap
+
+#include "Polyline_vector.hh"
+
+const std::vector<dpps::Polyline> &dpps::Polyline_vector::empty_vector () {
+    static const std::vector<Polyline> empty ;
+    return empty ;
+}
+
+dpps::Polyline_vector::Polyline_vector (const size_type n) :
+    storage (std::make_shared<std::vector<Polyline>> (n)) {
+}
+
+dpps::Polyline_vector::Polyline_vector (const size_type n,
+                                        const Polyline &p) :
+    storage (std::make_shared<std::vector<Polyline>> (n, p)) {
+}
+
+dpps::Polyline_vector::Polyline_vector (std::initializer_list<Polyline> list) :
+    storage (std::make_shared<std::vector<Polyline>> (list)) {
+}
+
+dpps::Polyline_vector::Polyline_vector (const std::vector<Polyline> &v) :
+    storage (std::make_shared<std::vector<Polyline>> (v)) {
+}
+
+dpps::Polyline_vector::Polyline_vector (std::vector<Polyline> &&v) :
+    storage (std::make_shared<std::vector<Polyline>> (std::move (v))) {
+}
+
+dpps::Polyline_vector::Polyline_vector (const Polyline_vector &v) {
+    v. write_back_selection_words () ;
+    storage = v. storage ;
+}
+
+dpps::Polyline_vector::Polyline_vector (Polyline_vector &&v) :
+    storage (std::move (v. storage)) {
+    take_selection_words (v) ;
+}
+
+dpps::Polyline_vector &dpps::Polyline_vector::operator= (
+    const Polyline_vector &v) {
+    if (&v == this)
+        return *this ;
+    v. write_back_selection_words () ;
+    forget_selection_words () ;
+    storage = v. storage ;
+    return *this ;
+}
+
+dpps::Polyline_vector &dpps::Polyline_vector::operator= (
+    Polyline_vector &&v) {
+    if (&v == this)
+        return *this ;
+    storage = std::move (v. storage) ;
+    take_selection_words (v) ;
+    return *this ;
+}
+
+dpps::Polyline_vector &dpps::Polyline_vector::operator= (
+    const std::vector<Polyline> &v) {
+    // v may be the vector of storage itself, through the conversion
+    forget_selection_words () ;
+    storage = std::make_shared<std::vector<Polyline>> (v) ;
+    return *this ;
+}
+
+dpps::Polyline_vector &dpps::Polyline_vector::operator= (
+    std::vector<Polyline> &&v) {
+    forget_selection_words () ;
+    storage = std::make_shared<std::vector<Polyline>> (std::move (v)) ;
+    return *this ;
+}
+
+dpps::Polyline_vector &dpps::Polyline_vector::operator= (
+    std::initializer_list<Polyline> list) {
+    forget_selection_words () ;
+    storage = std::make_shared<std::vector<Polyline>> (list) ;
+    return *this ;
+}
+
+void dpps::Polyline_vector::duplicate () {
+    if (!storage)
+        storage = std::make_shared<std::vector<Polyline>> () ;
+    else if (storage. use_count () > 1)
+        storage = std::make_shared<std::vector<Polyline>> (*storage) ;
+}
+
+void dpps::Polyline_vector::detach () {
+    if (packed_state. load (std::memory_order_acquire) != packed_none)
+        drop_selection_words () ;
+    duplicate () ;
+}
+
+// The registers are packed and written back in a critical section, as
+// the const functions may be called from several threads.
+
+void dpps::Polyline_vector::pack_register (const selection_t r) const {
+    if (packed_registers[r])
+        return ;
+    const std::vector<Polyline> &v = storage ? *storage : empty_vector () ;
+    long_unsigned_int n {v. size ()} ;
+    std::vector<uint64_t> &words = packed_words[r] ;
+    words. assign ((n + 63) / 64, 0) ;
+    for (long_unsigned_int i {0} ; i < n ; i++)
+        words[i / 64] |= static_cast<uint64_t> (v[i]. selected[r]) << (i % 64) ;
+    packed_registers[r] = true ;
+    if (packed_state. load (std::memory_order_relaxed) == packed_none)
+        packed_state. store (packed_valid, std::memory_order_release) ;
+}
+
+void dpps::Polyline_vector::write_back_selection_words () const {
+    if (packed_state. load (std::memory_order_acquire) != packed_ahead)
+        return ;
+#ifdef OPENMP_FOUND
+    #pragma omp critical (polyline_vector_selections)
+#endif
+    if (packed_state. load (std::memory_order_relaxed) == packed_ahead) {
+        // allocated and not shared while registers are ahead, see
+        // modified_selection_words()
+        std::vector<Polyline> &v = *storage ;
+        long_unsigned_int n {v. size ()} ;
+        for (selection_t r {0} ; r < polyline_max_selection ; r++) {
+            if (!packed_registers_ahead[r])
+                continue ;
+            const std::vector<uint64_t> &words = packed_words[r] ;
+            for (long_unsigned_int i {0} ; i < n ; i++)
+                v[i]. selected[r] = (words[i / 64] >> (i % 64)) & 1 ;
+        }
+        packed_registers_ahead. reset () ;
+        packed_state. store (packed_valid, std::memory_order_release) ;
+    }
+}
+
+void dpps::Polyline_vector::drop_selection_words () {
+    write_back_selection_words () ;
+#ifdef OPENMP_FOUND
+    #pragma omp critical (polyline_vector_selections)
+#endif
+    {
+        packed_registers. reset () ;
+        packed_state. store (packed_none, std::memory_order_release) ;
+    }
+}
+
+void dpps::Polyline_vector::forget_selection_words () {
+    packed_registers. reset () ;
+    packed_registers_ahead. reset () ;
+    packed_state. store (packed_none, std::memory_order_release) ;
+}
+
+void dpps::Polyline_vector::take_selection_words (Polyline_vector &v) {
+    packed_words. swap (v. packed_words) ;
+    packed_registers = v. packed_registers ;
+    packed_registers_ahead = v. packed_registers_ahead ;
+    packed_state. store (v. packed_state. load (std::memory_order_acquire),
+                         std::memory_order_release) ;
+    v. forget_selection_words () ;
+}
+
+const std::vector<uint64_t> &dpps::Polyline_vector::selection_words (
+    const selection_t r) const {
+#ifdef OPENMP_FOUND
+    #pragma omp critical (polyline_vector_selections)
+#endif
+    pack_register (r) ;
+    return packed_words[r] ;
+}
+
+std::vector<uint64_t> &dpps::Polyline_vector::modified_selection_words (
+    const selection_t r, const bool keep_bits) {
+    // The written back bits must not be seen by the copies.
+    if (!storage || is_shared ())
+        duplicate () ;
+#ifdef OPENMP_FOUND
+    #pragma omp critical (polyline_vector_selections)
+#endif
+    {
+        if (keep_bits)
+            pack_register (r) ;
+        else {
+            packed_words[r]. assign ((size () + 63) / 64, 0) ;
+            packed_registers[r] = true ;
+        }
+        packed_registers_ahead[r] = true ;
+        packed_state. store (packed_ahead, std::memory_order_release) ;
+    }
+    return packed_words[r] ;
+}
+
+bool dpps::Polyline_vector::has_selection_words (const selection_t r) const {
+    bool result {false} ;
+#ifdef OPENMP_FOUND
+    #pragma omp critical (polyline_vector_selections)
+#endif
+    result = packed_registers[r] ;
+    return result ;
+}
+
+void dpps::Polyline_vector::swap (Polyline_vector &v) {
+    storage. swap (v. storage) ;
+    packed_words. swap (v. packed_words) ;
+    std::swap (packed_registers, v. packed_registers) ;
+    std::swap (packed_registers_ahead, v. packed_registers_ahead) ;
+    int state {packed_state. load (std::memory_order_acquire)} ;
+    packed_state. store (v. packed_state. load (std::memory_order_acquire),
+                         std::memory_order_release) ;
+    v. packed_state. store (state, std::memory_order_release) ;
+}
+
+void dpps::Polyline_vector::clear () {
+    forget_selection_words () ;
+    if (is_shared ())
+        storage. reset () ;
+    else if (storage)
+        storage-> clear () ;
+}
+
+void dpps::Polyline_vector::assign (const size_type n, const Polyline &p) {
+    // p may be one of the shared polylines
+    forget_selection_words () ;
+    storage = std::make_shared<std::vector<Polyline>> (n, p) ;
+}
+
+void dpps::Polyline_vector::assign (std::initializer_list<Polyline> list) {
+    forget_selection_words () ;
+    storage = std::make_shared<std::vector<Polyline>> (list) ;
+}
+
+dpps::Polyline_vector::iterator dpps::Polyline_vector::insert (
+    const_iterator position, const Polyline &p) {
+    difference_type i {position - shared (). cbegin ()} ;
+    std::vector<Polyline> &v = owned () ;
+    return v. insert (v. cbegin () + i, p) ;
+}
+
+dpps::Polyline_vector::iterator dpps::Polyline_vector::insert (
+    const_iterator position, Polyline &&p) {
+    difference_type i {position - shared (). cbegin ()} ;
+    std::vector<Polyline> &v = owned () ;
+    return v. insert (v. cbegin () + i, std::move (p)) ;
+}
+
+dpps::Polyline_vector::iterator dpps::Polyline_vector::insert (
+    const_iterator position, const size_type n, const Polyline &p) {
+    difference_type i {position - shared (). cbegin ()} ;
+    std::vector<Polyline> &v = owned () ;
+    return v. insert (v. cbegin () + i, n, p) ;
+}
+
+dpps::Polyline_vector::iterator dpps::Polyline_vector::insert (
+    const_iterator position, std::initializer_list<Polyline> list) {
+    difference_type i {position - shared (). cbegin ()} ;
+    std::vector<Polyline> &v = owned () ;
+    return v. insert (v. cbegin () + i, list) ;
+}
+
+dpps::Polyline_vector::iterator dpps::Polyline_vector::erase (
+    const_iterator position) {
+    difference_type i {position - shared (). cbegin ()} ;
+    std::vector<Polyline> &v = owned () ;
+    return v. erase (v. cbegin () + i) ;
+}
+
+dpps::Polyline_vector::iterator dpps::Polyline_vector::erase (
+    const_iterator first, const_iterator last) {
+    difference_type i {first - shared (). cbegin ()} ;
+    difference_type j {last - shared (). cbegin ()} ;
+    std::vector<Polyline> &v = owned () ;
+    return v. erase (v. cbegin () + i, v. cbegin () + j) ;
+}
+
+bool dpps::Polyline_vector::operator== (const Polyline_vector &v) const {
+    return (storage == v. storage) || (shared () == v. shared ()) ;
+}
+
+bool dpps::Polyline_vector::operator!= (const Polyline_vector &v) const {
+    return !(*this == v) ;
+}
@@ -0,0 +1,407 @@
+/**
+ * @file Polyline_vector.hh
+ * @author Jérôme Borme <jerome.borme@inl.int>
+ * @version 1.0
+ * @brief Header file for class Polyline_vector, the container of the
+ * polylines of a Pattern
+ * @date 2026-10-14 Jérôme Borme: Initial version
+ * @copyright
+ * This Source Code Form is subject to the terms of the Mozilla Public
+ * License, v. 2.0. If a copy of the MPL was not distributed with this
+ * file, You can obtain one at http://mozilla.org/MPL/2.0/.
+ */
+#ifndef DPPS_POLYLINE_VECTOR
+#define DPPS_POLYLINE_VECTOR
+
+#include <array>
+#include <atomic>
+#include <bitset>
+#include <cstdint>
+#include <initializer_list>
+#include <memory>
+#include <utility>
+#include <vector>
+
+#include "common.hh"
+#include "Polyline.hh"
+
+namespace dpps {
+/** @brief A vector of Polyline whose copies share the same polylines until
+ * one of them is modified (copy on write).
+ *
+ * The Patterns are copied often: the factory functions return them, the
+ * scripts keep a copy before an operation, and each copy used to duplicate
+ * all the polylines. A Polyline_vector only copies a pointer, and the
+ * polylines are duplicated by the first function which may modify them:
+ * all the non-const functions, including the non-const operator[] and
+ * begin(). The const functions never duplicate anything.
+ *
+ * It has the part of the interface of std::vector that the classes use,
+ * with the same meaning, and the iterators are those of std::vector. It
+ * converts to a const std::vector<Polyline> &, and it is built and assigned
+ * from a std::vector<Polyline>.
+ *
+ * As with the implicitly shared containers of Qt, a reference or an
+ * iterator obtained from a non-const function must not be used to modify
+ * the polylines after the Polyline_vector was copied, as the copy would
+ * see the change. The functions which modify the polylines from several
+ * threads call detach() first, as the duplication itself may only happen
+ * on one thread.
+ *
+ * The selection registers can also be read and changed as words, 64
+ * polylines at a time (see selection_words()), for the operations of
+ * Pattern which work on a whole register. A register is packed from the
+ * bits of Polyline::selected when it is first asked for, and the changed
+ * words are written back to the polylines by the next function which
+ * accesses them, so that sort, erase, copies and the generators always see
+ * the selections in the polylines. In the same way, a reference to a
+ * polyline obtained from a non-const function must not be used to change
+ * its selection after selection_words() was called. */
+class Polyline_vector {
+public:
+    typedef Polyline value_type ;
+    typedef Polyline &reference ;
+    typedef const Polyline &const_reference ;
+    typedef Polyline *pointer ;
+    typedef const Polyline *const_pointer ;
+    typedef std::vector<Polyline>::iterator iterator ;
+    typedef std::vector<Polyline>::const_iterator const_iterator ;
+    typedef std::vector<Polyline>::reverse_iterator reverse_iterator ;
+    typedef std::vector<Polyline>::const_reverse_iterator
+        const_reverse_iterator ;
+    typedef std::vector<Polyline>::size_type size_type ;
+    typedef std::vector<Polyline>::difference_type difference_type ;
+
+protected:
+    /** @brief the polylines, shared with the copies. Empty vectors are not
+     * allocated: storage is then null. */
+    std::shared_ptr<std::vector<Polyline>> storage ;
+
+    enum {
+        // no register is packed
+        packed_none,
+        // the packed registers are the same as the bits of the polylines
+        packed_valid,
+        // some packed registers were changed and not yet written back
+        packed_ahead
+    } ;
+
+    /** @brief one of packed_none, packed_valid and packed_ahead, read by
+     * all the functions before they access the polylines. */
+    mutable std::atomic<int> packed_state {packed_none} ;
+
+    /** @brief the packed registers: polyline i is bit i % 64 of word i / 64,
+     * and the bits past the last polyline are zero. */
+    mutable std::array<std::vector<uint64_t>, polyline_max_selection>
+        packed_words ;
+
+    /** @brief the registers of packed_words which are up to date. */
+    mutable std::bitset<polyline_max_selection> packed_registers ;
+
+    /** @brief the registers of packed_words which are newer than the bits
+     * of the polylines. The polylines are then not shared with a copy. */
+    mutable std::bitset<polyline_max_selection> packed_registers_ahead ;
+
+    /** @brief the vector read by the const functions, after the changed
+     * registers were written back. */
+    const std::vector<Polyline> &shared () const {
+        if (packed_state. load (std::memory_order_acquire) == packed_ahead)
+            write_back_selection_words () ;
+        return storage ? *storage : empty_vector () ;
+    }
+
+    /** @brief the vector modified by the non-const functions, duplicated
+     * first if it is shared. The packed registers are written back and
+     * forgotten, as the polylines may change. */
+    std::vector<Polyline> &owned () {
+        if (packed_state. load (std::memory_order_acquire) != packed_none)
+            drop_selection_words () ;
+        if (!storage || (storage. use_count () > 1))
+            duplicate () ;
+        return *storage ;
+    }
+
+    /** @brief gives storage its own vector, without touching the packed
+     * registers. */
+    void duplicate () ;
+
+    /** @brief packs register r from the polylines if it is not up to date.
+     * To be called in the critical section polyline_vector_selections. */
+    void pack_register (const selection_t r) const ;
+
+    /** @brief writes the changed registers to the polylines, if there are
+     * some. */
+    void write_back_selection_words () const ;
+
+    /** @brief writes the changed registers to the polylines and forgets all
+     * the packed registers. */
+    void drop_selection_words () ;
+
+    /** @brief forgets the packed registers without writing them back, when
+     * the polylines are replaced. */
+    void forget_selection_words () ;
+
+    /** @brief takes the packed registers of v, which forgets them. */
+    void take_selection_words (Polyline_vector &v) ;
+
+    static const std::vector<Polyline> &empty_vector () ;
+
+public:
+    Polyline_vector () {
+    }
+
+    explicit Polyline_vector (const size_type n) ;
+
+    Polyline_vector (const size_type n, const Polyline &p) ;
+
+    template <class Iterator>
+    Polyline_vector (Iterator first, Iterator last) :
+        storage (std::make_shared<std::vector<Polyline>> (first, last)) {
+    }
+
+    Polyline_vector (std::initializer_list<Polyline> list) ;
+
+    /** @brief Constructor which copies the polylines of v. */
+    Polyline_vector (const std::vector<Polyline> &v) ;
+
+    /** @brief Constructor which takes the polylines of v, without copy. */
+    Polyline_vector (std::vector<Polyline> &&v) ;
+
+    /** @brief Copy constructor, which shares the polylines of v. The
+     * packed registers of v are written back first, and not copied. */
+    Polyline_vector (const Polyline_vector &v) ;
+
+    Polyline_vector (Polyline_vector &&v) ;
+
+    Polyline_vector &operator= (const Polyline_vector &v) ;
+
+    Polyline_vector &operator= (Polyline_vector &&v) ;
+
+    Polyline_vector &operator= (const std::vector<Polyline> &v) ;
+
+    Polyline_vector &operator= (std::vector<Polyline> &&v) ;
+
+    Polyline_vector &operator= (std::initializer_list<Polyline> list) ;
+
+    operator const std::vector<Polyline> & () const {
+        return shared () ;
+    }
+
+    /** @brief duplicates the polylines if they are shared with a copy, and
+     * writes back the packed registers, so that the next non-const functions
+     * do not have to. */
+    void detach () ;
+
+    /** @brief the words of selection register r: polyline i is bit i % 64
+     * of word i / 64, and the bits past the last polyline are zero. The
+     * register is packed from the polylines if it was not already. */
+    const std::vector<uint64_t> &selection_words (const selection_t r) const ;
+
+    /** @brief the words of selection register r, to be changed in place.
+     * They are written to the polylines by the next function which accesses
+     * these, and the bits past the last polyline must be left at zero. With
+     * keep_bits false, the register is not packed and its words are zero.
+     */
+    std::vector<uint64_t> &modified_selection_words (const selection_t r,
+        const bool keep_bits = true) ;
+
+    /** @brief whether register r is packed, so that selection_words() is
+     * only a read. */
+    bool has_selection_words (const selection_t r) const ;
+
+    /** @brief whether the polylines are shared with a copy. */
+    bool is_shared () const {
+        return storage && (storage. use_count () > 1) ;
+    }
+
+    Polyline *data () {
+        return owned (). data () ;
+    }
+
+    const Polyline *data () const {
+        return shared (). data () ;
+    }
+
+    iterator begin () {
+        return owned (). begin () ;
+    }
+
+    iterator end () {
+        return owned (). end () ;
+    }
+
+    const_iterator begin () const {
+        return shared (). begin () ;
+    }
+
+    const_iterator end () const {
+        return shared (). end () ;
+    }
+
+    const_iterator cbegin () const {
+        return shared (). cbegin () ;
+    }
+
+    const_iterator cend () const {
+        return shared (). cend () ;
+    }
+
+    reverse_iterator rbegin () {
+        return owned (). rbegin () ;
+    }
+
+    reverse_iterator rend () {
+        return owned (). rend () ;
+    }
+
+    const_reverse_iterator rbegin () const {
+        return shared (). rbegin () ;
+    }
+
+    const_reverse_iterator rend () const {
+        return shared (). rend () ;
+    }
+
+    const_reverse_iterator crbegin () const {
+        return shared (). crbegin () ;
+    }
+
+    const_reverse_iterator crend () const {
+        return shared (). crend () ;
+    }
+
+    // The sizes do not depend on the selections, they do not wait for the
+    // packed registers to be written back.
+    size_type size () const {
+        return storage ? storage-> size () : 0 ;
+    }
+
+    bool empty () const {
+        return size () == 0 ;
+    }
+
+    size_type capacity () const {
+        return storage ? storage-> capacity () : 0 ;
+    }
+
+    Polyline &operator[] (const size_type i) {
+        return owned ()[i] ;
+    }
+
+    const Polyline &operator[] (const size_type i) const {
+        return shared ()[i] ;
+    }
+
+    /** @brief returns polyline i, and throws std::out_of_range if there is
+     * none, as std::vector::at(). */
+    Polyline &at (const size_type i) {
+        return owned (). at (i) ;
+    }
+
+    const Polyline &at (const size_type i) const {
+        return shared (). at (i) ;
+    }
+
+    Polyline &front () {
+        return owned (). front () ;
+    }
+
+    const Polyline &front () const {
+        return shared (). front () ;
+    }
+
+    Polyline &back () {
+        return owned (). back () ;
+    }
+
+    const Polyline &back () const {
+        return shared (). back () ;
+    }
+
+    // p may be one of the polylines: if they were shared, the copy which
+    // still holds them keeps p alive.
+    void push_back (const Polyline &p) {
+        owned (). push_back (p) ;
+    }
+
+    void push_back (Polyline &&p) {
+        owned (). push_back (std::move (p)) ;
+    }
+
+    template <class... Arguments>
+    void emplace_back (Arguments &&... arguments) {
+        owned (). emplace_back (std::forward<Arguments> (arguments)...) ;
+    }
+
+    void pop_back () {
+        owned (). pop_back () ;
+    }
+
+    /** @brief removes all the polylines. Shared polylines are left to the
+     * copies, without being duplicated. */
+    void clear () ;
+
+    void reserve (const size_type n) {
+        owned (). reserve (n) ;
+    }
+
+    void shrink_to_fit () {
+        owned (). shrink_to_fit () ;
+    }
+
+    void resize (const size_type n) {
+        owned (). resize (n) ;
+    }
+
+    void resize (const size_type n, const Polyline &p) {
+        owned (). resize (n, p) ;
+    }
+
+    void assign (const size_type n, const Polyline &p) ;
+
+    template <class Iterator>
+    void assign (Iterator first, Iterator last) {
+        // the iterators may refer to the shared polylines
+        forget_selection_words () ;
+        storage = std::make_shared<std::vector<Polyline>> (first, last) ;
+    }
+
+    void assign (std::initializer_list<Polyline> list) ;
+
+    // The positions given to insert() and erase() may come from the const
+    // functions, before the polylines are duplicated, so they are converted
+    // to indices first.
+    iterator insert (const_iterator position, const Polyline &p) ;
+
+    iterator insert (const_iterator position, Polyline &&p) ;
+
+    iterator insert (const_iterator position, const size_type n,
+                     const Polyline &p) ;
+
+    template <class Iterator>
+    iterator insert (const_iterator position, Iterator first,
+                     Iterator last) {
+        difference_type i {position - shared (). cbegin ()} ;
+        std::vector<Polyline> &v = owned () ;
+        return v. insert (v. cbegin () + i, first, last) ;
+    }
+
+    iterator insert (const_iterator position,
+                     std::initializer_list<Polyline> list) ;
+
+    iterator erase (const_iterator position) ;
+
+    iterator erase (const_iterator first, const_iterator last) ;
+
+    void swap (Polyline_vector &v) ;
+
+    bool operator== (const Polyline_vector &v) const ;
+
+    bool operator!= (const Polyline_vector &v) const ;
+} ;
+
+inline void swap (Polyline_vector &a, Polyline_vector &b) {
+    a. swap (b) ;
+}
+} // namespace dpps
+#endif
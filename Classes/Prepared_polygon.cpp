@@ -0,0 +1,171 @@
+/**
+ * @file Prepared_polygon.cpp
+ * @author Jérôme Borme <jerome.borme@inl.int>
+ * @version 1.0
+ * @brief Class Prepared_polygon, which answers many point-in-polygon queries
+ * on the same polygon
+ * @date 2026-10-14 Jérôme Borme: Initial version
+ * @copyright
+ * This Source Code Form is subject to the terms of the Mozilla Public
+ * License, v. 2.0. If a copy of the MPL was not distributed with this
+ * file, You can obtain one at http://mozilla.org/MPL/2.0/.
+ */
+
+#include <cmath>
+#include <algorithm>
+#include <functional>
+#include <utility>
+
+#include "Prepared_polygon.hh"
+
+// The number of bands is at most the number of edges, and is reduced when
+// the edges would be repeated in more than this many bands on average.
+static const double maximum_bands_per_edge {16.0} ;
+
+dpps::Prepared_polygon::Prepared_polygon (const Polyline &polyline) {
+    long_unsigned_int l {polyline. size ()} ;
+    if (l < 3)
+        return ;
+    polyline. limits (minx, miny, maxx, maxy) ;
+    double total_height {0} ;
+    edges. reserve (l) ;
+    for (long_unsigned_int i {0} ; i < l ; i++) {
+        // the last vertex is followed by the first one
+        const Vertex &a {polyline. vertices[i]} ;
+        const Vertex &b {polyline. vertices[(i + 1) % l]} ;
+        // Horizontal edges never cross a horizontal ray with the half-open
+        // rule.
+        if (a. y == b. y)
+            continue ;
+        edges. push_back (Edge {a. x, a. y, b. x, b. y}) ;
+        total_height += fabs (b. y - a. y) ;
+    }
+    long_unsigned_int e {edges. size ()} ;
+    if (e == 0)
+        return ;
+    double height {maxy - miny} ;
+    double bands {std::min (static_cast<double> (e),
+        maximum_bands_per_edge * e * height / total_height)} ;
+    number_bands = std::max (static_cast<long_unsigned_int> (bands),
+                             static_cast<long_unsigned_int> (1)) ;
+    band_height = height / number_bands ;
+    double size {std::max ({fabs (minx), fabs (maxx), fabs (miny),
+                            fabs (maxy), maxx - minx, height})} ;
+    x_margin = 1e-12 * size ;
+    band_margin = std::max (1e-6 * band_height, x_margin) ;
+
+    // The edges are put in the bands in two passes, counting then filling.
+    auto band_of = [this] (const double y) {
+        double k {floor ((y - miny) / band_height)} ;
+        if (k < 0)
+            return static_cast<long_unsigned_int> (0) ;
+        if (k >= number_bands)
+            return number_bands - 1 ;
+        return static_cast<long_unsigned_int> (k) ;
+    } ;
+    auto for_each_band = [&] (const std::function<void (
+        long_unsigned_int, long_unsigned_int, bool)> &f) {
+        for (long_unsigned_int i {0} ; i < e ; i++) {
+            double ylo {std::min (edges[i]. ay, edges[i]. by)} ;
+            double yhi {std::max (edges[i]. ay, edges[i]. by)} ;
+            long_unsigned_int first {band_of (ylo - band_margin)} ;
+            long_unsigned_int last {band_of (yhi + band_margin)} ;
+            for (long_unsigned_int k {first} ; k <= last ; k++) {
+                double y0 {miny + k * band_height} ;
+                bool spanning {(ylo < y0 - band_margin) &&
+                               (yhi > y0 + band_height + band_margin)} ;
+                f (i, k, spanning) ;
+            }
+        }
+    } ;
+    spanning_offsets. resize (number_bands + 1, 0) ;
+    partial_offsets. resize (number_bands + 1, 0) ;
+    for_each_band ([this] (long_unsigned_int, long_unsigned_int k,
+                           bool spanning) {
+        if (spanning)
+            spanning_offsets[k+1]++ ;
+        else
+            partial_offsets[k+1]++ ;
+    }) ;
+    for (long_unsigned_int k {0} ; k < number_bands ; k++) {
+        spanning_offsets[k+1] += spanning_offsets[k] ;
+        partial_offsets[k+1] += partial_offsets[k] ;
+    }
+    std::vector<std::pair<double, long_unsigned_int>> spanning (
+        spanning_offsets. back ()) ;
+    partial_edges. resize (partial_offsets. back ()) ;
+    std::vector<long_unsigned_int> next_spanning (spanning_offsets. begin (),
+                                                  spanning_offsets. end () - 1) ;
+    std::vector<long_unsigned_int> next_partial (partial_offsets. begin (),
+                                                 partial_offsets. end () - 1) ;
+    band_width. resize (number_bands, 0) ;
+    for_each_band ([&] (long_unsigned_int i, long_unsigned_int k,
+                        bool spanning_band) {
+        if (!spanning_band) {
+            partial_edges[next_partial[k]++] = i ;
+            return ;
+        }
+        // abscissas of the edge at the bottom and top of the band
+        const Edge &edge {edges[i]} ;
+        double slope {(edge. bx - edge. ax) / (edge. by - edge. ay)} ;
+        double y0 {miny + k * band_height - band_margin} ;
+        double y1 {miny + (k + 1) * band_height + band_margin} ;
+        double x0 {edge. ax + (y0 - edge. ay) * slope} ;
+        double x1 {edge. ax + (y1 - edge. ay) * slope} ;
+        double xmin {std::min (x0, x1) - x_margin} ;
+        double xmax {std::max (x0, x1) + x_margin} ;
+        spanning[next_spanning[k]++] = std::make_pair (xmin, i) ;
+        band_width[k] = std::max (band_width[k], xmax - xmin) ;
+    }) ;
+    spanning_edges. reserve (spanning. size ()) ;
+    spanning_xmin. reserve (spanning. size ()) ;
+    for (long_unsigned_int k {0} ; k < number_bands ; k++) {
+        std::sort (spanning. begin () + spanning_offsets[k],
+                   spanning. begin () + spanning_offsets[k+1]) ;
+        for (long_unsigned_int j {spanning_offsets[k]} ;
+             j < spanning_offsets[k+1] ; j++) {
+            spanning_xmin. push_back (spanning[j]. first) ;
+            spanning_edges. push_back (spanning[j]. second) ;
+        }
+    }
+}
+
+bool dpps::Prepared_polygon::crosses (const Edge &e, const Vertex &v) const {
+    if ((e. ay > v. y) == (e. by > v. y))
+        return false ;
+    return e. ax + (v. y - e. ay) * (e. bx - e. ax) / (e. by - e. ay) < v. x ;
+}
+
+bool dpps::Prepared_polygon::contains (const Vertex &v) const {
+    // With the half-open rule, no edge crosses the ray at y = maxy.
+    if ((number_bands == 0) ||
+        (v. x < minx) || (v. x > maxx) || (v. y < miny) || (v. y >= maxy))
+        return false ;
+    long_unsigned_int k {std::min (
+        static_cast<long_unsigned_int> ((v. y - miny) / band_height),
+        number_bands - 1)} ;
+    const double *first {spanning_xmin. data () + spanning_offsets[k]} ;
+    const double *last {spanning_xmin. data () + spanning_offsets[k+1]} ;
+    // The edges starting before v.x - band_width end before v.x, and the
+    // edges starting after v.x are after it: only the edges between are
+    // tested.
+    const double *sure {std::lower_bound (first, last, v. x - band_width[k])} ;
+    long_unsigned_int crossings {static_cast<long_unsigned_int> (sure - first)} ;
+    for (const double *x {sure} ; (x < last) && (*x < v. x) ; x++)
+        crossings += crosses (
+            edges[spanning_edges[x - spanning_xmin. data ()]], v) ;
+    for (long_unsigned_int j {partial_offsets[k]} ;
+         j < partial_offsets[k+1] ; j++)
+        crossings += crosses (edges[partial_edges[j]], v) ;
+    return (crossings % 2) == 1 ;
+}
+
+bool dpps::Prepared_polygon::contains (const Polyline &polyline) const {
+    if (polyline. size () == 0)
+        return false ;
+    // the reference &v is used to avoid copy
+    for (auto &v: polyline. vertices)
+        if (!contains (v))
+            return false ;
+    return true ;
+}
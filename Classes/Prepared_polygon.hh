@@ -0,0 +1,89 @@
+/**
+ * @file Prepared_polygon.hh
+ * @author Jérôme Borme <jerome.borme@inl.int>
+ * @version 1.0
+ * @brief Header file for class Prepared_polygon, which answers many
+ * point-in-polygon queries on the same polygon
+ * @date 2026-10-14 Jérôme Borme: Initial version
+ * @copyright
+ * This Source Code Form is subject to the terms of the Mozilla Public
+ * License, v. 2.0. If a copy of the MPL was not distributed with this
+ * file, You can obtain one at http://mozilla.org/MPL/2.0/.
+ */
+#ifndef DPPS_PREPARED_POLYGON
+#define DPPS_PREPARED_POLYGON
+
+#include <vector>
+
+#include "common.hh"
+#include "Vertex.hh"
+#include "Polyline.hh"
+
+namespace dpps {
+/** @brief A polygon prepared once, to decide quickly whether many vertices
+ * are inside it.
+ *
+ * The height of the polygon is divided into horizontal bands. In each band,
+ * the edges crossing the whole band are sorted by their abscissa in the band,
+ * so that most of them are counted with a binary search, and only the edges
+ * near the vertex and those ending in the band are tested one by one. The
+ * number of bands is chosen so that there are a few edges per band, and a
+ * query takes a time close to O(log E) for E edges.
+ *
+ * As with Polyline::contains(), the polygon is taken to be closed, and a
+ * vertex is inside when a horizontal ray from it crosses an odd number of
+ * edges. The crossings are counted with the half-open rule of the hatching
+ * of Pattern_factory (fill_rule_even_odd), so the result may differ from
+ * Polyline::contains() for vertices on the edges, or whose ray goes through
+ * a vertex of the polygon.
+ *
+ * The polyline is copied, and can be changed or destroyed afterwards.
+ */
+class Prepared_polygon {
+protected:
+    /** @brief an edge from (ax, ay) to (bx, by), not horizontal. */
+    struct Edge {
+        double ax, ay, bx, by ;
+    } ;
+    std::vector<Edge> edges ;
+
+    double minx {0}, miny {0}, maxx {0}, maxy {0} ;
+    double band_height {0} ;
+    long_unsigned_int number_bands {0} ;
+
+    /** @brief margin of the bands, and of the abscissas of the edges in
+     * them, which covers the rounding errors. */
+    double band_margin {0} ;
+    double x_margin {0} ;
+
+    /** @brief for band k, the edges crossing the whole band are between
+     * spanning_offsets[k] and spanning_offsets[k+1] of spanning_edges,
+     * sorted by spanning_xmin, the smallest abscissa of the edge in the
+     * band. band_width[k] is the largest extent in x of these edges. */
+    std::vector<long_unsigned_int> spanning_offsets ;
+    std::vector<long_unsigned_int> spanning_edges ;
+    std::vector<double> spanning_xmin ;
+    std::vector<double> band_width ;
+
+    /** @brief for band k, the other edges in the band are between
+     * partial_offsets[k] and partial_offsets[k+1] of partial_edges. */
+    std::vector<long_unsigned_int> partial_offsets ;
+    std::vector<long_unsigned_int> partial_edges ;
+
+    /** @brief whether edge e crosses the horizontal ray going from v towards
+     * negative x. */
+    bool crosses (const Edge &e, const Vertex &v) const ;
+public:
+    /** @brief Constructor. A polyline of less than 3 vertices contains no
+     * vertex. */
+    Prepared_polygon (const Polyline &polyline) ;
+
+    /** @brief Returns whether v is inside the polygon. */
+    bool contains (const Vertex &v) const ;
+
+    /** @brief Returns whether all the vertices of polyline are inside the
+     * polygon. An empty polyline is not inside. */
+    bool contains (const Polyline &polyline) const ;
+} ;
+} // namespace dpps
+#endif
@@ -0,0 +1,287 @@
+/**
+ * @file Proximity_correction.cpp
+ * @author Jérôme Borme <jerome.borme@inl.int>
+ * @version 1.0
+ * @brief Implementation of class Proximity_correction
+ * @date 2026-10-14 Jérôme Borme: Initial version
+ * @copyright
+ * This Source Code Form is subject to the terms of the Mozilla Public
+ * License, v. 2.0. If a copy of the MPL was not distributed with this
+ * file, You can obtain one at http://mozilla.org/MPL/2.0/.
+ */
+
+#include <algorithm>
+#include <cmath>
+#include <limits>
+
+#include "Proximity_correction.hh"
+#include "Fourier_transform.hh"
+#include "bad_parametre.hh"
+
+dpps::Proximity_correction::Proximity_correction () {
+}
+
+dpps::Proximity_correction::Proximity_correction (
+    const double alpha,
+    const double beta,
+    const double eta,
+    const double pixel_size,
+    const long_unsigned_int iterations,
+    const double target_exposure) {
+    set_all_parametres (alpha, beta, eta, pixel_size, iterations,
+                        target_exposure) ;
+}
+
+void dpps::Proximity_correction::set_all_parametres (
+    const double alpha,
+    const double beta,
+    const double eta,
+    const double pixel_size,
+    const long_unsigned_int iterations,
+    const double target_exposure) {
+    if ((alpha <= 0) || (beta <= 0) || (pixel_size <= 0) || (eta < 0) ||
+        (target_exposure < 0)) {
+        std::string reason {"Proximity_correction, alpha, beta and the pixel \
+size must be positive, eta and the target exposure must not be negative, got \
+alpha = " + std::to_string (alpha) + ", beta = " + std::to_string (beta) +
+            ", eta = " + std::to_string (eta) + ", pixel size = " +
+            std::to_string (pixel_size) + " and target exposure = " +
+            std::to_string (target_exposure) + "."} ;
+        throw bad_parametre (reason. c_str ()) ;
+    }
+    settings. alpha = alpha ;
+    settings. beta = beta ;
+    settings. eta = eta ;
+    settings. pixel_size = pixel_size ;
+    settings. iterations = iterations ;
+    settings. target_exposure = target_exposure ;
+}
+
+const dpps::Proximity_correction::Proximity_correction_settings &
+    dpps::Proximity_correction::get_settings () const {
+    return settings ;
+}
+
+void dpps::Proximity_correction::rasterise (const Polyline &p,
+    std::vector<std::pair<long_unsigned_int, double>> &result) const {
+    const double size {settings. pixel_size} ;
+    auto pixel = [&] (const double x, const double y) {
+        long signed int i {static_cast<long signed int> (
+            floor ((x - origin. x) / size))} ;
+        long signed int j {static_cast<long signed int> (
+            floor ((y - origin. y) / size))} ;
+        i = std::max (0L, std::min (i, static_cast<long signed int> (nx) - 1)) ;
+        j = std::max (0L, std::min (j, static_cast<long signed int> (ny) - 1)) ;
+        return static_cast<long_unsigned_int> (j) * nx + i ;
+    } ;
+    long_unsigned_int n {p. size ()} ;
+    if (n == 0)
+        return ;
+    if (n == 1) {
+        result. push_back (std::make_pair (
+            pixel (p. vertices[0]. x, p. vertices[0]. y), 1.0)) ;
+        return ;
+    }
+    if (!p. closed || (n < 3)) {
+        // Points every half pixel along the segments.
+        for (long_unsigned_int k {0} ; k + 1 < n ; k++) {
+            const Vertex &a = p. vertices[k] ;
+            const Vertex &b = p. vertices[k + 1] ;
+            double length {sqrt ((b. x - a. x) * (b. x - a. x) +
+                                 (b. y - a. y) * (b. y - a. y))} ;
+            long_unsigned_int steps {std::max<long_unsigned_int> (1,
+                static_cast<long_unsigned_int> (ceil (2 * length / size)))} ;
+            for (long_unsigned_int m {0} ; m < steps ; m++) {
+                double t {(m + 0.5) / steps} ;
+                result. push_back (std::make_pair (
+                    pixel (a. x + t * (b. x - a. x), a. y + t * (b. y - a. y)),
+                    length / (steps * size))) ;
+            }
+        }
+        return ;
+    }
+    // The pixels whose centre is inside, row by row, with the even-odd rule.
+    double xmin {0.0}, ymin {0.0}, xmax {0.0}, ymax {0.0} ;
+    p. limits (xmin, ymin, xmax, ymax) ;
+    long signed int j_first {static_cast<long signed int> (
+        ceil ((ymin - origin. y) / size - 0.5))} ;
+    long signed int j_last {static_cast<long signed int> (
+        floor ((ymax - origin. y) / size - 0.5))} ;
+    long_unsigned_int first {result. size ()} ;
+    std::vector<double> crossings ;
+    for (long signed int j {j_first} ; j <= j_last ; j++) {
+        double y {origin. y + (j + 0.5) * size} ;
+        crossings. clear () ;
+        for (long_unsigned_int k {0} ; k < n ; k++) {
+            const Vertex &a = p. vertices[k] ;
+            const Vertex &b = p. vertices[(k + 1) % n] ;
+            if ((a. y <= y) != (b. y <= y))
+                crossings. push_back (a. x + (y - a. y) * (b. x - a. x) /
+                                             (b. y - a. y)) ;
+        }
+        std::sort (crossings. begin (), crossings. end ()) ;
+        for (long_unsigned_int k {0} ; k + 1 < crossings. size () ; k += 2) {
+            long signed int i_first {static_cast<long signed int> (
+                ceil ((crossings[k] - origin. x) / size - 0.5))} ;
+            long signed int i_end {static_cast<long signed int> (
+                ceil ((crossings[k + 1] - origin. x) / size - 0.5))} ;
+            for (long signed int i {i_first} ; i < i_end ; i++)
+                result. push_back (std::make_pair (
+                    static_cast<long_unsigned_int> (j) * nx + i, 1.0)) ;
+        }
+    }
+    // A polyline smaller than a pixel as a part of the pixel of its centre.
+    if (result. size () == first)
+        result. push_back (std::make_pair (
+            pixel ((xmin + xmax) / 2, (ymin + ymax) / 2),
+            std::min (1.0, p. area () / (size * size)))) ;
+}
+
+void dpps::Proximity_correction::prepare (const Pattern &pattern) {
+    const double size {settings. pixel_size} ;
+    double xmin {0.0}, ymin {0.0}, xmax {0.0}, ymax {0.0} ;
+    pattern. limits (xmin, ymin, xmax, ymax) ;
+    // With a margin of twice the range on each side, the convolution by
+    // Fourier transforms, which is periodic, does not mix opposite sides.
+    double range {std::max (settings. alpha, settings. beta)} ;
+    long_unsigned_int margin {static_cast<long_unsigned_int> (
+        ceil (2 * range / size)) + 1} ;
+    double pixels_x {ceil ((xmax - xmin) / size) + 1 + 2 * margin} ;
+    double pixels_y {ceil ((ymax - ymin) / size) + 1 + 2 * margin} ;
+    const double maximum_pixels {268435456.0} ;
+    if (pixels_x * pixels_y > maximum_pixels) {
+        std::string reason {"Proximity_correction, the pattern would need " +
+            std::to_string (pixels_x) + " × " + std::to_string (pixels_y) +
+            " pixels of " + std::to_string (size) + ", more than " +
+            std::to_string (maximum_pixels) +
+            ". The pixel size should be increased."} ;
+        throw bad_parametre (reason. c_str ()) ;
+    }
+    nx = Fourier_transform::next_power_of_two (
+        static_cast<long_unsigned_int> (pixels_x)) ;
+    ny = Fourier_transform::next_power_of_two (
+        static_cast<long_unsigned_int> (pixels_y)) ;
+    origin = Vertex (xmin - margin * size, ymin - margin * size) ;
+
+    kernel. assign (nx * ny, 0.0) ;
+    auto add_Gaussian = [&] (const double sigma, const double weight) {
+        long signed int radius_x {static_cast<long signed int> (std::min (
+            ceil (4 * sigma / size), static_cast<double> (nx / 2 - 1)))} ;
+        long signed int radius_y {static_cast<long signed int> (std::min (
+            ceil (4 * sigma / size), static_cast<double> (ny / 2 - 1)))} ;
+        // Normalised on the grid, so that a Gaussian narrower than a pixel
+        // keeps its integral.
+        double sum {0.0} ;
+        for (long signed int dj {-radius_y} ; dj <= radius_y ; dj++)
+            for (long signed int di {-radius_x} ; di <= radius_x ; di++)
+                sum += exp (-(di * di + dj * dj) * size * size /
+                            (sigma * sigma)) ;
+        for (long signed int dj {-radius_y} ; dj <= radius_y ; dj++)
+            for (long signed int di {-radius_x} ; di <= radius_x ; di++) {
+                long_unsigned_int i {static_cast<long_unsigned_int> (
+                    (di + static_cast<long signed int> (nx)) % nx)} ;
+                long_unsigned_int j {static_cast<long_unsigned_int> (
+                    (dj + static_cast<long signed int> (ny)) % ny)} ;
+                kernel[j * nx + i] += weight / sum *
+                    exp (-(di * di + dj * dj) * size * size / (sigma * sigma)) ;
+            }
+    } ;
+    add_Gaussian (settings. alpha, 1 / (1 + settings. eta)) ;
+    add_Gaussian (settings. beta, settings. eta / (1 + settings. eta)) ;
+    Fourier_transform::transform_2d (kernel, nx, ny) ;
+
+    long_unsigned_int n {pattern. polylines. size ()} ;
+    pixels. assign (n, std::vector<std::pair<long_unsigned_int, double>> ()) ;
+#ifdef OPENMP_FOUND
+    #pragma omp parallel for schedule(dynamic, 64) if (n > 256)
+#endif
+    for (long_unsigned_int k = 0 ; k < n ; k++)
+        rasterise (pattern. polylines[k], pixels[k]) ;
+}
+
+std::vector<double> dpps::Proximity_correction::exposures_for (
+    const std::vector<double> &doses) const {
+    std::vector<std::complex<double>> grid (nx * ny, 0.0) ;
+    for (long_unsigned_int k {0} ; k < pixels. size () ; k++) {
+        if (doses[k] <= 0)
+            continue ;
+        // the reference &pixel is used to avoid copy
+        for (auto &pixel: pixels[k])
+            grid[pixel. first] += doses[k] * pixel. second ;
+    }
+    Fourier_transform::transform_2d (grid, nx, ny) ;
+    for (long_unsigned_int i {0} ; i < grid. size () ; i++)
+        grid[i] *= kernel[i] ;
+    Fourier_transform::transform_2d (grid, nx, ny, true) ;
+    long_unsigned_int n {pixels. size ()} ;
+    std::vector<double> result (n, 0.0) ;
+#ifdef OPENMP_FOUND
+    #pragma omp parallel for schedule(dynamic, 256) if (n > 1024)
+#endif
+    for (long_unsigned_int k = 0 ; k < n ; k++) {
+        double exposure {0.0}, weight {0.0} ;
+        // the reference &pixel is used to avoid copy
+        for (auto &pixel: pixels[k]) {
+            exposure += pixel. second * grid[pixel. first]. real () ;
+            weight += pixel. second ;
+        }
+        if (weight > 0)
+            result[k] = exposure / weight ;
+    }
+    return result ;
+}
+
+std::vector<double> dpps::Proximity_correction::exposures (
+    const Pattern &pattern) {
+    prepare (pattern) ;
+    std::vector<double> doses ;
+    doses. reserve (pattern. polylines. size ()) ;
+    // the reference &p is used to avoid copy
+    for (auto &p: pattern. polylines)
+        doses. push_back (p. dose) ;
+    std::vector<double> result {exposures_for (doses)} ;
+    kernel. clear () ;
+    pixels. clear () ;
+    return result ;
+}
+
+void dpps::Proximity_correction::correct (Pattern &pattern,
+                                          const selection_t selection) {
+check_selection_not_too_high(selection) ;
+    prepare (pattern) ;
+    long_unsigned_int n {pattern. polylines. size ()} ;
+    std::vector<double> doses ;
+    doses. reserve (n) ;
+    // the reference &p is used to avoid copy
+    for (auto &p: static_cast<const Pattern &> (pattern). polylines)
+        doses. push_back (p. dose) ;
+    std::vector<bool> corrected (n, false) ;
+    for (long_unsigned_int k {0} ; k < n ; k++)
+        corrected[k] = (doses[k] > 0) &&
+            ((selection < 0) ||
+             static_cast<const Pattern &> (pattern). polylines[k].
+                 selected[selection]) ;
+    std::vector<double> exposure {exposures_for (doses)} ;
+    std::vector<double> target (n, settings. target_exposure) ;
+    if (settings. target_exposure == 0) {
+        double ratio {std::numeric_limits<double>::max ()} ;
+        for (long_unsigned_int k {0} ; k < n ; k++)
+            if (corrected[k] && (exposure[k] > 0))
+                ratio = std::min (ratio, exposure[k] / doses[k]) ;
+        for (long_unsigned_int k {0} ; k < n ; k++)
+            target[k] = doses[k] * ratio ;
+    }
+    for (long_unsigned_int iteration {0} ; iteration < settings. iterations ;
+         iteration++) {
+        if (iteration > 0)
+            exposure = exposures_for (doses) ;
+        for (long_unsigned_int k {0} ; k < n ; k++)
+            if (corrected[k] && (exposure[k] > 0))
+                doses[k] *= target[k] / exposure[k] ;
+    }
+    for (long_unsigned_int k {0} ; k < n ; k++)
+        if (corrected[k])
+            pattern. polylines[k]. dose = doses[k] ;
+    kernel. clear () ;
+    pixels. clear () ;
+}
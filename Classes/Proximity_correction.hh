@@ -0,0 +1,131 @@
+/**
+ * @file Proximity_correction.hh
+ * @author Jérôme Borme <jerome.borme@inl.int>
+ * @version 1.0
+ * @brief Header file for class Proximity_correction, which sets the doses
+ * of a pattern to compensate the proximity effect
+ * @date 2026-10-14 Jérôme Borme: Initial version
+ * @copyright
+ * This Source Code Form is subject to the terms of the Mozilla Public
+ * License, v. 2.0. If a copy of the MPL was not distributed with this
+ * file, You can obtain one at http://mozilla.org/MPL/2.0/.
+ */
+#ifndef DPPS_PROXIMITY_CORRECTION
+#define DPPS_PROXIMITY_CORRECTION
+
+#include <complex>
+#include <utility>
+#include <vector>
+
+#include "common.hh"
+#include "Polyline.hh"
+#include "Pattern.hh"
+
+namespace dpps {
+/** @brief Corrects the doses of a pattern for the proximity effect of
+ * electron beam lithography.
+ *
+ * The energy deposited by the exposure of a point spreads around it
+ * following the point spread function
+ *
+ *      f (r) = 1 / (1 + η) (G_α (r) + η G_β (r)),
+ *
+ * where G_σ is a Gaussian of integral 1 and width σ, α the range of the
+ * forward scattering and β the one of the backscattering, and η the ratio
+ * of the backscattered energy to the forward scattered one. In a dense
+ * lattice, each polyline receives the backscattered electrons of all its
+ * neighbours, so that the centre is more exposed than the edges.
+ *
+ * The pattern is drawn on a grid of pixels of pixel_size: each pixel
+ * receives the dose of the polylines covering it (the centre of the pixel
+ * inside a closed polyline, a dot counting as one pixel, and an open
+ * polyline as a line one pixel wide). The exposure is the convolution of
+ * this grid by f, computed by fast Fourier transforms (see
+ * Fourier_transform) in O(N log N) for N pixels instead of the O(n²) sums
+ * between the n polylines. The exposure of a polyline is the mean exposure
+ * of its pixels.
+ *
+ * Each iteration then multiplies the dose of each selected polyline by
+ * the ratio of its target exposure to its exposure. With target_exposure
+ * set to 0 (the default), the target of a polyline is its initial dose
+ * times the smallest ratio of exposure to dose of the initial pattern:
+ * the least exposed polylines keep their dose, and the others have their
+ * dose decreased so that all receive the exposure they were meant to.
+ * Otherwise the target is target_exposure for all.
+ *
+ * All the polylines with a positive dose contribute to the exposure, but
+ * only those of the selection are changed. The lengths are in the unit of
+ * the pattern. */
+class Proximity_correction {
+public:
+    /** @brief A struct to encapsulate the settings */
+    struct Proximity_correction_settings {
+        double alpha {0.05} ;
+        double beta {10.0} ;
+        double eta {0.5} ;
+        double pixel_size {0.05} ;
+        long_unsigned_int iterations {10} ;
+        double target_exposure {0.0} ;
+    } ;
+
+protected:
+    Proximity_correction_settings settings ;
+
+    /** @brief the grid: pixel (i, j) is centred at origin + (i + 1/2,
+     * j + 1/2) pixel_size. */
+    Vertex origin ;
+    long_unsigned_int nx {0} ;
+    long_unsigned_int ny {0} ;
+
+    /** @brief the Fourier transform of the point spread function on the
+     * grid. */
+    std::vector<std::complex<double>> kernel ;
+
+    /** @brief the pixels of each polyline and their weights. */
+    std::vector<std::vector<std::pair<long_unsigned_int, double>>> pixels ;
+
+    /** @brief sets the grid for pattern, transforms the kernel and
+     * rasterises the polylines. */
+    void prepare (const Pattern &pattern) ;
+
+    /** @brief appends to result the pixels of p. */
+    void rasterise (const Polyline &p,
+                    std::vector<std::pair<long_unsigned_int, double>> &result)
+        const ;
+
+    /** @brief returns the exposure of each polyline for the doses. */
+    std::vector<double> exposures_for (const std::vector<double> &doses) const ;
+
+public:
+    Proximity_correction () ;
+
+    /** @brief Constructor with the double Gaussian point spread function,
+     * the size of the pixels and the number of iterations. */
+    Proximity_correction (const double alpha,
+                          const double beta,
+                          const double eta,
+                          const double pixel_size,
+                          const long_unsigned_int iterations = 10,
+                          const double target_exposure = 0.0) ;
+
+    /** @brief sets the settings, see the constructor. Throws bad_parametre if
+     * a length is not positive or if eta or target_exposure is negative. */
+    void set_all_parametres (const double alpha,
+                             const double beta,
+                             const double eta,
+                             const double pixel_size,
+                             const long_unsigned_int iterations,
+                             const double target_exposure) ;
+
+    const Proximity_correction_settings &get_settings () const ;
+
+    /** @brief returns the exposure of each polyline of pattern, 0 for the
+     * empty ones. */
+    std::vector<double> exposures (const Pattern &pattern) ;
+
+    /** @brief changes the doses of the selected polylines of pattern, see
+     * the description of the class. */
+    void correct (Pattern &pattern, const selection_t selection = -1) ;
+} ;
+} // namespace dpps
+#endif
@@ -21,7 +21,53 @@ dpps::Reader::~Reader () {
     close () ;
 }
 
+void dpps::Reader::open_file () {
+#ifndef ZLIB_FOUND
+    if (is_gzip_filename (filename)) {
+        std::string reason {"File " + filename + " cannot be decompressed, "
+                            "as dpps was compiled without zlib"} ;
+        throw bad_io (reason. c_str ()) ;
+    }
+#endif
+    // The compressed data must not go through the end of line conversions.
+    if (is_gzip_filename (filename))
+        file. open (filename, std::ios_base::in|std::ios_base::binary) ;
+    else
+        file. open (filename, std::ios_base::in) ;
+    if (!file. is_open ()) {
+        std::string reason {"File " + filename +
+                            " could not be open for input"} ;
+        throw bad_io (reason. c_str ()) ;
+    }
+#ifdef ZLIB_FOUND
+    if (is_gzip_filename (filename)) {
+        decompressor. reset (new Gzip_input_buffer (file. rdbuf ())) ;
+        static_cast<std::istream &> (file). rdbuf (decompressor. get ()) ;
+        // std::istream would otherwise turn the bad_io of invalid or
+        // truncated data into badbit, which the readers take as an end of
+        // file.
+        file. exceptions (std::ios_base::badbit) ;
+    }
+#endif
+}
+
+bool dpps::Reader::is_compressed () const {
+#ifdef ZLIB_FOUND
+    return static_cast<bool> (decompressor) ;
+#else
+    return false ;
+#endif
+}
+
 void dpps::Reader::close () {
+#ifdef ZLIB_FOUND
+    if (decompressor) {
+        file. exceptions (std::ios_base::goodbit) ;
+        // back to the std::filebuf of file
+        static_cast<std::istream &> (file). rdbuf (file. rdbuf ()) ;
+        decompressor. reset () ;
+    }
+#endif
     if (file. is_open ()){
         file. close () ;
         if (file. bad()) {
@@ -16,8 +16,14 @@
 #ifndef DPPS_READER
 #define DPPS_READER
 
+#include <memory>
+
+#include "configure.h"
 #include "Polyline.hh"
 #include "Pattern.hh"
+#ifdef ZLIB_FOUND
+#include "Gzip_buffer.hh"
+#endif
 
 namespace dpps {
 /** @brief This is the base abstract class for file input. It will be
@@ -37,6 +43,21 @@ protected:
     std::ifstream file ;
     std::string filename ;
     std::string metadata_string {""} ;
+
+#ifdef ZLIB_FOUND
+    /** @brief if the file name ends with .gz, the stream buffer of file,
+     * which decompresses the data read from the file itself. */
+    std::unique_ptr<Gzip_input_buffer> decompressor ;
+#endif
+
+    /** @brief opens file for filename, through a decompressing stream
+     * buffer if filename ends with .gz. Throws bad_io if the file cannot be
+     * opened. */
+    void open_file () ;
+
+    /** @brief whether file is read through a decompressing stream buffer,
+     * which cannot seek. */
+    bool is_compressed () const ;
 public:
     /** @brief A struct to pass encapsulate metadata used by Reader derivatives.
     *
@@ -24,7 +24,19 @@
 #include <algorithm>
 #include <istream>
 #include <iostream>
+#include <cctype>
+#include <cstdio>
+#include <cstdlib>
+#include <exception>
+#include <fstream>
+#include <iterator>
+#include <limits>
+#include <streambuf>
 
+#include "configure.h"
+#ifdef MMAP_FOUND
+#include <sys/stat.h>
+#endif
 #include "Reader_DXF_R12.hh"
 #include "bad_parametre.hh"
 #include "bad_io.hh"
@@ -32,12 +44,14 @@
 
 dpps::Reader_DXF_R12::Reader_DXF_R12 (const std::string &set_filename) {
     filename = set_filename ;
-    file. open (filename, std::ios_base::in) ;
-    if (!file. is_open ()) {
-        std::string reason {"File " + filename +
-                            " could not be open for input"} ;
-        throw bad_io (reason. c_str ()) ;
-    }
+    open_file () ;
+    // strangely, initializer lists would segfault here (at least with gcc)
+    entity_names. push_back (std::string ("POLYLINE")) ;
+    entity_names. push_back (std::string ("POINT")) ;
+    entity_names. push_back (std::string ("LINE")) ;
+    entity_names. push_back (std::string ("CIRCLE")) ;
+    vertex_names. push_back (std::string ("VERTEX")) ;
+    vertex_names. push_back (std::string ("SEQEND")) ;
 }
 
 dpps::Reader_DXF_R12::Reader_DXF_R12 (
@@ -105,6 +119,7 @@ void dpps::Reader_DXF_R12::set_all_parametres (
     }
     reader_settings. set_reference_from_layer = set_reference_from_layer ;
     reader_settings. include_blocks = include_blocks ;
+    state. layer_skipped. clear () ;
 
 }
 
@@ -136,26 +151,43 @@ supported by C++ (ECMAScript, basic, extended, awk, grep, egrep), got " +
 }
 
 
-bool dpps::Reader_DXF_R12::find_next_line (std::istream &scan_file, std::string target) {
-    std::string line ;
+bool dpps::Reader_DXF_R12::read_line (std::istream &scan_file,
+                                      Parse_state &state) const {
+    std::string &line = state. line ;
+    bool test {getline (scan_file, line). good ()} ;
+    sanitize_EOL (line) ;
+    // Same as remove_spaces_left and remove_spaces_right, but in place.
+    long_unsigned_int end {line. size ()} ;
+    while ((end > 0) &&
+           std::isspace (static_cast<unsigned char> (line[end-1])))
+        end-- ;
+    line. erase (end) ;
+    long_unsigned_int begin {0} ;
+    while ((begin < line. size ()) &&
+           std::isspace (static_cast<unsigned char> (line[begin])))
+        begin++ ;
+    line. erase (0, begin) ;
+    return test ;
+}
+
+bool dpps::Reader_DXF_R12::find_next_line (std::istream &scan_file,
+                                           Parse_state &state,
+                                           const std::string &target) const {
     bool finished {false} ;
     while (!finished) {
-        bool test = getline (scan_file, line). good() ;
-        sanitize_EOL (line) ;
-        line = remove_spaces_left  (line) ;
-        line = remove_spaces_right (line) ;
+        bool test {read_line (scan_file, state)} ;
         //if (!scan_file. good ())
         if (!test)
             break ;
-        finished = (line == target) ;
+        finished = (state. line == target) ;
     }
     return finished ;
 }
 
 long_unsigned_int dpps::Reader_DXF_R12::find_next_line_vector (std::istream &scan_file,
-                                   std::vector <std::string> vector_target,
-                                   bool &ok) {
-    std::string line ;
+                                   Parse_state &state,
+                                   const std::vector <std::string> &vector_target,
+                                   bool &ok) const {
     bool finished {false} ;
     // BUG gcc: if we remove {0} then we get a -Wmaybe-uninitialized
     // warning (which is ok by itself), but at the wrong place,
@@ -164,17 +196,14 @@ long_unsigned_int dpps::Reader_DXF_R12::find_next_line_vector (std::istream &sca
     //std::vector<std::string>::const_iterator i ;
     while (!finished) {
         //std::cerr << "*" ;
-        bool test {getline (scan_file, line). good()} ;
-        //std::cerr << "read line : " << line << " ##\n ";
-        sanitize_EOL (line) ;
-        line = remove_spaces_left  (line) ;
-        line = remove_spaces_right (line) ;
+        bool test {read_line (scan_file, state)} ;
+        //std::cerr << "read line : " << state. line << " ##\n ";
         //if (!scan_file. good ())
         if (!test) {
             //std::cerr << "getting out !\n";
             break ;
         }
-        i = vector_string_find (vector_target, line) ;
+        i = vector_string_find (vector_target, state. line) ;
         finished = (i != std::numeric_limits<long_unsigned_int>::max()) ;
         //std::cerr << i << " " << std::numeric_limits<long_unsigned_int>::max() << " " << finished << " ";
         //std::cerr << finished << "\n";
@@ -196,25 +225,27 @@ long_unsigned_int dpps::Reader_DXF_R12::find_next_line_vector (std::istream &sca
 }
 
 bool dpps::Reader_DXF_R12::get_field_value (std::istream &scan_file,
+                             Parse_state &state,
                              long int &field,
-                             std::string &value) {
+                             std::string &value) const {
     // std::cout << "Getting field value\n" ;
-    std::string line ;
-    bool test {getline (scan_file, line). good ()} ;
-    sanitize_EOL (line) ;
-    line = remove_spaces_left  (line) ;
-    line = remove_spaces_right (line) ;
+    std::string &line = state. line ;
+    bool test {read_line (scan_file, state)} ;
     //if (!scan_file. good ())
     if (!test)
         return false ;
     // std::cout << "We will convert " << line << std::endl ;
-    field = std::stol (line. c_str (), nullptr, 10) ;
+    // strtol works on the buffer directly, without building a new string.
+    char *end ;
+    field = strtol (line. c_str (), &end, 10) ;
+    if (end == line. c_str ()) {
+        std::string reason {"File " + filename +
+            ": group code expected, got " + line} ;
+        throw bad_io (reason. c_str ()) ;
+    }
     if (field == 0)
         return true ;
-    test = getline (scan_file, line). good () ;
-    sanitize_EOL (line) ;
-    line = remove_spaces_left  (line) ;
-    line = remove_spaces_right (line) ;
+    test = read_line (scan_file, state) ;
     //if (!scan_file. good ())
     if (!test)
         return false ;
@@ -225,14 +256,21 @@ bool dpps::Reader_DXF_R12::get_field_value (std::istream &scan_file,
 
 /** Returns true if the layer is NOT in our list, and that therefore we will be
  * looking for another polyline */
-bool dpps::Reader_DXF_R12::manage_layer (std::string &string_value) {
+bool dpps::Reader_DXF_R12::manage_layer (std::string &string_value,
+                                         Parse_state &state) const {
     sanitize_EOL (string_value) ;
     //std::cerr << "we have layer " << string_value << "\n" << std::flush; //***
     string_value = remove_spaces_left  (string_value) ;
     string_value = remove_spaces_right (string_value) ;
+    if (reader_settings. regex_grammar == all)
+        return false ;
+    auto known = state. layer_skipped. find (string_value) ;
+    if (known != state. layer_skipped. end ())
+        return known-> second ;
+    bool skip {false} ;
     switch (reader_settings. regex_grammar) {
         case all:
-            return false ;
+            break ;
         case verbatim:
         case comma_separated_verbatim_list:
             if (std::find (reader_settings. layers_to_read. begin (),
@@ -242,19 +280,20 @@ bool dpps::Reader_DXF_R12::manage_layer (std::string &string_value) {
                 // Layer not in our list, ignore this Polyline
                 // look_for_next_polyline = true ;
                 //std::cerr << "true 1\n" << std::flush;
-                return true ;
+                skip = true ;
             }
             break ;
         default:
         if (!std::regex_match (string_value, expression))
             // look_for_next_polyline = true ;
             //std::cerr << "true 2\n" << std::flush ;
-            return true ;
+            skip = true ;
     }
     //std::cerr << "false \n"  << std::flush;
+    state. layer_skipped[string_value] = skip ;
 
     // N.B. true means "look for next polyline", false we accept this polyline
-    return false ;
+    return skip ;
 }
 
 /** Returns the reference to be used with the object (polyline, line, point, circle) */
@@ -293,16 +332,6 @@ long_unsigned_int dpps::Reader_DXF_R12::manage_reference (
 }
 
 bool dpps::Reader_DXF_R12::read_polyline (Polyline &p) {
-
-    std::string string_value ;
-    std::string polyline_layer ;
-    bool set_x,
-         set_y ;
-    long int field ;
-    double x {0.0} ;
-    double y {0.0} ;
-    Vertex v ;
-    std::string reason ;
     if (!file. good ())
         return false ;
     if (!reader_settings. include_blocks) {
@@ -315,45 +344,52 @@ bool dpps::Reader_DXF_R12::read_polyline (Polyline &p) {
         if (!skipped_header) {
             // Before ENTITIES can be BLOCK sections, but we do not support them.
             // After ENTITIES start the actual polylines.
-            skipped_header = find_next_line (file, "ENTITIES") ;
+            skipped_header = find_next_line (file, state, "ENTITIES") ;
             if (!skipped_header)
                 return false ;
         }
     }
-    // strangely, the line below would segfault (at least with gcc)
-    //std::vector<std::string> sequence {{"VERTEX", "SEQEND"}} ;
-    std::vector<std::string> sequence2 ;
-    sequence2. push_back (std::string ("VERTEX")) ;
-    sequence2. push_back (std::string ("SEQEND")) ;
-    std::vector<std::string> sequence1 ;
-    sequence1. push_back (std::string ("POLYLINE")) ;
-    sequence1. push_back (std::string ("POINT")) ;
-    sequence1. push_back (std::string ("LINE")) ;
-    sequence1. push_back (std::string ("CIRCLE")) ;
+    std::string polyline_layer ;
+    if (!read_entity (file, state, p, polyline_layer))
+        return false ;
+    p. reference = manage_reference (layers_read, polyline_layer) ;
+    return true ;
+}
+
+bool dpps::Reader_DXF_R12::read_entity (std::istream &scan_file,
+                                        Parse_state &state,
+                                        Polyline &p,
+                                        std::string &polyline_layer) const {
+    std::string string_value ;
+    bool set_x,
+         set_y ;
+    long int field ;
+    double x {0.0} ;
+    double y {0.0} ;
+    Vertex v ;
     while (true) {
         bool set_layer {false} ;
         bool set_closed {false} ;
         bool look_for_next_polyline {false} ;
         bool found ;
         //std::cerr << "." ;
-        long_unsigned_int pos {find_next_line_vector (file, sequence1, found)} ;
+        long_unsigned_int pos {find_next_line_vector (scan_file, state, entity_names, found)} ;
         if (!found)
             return false ;
         if (pos == 0) { // POLYLINE
             while ((!set_layer || !set_closed) && !look_for_next_polyline) {
-                found = get_field_value (file, field, string_value) ;
+                found = get_field_value (scan_file, state, field, string_value) ;
                 // std::cerr << "field " << field << " " << string_value << "\n" ;
                 if (!found)
                     return false ;
                 switch (field) {
                     case 8: // LAYER
-                        look_for_next_polyline = manage_layer (string_value) ;
+                        look_for_next_polyline = manage_layer (string_value, state) ;
                         set_layer = true ;
                         polyline_layer = string_value ;
                         break ;
                     case 70: // CLOSED
-                        p. closed = (std::stol (string_value. c_str (),
-                                            nullptr, 10) == 1) ;
+                        p. closed = (std::stol (string_value) == 1) ;
                         set_closed = true ;
                         break ;
                     // other fields are ignored.
@@ -377,7 +413,7 @@ bool dpps::Reader_DXF_R12::read_polyline (Polyline &p) {
             while (true) {
                 bool ok {true} ;
                 long_unsigned_int found_position {
-                    find_next_line_vector (file, sequence2, ok)} ;
+                    find_next_line_vector (scan_file, state, vertex_names, ok)} ;
                 if (!ok)
                     return false ;
                 switch (found_position) {
@@ -386,16 +422,13 @@ bool dpps::Reader_DXF_R12::read_polyline (Polyline &p) {
                         //////////////////////////////////////
                         // RETURN TRUE IS HERE FOR POLYLINE //
                         //////////////////////////////////////
-                        p. reference = manage_reference (layers_read,
-                                                         polyline_layer) ;
-                        //std::cerr << "POLY we use ref " << p.reference << "\n" ;
                         return true ;
                     case 0:
                         // if it's 0 and ok==true, then:
                         // VERTEX: good, let's proceed with reading vertex contents
                         break ;
                     default:
-                        // Not reachable, as sequence2 has only two components,
+                        // Not reachable, as vertex_names has only two components,
                         // returned value can only be 0 or 1.
                         // But compilers like to have default case treated.
                         return false ;
@@ -406,17 +439,17 @@ bool dpps::Reader_DXF_R12::read_polyline (Polyline &p) {
                 v. x = 0 ;
                 v. y = 0 ;
                 while (!(set_x && set_y)) {
-                    found = get_field_value (file, field, string_value) ;
+                    found = get_field_value (scan_file, state, field, string_value) ;
                     //std::cerr << "-- field " << field << " " << string_value << "\n" ;
                     if (!found)
                         return false ;
                     switch (field) {
                         case 10: // x coordinate
-                            x = std::stod (string_value. c_str (), nullptr) ;
+                            x = std::stod (string_value) ;
                             set_x = true ;
                             break ;
                         case 20: // y coordinate
-                            y = std::stod (string_value. c_str (), nullptr) ;
+                            y = std::stod (string_value) ;
                             set_y = true ;
                             break ;
                         // ignored cases:
@@ -442,27 +475,25 @@ bool dpps::Reader_DXF_R12::read_polyline (Polyline &p) {
             v. x = 0 ;
             v. y = 0 ;
             while (!look_for_next_polyline) {
-                found = get_field_value (file, field, string_value) ;
+                found = get_field_value (scan_file, state, field, string_value) ;
                 if (!found)
                     return false ;
                 switch (field) {
                     case 8: // LAYER
-                        look_for_next_polyline = manage_layer (string_value) ;
+                        look_for_next_polyline = manage_layer (string_value, state) ;
                         polyline_layer = string_value ;
                         break ;
                     case 10: // x coordinate
-                        v. x = std::stod (string_value. c_str (), nullptr) ;
+                        v. x = std::stod (string_value) ;
                         break ;
                     case 20: // y coordinate
-                        v. y = std::stod (string_value. c_str (), nullptr) ;
+                        v. y = std::stod (string_value) ;
                         break ;
                     case 0:
                         // We found SEQEND, Polyline is finished.
                         ///////////////////////////////////
                         // RETURN TRUE IS HERE FOR POINT //
                         ///////////////////////////////////
-                        p. reference = manage_reference (layers_read, polyline_layer) ;
-                        //std::cerr << "POINT we use ref " << p.reference << "\n" ;
                         p. push_back (v) ;
                         return true ;
                     default:
@@ -475,33 +506,31 @@ bool dpps::Reader_DXF_R12::read_polyline (Polyline &p) {
             v. y = 0 ;
             Vertex w (0,0) ;
             while (!look_for_next_polyline) {
-                found = get_field_value (file, field, string_value) ;
+                found = get_field_value (scan_file, state, field, string_value) ;
                 if (!found)
                     return false ;
                 switch (field) {
                     case 8: // LAYER
-                        look_for_next_polyline = manage_layer (string_value) ;
+                        look_for_next_polyline = manage_layer (string_value, state) ;
                         polyline_layer = string_value ;
                         break ;
                     case 10: // x coordinate, first point
-                        v. x = std::stod (string_value. c_str (), nullptr) ;
+                        v. x = std::stod (string_value) ;
                         break ;
                     case 20: // y coordinate, first point
-                        v. y = std::stod (string_value. c_str (), nullptr) ;
+                        v. y = std::stod (string_value) ;
                         break ;
                     case 11: // x coordinate, second point
-                        w. x = std::stod (string_value. c_str (), nullptr) ;
+                        w. x = std::stod (string_value) ;
                         break ;
                     case 21: // y coordinate, second point
-                        w. y = std::stod (string_value. c_str (), nullptr) ;
+                        w. y = std::stod (string_value) ;
                         break ;
                     case 0:
                         // We found SEQEND, Polyline is finished.
                         //////////////////////////////////
                         // RETURN TRUE IS HERE FOR LINE //
                         //////////////////////////////////
-                        p. reference = manage_reference (layers_read, polyline_layer) ;
-                        //std::cerr << "LINE we use ref " << p.reference << "\n" ;
                         p. push_back (v) ;
                         p. push_back (w) ;
                         return true ;
@@ -514,30 +543,28 @@ bool dpps::Reader_DXF_R12::read_polyline (Polyline &p) {
             v. x = 0 ;
             v. y = 0 ;
             while (!look_for_next_polyline) {
-                found = get_field_value (file, field, string_value) ;
+                found = get_field_value (scan_file, state, field, string_value) ;
                 if (!found)
                     return false ;
                 switch (field) {
                     case 8: // LAYER
-                        look_for_next_polyline = manage_layer (string_value) ;
+                        look_for_next_polyline = manage_layer (string_value, state) ;
                         polyline_layer = string_value ;
                         break ;
                     case 10: // x coordinate, first point
-                        v. x = std::stod (string_value. c_str (), nullptr) ;
+                        v. x = std::stod (string_value) ;
                         break ;
                     case 20: // y coordinate, first point
-                        v. y = std::stod (string_value. c_str (), nullptr) ;
+                        v. y = std::stod (string_value) ;
                         break ;
                     case 40: // dose is used to store the circle radius
-                        p. dose = std::stod (string_value. c_str (), nullptr) ;
+                        p. dose = std::stod (string_value) ;
                         break ;
                     case 0:
                         // We found SEQEND, Polyline is finished.
                         ////////////////////////////////////
                         // RETURN TRUE IS HERE FOR CIRCLE //
                         ////////////////////////////////////
-                        p. reference = manage_reference (layers_read, polyline_layer) ;
-                        //std::cerr << "CIRCLE we use ref " << p.reference << "\n" ;
                         p. push_back (v) ;
                         return true ;
                     default:
@@ -549,6 +576,119 @@ bool dpps::Reader_DXF_R12::read_polyline (Polyline &p) {
     // unreachable
     return false ;
 }
+namespace {
+/** @brief A read-only stream buffer over a part of a string, so that the
+ * chunks of append_to_pattern_parallel are parsed without being copied. */
+class chunk_buffer: public std::streambuf {
+public:
+    chunk_buffer (char *begin, char *end) {
+        setg (begin, begin, end) ;
+    }
+} ;
+} // namespace
+
+void dpps::Reader_DXF_R12::append_to_pattern_parallel (Pattern &pattern) {
+    if (!file. good ())
+        return ;
+    if (!reader_settings. include_blocks && !skipped_header) {
+        // See read_polyline
+        skipped_header = find_next_line (file, state, "ENTITIES") ;
+        if (!skipped_header)
+            return ;
+    }
+    std::string buffer ((std::istreambuf_iterator<char> (file)),
+                        std::istreambuf_iterator<char> ()) ;
+    long_unsigned_int size {buffer. size ()} ;
+
+    // Line of buffer from position begin to the next end of line, without
+    // surrounding spaces. end is set to the position of the end of line.
+    auto get_line = [&] (const long_unsigned_int begin,
+                         long_unsigned_int &end) {
+        end = buffer. find ('\n', begin) ;
+        if (end == std::string::npos)
+            end = size ;
+        std::string result {buffer. substr (begin, end - begin)} ;
+        sanitize_EOL (result) ;
+        return remove_spaces_right (remove_spaces_left (result)) ;
+    } ;
+    // First position at or after from where a line 0 is followed by the name
+    // of an entity we read, or size if there is none.
+    auto next_entity = [&] (const long_unsigned_int from) {
+        long_unsigned_int begin {from} ;
+        if (begin > 0) {
+            begin = buffer. find ('\n', begin - 1) ;
+            if (begin == std::string::npos)
+                return size ;
+            begin++ ;
+        }
+        while (begin < size) {
+            long_unsigned_int end, end_next ;
+            if (get_line (begin, end) == "0" && (end < size) &&
+                (vector_string_find (entity_names, get_line (end + 1, end_next))
+                    != std::numeric_limits<long_unsigned_int>::max ()))
+                return begin ;
+            begin = end + 1 ;
+        }
+        return size ;
+    } ;
+
+    long_unsigned_int number_threads {static_cast<long_unsigned_int> (
+        std::max (1, get_number_threads ()))} ;
+    std::vector<long_unsigned_int> starts {0} ;
+    for (long_unsigned_int k {1} ; k < number_threads ; k++) {
+        long_unsigned_int position {next_entity (k * size / number_threads)} ;
+        if ((position > starts. back ()) && (position < size))
+            starts. push_back (position) ;
+    }
+    starts. push_back (size) ;
+    long_unsigned_int number_chunks {starts. size () - 1} ;
+
+    std::vector<std::vector<Polyline>> chunk_polylines (number_chunks) ;
+    std::vector<std::vector<std::string>> chunk_layers (number_chunks) ;
+    std::vector<Parse_state> chunk_states (number_chunks, state) ;
+    // Exceptions cannot leave a parallel loop, they are thrown again when
+    // the chunk is merged.
+    std::vector<std::exception_ptr> chunk_errors (number_chunks) ;
+#ifdef OPENMP_FOUND
+    #pragma omp parallel for schedule(dynamic, 1)
+#endif
+    for (long_unsigned_int k = 0 ; k < number_chunks ; k++) {
+        try {
+            // A chunk also includes the line 0 which starts the next one,
+            // as POINT, LINE and CIRCLE are only finished when it is read.
+            long_unsigned_int end {size} ;
+            if (k + 1 < number_chunks)
+                end = buffer. find ('\n', starts[k+1]) + 1 ;
+            chunk_buffer chunk (&buffer[0] + starts[k], &buffer[0] + end) ;
+            std::istream scan_file (&chunk) ;
+            while (true) {
+                Polyline p ;
+                std::string polyline_layer ;
+                if (!read_entity (scan_file, chunk_states[k], p, polyline_layer))
+                    break ;
+                chunk_polylines[k]. push_back (std::move (p)) ;
+                chunk_layers[k]. push_back (std::move (polyline_layer)) ;
+            }
+        } catch (...) {
+            chunk_errors[k] = std::current_exception () ;
+        }
+    }
+
+    // References depend on the order in which layers are found, so they are
+    // set here, in the order of the file.
+    for (long_unsigned_int k {0} ; k < number_chunks ; k++) {
+        for (long_unsigned_int i {0} ; i < chunk_polylines[k]. size () ; i++) {
+            chunk_polylines[k][i]. reference =
+                manage_reference (layers_read, chunk_layers[k][i]) ;
+            pattern. polylines. push_back (std::move (chunk_polylines[k][i])) ;
+        }
+        state. layer_skipped. insert (chunk_states[k]. layer_skipped. begin (),
+                                     chunk_states[k]. layer_skipped. end ()) ;
+        if (chunk_errors[k])
+            std::rethrow_exception (chunk_errors[k]) ;
+    }
+}
+
 /** Returns the layers effectively read.
  *
  * In case of comma_separated_verbatim_list, the size and order of the layers in
@@ -563,3 +703,333 @@ std::vector<std::string> dpps::Reader_DXF_R12::get_layers_read () const {
 //         std::cout << s << " ";
     return layers_read ;
 }
+
+std::map<dpps::Reader_DXF_R12::Cache_key, std::shared_ptr<const dpps::Pattern>>
+    &dpps::Reader_DXF_R12::pattern_cache () {
+    // Built on first use, so that it exists before any reader does.
+    static std::map<Cache_key, std::shared_ptr<const Pattern>> cache ;
+    return cache ;
+}
+
+void dpps::Reader_DXF_R12::clear_cache () {
+#ifdef OPENMP_FOUND
+    #pragma omp critical (reader_DXF_R12_cache)
+#endif
+    {
+        pattern_cache (). clear () ;
+        index_cache (). clear () ;
+    }
+}
+
+void dpps::Reader_DXF_R12::append_cached_to_pattern (
+    Pattern &pattern,
+    const std::string &set_filename,
+    const bool set_reference_from_layer,
+    const bool include_blocks,
+    const enum_regex regex_grammar,
+    const std::string &layers_to_read) {
+    Cache_key key {set_filename, set_reference_from_layer, include_blocks,
+                   regex_grammar, layers_to_read} ;
+    std::shared_ptr<const Pattern> cached ;
+    // Same as Typeface::load(): no exception may leave a critical section,
+    // so the file is read outside of it.
+#ifdef OPENMP_FOUND
+    #pragma omp critical (reader_DXF_R12_cache)
+#endif
+    {
+        auto found = pattern_cache (). find (key) ;
+        if (found != pattern_cache (). end ())
+            cached = found-> second ;
+    }
+    if (!cached) {
+        std::shared_ptr<Pattern> result {std::make_shared<Pattern> ()} ;
+        Reader_DXF_R12 reader (set_filename, set_reference_from_layer,
+                               include_blocks, regex_grammar, layers_to_read) ;
+        reader. append_to_pattern (*result) ;
+        reader. close () ;
+#ifdef OPENMP_FOUND
+        #pragma omp critical (reader_DXF_R12_cache)
+#endif
+        cached = pattern_cache (). emplace (key, result). first-> second ;
+    }
+    pattern. append_from (*cached) ;
+}
+
+std::map<std::string, std::shared_ptr<const dpps::Reader_DXF_R12::Layer_index>>
+    &dpps::Reader_DXF_R12::index_cache () {
+    static std::map<std::string, std::shared_ptr<const Layer_index>> cache ;
+    return cache ;
+}
+
+bool dpps::Reader_DXF_R12::file_status (const std::string &set_filename,
+                                        long_unsigned_int &size,
+                                        long long int &mtime) {
+#ifdef MMAP_FOUND
+    struct stat status ;
+    if (stat (set_filename. c_str (), &status) != 0)
+        return false ;
+    size = status. st_size ;
+    mtime = status. st_mtime ;
+#else
+    std::ifstream input (set_filename,
+                         std::ios_base::in|std::ios_base::binary) ;
+    if (!input. is_open ())
+        return false ;
+    input. seekg (0, std::ios_base::end) ;
+    size = input. tellg () ;
+    mtime = 0 ;
+#endif
+    return true ;
+}
+
+std::shared_ptr<dpps::Reader_DXF_R12::Layer_index>
+    dpps::Reader_DXF_R12::build_layer_index () const {
+    std::ifstream input (filename, std::ios_base::in|std::ios_base::binary) ;
+    if (!input. is_open ()) {
+        std::string reason {"File " + filename +
+                            " could not be open for input"} ;
+        throw bad_io (reason. c_str ()) ;
+    }
+    std::shared_ptr<Layer_index> result {std::make_shared<Layer_index> ()} ;
+    long_unsigned_int position {0} ;
+    // Same as read_line, but also counts the bytes read.
+    auto next_line = [&] (std::string &line) {
+        if (!std::getline (input, line))
+            return false ;
+        position += line. size () ;
+        if (!input. eof ())
+            position++ ;
+        sanitize_EOL (line) ;
+        line = remove_spaces_right (remove_spaces_left (line)) ;
+        return true ;
+    } ;
+    const long_unsigned_int not_found {
+        std::numeric_limits<long_unsigned_int>::max ()} ;
+    bool found_entities {false} ;
+    // The entity being scanned. Its layer is the first one before its
+    // vertices, as in read_entity.
+    bool in_entity {false} ;
+    bool in_vertices {false} ;
+    bool set_layer {false} ;
+    long_unsigned_int begin {0} ;
+    std::string layer ;
+    std::string code ;
+    std::string value ;
+    while (true) {
+        long_unsigned_int code_position {position} ;
+        if (!next_line (code))
+            break ;
+        long_unsigned_int after_code {position} ;
+        if (!next_line (value))
+            break ;
+        char *end ;
+        long int field {strtol (code. c_str (), &end, 10)} ;
+        if (end == code. c_str ()) {
+            std::string reason {"File " + filename +
+                ": group code expected, got " + code} ;
+            throw bad_io (reason. c_str ()) ;
+        }
+        if (field == 0) {
+            if (in_entity &&
+                (vector_string_find (vertex_names, value) != not_found)) {
+                in_vertices = true ;
+                continue ;
+            }
+            if (in_entity) {
+                result-> ranges[layer]. push_back (
+                    std::make_pair (begin, after_code)) ;
+                in_entity = false ;
+            }
+            if (vector_string_find (entity_names, value) != not_found) {
+                in_entity = true ;
+                in_vertices = false ;
+                set_layer = false ;
+                layer. clear () ;
+                begin = code_position ;
+            }
+            if (value == "EOF")
+                break ;
+        } else if ((field == 8) && in_entity && !set_layer && !in_vertices) {
+            layer = value ;
+            set_layer = true ;
+        }
+        if (!found_entities && (value == "ENTITIES")) {
+            found_entities = true ;
+            result-> entities = position ;
+        }
+    }
+    if (in_entity)
+        result-> ranges[layer]. push_back (std::make_pair (begin, position)) ;
+    if (!found_entities)
+        result-> entities = position ;
+    return result ;
+}
+
+std::shared_ptr<dpps::Reader_DXF_R12::Layer_index>
+    dpps::Reader_DXF_R12::read_layer_index (
+        const long_unsigned_int size,
+        const long long int mtime) const {
+    std::ifstream input (filename + ".layers",
+                         std::ios_base::in|std::ios_base::binary) ;
+    if (!input. is_open ())
+        return nullptr ;
+    std::string line ;
+    if (!std::getline (input, line) || (line != "dpps_layer_index 1"))
+        return nullptr ;
+    std::shared_ptr<Layer_index> result {std::make_shared<Layer_index> ()} ;
+    long_unsigned_int number_layers {0} ;
+    input >> result-> size >> result-> mtime >> result-> entities
+          >> number_layers ;
+    if (!input || (result-> size != size) || (result-> mtime != mtime) ||
+        (result-> entities > size))
+        return nullptr ;
+    for (long_unsigned_int i {0} ; i < number_layers ; i++) {
+        input. ignore (std::numeric_limits<std::streamsize>::max (), '\n') ;
+        std::string name ;
+        long_unsigned_int number_ranges {0} ;
+        if (!std::getline (input, name) || !(input >> number_ranges))
+            return nullptr ;
+        std::vector<std::pair<long_unsigned_int, long_unsigned_int>> &ranges
+            = result-> ranges[name] ;
+        for (long_unsigned_int j {0} ; j < number_ranges ; j++) {
+            std::pair<long_unsigned_int, long_unsigned_int> range ;
+            if (!(input >> range. first >> range. second) ||
+                (range. first >= range. second) || (range. second > size))
+                return nullptr ;
+            ranges. push_back (range) ;
+        }
+    }
+    return result ;
+}
+
+void dpps::Reader_DXF_R12::write_layer_index (const Layer_index &index) const {
+    // Written to another name first, so that the sidecar file of another
+    // program reading the same file is never seen half written.
+    std::string sidecar {filename + ".layers"} ;
+    std::string temporary {sidecar + ".tmp"} ;
+    {
+        std::ofstream output (temporary,
+                              std::ios_base::out|std::ios_base::binary) ;
+        if (!output. is_open ())
+            return ;
+        output << "dpps_layer_index 1\n"
+               << index. size << " " << index. mtime << " "
+               << index. entities << "\n"
+               << index. ranges. size () << "\n" ;
+        for (const auto &layer: index. ranges) {
+            output << layer. first << "\n" << layer. second. size () ;
+            for (const auto &range: layer. second)
+                output << " " << range. first << " " << range. second ;
+            output << "\n" ;
+        }
+        if (!output. good ()) {
+            output. close () ;
+            std::remove (temporary. c_str ()) ;
+            return ;
+        }
+    }
+    if (std::rename (temporary. c_str (), sidecar. c_str ()) != 0)
+        std::remove (temporary. c_str ()) ;
+}
+
+std::shared_ptr<const dpps::Reader_DXF_R12::Layer_index>
+    dpps::Reader_DXF_R12::layer_index (const bool use_sidecar) {
+    long_unsigned_int size {0} ;
+    long long int mtime {0} ;
+    if (!file_status (filename, size, mtime)) {
+        std::string reason {"File " + filename +
+                            " could not be open for input"} ;
+        throw bad_io (reason. c_str ()) ;
+    }
+    std::shared_ptr<const Layer_index> cached ;
+    // As in append_cached_to_pattern, the file is scanned outside of the
+    // critical sections.
+#ifdef OPENMP_FOUND
+    #pragma omp critical (reader_DXF_R12_cache)
+#endif
+    {
+        auto found = index_cache (). find (filename) ;
+        if (found != index_cache (). end ())
+            cached = found-> second ;
+    }
+    if (cached && (cached-> size == size) && (cached-> mtime == mtime))
+        return cached ;
+    std::shared_ptr<Layer_index> result ;
+    if (use_sidecar)
+        result = read_layer_index (size, mtime) ;
+    if (!result) {
+        result = build_layer_index () ;
+        result-> size = size ;
+        result-> mtime = mtime ;
+        if (use_sidecar)
+            write_layer_index (*result) ;
+    }
+#ifdef OPENMP_FOUND
+    #pragma omp critical (reader_DXF_R12_cache)
+#endif
+    index_cache ()[filename] = result ;
+    return result ;
+}
+
+void dpps::Reader_DXF_R12::append_indexed_to_pattern (Pattern &pattern,
+                                                     const bool use_sidecar) {
+    if (is_compressed ()) {
+        append_to_pattern (pattern) ;
+        return ;
+    }
+    std::shared_ptr<const Layer_index> index {layer_index (use_sidecar)} ;
+    std::vector<std::pair<long_unsigned_int, long_unsigned_int>> ranges ;
+    for (const auto &layer: index-> ranges) {
+        // manage_layer normalizes its argument
+        std::string name {layer. first} ;
+        if (manage_layer (name, state))
+            continue ;
+        for (const auto &range: layer. second)
+            // See read_polyline for the blocks
+            if (reader_settings. include_blocks ||
+                (range. first >= index-> entities))
+                ranges. push_back (range) ;
+    }
+    // References depend on the order in which layers are found, so the
+    // entities are read in the order of the file. Consecutive entities
+    // share their last line and are read together.
+    std::sort (ranges. begin (), ranges. end ()) ;
+    std::vector<std::pair<long_unsigned_int, long_unsigned_int>> blocks ;
+    for (const auto &range: ranges) {
+        if (!blocks. empty () && (range. first < blocks. back (). second))
+            blocks. back (). second =
+                std::max (blocks. back (). second, range. second) ;
+        else
+            blocks. push_back (range) ;
+    }
+    std::ifstream input (filename, std::ios_base::in|std::ios_base::binary) ;
+    if (!input. is_open ()) {
+        std::string reason {"File " + filename +
+                            " could not be open for input"} ;
+        throw bad_io (reason. c_str ()) ;
+    }
+    std::string buffer ;
+    for (const auto &block: blocks) {
+        buffer. resize (block. second - block. first) ;
+        input. seekg (block. first) ;
+        input. read (&buffer[0], buffer. size ()) ;
+        if (!input) {
+            std::string reason {"Reader_DXF_R12: file " + filename +
+                                " could not be read"} ;
+            throw bad_io (reason. c_str ()) ;
+        }
+        chunk_buffer chunk (&buffer[0], &buffer[0] + buffer. size ()) ;
+        std::istream scan_file (&chunk) ;
+        while (true) {
+            Polyline p ;
+            std::string polyline_layer ;
+            if (!read_entity (scan_file, state, p, polyline_layer))
+                break ;
+            p. reference = manage_reference (layers_read, polyline_layer) ;
+            pattern. polylines. push_back (std::move (p)) ;
+        }
+    }
+    // The whole file was read.
+    skipped_header = true ;
+    file. seekg (0, std::ios_base::end) ;
+}
@@ -12,7 +12,12 @@
 #ifndef DPPS_READER_DXF_R12
 #define DPPS_READER_DXF_R12
 
+#include <map>
+#include <memory>
 #include <regex>
+#include <tuple>
+#include <unordered_map>
+#include <utility>
 #include "Reader.hh"
 
 namespace dpps {
@@ -90,6 +95,31 @@ protected:
     bool skipped_header {false} ;
     std::vector<std::string> layers_read ;
 
+    /** @brief the entities we read, in the order expected by read_polyline,
+     * and the markers of the vertices of a POLYLINE. Built once in the
+     * constructor rather than at each call of read_polyline. */
+    std::vector<std::string> entity_names ;
+    std::vector<std::string> vertex_names ;
+
+    /** @brief The buffers of a parse. There is one for the sequential
+     * reading by read_polyline, and one per chunk in
+     * append_to_pattern_parallel. */
+    struct Parse_state {
+        /** @brief line buffer reused by all reads, so that its memory is
+         * allocated only once. */
+        std::string line ;
+
+        /** @brief result of manage_layer for each layer name already seen,
+         * so that the regular expression is matched once per layer and not
+         * once per entity. */
+        std::unordered_map<std::string, bool> layer_skipped ;
+    } ;
+    Parse_state state ;
+
+    /** @brief reads the next line into state. line, without its end of line
+     * and surrounding spaces. Returns false if it could not be read. */
+    bool read_line (std::istream &scan_file, Parse_state &state) const ;
+
     /** @brief normalizes the string, manages the layer array and returns
      * true if we need to skip to next, or false if we keep this polyline.
      *
@@ -97,14 +127,27 @@ protected:
      * for POLYLINE, LINE and POINT. Could be done witha C macro as well but a
      * function is a bit cleaner and easier to debug.
      */
-    bool manage_layer (std::string &string_value) ;
-    bool find_next_line (std::istream &scan_file, std::string target) ;
+    bool manage_layer (std::string &string_value, Parse_state &state) const ;
+    bool find_next_line (std::istream &scan_file, Parse_state &state,
+                         const std::string &target) const ;
     long_unsigned_int find_next_line_vector (std::istream &scan_file,
-                                   std::vector <std::string> vector_target,
-                                   bool &ok) ;
+                                   Parse_state &state,
+                                   const std::vector <std::string> &vector_target,
+                                   bool &ok) const ;
     bool get_field_value (std::istream &scan_file,
+                             Parse_state &state,
                              long int &field,
-                             std::string &value) ;
+                             std::string &value) const ;
+
+    /** @brief reads the next POLYLINE, POINT, LINE or CIRCLE of an accepted
+     * layer from scan_file into p, and its layer into polyline_layer.
+     *
+     * This is read_polyline without the skipping of the header and without
+     * the reference, which depends on the layers read before. It only
+     * changes its arguments, so that several chunks of a file can be read at
+     * the same time. */
+    bool read_entity (std::istream &scan_file, Parse_state &state,
+                      Polyline &p, std::string &polyline_layer) const ;
     long_unsigned_int manage_reference (
         std::vector<std::string> &layers_read,
         std::string &polyline_layer) ;
@@ -125,6 +168,17 @@ public:
      * specific layers */
     bool read_polyline (Polyline &p) ;
 
+    /** @brief Reads all the remaining entities of the file and appends them
+     * to pattern, in the order of the file, using several threads.
+     *
+     * The remaining part of the file is loaded in memory and split into as
+     * many chunks as get_number_threads() at entity boundaries (a line 0
+     * followed by POLYLINE, POINT, LINE or CIRCLE). The chunks are parsed in
+     * parallel, then merged in order, so that the result is the same as
+     * with append_to_pattern. Without OpenMP, the chunks are parsed one after
+     * the other. */
+    void append_to_pattern_parallel (Pattern &pattern) ;
+
     Reader_DXF_R12 (
         const std::string &set_filename,
         const bool set_reference_from_layer,
@@ -139,6 +193,93 @@ public:
         const enum_regex regex_grammar,
         const std::string &layers_to_read) ;
     std::vector<std::string> get_layers_read () const ;
+
+    /** @brief Appends to pattern the polylines of the file, as a reader
+     * built with these parametres would, but reads the file only the first
+     * time.
+     *
+     * The polylines are kept in a cache which the whole program shares, so
+     * that the scripts of a batch (see run_batch()) which import the same
+     * file read it once. The file is not read again if it changes,
+     * clear_cache() forgets all the files read. */
+    static void append_cached_to_pattern (
+        Pattern &pattern,
+        const std::string &set_filename,
+        const bool set_reference_from_layer,
+        const bool include_blocks,
+        const enum_regex regex_grammar,
+        const std::string &layers_to_read) ;
+
+    /** @brief Appends to pattern the polylines of the file, as
+     * append_to_pattern would from a new reader, but reads only the part of
+     * the file taken by the entities of the layers to read.
+     *
+     * The first call for a file scans it once to find the layer and the
+     * position of each entity. This index is kept in memory and, if
+     * use_sidecar is set, in the file filename + ".layers", so that the
+     * readers of the same file with other layers to read, in this program or
+     * in the next ones, go directly to their entities. The index is built
+     * again if the size or the modification time of the file changed.
+     * Compressed files cannot be read at a position, they are read with
+     * append_to_pattern. Throws bad_io if the file cannot be read. */
+    void append_indexed_to_pattern (Pattern &pattern,
+                                    const bool use_sidecar = true) ;
+
+    /** @brief empties the cache of append_cached_to_pattern() and the layer
+     * indices of append_indexed_to_pattern() kept in memory. */
+    static void clear_cache () ;
+protected:
+    typedef std::tuple<std::string, bool, bool, enum_regex, std::string>
+        Cache_key ;
+
+    /** @brief the cache of append_cached_to_pattern(). */
+    static std::map<Cache_key, std::shared_ptr<const Pattern>> &pattern_cache () ;
+
+    /** @brief The entities of a file by layer, in bytes from the start of the
+     * file. An entity goes from its line 0 to the end of the line 0 which
+     * follows it, as POINT, LINE and CIRCLE are only finished when this line
+     * is read. The entities without layer are in layer "". */
+    struct Layer_index {
+        long_unsigned_int size {0} ;
+        long long int mtime {0} ;
+
+        /** @brief the position after the line ENTITIES, or size if there is
+         * none. The entities before it are in the blocks. */
+        long_unsigned_int entities {0} ;
+
+        std::map<std::string,
+                 std::vector<std::pair<long_unsigned_int, long_unsigned_int>>>
+            ranges ;
+    } ;
+
+    /** @brief the layer indices of append_indexed_to_pattern(), by file
+     * name. */
+    static std::map<std::string, std::shared_ptr<const Layer_index>>
+        &index_cache () ;
+
+    /** @brief sets the size and the modification time of the file, or 0 as
+     * time without POSIX stat(). Returns false if there is no such file. */
+    static bool file_status (const std::string &set_filename,
+                             long_unsigned_int &size,
+                             long long int &mtime) ;
+
+    /** @brief returns the index of the file, from the memory, from the
+     * sidecar file or by scanning the file, in that order. */
+    std::shared_ptr<const Layer_index> layer_index (const bool use_sidecar) ;
+
+    /** @brief scans the file to build its index. */
+    std::shared_ptr<Layer_index> build_layer_index () const ;
+
+    /** @brief reads the index of the file from the sidecar file, or returns
+     * nullptr if it does not exist, cannot be read or is for another
+     * version of the file. */
+    std::shared_ptr<Layer_index> read_layer_index (
+        const long_unsigned_int size,
+        const long long int mtime) const ;
+
+    /** @brief writes the index to the sidecar file. The index is only a
+     * cache, so that nothing happens if it cannot be written. */
+    void write_layer_index (const Layer_index &index) const ;
 } ;
 } // namespace dpps
 #endif
\ No newline at end of file
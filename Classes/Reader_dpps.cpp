@@ -0,0 +1,268 @@
+/**
+ * @file Reader_dpps.cpp
+ * @author Jérôme Borme <jerome.borme@inl.int>
+ * @version 1.0
+ * @brief A Reader derivative for the binary format of this program.
+ * @date 2026-10-14 Jérôme Borme: Initial version
+ * @copyright
+ * This Source Code Form is subject to the terms of the Mozilla Public
+ * License, v. 2.0. If a copy of the MPL was not distributed with this
+ * file, You can obtain one at http://mozilla.org/MPL/2.0/.
+ * */
+
+#include "configure.h"
+
+#include <cstring>
+#include <limits>
+#include <algorithm>
+
+#ifdef MMAP_FOUND
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <fcntl.h>
+#include <unistd.h>
+#endif
+
+#include "Reader_dpps.hh"
+#include "bad_parametre.hh"
+#include "bad_io.hh"
+
+dpps::Reader_dpps::Reader_dpps (const std::string &set_filename) {
+    filename = set_filename ;
+#ifdef MMAP_FOUND
+    int descriptor {::open (filename. c_str (), O_RDONLY)} ;
+    if (descriptor < 0) {
+        std::string reason {"File " + filename +
+                            " could not be open for input"} ;
+        throw bad_io (reason. c_str ()) ;
+    }
+    struct stat status ;
+    if (fstat (descriptor, &status) != 0) {
+        ::close (descriptor) ;
+        std::string reason {"Reader_dpps: size of file " + filename +
+                            " could not be read"} ;
+        throw bad_io (reason. c_str ()) ;
+    }
+    data_size = status. st_size ;
+    if (data_size > 0) {
+        void *mapping {mmap (nullptr, data_size, PROT_READ, MAP_PRIVATE,
+                             descriptor, 0)} ;
+        if (mapping != MAP_FAILED) {
+            data = static_cast<const char *> (mapping) ;
+            mapped = true ;
+        }
+    }
+    // The mapping remains valid after the descriptor is closed.
+    ::close (descriptor) ;
+#endif
+    if (!mapped) {
+        file. open (filename, std::ios_base::in|std::ios_base::binary) ;
+        if (!file. is_open ()) {
+            std::string reason {"File " + filename +
+                                " could not be open for input"} ;
+            throw bad_io (reason. c_str ()) ;
+        }
+        file. seekg (0, std::ios_base::end) ;
+        data_size = file. tellg () ;
+        file. seekg (0, std::ios_base::beg) ;
+        buffer. resize ((data_size + 7) / 8) ;
+        file. read (reinterpret_cast<char *> (buffer. data ()), data_size) ;
+        if (!file) {
+            std::string reason {"Reader_dpps: file " + filename +
+                                " could not be read"} ;
+            throw bad_io (reason. c_str ()) ;
+        }
+        file. close () ;
+        data = reinterpret_cast<const char *> (buffer. data ()) ;
+    }
+    try {
+        check_file () ;
+    } catch (...) {
+        close () ;
+        throw ;
+    }
+}
+
+dpps::Reader_dpps::~Reader_dpps () {
+    close () ;
+}
+
+void dpps::Reader_dpps::close () {
+#ifdef MMAP_FOUND
+    if (mapped)
+        munmap (const_cast<char *> (data), data_size) ;
+#endif
+    mapped = false ;
+    data = nullptr ;
+    data_size = 0 ;
+    buffer. clear () ;
+    buffer. shrink_to_fit () ;
+    header. number_polylines = 0 ;
+    header. number_vertices = 0 ;
+    Reader::close () ;
+}
+
+void dpps::Reader_dpps::check_file () {
+    std::string reason {"Reader_dpps: file " + filename} ;
+    if (data_size < sizeof (header)) {
+        reason += " is too short to be a dpps file" ;
+        throw bad_io (reason. c_str ()) ;
+    }
+    memcpy (&header, data, sizeof (header)) ;
+    if (memcmp (header. magic, Writer_dpps::magic,
+                sizeof (header. magic)) != 0) {
+        reason += " is not a dpps file" ;
+        throw bad_io (reason. c_str ()) ;
+    }
+    if (header. byte_order != Writer_dpps::byte_order_mark) {
+        reason += " was written with another byte order" ;
+        throw bad_io (reason. c_str ()) ;
+    }
+    if (header. version != Writer_dpps::version) {
+        reason += " has version " + std::to_string (header. version) +
+                  ", only version " + std::to_string (Writer_dpps::version) +
+                  " is supported" ;
+        throw bad_io (reason. c_str ()) ;
+    }
+    sections = Writer_dpps::layout (header) ;
+    if (sections. file_size != data_size) {
+        reason += " has a size different from the one in its header" ;
+        throw bad_io (reason. c_str ()) ;
+    }
+    offsets = reinterpret_cast<const uint64_t *> (data + sections. offsets) ;
+    dose = reinterpret_cast<const double *> (data + sections. dose) ;
+    reference = reinterpret_cast<const uint64_t *> (data + sections. reference) ;
+    x = reinterpret_cast<const double *> (data + sections. x) ;
+    y = reinterpret_cast<const double *> (data + sections. y) ;
+    selections = reinterpret_cast<const uint64_t *> (
+        data + sections. selections) ;
+    closed = reinterpret_cast<const uint8_t *> (data + sections. closed) ;
+    if (header. flags & Writer_dpps::flag_bounding_boxes)
+        bounding_boxes = reinterpret_cast<const double *> (
+            data + sections. bounding_boxes) ;
+    else
+        bounding_boxes = nullptr ;
+    // The vertices are read according to offsets, so they must not go
+    // beyond the x and y sections.
+    if ((offsets[0] != 0) ||
+        (offsets[header. number_polylines] != header. number_vertices)) {
+        reason += " has invalid offsets" ;
+        throw bad_io (reason. c_str ()) ;
+    }
+    for (long_unsigned_int i {0} ; i < header. number_polylines ; i++)
+        if (offsets[i+1] < offsets[i]) {
+            reason += " has invalid offsets" ;
+            throw bad_io (reason. c_str ()) ;
+        }
+}
+
+long_unsigned_int dpps::Reader_dpps::size () const {
+    return header. number_polylines ;
+}
+
+long_unsigned_int dpps::Reader_dpps::vertices_size () const {
+    return header. number_vertices ;
+}
+
+bool dpps::Reader_dpps::has_bounding_boxes () const {
+    return bounding_boxes != nullptr ;
+}
+
+void dpps::Reader_dpps::rewind () {
+    next_polyline = 0 ;
+}
+
+dpps::Polyline dpps::Reader_dpps::get_polyline (
+    const long_unsigned_int i) const {
+    if (i >= header. number_polylines) {
+        std::string reason {"Reader_dpps::get_polyline: polyline " +
+            std::to_string (i) + " requested, but file has " +
+            std::to_string (header. number_polylines) + " polylines"} ;
+        throw bad_parametre (reason. c_str ()) ;
+    }
+    Polyline result ;
+    result. vertices. reserve (offsets[i+1] - offsets[i]) ;
+    for (long_unsigned_int j {offsets[i]} ; j < offsets[i+1] ; j++)
+        result. vertices. push_back (Vertex (x[j], y[j])) ;
+    result. closed = closed[i] != 0 ;
+    result. dose = dose[i] ;
+    result. reference = reference[i] ;
+    long_unsigned_int words {(header. number_polylines + 63) / 64} ;
+    long_unsigned_int number_selections {std::min (
+        static_cast<long_unsigned_int> (header. number_selections),
+        static_cast<long_unsigned_int> (polyline_max_selection))} ;
+    for (long_unsigned_int s {0} ; s < number_selections ; s++)
+        result. selected[s] =
+            (selections[s * words + i / 64] >> (i % 64)) & 1 ;
+    return result ;
+}
+
+bool dpps::Reader_dpps::read_polyline (Polyline &p) {
+    if (next_polyline >= header. number_polylines)
+        return false ;
+    p = get_polyline (next_polyline) ;
+    next_polyline++ ;
+    return true ;
+}
+
+void dpps::Reader_dpps::append_to_pattern_packed (Pattern_packed &p) const {
+    long_unsigned_int n {header. number_polylines} ;
+    long_unsigned_int v {header. number_vertices} ;
+    long_unsigned_int first_polyline {p. dose. size ()} ;
+    long_unsigned_int first_vertex {p. x. size ()} ;
+    p. x. insert (p. x. end (), x, x + v) ;
+    p. y. insert (p. y. end (), y, y + v) ;
+    for (long_unsigned_int i {1} ; i <= n ; i++)
+        p. offsets. push_back (first_vertex + offsets[i]) ;
+    p. closed. insert (p. closed. end (), closed, closed + n) ;
+    p. dose. insert (p. dose. end (), dose, dose + n) ;
+    p. reference. insert (p. reference. end (), reference, reference + n) ;
+    long_unsigned_int words {(n + 63) / 64} ;
+    for (selection_t s {0} ; s < polyline_max_selection ; s++) {
+        std::vector<uint64_t> &w {p. selection_words[s]} ;
+        w. resize ((first_polyline + n + 63) / 64, 0) ;
+        if (static_cast<uint32_t> (s) >= header. number_selections)
+            continue ;
+        const uint64_t *source {selections + s * words} ;
+        if (first_polyline % 64 == 0)
+            std::copy (source, source + words, w. begin () + first_polyline / 64) ;
+        else
+            for (long_unsigned_int i {0} ; i < n ; i++)
+                if ((source[i / 64] >> (i % 64)) & 1)
+                    p. set_selected (first_polyline + i, s, true) ;
+    }
+}
+
+void dpps::Reader_dpps::polyline_limits (const long_unsigned_int i,
+    double &minx, double &miny, double &maxx, double &maxy) const {
+    if (bounding_boxes != nullptr) {
+        minx = bounding_boxes[4*i] ;
+        miny = bounding_boxes[4*i+1] ;
+        maxx = bounding_boxes[4*i+2] ;
+        maxy = bounding_boxes[4*i+3] ;
+        return ;
+    }
+    minx = std::numeric_limits<double>::max () ;
+    miny = std::numeric_limits<double>::max () ;
+    maxx = std::numeric_limits<double>::lowest () ;
+    maxy = std::numeric_limits<double>::lowest () ;
+    for (long_unsigned_int j {offsets[i]} ; j < offsets[i+1] ; j++) {
+        minx = std::min (minx, x[j]) ;
+        maxx = std::max (maxx, x[j]) ;
+        miny = std::min (miny, y[j]) ;
+        maxy = std::max (maxy, y[j]) ;
+    }
+}
+
+void dpps::Reader_dpps::append_window_to_pattern (Pattern &p,
+    const double xmin, const double ymin,
+    const double xmax, const double ymax) const {
+    double minx, miny, maxx, maxy ;
+    for (long_unsigned_int i {0} ; i < header. number_polylines ; i++) {
+        polyline_limits (i, minx, miny, maxx, maxy) ;
+        // For polylines without vertex, minx > maxx.
+        if ((minx >= xmin) && (maxx <= xmax) && (minx <= maxx) &&
+            (miny >= ymin) && (maxy <= ymax))
+            p. push_back (get_polyline (i)) ;
+    }
+}
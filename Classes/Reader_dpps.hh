@@ -0,0 +1,108 @@
+/**
+ * @file Reader_dpps.hh
+ * @author Jérôme Borme <jerome.borme@inl.int>
+ * @version 1.0
+ * @brief A Reader derivative for the binary format of this program.
+ * @date 2026-10-14 Jérôme Borme: Initial version
+ * @copyright
+ * This Source Code Form is subject to the terms of the Mozilla Public
+ * License, v. 2.0. If a copy of the MPL was not distributed with this
+ * file, You can obtain one at http://mozilla.org/MPL/2.0/.
+ * */
+#ifndef DPPS_READER_DPPS
+#define DPPS_READER_DPPS
+
+#include <cstdint>
+
+#include "Polyline.hh"
+#include "Pattern.hh"
+#include "Pattern_packed.hh"
+#include "Reader.hh"
+#include "Writer_dpps.hh"
+
+namespace dpps {
+/** @brief This is the derivative class that reads the files of Writer_dpps.
+ *
+ * Where the system provides it, the file is memory-mapped, otherwise it is
+ * read into memory at once. The constructor only checks the header and the
+ * offsets of the polylines: no other data is read or copied until it is used.
+ * Besides read_polyline(), the polylines can be accessed in any order
+ * directly from the file, with get_polyline() or append_window_to_pattern(),
+ * or copied at once into a Pattern_packed.
+ */
+class Reader_dpps: public Reader {
+protected:
+    /** @brief the contents of the file. */
+    const char *data {nullptr} ;
+    long_unsigned_int data_size {0} ;
+
+    /** @brief whether data is a memory mapping, or points to buffer. */
+    bool mapped {false} ;
+
+    /** @brief the contents of the file, if it could not be mapped. It is
+     * made of uint64_t so that the sections are aligned. */
+    std::vector<uint64_t> buffer ;
+
+    Writer_dpps::File_header header ;
+    Writer_dpps::File_layout sections ;
+
+    /** @brief the sections of the file, see Writer_dpps. */
+    const uint64_t *offsets {nullptr} ;
+    const double *dose {nullptr} ;
+    const uint64_t *reference {nullptr} ;
+    const double *x {nullptr} ;
+    const double *y {nullptr} ;
+    const uint64_t *selections {nullptr} ;
+    const uint8_t *closed {nullptr} ;
+    const double *bounding_boxes {nullptr} ;
+
+    /** @brief the polyline to be returned by the next read_polyline(). */
+    long_unsigned_int next_polyline {0} ;
+
+    /** @brief throws bad_io if the file is not a valid dpps file. */
+    void check_file () ;
+
+    /** @brief sets minx to maxy to the bounding box of polyline i, from the
+     * bounding box section if it exists. */
+    void polyline_limits (const long_unsigned_int i,
+                          double &minx, double &miny,
+                          double &maxx, double &maxy) const ;
+public:
+    Reader_dpps (const std::string &set_filename) ;
+    ~Reader_dpps () ;
+    void close () ;
+
+    // Implementation of inherited virtual functions.
+    bool read_polyline (Polyline &p) ;
+
+    /** @brief number of polylines in the file. */
+    long_unsigned_int size () const ;
+
+    /** @brief number of vertices in the file. */
+    long_unsigned_int vertices_size () const ;
+
+    /** @brief whether the file has the bounding box of each polyline. */
+    bool has_bounding_boxes () const ;
+
+    /** @brief returns polyline number i, including its selections. */
+    Polyline get_polyline (const long_unsigned_int i) const ;
+
+    /** @brief makes read_polyline() start again from the first polyline. */
+    void rewind () ;
+
+    /** @brief appends all the polylines of the file to p, copying each
+     * section at once. */
+    void append_to_pattern_packed (Pattern_packed &p) const ;
+
+    /** @brief appends to p the polylines lying entirely inside the window,
+     * as Pattern::select_window() with dots_as_circles = false would select
+     * them.
+     *
+     * If the file has bounding boxes, the vertices of the other polylines
+     * are not read. */
+    void append_window_to_pattern (Pattern &p,
+                                   const double xmin, const double ymin,
+                                   const double xmax, const double ymax) const ;
+} ;
+} // namespace dpps
+#endif
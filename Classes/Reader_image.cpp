@@ -13,6 +13,7 @@
  */
 
 #include <ios>
+#include <algorithm>
 
 #include "common.hh"
 #include "Reader_image.hh"
@@ -36,6 +37,54 @@ void dpps::Reader_image::set_all_parametres (
     maxy = 1.0 * image_size_height * reader_settings. size / 2.0 ;
     minx = -maxx ;
     miny = -maxy ;
+    // the colour or the mode may have changed
+    mask_built = false ;
+}
+
+void dpps::Reader_image::add_palette_colour (
+    const long_unsigned_int red,
+    const long_unsigned_int green,
+    const long_unsigned_int blue,
+    const long_unsigned_int reference,
+    const double dose) {
+    if ((red > 255) || (green > 255) || (blue > 255)) {
+        std::string reason {"Reader_image::add_palette_colour, red, green \
+and blue must be between 0 and 255, got " +
+            std::to_string (red) + ", " +
+            std::to_string (green) + " and " +
+            std::to_string (blue) + ", respectively."} ;
+        throw bad_parametre (reason. c_str ()) ;
+    }
+    std::pair<uint32_t, long_unsigned_int> key {
+        static_cast<uint32_t> ((red << 16) | (green << 8) | blue), 0} ;
+    auto position = std::lower_bound (palette_keys. begin (),
+                                      palette_keys. end (), key) ;
+    if ((position != palette_keys. end ()) &&
+        (position -> first == key. first)) {
+        std::string reason {"Reader_image::add_palette_colour, colour (" +
+            std::to_string (red) + ", " +
+            std::to_string (green) + ", " +
+            std::to_string (blue) + ") is already in the palette."} ;
+        throw bad_parametre (reason. c_str ()) ;
+    }
+    key. second = reader_settings. palette. size () ;
+    palette_keys. insert (position, key) ;
+    std::array<short unsigned int, 3> colour {{
+        static_cast<short unsigned int> (red),
+        static_cast<short unsigned int> (green),
+        static_cast<short unsigned int> (blue)}} ;
+    reader_settings. palette. push_back (colour) ;
+    reader_settings. palette_references. push_back (reference) ;
+    reader_settings. palette_doses. push_back (dose) ;
+    mask_built = false ;
+}
+
+void dpps::Reader_image::clear_palette () {
+    reader_settings. palette. clear () ;
+    reader_settings. palette_references. clear () ;
+    reader_settings. palette_doses. clear () ;
+    palette_keys. clear () ;
+    mask_built = false ;
 }
 
 void dpps::Reader_image::set_parametres (
@@ -51,9 +100,11 @@ void dpps::Reader_image::set_parametres (
             1, 4, 1, 0,
             vbool. size (), vint. size (), vdouble. size (), vstring. size ()) ;
     }
-    if (vint[0] > 2) {
+    if (vint[0] > image_reader_import_merged_rectangles) {
         std::string reason {"Reader_image::set_parametres, mode can \
-be zero to import x lines, 1 to import y lines and 2 to import as dots, " +
+be zero to import x lines, 1 to import y lines, 2 to import as dots, \
+3 to import x rectangles, 4 to import y rectangles, 5 to import as squares \
+and 6 to import merged rectangles, " +
             std::to_string (vint[0]) + " obtained."} ;
             throw bad_parametre (reason. c_str ()) ;
     }
@@ -85,50 +136,178 @@ bool dpps::Reader_image::colour_matches (
     return false ;
 }
 
+/** @brief returns the position of the first bit equal to value in words,
+ * starting at position start, or size if there is none before size. */
+static long_unsigned_int find_bit (const uint64_t *words,
+                                   const long_unsigned_int size,
+                                   const long_unsigned_int start,
+                                   const bool value) {
+    if (start >= size)
+        return size ;
+    long_unsigned_int i {start / 64} ;
+    long_unsigned_int number_words {(size + 63) / 64} ;
+    // the bits before start are ignored
+    uint64_t w {(value ? words[i] : ~words[i]) &
+                (~uint64_t {0} << (start % 64))} ;
+    while (w == 0) {
+        i++ ;
+        if (i >= number_words)
+            return size ;
+        w = value ? words[i] : ~words[i] ;
+    }
+    // When looking for a zero, the bits beyond size are found as well.
+    return std::min (i * 64 + __builtin_ctzll (w), size) ;
+}
+
+void dpps::Reader_image::match_row (const long_unsigned_int row,
+                                    uint64_t *words) {
+    for (long_unsigned_int column {0} ; column < image_size_width ; column++)
+        if (colour_matches (image_pixel (column, row)))
+            words[column / 64] |= uint64_t {1} << (column % 64) ;
+}
+
+void dpps::Reader_image::match_palette_row (
+    const long_unsigned_int row,
+    uint64_t *words,
+    const long_unsigned_int layer_words) {
+    uint32_t last_rgb {~uint32_t {0}} ;
+    long_unsigned_int last_layer {0} ;
+    for (long_unsigned_int column {0} ; column < image_size_width ; column++) {
+        std::array<short unsigned int, 3> colour {image_pixel (column, row)} ;
+        uint32_t rgb {(uint32_t {colour[0]} << 16) |
+                      (uint32_t {colour[1]} << 8) | colour[2]} ;
+        mark_palette_pixel (rgb, column, words, layer_words,
+                            last_rgb, last_layer) ;
+    }
+}
+
+void dpps::Reader_image::build_mask () {
+    words_per_row = (image_size_width + 63) / 64 ;
+    long_unsigned_int number_layers {reader_settings. palette. size ()} ;
+    current_layer = 0 ;
+    if (number_layers > 0) {
+        // Each row is read once for all the colours, and the colours are
+        // then read in turn, so that all the rows are kept.
+        long_unsigned_int layer_words {words_per_row * image_size_height} ;
+        mask. assign (number_layers * layer_words, 0) ;
+        if (sequential_rows) {
+            if (rows_matched > 0)
+                restart_rows () ;
+            for (long_unsigned_int row {0} ; row < image_size_height ; row++)
+                match_palette_row (row, mask. data () + row * words_per_row,
+                                   layer_words) ;
+            rows_matched = image_size_height ;
+        } else {
+            // The rows write distinct words.
+#ifdef OPENMP_FOUND
+            #pragma omp parallel for schedule(dynamic, 64)
+#endif
+            for (long_unsigned_int row = 0 ; row < image_size_height ; row++)
+                match_palette_row (row, mask. data () + row * words_per_row,
+                                   layer_words) ;
+        }
+    } else if (sequential_rows) {
+        if (rows_matched > 0)
+            restart_rows () ;
+        rows_matched = 0 ;
+        mask. assign (words_per_row, 0) ;
+    } else {
+        mask. assign (words_per_row * image_size_height, 0) ;
+        for (long_unsigned_int row {0} ; row < image_size_height ; row++)
+            match_row (row, mask. data () + row * words_per_row) ;
+    }
+    mask_transposed. clear () ;
+    if ((reader_settings. mode == image_reader_import_y_lines) ||
+        (reader_settings. mode == image_reader_import_y_rectangles)) {
+        words_per_column = (image_size_height + 63) / 64 ;
+        long_unsigned_int number_masks {number_layers > 0 ? number_layers : 1} ;
+        mask_transposed. assign (
+            number_masks * words_per_column * image_size_width, 0) ;
+        // Each colour of the palette is transposed by one thread.
+#ifdef OPENMP_FOUND
+        #pragma omp parallel for schedule(dynamic, 1) if (number_masks > 1)
+#endif
+        for (long_unsigned_int layer = 0 ; layer < number_masks ; layer++) {
+            uint64_t *transposed {mask_transposed. data () +
+                layer * words_per_column * image_size_width} ;
+            for (long_unsigned_int row {0} ; row < image_size_height ; row++) {
+                uint64_t bit {uint64_t {1} << (row % 64)} ;
+                // mask_row() only for the single colour, as it may read rows
+                const uint64_t *words {number_layers > 0 ?
+                    mask. data () + (layer * image_size_height + row) *
+                                    words_per_row :
+                    mask_row (row)} ;
+                for (long_unsigned_int i {0} ; i < words_per_row ; i++) {
+                    uint64_t w {words[i]} ;
+                    // visits the set bits only, clearing the lowest one each
+                    // time
+                    while (w != 0) {
+                        long_unsigned_int column {i * 64 +
+                                                  __builtin_ctzll (w)} ;
+                        transposed[column * words_per_column + row / 64] |=
+                            bit ;
+                        w &= w - 1 ;
+                    }
+                }
+            }
+        }
+    }
+    mask_built = true ;
+}
+
+void dpps::Reader_image::restart_rows () {
+}
+
+const uint64_t *dpps::Reader_image::mask_row (const long_unsigned_int row) {
+    if (!reader_settings. palette. empty ())
+        return mask. data () +
+               (current_layer * image_size_height + row) * words_per_row ;
+    if (!sequential_rows)
+        return mask. data () + row * words_per_row ;
+    if (row + 1 < rows_matched) {
+        std::string reason {"Reader_image::mask_row, row " +
+            std::to_string (row) + " requested after row " +
+            std::to_string (rows_matched - 1) + ", but rows can only be \
+read in increasing order"} ;
+        throw bad_parametre (reason. c_str ()) ;
+    }
+    while (rows_matched <= row) {
+        std::fill (mask. begin (), mask. end (), 0) ;
+        match_row (rows_matched, mask. data ()) ;
+        rows_matched++ ;
+    }
+    return mask. data () ;
+}
+
+bool dpps::Reader_image::mask_matches (const long_unsigned_int column,
+                                       const long_unsigned_int row) {
+    return (mask_row (row)[column / 64] >> (column % 64)) & 1 ;
+}
+
 bool dpps::Reader_image::get_next_block_x (
     const long_unsigned_int row,
     const long_unsigned_int column,
     long_unsigned_int &block_start_column,
-    long_unsigned_int &block_end_column) const {
+    long_unsigned_int &block_end_column) {
 
     block_start_column = column ;
     if ((block_start_column >= image_size_width) ||
         (row >= image_size_height))
         return false ;
-    if (!colour_matches (image_pixel (block_start_column, row))) {
-        // Since we use <= and then the increment, the last step in this loop
-        // will be at image_size_width+1, outside the image range. This is
-        // ok because we use the short-circuit && operator and check first
-        // if we are within acceptable range.
-        while ( (block_start_column < image_size_width) &&
-                (!colour_matches (image_pixel (block_start_column, row))) ) {
-            block_start_column++ ;
-        }
-        if (block_start_column >= image_size_width) {
-            //std::cout << "returning false" << std::endl ;
-            // reached EOL before getting a matching pixel
-            // returning with block_start_column > image_size_width
-            // so caller can determine with the numbers as well that we did
-            // not find a block in this row.
-            block_end_column = block_start_column ;
-            return false ;
-        }
-        // If we are here then we found a block in the current rown. At the
-        // moment block_start_column is right after the start, so we decrement
-        // its value to make it match the real start of the block.
-        //block_start_column-- ;
-    }
-    block_end_column = block_start_column ;
-    // Same as above: block_end_column can go beyond image_size_width, but
-    // this is ok as we check first the range and then use the && operator.
-    while ( (block_end_column < image_size_width) &&
-            (colour_matches (image_pixel (block_end_column, row))) ) {
-        block_end_column++ ;
+    const uint64_t *words {mask_row (row)} ;
+    block_start_column = find_bit (words, image_size_width, column, true) ;
+    if (block_start_column >= image_size_width) {
+        // reached EOL before getting a matching pixel
+        // returning with block_start_column == image_size_width
+        // so caller can determine with the numbers as well that we did
+        // not find a block in this row.
+        block_end_column = block_start_column ;
+        return false ;
     }
-    // Same as above:
-    // We found the end of the block, but we are at the first non-matching
-    // point, so the actual end of the block is one position before.
-    block_end_column-- ;
+    // find_bit returns the first non-matching pixel, so the actual end of
+    // the block is one position before.
+    block_end_column = find_bit (words, image_size_width,
+                                 block_start_column, false) - 1 ;
     return true ;
 }
 
@@ -142,22 +321,15 @@ bool dpps::Reader_image::get_next_block_y (
     if ((block_start_row >= image_size_height) ||
         (column >= image_size_width))
         return false ;
-    if (!colour_matches (image_pixel (column, block_start_row))) {
-        while ( (block_start_row < image_size_height) &&
-                (!colour_matches (image_pixel (column, block_start_row))) ) {
-            block_start_row++ ;
-        }
-        if (block_start_row >= image_size_height) {
-            block_end_row = block_start_row ;
-            return false ;
-        }
-    }
-    block_end_row = block_start_row ;
-    while ( (block_end_row < image_size_height) &&
-            (colour_matches (image_pixel (column, block_end_row))) ) {
-        block_end_row++ ;
+    const uint64_t *words {mask_transposed. data () +
+        (current_layer * image_size_width + column) * words_per_column} ;
+    block_start_row = find_bit (words, image_size_height, row, true) ;
+    if (block_start_row >= image_size_height) {
+        block_end_row = block_start_row ;
+        return false ;
     }
-    block_end_row-- ;
+    block_end_row = find_bit (words, image_size_height,
+                              block_start_row, false) - 1 ;
     return true ;
 }
 
@@ -304,7 +476,7 @@ bool dpps::Reader_image::acquire_dot (Polyline &p) {
             parsed = true ;
             return false ;
         }
-        success = colour_matches (image_pixel (current_col, current_row)) ;
+        success = mask_matches (current_col, current_row) ;
         current_col++ ;
     }
     p. vertices. clear () ;
@@ -329,6 +501,88 @@ bool dpps::Reader_image::acquire_dot (Polyline &p) {
     return true ;
 }
 
+void dpps::Reader_image::merge_rectangles () {
+    // A rectangle still open at the current row: columns begin to end,
+    // from first_row for now to the previous row.
+    struct Rectangle {
+        long_unsigned_int begin ;
+        long_unsigned_int end ;
+        long_unsigned_int first_row ;
+        long_unsigned_int last_row ;
+    } ;
+    std::vector<Rectangle> closed_rectangles ;
+    std::vector<Rectangle> open_rectangles ;
+    std::vector<Rectangle> next_open_rectangles ;
+    for (long_unsigned_int row {0} ; row <= image_size_height ; row++) {
+        next_open_rectangles. clear () ;
+        // Blocks are found from left to right, and open_rectangles is also
+        // sorted from left to right, so both are walked at the same time.
+        long_unsigned_int k {0} ;
+        long_unsigned_int column {0} ;
+        long_unsigned_int begin_col {0} ;
+        long_unsigned_int end_col {0} ;
+        // after the last row, no block is found and all rectangles are closed
+        while ((row < image_size_height) &&
+               get_next_block_x (row, column, begin_col, end_col)) {
+            while ((k < open_rectangles. size ()) &&
+                   (open_rectangles[k]. begin < begin_col))
+                closed_rectangles. push_back (open_rectangles[k++]) ;
+            if ((k < open_rectangles. size ()) &&
+                (open_rectangles[k]. begin == begin_col) &&
+                (open_rectangles[k]. end == end_col)) {
+                open_rectangles[k]. last_row = row ;
+                next_open_rectangles. push_back (open_rectangles[k++]) ;
+            } else
+                next_open_rectangles. push_back (
+                    Rectangle {begin_col, end_col, row, row}) ;
+            column = end_col + 1 ;
+        }
+        while (k < open_rectangles. size ())
+            closed_rectangles. push_back (open_rectangles[k++]) ;
+        open_rectangles. swap (next_open_rectangles) ;
+    }
+    std::sort (closed_rectangles. begin (), closed_rectangles. end (),
+        [] (const Rectangle &a, const Rectangle &b) {
+            return (a. first_row < b. first_row) ||
+                   ((a. first_row == b. first_row) && (a. begin < b. begin)) ;
+        }) ;
+    double s2 {reader_settings. size / 2.0} ;
+    polylines. clear () ;
+    polylines. reserve (closed_rectangles. size ()) ;
+    // the reference &r is used to avoid copy
+    for (auto &r: closed_rectangles) {
+        double
+            x1 {minx + (1.0*reader_settings. size * r. begin)},
+            x2 {minx + (1.0*reader_settings. size * r. end)},
+            y1 {maxy - (1.0*reader_settings. size * r. first_row)},
+            y2 {maxy - (1.0*reader_settings. size * r. last_row)} ;
+        Polyline p ;
+        // same orientation as image_reader_import_x_rectangles
+        p. push_back (x1-s2, y2-s2) ;
+        p. push_back (x2+s2, y2-s2) ;
+        p. push_back (x2+s2, y1+s2) ;
+        p. push_back (x1-s2, y1+s2) ;
+        p. set_closure (true) ;
+        polylines. push_back (p) ;
+    }
+    last_passed_polyline = 0 ;
+}
+
+bool dpps::Reader_image::acquire_merged_rectangle (Polyline &p) {
+    if (!parsed_x) {
+        merge_rectangles () ;
+        parsed_x = true ;
+    }
+    if (last_passed_polyline >= polylines. size ()) {
+        parsed = true ;
+        polylines. clear () ;
+        return false ;
+    }
+    p = polylines[last_passed_polyline] ;
+    last_passed_polyline++ ;
+    return true ;
+}
+
 bool dpps::Reader_image::read_polyline (Polyline &p) {
     if (parsed)
         return false ;
@@ -336,22 +590,43 @@ bool dpps::Reader_image::read_polyline (Polyline &p) {
         parsed = true ;
         return false ;
     }
+    if (!mask_built)
+        build_mask () ;
     bool value {false} ; // initialized just so that compiler does not complain
     p. vertices. clear () ;
-    switch (reader_settings. mode) {
-        case image_reader_import_x_lines:
-        case image_reader_import_x_rectangles:
-            value = acquire_polyline_x (p) ;
-            break ;
-        case image_reader_import_y_lines:
-        case image_reader_import_y_rectangles:
-            value = acquire_polyline_y (p) ;
-            break ;
-        case image_reader_import_dots:
-        case image_reader_import_squares:
-            value = acquire_dot (p) ;
-        default: // already filtered above
+    // In the palette mode, the next colour is read once one is parsed.
+    while (true) {
+        switch (reader_settings. mode) {
+            case image_reader_import_x_lines:
+            case image_reader_import_x_rectangles:
+                value = acquire_polyline_x (p) ;
+                break ;
+            case image_reader_import_y_lines:
+            case image_reader_import_y_rectangles:
+                value = acquire_polyline_y (p) ;
+                break ;
+            case image_reader_import_dots:
+            case image_reader_import_squares:
+                value = acquire_dot (p) ;
+                break ;
+            case image_reader_import_merged_rectangles:
+                value = acquire_merged_rectangle (p) ;
+                break ;
+            default: // already filtered above
+                break ;
+        }
+        if (value || (current_layer + 1 >= reader_settings. palette. size ()))
             break ;
+        current_layer++ ;
+        current_row = 0 ;
+        current_col = 0 ;
+        parsed = false ;
+        parsed_x = false ;
+        p. vertices. clear () ;
+    }
+    if (value && (!reader_settings. palette. empty ())) {
+        p. reference = reader_settings. palette_references[current_layer] ;
+        p. dose = reader_settings. palette_doses[current_layer] ;
     }
 
     // I also considered doing it by rotating the image, instead of
@@ -14,7 +14,11 @@
 #ifndef DPPS_READER_IMAGE
 #define DPPS_READER_IMAGE
 
+#include <algorithm>
 #include <array>
+#include <utility>
+#include <vector>
+#include <cstdint>
 
 #include "Reader.hh"
 
@@ -25,7 +29,8 @@ namespace dpps {
         image_reader_import_dots,
         image_reader_import_x_rectangles,
         image_reader_import_y_rectangles,
-        image_reader_import_squares
+        image_reader_import_squares,
+        image_reader_import_merged_rectangles
     } enum_image_reader_mode ;
 
 /** @brief This is the class used to read images and transform straight
@@ -35,15 +40,46 @@ namespace dpps {
  * Reader_image is abstract.
  *
  * To read x and y, use twice.
+ *
+ * With image_reader_import_merged_rectangles, the horizontal blocks that
+ * are repeated with the same columns on consecutive rows are merged into a
+ * single rectangle. A filled region made of rectangles then gives one polyline
+ * per rectangle rather than one per row.
  * To use small circles instead of polylines, read then transform the pattern
  * using replace_with
  *
- * This reader does not support assigning colours to doses. Doses are
- * double (with unit), while colours are int, so transform is not obvious.
+ * This reader does not convert colours to doses. Doses are double (with
+ * unit), while colours are int, so transform is not obvious. The palette
+ * mode below gives a dose to each colour listed instead.
  *
  * The derived constructor must open the image and set the variables
  * image_size_width and image_size_height. The image_pixel implementation image
  * must return the colour of the pixel.
+ *
+ * Before the first polyline is read, the image is converted once into a mask
+ * of one bit per pixel telling whether the pixel matches the colour, by
+ * calling match_row() for each row. The blocks are then found by scanning
+ * whole 64-bit words of the mask. For the y modes, a transposed mask is
+ * built too, so that columns are scanned along contiguous memory as well.
+ * Derived classes can override match_row() to read their rows directly,
+ * instead of calling image_pixel() for each pixel.
+ *
+ * Derived classes which decode the image row by row, without keeping it,
+ * set sequential_rows. match_row() is then called once for each row, in
+ * increasing order, only when the row is needed, and mask only holds the
+ * last row: the memory used by the x modes, the dots and the merged
+ * rectangles depends on the width of the image only. The y modes still
+ * need all the rows before the first polyline, they are read at once into
+ * the transposed mask, using one bit per pixel.
+ *
+ * To split an image coded in colours, add the colours to the palette with
+ * add_palette_colour(). The image is then read once for all of them: each
+ * pixel is looked up in the palette by match_palette_row(), which sets its bit
+ * in the mask of its colour, and the polylines of the first colour are given,
+ * then the ones of the second, and so on, with the reference and the dose
+ * of their colour. only_this_colour and colour are then ignored. The masks
+ * of all the rows are kept, one bit per pixel and per colour, also with
+ * sequential_rows.
  */
 class Reader_image: public Reader {
 public:
@@ -85,6 +121,13 @@ public:
          * Default value is (1 µm, 1 µm). Image will be centred.
          */
         double size {1.0} ;
+
+        /** @brief The colours of the palette mode, and the reference and the
+         * dose given to their polylines. Empty by default, for the single
+         * colour mode. */
+        std::vector<std::array<short unsigned int, 3>> palette ;
+        std::vector<long_unsigned_int> palette_references ;
+        std::vector<double> palette_doses ;
     };
 
 protected:
@@ -109,10 +152,104 @@ protected:
 
     double minx, maxx, miny, maxy ;
 
+    /** @brief bit c%64 of word r*words_per_row + c/64 tells whether pixel
+     * (c, r) matches the colour. Bits beyond the width are zero.
+     *
+     * With sequential_rows, it only has the words of row rows_matched-1.
+     *
+     * In the palette mode, it has the mask of each colour of the palette in
+     * turn, for all the rows. */
+    std::vector<uint64_t> mask ;
+    long_unsigned_int words_per_row {0} ;
+
+    /** @brief in the palette mode, the colour whose polylines are read. */
+    long_unsigned_int current_layer {0} ;
+
+    /** @brief the colours of the palette as 0xRRGGBB, sorted, with their
+     * position in the palette. */
+    std::vector<std::pair<uint32_t, long_unsigned_int>> palette_keys ;
+
+    /** @brief whether match_row() has to be called for each row in
+     * increasing order. Set by the derived constructor. */
+    bool sequential_rows {false} ;
+
+    /** @brief with sequential_rows, the number of rows passed to
+     * match_row() since the mask was built. */
+    long_unsigned_int rows_matched {0} ;
+
+    /** @brief bit r%64 of word c*words_per_column + r/64 tells whether pixel
+     * (c, r) matches the colour. It is only built for the y modes, for each
+     * colour of the palette in turn in the palette mode. */
+    std::vector<uint64_t> mask_transposed ;
+    long_unsigned_int words_per_column {0} ;
+
+    /** @brief whether the masks correspond to the current settings. */
+    bool mask_built {false} ;
+
+    /** @brief builds mask, and mask_transposed if the mode requires it. */
+    void build_mask () ;
+
+    /** @brief sets the bits of words for the pixels of row which match the
+     * colour. words has words_per_row elements, set to zero by the caller.
+     *
+     * This version calls image_pixel() for each pixel. */
+    virtual void match_row (const long_unsigned_int row,
+                            uint64_t *words) ;
+
+    /** @brief for each pixel of row whose colour is in the palette, sets its
+     * bit in the words of its colour. The words of colour k start at
+     * words + k * layer_words, and are set to zero by the caller.
+     *
+     * This version calls image_pixel() for each pixel. */
+    virtual void match_palette_row (const long_unsigned_int row,
+                                    uint64_t *words,
+                                    const long_unsigned_int layer_words) ;
+
+    /** @brief sets the bit of column in the words of the colour rgb
+     * (0xRRGGBB), if it is in the palette, see match_palette_row().
+     *
+     * last_rgb and last_layer keep the last colour looked up, as neighbouring
+     * pixels often have the same colour. last_rgb is initially above
+     * 0xFFFFFF. */
+    void mark_palette_pixel (const uint32_t rgb,
+                             const long_unsigned_int column,
+                             uint64_t *words,
+                             const long_unsigned_int layer_words,
+                             uint32_t &last_rgb,
+                             long_unsigned_int &last_layer) const {
+        if (rgb != last_rgb) {
+            std::pair<uint32_t, long_unsigned_int> key {rgb, 0} ;
+            auto found = std::lower_bound (palette_keys. begin (),
+                                           palette_keys. end (), key) ;
+            bool in_palette {(found != palette_keys. end ()) &&
+                             (found -> first == rgb)} ;
+            last_layer = in_palette ? found -> second : palette_keys. size () ;
+            last_rgb = rgb ;
+        }
+        if (last_layer < palette_keys. size ())
+            words[last_layer * layer_words + column / 64] |=
+                uint64_t {1} << (column % 64) ;
+    }
+
+    /** @brief with sequential_rows, called by build_mask() when rows were
+     * already matched, so that match_row() starts again from row 0.
+     *
+     * This version does nothing. */
+    virtual void restart_rows () ;
+
+    /** @brief returns the words_per_row words of mask for row. With
+     * sequential_rows, the rows up to row are matched first, and row must not
+     * be before the last row matched. */
+    const uint64_t *mask_row (const long_unsigned_int row) ;
+
+    /** @brief whether pixel (column, row) matches the colour, from mask. */
+    bool mask_matches (const long_unsigned_int column,
+                       const long_unsigned_int row) ;
+
     bool get_next_block_x (const long_unsigned_int row,
                            const long_unsigned_int column,
                            long_unsigned_int &block_start_column,
-                           long_unsigned_int &block_end_column) const ;
+                           long_unsigned_int &block_end_column) ;
 
     bool get_next_block_y (const long_unsigned_int row,
                            const long_unsigned_int column,
@@ -123,6 +260,12 @@ protected:
     bool acquire_polyline_x (Polyline &p) ;
     bool acquire_polyline_y (Polyline &p) ;
     bool acquire_dot (Polyline &p) ;
+
+    /** @brief fills polylines with the maximal rectangles of identical
+     * blocks on consecutive rows, ordered by their top row then by their
+     * first column. */
+    void merge_rectangles () ;
+    bool acquire_merged_rectangle (Polyline &p) ;
 public:
     //Reader_image (const std::string &filename) ;
 
@@ -142,6 +285,19 @@ public:
         const long_unsigned_int green,
         const long_unsigned_int blue,
         const double size) ;
+
+    /** @brief adds a colour to the palette, whose polylines get reference
+     * and dose, see the description of the class. Throws bad_parametre if
+     * a component is above 255 or if the colour is already in the palette.
+     */
+    void add_palette_colour (const long_unsigned_int red,
+                             const long_unsigned_int green,
+                             const long_unsigned_int blue,
+                             const long_unsigned_int reference,
+                             const double dose = 0.0) ;
+
+    /** @brief empties the palette, to read a single colour again. */
+    void clear_palette () ;
 } ;
 } // namespace dpps
 #endif
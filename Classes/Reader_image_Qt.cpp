@@ -16,6 +16,10 @@
 
 dpps::Reader_image_Qt::Reader_image_Qt (const std::string &filename) {
     image. load (QString (filename. c_str ())) ;
+    // pixel() returns the colours of any format as non-premultiplied ARGB,
+    // which is what Format_ARGB32 stores.
+    if ((!image. isNull ()) && (image. format () != QImage::Format_ARGB32))
+        image = image. convertToFormat (QImage::Format_ARGB32) ;
     QSize image_size = image. size () ;
     image_size_height = image_size. height () ;
     image_size_width  = image_size. width  () ;
@@ -35,13 +39,44 @@ dpps::Reader_image_Qt::Reader_image_Qt (
 std::array<short unsigned int, 3> dpps::Reader_image_Qt::image_pixel (
         const long_unsigned_int column,
         const long_unsigned_int row) const {
-    QColor colour {image. pixel (column, row)} ;
+    QRgb colour {reinterpret_cast<const QRgb *> (
+        image. constScanLine (row))[column]} ;
     std::array<short unsigned int, 3> components {{
-        static_cast<short unsigned int>(colour. red ()),
-        static_cast<short unsigned int>(colour. green ()),
-        static_cast<short unsigned int>(colour. blue ())}} ;
+        static_cast<short unsigned int>(qRed (colour)),
+        static_cast<short unsigned int>(qGreen (colour)),
+        static_cast<short unsigned int>(qBlue (colour))}} ;
     return components ;
 
 }
 
+void dpps::Reader_image_Qt::match_row (const long_unsigned_int row,
+                                       uint64_t *words) {
+    const QRgb *pixels {reinterpret_cast<const QRgb *> (
+        image. constScanLine (row))} ;
+    const std::array<short unsigned int, 3> &colour = reader_settings. colour ;
+    // The alpha channel is ignored, as it was by QColor. A component above
+    // 255 matches no pixel.
+    bool possible {(colour[0] <= 255) && (colour[1] <= 255) &&
+                   (colour[2] <= 255)} ;
+    QRgb target {qRgb (colour[0], colour[1], colour[2]) & RGB_MASK} ;
+    for (long_unsigned_int column {0} ; column < image_size_width ; column++) {
+        bool same_colour {possible && ((pixels[column] & RGB_MASK) == target)} ;
+        // same logic as Reader_image::colour_matches()
+        if (same_colour == reader_settings. only_this_colour)
+            words[column / 64] |= uint64_t {1} << (column % 64) ;
+    }
+}
 
+void dpps::Reader_image_Qt::match_palette_row (
+    const long_unsigned_int row,
+    uint64_t *words,
+    const long_unsigned_int layer_words) {
+    const QRgb *pixels {reinterpret_cast<const QRgb *> (
+        image. constScanLine (row))} ;
+    uint32_t last_rgb {~uint32_t {0}} ;
+    long_unsigned_int last_layer {0} ;
+    // The alpha channel is ignored, as in match_row().
+    for (long_unsigned_int column {0} ; column < image_size_width ; column++)
+        mark_palette_pixel (pixels[column] & RGB_MASK, column, words,
+                            layer_words, last_rgb, last_layer) ;
+}
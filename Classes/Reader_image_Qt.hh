@@ -14,17 +14,29 @@
 #define DPPS_READER_IMAGE_QT
 
 #include <QtGui/QImage>
-#include <QtGui/QColor>
 
 #include "Reader_image.hh"
 
 namespace dpps {
 /** @brief This class uses the QImage class to give access to an image. The
  * logic of he image to polyline conversion is treated in the base class.
+ *
+ * The image is converted once to QImage::Format_ARGB32 when it is loaded,
+ * so that the pixels are read as QRgb words directly in the scan lines,
+ * instead of calling QImage::pixel() and building a QColor for each one.
  */
 class Reader_image_Qt: public Reader_image {
 protected:
     QImage image ;
+
+    /** @brief see Reader_image::match_row(). The pixels are compared
+     * directly in the scan line of the image. */
+    void match_row (const long_unsigned_int row, uint64_t *words) ;
+
+    /** @brief see Reader_image::match_palette_row(). */
+    void match_palette_row (const long_unsigned_int row,
+                            uint64_t *words,
+                            const long_unsigned_int layer_words) ;
 public:
     Reader_image_Qt (const std::string &filename) ;
 
@@ -41,4 +41,35 @@ std::array<short unsigned int, 3> dpps::Reader_image_png::image_pixel (
     return components ;
 }
 
+void dpps::Reader_image_png::match_row (const long_unsigned_int row,
+                                        uint64_t *words) {
+    // the reference &pixels is used to avoid copy
+    const png::image<png::rgb_pixel>::row_type &pixels = image[row] ;
+    const std::array<short unsigned int, 3> &colour = reader_settings. colour ;
+    for (long_unsigned_int column {0} ; column < image_size_width ; column++) {
+        const png::rgb_pixel &pixel = pixels[column] ;
+        bool same_colour {(pixel. red == colour[0]) &&
+                          (pixel. green == colour[1]) &&
+                          (pixel. blue == colour[2])} ;
+        // same logic as Reader_image::colour_matches()
+        if (same_colour == reader_settings. only_this_colour)
+            words[column / 64] |= uint64_t {1} << (column % 64) ;
+    }
+}
 
+void dpps::Reader_image_png::match_palette_row (
+    const long_unsigned_int row,
+    uint64_t *words,
+    const long_unsigned_int layer_words) {
+    // the reference &pixels is used to avoid copy
+    const png::image<png::rgb_pixel>::row_type &pixels = image[row] ;
+    uint32_t last_rgb {~uint32_t {0}} ;
+    long_unsigned_int last_layer {0} ;
+    for (long_unsigned_int column {0} ; column < image_size_width ; column++) {
+        const png::rgb_pixel &pixel = pixels[column] ;
+        uint32_t rgb {(uint32_t {pixel. red} << 16) |
+                      (uint32_t {pixel. green} << 8) | pixel. blue} ;
+        mark_palette_pixel (rgb, column, words, layer_words,
+                            last_rgb, last_layer) ;
+    }
+}
@@ -25,6 +25,15 @@ namespace dpps {
 class Reader_image_png: public Reader_image {
 protected:
     png::image<png::rgb_pixel> image ;
+
+    /** @brief see Reader_image::match_row(). The pixels are compared
+     * directly in the row of the image. */
+    void match_row (const long_unsigned_int row, uint64_t *words) ;
+
+    /** @brief see Reader_image::match_palette_row(). */
+    void match_palette_row (const long_unsigned_int row,
+                            uint64_t *words,
+                            const long_unsigned_int layer_words) ;
 public:
     Reader_image_png (const std::string &filename) ;
     Reader_image_png (
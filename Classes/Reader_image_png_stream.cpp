@@ -0,0 +1,233 @@
+/**
+ * @file Reader_image_png_stream.cpp
+ * @author Jérôme Borme <jerome.borme@inl.int>
+ * @version 1.0
+ * @brief A Reader_image derivative that decodes a PNG file row by row with
+ * libpng.
+ * @date 2026-10-14 Jérôme Borme: Initial version
+ * @copyright
+ * This Source Code Form is subject to the terms of the Mozilla Public
+ * License, v. 2.0. If a copy of the MPL was not distributed with this
+ * file, You can obtain one at http://mozilla.org/MPL/2.0/.
+ */
+
+#include <csetjmp>
+
+#include "common.hh"
+#include "Reader_image_png_stream.hh"
+#include "bad_parametre.hh"
+#include "bad_io.hh"
+
+// libpng reports its errors with longjmp. The calls to libpng are made in
+// these functions, which have no object to destroy and return false after
+// an error, so that the exceptions are thrown by the caller.
+
+/** @brief reads the header from file and sets the conversion to 8-bit RGB,
+ * passes is set to the number of interlace passes. */
+static bool png_setup (png_structp png, png_infop info, FILE *file,
+                       int &passes) {
+    if (setjmp (png_jmpbuf (png)))
+        return false ;
+    png_init_io (png, file) ;
+    png_set_sig_bytes (png, 8) ;
+    png_read_info (png, info) ;
+    png_byte colour_type {png_get_color_type (png, info)} ;
+    png_byte bit_depth {png_get_bit_depth (png, info)} ;
+    // same conversions as png::image<png::rgb_pixel> in Reader_image_png
+    if (colour_type == PNG_COLOR_TYPE_PALETTE)
+        png_set_palette_to_rgb (png) ;
+    if ((colour_type & PNG_COLOR_MASK_COLOR) == 0) {
+        if (bit_depth < 8)
+            png_set_expand_gray_1_2_4_to_8 (png) ;
+        png_set_gray_to_rgb (png) ;
+    }
+    if (bit_depth == 16)
+        png_set_strip_16 (png) ;
+    if (colour_type & PNG_COLOR_MASK_ALPHA)
+        png_set_strip_alpha (png) ;
+    passes = png_set_interlace_handling (png) ;
+    png_read_update_info (png, info) ;
+    return true ;
+}
+
+/** @brief decodes the next row into row. */
+static bool png_decode_row (png_structp png, png_bytep row) {
+    if (setjmp (png_jmpbuf (png)))
+        return false ;
+    png_read_row (png, row, nullptr) ;
+    return true ;
+}
+
+/** @brief decodes the whole image, rows has a pointer for each row. */
+static bool png_decode_image (png_structp png, png_bytepp rows) {
+    if (setjmp (png_jmpbuf (png)))
+        return false ;
+    png_read_image (png, rows) ;
+    return true ;
+}
+
+dpps::Reader_image_png_stream::Reader_image_png_stream (
+    const std::string &set_filename) {
+    filename = set_filename ;
+    sequential_rows = true ;
+    open_png () ;
+}
+
+dpps::Reader_image_png_stream::Reader_image_png_stream (
+    const std::string &set_filename,
+    const bool only_this_colour,
+    const enum_image_reader_mode mode,
+    const long_unsigned_int red,
+    const long_unsigned_int green,
+    const long_unsigned_int blue,
+    const double size): Reader_image_png_stream (set_filename) {
+    set_all_parametres (only_this_colour, mode, red, green, blue, size) ;
+}
+
+dpps::Reader_image_png_stream::~Reader_image_png_stream () {
+    close () ;
+}
+
+void dpps::Reader_image_png_stream::close () {
+    close_png () ;
+    pixels. clear () ;
+    pixels. shrink_to_fit () ;
+    Reader::close () ;
+}
+
+void dpps::Reader_image_png_stream::open_png () {
+    png_file = fopen (filename. c_str (), "rb") ;
+    if (png_file == nullptr) {
+        std::string reason {"File " + filename +
+                            " could not be open for input"} ;
+        throw bad_io (reason. c_str ()) ;
+    }
+    png_byte signature[8] ;
+    if ((fread (signature, 1, 8, png_file) != 8) ||
+        (png_sig_cmp (signature, 0, 8) != 0)) {
+        close_png () ;
+        std::string reason {"Reader_image_png_stream: file " + filename +
+                            " is not a PNG file"} ;
+        throw bad_io (reason. c_str ()) ;
+    }
+    png = png_create_read_struct (PNG_LIBPNG_VER_STRING,
+                                  nullptr, nullptr, nullptr) ;
+    if (png != nullptr)
+        png_info = png_create_info_struct (png) ;
+    if (png_info == nullptr)
+        png_error_occurred ("initialise libpng for") ;
+    int passes {1} ;
+    if (!png_setup (png, png_info, png_file, passes))
+        png_error_occurred ("read the header of") ;
+    image_size_width = png_get_image_width (png, png_info) ;
+    image_size_height = png_get_image_height (png, png_info) ;
+    rows_decoded = 0 ;
+    interlaced = passes > 1 ;
+    long_unsigned_int row_size {png_get_rowbytes (png, png_info)} ;
+    if (interlaced) {
+        pixels. resize (row_size * image_size_height) ;
+        std::vector<png_bytep> rows (image_size_height) ;
+        for (long_unsigned_int row {0} ; row < image_size_height ; row++)
+            rows[row] = pixels. data () + row * row_size ;
+        if (!png_decode_image (png, rows. data ()))
+            png_error_occurred ("decode") ;
+        rows_decoded = image_size_height ;
+    } else
+        pixels. resize (row_size) ;
+}
+
+void dpps::Reader_image_png_stream::close_png () {
+    if (png != nullptr)
+        png_destroy_read_struct (&png, &png_info, nullptr) ;
+    png = nullptr ;
+    png_info = nullptr ;
+    if (png_file != nullptr)
+        fclose (png_file) ;
+    png_file = nullptr ;
+}
+
+void dpps::Reader_image_png_stream::png_error_occurred (
+    const std::string &action) {
+    close_png () ;
+    std::string reason {"Reader_image_png_stream: libpng could not " +
+                        action + " file " + filename} ;
+    throw bad_io (reason. c_str ()) ;
+}
+
+void dpps::Reader_image_png_stream::restart_rows () {
+    if (interlaced)
+        return ;
+    close_png () ;
+    open_png () ;
+}
+
+const png_byte *dpps::Reader_image_png_stream::decode_row (
+    const long_unsigned_int row) {
+    if (interlaced)
+        return pixels. data () + row * 3 * image_size_width ;
+    // Reader_image calls match_row for each row in increasing order, so
+    // row is the next row of the file.
+    if (png == nullptr) {
+        std::string reason {"Reader_image_png_stream: file " + filename +
+                            " is closed"} ;
+        throw bad_io (reason. c_str ()) ;
+    }
+    if (!png_decode_row (png, pixels. data ()))
+        png_error_occurred ("decode") ;
+    rows_decoded++ ;
+    return pixels. data () ;
+}
+
+void dpps::Reader_image_png_stream::match_row (const long_unsigned_int row,
+                                               uint64_t *words) {
+    const png_byte *pixel {decode_row (row)} ;
+    const std::array<short unsigned int, 3> &colour = reader_settings. colour ;
+    for (long_unsigned_int column {0} ; column < image_size_width ; column++) {
+        bool same_colour {(pixel[0] == colour[0]) &&
+                          (pixel[1] == colour[1]) &&
+                          (pixel[2] == colour[2])} ;
+        // same logic as Reader_image::colour_matches()
+        if (same_colour == reader_settings. only_this_colour)
+            words[column / 64] |= uint64_t {1} << (column % 64) ;
+        pixel += 3 ;
+    }
+}
+
+void dpps::Reader_image_png_stream::match_palette_row (
+    const long_unsigned_int row,
+    uint64_t *words,
+    const long_unsigned_int layer_words) {
+    const png_byte *pixel {decode_row (row)} ;
+    uint32_t last_rgb {~uint32_t {0}} ;
+    long_unsigned_int last_layer {0} ;
+    for (long_unsigned_int column {0} ; column < image_size_width ; column++) {
+        uint32_t rgb {(uint32_t {pixel[0]} << 16) |
+                      (uint32_t {pixel[1]} << 8) | pixel[2]} ;
+        mark_palette_pixel (rgb, column, words, layer_words,
+                            last_rgb, last_layer) ;
+        pixel += 3 ;
+    }
+}
+
+std::array<short unsigned int, 3> dpps::Reader_image_png_stream::image_pixel (
+        const long_unsigned_int column,
+        const long_unsigned_int row) const {
+    if ((column >= image_size_width) || (row >= image_size_height)) {
+        std::string reason {"Reader_image_png_stream::image_pixel, pixel (" +
+            std::to_string (column) + ", " + std::to_string (row) +
+            ") is outside of the image"} ;
+        throw bad_parametre (reason. c_str ()) ;
+    }
+    if ((!interlaced) && (row + 1 != rows_decoded)) {
+        std::string reason {"Reader_image_png_stream::image_pixel, row " +
+            std::to_string (row) + " requested, but only the last row \
+decoded is available"} ;
+        throw bad_parametre (reason. c_str ()) ;
+    }
+    const png_byte *pixel {pixels. data () + 3 * column} ;
+    if (interlaced)
+        pixel += row * 3 * image_size_width ;
+    std::array<short unsigned int, 3> components {{
+        pixel[0], pixel[1], pixel[2]}} ;
+    return components ;
+}
@@ -0,0 +1,96 @@
+/**
+ * @file Reader_image_png_stream.hh
+ * @author Jérôme Borme <jerome.borme@inl.int>
+ * @version 1.0
+ * @brief A Reader_image derivative that decodes a PNG file row by row with
+ * libpng.
+ * @date 2026-10-14 Jérôme Borme: Initial version
+ * @copyright
+ * This Source Code Form is subject to the terms of the Mozilla Public
+ * License, v. 2.0. If a copy of the MPL was not distributed with this
+ * file, You can obtain one at http://mozilla.org/MPL/2.0/.
+ */
+#ifndef DPPS_READER_IMAGE_PNG_STREAM
+#define DPPS_READER_IMAGE_PNG_STREAM
+
+#include <cstdio>
+#include <vector>
+#include <png.h>
+
+#include "Reader_image.hh"
+
+namespace dpps {
+/** @brief This class reads a PNG file for Reader_image without decoding the
+ * whole image in memory, for images too large for Reader_image_png.
+ *
+ * The rows are decoded one at a time with libpng, when Reader_image needs
+ * them (see Reader_image::sequential_rows), so that the memory used depends on
+ * the width of the image, not on its area. The pixels are converted to 8-bit
+ * RGB as in Reader_image_png.
+ *
+ * Interlaced images cannot be decoded row by row, they are decoded at once
+ * when the file is open.
+ *
+ * image_pixel() can only return the pixels of the last row decoded, or of any
+ * row for interlaced images.
+ */
+class Reader_image_png_stream: public Reader_image {
+protected:
+    FILE *png_file {nullptr} ;
+    png_structp png {nullptr} ;
+    png_infop png_info {nullptr} ;
+
+    /** @brief whether the whole image is in pixels. */
+    bool interlaced {false} ;
+
+    /** @brief the RGB components of the last row decoded, or of the whole
+     * image if interlaced. */
+    std::vector<png_byte> pixels ;
+
+    /** @brief the number of rows decoded since the file was open, the last
+     * one being in pixels, if not interlaced. */
+    long_unsigned_int rows_decoded {0} ;
+
+    /** @brief opens the file, reads its header and sets up the conversion
+     * to 8-bit RGB. */
+    void open_png () ;
+
+    /** @brief releases libpng and closes the file. */
+    void close_png () ;
+
+    /** @brief throws bad_io after a libpng error. */
+    void png_error_occurred (const std::string &action) ;
+
+    /** @brief see Reader_image::match_row(). */
+    void match_row (const long_unsigned_int row, uint64_t *words) ;
+
+    /** @brief see Reader_image::match_palette_row(). */
+    void match_palette_row (const long_unsigned_int row,
+                            uint64_t *words,
+                            const long_unsigned_int layer_words) ;
+
+    /** @brief returns the RGB components of row, decoding it if the image is
+     * not interlaced. */
+    const png_byte *decode_row (const long_unsigned_int row) ;
+
+    /** @brief see Reader_image::restart_rows(). The file is open again. */
+    void restart_rows () ;
+public:
+    Reader_image_png_stream (const std::string &set_filename) ;
+    Reader_image_png_stream (
+        const std::string &set_filename,
+        const bool only_this_colour,
+        const enum_image_reader_mode mode,
+        const long_unsigned_int red,
+        const long_unsigned_int green,
+        const long_unsigned_int blue,
+        const double size) ;
+    ~Reader_image_png_stream () ;
+    void close () ;
+    // Implementation of virtual methods of the base class
+    std::array<short unsigned int, 3> image_pixel (
+        const long_unsigned_int column,
+        const long_unsigned_int row) const ;
+} ;
+} // namespace dpps
+#endif
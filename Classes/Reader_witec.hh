@@ -18,23 +18,22 @@
  * Format is :
  * function(NUMBER,NUMBER);
  *
- * Spaces are allowed before and after the ufnction name, the opening bracket,
- * the comma, the closing bracket, the semicolon.
- * The parser works by looking to the next delimiter it needs.
+ * Spaces and line breaks are allowed before and after the function name, the
+ * opening bracket, the comma, the closing bracket, the semicolon.
  *
- * It looks to a function name by isolating what is before the opening bracket.
- * Therefore the opening bracket must be on the same line as the function name.
- * Parameters are isolated by looking to the next comma, or to the next
- * closing bracket. Then the next semicolon is looked for. Any additional text
- * before the semicolon will therefore be ignored. If a semicolon is forgotten
- * then the next lines are scanned until one is found. Strange results
- * can come out if the file is not valid.
+ * The whole file is read into memory by the constructor, then tokenized in
+ * place: function names are compared and numbers converted directly in the
+ * buffer, without building a string per line or per token. For the supported
+ * functions, the expected number of parametres is read, and any additional
+ * text before the closing bracket is ignored. The unsupported functions are
+ * skipped up to the next semicolon outside of a quoted string.
  *
  */
 #ifndef DPPS_READER_WITEC
 #define DPPS_READER_WITEC
 
 #include "Polyline.hh"
+#include "Pattern.hh"
 #include "Reader.hh"
 
 namespace dpps {
@@ -65,7 +64,7 @@ protected:
         "MoveAbsolute", "ma",              // 26 27 supported
         "JumpRelative", "jr",              // 28 29 supported
         "JumpAbsolute", "ja",              // 30 31 supported
-        "WaitforStablePosition", "wpos",    // 32 33
+        "WaitForStablePosition", "wpos",    // 32 33
         "SetOriginSamplePos", "so_sp",     // 34 35 supported
         "MoveRelativeSamplePos", "mr_sp",  // 36 37 supported
         "MoveAbsoluteSamplePos", "ma_sp",  // 38 39 supported
@@ -99,6 +98,45 @@ protected:
     Vertex current_stepper_pos ; //(0,0) ;
     Vertex current_piezo_pos ; //(0,0) ;
     Polyline current_polyline ;
+
+    /** @brief the indices in allowed_functions of the names of each
+     * length, so that a name is only compared to a few others. */
+    std::vector<std::vector<long_unsigned_int>> functions_by_length ;
+
+    /** @brief whether the last SetTrigger was on. */
+    bool trigger_on {false} ;
+
+    /** @brief the contents of the file, and the position and line of the
+     * next character to be parsed. */
+    std::string contents ;
+    long_unsigned_int next_char {0} ;
+    long_unsigned_int line_number {1} ;
+
+    /** @brief throws bad_io with the current line. */
+    void parse_error (const std::string &message) const ;
+
+    /** @brief skips the spaces, line breaks and comments. */
+    void skip_blanks () ;
+
+    /** @brief skips blanks and returns whether the next character is c, in
+     * which case it is skipped too. */
+    bool skip_char (const char c) ;
+
+    /** @brief skips up to the next character c outside of comments and
+     * quoted strings, included. Returns false if the end of file is reached
+     * first. */
+    bool skip_to (const char c) ;
+
+    /** @brief returns the index in allowed_functions of the function name
+     * at next_char, and skips it. */
+    long_unsigned_int read_function () ;
+
+    /** @brief reads a number at next_char. */
+    double read_number () ;
+
+    /** @brief reads the on or off argument of SetTrigger, up to the closing
+     * bracket, and returns whether it was on. */
+    bool read_on_off () ;
 public:
     Reader_witec (const std::string &set_filename) ;
     Reader_witec (const std::string &set_filename,
@@ -112,6 +150,24 @@ public:
 
     /** @brief A very simple parser */
     bool read_polyline (Polyline &p) ;
+
+    /** @brief reads the remaining polylines of the file and compares them to
+     * source, the Pattern that was given to Writer_witec, returning the
+     * differences as in Pattern_factory::compare().
+     *
+     * The polylines only in source are in selection 1 of the result, those
+     * only in the file are in selection 2. An empty result means that the
+     * file exposes exactly the polylines of source. Doses and references are
+     * not compared, as the file does not keep them, and construction lines
+     * are not part of the comparison. As Writer_witec does,
+     * closed polylines of source are compared with their first vertex
+     * repeated at their end. Polylines which Writer_witec had to split will
+     * appear as differences.
+     *
+     * precision should be larger than the rounding of the written
+     * coordinates, 0.0001 µm.
+     */
+    Pattern verify (const Pattern &source, const double precision = 0.001) ;
 } ;
 } // namespace dpps
 #endif
\ No newline at end of file
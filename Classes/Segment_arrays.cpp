@@ -0,0 +1,62 @@
+/**
+ * @file Segment_arrays.cpp
+ * @author Jérôme Borme <jerome.borme@inl.int>
+ * @version 1.0
+ * @brief Implementation of class Segment_arrays
+ * @date 2026-10-14 Jérôme Borme: Initial version
+ * @copyright
+ * This Source Code Form is subject to the terms of the Mozilla Public
+ * License, v. 2.0. If a copy of the MPL was not distributed with this
+ * file, You can obtain one at http://mozilla.org/MPL/2.0/.
+ */
+
+#include "Segment_arrays.hh"
+
+long_unsigned_int dpps::Segment_arrays::size () const {
+    return x0. size () ;
+}
+
+void dpps::Segment_arrays::clear () {
+    x0. clear () ;
+    y0. clear () ;
+    x1. clear () ;
+    y1. clear () ;
+}
+
+void dpps::Segment_arrays::reserve (const long_unsigned_int n) {
+    x0. reserve (n) ;
+    y0. reserve (n) ;
+    x1. reserve (n) ;
+    y1. reserve (n) ;
+}
+
+void dpps::Segment_arrays::push_back (const Vertex &a, const Vertex &b) {
+    x0. push_back (a. x) ;
+    y0. push_back (a. y) ;
+    x1. push_back (b. x) ;
+    y1. push_back (b. y) ;
+}
+
+void dpps::Segment_arrays::assign_edges (const Vertex_vector &vertices,
+                                         const bool closed) {
+    long_unsigned_int n {vertices. size ()} ;
+    long_unsigned_int straight {(n == 0) ? 0 : n - 1} ;
+    long_unsigned_int edges {closed ? n : straight} ;
+    x0. resize (edges) ;
+    y0. resize (edges) ;
+    x1. resize (edges) ;
+    y1. resize (edges) ;
+    const Vertex *v {vertices. data ()} ;
+    for (long_unsigned_int i {0} ; i < straight ; i++) {
+        x0[i] = v[i]. x ;
+        y0[i] = v[i]. y ;
+        x1[i] = v[i + 1]. x ;
+        y1[i] = v[i + 1]. y ;
+    }
+    if (edges > straight) {
+        x0[straight] = v[straight]. x ;
+        y0[straight] = v[straight]. y ;
+        x1[straight] = v[0]. x ;
+        y1[straight] = v[0]. y ;
+    }
+}
@@ -0,0 +1,55 @@
+/**
+ * @file Segment_arrays.hh
+ * @author Jérôme Borme <jerome.borme@inl.int>
+ * @version 1.0
+ * @brief Header file for class Segment_arrays, segments stored as a structure
+ * of arrays for the batched tests of Vertex
+ * @date 2026-10-14 Jérôme Borme: Initial version
+ * @copyright
+ * This Source Code Form is subject to the terms of the Mozilla Public
+ * License, v. 2.0. If a copy of the MPL was not distributed with this
+ * file, You can obtain one at http://mozilla.org/MPL/2.0/.
+ */
+#ifndef DPPS_SEGMENT_ARRAYS
+#define DPPS_SEGMENT_ARRAYS
+
+#include <vector>
+
+#include "common.hh"
+#include "Vertex.hh"
+#include "Vertex_vector.hh"
+
+namespace dpps {
+/** @brief Segments from (x0[i], y0[i]) to (x1[i], y1[i]), each coordinate in
+ * its own array, to be tested against one segment at a time by
+ * Vertex::intersects() and Vertex::count_segments_intersect().
+ *
+ * With the coordinates in contiguous arrays, the loops of these tests are
+ * vectorized by the compiler instead of testing the segments one pair at a
+ * time; with the cmake option MULTIVERSION, the AVX2 or SSE 4.2 version is
+ * chosen at run time.
+ */
+class Segment_arrays {
+public:
+    std::vector<double> x0 ;
+    std::vector<double> y0 ;
+    std::vector<double> x1 ;
+    std::vector<double> y1 ;
+
+    long_unsigned_int size () const ;
+
+    void clear () ;
+
+    void reserve (const long_unsigned_int n) ;
+
+    /** @brief adds the segment [ab]. */
+    void push_back (const Vertex &a, const Vertex &b) ;
+
+    /** @brief replaces the segments by the edges of a polyline, from each
+     * vertex to the next one, and from the last one to the first one if
+     * closed is set (a single vertex then gives a segment of zero length).
+     */
+    void assign_edges (const Vertex_vector &vertices, const bool closed) ;
+} ;
+} // namespace dpps
+#endif
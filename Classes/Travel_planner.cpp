@@ -0,0 +1,370 @@
+/**
+ * @file Travel_planner.cpp
+ * @author Jérôme Borme <jerome.borme@inl.int>
+ * @version 1.0
+ * @brief Class Travel_planner, which orders polylines to reduce the jumps
+ * between them
+ * @date 2026-10-14 Jérôme Borme: Initial version
+ * @copyright
+ * This Source Code Form is subject to the terms of the Mozilla Public
+ * License, v. 2.0. If a copy of the MPL was not distributed with this
+ * file, You can obtain one at http://mozilla.org/MPL/2.0/.
+ */
+
+#include <cmath>
+#include <limits>
+#include <algorithm>
+
+#include "Travel_planner.hh"
+
+// Changes of length below this are considered as rounding errors, so that
+// the improvements always terminate.
+static const double length_tolerance {1e-9} ;
+
+// The moves change the order over the positions between both ends of the
+// move, which would make the improvements quadratic on large patterns. As
+// nearly all the gain comes from short moves, longer ones are not tried.
+static const long_unsigned_int maximum_move_positions {50000} ;
+
+// Vertex::operator-() and norm2() are not inlined, and this is where most
+// of the time is spent.
+static inline double distance (const dpps::Vertex &v, const dpps::Vertex &w) {
+    double dx {v. x - w. x} ;
+    double dy {v. y - w. y} ;
+    return sqrt (dx*dx + dy*dy) ;
+}
+
+// In the grid, vertex 2k is the start and 2k+1 the end of polyline k.
+
+dpps::Travel_planner::Travel_planner (
+    const std::vector<const Polyline *> &polylines,
+    const bool allow_reversal) {
+    long_unsigned_int n {polylines. size ()} ;
+    start. reserve (n + 1) ;
+    end. reserve (n + 1) ;
+    // the reference &p is used to avoid copy
+    for (auto &p: polylines) {
+        start. push_back (p-> vertices. front ()) ;
+        // same as in Writer_witec::write_Polyline()
+        if (p-> closed && (p-> size () >= 3))
+            end. push_back (p-> vertices. front ()) ;
+        else
+            end. push_back (p-> vertices. back ()) ;
+        bool distinct {start. back () != end. back ()} ;
+        distinct_ends. push_back (distinct) ;
+        reversible. push_back (allow_reversal || !distinct) ;
+        if (!reversible. back ())
+            all_reversible = false ;
+    }
+    // the start position, set by plan()
+    start. push_back (Vertex (0, 0)) ;
+    end. push_back (Vertex (0, 0)) ;
+    distinct_ends. push_back (false) ;
+    reversible. push_back (false) ;
+}
+
+const dpps::Vertex &dpps::Travel_planner::first (
+    const long_unsigned_int k) const {
+    return reversed[k] ? end[k] : start[k] ;
+}
+
+const dpps::Vertex &dpps::Travel_planner::last (
+    const long_unsigned_int k) const {
+    return reversed[k] ? start[k] : end[k] ;
+}
+
+double dpps::Travel_planner::jump (const long_unsigned_int k,
+                                   const long_unsigned_int l) const {
+    return distance (first (l), last (k)) ;
+}
+
+double dpps::Travel_planner::jump_after (const long_unsigned_int i) const {
+    if (i + 1 >= order. size ())
+        return 0 ;
+    return jump (order[i], order[i+1]) ;
+}
+
+void dpps::Travel_planner::activate (const long_unsigned_int i) {
+    if (i < order. size ())
+        active[order[i]] = true ;
+}
+
+void dpps::Travel_planner::find_neighbours (const Vertex_grid &grid,
+    const long_unsigned_int number_neighbours) {
+    long_unsigned_int n {start. size () - 1} ;
+    neighbours. assign (n + 1, std::vector<long_unsigned_int> ()) ;
+    std::vector<long_unsigned_int> found ;
+    std::vector<std::pair<double, long_unsigned_int>> candidates ;
+    for (long_unsigned_int k {0} ; k <= n ; k++) {
+        candidates. clear () ;
+        for (int side {0} ; side < 2 ; side++) {
+            const Vertex &v = (side == 0) ? start[k] : end[k] ;
+            long_unsigned_int found_here {0} ;
+            // The rings stop at the first one giving enough candidates, so
+            // the neighbours are only approximately the nearest ones, which
+            // is enough to find the moves.
+            for (long_unsigned_int r {0} ; (r <= maximum_ring) &&
+                 (found_here < number_neighbours) ; r++) {
+                grid. ring (v, r, found) ;
+                for (long_unsigned_int e: found) {
+                    long_unsigned_int c {e / 2} ;
+                    if (c == k)
+                        continue ;
+                    const Vertex &w = (e % 2 == 0) ? start[c] : end[c] ;
+                    candidates. push_back (std::make_pair (distance (w, v), c)) ;
+                    found_here++ ;
+                }
+            }
+        }
+        std::sort (candidates. begin (), candidates. end ()) ;
+        std::vector<long_unsigned_int> &result {neighbours[k]} ;
+        for (auto c: candidates) {
+            if (result. size () >= number_neighbours)
+                break ;
+            if (std::find (result. begin (), result. end (), c. second) ==
+                result. end ())
+                result. push_back (c. second) ;
+        }
+    }
+}
+
+void dpps::Travel_planner::build_nearest_order (Vertex_grid &grid) {
+    long_unsigned_int n {start. size () - 1} ;
+    // The polylines not yet visited, to look for the nearest one directly
+    // when there are fewer of them than cells to look at.
+    std::vector<long_unsigned_int> remaining ;
+    std::vector<long_unsigned_int> remaining_position (n) ;
+    for (long_unsigned_int k {0} ; k < n ; k++) {
+        remaining. push_back (k) ;
+        remaining_position[k] = k ;
+    }
+    order. clear () ;
+    order. push_back (n) ;
+    position[n] = 0 ;
+    long_unsigned_int current {n} ;
+    double cell {grid. get_cell_size ()} ;
+    std::vector<long_unsigned_int> found ;
+    while (!remaining. empty ()) {
+        const Vertex &from = last (current) ;
+        long_unsigned_int best {std::numeric_limits<long_unsigned_int>::max ()} ;
+        double best_distance {std::numeric_limits<double>::max ()} ;
+        // Vertex e is a candidate if its polyline can start at it.
+        auto try_vertex = [&] (const long_unsigned_int e) {
+            long_unsigned_int c {e / 2} ;
+            if ((e % 2 == 1) && !(reversible[c] && distinct_ends[c]))
+                return ;
+            const Vertex &w = (e % 2 == 0) ? start[c] : end[c] ;
+            double d {distance (w, from)} ;
+            if ((d < best_distance) || ((d == best_distance) && (e < best))) {
+                best_distance = d ;
+                best = e ;
+            }
+        } ;
+        long_unsigned_int cells_seen {0} ;
+        for (long_unsigned_int r {0} ; r <= maximum_ring ; r++) {
+            // the vertices of ring r are at least (r - 1) * cell away
+            if ((r >= 1) && (best_distance <= (r - 1) * cell))
+                break ;
+            cells_seen += (r == 0) ? 1 : 8 * r ;
+            if (cells_seen > 2 * remaining. size ()) {
+                for (long_unsigned_int c: remaining) {
+                    try_vertex (2 * c) ;
+                    try_vertex (2 * c + 1) ;
+                }
+                break ;
+            }
+            grid. ring (from, r, found) ;
+            for (long_unsigned_int e: found)
+                try_vertex (e) ;
+        }
+        long_unsigned_int c {best / 2} ;
+        reversed[c] = (best % 2 == 1) ;
+        grid. erase (start[c], 2 * c) ;
+        grid. erase (end[c], 2 * c + 1) ;
+        long_unsigned_int i {remaining_position[c]} ;
+        remaining[i] = remaining. back () ;
+        remaining_position[remaining[i]] = i ;
+        remaining. pop_back () ;
+        position[c] = order. size () ;
+        order. push_back (c) ;
+        current = c ;
+    }
+}
+
+void dpps::Travel_planner::reverse_between (const long_unsigned_int i,
+                                            const long_unsigned_int j) {
+    std::reverse (order. begin () + i + 1, order. begin () + j + 1) ;
+    for (long_unsigned_int m {i + 1} ; m <= j ; m++) {
+        position[order[m]] = m ;
+        reversed[order[m]] = !reversed[order[m]] ;
+    }
+}
+
+void dpps::Travel_planner::move_after (const long_unsigned_int p,
+                                       const long_unsigned_int q) {
+    long_unsigned_int k {order[p]} ;
+    if (q > p) {
+        for (long_unsigned_int i {p} ; i < q ; i++) {
+            order[i] = order[i+1] ;
+            position[order[i]] = i ;
+        }
+        order[q] = k ;
+        position[k] = q ;
+    } else {
+        for (long_unsigned_int i {p} ; i > q + 1 ; i--) {
+            order[i] = order[i-1] ;
+            position[order[i]] = i ;
+        }
+        order[q+1] = k ;
+        position[k] = q + 1 ;
+    }
+}
+
+bool dpps::Travel_planner::improve_2opt (const long_unsigned_int i) {
+    long_unsigned_int size {order. size ()} ;
+    for (long_unsigned_int c: neighbours[order[i]]) {
+        long_unsigned_int j {position[c]} ;
+        if ((j == i) || (j + maximum_move_positions < i) ||
+            (i + maximum_move_positions < j))
+            continue ;
+        long_unsigned_int low {std::min (i, j)} ;
+        long_unsigned_int high {std::max (i, j)} ;
+        // Reversing from low+1 to high replaces the jumps after low and
+        // after high, the jumps in between keep their lengths.
+        double old_length {jump_after (low) + jump_after (high)} ;
+        double new_length {distance (last (order[high]), last (order[low]))} ;
+        if (high + 1 < size)
+            new_length += distance (first (order[high+1]),
+                                    first (order[low+1])) ;
+        if (new_length < old_length - length_tolerance) {
+            reverse_between (low, high) ;
+            activate (low) ;
+            activate (low + 1) ;
+            activate (high) ;
+            activate (high + 1) ;
+            return true ;
+        }
+    }
+    return false ;
+}
+
+bool dpps::Travel_planner::improve_or_opt (const long_unsigned_int p) {
+    long_unsigned_int size {order. size ()} ;
+    long_unsigned_int k {order[p]} ;
+    long_unsigned_int previous {order[p-1]} ;
+    double gain {jump (previous, k) + jump_after (p)} ;
+    if (p + 1 < size)
+        gain -= jump (previous, order[p+1]) ;
+    for (long_unsigned_int c: neighbours[k]) {
+        // inserted after c, or before c
+        for (int before {0} ; before < 2 ; before++) {
+            long_unsigned_int q {position[c] - before} ;
+            if ((q == p) || (q + 1 == p) || (q + maximum_move_positions < p) ||
+                (p + maximum_move_positions < q))
+                continue ;
+            for (int flip {0} ; flip < 2 ; flip++) {
+                if ((flip == 1) && !(reversible[k] && distinct_ends[k]))
+                    break ;
+                bool r {reversed[k] != (flip == 1)} ;
+                const Vertex &f = r ? end[k] : start[k] ;
+                const Vertex &l = r ? start[k] : end[k] ;
+                double cost {distance (f, last (order[q]))} ;
+                if (q + 1 < size)
+                    cost += distance (first (order[q+1]), l) - jump_after (q) ;
+                if (cost < gain - length_tolerance) {
+                    activate (p - 1) ;
+                    activate (p + 1) ;
+                    reversed[k] = r ;
+                    move_after (p, q) ;
+                    activate (position[k] - 1) ;
+                    activate (position[k]) ;
+                    activate (position[k] + 1) ;
+                    return true ;
+                }
+            }
+        }
+    }
+    return false ;
+}
+
+std::vector<dpps::Travel_planner::Step> dpps::Travel_planner::plan (
+    const Vertex &start_position,
+    const long_unsigned_int improvement_passes) {
+    long_unsigned_int n {start. size () - 1} ;
+    start[n] = start_position ;
+    end[n] = start_position ;
+    reversed. assign (n + 1, false) ;
+    position. assign (n + 1, 0) ;
+    std::vector<Step> result ;
+    if (n == 0)
+        return result ;
+
+    // Cells are chosen so that there is about one polyline per cell.
+    double minx {start_position. x}, maxx {start_position. x} ;
+    double miny {start_position. y}, maxy {start_position. y} ;
+    for (long_unsigned_int k {0} ; k < n ; k++)
+        for (const Vertex *v: {&start[k], &end[k]}) {
+            minx = std::min (minx, v-> x) ;
+            maxx = std::max (maxx, v-> x) ;
+            miny = std::min (miny, v-> y) ;
+            maxy = std::max (maxy, v-> y) ;
+        }
+    double width {std::max (maxx - minx, maxy - miny)} ;
+    double cell {std::max (sqrt ((maxx - minx) * (maxy - miny) / n),
+                           width / n)} ;
+    if (cell <= 0)
+        cell = 1.0 ;
+    double maximum_coordinate {std::max (std::max (fabs (minx), fabs (maxx)),
+                                         std::max (fabs (miny), fabs (maxy)))} ;
+    Vertex_grid grid (cell, maximum_coordinate) ;
+    for (long_unsigned_int k {0} ; k < n ; k++) {
+        grid. insert (start[k], 2 * k) ;
+        grid. insert (end[k], 2 * k + 1) ;
+    }
+    maximum_ring = static_cast<long_unsigned_int> (
+        ceil (width / grid. get_cell_size ())) + 1 ;
+
+    find_neighbours (grid, 8) ;
+    build_nearest_order (grid) ;
+
+    // Each pass only tries the elements which were moved, or next to a
+    // move, since they were last tried.
+    active. assign (n + 1, true) ;
+    for (long_unsigned_int pass {0} ; pass < improvement_passes ; pass++) {
+        bool improved {false} ;
+        for (long_unsigned_int i {0} ; i <= n ; i++) {
+            long_unsigned_int k {order[i]} ;
+            if (!active[k])
+                continue ;
+            active[k] = false ;
+            if (all_reversible && (i < n))
+                while (improve_2opt (i))
+                    improved = true ;
+            if ((i >= 1) && improve_or_opt (i))
+                improved = true ;
+        }
+        if (!improved)
+            break ;
+    }
+
+    result. reserve (n) ;
+    for (long_unsigned_int i {1} ; i <= n ; i++) {
+        long_unsigned_int k {order[i]} ;
+        // the direction of polylines with equal ends does not matter
+        result. push_back (Step {k, reversed[k] && distinct_ends[k]}) ;
+    }
+    return result ;
+}
+
+double dpps::Travel_planner::jump_length (const std::vector<Step> &steps,
+    const Vertex &start_position) const {
+    double result {0} ;
+    Vertex from {start_position} ;
+    // the reference &s is used to avoid copy
+    for (auto &s: steps) {
+        result += distance (s. reversed ? end[s. index] : start[s. index],
+                            from) ;
+        from = s. reversed ? start[s. index] : end[s. index] ;
+    }
+    return result ;
+}
@@ -0,0 +1,139 @@
+/**
+ * @file Travel_planner.hh
+ * @author Jérôme Borme <jerome.borme@inl.int>
+ * @version 1.0
+ * @brief Header file for class Travel_planner, which orders polylines to
+ * reduce the jumps between them
+ * @date 2026-10-14 Jérôme Borme: Initial version
+ * @copyright
+ * This Source Code Form is subject to the terms of the Mozilla Public
+ * License, v. 2.0. If a copy of the MPL was not distributed with this
+ * file, You can obtain one at http://mozilla.org/MPL/2.0/.
+ */
+#ifndef DPPS_TRAVEL_PLANNER
+#define DPPS_TRAVEL_PLANNER
+
+#include <vector>
+
+#include "common.hh"
+#include "Vertex.hh"
+#include "Polyline.hh"
+#include "Vertex_grid.hh"
+
+namespace dpps {
+/** @brief Finds an order of polylines which reduces the total length of the
+ * jumps from the end of each polyline to the start of the next one.
+ *
+ * This is a travelling salesman problem on the polylines, with a free end.
+ * A first order is built by going each time to the nearest polyline not yet
+ * visited, then it is improved by 2-opt moves (reversing a part of the
+ * order) and Or-opt moves (moving one polyline elsewhere in the order),
+ * each polyline being only tried against its nearest neighbours, and only
+ * again after a move near it. The result is usually within a few percent of
+ * the optimum, in a time close to linear with the number of polylines.
+ *
+ * A closed polyline of at least 3 vertices is taken to end at its first
+ * vertex, as written by Writer_witec, and so are single dots. If reversal is
+ * allowed, the other polylines may be visited from their last vertex to
+ * their first one. Without reversal, 2-opt is only used when no polyline
+ * has distinct ends, as it reverses the direction of the polylines it moves.
+ *
+ * As the jump durations are estimated proportionally to their lengths (see
+ * Writer_witec::update_duration_jump_to()), reducing the length also reduces
+ * the estimated duration.
+ */
+class Travel_planner {
+public:
+    /** @brief a polyline in the planned order, with its direction. */
+    struct Step {
+        long_unsigned_int index ;
+        bool reversed ;
+    } ;
+protected:
+    /** @brief the first and last positions of each polyline, plus the start
+     * position as the last element, which stays first in the order. */
+    std::vector<Vertex> start ;
+    std::vector<Vertex> end ;
+
+    /** @brief whether the first and last positions of each polyline are
+     * different, and whether it may be reversed. */
+    std::vector<bool> distinct_ends ;
+    std::vector<bool> reversible ;
+
+    /** @brief whether all polylines can be reversed, or have equal ends. */
+    bool all_reversible {true} ;
+
+    /** @brief the order, starting with the start position, the position
+     * of each element in it, and whether each element is reversed. */
+    std::vector<long_unsigned_int> order ;
+    std::vector<long_unsigned_int> position ;
+    std::vector<bool> reversed ;
+
+    /** @brief the nearest other polylines of each polyline. */
+    std::vector<std::vector<long_unsigned_int>> neighbours ;
+
+    /** @brief whether moves are still to be tried from each element. */
+    std::vector<bool> active ;
+
+    /** @brief the largest distance, in cells of the grid, between two
+     * positions. */
+    long_unsigned_int maximum_ring {0} ;
+
+    /** @brief first and last positions of element k, in its direction. */
+    const Vertex &first (const long_unsigned_int k) const ;
+    const Vertex &last (const long_unsigned_int k) const ;
+
+    /** @brief length of the jump from element k to element l. */
+    double jump (const long_unsigned_int k, const long_unsigned_int l) const ;
+
+    /** @brief length of the jump after position i in the order, zero for the
+     * last position. */
+    double jump_after (const long_unsigned_int i) const ;
+
+    /** @brief marks the element at position i, if any, to be tried again. */
+    void activate (const long_unsigned_int i) ;
+
+    /** @brief builds the nearest neighbour order. */
+    void build_nearest_order (Vertex_grid &grid) ;
+
+    /** @brief fills neighbours with the number_neighbours nearest. */
+    void find_neighbours (const Vertex_grid &grid,
+                          const long_unsigned_int number_neighbours) ;
+
+    /** @brief reverses the order between positions i+1 and j included, and
+     * the direction of these elements. */
+    void reverse_between (const long_unsigned_int i,
+                          const long_unsigned_int j) ;
+
+    /** @brief moves the element at position p after the element at
+     * position q. */
+    void move_after (const long_unsigned_int p, const long_unsigned_int q) ;
+
+    /** @brief tries the 2-opt moves of the jump after position i, and
+     * applies the first one which reduces the length. */
+    bool improve_2opt (const long_unsigned_int i) ;
+
+    /** @brief tries moving the element at position p after one of its
+     * neighbours, and applies the first one which reduces the length. */
+    bool improve_or_opt (const long_unsigned_int p) ;
+public:
+    /** @brief Constructor. Only the ends of the polylines are kept, in
+     * the order of polylines, which gives the indices of the Steps. Empty
+     * polylines must not be passed. */
+    Travel_planner (const std::vector<const Polyline *> &polylines,
+                    const bool allow_reversal) ;
+
+    /** @brief returns the planned order starting from start_position.
+     *
+     * improvement_passes is the maximum number of passes of 2-opt and Or-opt
+     * moves over all polylines. Zero only gives the nearest neighbour
+     * order. */
+    std::vector<Step> plan (const Vertex &start_position,
+                            const long_unsigned_int improvement_passes = 10) ;
+
+    /** @brief total length of the jumps of order from start_position. */
+    double jump_length (const std::vector<Step> &steps,
+                        const Vertex &start_position) const ;
+} ;
+} // namespace dpps
+#endif
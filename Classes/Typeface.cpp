@@ -70,6 +70,7 @@
  */
 
 #include <limits>
+#include <algorithm>
 
 #include <iostream> // debug only
 #include "Typeface.hh"
@@ -126,6 +127,21 @@ bool dpps::Typeface::get_loaded () const {
     return loaded ;
 }
 
+std::map<dpps::Typeface::Glyphs_key,
+         std::shared_ptr<const dpps::Typeface::Glyphs>>
+    &dpps::Typeface::glyphs_cache () {
+    // Built on first use, so that it exists before any Typeface does.
+    static std::map<Glyphs_key, std::shared_ptr<const Glyphs>> cache ;
+    return cache ;
+}
+
+void dpps::Typeface::clear_cache () {
+#ifdef OPENMP_FOUND
+    #pragma omp critical (typeface_cache)
+#endif
+    glyphs_cache (). clear () ;
+}
+
 dpps::character dpps::Typeface::get_character (const unsigned char c) const {
     short unsigned int d {static_cast<short unsigned int> (c)} ;
     //std::cout << "get_character ; c= : " << c << ", d=" << d << "\n" ;
@@ -135,7 +151,10 @@ out of range allowed by the font: range is 0-" + std::to_string ((long_unsigned_
          "provided value was " + std::to_string ((long_unsigned_int)d) + "."} ;
         throw bad_parametre (reason. c_str ()) ;
     }
-    return font [static_cast<short unsigned int> (c)] ;
+    if (!glyphs)
+        throw bad_parametre ("Typeface::get_character, the typeface was not \
+loaded.") ;
+    return glyphs-> font [static_cast<short unsigned int> (c)] ;
 }
 
 bool dpps::Typeface::get_next_line_vector (std::istream &scan_file,
@@ -309,15 +328,54 @@ uses cut mode 1 for a first polyline, which is not allowed."} ;
 // }
 
 void dpps::Typeface::load () {
-    bool use_composition {false} ;
     if (loaded)
         return ;
+    Glyphs_key key {font_name, variant, stroke} ;
+    glyphs. reset () ;
+    // No exception may leave a critical section, so the files are read
+    // outside of it. If two threads load the same typeface, the first one to
+    // finish sets the cache.
+#ifdef OPENMP_FOUND
+    #pragma omp critical (typeface_cache)
+#endif
+    {
+        auto found = glyphs_cache (). find (key) ;
+        if (found != glyphs_cache (). end ())
+            glyphs = found-> second ;
+    }
+    if (!glyphs) {
+        std::shared_ptr<const Glyphs> result {read_glyphs ()} ;
+#ifdef OPENMP_FOUND
+        #pragma omp critical (typeface_cache)
+#endif
+        glyphs = glyphs_cache (). emplace (key, result). first-> second ;
+    }
+    ex = glyphs-> ex ;
+    em = glyphs-> em ;
+    en = glyphs-> en ;
     loaded = true ;
+}
+
+std::string dpps::Typeface::font_file (const std::string &font_value) {
 #ifdef FILENAMES_FOR_WINDOWS
-    std::string font_name_complete {".\\font_data\\" + font_name + ".dxf"} ;
+    return ".\\font_data\\" + font_value + ".dxf" ;
 #else
-    std::string font_name_complete {"./font_data/" + font_name + ".dxf"} ;
+    return "./font_data/" + font_value + ".dxf" ;
 #endif
+}
+
+std::string dpps::Typeface::composition_file (const std::string &font_value) {
+#ifdef FILENAMES_FOR_WINDOWS
+    return ".\\font_data\\" + font_value + "-composition.txt" ;
+#else
+    return "./font_data/" + font_value + "-composition.txt" ;
+#endif
+}
+
+std::shared_ptr<const dpps::Typeface::Glyphs> dpps::Typeface::read_glyphs () {
+    bool use_composition {false} ;
+    std::shared_ptr<Glyphs> result {std::make_shared<Glyphs> ()} ;
+    std::string font_name_complete {font_file (font_name)} ;
     Reader_DXF_R12 reader (font_name_complete, false, false, verbatim, "1") ;
     Pattern raw_alphabet ;
     reader. append_to_pattern (raw_alphabet) ;
@@ -325,11 +383,7 @@ void dpps::Typeface::load () {
     reader. close () ;
 
     std::ifstream composition ;
-#ifdef FILENAMES_FOR_WINDOWS
-    std::string composition_name_complete {".\\font_data\\" + font_name + "-composition.txt"} ;
-#else
-    std::string composition_name_complete {"./font_data/" + font_name + "-composition.txt"} ;
-#endif
+    std::string composition_name_complete {composition_file (font_name)} ;
     composition. open (composition_name_complete, std::ios_base::in) ;
     if (composition. is_open ()) {
         use_composition = true ;
@@ -378,16 +432,22 @@ void dpps::Typeface::load () {
                 c = create_character_composition (vararg, raw_alphabet, current) ; // updates current
             else
                 c = create_character (raw_alphabet, current) ; // does current++
-            font[k] = c. polylines ;
+            result-> font[k] = c. polylines ;
+            // Pattern_text aligns the characters on the left of their
+            // polylines.
+            double left {std::numeric_limits<double>::max ()} ;
+            // the reference &p is used to avoid copy
+            for (auto &p: c. polylines)
+                left = std::min (left, p. minimum_x ()) ;
+            result-> left[k] = left ;
             // We reset the x shift to zero.
             // We do not do approach or kerning, for simplicity.
             Vertex bl {c. lower_left()} ;
             c. translate (-bl.x, 0.0) ;
             Vertex tr {c. upper_right()} ;
-            top[k] = tr. y ;
-            bottom[k] = bl. y ;
-            //left[k] = 0.0 ;
-            right[k] = tr. x ;
+            result-> top[k] = tr. y ;
+            result-> bottom[k] = bl. y ;
+            result-> right[k] = tr. x ;
             /*if (k >= 28)
                 break ;*/
         }
@@ -395,12 +455,9 @@ void dpps::Typeface::load () {
             break ;*/
     }
     composition. close () ;
-    ex = top    [static_cast<short unsigned int> ('x')] -
-         bottom [static_cast<short unsigned int> ('x')] ;
-    em = right  [static_cast<short unsigned int> ('m')] ;
-         //left   [static_cast<short unsigned int> ('m')] ;
-    en = right  [static_cast<short unsigned int> ('n')] ;
-         //left   [static_cast<short unsigned int> ('n')] ;
-    // std::cout << " tailles ex " << ex << " em " << em << " en " << en << std::endl ; ####
-    // std::cout << "We succeeded the load" ;
+    result-> ex = result-> top    [static_cast<short unsigned int> ('x')] -
+                  result-> bottom [static_cast<short unsigned int> ('x')] ;
+    result-> em = result-> right  [static_cast<short unsigned int> ('m')] ;
+    result-> en = result-> right  [static_cast<short unsigned int> ('n')] ;
+    return result ;
 }
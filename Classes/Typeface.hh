@@ -15,6 +15,9 @@
 
 #include <Reader_DXF_R12.hh>
 #include <array>
+#include <map>
+#include <memory>
+#include <tuple>
 
 // #include "fonts_declarations.hh"
 #include "Polyline.hh"
@@ -35,10 +38,34 @@ namespace dpps {
  * Its purpose is to load a special DXF file which contains the description
  * of the characters as polylines.
  * The codepoints correspond to ISO-8859-1 (latin-1).
+ *
+ * The characters are built once per font, variant and stroke type for the
+ * whole program: they are kept in a cache which all the instances share, so
+ * that loading a typeface again, or copying it, does not read the files
+ * again. clear_cache() forgets them, for instance if the files changed.
  */
 class Typeface {
     friend class Pattern_text ;
+public:
+    /** @brief the characters of a typeface, and their sizes. */
+    struct Glyphs {
+        alphabet_iso8859_1_polyline font ;
+        std::array<double, maxchars> top {{}} ;   // make really sure they are initialized at zero
+        std::array<double, maxchars> bottom {{}} ;
+        std::array<double, maxchars> right {{}} ;
+        /** @brief the minimum x of the polylines of each character, as
+         * stored in font. */
+        std::array<double, maxchars> left {{}} ;
+        double ex {1.0} ;
+        double em {1.0} ;
+        double en {1.0} ;
+    } ;
 protected:
+    typedef std::tuple<std::string, short unsigned int, stroke_type> Glyphs_key ;
+
+    /** @brief the cache of the characters of all the typefaces loaded. */
+    static std::map<Glyphs_key, std::shared_ptr<const Glyphs>> &glyphs_cache () ;
+
     std::string font_name ;
     short unsigned int variant {0} ;
     bool loaded {false} ;
@@ -49,11 +76,11 @@ protected:
     Pattern create_character_composition (std::vector<short signed int> &vararg, Pattern &original, long_unsigned_int &current) ;
     Pattern create_character (Pattern &original, long_unsigned_int &current) ;
 
+    /** @brief reads the files of the font and builds its characters. */
+    std::shared_ptr<const Glyphs> read_glyphs () ;
+
     // The protected things below are accessed from Pattern_text
-    alphabet_iso8859_1_polyline font ;
-    std::array<double, maxchars> top {{}} ;   // make really sure they are initialized at zero
-    std::array<double, maxchars> bottom {{}} ;
-    std::array<double, maxchars> right {{}} ;
+    std::shared_ptr<const Glyphs> glyphs ;
 public:
     static const constexpr short unsigned int characters_in_a_typeface {188} ;
 
@@ -69,8 +96,22 @@ public:
     short unsigned int get_variant () const ;
     stroke_type get_stroke_type () const ;
 
+    /** @brief gets the characters from the cache, or builds them if this
+     * typeface was not loaded before. */
     void load () ;
 
+    /** @brief empties the cache of characters, the typefaces already loaded
+     * keep theirs. */
+    static void clear_cache () ;
+
+    /** @brief the file holding the strokes of the characters of font_value,
+     * relative to the working directory. */
+    static std::string font_file (const std::string &font_value) ;
+
+    /** @brief the optional file describing how the characters of font_value
+     * are composed from these strokes. */
+    static std::string composition_file (const std::string &font_value) ;
+
     double ex {1.0} ;
     double em {1.0} ;
     double en {1.0} ;
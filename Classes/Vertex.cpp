@@ -10,13 +10,16 @@
  * file, You can obtain one at http://mozilla.org/MPL/2.0/.
  */
 
+#include <algorithm>
 #include <iostream>
 #include <cmath>
 #include <errno.h>
 #include <limits>
 
 #include "Polyline.hh"
+#include "Segment_arrays.hh"
 #include "Vertex.hh"
+#include "Vertex_vector.hh"
 #include "util.hh"
 #include "Matrix2x2.hh"
 #include "bad_math.hh"
@@ -334,3 +337,126 @@ double
   }
 return 0;
 }
+
+// The sign of a criterion of turn(), without branches so that the loops
+// calling it can be vectorized.
+static inline int turn_sign (const double criterion) {
+    return (criterion > std::numeric_limits<double>::epsilon ()) -
+           (criterion < -std::numeric_limits<double>::epsilon ()) ;
+}
+
+DPPS_MULTIVERSION
+void dpps::Vertex::intersects (const Vertex &u, const Vertex &v,
+                               const Segment_arrays &segments,
+                               std::vector<unsigned char> &result) {
+    long_unsigned_int n {segments. size ()} ;
+    result. resize (n) ;
+    const double *wx {segments. x0. data ()} ;
+    const double *wy {segments. y0. data ()} ;
+    const double *zx {segments. x1. data ()} ;
+    const double *zy {segments. y1. data ()} ;
+    unsigned char *r {result. data ()} ;
+    double ux {u. x}, uy {u. y}, vx {v. x}, vy {v. y} ;
+    // Same expressions as intersects(), with w and z the ends of segment i.
+#ifdef OPENMP_FOUND
+    #pragma omp simd
+#endif
+    for (long_unsigned_int i = 0 ; i < n ; i++) {
+        int uvw {turn_sign ((vx - ux) * (wy[i] - uy) - (wx[i] - ux) * (vy - uy))} ;
+        int uvz {turn_sign ((vx - ux) * (zy[i] - uy) - (zx[i] - ux) * (vy - uy))} ;
+        int uzw {turn_sign ((zx[i] - wx[i]) * (uy - wy[i]) -
+                            (ux - wx[i]) * (zy[i] - wy[i]))} ;
+        int wzv {turn_sign ((zx[i] - wx[i]) * (vy - wy[i]) -
+                            (vx - wx[i]) * (zy[i] - wy[i]))} ;
+        r[i] = (uvw * uvz <= 0) & (uzw * wzv <= 0) ;
+    }
+}
+
+namespace {
+// The ends of the segments of count_segments_intersect(), read from the
+// arrays of a Segment_arrays, or from consecutive vertices.
+struct Array_ends {
+    const double *ax, *ay, *bx, *by ;
+    double a_x (const long_unsigned_int i) const { return ax[i] ; }
+    double a_y (const long_unsigned_int i) const { return ay[i] ; }
+    double b_x (const long_unsigned_int i) const { return bx[i] ; }
+    double b_y (const long_unsigned_int i) const { return by[i] ; }
+} ;
+
+struct Vertex_ends {
+    const dpps::Vertex *v ;
+    double a_x (const long_unsigned_int i) const { return v[i]. x ; }
+    double a_y (const long_unsigned_int i) const { return v[i]. y ; }
+    double b_x (const long_unsigned_int i) const { return v[i+1]. x ; }
+    double b_y (const long_unsigned_int i) const { return v[i+1]. y ; }
+} ;
+
+// The segments are taken in blocks. The secant ones are counted in a
+// vectorized loop, with the same expressions as segments_intersect(), and
+// the parallel ones, rare but for which the result depends on more tests,
+// are then passed to segments_intersect() itself.
+template <typename Ends>
+DPPS_INLINE_MULTIVERSION long_unsigned_int count_ends_intersect (
+    const Ends e, const long_unsigned_int n,
+    const dpps::Vertex &C, const dpps::Vertex &D) {
+    const double epsilon {std::numeric_limits<double>::epsilon ()} ;
+    double cx {C. x}, cy {C. y}, dx {D. x}, dy {D. y} ;
+    long_unsigned_int count {0} ;
+    const long_unsigned_int block_size {256} ;
+    long_unsigned_int parallel[block_size] ;
+    for (long_unsigned_int first {0} ; first < n ; first += block_size) {
+        long_unsigned_int last {first + std::min (block_size, n - first)} ;
+        long_unsigned_int found {0} ;
+        long_unsigned_int any_parallel {0} ;
+#ifdef OPENMP_FOUND
+        #pragma omp simd reduction(+:found) reduction(|:any_parallel)
+#endif
+        for (long_unsigned_int i = first ; i < last ; i++) {
+            double Ax {e. a_x (i)}, Ay {e. a_y (i)} ;
+            double Bx {e. b_x (i)}, By {e. b_y (i)} ;
+            double numer_r {(Ay-cy)*(dx-cx)-(Ax-cx)*(dy-cy)} ;
+            double numer_s {(Ay-cy)*(Bx-Ax)-(Ax-cx)*(By-Ay)} ;
+            double denominator {(Bx-Ax)*(dy-cy)-(By-Ay)*(dx-cx)} ;
+            // the lanes of the parallel segments are not used
+            double r {numer_r / denominator} ;
+            double s {numer_s / denominator} ;
+            long_unsigned_int is_parallel {fabs (denominator) <= epsilon} ;
+            long_unsigned_int secant {!((r < 0) | (r > 1) | (s < 0) | (s > 1))} ;
+            parallel[i - first] = is_parallel ;
+            any_parallel |= is_parallel ;
+            found += secant & !is_parallel ;
+        }
+        count += found ;
+        if (any_parallel)
+            for (long_unsigned_int i {first} ; i < last ; i++)
+                if (parallel[i - first])
+                    count += (dpps::Vertex::segments_intersect (
+                        dpps::Vertex (e. a_x (i), e. a_y (i)),
+                        dpps::Vertex (e. b_x (i), e. b_y (i)), C, D) >= 1) ;
+    }
+    return count ;
+}
+} // namespace
+
+DPPS_MULTIVERSION
+long_unsigned_int dpps::Vertex::count_segments_intersect (
+    const Segment_arrays &segments, const Vertex &C, const Vertex &D) {
+    Array_ends ends {segments. x0. data (), segments. y0. data (),
+                     segments. x1. data (), segments. y1. data ()} ;
+    return count_ends_intersect (ends, segments. size (), C, D) ;
+}
+
+DPPS_MULTIVERSION
+long_unsigned_int dpps::Vertex::count_segments_intersect (
+    const Vertex_vector &vertices, const bool closed,
+    const Vertex &C, const Vertex &D) {
+    long_unsigned_int n {vertices. size ()} ;
+    if (n == 0)
+        return 0 ;
+    Vertex_ends ends {vertices. data ()} ;
+    long_unsigned_int count {count_ends_intersect (ends, n - 1, C, D)} ;
+    if (closed)
+        count += (segments_intersect (vertices. back (), vertices. front (),
+                                      C, D) >= 1) ;
+    return count ;
+}
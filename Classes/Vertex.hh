@@ -18,8 +18,11 @@
 #include <limits>
 #include <string>
 #include <array>
+#include <vector>
 
 namespace dpps {
+class Segment_arrays ;
+class Vertex_vector ;
 
     typedef enum {
         quadrant_centre,
@@ -224,6 +227,31 @@ public:
     bool is_aligned (const Vertex &v, const Vertex &w, double precision) const ;
 
     static short int segments_intersect (const Vertex &A, const Vertex &B, const Vertex &C, const Vertex &D) ;
+
+    /** @brief sets result[i] to 1 if segment [uv] intersects segment i,
+     * else to 0, as intersects() does, for all the segments at once.
+     *
+     * The turns are computed with the same operations and compared to the
+     * same epsilon as turn(), so that the results are exactly those of
+     * intersects(), including for collinear and touching segments, but
+     * the loop is vectorized. */
+    static void intersects (const Vertex &u, const Vertex &v,
+                            const Segment_arrays &segments,
+                            std::vector<unsigned char> &result) ;
+
+    /** @brief the number of segments i for which segments_intersect (start
+     * of i, end of i, C, D) is at least 1, computed in a vectorized loop
+     * with the same operations. The parallel segments, for which the result
+     * depends on more tests, are passed to segments_intersect() itself. This
+     * is the count of crossings of the ray of Polyline::contains(). */
+    static long_unsigned_int count_segments_intersect (
+        const Segment_arrays &segments, const Vertex &C, const Vertex &D) ;
+
+    /** @brief same, for the edges of a polyline of these vertices, read in
+     * place, the last one closing it if closed is set. */
+    static long_unsigned_int count_segments_intersect (
+        const Vertex_vector &vertices, const bool closed,
+        const Vertex &C, const Vertex &D) ;
 } ;
 } // namespace dpps
 
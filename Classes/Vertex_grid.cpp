@@ -0,0 +1,136 @@
+/**
+ * @file Vertex_grid.cpp
+ * @author Jérôme Borme <jerome.borme@inl.int>
+ * @version 1.0
+ * @brief Implementation of class Vertex_grid
+ * @date 2026-10-14 Jérôme Borme: Initial version
+ * @copyright
+ * This Source Code Form is subject to the terms of the Mozilla Public
+ * License, v. 2.0. If a copy of the MPL was not distributed with this
+ * file, You can obtain one at http://mozilla.org/MPL/2.0/.
+ */
+
+#include <cmath>
+#include <limits>
+#include <algorithm>
+
+#include "Vertex_grid.hh"
+
+dpps::Vertex_grid::Vertex_grid (const double precision,
+                                const double maximum_coordinate) {
+    // Same convention as Vertex::equals_to()
+    cell_size = precision ;
+    if (cell_size <= 0)
+        cell_size = std::numeric_limits<double>::epsilon() ;
+    // Cells numbers are kept within 2^30 so that they fit in a long signed
+    // int on all platforms. Larger cells only mean more candidates.
+    double minimum_cell_size {fabs (maximum_coordinate) / 1073741824.0} ;
+    if (cell_size < minimum_cell_size)
+        cell_size = minimum_cell_size ;
+}
+
+void dpps::Vertex_grid::get_cell (long signed int &i, long signed int &j,
+                                  const Vertex &v) const {
+    i = static_cast<long signed int> (floor (v. x / cell_size)) ;
+    j = static_cast<long signed int> (floor (v. y / cell_size)) ;
+}
+
+long_unsigned_int dpps::Vertex_grid::cell_key (const long signed int i,
+                                               const long signed int j) {
+    return (static_cast<long_unsigned_int> (i) * 73856093u) ^
+           (static_cast<long_unsigned_int> (j) * 19349663u) ;
+}
+
+void dpps::Vertex_grid::insert (const Vertex &v, const long_unsigned_int n) {
+    long signed int i, j ;
+    get_cell (i, j, v) ;
+    cells[cell_key (i, j)]. push_back (n) ;
+}
+
+void dpps::Vertex_grid::neighbours (const Vertex &v,
+    std::vector<long_unsigned_int> &result) const {
+    result. clear () ;
+    long signed int i, j ;
+    get_cell (i, j, v) ;
+    for (long signed int di = -1 ; di <= 1 ; di++)
+        for (long signed int dj = -1 ; dj <= 1 ; dj++) {
+            auto cell = cells. find (cell_key (i + di, j + dj)) ;
+            if (cell != cells. end ())
+                result. insert (result. end (),
+                                cell-> second. begin (),
+                                cell-> second. end ()) ;
+        }
+}
+
+void dpps::Vertex_grid::erase (const Vertex &v, const long_unsigned_int n) {
+    long signed int i, j ;
+    get_cell (i, j, v) ;
+    auto cell = cells. find (cell_key (i, j)) ;
+    if (cell == cells. end ())
+        return ;
+    std::vector<long_unsigned_int> &indices {cell-> second} ;
+    auto k = std::find (indices. begin (), indices. end (), n) ;
+    if (k == indices. end ())
+        return ;
+    // the order of the indices in a cell does not matter
+    *k = indices. back () ;
+    indices. pop_back () ;
+    if (indices. empty ())
+        cells. erase (cell) ;
+}
+
+void dpps::Vertex_grid::ring (const Vertex &v, const long_unsigned_int r,
+    std::vector<long_unsigned_int> &result) const {
+    result. clear () ;
+    long signed int i, j ;
+    get_cell (i, j, v) ;
+    long signed int d {static_cast<long signed int> (r)} ;
+    auto add_cell = [&] (const long signed int ci, const long signed int cj) {
+        auto cell = cells. find (cell_key (ci, cj)) ;
+        if (cell != cells. end ())
+            result. insert (result. end (),
+                            cell-> second. begin (),
+                            cell-> second. end ()) ;
+    } ;
+    if (d == 0) {
+        add_cell (i, j) ;
+        return ;
+    }
+    for (long signed int k = -d ; k <= d ; k++) {
+        add_cell (i + k, j - d) ;
+        add_cell (i + k, j + d) ;
+    }
+    for (long signed int k = -d + 1 ; k <= d - 1 ; k++) {
+        add_cell (i - d, j + k) ;
+        add_cell (i + d, j + k) ;
+    }
+}
+
+double dpps::Vertex_grid::get_cell_size () const {
+    return cell_size ;
+}
+
+void dpps::Vertex_grid::clear () {
+    cells. clear () ;
+}
+
+namespace {
+template <class Container>
+double maximum_absolute_coordinate (const Container &vertices) {
+    double result {0.0} ;
+    // the reference &v is used to avoid copy
+    for (auto &v: vertices)
+        result = std::max (result, std::max (fabs (v. x), fabs (v. y))) ;
+    return result ;
+}
+} // namespace
+
+double dpps::Vertex_grid::maximum_coordinate (
+    const std::vector<Vertex> &vertices) {
+    return maximum_absolute_coordinate (vertices) ;
+}
+
+double dpps::Vertex_grid::maximum_coordinate (
+    const Vertex_vector &vertices) {
+    return maximum_absolute_coordinate (vertices) ;
+}
@@ -0,0 +1,107 @@
+/**
+ * @file Vertex_grid.hh
+ * @author Jérôme Borme <jerome.borme@inl.int>
+ * @version 1.0
+ * @brief Header file for class Vertex_grid, a spatial index of vertices
+ * @date 2026-10-14 Jérôme Borme: Initial version
+ * @copyright
+ * This Source Code Form is subject to the terms of the Mozilla Public
+ * License, v. 2.0. If a copy of the MPL was not distributed with this
+ * file, You can obtain one at http://mozilla.org/MPL/2.0/.
+ */
+#ifndef DPPS_VERTEX_GRID
+#define DPPS_VERTEX_GRID
+
+#include <unordered_map>
+#include <vector>
+
+#include "common.hh"
+#include "Vertex.hh"
+#include "Vertex_vector.hh"
+
+namespace dpps {
+/** @brief A spatial index of vertices, to find quickly the vertices close to
+ * a given position.
+ *
+ * The plane is divided into square cells of a size at least equal to the
+ * precision passed to the constructor. Each inserted Vertex is recorded with
+ * an index chosen by the caller (typically its position in a vector) in the
+ * cell where it lies. Two vertices which are equal within the precision, in
+ * the sense of Vertex::equals_to(), are then in the same cell or in adjacent
+ * cells, so that the candidates for equality with a position are found by
+ * looking at the 3×3 cells around it.
+ *
+ * neighbours() returns candidates only: the caller still has to perform the
+ * actual comparison. This makes it possible to look for equal vertices as
+ * well as for equal polylines, by indexing their first vertex.
+ *
+ * Cells are stored in a hash table, so that only non-empty cells use memory.
+ */
+class Vertex_grid {
+protected:
+    /** @brief side of a cell. */
+    double cell_size {1.0} ;
+
+    /** @brief the non-empty cells, with the indices of their vertices. */
+    std::unordered_map<long_unsigned_int,
+                       std::vector<long_unsigned_int>> cells ;
+
+    /** @brief coordinates of the cell containing v. */
+    void get_cell (long signed int &i, long signed int &j,
+                   const Vertex &v) const ;
+
+    /** @brief key of cell (i, j) in the hash table.
+     *
+     * Two cells may share the same key, which only adds candidates to the
+     * result of neighbours(). */
+    static long_unsigned_int cell_key (const long signed int i,
+                                       const long signed int j) ;
+public:
+    /** @brief Constructor.
+     *
+     * The precision is the tolerance of the comparisons the caller will
+     * make. maximum_coordinate is the largest absolute value of the
+     * coordinates that will be inserted or looked for. It is used to enlarge
+     * the cells when precision is so small compared to the coordinates that
+     * cell numbers would not fit in an integer.
+     */
+    Vertex_grid (const double precision, const double maximum_coordinate) ;
+
+    /** @brief records Vertex v with index n. */
+    void insert (const Vertex &v, const long_unsigned_int n) ;
+
+    /** @brief Sets result to the indices of all the vertices inserted in the
+     * 3×3 cells around v.
+     *
+     * All the vertices equal to v within precision are part of them, but
+     * more may be returned. */
+    void neighbours (const Vertex &v,
+                     std::vector<long_unsigned_int> &result) const ;
+
+    /** @brief removes the record of Vertex v with index n, if it exists. */
+    void erase (const Vertex &v, const long_unsigned_int n) ;
+
+    /** @brief Sets result to the indices of the vertices inserted in the
+     * cells at distance r from the cell of v, that is the cells (i, j) with
+     * max (|i - iv|, |j - jv|) = r.
+     *
+     * These vertices are at least (r - 1) * get_cell_size() away from v, so
+     * that the nearest vertex can be found by looking at increasing r. */
+    void ring (const Vertex &v, const long_unsigned_int r,
+               std::vector<long_unsigned_int> &result) const ;
+
+    /** @brief side of a cell. */
+    double get_cell_size () const ;
+
+    /** @brief removes all the vertices. */
+    void clear () ;
+
+    /** @brief returns the largest absolute value of the coordinates of
+     * vertices, to be passed to the constructor. */
+    static double maximum_coordinate (const std::vector<Vertex> &vertices) ;
+
+    /** @brief the same for the vertices of a Polyline. */
+    static double maximum_coordinate (const Vertex_vector &vertices) ;
+} ;
+} // namespace dpps
+#endif
@@ -0,0 +1,234 @@
+/**
+ * @file Vertex_vector.cpp
+ * @author Jérôme Borme <jerome.borme@inl.int>
+ * @version 1.0
+ * @brief Implementation of class Vertex_vector
+ * @date 2026-10-14 Jérôme Borme: Initial version
+ * @copyright
+ * This Source Code Form is subject to the terms of the Mozilla Public
+ * License, v. 2.0. If a copy of the MPL was not distributed with this
+ * file, You can obtain one at http://mozilla.org/MPL/2.0/.
+ */
+
+#include <algorithm>
+#include <cstring>
+#include <functional>
+#include <memory>
+#include <stdexcept>
+#include <string>
+
+#include "Vertex_vector.hh"
+
+const dpps::Vertex_vector::size_type dpps::Vertex_vector::inline_capacity ;
+
+void dpps::Vertex_vector::reallocate (const size_type new_allocated) {
+    Vertex *old {data ()} ;
+    bool old_on_heap {on_heap ()} ;
+    if (new_allocated <= inline_capacity) {
+        if (!old_on_heap)
+            return ;
+        // The union holds the heap pointer, which is read before the copy.
+        std::memcpy (static_cast<void *> (storage. local), old,
+                     count * sizeof (Vertex)) ;
+        allocated = inline_capacity ;
+    } else {
+        Vertex *buffer {static_cast<Vertex *> (
+            ::operator new (new_allocated * sizeof (Vertex)))} ;
+        std::memcpy (static_cast<void *> (buffer), old,
+                     count * sizeof (Vertex)) ;
+        storage. heap = buffer ;
+        allocated = new_allocated ;
+    }
+    if (old_on_heap)
+        ::operator delete (old) ;
+}
+
+void dpps::Vertex_vector::grow_for (const size_type n) {
+    if (count + n <= allocated)
+        return ;
+    reallocate (std::max (count + n, 2 * allocated)) ;
+}
+
+dpps::Vertex_vector::iterator dpps::Vertex_vector::open_gap (
+    const_iterator position, const size_type n) {
+    size_type offset {static_cast<size_type> (position - cbegin ())} ;
+    grow_for (n) ;
+    Vertex *start {data () + offset} ;
+    std::memmove (static_cast<void *> (start + n), start,
+                  (count - offset) * sizeof (Vertex)) ;
+    count += n ;
+    return start ;
+}
+
+dpps::Vertex_vector::iterator dpps::Vertex_vector::insert_range (
+    const_iterator position, const Vertex *first, const Vertex *last,
+    std::true_type) {
+    std::less<const Vertex *> before ;
+    if ((!before (first, cbegin ())) && before (first, cend ())) {
+        // The vertices are ours and the gap would move them.
+        Vertex_vector copy ;
+        copy. insert_range (copy. cend (), first, last, std::true_type ()) ;
+        return insert_range (position, copy. cbegin (), copy. cend (),
+                             std::true_type ()) ;
+    }
+    size_type n {static_cast<size_type> (last - first)} ;
+    iterator start {open_gap (position, n)} ;
+    std::uninitialized_copy (first, last, start) ;
+    return start ;
+}
+
+dpps::Vertex_vector::Vertex_vector (const size_type n) {
+    resize (n) ;
+}
+
+dpps::Vertex_vector::Vertex_vector (const size_type n, const Vertex &v) {
+    assign (n, v) ;
+}
+
+dpps::Vertex_vector::Vertex_vector (std::initializer_list<Vertex> list) {
+    assign (list) ;
+}
+
+dpps::Vertex_vector::Vertex_vector (const std::vector<Vertex> &v) {
+    reserve (v. size ()) ;
+    assign (v. data (), v. data () + v. size ()) ;
+}
+
+dpps::Vertex_vector::Vertex_vector (const Vertex_vector &v) {
+    // The copy is allocated at the exact size.
+    reserve (v. size ()) ;
+    assign (v. cbegin (), v. cend ()) ;
+}
+
+dpps::Vertex_vector::Vertex_vector (Vertex_vector &&v) {
+    swap (v) ;
+}
+
+dpps::Vertex_vector::~Vertex_vector () {
+    if (on_heap ())
+        ::operator delete (storage. heap) ;
+}
+
+dpps::Vertex_vector &dpps::Vertex_vector::operator= (const Vertex_vector &v) {
+    if (this != &v)
+        assign (v. cbegin (), v. cend ()) ;
+    return *this ;
+}
+
+dpps::Vertex_vector &dpps::Vertex_vector::operator= (Vertex_vector &&v) {
+    swap (v) ;
+    return *this ;
+}
+
+dpps::Vertex_vector &dpps::Vertex_vector::operator= (
+    std::initializer_list<Vertex> list) {
+    assign (list) ;
+    return *this ;
+}
+
+std::vector<dpps::Vertex> dpps::Vertex_vector::to_vector () const {
+    return std::vector<Vertex> (cbegin (), cend ()) ;
+}
+
+dpps::Vertex &dpps::Vertex_vector::at (const size_type i) {
+    if (i >= count) {
+        std::string reason {"Vertex_vector::at, vertex " + std::to_string (i) +
+                            " requested from " + std::to_string (count)} ;
+        throw std::out_of_range (reason. c_str ()) ;
+    }
+    return data ()[i] ;
+}
+
+const dpps::Vertex &dpps::Vertex_vector::at (const size_type i) const {
+    if (i >= count) {
+        std::string reason {"Vertex_vector::at, vertex " + std::to_string (i) +
+                            " requested from " + std::to_string (count)} ;
+        throw std::out_of_range (reason. c_str ()) ;
+    }
+    return data ()[i] ;
+}
+
+void dpps::Vertex_vector::reserve (const size_type n) {
+    if (n > allocated)
+        reallocate (n) ;
+}
+
+void dpps::Vertex_vector::shrink_to_fit () {
+    if (on_heap () && (count < allocated))
+        reallocate (count) ;
+}
+
+void dpps::Vertex_vector::resize (const size_type n) {
+    resize (n, Vertex ()) ;
+}
+
+void dpps::Vertex_vector::resize (const size_type n, const Vertex &v) {
+    if (n <= count) {
+        count = n ;
+        return ;
+    }
+    insert (cend (), n - count, v) ;
+}
+
+void dpps::Vertex_vector::assign (const size_type n, const Vertex &v) {
+    // v may be one of the vertices.
+    Vertex copy {v} ;
+    clear () ;
+    insert (cend (), n, copy) ;
+}
+
+void dpps::Vertex_vector::assign (std::initializer_list<Vertex> list) {
+    clear () ;
+    insert_range (cend (), list. begin (), list. end (), std::true_type ()) ;
+}
+
+dpps::Vertex_vector::iterator dpps::Vertex_vector::insert (
+    const_iterator position, const Vertex &v) {
+    return insert (position, 1, v) ;
+}
+
+dpps::Vertex_vector::iterator dpps::Vertex_vector::insert (
+    const_iterator position, const size_type n, const Vertex &v) {
+    Vertex copy {v} ;
+    iterator start {open_gap (position, n)} ;
+    std::uninitialized_fill (start, start + n, copy) ;
+    return start ;
+}
+
+dpps::Vertex_vector::iterator dpps::Vertex_vector::insert (
+    const_iterator position, std::initializer_list<Vertex> list) {
+    return insert_range (position, list. begin (), list. end (),
+                         std::true_type ()) ;
+}
+
+dpps::Vertex_vector::iterator dpps::Vertex_vector::erase (
+    const_iterator position) {
+    return erase (position, position + 1) ;
+}
+
+dpps::Vertex_vector::iterator dpps::Vertex_vector::erase (
+    const_iterator first, const_iterator last) {
+    iterator start {begin () + (first - cbegin ())} ;
+    std::memmove (static_cast<void *> (start), last,
+                  (cend () - last) * sizeof (Vertex)) ;
+    count -= last - first ;
+    return start ;
+}
+
+void dpps::Vertex_vector::swap (Vertex_vector &v) {
+    // The inline vertices are copied, the heap buffers are exchanged.
+    Storage temp ;
+    std::memcpy (static_cast<void *> (&temp), &storage, sizeof (Storage)) ;
+    std::memcpy (static_cast<void *> (&storage), &v. storage, sizeof (Storage)) ;
+    std::memcpy (static_cast<void *> (&v. storage), &temp, sizeof (Storage)) ;
+    std::swap (count, v. count) ;
+    std::swap (allocated, v. allocated) ;
+}
+
+bool dpps::Vertex_vector::operator== (const Vertex_vector &v) const {
+    return (count == v. count) && std::equal (cbegin (), cend (), v. cbegin ()) ;
+}
+
+bool dpps::Vertex_vector::operator!= (const Vertex_vector &v) const {
+    return !(*this == v) ;
+}
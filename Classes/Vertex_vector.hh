@@ -0,0 +1,310 @@
+/**
+ * @file Vertex_vector.hh
+ * @author Jérôme Borme <jerome.borme@inl.int>
+ * @version 1.0
+ * @brief Header file for class Vertex_vector, the container of the vertices
+ * of a Polyline
+ * @date 2026-10-14 Jérôme Borme: Initial version
+ * @copyright
+ * This Source Code Form is subject to the terms of the Mozilla Public
+ * License, v. 2.0. If a copy of the MPL was not distributed with this
+ * file, You can obtain one at http://mozilla.org/MPL/2.0/.
+ */
+#ifndef DPPS_VERTEX_VECTOR
+#define DPPS_VERTEX_VECTOR
+
+#include <cstddef>
+#include <initializer_list>
+#include <iterator>
+#include <new>
+#include <type_traits>
+#include <utility>
+#include <vector>
+
+#include "common.hh"
+#include "Vertex.hh"
+
+namespace dpps {
+/** @brief A vector of Vertex which keeps up to inline_capacity vertices in
+ * the object itself, so that dots, lines and rectangles need no allocation.
+ *
+ * Most polylines are dots (lattices, explode_in_vertices()), lines
+ * (fill_with_lines(), explode()) or rectangles, for which a std::vector
+ * would allocate a buffer of its own. Beyond inline_capacity, the vertices
+ * move to the heap and grow as in std::vector.
+ *
+ * It has the part of the interface of std::vector that the classes use,
+ * with the same meaning. The iterators are pointers, invalidated as those
+ * of std::vector. It can be built from a std::vector<Vertex>, and
+ * to_vector() makes the opposite conversion, which is not implicit so that
+ * no copy is made by mistake. */
+class Vertex_vector {
+public:
+    typedef Vertex value_type ;
+    typedef Vertex &reference ;
+    typedef const Vertex &const_reference ;
+    typedef Vertex *pointer ;
+    typedef const Vertex *const_pointer ;
+    typedef Vertex *iterator ;
+    typedef const Vertex *const_iterator ;
+    typedef std::reverse_iterator<iterator> reverse_iterator ;
+    typedef std::reverse_iterator<const_iterator> const_reverse_iterator ;
+    typedef std::size_t size_type ;
+    typedef std::ptrdiff_t difference_type ;
+
+    /** @brief the number of vertices kept without allocation. */
+    static const size_type inline_capacity {4} ;
+
+protected:
+    // The vertices are copied as values and never destroyed one by one.
+    static_assert (std::is_trivially_destructible<Vertex>::value,
+                   "Vertex_vector requires a trivially destructible Vertex") ;
+
+    size_type count {0} ;
+    size_type allocated {inline_capacity} ;
+
+    /** @brief the heap buffer if allocated > inline_capacity, otherwise the
+     * vertices, so that the heap pointer costs no space. */
+    union Storage {
+        Vertex *heap ;
+        typename std::aligned_storage<sizeof (Vertex),
+            std::alignment_of<Vertex>::value>::type local[inline_capacity] ;
+    } storage {} ;
+
+    bool on_heap () const {
+        return allocated > inline_capacity ;
+    }
+
+    /** @brief moves the vertices to a buffer of capacity new_allocated,
+     * which must be at least count. */
+    void reallocate (const size_type new_allocated) ;
+
+    /** @brief makes room for count + n vertices, growing geometrically. */
+    void grow_for (const size_type n) ;
+
+    /** @brief opens n uninitialised places at position, and returns them. */
+    iterator open_gap (const_iterator position, const size_type n) ;
+
+    iterator insert_range (const_iterator position, const Vertex *first,
+                           const Vertex *last, std::true_type) ;
+
+    template <class Iterator>
+    iterator insert_range (const_iterator position, Iterator first,
+                           Iterator last, std::false_type) {
+        // Copied first, for iterators of any kind.
+        Vertex_vector copy ;
+        for ( ; first != last ; ++first)
+            copy. push_back (*first) ;
+        return insert_range (position, copy. cbegin (), copy. cend (),
+                             std::true_type ()) ;
+    }
+
+public:
+    Vertex_vector () {
+    }
+
+    explicit Vertex_vector (const size_type n) ;
+
+    Vertex_vector (const size_type n, const Vertex &v) ;
+
+    template <class Iterator>
+    Vertex_vector (Iterator first, Iterator last) {
+        assign (first, last) ;
+    }
+
+    Vertex_vector (std::initializer_list<Vertex> list) ;
+
+    /** @brief Constructor which copies the vertices of v. */
+    Vertex_vector (const std::vector<Vertex> &v) ;
+
+    Vertex_vector (const Vertex_vector &v) ;
+
+    Vertex_vector (Vertex_vector &&v) ;
+
+    ~Vertex_vector () ;
+
+    Vertex_vector &operator= (const Vertex_vector &v) ;
+
+    Vertex_vector &operator= (Vertex_vector &&v) ;
+
+    Vertex_vector &operator= (std::initializer_list<Vertex> list) ;
+
+    /** @brief returns a copy of the vertices in a std::vector. */
+    std::vector<Vertex> to_vector () const ;
+
+    Vertex *data () {
+        return on_heap () ? storage. heap :
+                            reinterpret_cast<Vertex *> (storage. local) ;
+    }
+
+    const Vertex *data () const {
+        return on_heap () ? storage. heap :
+                            reinterpret_cast<const Vertex *> (storage. local) ;
+    }
+
+    iterator begin () {
+        return data () ;
+    }
+
+    iterator end () {
+        return data () + count ;
+    }
+
+    const_iterator begin () const {
+        return data () ;
+    }
+
+    const_iterator end () const {
+        return data () + count ;
+    }
+
+    const_iterator cbegin () const {
+        return data () ;
+    }
+
+    const_iterator cend () const {
+        return data () + count ;
+    }
+
+    reverse_iterator rbegin () {
+        return reverse_iterator (end ()) ;
+    }
+
+    reverse_iterator rend () {
+        return reverse_iterator (begin ()) ;
+    }
+
+    const_reverse_iterator rbegin () const {
+        return const_reverse_iterator (end ()) ;
+    }
+
+    const_reverse_iterator rend () const {
+        return const_reverse_iterator (begin ()) ;
+    }
+
+    const_reverse_iterator crbegin () const {
+        return const_reverse_iterator (end ()) ;
+    }
+
+    const_reverse_iterator crend () const {
+        return const_reverse_iterator (begin ()) ;
+    }
+
+    size_type size () const {
+        return count ;
+    }
+
+    bool empty () const {
+        return count == 0 ;
+    }
+
+    size_type capacity () const {
+        return allocated ;
+    }
+
+    Vertex &operator[] (const size_type i) {
+        return data ()[i] ;
+    }
+
+    const Vertex &operator[] (const size_type i) const {
+        return data ()[i] ;
+    }
+
+    /** @brief returns vertex i, and throws std::out_of_range if there is
+     * none, as std::vector::at(). */
+    Vertex &at (const size_type i) ;
+
+    const Vertex &at (const size_type i) const ;
+
+    Vertex &front () {
+        return data ()[0] ;
+    }
+
+    const Vertex &front () const {
+        return data ()[0] ;
+    }
+
+    Vertex &back () {
+        return data ()[count - 1] ;
+    }
+
+    const Vertex &back () const {
+        return data ()[count - 1] ;
+    }
+
+    void push_back (const Vertex &v) {
+        if (count == allocated) {
+            // v may be one of the vertices, which the growth moves.
+            Vertex copy {v} ;
+            grow_for (1) ;
+            new (data () + count) Vertex (copy) ;
+        } else
+            new (data () + count) Vertex (v) ;
+        count++ ;
+    }
+
+    template <class... Arguments>
+    void emplace_back (Arguments &&... arguments) {
+        push_back (Vertex (std::forward<Arguments> (arguments)...)) ;
+    }
+
+    void pop_back () {
+        count-- ;
+    }
+
+    void clear () {
+        count = 0 ;
+    }
+
+    /** @brief makes room for n vertices, as std::vector::reserve(). */
+    void reserve (const size_type n) ;
+
+    /** @brief frees the unused places, and goes back to the inline storage
+     * if the vertices fit. */
+    void shrink_to_fit () ;
+
+    void resize (const size_type n) ;
+
+    void resize (const size_type n, const Vertex &v) ;
+
+    void assign (const size_type n, const Vertex &v) ;
+
+    template <class Iterator>
+    void assign (Iterator first, Iterator last) {
+        clear () ;
+        insert (cend (), first, last) ;
+    }
+
+    void assign (std::initializer_list<Vertex> list) ;
+
+    iterator insert (const_iterator position, const Vertex &v) ;
+
+    iterator insert (const_iterator position, const size_type n,
+                     const Vertex &v) ;
+
+    template <class Iterator>
+    iterator insert (const_iterator position, Iterator first,
+                     Iterator last) {
+        return insert_range (position, first, last,
+            typename std::is_convertible<Iterator, const Vertex *>::type ()) ;
+    }
+
+    iterator insert (const_iterator position,
+                     std::initializer_list<Vertex> list) ;
+
+    iterator erase (const_iterator position) ;
+
+    iterator erase (const_iterator first, const_iterator last) ;
+
+    void swap (Vertex_vector &v) ;
+
+    bool operator== (const Vertex_vector &v) const ;
+
+    bool operator!= (const Vertex_vector &v) const ;
+} ;
+
+inline void swap (Vertex_vector &a, Vertex_vector &b) {
+    a. swap (b) ;
+}
+} // namespace dpps
+#endif
@@ -12,8 +12,6 @@
 
 #include "configure.h"
 
-#include <cstdio> // remove
-
 #include "Writer.hh"
 #include "bad_parametre.hh"
 #include "bad_io.hh"
@@ -24,42 +22,87 @@
 dpps::Writer::Writer (const std::string &set_filename,
                       const bool set_append):
     filename (set_filename), append (set_append) {
+#ifndef ZLIB_FOUND
+    if (is_gzip_filename (filename)) {
+        std::string reason {"File " + filename + " cannot be compressed, "
+                            "as dpps was compiled without zlib"} ;
+        throw bad_io (reason. c_str ()) ;
+    }
+#endif
+    std::ios_base::openmode mode {std::ios_base::out} ;
     if (set_append)
-        file. open (filename, std::ios_base::out|std::ios_base::app) ;
+        mode |= std::ios_base::app ;
     else
-        file. open (filename, std::ios_base::out|std::ios_base::trunc) ;
+        mode |= std::ios_base::trunc ;
+    // The compressed data must not go through the end of line conversions.
+    if (is_gzip_filename (filename))
+        mode |= std::ios_base::binary ;
+    file. open (filename, mode) ;
     if (!file. is_open ()) {
         std::string reason {"File " + filename +
                             " could not be open for output"} ;
         throw bad_io (reason. c_str ()) ;
     }
-    // tmpnam returns a pointer to an internal static buffer.
-    // I prefer to pipe it to an explicit adapter to make sure memory
-    // is properly handled.
-    tmpfilename = std::string (tmpnam (nullptr)) ;
-#ifdef FILENAMES_FOR_WINDOWS
-    tmpfilename = ".\\" + tmpfilename ;
-#endif
-    tmpfile. open (tmpfilename, std::ofstream::out|std::ofstream::trunc) ;
-    if (!tmpfile. is_open ()) {
-        std::string reason {"Writer: file " + tmpfilename +
-                            " could not be open for output"} ;
-        throw bad_io (reason. c_str ()) ;
+#ifdef ZLIB_FOUND
+    // In append mode, a new gzip member is added, which the readers and
+    // gunzip read as the continuation of the previous ones.
+    if (is_gzip_filename (filename)) {
+        output_thread. reset (new Gzip_output_buffer (file. rdbuf ())) ;
+        static_cast<std::ostream &> (file). rdbuf (output_thread. get ()) ;
     }
+#endif
 }
 
+dpps::Writer::Writer () {}
+
 void dpps::Writer::write_header () {
 }
 
 void dpps::Writer::write_footer () {
 }
 
+void dpps::Writer::begin_stream () {
+    write_header () ;
+}
+
+void dpps::Writer::write_Polyline_stream (const Polyline &polyline) {
+    write_Polyline (polyline) ;
+}
+
+void dpps::Writer::end_stream () {
+    write_footer () ;
+}
+
 dpps::Writer::~Writer () {
     if (open)
         close () ;
 }
 
+bool dpps::Writer::finish_output_thread () {
+    if (!output_thread)
+        return true ;
+    bool written {output_thread-> finish ()} ;
+    // back to the std::filebuf of file
+    static_cast<std::ostream &> (file). rdbuf (file. rdbuf ()) ;
+    output_thread. reset () ;
+    return written ;
+}
+
+void dpps::Writer::set_asynchronous (const bool asynchronous) {
+    if (!file. is_open () || is_gzip_filename (filename))
+        return ;
+    if (asynchronous && !output_thread) {
+        output_thread. reset (new Async_output_buffer (file. rdbuf ())) ;
+        static_cast<std::ostream &> (file). rdbuf (output_thread. get ()) ;
+    } else if (!asynchronous && !finish_output_thread ()) {
+        std::string reason {"Writer: file " + filename +
+                            " could not be written"} ;
+        throw bad_io (reason. c_str ()) ;
+    }
+}
+
 void dpps::Writer::close () {
+    bool written {finish_output_thread ()} ;
     if (file. is_open ()) {
         file. close () ;
         if (file. bad()) {
@@ -68,20 +111,22 @@ void dpps::Writer::close () {
             throw bad_io (reason. c_str ()) ;
         }
     }
-    if (tmpfile. is_open ()) {
-        tmpfile. close () ;
-        if (tmpfile. bad()) {
-            std::string reason {"Writer: tmpfile " + tmpfilename +
-                                " could not be closed"} ;
-            throw bad_io (reason. c_str ()) ;
-        }
-    }
-    if (remove (tmpfilename. c_str ()) != 0) {
-        std::string reason {"Writer: file " + tmpfilename +
-                            " could not be removed"} ;
+    body. str (std::string ()) ;
+    open = false ;
+    if (!written) {
+        std::string reason {"Writer: file " + filename +
+                            " could not be written"} ;
         throw bad_io (reason. c_str ()) ;
     }
-    open = false ;
+}
+
+void dpps::Writer::write_body () {
+    // Writing a stream into another. See:
+    // * N. Josuttis, The C++ std. lib. 2nd ed (2012),
+    //   section 15.14.3 « Using stream buffers directly », page 846-7.
+    // Inserting an empty stream buffer would set failbit on file.
+    if (body. rdbuf ()-> in_avail () > 0)
+        file << body. rdbuf () ;
 }
 
 void dpps::Writer::set_parametres (const std::vector<bool> &vbool,
@@ -100,8 +145,10 @@ void dpps::Writer::set_parametres (const std::vector<bool> &vbool,
 
 void dpps::Writer::write_Pattern (const Pattern &pattern) {
     write_header () ;
-    for (auto p: pattern. polylines)
+    // the reference &p is used to avoid copy
+    for (auto &p: pattern. polylines)
         write_Polyline (p) ;
+    write_instances (pattern, -1) ;
     write_footer () ;
 }
 
@@ -109,8 +156,38 @@ void dpps::Writer::write_Pattern_selected (const Pattern &pattern,
     const selection_t selection) {
 check_selection_not_too_high(selection) ;
     write_header () ;
-    for (auto p: pattern. polylines)
+    // the reference &p is used to avoid copy
+    for (auto &p: pattern. polylines)
         if ((selection < 0) || (p. selected[selection]))
             write_Polyline (p) ;
+    write_instances (pattern, selection) ;
     write_footer () ;
+}
+
+void dpps::Writer::write_instances (const Pattern &pattern,
+                                    const selection_t selection) {
+    pattern. for_each_instance_polyline (
+        [this] (const Polyline &p) {
+            write_Polyline (p) ;
+        }, selection) ;
+}
+
+void dpps::Writer::write_Polyline_view (
+    const std::vector<const Polyline *> &view) {
+    write_header () ;
+    for (auto p: view)
+        write_Polyline (*p) ;
+    write_footer () ;
+}
+
+std::vector<const dpps::Polyline *> dpps::Writer::selected_view (
+    const Pattern &pattern,
+    const selection_t selection) {
+check_selection_not_too_high(selection) ;
+    std::vector<const Polyline *> result ;
+    result. reserve (pattern. polylines. size ()) ;
+    for (auto &p: pattern. polylines)
+        if ((selection < 0) || (p. selected[selection]))
+            result. push_back (&p) ;
+    return result ;
 }
\ No newline at end of file
@@ -16,7 +16,15 @@
 #ifndef DPPS_WRITER
 #define DPPS_WRITER
 
+#include <sstream>
+#include <memory>
+
+#include "configure.h"
 #include "Pattern.hh"
+#include "Async_output_buffer.hh"
+#ifdef ZLIB_FOUND
+#include "Gzip_buffer.hh"
+#endif
 
 namespace dpps {
 /** @brief This is the base abstract class for file processing. It will be
@@ -30,24 +38,33 @@ protected:
     /** @brief the stream where all data is going to be sent to. */
     std::ofstream file ;
 
+    /** @brief if the output is asynchronous or compressed, the stream
+     * buffer of file, which passes the data to the file itself from a
+     * thread of its own. It is a Gzip_output_buffer if the file name ends
+     * with .gz. */
+    std::unique_ptr<Async_output_buffer> output_thread ;
+
+    /** @brief writes what output_thread holds and puts back the stream
+     * buffer of the file. Returns false if anything could not be written. */
+    bool finish_output_thread () ;
+
     std::string filename ;
 
-    /** @brief A temporary file.
+    /** @brief A buffer for the body of the output.
      *
-     * It can be used as a buffer for the output. Often, the file header is
-     * known only when the file is finished. In this case, the temporary file
-     * is used to write the output, then the final file is used to write the
-     * header (once it's known) and receive a copy of temporary file's contents.
+     * Often, the file header is known only when the file is finished. In this
+     * case, the body is written to this buffer, then the final file is used
+     * to write the header (once it's known) and receives the contents of the
+     * buffer through write_body().
      *
-     * The file is opened in text-mode for output, an will be closed and
-     * removed by Writer::close() and Writer::~Writer().
+     * The buffer is kept in memory rather than in a temporary file, so that
+     * the body is written to disk only once. It is emptied by
+     * Writer::close().
      */
-    std::ofstream tmpfile ;
-    /** @brief A randomly chosen filename, provided by C functions. It is set
-     * in Writer constructor.
-     */
-    std::string tmpfilename ;
+    std::stringstream body ;
 
+    /** @brief writes the contents of body to file. */
+    void write_body () ;
 
     /** @brief whether the stream is open.
      *
@@ -63,6 +80,34 @@ protected:
      * need to be opened in similar fashion.
      */
     bool append {false} ;
+
+    /** @brief writes the header, the polylines pointed to by view, in this
+     * order, and the footer.
+     *
+     * This allows derived classes to write a reordered or filtered subset of
+     * a Pattern without copying its polylines: view only holds pointers to
+     * polylines owned by the Pattern, which must outlive the call.
+     */
+    void write_Polyline_view (const std::vector<const Polyline *> &view) ;
+
+    /** @brief writes the polylines drawn by the instances of pattern which
+     * belong to selection (all of them if selection is negative).
+     *
+     * By default, the polylines are computed and written one at a time with
+     * write_Polyline(). Derived classes for formats which can refer to a
+     * group of entities several times may write the cells once instead. */
+    virtual void write_instances (const Pattern &pattern,
+                                  const selection_t selection) ;
+
+    /** @brief returns pointers to the polylines of pattern which belong to
+     * selection (all of them if selection is negative), in their order. */
+    static std::vector<const Polyline *> selected_view (
+        const Pattern &pattern,
+        const selection_t selection) ;
+    /** @brief Constructor which opens no file, for derived classes which
+     * can also be used without output, such as the simulations of
+     * Writer_witec. */
+    Writer () ;
 public:
     Writer (const std::string &set_filename, const bool append) ;
 
@@ -92,6 +137,29 @@ public:
      */
     virtual void write_footer () ;
 
+    /** @brief starts writing polylines one at a time, without a Pattern.
+     *
+     * Calling begin_stream(), then write_Polyline_stream() for each polyline,
+     * then end_stream() writes the same file as write_Pattern() on a Pattern
+     * made of these polylines, without having to keep them in memory.
+     * Derived classes whose header depends on the whole pattern (such as its
+     * bounding box) collect that information polyline by polyline.
+     *
+     * Processing which needs all the polylines at once, such as the
+     * reordering done by Writer_witec::write_Pattern(), is not performed.
+     *
+     * By default, it calls write_header().
+     */
+    virtual void begin_stream () ;
+
+    /** @brief writes one polyline after begin_stream(). By default, it calls
+     * write_Polyline(). */
+    virtual void write_Polyline_stream (const Polyline &polyline) ;
+
+    /** @brief finishes the output started by begin_stream(). By default, it
+     * calls write_footer(). */
+    virtual void end_stream () ;
+
     /** @brief Destructor, closes the stream.
      *
      * It is virtual to make sure we always give a chance to invoke the
@@ -102,6 +170,20 @@ public:
 
     virtual void close () ;
 
+    /** @brief whether the file is written from a thread of its own.
+     *
+     * When asynchronous is true, the derived classes format blocks of
+     * Async_output_buffer::block_size while the previous ones are written
+     * to disk, and a few blocks at most wait in memory. close() waits until
+     * everything is written. This helps the large files, whose writing
+     * would otherwise stop the computation while the system writes.
+     *
+     * It may be changed at any time while the file is open. The compressed
+     * files (see is_gzip_filename()) are always written asynchronously.
+     * Default is false.
+     */
+    void set_asynchronous (const bool asynchronous) ;
+
     /** @brief Function to pass metadata to set-up the Writer.
      *
      * To allow the main program to pass generically the arguments that
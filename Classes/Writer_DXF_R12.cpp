@@ -28,7 +28,12 @@
 
 #include <ctime>
 #include <cstdlib>
+#include <cstdio>
 #include <iomanip>
+#include <limits>
+#include <algorithm>
+#include <cctype>
+#include <cmath>
 
 dpps::Writer_DXF_R12::~Writer_DXF_R12 () {
     if (open)
@@ -226,12 +231,12 @@ $MIRRTEXT\n 70\n     0\n  9\n$DRAGMODE\n 70\n     2\n  9\n$LTSCALE\n 40\n1.0\
 \n0.0\n 30\n0.0\n  3\n$MODEL_SPACE\n  1\n\n  0\nENDBLK\n  5\n21\n  8\n0\n  0\
 \nBLOCK\n 67\n     1\n  8\n0\n  2\n$PAPER_SPACE\n 70\n     0\n 10\n0.0\n 20\
 \n0.0\n 30\n0.0\n  3\n"
-<< "$PAPER_SPACE\n  1\n\n  0\nENDBLK\n  5\n5B\n 67\n     1\n  8\n0\n  0\nENDSEC\
-\n  0\nSECTION\n  2\nENTITIES\n  0\n" ;
+<< "$PAPER_SPACE\n  1\n\n  0\nENDBLK\n  5\n5B\n 67\n     1\n  8\n0\n  0\n"
+<< blocks_buffer << "ENDSEC\n  0\nSECTION\n  2\nENTITIES\n  0\n" ;
 }
 
 void dpps::Writer_DXF_R12::write_footer () {
-    tmpfile << "ENDSEC\n  0\nEOF\n" ;
+    output_buffer += "ENDSEC\n  0\nEOF\n" ;
 }
 
 void dpps::Writer_DXF_R12::set_all_parametres (
@@ -278,8 +283,12 @@ dot_dxf_export can value 0 (dot_as_dot), 1 (dot_as_polyline), 2 \
 }
 
 void dpps::Writer_DXF_R12::write_Polyline (const Polyline &polyline) {
-    long_unsigned_int layer_number {
-        std::min (polyline. reference, layer_names. size ()-1)} ;
+    write_dxf_entities (polyline,
+        std::min (polyline. reference, layer_names. size ()-1)) ;
+}
+
+void dpps::Writer_DXF_R12::write_dxf_entities (const Polyline &polyline,
+    const long_unsigned_int layer_number) {
     if ((polyline. vertices. size () == 1) &&
         (writer_settings. dot_dxf_export == dot_as_dot))
         write_dxf_point (polyline. vertices. front (). x,
@@ -367,6 +376,10 @@ void dpps::Writer_DXF_R12::set_two_point_line_as_polyline (const bool two_point_
     writer_settings. two_point_line_as_polyline = two_point_line_as_polyline ;
 }
 
+void dpps::Writer_DXF_R12::set_instances_as_blocks (const bool instances_as_blocks) {
+    writer_settings. instances_as_blocks = instances_as_blocks ;
+}
+
 void dpps::Writer_DXF_R12::set_layer_colours (const std::string &layer_colour_parametre) {
     if (!layers_set) {
             std::string reason {"Writer_DXF_R12::set_all_parametres, colours \
@@ -396,93 +409,246 @@ are not enough for all layers"} ;
 // dpps::Writer_DXF_R12:: Class-specific methods //
 ///////////////////////////////////////////////////
 
+void dpps::Writer_DXF_R12::append_number (const double x) {
+    char number[32] ;
+    int length {snprintf (number, sizeof (number), "%.*g", precision,
+                          rounding_zero (x))} ;
+    // snprintf follows the C locale, which may have been changed to one
+    // using a decimal comma. std::ostream does not.
+    for (int i {0} ; i < length ; i++)
+        if (number[i] == ',')
+            number[i] = '.' ;
+    output_buffer. append (number, length) ;
+}
+
+void dpps::Writer_DXF_R12::append_handle () {
+    char number[32] ;
+    int length {snprintf (number, sizeof (number), "%llx",
+                          static_cast<unsigned long long> (handle))} ;
+    output_buffer. append (number, length) ;
+    handle++ ;
+}
+
+const std::string &dpps::Writer_DXF_R12::layer_name (
+    const long_unsigned_int layer_number) const {
+    static const std::string layer_zero {"0"} ;
+    if (layer_number < layer_names. size())
+        return layer_names[layer_number] ;
+    return layer_zero ;
+}
+
 void dpps::Writer_DXF_R12::write_dxf_circle (const double x,
      const double y,
      const double radius,
      const long_unsigned_int layer_number) {
-    std::string name {"0"};
-    if (layer_number < layer_names. size())
-        name = layer_names. at (layer_number) ;
     // there is a 0 only in the end.
-    tmpfile << "CIRCLE\n  5\n" << std::hex << handle
-         << "\n  8\n" << name
-         << std::setprecision (precision)
-         << "\n 10\n" << rounding_zero (x) << "\n 20\n" << rounding_zero (y) << "\n 30\n0.0"
-         << "\n 40\n" << rounding_zero (radius) << "\n  0\n" ;
-    handle++ ;
+    output_buffer += "CIRCLE\n  5\n" ;
+    append_handle () ;
+    output_buffer += "\n  8\n" ;
+    output_buffer += layer_name (layer_number) ;
+    output_buffer += "\n 10\n" ;
+    append_number (x) ;
+    output_buffer += "\n 20\n" ;
+    append_number (y) ;
+    output_buffer += "\n 30\n0.0\n 40\n" ;
+    append_number (radius) ;
+    output_buffer += "\n  0\n" ;
 }
 
 void dpps::Writer_DXF_R12::write_dxf_point (const double x,
      const double y,
      const long_unsigned_int layer_number) {
     // there is a 0 only in the end.
-    std::string name {"0"};
-    if (layer_number < layer_names. size())
-        name = layer_names. at (layer_number) ;
-    tmpfile << "POINT\n  5\n" << std::hex << handle
-         << "\n  8\n" << name
-         << std::setprecision (precision)
-         << "\n 10\n" << rounding_zero (x) << "\n 20\n" << rounding_zero (y) << "\n 30\n0.0\n  0\n" ;
-    handle++ ;
+    output_buffer += "POINT\n  5\n" ;
+    append_handle () ;
+    output_buffer += "\n  8\n" ;
+    output_buffer += layer_name (layer_number) ;
+    output_buffer += "\n 10\n" ;
+    append_number (x) ;
+    output_buffer += "\n 20\n" ;
+    append_number (y) ;
+    output_buffer += "\n 30\n0.0\n  0\n" ;
 }
 
 void dpps::Writer_DXF_R12::write_dxf_line (
     const double x1, const double y1,
     const double x2, const double y2,
     const long_unsigned_int layer_number) {
-    std::string name {"0"};
-    if (layer_number < layer_names. size())
-        name = layer_names. at (layer_number) ;
-    tmpfile << "LINE\n  5\n" << std::hex << handle
-         << "\n  8\n" << name
-         << std::setprecision (precision)
-         << "\n 10\n" << rounding_zero (x1) << "\n 20\n" << rounding_zero (y1) << "\n 30\n0.0"
-         << "\n 11\n" << rounding_zero (x2) << "\n 21\n" << rounding_zero (y2) << "\n 31\n0.0\n  0\n" ;
-    handle++ ;
+    output_buffer += "LINE\n  5\n" ;
+    append_handle () ;
+    output_buffer += "\n  8\n" ;
+    output_buffer += layer_name (layer_number) ;
+    output_buffer += "\n 10\n" ;
+    append_number (x1) ;
+    output_buffer += "\n 20\n" ;
+    append_number (y1) ;
+    output_buffer += "\n 30\n0.0\n 11\n" ;
+    append_number (x2) ;
+    output_buffer += "\n 21\n" ;
+    append_number (y2) ;
+    output_buffer += "\n 31\n0.0\n  0\n" ;
 }
 
 void dpps::Writer_DXF_R12::write_dxf_polyline_header (
     const bool closed, const long_unsigned_int layer_number) {
   // adds the header for a closed (70 1) polyline.
   // user must then add vertices and finish the line with a seqend.
-    std::string name {"0"};
-    if (layer_number < layer_names. size())
-        name = layer_names. at (layer_number) ;
-  tmpfile << "POLYLINE\n  5\n" << std::hex << handle
-       << "\n  8\n" << name
-       << "\n 66\n     1\n 10\n0.0\n 20\n0.0\n 30\n0.0\n 70\n     "
-       << (closed ? '1':'0') << "\n  0\n" ;
-  handle++ ;
+    output_buffer += "POLYLINE\n  5\n" ;
+    append_handle () ;
+    output_buffer += "\n  8\n" ;
+    output_buffer += layer_name (layer_number) ;
+    output_buffer += "\n 66\n     1\n 10\n0.0\n 20\n0.0\n 30\n0.0\n 70\n     " ;
+    output_buffer += (closed ? '1':'0') ;
+    output_buffer += "\n  0\n" ;
 }
 
 void dpps::Writer_DXF_R12::write_dxf_vertex (
     const double x, const double y,
     const long_unsigned_int layer_number) {
-    std::string name {"0"};
-    if (layer_number < layer_names. size())
-        name = layer_names. at (layer_number) ;
-  tmpfile << "VERTEX\n  5\n" << std::hex << handle
-       << "\n  8\n" << name
-       << std::setprecision (precision)
-       << "\n 10\n" << rounding_zero (x) << "\n 20\n" << rounding_zero (y) << "\n 30\n0.0\n  0\n" ;
-  handle++ ;
+    output_buffer += "VERTEX\n  5\n" ;
+    append_handle () ;
+    output_buffer += "\n  8\n" ;
+    output_buffer += layer_name (layer_number) ;
+    output_buffer += "\n 10\n" ;
+    append_number (x) ;
+    output_buffer += "\n 20\n" ;
+    append_number (y) ;
+    output_buffer += "\n 30\n0.0\n  0\n" ;
 }
 
 void dpps::Writer_DXF_R12::write_dxf_seqend (
     const long_unsigned_int layer_number) {
-    std::string name {"0"};
-    if (layer_number < layer_names. size())
-        name = layer_names. at (layer_number) ;
-  tmpfile << "SEQEND\n  5\n" << std::hex << handle ;
-  tmpfile << "\n  8\n" << name
-       << "\n  0\n" ;
-  handle++ ;
+    output_buffer += "SEQEND\n  5\n" ;
+    append_handle () ;
+    output_buffer += "\n  8\n" ;
+    output_buffer += layer_name (layer_number) ;
+    output_buffer += "\n  0\n" ;
+}
+
+void dpps::Writer_DXF_R12::write_dxf_insert (
+    const Pattern::Instance &instance,
+    const std::string &name,
+    const long_unsigned_int layer_number) {
+    output_buffer += "INSERT\n  5\n" ;
+    append_handle () ;
+    output_buffer += "\n  8\n" ;
+    output_buffer += layer_name (layer_number) ;
+    output_buffer += "\n  2\n" ;
+    output_buffer += name ;
+    output_buffer += "\n 10\n" ;
+    append_number (instance. position. x) ;
+    output_buffer += "\n 20\n" ;
+    append_number (instance. position. y) ;
+    output_buffer += "\n 30\n0.0\n 41\n" ;
+    append_number (instance. scale) ;
+    output_buffer += "\n 42\n" ;
+    append_number (instance. scale) ;
+    output_buffer += "\n 43\n" ;
+    append_number (instance. scale) ;
+    output_buffer += "\n 50\n" ;
+    append_number (instance. angle * 180.0 / M_PI) ;
+    output_buffer += "\n  0\n" ;
+}
+
+std::string dpps::Writer_DXF_R12::unique_block_name (const std::string &name) {
+    // Symbol names of DXF R12 are made of upper case letters, digits, and
+    // the characters $, - and _.
+    std::string base ;
+    for (auto c: name)
+        if (isalnum (static_cast<unsigned char> (c)) ||
+            (c == '$') || (c == '-') || (c == '_'))
+            base += toupper (static_cast<unsigned char> (c)) ;
+        else
+            base += '_' ;
+    if (base. empty ())
+        base = "CELL" ;
+    std::string result {base} ;
+    for (long_unsigned_int i {1} ;
+         used_block_names. find (result) != used_block_names. end () ; i++)
+        result = base + "_" + std::to_string (i) ;
+    used_block_names. insert (result) ;
+    return result ;
+}
+
+const std::string &dpps::Writer_DXF_R12::block_name (const Pattern &pattern,
+    const long_unsigned_int cell,
+    const bool on_layer_zero) {
+    std::pair<long_unsigned_int, bool> key {cell, on_layer_zero} ;
+    auto found = block_names. find (key) ;
+    if (found != block_names. end ())
+        return found-> second ;
+    const Pattern::Cell &c = pattern. cells[cell] ;
+    // The blocks of the instances are written first, as blocks cannot be
+    // written inside one another. The entities of a block on layer 0 take
+    // the layer of the INSERT, so that the blocks it refers to must also
+    // be on layer 0.
+    std::vector<const std::string *> names ;
+    for (auto &i: c. instances)
+        names. push_back (&block_name (pattern, i. cell,
+                                       on_layer_zero || i. override_properties)) ;
+    std::string name {unique_block_name (c. name + (on_layer_zero ? "$0" : ""))} ;
+    // layer_name() gives 0 for this number
+    long_unsigned_int layer_zero {layer_names. size ()} ;
+    std::swap (output_buffer, blocks_buffer) ;
+    output_buffer += "BLOCK\n  8\n0\n  2\n" ;
+    output_buffer += name ;
+    output_buffer += "\n 70\n     0\n 10\n0.0\n 20\n0.0\n 30\n0.0\n  3\n" ;
+    output_buffer += name ;
+    output_buffer += "\n  1\n\n  0\n" ;
+    // the reference &p is used to avoid copy
+    for (auto &p: c. polylines)
+        write_dxf_entities (p, on_layer_zero ? layer_zero :
+            std::min (p. reference, layer_names. size ()-1)) ;
+    for (long_unsigned_int i {0} ; i < c. instances. size () ; i++)
+        write_dxf_insert (c. instances[i], *names[i], on_layer_zero ?
+            layer_zero : std::min (c. instances[i]. properties. reference,
+                                   layer_names. size ()-1)) ;
+    output_buffer += "ENDBLK\n  5\n" ;
+    append_handle () ;
+    output_buffer += "\n  8\n0\n  0\n" ;
+    std::swap (output_buffer, blocks_buffer) ;
+    return block_names. insert (std::make_pair (key, name)). first-> second ;
+}
+
+void dpps::Writer_DXF_R12::write_instances (const Pattern &pattern,
+                                            const selection_t selection) {
+    if (!writer_settings. instances_as_blocks) {
+        Writer::write_instances (pattern, selection) ;
+        return ;
+    }
+check_selection_not_too_high(selection) ;
+    // the cell numbers only refer to the cells of this pattern
+    block_names. clear () ;
+    for (auto &i: pattern. instances)
+        if ((selection < 0) || i. properties. selected[selection])
+            write_dxf_insert (i, block_name (pattern, i. cell,
+                                             i. override_properties),
+                std::min (i. properties. reference, layer_names. size ()-1)) ;
+}
+
+void dpps::Writer_DXF_R12::set_limits (const Pattern &pattern,
+                                       const selection_t selection) {
+    lower_left = pattern. lower_left (selection) ;
+    upper_right = pattern. upper_right (selection) ;
+    Vertex min, max ;
+    if (pattern. instances_limits (min, max, selection)) {
+        if (pattern. size (selection) == 0) {
+            lower_left = min ;
+            upper_right = max ;
+        } else {
+            lower_left = Vertex (std::min (lower_left. x, min. x),
+                                 std::min (lower_left. y, min. y)) ;
+            upper_right = Vertex (std::max (upper_right. x, max. x),
+                                  std::max (upper_right. y, max. y)) ;
+        }
+    }
+    lower_left = lower_left * 1.05 ;
+    upper_right = upper_right * 1.05 ;
 }
 
 void dpps::Writer_DXF_R12::write_Pattern_selected (const Pattern &pattern,
                                                  const selection_t selection) {
-    lower_left = pattern. lower_left(selection) * 1.05 ;
-    upper_right = pattern. upper_right(selection) * 1.05 ;
+    set_limits (pattern, selection) ;
 
     if (!layers_set)
         set_layer_names (default_layer_name) ;
@@ -494,12 +660,11 @@ void dpps::Writer_DXF_R12::write_Pattern_selected (const Pattern &pattern,
     // to (max_handle - 1)
     //max_handle = min_handle + pattern. vertices_size (selection) +
     //             + (2 * pattern. size (selection)) ;
-    Writer::write_Pattern_selected (pattern) ;
+    Writer::write_Pattern_selected (pattern, selection) ;
 }
 
 void dpps::Writer_DXF_R12::write_Pattern (const Pattern &pattern) {
-    lower_left = pattern. lower_left(-1) * 1.05 ;
-    upper_right = pattern. upper_right(-1) * 1.05 ;
+    set_limits (pattern, -1) ;
     //max_handle = min_handle + pattern. vertices_size (-1) +
     //             + (2 * pattern. size (-1)) ;
     if (!layers_set)
@@ -509,27 +674,59 @@ void dpps::Writer_DXF_R12::write_Pattern (const Pattern &pattern) {
     Writer::write_Pattern (pattern) ;
 }
 
-void dpps::Writer_DXF_R12::close () {
-    tmpfile. close () ;
-    if (tmpfile. bad()) {
-        std::string reason {"Writer: tmpfile " + tmpfilename +
-                            " could not be closed"} ;
-        throw bad_io (reason. c_str ()) ;
+void dpps::Writer_DXF_R12::begin_stream () {
+    if (!layers_set)
+        set_layer_names (default_layer_name) ;
+    if (!colours_set)
+        set_layer_colours ("") ;
+    stream_lower_left = Vertex (std::numeric_limits<double>::max (),
+                                std::numeric_limits<double>::max ()) ;
+    stream_upper_right = Vertex (std::numeric_limits<double>::lowest (),
+                                 std::numeric_limits<double>::lowest ()) ;
+    stream_lower_left_found = false ;
+    stream_upper_right_found = false ;
+    Writer::begin_stream () ;
+}
+
+void dpps::Writer_DXF_R12::write_Polyline_stream (const Polyline &polyline) {
+    double temporary_value ;
+    if ((temporary_value = polyline. minimum_x ()) < stream_lower_left. x) {
+        stream_lower_left_found = true ;
+        stream_lower_left. x = temporary_value ;
+    }
+    stream_lower_left. y = std::min (stream_lower_left. y,
+                                     polyline. minimum_y ()) ;
+    if ((temporary_value = polyline. maximum_x ()) > stream_upper_right. x) {
+        stream_upper_right_found = true ;
+        stream_upper_right. x = temporary_value ;
     }
+    stream_upper_right. y = std::max (stream_upper_right. y,
+                                      polyline. maximum_y ()) ;
+    write_Polyline (polyline) ;
+}
+
+void dpps::Writer_DXF_R12::end_stream () {
+    // Same as in write_Pattern(), where the bounding box is known first.
+    lower_left = (stream_lower_left_found ?
+                  stream_lower_left : Vertex (0.0, 0.0)) * 1.05 ;
+    upper_right = (stream_upper_right_found ?
+                   stream_upper_right : Vertex (0.0, 0.0)) * 1.05 ;
+    Writer::end_stream () ;
+}
+
+void dpps::Writer_DXF_R12::close () {
     if (layers_set) { // We can only go there if user set the layers.
         // in case user just invoked the two-argument constructor and
         // the instance is destroyed, there is no point in writing the final
         // file, and we cannot call write_final_header() as we don't have a
         // layer list.
         write_final_header () ;
-        std::ifstream tmpfile_readonly (tmpfilename, std::ios::in) ;
-        file << tmpfile_readonly. rdbuf() ;
-        tmpfile_readonly. close () ;
-        if (tmpfile_readonly. bad()) {
-            std::string reason {"Writer: tmpfile_readonly " + tmpfilename +
-                                " could not be closed"} ;
-            throw bad_io (reason. c_str ()) ;
-        }
+        file. write (output_buffer. data (), output_buffer. size ()) ;
     }
+    // swap with an empty string to release the memory
+    std::string (). swap (output_buffer) ;
+    std::string (). swap (blocks_buffer) ;
+    block_names. clear () ;
+    used_block_names. clear () ;
     Writer::close() ;
 }
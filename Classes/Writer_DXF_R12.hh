@@ -34,6 +34,9 @@
 #define DPPS_WRITER_DXF_R12
 
 #include <array>
+#include <map>
+#include <set>
+#include <utility>
 
 #include "Writer.hh"
 #include "Pattern.hh"
@@ -82,6 +85,18 @@ public:
          */
         double julian_date {0.0} ;
         std::string layer_name_parametre {"dpps"} ;
+
+        /** @brief Whether the instances of patterns are written as INSERT
+         * entities referring to a BLOCK for each cell, instead of the
+         * polylines they draw.
+         *
+         * The entities of a block are on the layers of the polylines of the
+         * cell. When the instance overrides the properties of its polylines
+         * (Pattern::Instance), they are on layer 0 of another block, so that
+         * they take the layer of the INSERT. Dots written as circles then
+         * take their radius from the dose of the cell, not of the instance.
+         */
+        bool instances_as_blocks {false} ;
     };
 protected:
     //std::array<double, 4> coordinates {{0., 0., 0., 0.}} ;
@@ -90,6 +105,12 @@ protected:
 
     Vertex lower_left, upper_right ;
 
+    /** @brief bounding box of the polylines written since begin_stream(),
+     * computed as Pattern::lower_left() and Pattern::upper_right() do. */
+    Vertex stream_lower_left, stream_upper_right ;
+    bool stream_lower_left_found {false} ;
+    bool stream_upper_right_found {false} ;
+
     std::vector<std::string> layer_names ;
 
     std::vector<int> layer_colours ;
@@ -104,6 +125,39 @@ protected:
 
     Writer_DXF_R12_settings writer_settings ;
 
+    /** @brief the entities are formatted into this buffer, which is written
+     * to file after the header by close(), as the header depends on all the
+     * entities.
+     *
+     * This avoids the formatting machinery of std::ostream, which dominated
+     * the time spent writing large files. For the same reason, Writer::body
+     * is not used. */
+    std::string output_buffer ;
+
+    /** @brief The BLOCK entities, which are written in the BLOCKS section of
+     * the header. */
+    std::string blocks_buffer ;
+
+    /** @brief the names of the blocks written for the cells of the pattern
+     * being written, for each cell number and whether the entities are on
+     * layer 0. */
+    std::map<std::pair<long_unsigned_int, bool>, std::string> block_names ;
+
+    /** @brief the names of all the blocks of the file. */
+    std::set<std::string> used_block_names ;
+
+    /** @brief appends x to output_buffer as file << std::setprecision
+     * (precision) << x would, with values below 0.001 written as 0. */
+    void append_number (const double x) ;
+
+    /** @brief appends handle to output_buffer in hexadecimal, then
+     * increments it. */
+    void append_handle () ;
+
+    /** @brief returns the name of layer_number, or "0" if there is no such
+     * layer. */
+    const std::string &layer_name (const long_unsigned_int layer_number) const ;
+
     void write_dxf_polyline_header (const bool closed,
                                     const long_unsigned_int layer_number) ;
 
@@ -122,6 +176,32 @@ protected:
         const double x2, const double y2,
         const long_unsigned_int layer_number) ;
     void write_final_header () ;
+
+    /** @brief writes polyline as POINT, CIRCLE, LINE or POLYLINE entities
+     * on layer number layer_number, as write_Polyline() does. */
+    void write_dxf_entities (const Polyline &polyline,
+                             const long_unsigned_int layer_number) ;
+
+    void write_dxf_insert (const Pattern::Instance &instance,
+                           const std::string &name,
+                           const long_unsigned_int layer_number) ;
+
+    /** @brief returns the name of the block of cell number cell of pattern,
+     * with its entities on layer 0 if on_layer_zero is true, after writing
+     * it to blocks_buffer if needed. */
+    const std::string &block_name (const Pattern &pattern,
+                                   const long_unsigned_int cell,
+                                   const bool on_layer_zero) ;
+
+    /** @brief returns a block name made from name which is not used yet. */
+    std::string unique_block_name (const std::string &name) ;
+
+    /** @brief sets lower_left and upper_right from the polylines and the
+     * instances of pattern. */
+    void set_limits (const Pattern &pattern, const selection_t selection) ;
+
+    void write_instances (const Pattern &pattern,
+                          const selection_t selection) ;
 public:
     ~Writer_DXF_R12 () ;
     static const long_unsigned_int min_handle {581} ;
@@ -151,6 +231,9 @@ public:
     void write_Pattern (const Pattern &pattern) ;
     void write_Pattern_selected (const Pattern &pattern, const selection_t selection = 0) ;
     void write_footer () ;
+    void begin_stream () ;
+    void write_Polyline_stream (const Polyline &polyline) ;
+    void end_stream () ;
     void set_parametres (const std::vector<bool> &vbool,
                          const std::vector<long_unsigned_int> &vint,
                          const std::vector<double> &vdouble,
@@ -163,6 +246,7 @@ public:
     void set_dot_dxf_export (const enum_dot_dxf_export dot_dxf_export) ;
     void set_two_point_line_as_polyline (const bool two_point_line_as_polyline) ;
     void set_layer_colours (const std::string &layer_colour_parametre) ;
+    void set_instances_as_blocks (const bool instances_as_blocks) ;
 
     void set_all_parametres (
         //const bool dot_as_polyline,
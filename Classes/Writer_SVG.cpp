@@ -11,13 +11,21 @@
  *
  * The file \c SVG_witer.cp contains one derived class to write simple SVG
  * files implementing Polyline elemnt as <Path> with commands M (absolute
- * coordinates) and Z (for closed lines).
+ * coordinates) and Z (for closed lines), or in compact mode M then l
+ * (relative coordinates) and z.
  * */
 
+#include <algorithm>
+#include <cmath>
+#include <cstdio>
+#include <limits>
+
 #include "Writer_SVG.hh"
 #include "bad_parametre.hh"
 #include "bad_io.hh"
 
+const long_unsigned_int dpps::Writer_SVG::buffer_size ;
+
 dpps::Writer_SVG::Writer_SVG (
     const std::string &set_filename,
     const bool append): Writer (set_filename, append) {}
@@ -34,21 +42,174 @@ dpps::Writer_SVG::Writer_SVG (
     set_all_parametres (minx, miny, maxx, maxy, style) ;
     }
 
+dpps::Writer_SVG::~Writer_SVG () {
+    if (open)
+        close () ;
+}
+
+void dpps::Writer_SVG::close () {
+    flush_buffer (true) ;
+    // swap with an empty string to release the memory
+    std::string (). swap (output_buffer) ;
+    std::vector<uint32_t> (). swap (density) ;
+    Writer::close () ;
+}
+
+void dpps::Writer_SVG::flush_buffer (const bool force) {
+    if ((!force) && (output_buffer. size () < buffer_size))
+        return ;
+    file. write (output_buffer. data (), output_buffer. size ()) ;
+    output_buffer. clear () ;
+}
+
+void dpps::Writer_SVG::append_number (const double x) {
+    char number[32] ;
+    // %g is the default format of std::ostream for doubles.
+    int length {snprintf (number, sizeof (number), "%g", x)} ;
+    // snprintf follows the C locale, which may have been changed to one
+    // using a decimal comma. std::ostream does not.
+    for (int i {0} ; i < length ; i++)
+        if (number[i] == ',')
+            number[i] = '.' ;
+    output_buffer. append (number, length) ;
+}
+
+void dpps::Writer_SVG::append_fixed (long long int steps) {
+    if (steps < 0)
+        output_buffer += '-' ;
+    unsigned long long int magnitude {steps < 0 ?
+        0ULL - static_cast<unsigned long long int> (steps) :
+        static_cast<unsigned long long int> (steps)} ;
+    unsigned long long int power {1} ;
+    for (long_unsigned_int i {0} ; i < writer_settings. decimals ; i++)
+        power *= 10 ;
+    char number[32] ;
+    int length {snprintf (number, sizeof (number), "%llu",
+                          magnitude / power)} ;
+    output_buffer. append (number, length) ;
+    if (magnitude % power == 0)
+        return ;
+    length = snprintf (number, sizeof (number), "%0*llu",
+                       static_cast<int> (writer_settings. decimals),
+                       magnitude % power) ;
+    while (number[length - 1] == '0')
+        length-- ;
+    output_buffer += '.' ;
+    output_buffer. append (number, length) ;
+}
+
 void dpps::Writer_SVG::write_header () {
-    file << "<?xml version=\"1.0\" encoding=\"UTF-8\" standalone=\"no\"?>"
-         << std::endl << "<svg xmlns:svg=\"http://www.w3.org/2000/svg\""
-         << std::endl << "xmlns=\"http://www.w3.org/2000/svg\""
-         << std::endl << "version=\"1.1\"" << std::endl << "viewBox=\""
-         << writer_settings. view_box [0] << ' '
-         << writer_settings. view_box [1] << ' '
-         << writer_settings. view_box [2] << ' '
-         << writer_settings. view_box [3] << '\"' << std::endl
-         << "id=\"svg2\">" << std::endl
-         << "<g id = \"Design\" style=\""
-         << writer_settings. style << "\">" << std::endl ;
+    output_buffer += "<?xml version=\"1.0\" encoding=\"UTF-8\" standalone=\"no\"?>"
+                     "\n<svg xmlns:svg=\"http://www.w3.org/2000/svg\""
+                     "\nxmlns=\"http://www.w3.org/2000/svg\""
+                     "\nversion=\"1.1\"\nviewBox=\"" ;
+    for (short unsigned int i {0} ; i < 4 ; i++) {
+        append_number (writer_settings. view_box [i]) ;
+        output_buffer += (i < 3 ? " " : "\"\n") ;
+    }
+    output_buffer += "id=\"svg2\">\n<g id = \"Design\" style=\"" ;
+    output_buffer += writer_settings. style ;
+    output_buffer += "\">\n" ;
+    pixel_size = 0.0 ;
+    density. clear () ;
+    if (writer_settings. preview_pixels == 0)
+        return ;
+    double width {writer_settings. view_box [2] - writer_settings. view_box [0]} ;
+    double height {writer_settings. view_box [3] - writer_settings. view_box [1]} ;
+    pixel_size = std::max (width, height) / writer_settings. preview_pixels ;
+    if (!(pixel_size > 0.0) || !std::isfinite (pixel_size)) {
+        pixel_size = 0.0 ;
+        throw bad_parametre ("Writer_SVG::write_header, the preview mode "
+                             "needs a view box with xmax > xmin or ymax > ymin.") ;
+    }
+    density_columns = static_cast<long_unsigned_int> (
+        std::max (1.0, ceil (width / pixel_size))) ;
+    density_rows = static_cast<long_unsigned_int> (
+        std::max (1.0, ceil (height / pixel_size))) ;
 }
+
 void dpps::Writer_SVG::write_footer () {
-    file << "</g>" << std::endl << "</svg>" ;
+    output_buffer += "</g>\n" ;
+    write_density () ;
+    output_buffer += "</svg>" ;
+    flush_buffer (true) ;
+}
+
+bool dpps::Writer_SVG::decimate (const Polyline &polyline) {
+    if (polyline. vertices. empty ())
+        return false ;
+    double minx {std::numeric_limits<double>::max ()} ;
+    double maxx {std::numeric_limits<double>::lowest ()} ;
+    double miny {std::numeric_limits<double>::max ()} ;
+    double maxy {std::numeric_limits<double>::lowest ()} ;
+    // the reference &v is used to avoid copy
+    for (auto &v : polyline. vertices) {
+        minx = std::min (minx, v. x) ;
+        maxx = std::max (maxx, v. x) ;
+        miny = std::min (miny, v. y) ;
+        maxy = std::max (maxy, v. y) ;
+    }
+    if ((maxx - minx >= pixel_size) || (maxy - miny >= pixel_size))
+        return false ;
+    if (!writer_settings. density_raster)
+        return true ;
+    double column {floor (((minx + maxx) / 2.0 - writer_settings. view_box [0]) /
+                          pixel_size)} ;
+    double row {floor (((miny + maxy) / 2.0 - writer_settings. view_box [1]) /
+                       pixel_size)} ;
+    // Outside of the view box, it would not be seen anyway.
+    if ((column < 0.0) || (column >= density_columns) ||
+        (row < 0.0) || (row >= density_rows))
+        return true ;
+    if (density. empty ())
+        density. assign (density_columns * density_rows, 0) ;
+    uint32_t &count = density[static_cast<long_unsigned_int> (row) *
+                              density_columns +
+                              static_cast<long_unsigned_int> (column)] ;
+    if (count < std::numeric_limits<uint32_t>::max ())
+        count++ ;
+    return true ;
+}
+
+void dpps::Writer_SVG::write_density () {
+    if (density. empty ())
+        return ;
+    // The opacity of a pixel is its count relative to the largest one, in
+    // levels steps, at least one step so that no pixel disappears.
+    const uint32_t levels {16} ;
+    uint32_t largest {*std::max_element (density. begin (), density. end ())} ;
+    output_buffer += "<g id = \"Density\" style=\"fill:#000000;stroke:none\">\n" ;
+    for (long_unsigned_int row {0} ; row < density_rows ; row++) {
+        long_unsigned_int column {0} ;
+        while (column < density_columns) {
+            uint32_t count {density[row * density_columns + column]} ;
+            uint32_t level {static_cast<uint32_t> (
+                ceil (static_cast<double> (levels) * count / largest))} ;
+            long_unsigned_int end {column + 1} ;
+            while ((end < density_columns) &&
+                   (static_cast<uint32_t> (ceil (static_cast<double> (levels) *
+                        density[row * density_columns + end] / largest)) ==
+                    level))
+                end++ ;
+            if (level > 0) {
+                output_buffer += "<rect x=\"" ;
+                append_number (writer_settings. view_box [0] +
+                               column * pixel_size) ;
+                output_buffer += "\" y=\"" ;
+                append_number (writer_settings. view_box [1] + row * pixel_size) ;
+                output_buffer += "\" width=\"" ;
+                append_number ((end - column) * pixel_size) ;
+                output_buffer += "\" height=\"" ;
+                append_number (pixel_size) ;
+                output_buffer += "\" fill-opacity=\"" ;
+                append_number (static_cast<double> (level) / levels) ;
+                output_buffer += "\"/>\n" ;
+            }
+            column = end ;
+            flush_buffer (false) ;
+        }
+    }
+    output_buffer += "</g>\n" ;
 }
 
 void dpps::Writer_SVG::set_all_parametres (
@@ -62,12 +223,41 @@ void dpps::Writer_SVG::set_all_parametres (
     writer_settings. style = style ;
 }
 
+void dpps::Writer_SVG::set_compact (const bool compact,
+                                    const long_unsigned_int decimals) {
+    // 10^9 steps keep coordinates of 10^9 exact in a long long int.
+    if (decimals > 9) {
+        std::string reason {"Writer_SVG::set_compact, decimals must be 9 or "
+                            "less, but it is " + std::to_string (decimals)} ;
+        throw bad_parametre (reason. c_str ()) ;
+    }
+    writer_settings. compact = compact ;
+    writer_settings. decimals = decimals ;
+}
+
+void dpps::Writer_SVG::set_preview (const long_unsigned_int preview_pixels,
+                                    const bool density_raster) {
+    if (preview_pixels > 4096) {
+        std::string reason {"Writer_SVG::set_preview, preview_pixels must be "
+                            "4096 or less, but it is " +
+                            std::to_string (preview_pixels)} ;
+        throw bad_parametre (reason. c_str ()) ;
+    }
+    writer_settings. preview_pixels = preview_pixels ;
+    writer_settings. density_raster = density_raster ;
+}
+
 void dpps::Writer_SVG::set_parametres (
                         const std::vector<bool> &vbool,
                         const std::vector<long_unsigned_int> &vint,
                         const std::vector<double> &vdouble,
                         const std::vector<std::string> &vstring) {
-    if ((vbool. size () != 0)   ||
+    // The compact and preview settings are optional.
+    if ((vbool. size () == 2) && (vint. size () == 2) &&
+        (vdouble. size () == 4) && (vstring. size () == 1)) {
+        set_compact (vbool. at (0), vint. at (0)) ;
+        set_preview (vint. at (1), vbool. at (1)) ;
+    } else if ((vbool. size () != 0)   ||
         (vint. size () != 0)    ||
         (vdouble. size () != 4) ||
         (vstring. size () != 1)) {
@@ -80,11 +270,50 @@ void dpps::Writer_SVG::set_parametres (
 }
 
 void dpps::Writer_SVG::write_Polyline (const Polyline &polyline) {
-    file << "<path d=\"M " ;
-    // the reference &v is used to avoid copy
-    for (auto &v : polyline. vertices)
-        file << v. x << "," << v. y << " " ;
-    file << (polyline. closed? "Z":"") << "\" id=\"p"
-         << path_id << "\"/>" << std::endl ;
+    if ((pixel_size > 0.0) && decimate (polyline))
+        return ;
+    if (!writer_settings. compact) {
+        output_buffer += "<path d=\"M " ;
+        // the reference &v is used to avoid copy
+        for (auto &v : polyline. vertices) {
+            append_number (v. x) ;
+            output_buffer += ',' ;
+            append_number (v. y) ;
+            output_buffer += ' ' ;
+        }
+        output_buffer += (polyline. closed? "Z\" id=\"p":"\" id=\"p") ;
+        output_buffer += std::to_string (path_id) ;
+        output_buffer += "\"/>\n" ;
+    } else {
+        // The differences are taken between the rounded coordinates, so that
+        // the rounding errors do not add up along the path.
+        double scale {pow (10.0, writer_settings. decimals)} ;
+        long long int previous_x {0}, previous_y {0} ;
+        bool first {true} ;
+        bool relative {false} ;
+        output_buffer += "<path d=\"" ;
+        // the reference &v is used to avoid copy
+        for (auto &v : polyline. vertices) {
+            long long int x {llround (v. x * scale)} ;
+            long long int y {llround (v. y * scale)} ;
+            if (first) {
+                output_buffer += 'M' ;
+                append_fixed (x) ;
+                output_buffer += ',' ;
+                append_fixed (y) ;
+                first = false ;
+            } else if ((x != previous_x) || (y != previous_y)) {
+                output_buffer += (relative ? ' ' : 'l') ;
+                append_fixed (x - previous_x) ;
+                output_buffer += ',' ;
+                append_fixed (y - previous_y) ;
+                relative = true ;
+            }
+            previous_x = x ;
+            previous_y = y ;
+        }
+        output_buffer += (polyline. closed? "z\"/>\n":"\"/>\n") ;
+    }
     path_id++ ;
+    flush_buffer (false) ;
 }
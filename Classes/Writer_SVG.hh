@@ -14,6 +14,9 @@
 #define DPPS_WRITER_SVG
 
 #include <array>
+#include <cstdint>
+#include <string>
+#include <vector>
 
 #include "Writer.hh"
 
@@ -32,6 +35,11 @@ namespace dpps {
  * to write the polylines of the design. Note that the choice of using Writer
  * classes that support only the writing of polylines (and not group elements
  * or layer tags) is not ver well suited to this objective.
+ *
+ * The file is formatted in a buffer written in large blocks. For previews of
+ * large patterns, the compact mode writes relative coordinates rounded to a
+ * number of decimals, and the preview mode draws the polylines smaller than a
+ * pixel of the view box as a density raster, or drops them.
  */
 class Writer_SVG: public Writer {
 public:
@@ -50,6 +58,23 @@ stroke-linecap:butt;stroke-linejoin:bevel;stroke-opacity:1" ;
          */
         std::array<double, 4> view_box {{0., 0., 0., 0.}} ;
 
+        /** @brief Whether the paths are written with relative coordinates
+         * rounded to decimals places, and without id. By default, they are
+         * written with absolute coordinates of 6 significant digits. */
+        bool compact {false} ;
+
+        /** @brief The number of decimal places of the compact mode. */
+        long_unsigned_int decimals {3} ;
+
+        /** @brief The number of pixels on the longer side of the view box for
+         * the preview mode, or 0 to write all the polylines as paths. */
+        long_unsigned_int preview_pixels {0} ;
+
+        /** @brief Whether the polylines smaller than a pixel are counted in a
+         * density raster, drawn as rectangles whose opacity grows with their
+         * number, or dropped. Used only if preview_pixels is not 0. */
+        bool density_raster {true} ;
+
         /* @brief Whether to use the CAD convention (origin at lower-left,
          * Y increasing to the top) or the Image convention (origin at top-left,
          * Y increasing to the bottom). */
@@ -70,7 +95,44 @@ stroke-linecap:butt;stroke-linejoin:bevel;stroke-opacity:1" ;
 protected:
     Writer_SVG_settings writer_settings ;
     long_unsigned_int path_id {0} ;
+
+    /** @brief the file is formatted into this buffer, which is written to
+     * file when it exceeds buffer_size, and by write_footer(). */
+    std::string output_buffer ;
+
+    /** @brief the number of polylines smaller than a pixel in each pixel,
+     * row by row, allocated by the first one. */
+    std::vector<uint32_t> density ;
+
+    long_unsigned_int density_columns {0} ;
+    long_unsigned_int density_rows {0} ;
+
+    /** @brief the size of a pixel of the preview mode, or 0. */
+    double pixel_size {0.0} ;
+
+    /** @brief writes output_buffer to file if it is larger than buffer_size,
+     * or if force is true. */
+    void flush_buffer (const bool force) ;
+
+    /** @brief appends x to output_buffer as file << x would. */
+    void append_number (const double x) ;
+
+    /** @brief appends steps times 10^-decimals to output_buffer, without
+     * trailing zeros. */
+    void append_fixed (long long int steps) ;
+
+    /** @brief returns true if polyline is smaller than a pixel, after
+     * counting it in density if density_raster is set. */
+    bool decimate (const Polyline &polyline) ;
+
+    /** @brief appends the density raster to output_buffer, merging the
+     * pixels of a row having the same opacity. */
+    void write_density () ;
 public:
+    /** @brief the size above which output_buffer is written to file. */
+    static const long_unsigned_int buffer_size {1 << 20} ;
+
+
     // Implementation of inherited virtual functions.
     //Writer_SVG () ;
     Writer_SVG (const std::string &set_filename, const bool append) ;
@@ -82,8 +144,10 @@ public:
         const double maxx,
         const double maxy,
         const std::string &style) ;
+    ~Writer_SVG () ;
     void write_header () ;
     void write_footer () ;
+    void close () ;
     void set_parametres (const std::vector<bool> &vbool,
                          const std::vector<long_unsigned_int> &vint,
                          const std::vector<double> &vdouble,
@@ -95,6 +159,19 @@ public:
         const double maxx,
         const double maxy,
         const std::string &style) ;
+
+    /** @brief sets the compact mode, with decimals places, or back to the
+     * absolute coordinates if compact is false. Throws bad_parametre if
+     * decimals is more than 9. */
+    void set_compact (const bool compact,
+                      const long_unsigned_int decimals = 3) ;
+
+    /** @brief sets the preview mode for preview_pixels pixels on the longer
+     * side of the view box, or writes all the polylines if it is 0. Throws
+     * bad_parametre if it is more than 4096, and write_header() throws it if
+     * the view box is then empty. */
+    void set_preview (const long_unsigned_int preview_pixels,
+                      const bool density_raster = true) ;
 } ;
 } // namespace dpps
 #endif
\ No newline at end of file
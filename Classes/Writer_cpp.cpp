@@ -52,6 +52,8 @@ std::vector<dpps::Polyline> my_polylines {
  *
  * */
 
+#include <cctype>
+#include <functional>
 #include <utility> // std::pair
 
 #include "Writer_cpp.hh"
@@ -62,7 +64,17 @@ dpps::Writer_cpp::Writer_cpp (
     const std::string &set_filename,
     const bool append): Writer (set_filename, append) {}
 
+dpps::Writer_cpp::~Writer_cpp () {
+    if (open) // set in Writer contructor
+        close () ;
+    // open will be set to false in Writer::close()
+}
+
 void dpps::Writer_cpp::write_header () {
+    if (writer_settings. table) {
+        elements. push_back (packed. size ()) ;
+        return ;
+    }
     if (first)
         file << "{" ;
     else {
@@ -74,17 +86,40 @@ void dpps::Writer_cpp::write_header () {
 //double>>>> output {{" << std::endl ;
 }
 void dpps::Writer_cpp::write_footer () {
+    if (writer_settings. table)
+        return ;
     file << "}\n" ;
     //file << std::endl << "}} ;" << std::endl ;
 }
 
 void dpps::Writer_cpp::set_all_parametres () {}
 
+void dpps::Writer_cpp::set_table (const bool table, const std::string &name) {
+    bool valid {!name. empty () &&
+                !std::isdigit (static_cast<unsigned char> (name[0]))} ;
+    for (char c: name)
+        if (!std::isalnum (static_cast<unsigned char> (c)) && (c != '_'))
+            valid = false ;
+    if (!valid) {
+        std::string reason {"Writer_cpp::set_table, name must be a C++ \
+identifier, but it is \"" + name + "\""} ;
+        throw bad_parametre (reason. c_str ()) ;
+    }
+    writer_settings. table = table ;
+    writer_settings. name = name ;
+}
+
 void dpps::Writer_cpp::set_parametres (
                         const std::vector<bool> &vbool,
                         const std::vector<long_unsigned_int> &vint,
                         const std::vector<double> &vdouble,
                         const std::vector<std::string> &vstring) {
+    // The table mode is optional.
+    if ((vbool. size () == 1) && (vint. size () == 0) &&
+        (vdouble. size () == 0) && (vstring. size () == 1)) {
+        set_table (vbool. at (0), vstring. at (0)) ;
+        return ;
+    }
     if ((vbool. size () != 0)   ||
         (vint. size () != 0)    ||
         (vdouble. size () != 0) ||
@@ -97,6 +132,14 @@ void dpps::Writer_cpp::set_parametres (
 }
 
 void dpps::Writer_cpp::write_Polyline (const Polyline &polyline) {
+    if (writer_settings. table) {
+        // Polylines written without write_header belong to the first
+        // pattern.
+        if (elements. empty ())
+            elements. push_back (0) ;
+        packed. push_back (polyline) ;
+        return ;
+    }
     if (first)
         first = false ;
     else
@@ -110,3 +153,77 @@ void dpps::Writer_cpp::write_Polyline (const Polyline &polyline) {
     }
     file << "}" ;
 }
+
+void dpps::Writer_cpp::close () {
+    if (!writer_settings. table || !file. is_open ()) {
+        Writer::close () ;
+        return ;
+    }
+    const std::string &name {writer_settings. name} ;
+    if (elements. empty ())
+        elements. push_back (0) ;
+    elements. push_back (packed. size ()) ;
+    // Writes values as the elements of a std::array of type, a few per line
+    // so that the lines stay short.
+    auto write_table = [&] (const std::string &type,
+                            const std::string &table,
+                            const long_unsigned_int size,
+                            const std::function<void (long_unsigned_int)> &write) {
+        file << "static constexpr std::array<" << type << ", " << size
+             << "> " << name << "_" << table << " {{" ;
+        for (long_unsigned_int i {0} ; i < size ; i++) {
+            if (i != 0)
+                file << "," ;
+            if (i % 8 == 0)
+                file << "\n    " ;
+            write (i) ;
+        }
+        file << "}} ;\n\n" ;
+    } ;
+    file << "#include <array>\n#include <cstddef>\n#include <utility>\n\n\
+#include \"Pattern.hh\"\n\n" ;
+    file << "// x and y of the vertices of all the polylines\n" ;
+    write_table ("double", "coordinates", 2 * packed. x. size (),
+        [&] (long_unsigned_int i) {
+            file << (i % 2 == 0 ? packed. x[i / 2] : packed. y[i / 2]) ;
+        }) ;
+    file << "// first vertex of each polyline, and number of vertices\n" ;
+    write_table ("std::size_t", "offsets", packed. offsets. size (),
+        [&] (long_unsigned_int i) { file << packed. offsets[i] ; }) ;
+    write_table ("bool", "closed", packed. closed. size (),
+        [&] (long_unsigned_int i) {
+            file << (packed. closed[i] ? "true" : "false") ;
+        }) ;
+    write_table ("double", "dose", packed. dose. size (),
+        [&] (long_unsigned_int i) { file << packed. dose[i] ; }) ;
+    write_table ("long unsigned int", "reference", packed. reference. size (),
+        [&] (long_unsigned_int i) { file << packed. reference[i] ; }) ;
+    file << "// first polyline of each pattern, and number of polylines\n" ;
+    write_table ("std::size_t", "elements", elements. size (),
+        [&] (long_unsigned_int i) { file << elements[i] ; }) ;
+    file << "/** @brief appends the polylines of pattern element of the \
+tables to pattern. */\n\
+static inline void " << name << "_append_to (dpps::Pattern &pattern,\n\
+                                    const std::size_t element = 0) {\n\
+    const std::size_t begin {" << name << "_elements[element]} ;\n\
+    const std::size_t end {" << name << "_elements[element + 1]} ;\n\
+    pattern. polylines. reserve (pattern. polylines. size () + end - begin) ;\n\
+    for (std::size_t i {begin} ; i < end ; i++) {\n\
+        dpps::Polyline p ;\n\
+        p. vertices. reserve (" << name << "_offsets[i + 1] - " << name
+         << "_offsets[i]) ;\n\
+        for (std::size_t j {" << name << "_offsets[i]} ; j < " << name
+         << "_offsets[i + 1] ; j++)\n\
+            p. vertices. push_back (dpps::Vertex (\n\
+                " << name << "_coordinates[2 * j], " << name
+         << "_coordinates[2 * j + 1])) ;\n\
+        p. closed = " << name << "_closed[i] ;\n\
+        p. dose = " << name << "_dose[i] ;\n\
+        p. reference = " << name << "_reference[i] ;\n\
+        pattern. polylines. push_back (std::move (p)) ;\n\
+    }\n\
+}\n" ;
+    packed. clear () ;
+    elements. clear () ;
+    Writer::close () ;
+}
@@ -13,7 +13,11 @@
 #ifndef DPPS_WRITER_CPP
 #define DPPS_WRITER_CPP
 
+#include <string>
+#include <vector>
+
 #include "Writer.hh"
+#include "Pattern_packed.hh"
 
 namespace dpps {
 /** @brief A Writer derivative to print patterns and groups of patterns. It is
@@ -43,19 +47,45 @@ namespace dpps {
  *  {{{...},{...}}} <- raw_character
  *  } <- alphabet_iso8859_1_raw
  *
+ * Large patterns make such lists slow to compile and slow to build at run
+ * time. In the table mode (see set_table()), the writer keeps the polylines
+ * and writes, when it is closed, flat constant tables instead: the
+ * coordinates of all the vertices, the first vertex of each polyline, the
+ * closed, dose and reference of each polyline and the first polyline of
+ * each pattern written. The file also defines a function which appends one
+ * of these patterns to a Pattern in a single pass. For the name output:
+ *
+ * output_append_to (pattern, 0) ; // appends the first pattern written
  *
  */
 class Writer_cpp: public Writer {
 public:
     /** @brief A struct to encapsulates the size metadata */
     struct Writer_cpp_settings: public Writer_settings {
+        /** @brief Whether the polylines are written as tables when the
+         * writer is closed, instead of an initialization list. */
+        bool table {false} ;
+
+        /** @brief The prefix of the names of the tables and of the function
+         * of the table mode. */
+        std::string name {"output"} ;
     };
 protected:
     Writer_cpp_settings writer_settings ;
     bool first {true} ;
+
+    /** @brief the polylines of the table mode, written by close(). */
+    Pattern_packed packed ;
+
+    /** @brief the first polyline of each pattern of the table mode. */
+    std::vector<long_unsigned_int> elements ;
 public:
     // Implementation of inherited virtual functions.
     Writer_cpp (const std::string &set_filename, const bool append) ;
+    ~Writer_cpp () ;
+
+    /** @brief writes the tables of the table mode, then closes the file. */
+    void close () ;
     void write_header () ;
     void write_footer () ;
     void set_parametres (const std::vector<bool> &vbool,
@@ -64,6 +94,11 @@ public:
                          const std::vector<std::string> &vstring) ;
     void write_Polyline (const Polyline &polyline) ;
     void set_all_parametres () ;
+
+    /** @brief sets the table mode, whose tables and function have names
+     * starting with name, or back to the initialization lists if table is
+     * false. Throws bad_parametre if name is not a C++ identifier. */
+    void set_table (const bool table, const std::string &name = "output") ;
 } ;
 } // namespace dpps
 #endif
\ No newline at end of file
@@ -0,0 +1,177 @@
+/**
+ * @file Writer_dpps.cpp
+ * @author Jérôme Borme <jerome.borme@inl.int>
+ * @version 1.0
+ * @brief A Writer derivative for the binary format of this program.
+ * @date 2026-10-14 Jérôme Borme: Initial version
+ * @copyright
+ * This Source Code Form is subject to the terms of the Mozilla Public
+ * License, v. 2.0. If a copy of the MPL was not distributed with this
+ * file, You can obtain one at http://mozilla.org/MPL/2.0/.
+ * */
+
+#include <cstring>
+#include <limits>
+
+#include "Writer_dpps.hh"
+#include "bad_parametre.hh"
+#include "bad_io.hh"
+
+static_assert (sizeof (dpps::Writer_dpps::File_header) == 48,
+               "Writer_dpps::File_header must not be padded") ;
+// offsets and reference are written directly from the vectors.
+static_assert (sizeof (long_unsigned_int) == sizeof (uint64_t),
+               "long_unsigned_int must be 64 bits") ;
+
+const char dpps::Writer_dpps::magic[8] {'d', 'p', 'p', 's', '\x1a', 'p',
+                                        'a', 't'} ;
+
+static uint64_t round_up_8 (const uint64_t n) {
+    return (n + 7) / 8 * 8 ;
+}
+
+dpps::Writer_dpps::File_layout dpps::Writer_dpps::layout (
+    const File_header &header) {
+    uint64_t n {header. number_polylines} ;
+    uint64_t v {header. number_vertices} ;
+    File_layout result ;
+    result. offsets = sizeof (File_header) ;
+    result. dose = result. offsets + (n + 1) * sizeof (uint64_t) ;
+    result. reference = result. dose + n * sizeof (double) ;
+    result. x = result. reference + n * sizeof (uint64_t) ;
+    result. y = result. x + v * sizeof (double) ;
+    result. selections = result. y + v * sizeof (double) ;
+    result. closed = result. selections + header. number_selections *
+                     ((n + 63) / 64) * sizeof (uint64_t) ;
+    result. bounding_boxes = result. closed + round_up_8 (n) ;
+    result. file_size = result. bounding_boxes ;
+    if (header. flags & flag_bounding_boxes)
+        result. file_size += 4 * n * sizeof (double) ;
+    return result ;
+}
+
+dpps::Writer_dpps::Writer_dpps (const std::string &set_filename):
+    Writer (set_filename, false) {
+    // Writer opens the file in text mode, which would translate the line
+    // feeds on some platforms.
+    file. close () ;
+    file. open (filename,
+                std::ios_base::out|std::ios_base::trunc|std::ios_base::binary) ;
+    if (!file. is_open ()) {
+        std::string reason {"File " + filename +
+                            " could not be open for output"} ;
+        throw bad_io (reason. c_str ()) ;
+    }
+}
+
+dpps::Writer_dpps::~Writer_dpps () {
+    if (open) // set in Writer contructor
+        close () ;
+    // open will be set to false in Writer::close()
+}
+
+void dpps::Writer_dpps::set_parametres (
+                        const std::vector<bool> &vbool,
+                        const std::vector<long_unsigned_int> &vint,
+                        const std::vector<double> &vdouble,
+                        const std::vector<std::string> &vstring) {
+    if ((vbool. size () != 1)   ||
+        (vint. size () != 0)    ||
+        (vdouble. size () != 0) ||
+        (vstring. size () != 0)) {
+        throw bad_parametre ("Writer_dpps::set_parametres",
+            1, 0, 0, 0,
+            vbool. size (), vint. size (), vdouble. size (), vstring. size ()) ;
+    }
+    set_all_parametres (vbool. at (0)) ;
+}
+
+void dpps::Writer_dpps::set_all_parametres (const bool bounding_boxes) {
+    writer_settings. bounding_boxes = bounding_boxes ;
+}
+
+void dpps::Writer_dpps::write_Polyline (const Polyline &polyline) {
+    packed. push_back (polyline) ;
+}
+
+void dpps::Writer_dpps::write_Pattern (const Pattern &pattern) {
+    packed. reserve (packed. size () + pattern. size (-1),
+                     packed. x. size () + pattern. vertices_size (-1)) ;
+    Writer::write_Pattern (pattern) ;
+}
+
+void dpps::Writer_dpps::write_Pattern_selected (const Pattern &pattern,
+    const selection_t selection) {
+    packed. reserve (packed. size () + pattern. size (selection),
+                     packed. x. size () + pattern. vertices_size (selection)) ;
+    Writer::write_Pattern_selected (pattern, selection) ;
+}
+
+void dpps::Writer_dpps::write_Pattern_packed (const Pattern_packed &p) {
+    if (packed. size () == 0) {
+        packed = p ;
+        return ;
+    }
+    packed. reserve (packed. size () + p. size (),
+                     packed. x. size () + p. x. size ()) ;
+    for (long_unsigned_int i {0} ; i < p. size () ; i++)
+        packed. push_back (p. get_polyline (i)) ;
+}
+
+void dpps::Writer_dpps::write_section (const void *data,
+                                       const long_unsigned_int size) {
+    static const char zeros[8] {0, 0, 0, 0, 0, 0, 0, 0} ;
+    if (size > 0)
+        file. write (static_cast<const char *> (data), size) ;
+    file. write (zeros, round_up_8 (size) - size) ;
+}
+
+void dpps::Writer_dpps::close () {
+    if (file. is_open ()) {
+        long_unsigned_int n {packed. size ()} ;
+        File_header header ;
+        memcpy (header. magic, magic, sizeof (magic)) ;
+        header. version = version ;
+        header. flags = writer_settings. bounding_boxes ?
+                        flag_bounding_boxes : 0 ;
+        header. number_polylines = n ;
+        header. number_vertices = packed. x. size () ;
+        header. number_selections = polyline_max_selection ;
+        header. byte_order = byte_order_mark ;
+        header. reserved = 0 ;
+        file. write (reinterpret_cast<const char *> (&header),
+                     sizeof (header)) ;
+
+        write_section (packed. offsets. data (),
+                       packed. offsets. size () * sizeof (uint64_t)) ;
+        write_section (packed. dose. data (), n * sizeof (double)) ;
+        write_section (packed. reference. data (), n * sizeof (uint64_t)) ;
+        write_section (packed. x. data (), packed. x. size () * sizeof (double)) ;
+        write_section (packed. y. data (), packed. y. size () * sizeof (double)) ;
+        // the reference &w is used to avoid copy
+        for (auto &w: packed. selection_words)
+            write_section (w. data (), w. size () * sizeof (uint64_t)) ;
+        // std::vector<bool> is not stored as bytes.
+        std::vector<uint8_t> closed (packed. closed. begin (),
+                                     packed. closed. end ()) ;
+        write_section (closed. data (), n) ;
+        if (writer_settings. bounding_boxes) {
+            std::vector<double> boxes ;
+            boxes. reserve (4 * n) ;
+            for (long_unsigned_int i {0} ; i < n ; i++) {
+                double minx {std::numeric_limits<double>::max ()} ;
+                double miny {std::numeric_limits<double>::max ()} ;
+                double maxx {std::numeric_limits<double>::lowest ()} ;
+                double maxy {std::numeric_limits<double>::lowest ()} ;
+                packed. polyline_limits (i, minx, miny, maxx, maxy) ;
+                boxes. push_back (minx) ;
+                boxes. push_back (miny) ;
+                boxes. push_back (maxx) ;
+                boxes. push_back (maxy) ;
+            }
+            write_section (boxes. data (), boxes. size () * sizeof (double)) ;
+        }
+        packed. clear () ;
+    }
+    Writer::close () ;
+}
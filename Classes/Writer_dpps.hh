@@ -0,0 +1,124 @@
+/**
+ * @file Writer_dpps.hh
+ * @author Jérôme Borme <jerome.borme@inl.int>
+ * @version 1.0
+ * @brief A Writer derivative for the binary format of this program.
+ * @date 2026-10-14 Jérôme Borme: Initial version
+ * @copyright
+ * This Source Code Form is subject to the terms of the Mozilla Public
+ * License, v. 2.0. If a copy of the MPL was not distributed with this
+ * file, You can obtain one at http://mozilla.org/MPL/2.0/.
+ * */
+
+#ifndef DPPS_WRITER_DPPS
+#define DPPS_WRITER_DPPS
+
+#include <cstdint>
+
+#include "Writer.hh"
+#include "Pattern_packed.hh"
+
+namespace dpps {
+/** @brief A Writer derivative for the binary dpps format, which stores the
+ * arrays of a Pattern_packed.
+ *
+ * It is intended to keep intermediate results between the stages of a
+ * script: it is read back by Reader_dpps without any parsing, and the file
+ * can be used in place through a memory mapping. Nothing is lost, including
+ * the selections.
+ *
+ * The file is made of a File_header, followed by these sections, in native
+ * byte order and each starting at a multiple of 8 bytes:
+ * * offsets: number_polylines + 1 uint64, polyline i has the vertices from
+ *   offsets[i] to offsets[i+1]-1;
+ * * dose: number_polylines double;
+ * * reference: number_polylines uint64;
+ * * x, then y: number_vertices double each;
+ * * selections: for each of the number_selections registers,
+ *   (number_polylines + 63) / 64 uint64, with bit i%64 of word i/64 for
+ *   polyline i;
+ * * closed: number_polylines uint8, padded with zeros to a multiple of 8;
+ * * if flag_bounding_boxes is set, bounding boxes: number_polylines times
+ *   4 double, minimum x, minimum y, maximum x and maximum y. A polyline
+ *   without vertex has minimum values larger than its maximum values.
+ *
+ * The version is increased whenever the layout changes.
+ */
+class Writer_dpps: public Writer {
+public:
+    /** @brief the first 48 bytes of the file. */
+    struct File_header {
+        char magic[8] ;
+        uint32_t version ;
+        uint32_t flags ;
+        uint64_t number_polylines ;
+        uint64_t number_vertices ;
+        uint32_t number_selections ;
+        /** @brief byte_order_mark as written by the machine which wrote the
+         * file, so that the byte order can be checked. */
+        uint32_t byte_order ;
+        uint64_t reserved ;
+    } ;
+
+    /** @brief the position in bytes of each section in the file, and the
+     * size of the file. */
+    struct File_layout {
+        uint64_t offsets ;
+        uint64_t dose ;
+        uint64_t reference ;
+        uint64_t x ;
+        uint64_t y ;
+        uint64_t selections ;
+        uint64_t closed ;
+        uint64_t bounding_boxes ;
+        uint64_t file_size ;
+    } ;
+
+    static const char magic[8] ;
+    static const uint32_t version {1} ;
+    static const uint32_t byte_order_mark {0x01020304} ;
+    static const uint32_t flag_bounding_boxes {1} ;
+
+    /** @brief returns the positions of the sections of a file with this
+     * header. */
+    static File_layout layout (const File_header &header) ;
+
+    /** @brief A struct to encapsulates the metadata */
+    struct Writer_dpps_settings: public Writer_settings {
+        bool bounding_boxes {true} ;
+    };
+protected:
+    Writer_dpps_settings writer_settings ;
+
+    /** @brief the polylines written so far, which are only sent to the file
+     * by close() as the sizes of the sections have to be known. */
+    Pattern_packed packed ;
+
+    /** @brief writes size bytes from data, then zeros up to a multiple of
+     * 8 bytes. */
+    void write_section (const void *data, const long_unsigned_int size) ;
+public:
+    /** @brief Constructor. The file is always overwritten, as appending
+     * to a binary file would produce an invalid file. */
+    Writer_dpps (const std::string &set_filename) ;
+    ~Writer_dpps () ;
+    void close () ;
+    // Implementation of inherited virtual functions.
+    void set_parametres (const std::vector<bool> &vbool,
+                         const std::vector<long_unsigned_int> &vint,
+                         const std::vector<double> &vdouble,
+                         const std::vector<std::string> &vstring) ;
+    void write_Polyline (const Polyline &polyline) ;
+    void write_Pattern (const Pattern &pattern) ;
+    void write_Pattern_selected (const Pattern &pattern,
+                                 const selection_t selection = 0) ;
+
+    /** @brief writes all the polylines of p, copying its arrays at once if
+     * nothing was written before. */
+    void write_Pattern_packed (const Pattern_packed &p) ;
+    /** @brief whether to write the bounding box of each polyline, used by
+     * Reader_dpps::append_window_to_pattern(). */
+    void set_all_parametres (const bool bounding_boxes) ;
+} ;
+} // namespace dpps
+#endif
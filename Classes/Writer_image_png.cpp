@@ -0,0 +1,368 @@
+/**
+ * @file Writer_image_png.cpp
+ * @author Jérôme Borme <jerome.borme@inl.int>
+ * @version 1.0
+ * @brief A Writer derivative that rasterises the polylines into a PNG file
+ * with libpng.
+ * @date 2026-10-14 Jérôme Borme: Initial version
+ * @copyright
+ * This Source Code Form is subject to the terms of the Mozilla Public
+ * License, v. 2.0. If a copy of the MPL was not distributed with this
+ * file, You can obtain one at http://mozilla.org/MPL/2.0/.
+ */
+
+#include <algorithm>
+#include <cmath>
+#include <limits>
+
+#include <png.h>
+
+#include "configure.h" // created by cmake
+#ifdef OPENMP_FOUND
+#include <omp.h>
+#endif
+
+#include "Writer_image_png.hh"
+#include "bad_io.hh"
+#include "bad_parametre.hh"
+
+// libpng reports its errors with longjmp. The calls to libpng are made in
+// these functions, which have no object to destroy and return false after
+// an error, so that the exceptions are thrown by the caller, as in
+// Reader_image_png_stream.
+
+static void png_write_to_stream (png_structp png, png_bytep data,
+                                 png_size_t length) {
+    std::ostream *stream {static_cast<std::ostream *> (png_get_io_ptr (png))} ;
+    stream-> write (reinterpret_cast<const char *> (data), length) ;
+}
+
+static void png_flush_stream (png_structp png) {
+    static_cast<std::ostream *> (png_get_io_ptr (png))-> flush () ;
+}
+
+static bool png_begin (png_structp png, png_infop info, std::ostream *stream,
+                       const png_uint_32 width, const png_uint_32 height) {
+    if (setjmp (png_jmpbuf (png)))
+        return false ;
+    png_set_write_fn (png, stream, png_write_to_stream, png_flush_stream) ;
+    png_set_IHDR (png, info, width, height, 8, PNG_COLOR_TYPE_GRAY,
+                  PNG_INTERLACE_NONE, PNG_COMPRESSION_TYPE_DEFAULT,
+                  PNG_FILTER_TYPE_DEFAULT) ;
+    png_write_info (png, info) ;
+    return true ;
+}
+
+static bool png_encode_row (png_structp png, png_bytep row) {
+    if (setjmp (png_jmpbuf (png)))
+        return false ;
+    png_write_row (png, row) ;
+    return true ;
+}
+
+static bool png_finish (png_structp png, png_infop info) {
+    if (setjmp (png_jmpbuf (png)))
+        return false ;
+    png_write_end (png, info) ;
+    return true ;
+}
+
+dpps::Writer_image_png::Writer_image_png (const std::string &set_filename):
+    Writer (set_filename, false) {
+    // Writer opens the file in text mode, which would translate the line
+    // feeds on some platforms.
+    file. close () ;
+    file. open (filename,
+                std::ios_base::out|std::ios_base::trunc|std::ios_base::binary) ;
+    if (!file. is_open ()) {
+        std::string reason {"File " + filename +
+                            " could not be open for output"} ;
+        throw bad_io (reason. c_str ()) ;
+    }
+}
+
+dpps::Writer_image_png::Writer_image_png (const std::string &set_filename,
+                                          const double minx,
+                                          const double miny,
+                                          const double maxx,
+                                          const double maxy,
+                                          const double pixel_size,
+                                          const bool use_dose,
+                                          const double full_scale):
+    Writer_image_png (set_filename) {
+    set_all_parametres (minx, miny, maxx, maxy, pixel_size, use_dose,
+                        full_scale) ;
+}
+
+dpps::Writer_image_png::~Writer_image_png () {
+    if (open) // set in Writer contructor
+        close () ;
+    // open will be set to false in Writer::close()
+}
+
+void dpps::Writer_image_png::set_parametres (
+                        const std::vector<bool> &vbool,
+                        const std::vector<long_unsigned_int> &vint,
+                        const std::vector<double> &vdouble,
+                        const std::vector<std::string> &vstring) {
+    if ((vbool. size () != 1)   ||
+        (vint. size () != 0)    ||
+        (vdouble. size () != 6) ||
+        (vstring. size () != 0)) {
+        throw bad_parametre ("Writer_image_png::set_parametres",
+            1, 0, 6, 0,
+            vbool. size (), vint. size (), vdouble. size (), vstring. size ()) ;
+    }
+    set_all_parametres (vdouble. at (0), vdouble. at (1), vdouble. at (2),
+                        vdouble. at (3), vdouble. at (4), vbool. at (0),
+                        vdouble. at (5)) ;
+}
+
+void dpps::Writer_image_png::set_all_parametres (const double minx,
+                                                 const double miny,
+                                                 const double maxx,
+                                                 const double maxy,
+                                                 const double pixel_size,
+                                                 const bool use_dose,
+                                                 const double full_scale) {
+    if ((pixel_size <= 0) || (full_scale <= 0)) {
+        std::string reason {"Writer_image_png, the pixel size and the full \
+scale must be positive, got " + std::to_string (pixel_size) + " and " +
+            std::to_string (full_scale) + "."} ;
+        throw bad_parametre (reason. c_str ()) ;
+    }
+    writer_settings. window = {{minx, miny, maxx, maxy}} ;
+    writer_settings. pixel_size = pixel_size ;
+    writer_settings. use_dose = use_dose ;
+    writer_settings. full_scale = full_scale ;
+}
+
+void dpps::Writer_image_png::set_band_rows (
+    const long_unsigned_int band_rows) {
+    if (band_rows == 0)
+        throw bad_parametre ("Writer_image_png::set_band_rows, the bands must \
+have at least one row.") ;
+    writer_settings. band_rows = band_rows ;
+}
+
+void dpps::Writer_image_png::write_Polyline (const Polyline &polyline) {
+    packed. push_back (polyline) ;
+}
+
+void dpps::Writer_image_png::draw_band (
+    const std::vector<long_unsigned_int> &numbers,
+    const long_unsigned_int first_row,
+    const long_unsigned_int rows,
+    const long_unsigned_int width,
+    const double minx, const double maxy,
+    std::vector<float> &buffer) const {
+    const double size {writer_settings. pixel_size} ;
+    const long signed int row_begin {static_cast<long signed int> (first_row)} ;
+    const long signed int row_end {row_begin +
+                                   static_cast<long signed int> (rows)} ;
+    const long signed int columns {static_cast<long signed int> (width)} ;
+    // the last pixel drawn by a line, so that it is not counted twice
+    long signed int last {-1} ;
+    auto add = [&] (const long signed int c, const long signed int r,
+                    const double value) {
+        if ((c < 0) || (c >= columns) || (r < row_begin) || (r >= row_end))
+            return ;
+        long signed int pixel {(r - row_begin) * columns + c} ;
+        if (pixel == last)
+            return ;
+        buffer[pixel] += value ;
+        last = pixel ;
+    } ;
+    auto column_of = [&] (const double x) {
+        return static_cast<long signed int> (floor ((x - minx) / size)) ;
+    } ;
+    auto row_of = [&] (const double y) {
+        return static_cast<long signed int> (floor ((maxy - y) / size)) ;
+    } ;
+    std::vector<double> crossings ;
+    for (auto k: numbers) {
+        long_unsigned_int first {packed. offsets[k]} ;
+        long_unsigned_int n {packed. offsets[k + 1] - first} ;
+        const double *x {packed. x. data () + first} ;
+        const double *y {packed. y. data () + first} ;
+        double value {writer_settings. use_dose ? packed. dose[k] : 1.0} ;
+        last = -1 ;
+        if (n == 0)
+            continue ;
+        if (n == 1) {
+            add (column_of (x[0]), row_of (y[0]), value) ;
+            continue ;
+        }
+        if (!packed. closed[k] || (n < 3)) {
+            // Points every half pixel along the segments.
+            for (long_unsigned_int i {0} ; i + 1 < n ; i++) {
+                double length {sqrt ((x[i + 1] - x[i]) * (x[i + 1] - x[i]) +
+                                     (y[i + 1] - y[i]) * (y[i + 1] - y[i]))} ;
+                long_unsigned_int steps {1 + static_cast<long_unsigned_int> (
+                    ceil (2 * length / size))} ;
+                for (long_unsigned_int m {0} ; m <= steps ; m++) {
+                    double t {static_cast<double> (m) / steps} ;
+                    add (column_of (x[i] + t * (x[i + 1] - x[i])),
+                         row_of (y[i] + t * (y[i + 1] - y[i])), value) ;
+                }
+            }
+            continue ;
+        }
+        double xmin {x[0]}, xmax {x[0]}, ymin {y[0]}, ymax {y[0]} ;
+        for (long_unsigned_int i {1} ; i < n ; i++) {
+            xmin = std::min (xmin, x[i]) ;
+            xmax = std::max (xmax, x[i]) ;
+            ymin = std::min (ymin, y[i]) ;
+            ymax = std::max (ymax, y[i]) ;
+        }
+        long signed int r_first {static_cast<long signed int> (
+            ceil ((maxy - ymax) / size - 0.5))} ;
+        long signed int r_last {static_cast<long signed int> (
+            floor ((maxy - ymin) / size - 0.5))} ;
+        long signed int c_first {static_cast<long signed int> (
+            ceil ((xmin - minx) / size - 0.5))} ;
+        long signed int c_last {static_cast<long signed int> (
+            floor ((xmax - minx) / size - 0.5))} ;
+        if ((r_first > r_last) || (c_first > c_last)) {
+            add (column_of ((xmin + xmax) / 2), row_of ((ymin + ymax) / 2),
+                 value) ;
+            continue ;
+        }
+        // The pixels whose centre is inside, row by row.
+        for (long signed int r {std::max (r_first, row_begin)} ;
+             r <= std::min (r_last, row_end - 1) ; r++) {
+            double yc {maxy - (r + 0.5) * size} ;
+            crossings. clear () ;
+            for (long_unsigned_int i {0} ; i < n ; i++) {
+                long_unsigned_int j {(i + 1) % n} ;
+                if ((y[i] <= yc) != (y[j] <= yc))
+                    crossings. push_back (x[i] + (yc - y[i]) * (x[j] - x[i]) /
+                                                 (y[j] - y[i])) ;
+            }
+            std::sort (crossings. begin (), crossings. end ()) ;
+            for (long_unsigned_int i {0} ; i + 1 < crossings. size () ; i += 2) {
+                long signed int c_begin {std::max (0L,
+                    static_cast<long signed int> (
+                        ceil ((crossings[i] - minx) / size - 0.5)))} ;
+                long signed int c_end {std::min (columns,
+                    static_cast<long signed int> (
+                        ceil ((crossings[i + 1] - minx) / size - 0.5)))} ;
+                float *row {buffer. data () + (r - row_begin) * columns} ;
+                for (long signed int c {c_begin} ; c < c_end ; c++)
+                    row[c] += value ;
+            }
+        }
+    }
+}
+
+void dpps::Writer_image_png::close () {
+    if (!file. is_open ()) {
+        Writer::close () ;
+        return ;
+    }
+    const double size {writer_settings. pixel_size} ;
+    double minx {writer_settings. window[0]} ;
+    double miny {writer_settings. window[1]} ;
+    double maxx {writer_settings. window[2]} ;
+    double maxy {writer_settings. window[3]} ;
+    if (((minx >= maxx) || (miny >= maxy)) && (packed. size () == 0)) {
+        // Nothing to draw: one black pixel.
+        minx = 0.0 ;
+        miny = 0.0 ;
+        maxx = size ;
+        maxy = size ;
+    } else if ((minx >= maxx) || (miny >= maxy)) {
+        Vertex lower_left {packed. lower_left ()} ;
+        Vertex upper_right {packed. upper_right ()} ;
+        minx = lower_left. x ;
+        miny = lower_left. y ;
+        maxx = upper_right. x ;
+        maxy = upper_right. y ;
+    }
+    double columns {ceil ((maxx - minx) / size)} ;
+    double rows {ceil ((maxy - miny) / size)} ;
+    // A pattern of one dot, or of dots on a line, still has one pixel.
+    columns = std::max (columns, 1.0) ;
+    rows = std::max (rows, 1.0) ;
+    const double maximum {2147483647.0} ;
+    if ((columns > maximum) || (rows > maximum)) {
+        packed. clear () ;
+        Writer::close () ;
+        std::string reason {"Writer_image_png: the image of file " +
+            filename + " would have " + std::to_string (columns) + " × " +
+            std::to_string (rows) + " pixels."} ;
+        throw bad_parametre (reason. c_str ()) ;
+    }
+    long_unsigned_int width {static_cast<long_unsigned_int> (columns)} ;
+    long_unsigned_int height {static_cast<long_unsigned_int> (rows)} ;
+    long_unsigned_int band_rows {std::min (writer_settings. band_rows, height)} ;
+    long_unsigned_int bands {(height + band_rows - 1) / band_rows} ;
+
+    // The polylines of each band, from their bounding box.
+    std::vector<std::vector<long_unsigned_int>> numbers (bands) ;
+    for (long_unsigned_int k {0} ; k < packed. size () ; k++) {
+        double pminx {std::numeric_limits<double>::max ()} ;
+        double pminy {std::numeric_limits<double>::max ()} ;
+        double pmaxx {std::numeric_limits<double>::lowest ()} ;
+        double pmaxy {std::numeric_limits<double>::lowest ()} ;
+        packed. polyline_limits (k, pminx, pminy, pmaxx, pmaxy) ;
+        if ((pminx > maxx) || (pmaxx < minx) || (pminy > maxy) || (pmaxy < miny))
+            continue ;
+        long_unsigned_int first {static_cast<long_unsigned_int> (std::max (0.0,
+            floor ((maxy - pmaxy) / size)))} ;
+        long_unsigned_int last {static_cast<long_unsigned_int> (std::min (
+            rows - 1, floor ((maxy - pminy) / size)))} ;
+        for (long_unsigned_int b {first / band_rows} ; b <= last / band_rows ;
+             b++)
+            numbers[b]. push_back (k) ;
+    }
+
+    png_structp png {png_create_write_struct (PNG_LIBPNG_VER_STRING,
+                                              nullptr, nullptr, nullptr)} ;
+    png_infop png_info {png == nullptr ? nullptr : png_create_info_struct (png)} ;
+    bool ok {(png_info != nullptr) &&
+             png_begin (png, png_info, &file, width, height)} ;
+    long_unsigned_int threads {1} ;
+#ifdef OPENMP_FOUND
+    threads = omp_get_max_threads () ;
+#endif
+    // One band per thread at a time, the rows of each group then written in
+    // order.
+    std::vector<std::vector<float>> buffers (threads) ;
+    std::vector<png_byte> row (width) ;
+    for (long_unsigned_int group {0} ; ok && (group < bands) ;
+         group += threads) {
+        long_unsigned_int end {std::min (bands, group + threads)} ;
+#ifdef OPENMP_FOUND
+        #pragma omp parallel for schedule(dynamic, 1)
+#endif
+        for (long_unsigned_int b = group ; b < end ; b++) {
+            std::vector<float> &buffer {buffers[b - group]} ;
+            buffer. assign (band_rows * width, 0.0f) ;
+            draw_band (numbers[b], b * band_rows,
+                       std::min (band_rows, height - b * band_rows), width,
+                       minx, maxy, buffer) ;
+        }
+        for (long_unsigned_int b {group} ; ok && (b < end) ; b++)
+            for (long_unsigned_int r {0} ;
+                 ok && (r < std::min (band_rows, height - b * band_rows)) ;
+                 r++) {
+                const float *values {buffers[b - group]. data () + r * width} ;
+                for (long_unsigned_int c {0} ; c < width ; c++) {
+                    double level {values[c] / writer_settings. full_scale} ;
+                    row[c] = static_cast<png_byte> (
+                        lround (255 * std::max (0.0, std::min (1.0, level)))) ;
+                }
+                ok = png_encode_row (png, row. data ()) ;
+            }
+    }
+    ok = ok && png_finish (png, png_info) ;
+    png_destroy_write_struct (&png, &png_info) ;
+    packed. clear () ;
+    Writer::close () ;
+    if (!ok) {
+        std::string reason {"Writer_image_png: file " + filename +
+                            " could not be written"} ;
+        throw bad_io (reason. c_str ()) ;
+    }
+}
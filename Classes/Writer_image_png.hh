@@ -0,0 +1,118 @@
+/**
+ * @file Writer_image_png.hh
+ * @author Jérôme Borme <jerome.borme@inl.int>
+ * @version 1.0
+ * @brief A Writer derivative that rasterises the polylines into a PNG file
+ * with libpng.
+ * @date 2026-10-14 Jérôme Borme: Initial version
+ * @copyright
+ * This Source Code Form is subject to the terms of the Mozilla Public
+ * License, v. 2.0. If a copy of the MPL was not distributed with this
+ * file, You can obtain one at http://mozilla.org/MPL/2.0/.
+ */
+#ifndef DPPS_WRITER_IMAGE_PNG
+#define DPPS_WRITER_IMAGE_PNG
+
+#include <array>
+#include <string>
+#include <vector>
+
+#include "Writer.hh"
+#include "Pattern_packed.hh"
+
+namespace dpps {
+/** @brief A Writer derivative which draws the polylines into a grey level
+ * PNG image, to check the coverage or the dose of a pattern, the reverse of
+ * Reader_image.
+ *
+ * Each pixel adds up the polylines covering it: closed polylines fill the
+ * pixels whose centre is inside them (even-odd rule), open polylines are
+ * drawn one pixel wide and dots as one pixel. A closed polyline whose
+ * bounding box contains no centre of pixel is drawn as a dot at its centre.
+ * Each polyline counts 1, or its dose if use_dose is set, and the grey level
+ * goes from black for 0 to white for full_scale or more. The first row of
+ * the image is at the top of the window.
+ *
+ * The polylines are kept as a Pattern_packed until close(), as any of them
+ * may cover any part of the image. The image is then drawn in bands of
+ * band_rows rows, each band filled by one thread from the polylines whose
+ * bounding box meets it, and the rows are written one at a time with
+ * libpng, so that the memory used depends on the width of the image and
+ * on the number of threads, not on its area.
+ */
+class Writer_image_png: public Writer {
+public:
+    /** @brief A struct to encapsulate the settings */
+    struct Writer_image_png_settings: public Writer_settings {
+        /** @brief the window drawn, (xmin, ymin, xmax, ymax). If it is empty,
+         * the bounding box of the polylines is drawn. */
+        std::array<double, 4> window {{0., 0., 0., 0.}} ;
+
+        double pixel_size {1.0} ;
+
+        /** @brief whether the polylines count their dose instead of 1. */
+        bool use_dose {false} ;
+
+        /** @brief the value drawn in white. */
+        double full_scale {1.0} ;
+
+        long_unsigned_int band_rows {256} ;
+    } ;
+
+protected:
+    Writer_image_png_settings writer_settings ;
+
+    /** @brief the polylines written so far, drawn by close(). */
+    Pattern_packed packed ;
+
+    /** @brief adds the polylines of numbers to the rows from first_row of
+     * buffer, of width columns, for the window from minx to maxy. */
+    void draw_band (const std::vector<long_unsigned_int> &numbers,
+                    const long_unsigned_int first_row,
+                    const long_unsigned_int rows,
+                    const long_unsigned_int width,
+                    const double minx, const double maxy,
+                    std::vector<float> &buffer) const ;
+
+public:
+    Writer_image_png (const std::string &set_filename) ;
+
+    Writer_image_png (const std::string &set_filename,
+                      const double minx,
+                      const double miny,
+                      const double maxx,
+                      const double maxy,
+                      const double pixel_size,
+                      const bool use_dose = false,
+                      const double full_scale = 1.0) ;
+
+    ~Writer_image_png () ;
+
+    /** @brief draws the image and writes it. Throws bad_io if it cannot be
+     * written, and bad_parametre if it would be larger than the 2^31 - 1
+     * pixels of side of the PNG format. */
+    void close () ;
+
+    // Implementation of inherited virtual functions.
+    void set_parametres (const std::vector<bool> &vbool,
+                         const std::vector<long_unsigned_int> &vint,
+                         const std::vector<double> &vdouble,
+                         const std::vector<std::string> &vstring) ;
+    void write_Polyline (const Polyline &polyline) ;
+
+    /** @brief sets the settings, see Writer_image_png_settings. Throws
+     * bad_parametre if pixel_size or full_scale is not positive. */
+    void set_all_parametres (const double minx,
+                             const double miny,
+                             const double maxx,
+                             const double maxy,
+                             const double pixel_size,
+                             const bool use_dose,
+                             const double full_scale) ;
+
+    /** @brief sets the number of rows drawn by a thread at a time. Throws
+     * bad_parametre if it is 0. */
+    void set_band_rows (const long_unsigned_int band_rows) ;
+} ;
+} // namespace dpps
+#endif
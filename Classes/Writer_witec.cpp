@@ -23,18 +23,27 @@
 #include <cmath>
 #include <chrono>
 #include <cstdio>
+#include <exception>
 
 #include "util.hh"
 #include "Vertex.hh"
 #include "Writer_witec.hh"
 #include "Polyline_factory.hh"
 #include "Pattern_factory.hh"
+#include "Travel_planner.hh"
 #include "bad_parametre.hh"
 #include "bad_io.hh"
 
 dpps::Writer_witec::Writer_witec (const std::string &set_filename,
     const bool append): Writer (set_filename, append) {}
 
+dpps::Writer_witec::Writer_witec (): Writer () {
+    simulation = true ;
+    // Nothing is inserted into a bad stream, so that the commands are not
+    // kept in memory.
+    body. setstate (std::ios_base::badbit) ;
+}
+
 dpps::Writer_witec::~Writer_witec() {
     if (open) // set in Writer contructor
         close () ;
@@ -42,10 +51,13 @@ dpps::Writer_witec::~Writer_witec() {
 }
 
 void dpps::Writer_witec::close () {
+    if (simulation) {
+        Writer::close () ;
+        return ;
+    }
     // Ready to close, we actually write the header of the real file.
     std::chrono::milliseconds total (static_cast<long_unsigned_int>(
-        round (1000.0*(jump_duration+move_duration+
-                       dot_duration+shutter_duration)))) ;
+        round (1000.0*get_estimated_duration ()))) ;
 #ifdef FILENAMES_FOR_WINDOWS
     // For users using drag and drop of the lua program onto
     // the executable, the OS will pass the full path. Because display size
@@ -85,31 +97,16 @@ void dpps::Writer_witec::close () {
             throw bad_io (reason. c_str ()) ;
         }
     }
-    // Writign a stream into another. See:
-    // * N. Josuttis, The C++ std. lib. 2nd ed (2012),
-    //   section 15.14.3 « Using stream buffers directly », page 846-7.
-    //   « This is probably the fastest way to copy files by using
-    //     C++ I/O streams »
-    // * http://stackoverflow.com/questions/3738233/how-to-copy-binary-data-from-one-stream-to-another
-    // * http://stackoverflow.com/questions/7250720/ofstreamoperatorstreambuf-is-a-slow-way-to-copy-a-file
-    tmpfile. close () ;
-    if (tmpfile. bad()) {
-        std::string reason {"Writer_witec: tmpfile " + tmpfilename +
-                            " could not be closed"} ;
-        throw bad_io (reason. c_str ()) ;
-    }
-    std::ifstream tmpfile_readonly (tmpfilename, std::ios::in);
-    file << tmpfile_readonly. rdbuf() ;
-    tmpfile_readonly. close () ;
-    if (tmpfile. bad()) {
-        std::string reason {"Writer_witec: tmpfile_readonly " + tmpfilename +
-                            " could not be closed"} ;
-        throw bad_io (reason. c_str ()) ;
-    }
+    if (writer_settings. optimize_commands)
+        write_optimized_body () ;
+    else
+        write_body () ;
     Writer::close() ;
 }
 
 void dpps::Writer_witec::write_header () {
+    if (simulation)
+        return ;
     file << "/* " + current_date_string () << " */\n" ;
     if (writer_settings. comment_separate) {
         // It can be open already if the user calls several times write_header()
@@ -130,9 +127,17 @@ void dpps::Writer_witec::write_header () {
     }
 }
 
+bool dpps::Writer_witec::comments_emitted () const {
+    return !simulation && (writer_settings. comment_inline ||
+                           writer_settings. comment_separate ||
+                           writer_settings. comment_cerr) ;
+}
+
 void dpps::Writer_witec::emit_comment (const std::string value) {
+    if (simulation)
+        return ;
     if (writer_settings. comment_inline)
-        tmpfile << "/* " << value << " */\n" ;
+        body << "/* " << value << " */\n" ;
     if (writer_settings. comment_separate)
         log << value << "\n" ;
     if (writer_settings. comment_cerr)
@@ -147,14 +152,14 @@ void dpps::Writer_witec::perform_focus_change (double value) {
             std::to_string (current_piezo_height) + " µm by " +
             std::to_string (value) + " µm "} ;
         if (writer_settings. absolute_movements) {
-            tmpfile << string_piezo_move_absolute << "("
+            body << string_piezo_move_absolute << "("
                  << fixed_number (current_stepper_position. x, 4, false) << ","
                  << fixed_number (current_stepper_position. y, 4, false) << ","
                  << fixed_number (current_piezo_height+value, 4, false)
                  << ");\n" ;
             current_piezo_height = fixed_number_value (current_piezo_height+value, 4) ;
         } else {
-            tmpfile << string_piezo_move_relative << "(0,0,"
+            body << string_piezo_move_relative << "(0,0,"
                  << fixed_number (value, 4, false)
                  << ");\n" ;
             current_piezo_height = fixed_number_value (value, 4) ;
@@ -169,7 +174,7 @@ void dpps::Writer_witec::perform_focus_change (double value) {
         // was checked to be >= movement_unit > 0
         value = std::round (value / writer_settings. stepper_z_correction_step) *
                 writer_settings. stepper_z_correction_step ;
-        tmpfile << string_stepper_z_move << "("
+        body << string_stepper_z_move << "("
              << fixed_number (value, 4, false)
              << ");\n" ;
         std::string comment {"Changing stepper z from " +
@@ -218,7 +223,7 @@ void dpps::Writer_witec::piezo_lithography_on (const Vertex &focus_position,
                 !writer_settings. focus_by_piezo)
             perform_focus_change (height_correction_value) ;
         if (!triggered) {
-            tmpfile << string_shutter << "(on);\n" ;
+            body << string_shutter << "(on);\n" ;
             update_duration_shutter () ;
             triggered = true ;
         }
@@ -254,7 +259,7 @@ void dpps::Writer_witec::stepper_lithography_on (const Vertex &focus_position,
         if (writer_settings. focus_correction)
             perform_focus_change (height_correction_value) ;
         if (!triggered) {
-            tmpfile << string_shutter << "(on);\n" ;
+            body << string_shutter << "(on);\n" ;
             update_duration_shutter () ;
             triggered = true ;
         }
@@ -263,8 +268,9 @@ void dpps::Writer_witec::stepper_lithography_on (const Vertex &focus_position,
 }
 
 void dpps::Writer_witec::lithography_off () {
+    chain_open = false ;
     if (writer_settings. litho_by_shutter && triggered) {
-        tmpfile << string_shutter << "(off);\n" ;
+        body << string_shutter << "(off);\n" ;
         update_duration_shutter () ;
         triggered = false ;
     }
@@ -281,12 +287,12 @@ void dpps::Writer_witec::write_footer () {
     lithography_off () ;
     if (writer_settings. xy_by_piezo) {
         if (writer_settings. absolute_movements) {
-            tmpfile << string_piezo_jump_absolute << "(0,0,0);\n" ;
+            body << string_piezo_jump_absolute << "(0,0,0);\n" ;
             current_piezo_position. x = 0.0 ;
             current_piezo_position. y = 0.0 ;
             current_piezo_height = 0.0 ;
         } else {
-            tmpfile << string_piezo_jump_relative << "("
+            body << string_piezo_jump_relative << "("
                 << fixed_number (-current_piezo_position. x, 4, false)
                 << ","
                 << fixed_number (-current_piezo_position. y, 4, false)
@@ -363,7 +369,239 @@ void dpps::Writer_witec::set_additional_parametres (
 }
 
 void dpps::Writer_witec::piezo_stabilize () {
-    tmpfile << string_stabilize<< "();\n" ;
+    body << string_stabilize<< "();\n" ;
+}
+
+void dpps::Writer_witec::write_optimized_body () {
+    // The coordinates are counted in units of 10^-4 µm, the precision of
+    // the commands, so that the merged and converted movements are exact.
+    typedef std::array<long long int, 3> Position ;
+    const long double scale {10000.0} ;
+    const long long int stepper_step {std::max (1LL, static_cast<long long int> (
+        std::llround (writer_settings. stepper_xy_relative_step * scale)))} ;
+    // For the piezo (0) and the stepper (1), whether the position is known
+    // and the position.
+    std::array<bool, 2> known {{false, false}} ;
+    std::array<Position, 2> position {{{{0, 0, 0}}, {{0, 0, 0}}}} ;
+    // The move waiting to be extended by the next ones: its device and its
+    // displacement. Without known position, it is written relative.
+    bool pending {false} ;
+    long_unsigned_int pending_device {0} ;
+    Position pending_move {{0, 0, 0}} ;
+    // The state of the shutter: 0 off, 1 on, -1 unknown, and whether a
+    // closing of the shutter waits to see whether it is opened at once.
+    int shutter {-1} ;
+    bool pending_off {false} ;
+    // whether nothing moved since the last stabilization.
+    bool stable {false} ;
+
+    auto format = [&] (const std::string &name, const Position &values,
+                       const long_unsigned_int dimension) {
+        std::string result {name + "("} ;
+        for (long_unsigned_int k {0} ; k < dimension ; k++) {
+            if (k != 0)
+                result += "," ;
+            result += fixed_number (values[k] / scale, 4, false) ;
+        }
+        return result + ");\n" ;
+    } ;
+    // Writes a movement of displacement, in the shorter form if the
+    // position is known.
+    auto write_movement = [&] (const long_unsigned_int device,
+                               const bool jump,
+                               const Position &displacement) {
+        const long_unsigned_int dimension {device == 0 ? 3UL : 2UL} ;
+        const std::string &name_absolute {device == 0 ?
+            (jump ? string_piezo_jump_absolute : string_piezo_move_absolute) :
+            (jump ? string_stepper_jump_absolute :
+                    string_stepper_move_absolute)} ;
+        const std::string &name_relative {device == 0 ?
+            (jump ? string_piezo_jump_relative : string_piezo_move_relative) :
+            (jump ? string_stepper_jump_relative :
+                    string_stepper_move_relative)} ;
+        std::string command_relative {
+            format (name_relative, displacement, dimension)} ;
+        if (known[device]) {
+            Position destination {position[device]} ;
+            for (long_unsigned_int k {0} ; k < dimension ; k++)
+                destination[k] += displacement[k] ;
+            std::string command_absolute {
+                format (name_absolute, destination, dimension)} ;
+            bool relative_allowed {device == 0 ||
+                ((displacement[0] % stepper_step == 0) &&
+                 (displacement[1] % stepper_step == 0))} ;
+            if (relative_allowed &&
+                (command_relative. size () < command_absolute. size ()))
+                file << command_relative ;
+            else
+                file << command_absolute ;
+            position[device] = destination ;
+        } else
+            file << command_relative ;
+        stable = false ;
+    } ;
+    auto flush_move = [&] () {
+        if (pending)
+            write_movement (pending_device, false, pending_move) ;
+        pending = false ;
+    } ;
+    auto flush_off = [&] () {
+        if (pending_off) {
+            file << string_shutter << "(off);\n" ;
+            shutter = 0 ;
+        }
+        pending_off = false ;
+    } ;
+
+    body. seekg (0) ;
+    std::string line ;
+    while (std::getline (body, line)) {
+        std::string name ;
+        std::vector<std::string> arguments ;
+        long_unsigned_int open_position {line. find ('(')} ;
+        bool command {(open_position != std::string::npos) &&
+                      (line. size () >= open_position + 3) &&
+                      (line. compare (line. size () - 2, 2, ");") == 0)} ;
+        if (command) {
+            name = line. substr (0, open_position) ;
+            std::string list {line. substr (open_position + 1,
+                line. size () - open_position - 3)} ;
+            if (!list. empty ())
+                arguments = split_string (list, ',', false) ;
+        }
+        // The movements, as device, jump and relative.
+        long_unsigned_int device {0} ;
+        bool jump {false} ;
+        bool relative {false} ;
+        bool movement {true} ;
+        if (!command)
+            movement = false ;
+        else if (name == string_piezo_move_absolute) {
+        } else if (name == string_piezo_move_relative)
+            relative = true ;
+        else if (name == string_piezo_jump_absolute)
+            jump = true ;
+        else if (name == string_piezo_jump_relative)
+            jump = relative = true ;
+        else if (name == string_stepper_move_absolute)
+            device = 1 ;
+        else if (name == string_stepper_move_relative) {
+            device = 1 ;
+            relative = true ;
+        } else if (name == string_stepper_jump_absolute) {
+            device = 1 ;
+            jump = true ;
+        } else if (name == string_stepper_jump_relative) {
+            device = 1 ;
+            jump = relative = true ;
+        } else
+            movement = false ;
+        Position values {{0, 0, 0}} ;
+        if (movement) {
+            movement = (arguments. size () == (device == 0 ? 3UL : 2UL)) ;
+            for (long_unsigned_int k {0} ; movement &&
+                                      (k < arguments. size ()) ; k++) {
+                char *end ;
+                double value {strtod (arguments[k]. c_str (), &end)} ;
+                movement = (end != arguments[k]. c_str ()) && (*end == 0) ;
+                values[k] = std::llround (value * scale) ;
+            }
+        }
+        if (movement) {
+            flush_off () ;
+            // position does not include the pending move yet.
+            Position displacement {values} ;
+            if (!relative && known[device])
+                for (long_unsigned_int k {0} ; k < 3 ; k++) {
+                    displacement[k] -= position[device][k] ;
+                    if (pending && (pending_device == device))
+                        displacement[k] -= pending_move[k] ;
+                }
+            if (!relative && !known[device]) {
+                // The starting point is unknown, the command is written as
+                // it is, and gives the position.
+                flush_move () ;
+                file << line << "\n" ;
+                known[device] = true ;
+                position[device] = values ;
+                stable = false ;
+                continue ;
+            }
+            if ((displacement[0] == 0) && (displacement[1] == 0) &&
+                (displacement[2] == 0))
+                continue ;
+            if (!jump && pending && (pending_device == device)) {
+                // Same direction if the cross product is null and the dot
+                // product is positive.
+                const Position &a = pending_move ;
+                const Position &b = displacement ;
+                long double cross_x {static_cast<long double> (a[1]) * b[2] -
+                                     static_cast<long double> (a[2]) * b[1]} ;
+                long double cross_y {static_cast<long double> (a[2]) * b[0] -
+                                     static_cast<long double> (a[0]) * b[2]} ;
+                long double cross_z {static_cast<long double> (a[0]) * b[1] -
+                                     static_cast<long double> (a[1]) * b[0]} ;
+                long double dot {static_cast<long double> (a[0]) * b[0] +
+                                 static_cast<long double> (a[1]) * b[1] +
+                                 static_cast<long double> (a[2]) * b[2]} ;
+                if ((cross_x == 0) && (cross_y == 0) && (cross_z == 0) &&
+                    (dot > 0)) {
+                    for (long_unsigned_int k {0} ; k < 3 ; k++)
+                        pending_move[k] += displacement[k] ;
+                    continue ;
+                }
+            }
+            flush_move () ;
+            if (jump)
+                write_movement (device, true, displacement) ;
+            else {
+                pending = true ;
+                pending_device = device ;
+                pending_move = displacement ;
+            }
+            continue ;
+        }
+        flush_move () ;
+        if (command && (name == string_shutter) && (arguments. size () == 1)) {
+            if (arguments[0] == "off") {
+                if (shutter != 0)
+                    pending_off = true ;
+                continue ;
+            }
+            if (arguments[0] == "on") {
+                if (pending_off)
+                    // closed and opened again at once
+                    pending_off = false ;
+                else if (shutter != 1)
+                    file << line << "\n" ;
+                shutter = 1 ;
+                continue ;
+            }
+        }
+        flush_off () ;
+        if (command && (name == string_stabilize)) {
+            if (!stable)
+                file << line << "\n" ;
+            stable = true ;
+            continue ;
+        }
+        file << line << "\n" ;
+        if (command && (name == string_stepper_z_move))
+            stable = false ;
+        // The comments and the commands which do not move the stage keep
+        // what is known, the other ones might change anything.
+        bool neutral {!command || (name == string_speed) ||
+                      (name == string_sleep) || (name == string_message) ||
+                      (name == string_snapshot) ||
+                      (name == string_stepper_z_move)} ;
+        if (!neutral) {
+            known[0] = known[1] = false ;
+            shutter = -1 ;
+            stable = false ;
+        }
+    }
+    flush_move () ;
+    flush_off () ;
 }
 
 void dpps::Writer_witec::set_all_parametres (
@@ -444,6 +682,8 @@ void dpps::Writer_witec::set_all_parametres (
         default:
             break ;
     }
+    // the decompositions depend on the quadrants
+    decomposition_cache. clear () ;
     capture_name = filename ;
     std::string::size_type pos {capture_name. find_last_of ('.')} ;
     if (pos != std::string::npos)
@@ -519,12 +759,36 @@ accuracy"} ;
         }
     writer_settings. focus_position. push_back (position) ;
     writer_settings. focus_value. push_back (value) ;
+    focus_grid_built = false ;
 
 }
 
 void dpps::Writer_witec::clear_focus_points () {
     writer_settings. focus_position. clear () ;
     writer_settings. focus_value. clear () ;
+    focus_grid_built = false ;
+}
+
+void dpps::Writer_witec::set_travel_planning (const bool plan_travel,
+                                              const bool reverse_polylines) {
+    writer_settings. plan_travel = plan_travel ;
+    writer_settings. reverse_polylines = reverse_polylines ;
+}
+
+void dpps::Writer_witec::set_polyline_chaining (const bool chain_polylines,
+                                                const double tolerance) {
+    if (tolerance < 0) {
+        std::string reason {"Writer_witec::set_polyline_chaining, tolerance \
+must be positive or zero, but it is " + std::to_string (tolerance)} ;
+        throw bad_parametre (reason. c_str ()) ;
+    }
+    writer_settings. chain_polylines = chain_polylines ;
+    writer_settings. chain_tolerance = tolerance ;
+}
+
+void dpps::Writer_witec::set_command_optimization (
+    const bool optimize_commands) {
+    writer_settings. optimize_commands = optimize_commands ;
 }
 
 void dpps::Writer_witec::set_parametres (
@@ -608,45 +872,62 @@ static long_unsigned_int next_contiguous (
 
 std::vector<dpps::Polyline> dpps::Writer_witec::
     decompose_polyline_no_hysteresis_paths (const dpps::Polyline &p) {
+    // The quadrants only depend on the differences between successive
+    // vertices, which are the key, written exactly.
+    std::string key ;
+    key. reserve (2 * sizeof (double) * p. size ()) ;
+    for (long_unsigned_int i {1} ; i < p. size () ; i++) {
+        double difference[2] {p. vertices[i]. x - p. vertices[i-1]. x,
+                              p. vertices[i]. y - p. vertices[i-1]. y} ;
+        key. append (reinterpret_cast<const char *> (difference),
+                     sizeof (difference)) ;
+    }
+    auto found = decomposition_cache. find (key) ;
+    if (found == decomposition_cache. end ()) {
+        std::vector<Sub_path> paths ;
+        long_unsigned_int current_pos {0} ;
+        long_unsigned_int new_pos {0} ;
+        while (new_pos < p. size ()-1) {
+            new_pos = next_contiguous  (p, current_pos, correct) ;
+            if (new_pos != current_pos) {
+                paths. push_back ({current_pos, new_pos, false}) ;
+                current_pos = new_pos ;
+            }
+            new_pos = next_contiguous (p, current_pos, opposite) ;
+            if (new_pos != current_pos) {
+                // For the opposite direction we want to draw them in reverse
+                // order so that they actually will be in the correct
+                // direction.
+                paths. push_back ({current_pos, new_pos, true}) ;
+                current_pos = new_pos ;
+            }
+            new_pos = next_contiguous (p, current_pos, lateral) ;
+            if (new_pos != current_pos) {
+                paths. push_back ({current_pos, new_pos, false}) ;
+                current_pos = new_pos ;
+            }
+        }
+        // The shapes of a pattern are usually few, a bound keeps the memory
+        // used small when they are not.
+        if (decomposition_cache. size () >= 65536)
+            decomposition_cache. clear () ;
+        found = decomposition_cache. emplace (key, std::move (paths)). first ;
+    }
+
     std::vector<dpps::Polyline> result ;
     // the sub-polylines will be based on the enclosing one to keep
     // the parametres (dose), except they must be open.
     dpps::Polyline q {p} ;
     q. closed = false ;
-
-    long_unsigned_int current_pos {0} ;
-    long_unsigned_int new_pos {0} ;
-    while (new_pos < p. size ()-1) {
-        new_pos = next_contiguous  (p, current_pos, correct) ;
-        if (new_pos != current_pos) {
-            q. vertices. clear () ;
-            q. vertices. insert (q. vertices. end (),
-                                p. vertices. begin () + current_pos,
-                                p. vertices. begin () + new_pos + 1) ;
-            result. push_back (q) ;
-            current_pos = new_pos ;
-        }
-        new_pos = next_contiguous (p, current_pos, opposite) ;
-        if (new_pos != current_pos) {
-            q. vertices. clear () ;
-            q. vertices. insert (q. vertices. end (),
-                                p. vertices. begin () + current_pos,
-                                p. vertices. begin () + new_pos + 1) ;
-            // For the opposite direction we want to draw them in reverse
-            // order so that they actually will be in the correct direction.
+    // the reference &path is used to avoid copy
+    for (const Sub_path &path: found-> second) {
+        q. vertices. clear () ;
+        q. vertices. insert (q. vertices. end (),
+                            p. vertices. begin () + path. first,
+                            p. vertices. begin () + path. last + 1) ;
+        if (path. reversed)
             std::reverse (q. vertices. begin (), q. vertices. end ()) ;
-            result. push_back (q) ;
-            current_pos = new_pos ;
-        }
-        new_pos = next_contiguous (p, current_pos, lateral) ;
-        if (new_pos != current_pos) {
-            q. vertices. clear () ;
-            q. vertices. insert (q. vertices. end (),
-                                p. vertices. begin () + current_pos,
-                                p. vertices. begin () + new_pos + 1) ;
-            result. push_back (q) ;
-            current_pos = new_pos ;
-        }
+        result. push_back (q) ;
     }
     return result ;
 }
@@ -735,6 +1016,7 @@ bool dpps::Writer_witec::polyline_crosses_field_border (
 void dpps::Writer_witec::write_Polyline (const Polyline &polyline) {
     if (polyline. size () == 0)
         return ;
+    double duration_before {get_estimated_duration ()} ;
     if (writer_settings. focus_correction && polyline. is_self_crossing ()) {
         std::string comment {"WARNING: when focus correction is activated, \
 self-crossing polylines are not advised as geometrical_centre() might not \
@@ -743,14 +1025,6 @@ give the expected result. Self-crossing polyline: " +
         emit_comment (comment) ;
     }
 
-    if ((writer_settings. take_snapshot_every > 0) &&
-        ((move_number + dot_number) %
-            writer_settings. take_snapshot_every == 0) /*&& !just_took_snapshot*/) {
-        // Note that second argument is set to 1 for colour.
-        tmpfile << string_snapshot << "(\"" << capture_name << "\", 1);\n" ;
-        //just_took_snapshot = true ;
-    }
-
     // The API we designed (write_Polyline is inherited from base class Writer)
     // imposes passing by const reference but we need to alter it, so we'll
     // make a copy.
@@ -787,6 +1061,23 @@ give the expected result. Self-crossing polyline: " +
             p. vertices. push_back (p. vertices. front ()) ;
     }
 
+    bool snapshot {(writer_settings. take_snapshot_every > 0) &&
+        ((move_number + dot_number) %
+            writer_settings. take_snapshot_every == 0)} ;
+    // The shutter left open by the previous polyline is closed unless this
+    // one continues it.
+    if (chain_open) {
+        chained = !snapshot && chain_continues (p) ;
+        chain_open = false ;
+        if (!chained)
+            lithography_off () ;
+    }
+    if (snapshot /*&& !just_took_snapshot*/) {
+        // Note that second argument is set to 1 for colour.
+        body << string_snapshot << "(\"" << capture_name << "\", 1);\n" ;
+        //just_took_snapshot = true ;
+    }
+
     if (writer_settings. xy_by_piezo) {
         if ((p. horizontal_size () <= writer_settings. field_size_x) &&
             (p. vertical_size () <= writer_settings. field_size_y))
@@ -801,6 +1092,16 @@ give the expected result. Self-crossing polyline: " +
     }
     else
         write_polyline_stepper (p) ;
+    chained = false ;
+
+    if (simulation) {
+        double spent {get_estimated_duration () - duration_before} ;
+        long signed int i ;
+        long signed int j ;
+        get_field_number (i, j, polyline. geometrical_centre ()) ;
+        field_durations[Field_number (i, j)] += spent ;
+        reference_durations[polyline. reference] += spent ;
+    }
 }
 
 void dpps::Writer_witec::write_polyline_piezo (Polyline &p) {
@@ -846,9 +1147,6 @@ void dpps::Writer_witec::write_polyline_piezo (Polyline &p) {
 //     // now minx, etc. are in the first field where gc.x and gc.y are positive.
 //     if ((minx < 0) || (maxx > writer_settings. field_size_x) ||
 //         (miny < 0) || (maxy > writer_settings. field_size_y)) {
-    std::string comment {"Starting piezo lithography of polyline " +
-        p. display_string ()} ;
-    emit_comment (comment) ;
     if (polyline_crosses_field_border (p)) {
         lithography_off () ;
         emit_comment ("Polyline crosses a field border : " +
@@ -874,6 +1172,14 @@ void dpps::Writer_witec::write_polyline_piezo (Polyline &p) {
         }
     }
 
+    // The comment follows the change of field, so that the program of each
+    // field starts with the move to it, see write_Pattern_by_field().
+    if (comments_emitted ()) {
+        std::string comment {"Starting piezo lithography of polyline " +
+            p. display_string ()} ;
+        emit_comment (comment) ;
+    }
+
     // Now we expose the polyline with the piezo.
     // Polyline which are closed were already appended their final dot
     if (p. size () == 1) {
@@ -884,14 +1190,21 @@ void dpps::Writer_witec::write_polyline_piezo (Polyline &p) {
         lithography_off () ;
         return ;
     }
-    piezo_jump_to (p. vertices[0]-current_stepper_position) ;
-    piezo_stabilize () ;
+    if (chained) {
+        // The shutter is still open, see set_polyline_chaining().
+        chained = false ;
+        if (current_piezo_position != p. vertices[0]-current_stepper_position)
+            piezo_move_to (p. vertices[0]-current_stepper_position, p. dose) ;
+    } else {
+        piezo_jump_to (p. vertices[0]-current_stepper_position) ;
+        piezo_stabilize () ;
+    }
     for (long_unsigned_int i = 1 ; i < p. vertices. size () ; i++) {
         piezo_lithography_on ((current_piezo_position + p. vertices[i]) /2.0,
             writer_settings. correct_focus_inside_polylines || (i == 1)) ;
         piezo_move_to(p. vertices[i]-current_stepper_position, p. dose) ;
     }
-    lithography_off() ;
+    end_exposure (p) ;
 }
 
 void dpps::Writer_witec::go_stepper_to (const Vertex &position) {
@@ -926,15 +1239,18 @@ void dpps::Writer_witec::go_stepper_to (const Vertex &position) {
 void dpps::Writer_witec::write_polyline_stepper (Polyline &p) {
     if (p. size () == 1) {
         // Single dots
-        std::string comment {"Will do single dot at " + p. display_string () +
-            " for duration " + std::to_string (p. dose) + " ms"} ;
-        emit_comment (comment) ;
+        if (comments_emitted ()) {
+            std::string comment {"Will do single dot at " +
+                p. display_string () + " for duration " +
+                std::to_string (p. dose) + " ms"} ;
+            emit_comment (comment) ;
+        }
         go_stepper_to (p. vertices [0]) ;
         stepper_lithography_on (p. vertices [0], true) ;
         sleep (p. dose) ;
         lithography_off () ;
         return ;
-    } else {
+    } else if (comments_emitted ()) {
         std::string comment {"Will write polyline " + p. display_string ()} ;
         emit_comment (comment) ;
     }
@@ -952,7 +1268,14 @@ void dpps::Writer_witec::write_polyline_stepper (Polyline &p) {
         // to compensate hysteresis. The cases are:
         // - if we need to move, or
         // - if we know we need to compensate for hysteresis
-        go_stepper_to (q. vertices [0]) ;
+        // If the shutter is still open, we just move to the start, see
+        // set_polyline_chaining().
+        if (chained) {
+            chained = false ;
+            if (q. vertices[0] != current_stepper_position)
+                stepper_move_to (q. vertices[0], p. dose) ;
+        } else
+            go_stepper_to (q. vertices [0]) ;
         // Now we can do this whole polyline without thinking of hysteresis
         // problems.
         // Skipping the first dot, we already moved there.
@@ -978,6 +1301,61 @@ void dpps::Writer_witec::write_polyline_stepper (Polyline &p) {
             }
         }
     }
+    end_exposure (p) ;
+}
+
+bool dpps::Writer_witec::chain_continues (const Polyline &p) const {
+    if (!writer_settings. chain_polylines || !writer_settings. litho_by_shutter
+        || !triggered || (p. size () < 2) ||
+        (fabs (p. dose - chain_dose) > speed_unit * 0.01))
+        return false ;
+    if (writer_settings. xy_by_piezo) {
+        // The polyline must be written by the piezo in the current field,
+        // see write_Polyline() and write_polyline_piezo().
+        if ((p. horizontal_size () > writer_settings. field_size_x) ||
+            (p. vertical_size () > writer_settings. field_size_y) ||
+            polyline_crosses_field_border (p))
+            return false ;
+        long signed int i1 ;
+        long signed int j1 ;
+        long signed int i2 ;
+        long signed int j2 ;
+        get_field_number (i1, j1, current_stepper_position) ;
+        get_field_number (i2, j2, p. geometrical_centre ()) ;
+        if ((i1 != i2) || (j1 != j2))
+            return false ;
+        return (current_stepper_position + current_piezo_position -
+                p. vertices[0]). norm2 () <= writer_settings. chain_tolerance ;
+    }
+    if ((current_stepper_position - p. vertices[0]). norm2 () >
+        writer_settings. chain_tolerance)
+        return false ;
+    if (writer_settings. hysteresis_quadrant == hysteresis_no_correction)
+        return true ;
+    // As in go_stepper_to(), the move to the first vertex must not need a
+    // correction, and as in decompose_polyline_no_hysteresis_paths(), the
+    // first sub-polyline must start at the first vertex.
+    if (!status_hysteresis_ok ||
+        (current_hysteresis_quadrant != writer_settings. hysteresis_quadrant))
+        return false ;
+    enum_quadrant gap {current_stepper_position. quadrant (p. vertices[0])} ;
+    enum_quadrant first {p. vertices[0]. quadrant (p. vertices[1])} ;
+    auto in = [] (const enum_quadrant q,
+                  const std::array<enum_quadrant, 3> &quadrants) {
+        return std::find (quadrants. begin (), quadrants. end (), q) !=
+               quadrants. end () ;
+    } ;
+    return ((gap == quadrant_centre) || in (gap, correct)) &&
+           (in (first, correct) || in (first, lateral)) ;
+}
+
+void dpps::Writer_witec::end_exposure (const Polyline &p) {
+    if (writer_settings. chain_polylines && writer_settings. litho_by_shutter
+        && triggered && (p. size () > 1)) {
+        chain_open = true ;
+        chain_dose = p. dose ;
+        return ;
+    }
     lithography_off () ;
 }
 
@@ -1173,92 +1551,663 @@ bool dpps::Writer_witec::compare_height_x_y (
 void dpps::Writer_witec::get_extremum_altitude_from_pattern (
     const Pattern &pattern,
     const selection_t selection) {
-    Pattern q {Pattern_factory::Pattern_from_selected (pattern, selection)} ;
-    if (writer_settings. correct_focus_inside_polylines)
-        q. explode (selection) ;
-    Pattern r ;
+check_selection_not_too_high(selection) ;
+    // Only the first polyline in the order of compare_height() is needed.
+    // It is searched among the selected polylines (or their segments) and
+    // the focus positions without copying them, keeping the first one
+    // in case of equality as std::partial_sort() would.
+    Polyline extremum ;
+    bool found {false} ;
+    auto consider = [&] (const Polyline &p) {
+        if (!found || compare_height (p, extremum)) {
+            extremum = p ;
+            found = true ;
+        }
+    } ;
+    // the reference &p is used to avoid copy
+    for (auto &p: pattern. polylines)
+        if ((selection < 0) || p. selected[selection]) {
+            if (writer_settings. correct_focus_inside_polylines) {
+                Pattern segments {Pattern_factory::explode (p)} ;
+                for (auto &segment: segments. polylines)
+                    consider (segment) ;
+            } else
+                consider (p) ;
+        }
     for (auto i: writer_settings. focus_position)
-        r. push_back (Polyline (i)) ;
-    q. append_from (r) ;
-
-    std::partial_sort (q. polylines. begin (),
-                       q. polylines. begin () + 1,
-                       q. polylines. end (),
-                       std::bind (&Writer_witec::compare_height, this,
-                            std::placeholders::_1, std::placeholders::_2)) ;
-    extremum_altitude_position = q. polylines. front (). geometrical_centre () ;
+        consider (Polyline (i)) ;
+    if (!found)
+        return ;
+    extremum_altitude_position = extremum. geometrical_centre () ;
     extremum_altitude = interpolate_height (extremum_altitude_position) ;
 
 }
 
+// The selected polylines of pattern and the polylines drawn by its selected
+// instances, which are reordered together.
+static dpps::Pattern flattened_selection (const dpps::Pattern &pattern,
+                                          const selection_t selection) {
+    dpps::Pattern result ;
+    // the reference &p is used to avoid copy
+    for (auto &p: pattern. polylines)
+        if ((selection < 0) || p. selected[selection])
+            result. polylines. push_back (p) ;
+    pattern. for_each_instance_polyline (
+        [&result] (const dpps::Polyline &p) {
+            result. polylines. push_back (p) ;
+        }, selection) ;
+    return result ;
+}
+
 void dpps::Writer_witec::write_Pattern_selected (const Pattern &pattern,
                                                  const selection_t selection) {
+    if (!pattern. instances. empty ()) {
+        write_Pattern_selected (flattened_selection (pattern, selection), -1) ;
+        return ;
+    }
     if (pattern. size (selection) == 0)
         return ;
     if (writer_settings. hysteresis_quadrant != hysteresis_no_correction)
         get_reference_position_from_pattern (pattern, selection) ;
     if (writer_settings. focus_correction) {
-        get_extremum_altitude_from_pattern (pattern, selection) ;
-        if (writer_settings. stepper_reorder == stepper_reorder_zdown_x_y ||
-            writer_settings. stepper_reorder == stepper_reorder_zdown_y_x)
-            tmpfile << "/* Maximum " ;
-        else
-            tmpfile << "/* Minimum " ;
-        tmpfile << " z value of sample found at "
-                << extremum_altitude_position. display_string ()
-                << " (altitude " << extremum_altitude
-                << " µm) please go there and focus,"
-                << " then go back to (0,0) */\n" ;
-        // We assume user follows our instruction and focused there,
-        // we set the current height accordingly
-        current_stepper_height = extremum_altitude ;
-        if (writer_settings. xy_by_piezo || writer_settings. focus_by_piezo) {
-            tmpfile << string_set_origin << "(0,0,0);\n" ;
-            current_piezo_height = 0.0 ;
-        }
+        prepare_focus_correction (pattern, selection) ;
         if (writer_settings. stepper_reorder == stepper_reorder_none) {
             if (writer_settings. xy_by_piezo) {
-                Pattern q {Pattern_factory::Pattern_from_selected (
-                    pattern, selection)} ;
-                // See N. Josuttis (2012), section 11.9.1 pages 597-598
-                std::sort (q. polylines. begin (), q. polylines. end (),
-                    std::bind (&Writer_witec::compare_x_y_field, this,
-                        std::placeholders::_1, std::placeholders::_2)) ;
-                Writer::write_Pattern_selected (q, selection) ;
-            } else
+                // write_planned_view() groups the polylines by field itself.
+                if (writer_settings. plan_travel)
+                    write_planned_view (selected_view (pattern, selection)) ;
+                else
+                    write_Polyline_view (sorted_by_field (
+                        selected_view (pattern, selection))) ;
+            } else if (writer_settings. plan_travel)
+                write_planned_view (selected_view (pattern, selection)) ;
+            else
                 Writer::write_Pattern_selected (pattern, selection) ;
         } else {
-            Pattern q {Pattern_factory::Pattern_from_selected (
-                pattern, selection)} ;
-            std::sort (q. polylines. begin (), q. polylines. end (),
-                std::bind (&Writer_witec::compare_height_x_y, this,
-                    std::placeholders::_1, std::placeholders::_2)) ;
-            Writer::write_Pattern_selected (q, selection) ;
+            std::vector<const Polyline *> view {
+                selected_view (pattern, selection)} ;
+            std::sort (view. begin (), view. end (),
+                [this] (const Polyline *p, const Polyline *q) {
+                    return compare_height_x_y (*p, *q) ;
+                }) ;
+            write_Polyline_view (view) ;
         }
-    } else
+    } else if (writer_settings. plan_travel)
+        write_planned_view (selected_view (pattern, selection)) ;
+    else
         Writer::write_Pattern_selected (pattern, selection) ;
 }
 
+void dpps::Writer_witec::prepare_focus_correction (const Pattern &pattern,
+    const selection_t selection) {
+    get_extremum_altitude_from_pattern (pattern, selection) ;
+    if (writer_settings. stepper_reorder == stepper_reorder_zdown_x_y ||
+        writer_settings. stepper_reorder == stepper_reorder_zdown_y_x)
+        body << "/* Maximum " ;
+    else
+        body << "/* Minimum " ;
+    body << " z value of sample found at "
+            << extremum_altitude_position. display_string ()
+            << " (altitude " << extremum_altitude
+            << " µm) please go there and focus,"
+            << " then go back to (0,0) */\n" ;
+    // We assume user follows our instruction and focused there,
+    // we set the current height accordingly
+    current_stepper_height = extremum_altitude ;
+    if (writer_settings. xy_by_piezo || writer_settings. focus_by_piezo) {
+        body << string_set_origin << "(0,0,0);\n" ;
+        current_piezo_height = 0.0 ;
+    }
+}
+
+void dpps::Writer_witec::plan_travel_of (
+    const std::vector<const Polyline *> &view,
+    Vertex &position,
+    std::vector<const Polyline *> &planned,
+    std::vector<bool> &reversed,
+    double &length_before,
+    double &length_after) {
+    if (view. empty ())
+        return ;
+    Travel_planner planner (view, writer_settings. reverse_polylines) ;
+    std::vector<Travel_planner::Step> unchanged ;
+    for (long_unsigned_int i {0} ; i < view. size () ; i++)
+        unchanged. push_back (Travel_planner::Step {i, false}) ;
+    length_before += planner. jump_length (unchanged, position) ;
+    std::vector<Travel_planner::Step> steps {planner. plan (position)} ;
+    length_after += planner. jump_length (steps, position) ;
+    // the reference &s is used to avoid copy
+    for (auto &s: steps) {
+        const Polyline &p = *view[s. index] ;
+        planned. push_back (&p) ;
+        reversed. push_back (s. reversed) ;
+        // same end as in write_Polyline()
+        if (s. reversed || (p. closed && (p. size () >= 3)))
+            position = p. vertices. front () ;
+        else
+            position = p. vertices. back () ;
+    }
+}
+
+void dpps::Writer_witec::group_by_field (
+    const std::vector<const Polyline *> &view,
+    std::map<Field_number, std::vector<const Polyline *>> &fields,
+    std::vector<const Polyline *> &crossing,
+    std::vector<const Polyline *> &large) const {
+    for (auto p: view) {
+        if (p-> size () == 0)
+            continue ;
+        if ((p-> horizontal_size () > writer_settings. field_size_x) ||
+            (p-> vertical_size () > writer_settings. field_size_y))
+            large. push_back (p) ;
+        else if (polyline_crosses_field_border (*p))
+            crossing. push_back (p) ;
+        else {
+            long signed int i ;
+            long signed int j ;
+            get_field_number (i, j, p-> geometrical_centre ()) ;
+            fields[Field_number (i, j)]. push_back (p) ;
+        }
+    }
+}
+
+std::vector<dpps::Writer_witec::Field_number>
+dpps::Writer_witec::planned_fields (
+    const std::map<Field_number, std::vector<const Polyline *>> &fields,
+    const Vertex &position) const {
+    // The fields are ordered as dots at their centres, where the stepper
+    // goes to write them.
+    std::vector<Field_number> numbers ;
+    std::vector<Polyline> centres ;
+    // the reference &f is used to avoid copy
+    for (auto &f: fields) {
+        numbers. push_back (f. first) ;
+        centres. push_back (Polyline (get_field_centre_position (
+            f. first. first, f. first. second))) ;
+    }
+    std::vector<const Polyline *> centre_view ;
+    // the reference &c is used to avoid copy
+    for (auto &c: centres)
+        centre_view. push_back (&c) ;
+    Travel_planner planner (centre_view, false) ;
+    std::vector<Field_number> result ;
+    // the reference &s is used to avoid copy
+    for (auto &s: planner. plan (position))
+        result. push_back (numbers[s. index]) ;
+    return result ;
+}
+
+void dpps::Writer_witec::order_by_field (
+    const std::vector<const Polyline *> &view,
+    std::vector<Field_number> &numbers,
+    std::vector<std::vector<const Polyline *>> &ordered,
+    std::vector<const Polyline *> &others) const {
+    // Each polyline is put once in its category, with its geometrical centre,
+    // so that neither the centre nor the field are computed again when
+    // sorting.
+    typedef std::pair<Vertex, const Polyline *> Centred ;
+    std::map<Field_number, std::vector<Centred>> fields ;
+    std::vector<Centred> crossing ;
+    std::vector<Centred> large ;
+    for (auto p: view) {
+        if (p-> size () == 0)
+            continue ;
+        Vertex centre {p-> geometrical_centre ()} ;
+        if ((p-> horizontal_size () > writer_settings. field_size_x) ||
+            (p-> vertical_size () > writer_settings. field_size_y))
+            large. push_back (Centred (centre, p)) ;
+        else if (polyline_crosses_field_border (*p))
+            crossing. push_back (Centred (centre, p)) ;
+        else {
+            long signed int i ;
+            long signed int j ;
+            get_field_number (i, j, centre) ;
+            fields[Field_number (i, j)]. push_back (Centred (centre, p)) ;
+        }
+    }
+
+    // The stepper goes in the direction given by the hysteresis quadrant, so
+    // that it does not need to correct the hysteresis between fields. Without
+    // correction, the columns of fields are alternatively gone up and down.
+    bool increasing_x {
+        (writer_settings. hysteresis_quadrant != hysteresis_quadrant_mxpy) &&
+        (writer_settings. hysteresis_quadrant != hysteresis_quadrant_mxmy)} ;
+    bool increasing_y {
+        (writer_settings. hysteresis_quadrant != hysteresis_quadrant_pxmy) &&
+        (writer_settings. hysteresis_quadrant != hysteresis_quadrant_mxmy)} ;
+    bool alternate {
+        writer_settings. hysteresis_quadrant == hysteresis_no_correction} ;
+
+    auto append_sorted = [increasing_x] (std::vector<Centred> &c,
+                                         const bool up,
+                                         std::vector<const Polyline *> &result) {
+        std::stable_sort (c. begin (), c. end (),
+            [increasing_x, up] (const Centred &a, const Centred &b) {
+                if (a. first. x != b. first. x)
+                    return increasing_x ? (a. first. x < b. first. x) :
+                                          (a. first. x > b. first. x) ;
+                return up ? (a. first. y < b. first. y) :
+                            (a. first. y > b. first. y) ;
+            }) ;
+        // the reference &p is used to avoid copy
+        for (auto &p: c)
+            result. push_back (p. second) ;
+    } ;
+
+    // The map is ordered by i then j, which gives the columns of fields.
+    std::vector<std::vector<Field_number>> columns ;
+    // the reference &f is used to avoid copy
+    for (auto &f: fields) {
+        if (columns. empty () ||
+            (columns. back (). front (). first != f. first. first))
+            columns. push_back (std::vector<Field_number> ()) ;
+        columns. back (). push_back (f. first) ;
+    }
+    if (!increasing_x)
+        std::reverse (columns. begin (), columns. end ()) ;
+    bool up {increasing_y} ;
+    // the reference &c is used to avoid copy
+    for (auto &c: columns) {
+        if (!up)
+            std::reverse (c. begin (), c. end ()) ;
+        // the reference &f is used to avoid copy
+        for (auto &f: c) {
+            numbers. push_back (f) ;
+            ordered. push_back (std::vector<const Polyline *> ()) ;
+            append_sorted (fields[f], up, ordered. back ()) ;
+        }
+        if (alternate)
+            up = !up ;
+    }
+    append_sorted (crossing, increasing_y, others) ;
+    append_sorted (large, increasing_y, others) ;
+}
+
+std::vector<const dpps::Polyline *> dpps::Writer_witec::sorted_by_field (
+    const std::vector<const Polyline *> &view) const {
+    std::vector<Field_number> numbers ;
+    std::vector<std::vector<const Polyline *>> ordered ;
+    std::vector<const Polyline *> others ;
+    order_by_field (view, numbers, ordered, others) ;
+    std::vector<const Polyline *> result ;
+    result. reserve (view. size ()) ;
+    // the reference &f is used to avoid copy
+    for (auto &f: ordered)
+        result. insert (result. end (), f. begin (), f. end ()) ;
+    result. insert (result. end (), others. begin (), others. end ()) ;
+    return result ;
+}
+
+
+void dpps::Writer_witec::write_planned_view (
+    const std::vector<const Polyline *> &view) {
+    std::vector<const Polyline *> planned ;
+    std::vector<bool> reversed ;
+    planned. reserve (view. size ()) ;
+    reversed. reserve (view. size ()) ;
+    Vertex position {current_stepper_position + current_piezo_position} ;
+    double length_before {0} ;
+    double length_after {0} ;
+    if (writer_settings. xy_by_piezo) {
+        std::map<Field_number, std::vector<const Polyline *>> fields ;
+        std::vector<const Polyline *> crossing ;
+        std::vector<const Polyline *> large ;
+        group_by_field (view, fields, crossing, large) ;
+        // the reference &f is used to avoid copy
+        for (auto &f: planned_fields (fields, position))
+            plan_travel_of (fields[f], position, planned, reversed,
+                            length_before, length_after) ;
+        plan_travel_of (crossing, position, planned, reversed,
+                        length_before, length_after) ;
+        plan_travel_of (large, position, planned, reversed,
+                        length_before, length_after) ;
+    } else {
+        std::vector<const Polyline *> not_empty ;
+        for (auto p: view)
+            if (p-> size () > 0)
+                not_empty. push_back (p) ;
+        plan_travel_of (not_empty, position, planned, reversed,
+                        length_before, length_after) ;
+    }
+    emit_comment ("Travel planning: jump length reduced from " +
+                  std::to_string (length_before) + " µm to " +
+                  std::to_string (length_after) + " µm") ;
+    write_header () ;
+    write_field (planned, reversed) ;
+    write_footer () ;
+}
+
+void dpps::Writer_witec::write_field (
+    const std::vector<const Polyline *> &polylines,
+    const std::vector<bool> &reversed) {
+    for (long_unsigned_int i {0} ; i < polylines. size () ; i++) {
+        if (reversed[i]) {
+            Polyline p {*polylines[i]} ;
+            p. reverse_vertices () ;
+            write_Polyline (p) ;
+        } else
+            write_Polyline (*polylines[i]) ;
+    }
+    // Each field ends with the shutter closed, so that they can be joined.
+    if (chain_open)
+        lithography_off () ;
+}
+
 void dpps::Writer_witec::write_Pattern (const Pattern &pattern) {
-    Pattern q {pattern} ;
-    q. select (logical_action_all, 0) ;
-    write_Pattern_selected (q, 0) ;
+    // A negative selection means all polylines, there is no need to copy
+    // the pattern to select them all.
+    write_Pattern_selected (pattern, -1) ;
+}
+
+double dpps::Writer_witec::get_estimated_duration () const {
+    return jump_duration + move_duration + dot_duration + shutter_duration ;
+}
+
+double dpps::Writer_witec::get_field_duration (const long signed int i,
+                                               const long signed int j) const {
+    auto found = field_durations. find (Field_number (i, j)) ;
+    if (found == field_durations. end ())
+        return 0.0 ;
+    return found-> second ;
+}
+
+double dpps::Writer_witec::get_reference_duration (
+    const long_unsigned_int reference) const {
+    auto found = reference_durations. find (reference) ;
+    if (found == reference_durations. end ())
+        return 0.0 ;
+    return found-> second ;
+}
+
+std::string dpps::Writer_witec::get_simulation_report () const {
+    double total {get_estimated_duration ()} ;
+    std::string result {"Estimated duration: " + std::to_string (total) +
+        " s (jumps " + std::to_string (jump_duration) +
+        " s, moves " + std::to_string (move_duration) +
+        " s, dots " + std::to_string (dot_duration) +
+        " s, shutter " + std::to_string (shutter_duration) + " s)\n"} ;
+    double other {total} ;
+    // the reference &f is used to avoid copy
+    for (auto &f: field_durations) {
+        result += "Field (" + std::to_string (f. first. first) + ", " +
+                  std::to_string (f. first. second) + "): " +
+                  std::to_string (f. second) + " s\n" ;
+        other -= f. second ;
+    }
+    // the reference &r is used to avoid copy
+    for (auto &r: reference_durations)
+        result += "Reference " + std::to_string (r. first) + ": " +
+                  std::to_string (r. second) + " s\n" ;
+    result += "Other: " + std::to_string (other) + " s\n" ;
+    return result ;
+}
+
+void dpps::Writer_witec::add_durations_of (const Writer_witec &w) {
+    move_number += w. move_number ;
+    jump_number += w. jump_number ;
+    dot_number += w. dot_number ;
+    shutter_number += w. shutter_number ;
+    move_distance += w. move_distance ;
+    jump_distance += w. jump_distance ;
+    move_duration += w. move_duration ;
+    jump_duration += w. jump_duration ;
+    dot_duration += w. dot_duration ;
+    shutter_duration += w. shutter_duration ;
+    // the reference &f is used to avoid copy
+    for (auto &f: w. field_durations)
+        field_durations[f. first] += f. second ;
+    // the reference &r is used to avoid copy
+    for (auto &r: w. reference_durations)
+        reference_durations[r. first] += r. second ;
+}
+
+void dpps::Writer_witec::simulate_by_field (const Pattern &pattern,
+                                            const selection_t selection) {
+    if (!simulation) {
+        std::string reason {"Writer_witec::simulate_by_field can only be \
+used in a simulation."} ;
+        throw bad_parametre (reason. c_str ()) ;
+    }
+    write_Pattern_by_field (pattern, selection) ;
+}
+
+bool dpps::Writer_witec::Field_state::matches (const Field_state &s) const {
+    // The positions are written with 4 decimals, so that smaller differences
+    // only come from the rounding of the sums of relative movements.
+    static const constexpr double tolerance {1e-9} ;
+    return (fabs (stepper_position. x - s. stepper_position. x) < tolerance) &&
+           (fabs (stepper_position. y - s. stepper_position. y) < tolerance) &&
+           (fabs (piezo_position. x - s. piezo_position. x) < tolerance) &&
+           (fabs (piezo_position. y - s. piezo_position. y) < tolerance) &&
+           (fabs (stepper_height - s. stepper_height) < tolerance) &&
+           (fabs (piezo_height - s. piezo_height) < tolerance) &&
+           (moving_speed == s. moving_speed) &&
+           (triggered == s. triggered) &&
+           (focused == s. focused) ;
+}
+
+dpps::Writer_witec::Field_state dpps::Writer_witec::get_field_state () const {
+    Field_state s ;
+    s. stepper_position = current_stepper_position ;
+    s. piezo_position = current_piezo_position ;
+    s. stepper_height = current_stepper_height ;
+    s. piezo_height = current_piezo_height ;
+    s. moving_speed = current_moving_speed ;
+    s. triggered = triggered ;
+    s. focused = focused ;
+    return s ;
+}
+
+void dpps::Writer_witec::set_field_state (const Field_state &s) {
+    current_stepper_position = s. stepper_position ;
+    current_piezo_position = s. piezo_position ;
+    current_stepper_height = s. stepper_height ;
+    current_piezo_height = s. piezo_height ;
+    current_moving_speed = s. moving_speed ;
+    triggered = s. triggered ;
+    focused = s. focused ;
+}
+
+void dpps::Writer_witec::start_field_writer (Writer_witec &w,
+                                             const Field_state &s) const {
+    w. simulation = simulation ;
+    if (!simulation)
+        w. body. clear () ;
+    w. writer_settings = writer_settings ;
+    w. capture_name = capture_name ;
+    w. correct = correct ;
+    w. opposite = opposite ;
+    w. lateral = lateral ;
+    w. reference_position = reference_position ;
+    w. current_hysteresis_quadrant = current_hysteresis_quadrant ;
+    w. status_hysteresis_ok = status_hysteresis_ok ;
+    w. extremum_altitude = extremum_altitude ;
+    w. extremum_altitude_position = extremum_altitude_position ;
+    w. focus_grid = focus_grid ;
+    w. focus_grid_built = focus_grid_built ;
+    w. focus_grid_minimum = focus_grid_minimum ;
+    w. focus_grid_maximum = focus_grid_maximum ;
+    w. set_field_state (s) ;
+}
+
+void dpps::Writer_witec::append_field (Writer_witec &w) {
+    // Inserting an empty buffer would set the failbit of body.
+    if (!simulation && (w. body. rdbuf ()-> in_avail () > 0))
+        body << w. body. rdbuf () ;
+    set_field_state (w. get_field_state ()) ;
+    add_durations_of (w) ;
+}
+
+void dpps::Writer_witec::write_Pattern_by_field (const Pattern &pattern,
+                                                 const selection_t selection) {
+    if (!writer_settings. xy_by_piezo) {
+        std::string reason {"Writer_witec::write_Pattern_by_field can only \
+be used with xy_by_piezo."} ;
+        throw bad_parametre (reason. c_str ()) ;
+    }
+    if (!pattern. instances. empty ()) {
+        write_Pattern_by_field (flattened_selection (pattern, selection), -1) ;
+        return ;
+    }
+    if (pattern. size (selection) == 0)
+        return ;
+    // as in write_Pattern_selected()
+    if (writer_settings. hysteresis_quadrant != hysteresis_no_correction)
+        get_reference_position_from_pattern (pattern, selection) ;
+    if (writer_settings. focus_correction)
+        prepare_focus_correction (pattern, selection) ;
+
+    std::vector<const Polyline *> view {selected_view (pattern, selection)} ;
+    std::vector<Field_number> numbers ;
+    std::vector<std::vector<const Polyline *>> fields ;
+    std::vector<std::vector<bool>> reversed ;
+    std::vector<const Polyline *> others ;
+    std::vector<bool> others_reversed ;
+    if (writer_settings. plan_travel) {
+        // as in write_planned_view(), the travel is planned from the end of
+        // each field to the next one.
+        std::map<Field_number, std::vector<const Polyline *>> grouped ;
+        std::vector<const Polyline *> crossing ;
+        std::vector<const Polyline *> large ;
+        group_by_field (view, grouped, crossing, large) ;
+        Vertex position {current_stepper_position + current_piezo_position} ;
+        double length_before {0} ;
+        double length_after {0} ;
+        numbers = planned_fields (grouped, position) ;
+        // the reference &f is used to avoid copy
+        for (auto &f: numbers) {
+            fields. push_back (std::vector<const Polyline *> ()) ;
+            reversed. push_back (std::vector<bool> ()) ;
+            plan_travel_of (grouped[f], position, fields. back (),
+                            reversed. back (), length_before, length_after) ;
+        }
+        plan_travel_of (crossing, position, others, others_reversed,
+                        length_before, length_after) ;
+        plan_travel_of (large, position, others, others_reversed,
+                        length_before, length_after) ;
+        emit_comment ("Travel planning: jump length reduced from " +
+                      std::to_string (length_before) + " µm to " +
+                      std::to_string (length_after) + " µm") ;
+    } else {
+        order_by_field (view, numbers, fields, others) ;
+        // the reference &f is used to avoid copy
+        for (auto &f: fields)
+            reversed. push_back (std::vector<bool> (f. size (), false)) ;
+        others_reversed. assign (others. size (), false) ;
+    }
+    long_unsigned_int n {numbers. size ()} ;
+    write_header () ;
+
+    // Snapshots depend on the number of movements since the start, and the
+    // comments outside of the body cannot be kept by field, so in these
+    // cases the fields are written one after the other.
+    if ((writer_settings. take_snapshot_every > 0) ||
+        writer_settings. comment_separate ||
+        writer_settings. comment_cerr) {
+        for (long_unsigned_int k {0} ; k < n ; k++)
+            write_field (fields[k], reversed[k]) ;
+        write_field (others, others_reversed) ;
+        write_footer () ;
+        return ;
+    }
+
+    // The state at the start of each field is predicted. The stepper moves
+    // between fields do not depend on the polylines; the speed is the one
+    // of the last movement, and every polyline ends with lithography off.
+    if (writer_settings. focus_position. size () > 3 && !focus_grid_built)
+        build_focus_grid () ;
+    std::vector<Field_state> starts (n) ;
+    Writer_witec stepper ;
+    start_field_writer (stepper, get_field_state ()) ;
+    stepper. simulation = true ;
+    Field_state state {get_field_state ()} ;
+    for (long_unsigned_int k {0} ; k < n ; k++) {
+        long signed int i ;
+        long signed int j ;
+        stepper. get_field_number (i, j, stepper. current_stepper_position) ;
+        if ((i != numbers[k]. first) || (j != numbers[k]. second)) {
+            stepper. go_stepper_to (get_field_centre_position (
+                numbers[k]. first, numbers[k]. second)) ;
+            state. piezo_position = Vertex (0, 0) ;
+        }
+        state. stepper_position = stepper. current_stepper_position ;
+        starts[k] = state ;
+        // as in write_Polyline() and check_speed()
+        for (auto p: fields[k])
+            if (p-> size () >= 2) {
+                double speed {p-> dose} ;
+                if (fabs (speed) <= std::numeric_limits<double>::epsilon ())
+                    speed = writer_settings. moving_speed ;
+                if ((fabs (speed - state. moving_speed) > speed_unit) &&
+                    (speed > 0))
+                    state. moving_speed = speed ;
+            }
+        state. triggered = false ;
+        if (writer_settings. litho_by_focus)
+            state. focused = false ;
+    }
+
+    std::vector<Writer_witec> writers (n) ;
+    // Exceptions cannot leave a parallel loop, they are thrown again when
+    // the field is appended.
+    std::vector<std::exception_ptr> errors (n) ;
+#ifdef OPENMP_FOUND
+    #pragma omp parallel for schedule(dynamic, 1)
+#endif
+    for (long_unsigned_int k = 0 ; k < n ; k++) {
+        try {
+            start_field_writer (writers[k], starts[k]) ;
+            writers[k]. write_field (fields[k], reversed[k]) ;
+        } catch (...) {
+            errors[k] = std::current_exception () ;
+        }
+    }
+    for (long_unsigned_int k {0} ; k < n ; k++) {
+        if (errors[k])
+            std::rethrow_exception (errors[k]) ;
+        // as in write_polyline_piezo()
+        long signed int i ;
+        long signed int j ;
+        get_field_number (i, j, current_stepper_position) ;
+        if ((i != numbers[k]. first) || (j != numbers[k]. second)) {
+            emit_comment ("Going to field (" +
+                std::to_string (numbers[k]. first) + ", " +
+                std::to_string (numbers[k]. second) + ")") ;
+            piezo_jump_to (Vertex (0,0)) ;
+            go_stepper_to (get_field_centre_position (numbers[k]. first,
+                                                      numbers[k]. second)) ;
+        }
+        if (get_field_state (). matches (starts[k]))
+            append_field (writers[k]) ;
+        else {
+            // The altitude, with focus correction, depends on the previous
+            // field; the field is written again from the actual state.
+            Writer_witec w ;
+            start_field_writer (w, get_field_state ()) ;
+            w. write_field (fields[k], reversed[k]) ;
+            append_field (w) ;
+        }
+    }
+    write_field (others, others_reversed) ;
+    write_footer () ;
 }
 
 void dpps::Writer_witec::update_duration_shutter () {
     shutter_number++ ;
     shutter_duration += writer_settings. shutter_response_time ;
 }
-void dpps::Writer_witec::update_duration_jump_to(const Vertex &destination) {
-    double distance {(destination - current_stepper_position). norm2 ()} ;
+void dpps::Writer_witec::update_duration_jump_to(const Vertex &origin,
+                                                  const Vertex &destination) {
+    double distance {(destination - origin). norm2 ()} ;
     jump_number++ ;
     jump_distance += distance ;
     jump_duration += distance / writer_settings. jump_speed ;
 }
 
-void dpps::Writer_witec::update_duration_move_to(const Vertex &destination,
+void dpps::Writer_witec::update_duration_move_to(const Vertex &origin,
+                                                  const Vertex &destination,
                                                   const double speed) {
-    double distance {(destination - current_stepper_position). norm2 ()} ;
+    double distance {(destination - origin). norm2 ()} ;
     move_number++ ;
     move_distance += distance ;
     move_duration += distance / speed ;
@@ -1270,7 +2219,7 @@ void dpps::Writer_witec::update_duration_dot (const double time) {
 }
 
 void dpps::Writer_witec::sleep (const double time) {
-    tmpfile << string_sleep << "("
+    body << string_sleep << "("
          << fixed_number (time, 4, false)
          << ");\n" ;
     update_duration_dot (time) ;
@@ -1282,7 +2231,7 @@ void dpps::Writer_witec::check_speed (const double speed) {
         // issue command if speed changed significantly ;
         // negative speed means no commands are issued.
         current_moving_speed = speed ;
-        tmpfile << string_speed << "("
+        body << string_speed << "("
              << fixed_number (writer_settings. moving_speed, 4, false)
              << ");\n" ;
     }
@@ -1298,7 +2247,7 @@ void dpps::Writer_witec::piezo_move_to(const Vertex &destination,
     if (fabs (dest.y) < movement_unit)
         dest.y = 0 ;
     check_speed (speed) ;
-    update_duration_move_to (dest, speed) ;
+    update_duration_move_to (current_piezo_position, dest, speed) ;
     if (writer_settings. focus_correction && writer_settings. focus_by_piezo) {
         // When we are here we are focused (because lithography_on() was called)
         // so we correct by the difference in height between the start and end
@@ -1309,7 +2258,7 @@ void dpps::Writer_witec::piezo_move_to(const Vertex &destination,
     } else
         dest_height = current_piezo_height ;
     if (writer_settings. absolute_movements) {
-        tmpfile << string_piezo_move_absolute << "("
+        body << string_piezo_move_absolute << "("
              << fixed_number (dest. x, 4, false)
              << ","
              << fixed_number (dest. y, 4, false)
@@ -1323,7 +2272,7 @@ void dpps::Writer_witec::piezo_move_to(const Vertex &destination,
         Vertex rel {dest. x - current_piezo_position. x,
                     dest. y - current_piezo_position. y} ;
         rel_height = dest_height - current_piezo_height ;
-        tmpfile << string_piezo_move_relative << "("
+        body << string_piezo_move_relative << "("
              << fixed_number (rel. x, 4, false)
              << ","
              << fixed_number (rel. y, 4, false)
@@ -1345,7 +2294,7 @@ void dpps::Writer_witec::piezo_jump_to(const Vertex &destination) {
         dest.x = 0 ;
     if (fabs (dest.y) < movement_unit)
         dest.y = 0 ;
-    update_duration_jump_to (dest) ;
+    update_duration_jump_to (current_piezo_position, dest) ;
     if (writer_settings. focus_correction && writer_settings. focus_by_piezo) {
         // We keep focus status by changing only relative values.
         rel_height = interpolate_height (destination)
@@ -1353,7 +2302,7 @@ void dpps::Writer_witec::piezo_jump_to(const Vertex &destination) {
         dest_height = current_piezo_height + rel_height ;
     }
     if (writer_settings. absolute_movements) {
-        tmpfile << string_piezo_jump_absolute << "("
+        body << string_piezo_jump_absolute << "("
              << fixed_number (dest. x, 4, false)
              << ","
              << fixed_number (dest. y, 4, false)
@@ -1366,7 +2315,7 @@ void dpps::Writer_witec::piezo_jump_to(const Vertex &destination) {
     } else {
         Vertex rel {dest. x - current_piezo_position. x,
                     dest. y - current_piezo_position. y} ;
-        tmpfile << string_piezo_jump_relative << "("
+        body << string_piezo_jump_relative << "("
              << fixed_number (rel. x, 4, false)
              << ","
              << fixed_number (rel. y, 4, false)
@@ -1386,9 +2335,9 @@ void dpps::Writer_witec::stepper_jump_to(const Vertex &destination) {
         dest.x = 0 ;
     if (fabs (dest.y) < movement_unit)
         dest.y = 0 ;
-    update_duration_jump_to (dest) ;
+    update_duration_jump_to (current_stepper_position, dest) ;
     if (writer_settings. absolute_movements) {
-        tmpfile << string_stepper_jump_absolute << "("
+        body << string_stepper_jump_absolute << "("
              << fixed_number (dest. x, 4, false)
              << ","
              << fixed_number (dest. y, 4, false)
@@ -1402,7 +2351,7 @@ void dpps::Writer_witec::stepper_jump_to(const Vertex &destination) {
                     round (rel. x / writer_settings. stepper_xy_relative_step) ;
         rel. y = writer_settings. stepper_xy_relative_step *
                     round (rel. y / writer_settings. stepper_xy_relative_step) ;
-        tmpfile << string_stepper_jump_relative << "("
+        body << string_stepper_jump_relative << "("
              << fixed_number (rel. x, 4, false)
              << ","
              << fixed_number (rel. y, 4, false)
@@ -1421,9 +2370,9 @@ void dpps::Writer_witec::stepper_move_to(const Vertex &destination,
     if (fabs (dest.y) < movement_unit)
         dest.y = 0 ;
     check_speed (speed) ;
-    update_duration_move_to (dest, speed) ;
+    update_duration_move_to (current_stepper_position, dest, speed) ;
     if (writer_settings. absolute_movements) {
-        tmpfile << string_stepper_move_absolute << "("
+        body << string_stepper_move_absolute << "("
              << fixed_number (dest. x, 4, false)
              << ","
              << fixed_number (dest. y, 4, false)
@@ -1436,7 +2385,7 @@ void dpps::Writer_witec::stepper_move_to(const Vertex &destination,
                     round (rel. x / writer_settings. stepper_xy_relative_step) ;
         rel. y = writer_settings. stepper_xy_relative_step *
                     round (rel. y / writer_settings. stepper_xy_relative_step) ;
-        tmpfile << string_stepper_move_relative << "("
+        body << string_stepper_move_relative << "("
              << fixed_number (rel. x, 4, false)
              << ","
              << fixed_number (rel. y, 4, false)
@@ -1593,6 +2542,109 @@ the precision of the movement, and this does not allow alignment correction"} ;
     }
 }
 */
+void dpps::Writer_witec::build_focus_grid () {
+    const std::vector<Vertex> &points = writer_settings. focus_position ;
+    double minx {std::numeric_limits<double>::max ()} ;
+    double miny {std::numeric_limits<double>::max ()} ;
+    double maxx {std::numeric_limits<double>::lowest ()} ;
+    double maxy {std::numeric_limits<double>::lowest ()} ;
+    // the reference &v is used to avoid copy
+    for (auto &v: points) {
+        minx = std::min (minx, v. x) ;
+        miny = std::min (miny, v. y) ;
+        maxx = std::max (maxx, v. x) ;
+        maxy = std::max (maxy, v. y) ;
+    }
+    // Cells are chosen so that there is about one point per cell.
+    double n {static_cast<double> (points. size ())} ;
+    double width {std::max (maxx - minx, maxy - miny)} ;
+    double cell {std::max (sqrt ((maxx - minx) * (maxy - miny) / n),
+                           width / n)} ;
+    if (cell <= 0)
+        cell = 1.0 ;
+    // Beyond one width around the points, a linear search is faster than
+    // going through the empty cells.
+    double margin {width + cell} ;
+    focus_grid_minimum = Vertex (minx - margin, miny - margin) ;
+    focus_grid_maximum = Vertex (maxx + margin, maxy + margin) ;
+    focus_grid = Vertex_grid (cell, std::max (
+        std::max (fabs (focus_grid_minimum. x), fabs (focus_grid_minimum. y)),
+        std::max (fabs (focus_grid_maximum. x), fabs (focus_grid_maximum. y)))) ;
+    for (long_unsigned_int i {0} ; i < points. size () ; i++)
+        focus_grid. insert (points[i], i) ;
+    focus_grid_built = true ;
+}
+
+bool dpps::Writer_witec::find_nearest_focus_points (const Vertex &position,
+                                                    long_unsigned_int &i0,
+                                                    long_unsigned_int &i1,
+                                                    long_unsigned_int &i2) {
+    if (!focus_grid_built)
+        build_focus_grid () ;
+    if ((position. x < focus_grid_minimum. x) ||
+        (position. y < focus_grid_minimum. y) ||
+        (position. x > focus_grid_maximum. x) ||
+        (position. y > focus_grid_maximum. y))
+        return false ;
+    const std::vector<Vertex> &points = writer_settings. focus_position ;
+    double cell {focus_grid. get_cell_size ()} ;
+    // All the points are within this number of rings of any position inside
+    // the rectangle.
+    long_unsigned_int last_ring {static_cast<long_unsigned_int> (ceil (
+        std::max (focus_grid_maximum. x - focus_grid_minimum. x,
+                  focus_grid_maximum. y - focus_grid_minimum. y) / cell)) + 1} ;
+    // The points found so far, with their squared distances. Comparing the
+    // pairs (distance, index) chooses the lowest index among equal
+    // distances, as the linear search does.
+    std::vector<std::pair<double, long_unsigned_int>> seen ;
+    std::vector<long_unsigned_int> found ;
+    const long_unsigned_int none {std::numeric_limits<long_unsigned_int>::max ()} ;
+    bool nearest_known {false} ;
+    long_unsigned_int cells_seen {0} ;
+    for (long_unsigned_int r {0} ; r <= last_ring ; r++) {
+        cells_seen += (r == 0) ? 1 : 8 * r ;
+        if (cells_seen > 4 * points. size ())
+            return false ;
+        focus_grid. ring (position, r, found) ;
+        for (long_unsigned_int i: found)
+            seen. push_back (std::make_pair (
+                (points[i] - position). norm2_square (), i)) ;
+        // The points not seen yet are at least r * cell away.
+        double bound {(r == last_ring) ? std::numeric_limits<double>::max ()
+                                       : (r * cell) * (r * cell)} ;
+        if (!nearest_known) {
+            if (seen. size () < 2)
+                continue ;
+            std::partial_sort (seen. begin (), seen. begin () + 2,
+                               seen. end ()) ;
+            if (seen[1]. first >= bound)
+                continue ;
+            i0 = seen[0]. second ;
+            i1 = seen[1]. second ;
+            nearest_known = true ;
+        }
+        std::pair<double, long_unsigned_int> best {
+            std::numeric_limits<double>::max (), none} ;
+        // the reference &s is used to avoid copy
+        for (auto &s: seen)
+            if ((s. second != i0) && (s. second != i1) && (s < best) &&
+                !points[s. second]. is_aligned (points[i0], points[i1],
+                                                movement_unit))
+                best = s ;
+        if ((best. second != none) && (best. first < bound)) {
+            i2 = best. second ;
+            return true ;
+        }
+    }
+    // All the points are aligned with i0 and i1, the linear search leaves
+    // i2 to 0.
+    if (nearest_known) {
+        i2 = 0 ;
+        return true ;
+    }
+    return false ;
+}
+
 double dpps::Writer_witec::interpolate_height (const Vertex &position) { // const
     Vertex p0, p1, p2 ;
     double f0{0.0},
@@ -1645,35 +2697,39 @@ double dpps::Writer_witec::interpolate_height (const Vertex &position) { // cons
         // Initializing to avoid a gcc warning.
         // NOTE: we get a gcc warning in -O2 but not in -O0
         long_unsigned_int i0{0}, i1{0}, i2{0} ;
-        for (long_unsigned_int i {0} ; i < writer_settings. focus_position. size () ; i++) {
-            d = (writer_settings. focus_position[i] - position). norm2_square () ;
-            if (d < min_dist) {
-                i0 = i ;
-                min_dist = d ;
+        // The linear search below is only used for positions far from the
+        // focus points.
+        if (!find_nearest_focus_points (position, i0, i1, i2)) {
+            for (long_unsigned_int i {0} ; i < writer_settings. focus_position. size () ; i++) {
+                d = (writer_settings. focus_position[i] - position). norm2_square () ;
+                if (d < min_dist) {
+                    i0 = i ;
+                    min_dist = d ;
+                }
             }
-        }
-        min_dist = std::numeric_limits<double>::max () ;
-        for (long_unsigned_int i {0} ; i < writer_settings. focus_position. size () ; i++) {
-            if (i == i0)
-                continue ;
-            d = (writer_settings. focus_position[i] - position). norm2_square () ;
-            if (d < min_dist) {
-                i1 = i ;
-                min_dist = d ;
+            min_dist = std::numeric_limits<double>::max () ;
+            for (long_unsigned_int i {0} ; i < writer_settings. focus_position. size () ; i++) {
+                if (i == i0)
+                    continue ;
+                d = (writer_settings. focus_position[i] - position). norm2_square () ;
+                if (d < min_dist) {
+                    i1 = i ;
+                    min_dist = d ;
+                }
             }
-        }
-        min_dist = std::numeric_limits<double>::max () ;
-        for (long_unsigned_int i {0} ; i < writer_settings. focus_position. size () ; i++) {
-            if ((i == i0) || (i == i1))
-                continue ;
-            if (writer_settings. focus_position[i]. is_aligned (
-                    writer_settings. focus_position[i0],
-                    writer_settings. focus_position[i1], movement_unit))
-                continue ;
-            d = (writer_settings. focus_position[i] - position). norm2_square () ;
-            if (d < min_dist) {
-                i2 = i ;
-                min_dist = d ;
+            min_dist = std::numeric_limits<double>::max () ;
+            for (long_unsigned_int i {0} ; i < writer_settings. focus_position. size () ; i++) {
+                if ((i == i0) || (i == i1))
+                    continue ;
+                if (writer_settings. focus_position[i]. is_aligned (
+                        writer_settings. focus_position[i0],
+                        writer_settings. focus_position[i1], movement_unit))
+                    continue ;
+                d = (writer_settings. focus_position[i] - position). norm2_square () ;
+                if (d < min_dist) {
+                    i2 = i ;
+                    min_dist = d ;
+                }
             }
         }
         p0 = writer_settings. focus_position[i0] ;
@@ -19,10 +19,13 @@
 #define DPPS_WRITER_WITEC
 
 #include <array>
+#include <map>
+#include <unordered_map>
 
 #include "Vertex.hh"
 #include "Writer.hh"
 #include "Pattern.hh"
+#include "Vertex_grid.hh"
 
 namespace dpps {
 typedef enum {
@@ -149,15 +152,26 @@ public:
         bool comment_separate {false} ;
         bool comment_cerr {false} ;
         bool correct_focus_inside_polylines {false} ;
+
+        /** @brief Whether the order of the polylines is planned to reduce
+         * the jumps, and whether their direction may be reversed for that,
+         * see set_travel_planning(). */
+        bool plan_travel {false} ;
+        bool reverse_polylines {false} ;
+
+        /** @brief Whether the commands are compacted when the file is
+         * written, see set_command_optimization(). */
+        bool optimize_commands {false} ;
+
+        /** @brief Whether the shutter stays open between polylines which
+         * touch, see set_polyline_chaining(). */
+        bool chain_polylines {false} ;
+        double chain_tolerance {0.001} ;
         //enum_alignment alignment {alignment_translation} ;
         std::vector<Vertex> a, b ;
 } ;
 
 protected:
-    /** @brief default constructor is private so that user has to pass
-     * filename and append parameters. */
-    Writer_witec () ;
-
     /** @brief variable that describe the nature of the quadrants in the
      * different cases given by hysteresis_quadrant.
      *
@@ -203,8 +217,40 @@ protected:
     //double current_jump_speed {0.0} ;
     bool triggered {false} ;
     bool status_hysteresis_ok {true} ;
+
+    /** @brief whether the shutter was left open at the end of the last
+     * polyline, of dose chain_dose, and whether the polyline being written
+     * continues it. */
+    bool chain_open {false} ;
+    bool chained {false} ;
+    double chain_dose {0.0} ;
+
+    /** @brief whether the exposure of p can start where the last polyline
+     * ended without closing the shutter: chaining is set, the doses are the
+     * same, the first vertex of p is within chain_tolerance of the position
+     * and going there moves neither the stepper to another field nor in a
+     * direction which needs a hysteresis correction. */
+    bool chain_continues (const Polyline &p) const ;
+
+    /** @brief ends the exposure of p, leaving the shutter open if the next
+     * polyline may continue it. */
+    void end_exposure (const Polyline &p) ;
     std::vector<Polyline> decompose_polyline_no_hysteresis_paths (
         const Polyline &p) ;
+
+    /** @brief a part of a polyline, from its vertex first to its vertex
+     * last, written backwards if reversed is true. */
+    struct Sub_path {
+        long_unsigned_int first ;
+        long_unsigned_int last ;
+        bool reversed ;
+    } ;
+
+    /** @brief the decompositions of decompose_polyline_no_hysteresis_paths()
+     * by the differences between the successive vertices on which they only
+     * depend, so that the instances of a shape repeated in a lattice are
+     * decomposed once. */
+    std::unordered_map<std::string, std::vector<Sub_path>> decomposition_cache ;
     // Note that current_hysteresis_quadrant is set to none so that
     // at first use when user requested a correction, it is detected as changed.
     enum_hysteresis_quadrant current_hysteresis_quadrant {
@@ -227,6 +273,18 @@ protected:
     double shutter_duration {0.0} ;
     bool three_point_adjust_already_made {false} ;
 
+    /** @brief whether this writer was built for a simulation, without
+     * file. */
+    bool simulation {false} ;
+
+    /** @brief a field, as numbered by get_field_number(). */
+    typedef std::pair<long signed int, long signed int> Field_number ;
+
+    /** @brief in a simulation, the durations spent on the polylines of each
+     * field, and of each reference, in seconds. */
+    std::map<Field_number, double> field_durations ;
+    std::map<long_unsigned_int, double> reference_durations ;
+
     // The epsilon for all movements, in units of micrometres
     static const constexpr double movement_unit {0.001} ;
 
@@ -236,9 +294,13 @@ protected:
 
     void get_reference_position_from_pattern (const dpps::Pattern &p,
         const selection_t selection) ;
-    void update_duration_jump_to (const Vertex &destination) ;//, const double speed) ;
-    void update_duration_move_to (const Vertex &destination,
-        const double speed) ;
+    /** @brief origin is current_stepper_position for the stepper, or
+     * current_piezo_position for the piezo. */
+    void update_duration_jump_to (const Vertex &origin,
+                                  const Vertex &destination) ;
+    void update_duration_move_to (const Vertex &origin,
+                                  const Vertex &destination,
+                                  const double speed) ;
     void update_duration_dot (const double time) ;
     void update_duration_shutter () ;
 
@@ -272,6 +334,29 @@ protected:
 
     double interpolate_height (const Vertex &position) ;//const ;
 
+    /** @brief a grid of the focus points, to find the nearest ones in
+     * interpolate_height(). It is built at the first call after the focus
+     * points have changed. */
+    Vertex_grid focus_grid {1.0, 0.0} ;
+    bool focus_grid_built {false} ;
+
+    /** @brief the rectangle around the focus points inside which the grid is
+     * searched. */
+    Vertex focus_grid_minimum ;
+    Vertex focus_grid_maximum ;
+
+    void build_focus_grid () ;
+
+    /** @brief sets i0 and i1 to the nearest focus points of position, and i2
+     * to the nearest one which is not aligned with them, as the linear
+     * search of interpolate_height() would, with the same choice among equal
+     * distances. Returns false if position is too far from the focus points
+     * for the grid to be useful. */
+    bool find_nearest_focus_points (const Vertex &position,
+                                    long_unsigned_int &i0,
+                                    long_unsigned_int &i1,
+                                    long_unsigned_int &i2) ;
+
     // initial value set to true so that the first image at start is skipped
     //bool just_took_snapshot {true} ;
 
@@ -337,6 +422,95 @@ protected:
         const long signed int i,
         const long signed int j) const ;
     void write_polyline_stepper (Polyline &p) ;
+
+    /** @brief Appends to planned the polylines of view in the order planned
+     * by Travel_planner from position, and whether each one is reversed.
+     * position is set to the end of the last polyline, and the jump lengths
+     * before and after planning are added to length_before and
+     * length_after. */
+    void plan_travel_of (const std::vector<const Polyline *> &view,
+                         Vertex &position,
+                         std::vector<const Polyline *> &planned,
+                         std::vector<bool> &reversed,
+                         double &length_before,
+                         double &length_after) ;
+
+    /** @brief Writes the polylines of view in a planned order, see
+     * set_travel_planning(). */
+    void write_planned_view (const std::vector<const Polyline *> &view) ;
+
+    /** @brief Splits the non-empty polylines of view in the categories of
+     * compare_x_y_field(): those which fit in a field, by field, those which
+     * cross a field border and those larger than a field. */
+    void group_by_field (const std::vector<const Polyline *> &view,
+        std::map<Field_number, std::vector<const Polyline *>> &fields,
+        std::vector<const Polyline *> &crossing,
+        std::vector<const Polyline *> &large) const ;
+
+    /** @brief the fields in the order planned by Travel_planner from
+     * position, going to their centres. */
+    std::vector<Field_number> planned_fields (
+        const std::map<Field_number, std::vector<const Polyline *>> &fields,
+        const Vertex &position) const ;
+
+    /** @brief the polylines of view in the order of sorted_by_field(): the
+     * polylines of each field in ordered, with the numbers of the fields in
+     * numbers, then the other polylines in others. */
+    void order_by_field (const std::vector<const Polyline *> &view,
+        std::vector<Field_number> &numbers,
+        std::vector<std::vector<const Polyline *>> &ordered,
+        std::vector<const Polyline *> &others) const ;
+
+    /** @brief the non-empty polylines of view in the order in which they are
+     * written with xy_by_piezo and without travel planning: first those which
+     * fit in a field, field by field, then those which cross a field border,
+     * then those larger than a field, each ordered by geometrical centre.
+     *
+     * The fields are ordered by columns, in the directions of the hysteresis
+     * quadrant, or in alternate directions without hysteresis correction, so
+     * that the stepper moves from each field to a neighbouring one. */
+    std::vector<const Polyline *> sorted_by_field (
+        const std::vector<const Polyline *> &view) const ;
+
+    /** @brief adds the numbers of movements and the durations of w to the
+     * ones of this writer. */
+    void add_durations_of (const Writer_witec &w) ;
+
+    /** @brief the state which the commands written for a field depend on,
+     * see write_Pattern_by_field(). */
+    struct Field_state {
+        Vertex stepper_position ;
+        Vertex piezo_position ;
+        double stepper_height ;
+        double piezo_height ;
+        double moving_speed ;
+        bool triggered ;
+        bool focused ;
+
+        /** @brief whether s is the same state, apart from differences far
+         * below the precision of the commands. */
+        bool matches (const Field_state &s) const ;
+    } ;
+    Field_state get_field_state () const ;
+    void set_field_state (const Field_state &s) ;
+
+    /** @brief prepares w to write the polylines of a field as this writer
+     * would, from state s. The commands are kept in the body of w. */
+    void start_field_writer (Writer_witec &w, const Field_state &s) const ;
+
+    /** @brief writes the polylines, reversing those for which reversed is
+     * true, without header nor footer. */
+    void write_field (const std::vector<const Polyline *> &polylines,
+                      const std::vector<bool> &reversed) ;
+
+    /** @brief appends the commands of w, written for the next field, and
+     * takes its final state and its durations. */
+    void append_field (Writer_witec &w) ;
+
+    /** @brief finds the extremum altitude and asks the user to focus there,
+     * as needed before writing with focus correction. */
+    void prepare_focus_correction (const Pattern &pattern,
+                                   const selection_t selection) ;
     //void emit_warning (const std::string &reason) ;
     /** @brief Writes a comment on the log.
      *
@@ -351,8 +525,16 @@ protected:
      *
      */
     void emit_comment (const std::string value) ;
+
+    /** @brief whether emit_comment() outputs anything, so that the comments
+     * written for each polyline are not built in vain. */
+    bool comments_emitted () const ;
     void piezo_stabilize () ;
 
+    /** @brief writes body to the file as write_body() does, with the
+     * commands compacted, see set_command_optimization(). */
+    void write_optimized_body () ;
+
     /** @brief Get the (i, j) field coordinate of a given Vertex position.
      *
      * A field corresponds to the division of the (xy) plane in rectangles of
@@ -391,6 +573,11 @@ protected:
     /** @brief the function that calculates the transformation matrix. */
     //void calculate_alignment_parameters () ;
 public:
+    /** @brief Constructor for a simulation: no file is written, but the
+     * polylines are processed as for a file, so that the duration estimated
+     * by close() is known without writing the program, see
+     * get_estimated_duration(). */
+    Writer_witec () ;
     ~Writer_witec() ;
     void close () ;
     // Implementation of inherited virtual functions.
@@ -446,6 +633,96 @@ public:
     void add_focus_point (const Vertex &position, const double value) ;
     void clear_focus_points () ;
 
+    /** @brief Sets whether write_Pattern_selected() changes the order of the
+     * polylines to reduce the length of the jumps between them.
+     *
+     * The order is found by Travel_planner. With xy_by_piezo, the polylines
+     * which fit in a field are grouped by field, the fields are ordered and
+     * then the polylines inside each field, followed by the polylines which
+     * cross a field border and those larger than a field. If
+     * reverse_polylines is set, open polylines may be written from their last
+     * vertex to their first one.
+     *
+     * The planning is not used when focus_correction is set with a
+     * stepper_reorder other than stepper_reorder_none, as the order by
+     * altitude is then needed. */
+    void set_travel_planning (const bool plan_travel,
+                              const bool reverse_polylines) ;
+
+    /** @brief sets whether close() compacts the commands before they are
+     * written to the file.
+     *
+     * Consecutive moves in the same direction are merged into one, the
+     * movements of null length and the stabilizations after which nothing
+     * moved are dropped, and so are a shutter closed then opened again at
+     * once, and a shutter set to the state it is in. When the position is
+     * known from an absolute command, the piezo commands use the relative or
+     * the absolute form, whichever is shorter, as do the stepper ones when
+     * the relative one is a multiple of stepper_xy_relative_step. The
+     * estimated duration in the header is the one of the commands before
+     * they were compacted. Default is false. */
+    void set_command_optimization (const bool optimize_commands) ;
+
+    /** @brief sets whether the shutter stays open from a polyline to the
+     * next one when they have the same dose and the next one starts within
+     * tolerance of the end of the previous one. The stage then moves, at
+     * the speed of the dose, to the start of the next polyline, which saves
+     * twice shutter_response_time. This is meant for the lines of hatch
+     * fills (see Pattern::fill_with_lines()); set_travel_planning() with
+     * reverse_polylines makes such lines follow each other end to start.
+     * Only used with litho_by_shutter. Throws bad_parametre if tolerance is
+     * negative. Default is false. */
+    void set_polyline_chaining (const bool chain_polylines,
+                                const double tolerance = 0.001) ;
+
+    /** @brief the estimated duration of the polylines written so far, in
+     * seconds, as displayed by close(). */
+    double get_estimated_duration () const ;
+
+    /** @brief in a simulation, the duration spent on the polylines of field
+     * (i, j), see get_field_number(). The polylines are counted in the field
+     * of their geometrical centre. */
+    double get_field_duration (const long signed int i,
+                               const long signed int j) const ;
+
+    /** @brief in a simulation, the duration spent on the polylines with
+     * this reference. */
+    double get_reference_duration (const long_unsigned_int reference) const ;
+
+    /** @brief in a simulation, a description of the estimated duration, by
+     * type of movement, by field and by reference. The time spent outside
+     * polylines, such as going back to zero at the end, is counted as
+     * other. */
+    std::string get_simulation_report () const ;
+
+    /** @brief in a simulation with xy_by_piezo, simulates the fields
+     * independently, on several threads if OpenMP is used, see
+     * write_Pattern_by_field(). */
+    void simulate_by_field (const Pattern &pattern,
+                            const selection_t selection = -1) ;
+
+    /** @brief with xy_by_piezo, writes the fields independently, on several
+     * threads if OpenMP is used.
+     *
+     * The polylines are written as write_Pattern_selected() does with
+     * focus_correction and stepper_reorder_none, grouped by field (in a
+     * planned order with set_travel_planning()), then those which do not fit
+     * in one field; stepper_reorder is ignored. The commands of each field
+     * are written into a buffer of their own, from the state of the stage
+     * predicted at the start of the field, then the buffers are appended in
+     * the order of the fields with the stepper moves between them, and the
+     * durations are added. The program is the same as the one written field
+     * after field, apart from rounding errors far below the precision of the
+     * commands, which can change the sign of a zero.
+     *
+     * With focus correction, the altitude at the start of a field depends on
+     * the previous field: a field started from another altitude is written
+     * again, so that focus correction gains less from the threads. With
+     * take_snapshot_every, or comments written outside of the file, the
+     * fields are written one after the other. */
+    void write_Pattern_by_field (const Pattern &pattern,
+                                 const selection_t selection = -1) ;
+
 #ifdef GSL_FOUND
     /** @brief The functions to call to set the points used to align the sample.
      *
@@ -0,0 +1,361 @@
+/**
+ * @file benchmark.cpp
+ * @author Jérôme Borme <jerome.borme@inl.int>
+ * @version 1.0
+ * @brief Benchmarks of the main operations of dpps, built as dpps_bench
+ * @date 2026-10-14 Jérôme Borme: Initial version
+ * @copyright
+ * This Source Code Form is subject to the terms of the Mozilla Public
+ * License, v. 2.0. If a copy of the MPL was not distributed with this
+ * file, You can obtain one at http://mozilla.org/MPL/2.0/.
+ *
+ * Each benchmark is run until it took at least min_time seconds, and its
+ * time per iteration is reported on std::cout, with the polylines or bytes
+ * processed per second. With --json FILE, the results are also written in
+ * the JSON format of Google Benchmark, so that the tools which compare its
+ * results across releases can be used. All the random patterns use a fixed
+ * seed, so that every run processes the same polylines.
+ *
+ * Syntax: dpps_bench [--filter TEXT] [--min-time SECONDS] [--json FILE]
+ * */
+
+#include <chrono>
+#include <cmath>
+#include <cstdio> // remove()
+#include <cstdlib> // EXIT_SUCCESS
+#include <ctime>
+#include <fstream>
+#include <functional>
+#include <iomanip>
+#include <iostream>
+#include <memory>
+#include <string>
+#include <vector>
+
+#include "configure.h" // created by cmake
+#include "common.hh"
+#include "Pattern.hh"
+#include "Pattern_hard_sphere_random_packing.hh"
+#include "Pattern_rectangular_lattice.hh"
+#include "Polyline_factory.hh"
+#include "Reader_DXF_R12.hh"
+#include "Reader_image.hh"
+#include "Segment_arrays.hh"
+#include "Writer_DXF_R12.hh"
+#include "Writer_witec.hh"
+#include "util.hh"
+
+namespace {
+struct Benchmark {
+    std::string name ;
+    // called before each iteration, and not timed
+    std::function<void ()> setup ;
+    std::function<void ()> run ;
+    // processed by one iteration, 0 if not relevant
+    double items ;
+    double bytes ;
+} ;
+
+struct Result {
+    std::string name ;
+    long_unsigned_int iterations ;
+    double seconds ;
+    double minimum_seconds ;
+    double items ;
+    double bytes ;
+} ;
+
+const long_unsigned_int seed {20131130} ;
+
+// A Reader_image on a generated image, so that no image library is needed:
+// black disks of diametre side/8 on a grid of period side/10.
+class Benchmark_image: public dpps::Reader_image {
+public:
+    Benchmark_image (const long_unsigned_int side) {
+        image_size_width = side ;
+        image_size_height = side ;
+        set_all_parametres (true, dpps::image_reader_import_x_lines,
+                            0, 0, 0, 1.0) ;
+    }
+
+    std::array<short unsigned int, 3> image_pixel (
+        const long_unsigned_int column,
+        const long_unsigned_int row) const {
+        double period {image_size_width / 10.0} ;
+        double x {fmod (column, period) - period / 2.0} ;
+        double y {fmod (row, period) - period / 2.0} ;
+        double r {image_size_width / 16.0} ;
+        if (x*x + y*y < r*r)
+            return {{0, 0, 0}} ;
+        return {{255, 255, 255}} ;
+    }
+} ;
+
+dpps::Pattern lattice (const long_unsigned_int side) {
+    dpps::Pattern_rectangular_lattice p (0, 0, side, side, 1.0, 1.0, 0.25) ;
+    p. generate () ;
+    return p ;
+}
+
+dpps::Pattern random_packing (const long_unsigned_int number) {
+    dpps::Pattern_hard_sphere_random_packing p (
+        number, 0, 0, 0, 1000, 1000, 1.0) ;
+    p. set_random_seed (seed) ;
+    p. generate () ;
+    return p ;
+}
+
+// A star of number vertices, alternately on circles of radius 1000 and 500,
+// so that a ray from its edge to its centre crosses many of its edges.
+dpps::Polyline star (const long_unsigned_int number) {
+    dpps::Polyline p ;
+    p. vertices. reserve (number) ;
+    for (long_unsigned_int i {0} ; i < number ; i++) {
+        double angle {2 * M_PI * i / number} ;
+        double radius {(i % 2 == 0) ? 1000.0 : 500.0} ;
+        p. push_back (dpps::Vertex (radius * cos (angle),
+                                    radius * sin (angle))) ;
+    }
+    p. closed = true ;
+    return p ;
+}
+
+double file_size (const std::string &filename) {
+    std::ifstream f (filename, std::ios_base::binary|std::ios_base::ate) ;
+    return f. tellg () ;
+}
+
+// The benchmarks share these patterns, each one built once.
+std::vector<Benchmark> make_benchmarks (dpps::Pattern &work,
+                                        std::vector<dpps::Pattern> &data) {
+    std::vector<Benchmark> benchmarks ;
+    const std::vector<long_unsigned_int> sides {10, 100, 1000} ;
+    for (auto side : sides) {
+        benchmarks. push_back ({"lattice/" + std::to_string (side * side),
+            [] () {},
+            [&work, side] () { work = lattice (side) ; },
+            static_cast<double> (side * side), 0.0}) ;
+    }
+    const std::vector<long_unsigned_int> spheres {1000, 10000, 100000} ;
+    for (auto number : spheres) {
+        benchmarks. push_back ({"hard_sphere_packing/" +
+                                    std::to_string (number),
+            [] () {},
+            [&work, number] () { work = random_packing (number) ; },
+            static_cast<double> (number), 0.0}) ;
+    }
+    data. push_back (lattice (1000)) ;
+    // the reference &big is used to avoid copy
+    dpps::Pattern &big = data. back () ;
+    double big_size {static_cast<double> (big. size ())} ;
+    benchmarks. push_back ({"select_window/1000000",
+        [&work, &big] () { work = big ; work. invalidate_spatial_index () ; },
+        [&work] () { work. select_window (400, 400, 600, 600) ; },
+        big_size, 0.0}) ;
+    benchmarks. push_back ({"select_window_indexed/1000000",
+        [&work, &big] () {
+            work = big ;
+            work. set_spatial_index (true) ;
+            work. select_window (0, 0, 0, 0) ;
+        },
+        [&work] () { work. select_window (400, 400, 600, 600) ; },
+        big_size, 0.0}) ;
+    data. push_back (random_packing (100000)) ;
+    // the reference &spheres_pattern is used to avoid copy
+    dpps::Pattern &spheres_pattern = data. back () ;
+    benchmarks. push_back ({"sort/100000",
+        [&work, &spheres_pattern] () { work = spheres_pattern ; },
+        [&work] () {
+            work. sort2 (dpps::double_property_minimum_x,
+                         dpps::double_property_minimum_y, true) ;
+        },
+        static_cast<double> (spheres_pattern. size ()), 0.0}) ;
+    benchmarks. push_back ({"fill_with_lines/10000",
+        [&work, &big] () {
+            work. polylines. assign (big. polylines. begin (),
+                                     big. polylines. begin () + 10000) ;
+        },
+        [&work] () { work. fill_with_lines (0.3, 0.01, false) ; },
+        10000.0, 0.0}) ;
+    // A smaller pattern keeps the file below 100 MB.
+    data. push_back (lattice (300)) ;
+    // the reference &medium is used to avoid copy
+    dpps::Pattern &medium = data. back () ;
+    double medium_size {static_cast<double> (medium. size ())} ;
+    const std::string dxf_file {"dpps_bench.dxf"} ;
+    {
+        dpps::Writer_DXF_R12 w (dxf_file) ;
+        w. write_Pattern (medium) ;
+        w. close () ;
+    }
+    double dxf_bytes {file_size (dxf_file)} ;
+    benchmarks. push_back ({"dxf_write/90000", [] () {},
+        [&medium, dxf_file] () {
+            dpps::Writer_DXF_R12 w (dxf_file) ;
+            w. write_Pattern (medium) ;
+            w. close () ;
+        },
+        medium_size, dxf_bytes}) ;
+    benchmarks. push_back ({"dxf_read/90000",
+        [&work] () { work. polylines. clear () ; },
+        [&work, dxf_file] () {
+            dpps::Reader_DXF_R12 r (dxf_file) ;
+            r. append_to_pattern (work) ;
+        },
+        medium_size, dxf_bytes}) ;
+    const std::string witec_file {"dpps_bench.witec"} ;
+    benchmarks. push_back ({"witec_write/100000", [] () {},
+        [&spheres_pattern, witec_file] () {
+            dpps::Writer_witec w (witec_file, false) ;
+            w. write_Pattern (spheres_pattern) ;
+            w. close () ;
+        },
+        static_cast<double> (spheres_pattern. size ()), 0.0}) ;
+    const std::vector<long_unsigned_int> image_sides {256, 1024, 4096} ;
+    for (auto side : image_sides) {
+        benchmarks. push_back ({"image_vectorization/" +
+                                    std::to_string (side) + "x" +
+                                    std::to_string (side),
+            [&work] () { work. polylines. clear () ; },
+            [&work, side] () {
+                Benchmark_image r (side) ;
+                r. append_to_pattern (work) ;
+            },
+            // counted as 3 bytes per pixel, as in an RGB file
+            0.0, static_cast<double> (3 * side * side)}) ;
+    }
+    data. push_back (dpps::Pattern ()) ;
+    data. back (). push_back (star (1000000)) ;
+    // the reference &polygon is used to avoid copy
+    dpps::Polyline &polygon = data. back (). polylines[0] ;
+    std::shared_ptr<dpps::Segment_arrays> edges {new dpps::Segment_arrays} ;
+    edges-> assign_edges (polygon. vertices, true) ;
+    std::shared_ptr<std::vector<unsigned char>> crossed {
+        new std::vector<unsigned char>} ;
+    benchmarks. push_back ({"segment_intersects/1000000", [] () {},
+        [edges, crossed] () {
+            dpps::Vertex::intersects (dpps::Vertex (-1000, 1),
+                                      dpps::Vertex (1000, -1),
+                                      *edges, *crossed) ;
+        },
+        static_cast<double> (edges-> size ()), 0.0}) ;
+    // the points are counted as polylines, each one tested on all the edges
+    const long_unsigned_int points {10} ;
+    benchmarks. push_back ({"polygon_contains/1000000", [] () {},
+        [&polygon, points] () {
+            long_unsigned_int inside {0} ;
+            for (long_unsigned_int i {0} ; i < points ; i++)
+                inside += polygon. contains (dpps::Vertex (
+                    -900.0 + 1800.0 * i / points, 0.5)) ;
+            if (inside == 0)
+                std::cerr << "dpps_bench: no point inside the polygon\n" ;
+        },
+        static_cast<double> (points), 0.0}) ;
+    return benchmarks ;
+}
+
+Result run_benchmark (Benchmark &b, const double min_time) {
+    Result result {b. name, 0, 0.0, 0.0, b. items, b. bytes} ;
+    while ((result. iterations == 0) || (result. seconds < min_time)) {
+        b. setup () ;
+        std::chrono::steady_clock::time_point start {
+            std::chrono::steady_clock::now ()} ;
+        b. run () ;
+        double seconds {std::chrono::duration<double> (
+            std::chrono::steady_clock::now () - start). count ()} ;
+        if ((result. iterations == 0) || (seconds < result. minimum_seconds))
+            result. minimum_seconds = seconds ;
+        result. seconds += seconds ;
+        result. iterations++ ;
+    }
+    return result ;
+}
+
+void write_json (const std::string &filename,
+                 const std::vector<Result> &results) {
+    std::ofstream json ;
+    json. open (filename, std::ofstream::out|std::ofstream::trunc) ;
+    if (!json. is_open ()) {
+        std::cerr << "dpps_bench: " << filename
+                  << " could not be open for output\n" ;
+        return ;
+    }
+    std::time_t now {std::time (nullptr)} ;
+    char date[32] ;
+    std::strftime (date, sizeof (date), "%Y-%m-%dT%H:%M:%S",
+                   std::localtime (&now)) ;
+    json << "{\n  \"context\": {\n    \"date\": \"" << date << "\",\n"
+         << "    \"executable\": \"dpps_bench\",\n"
+         << "    \"num_threads\": " << dpps::get_number_threads () << ",\n"
+         << "    \"library_build_type\": \"release\"\n  },\n"
+         << "  \"benchmarks\": [" ;
+    bool first {true} ;
+    for (auto &r : results) {
+        double mean {r. seconds / r. iterations} ;
+        json << (first ? "\n" : ",\n") << "    {\n"
+             << "      \"name\": \"" << r. name << "\",\n"
+             << "      \"run_type\": \"iteration\",\n"
+             << "      \"iterations\": " << r. iterations << ",\n"
+             << std::setprecision (9)
+             << "      \"real_time\": " << mean * 1e9 << ",\n"
+             << "      \"cpu_time\": " << mean * 1e9 << ",\n"
+             << "      \"min_time\": " << r. minimum_seconds * 1e9 << ",\n" ;
+        if (r. items > 0)
+            json << "      \"items_per_second\": " << r. items / mean << ",\n" ;
+        if (r. bytes > 0)
+            json << "      \"bytes_per_second\": " << r. bytes / mean << ",\n" ;
+        json << "      \"time_unit\": \"ns\"\n    }" ;
+        first = false ;
+    }
+    json << "\n  ]\n}\n" ;
+}
+} // namespace
+
+int main (int argc, char** argv) {
+    std::string filter ;
+    std::string json_filename ;
+    double min_time {0.5} ;
+    for (int i {1} ; i < argc ; i++) {
+        std::string option {argv[i]} ;
+        if ((option == "--filter") && (i + 1 < argc))
+            filter = argv[++i] ;
+        else if ((option == "--min-time") && (i + 1 < argc))
+            min_time = std::stod (argv[++i]) ;
+        else if ((option == "--json") && (i + 1 < argc))
+            json_filename = argv[++i] ;
+        else {
+            std::cerr << "Syntax: dpps_bench [--filter TEXT] "
+                      << "[--min-time SECONDS] [--json FILE]\n" ;
+            return EXIT_FAILURE ;
+        }
+    }
+    dpps::Pattern work ;
+    std::vector<dpps::Pattern> data ;
+    // reserved so that the references of the lambdas remain valid
+    data. reserve (4) ;
+    std::vector<Benchmark> benchmarks {make_benchmarks (work, data)} ;
+    std::vector<Result> results ;
+    std::cout << std::left << std::setw (36) << "benchmark" << std::right
+              << std::setw (12) << "iterations" << std::setw (14)
+              << "time (ms)" << std::setw (16) << "polylines/s"
+              << std::setw (12) << "MB/s" << "\n" ;
+    for (auto &b : benchmarks) {
+        if (b. name. find (filter) == std::string::npos)
+            continue ;
+        results. push_back (run_benchmark (b, min_time)) ;
+        // the reference &r is used to avoid copy
+        const Result &r = results. back () ;
+        double mean {r. seconds / r. iterations} ;
+        std::cout << std::left << std::setw (36) << r. name << std::right
+                  << std::setw (12) << r. iterations << std::fixed
+                  << std::setprecision (3) << std::setw (14) << mean * 1e3
+                  << std::setprecision (0) << std::setw (16)
+                  << r. items / mean << std::setprecision (1)
+                  << std::setw (12) << r. bytes / mean / 1e6 << "\n" ;
+    }
+    if (!json_filename. empty ())
+        write_json (json_filename, results) ;
+    remove ("dpps_bench.dxf") ;
+    remove ("dpps_bench.witec") ;
+    return EXIT_SUCCESS ;
+}
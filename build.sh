@@ -20,6 +20,8 @@ prog=dpps
 # REP=/mnt/stockage/jerome/travail/INL/projets/C/20131117-masques/
 REP=/home/jerome/travail/2014/projets/C/dpps/
 makeopts="-j4" #VERBOSE=1
+# scripts run by dpps to train the distribution build, in addition to dpps_bench
+pgo_scripts=""
 # end of user settings
 
 function help {
@@ -27,7 +29,7 @@ function help {
     echo    "   will clean most files produced by the build including cmake cache"
     echo    "   but not the executables (because we want to produce them all)"
     echo    "   (not font_* since I still do not know to rebuild them well)"
-    echo -e "        " $0 " <clang|gcc|mingw64|scan-build|all>\n\n"
+    echo -e "        " $0 " <clang|gcc|distribution|mingw64|scan-build|all>\n\n"
     echo    "It will clean previous compilation and configure files,"
     echo -e "then compiles for the provided target.\n"
     echo    "Final executable is copied to ${prog}-target, where target is one"
@@ -36,6 +38,10 @@ function help {
     echo    "Description of the targets:"
     echo    "   gcc: compiles with g++, with -mtune=native"
     echo    "        This is for use on one's machine"
+    echo    "   distribution: compiles with g++, with link-time optimisation,"
+    echo    "        the loops for several instruction sets, and profile-guided"
+    echo    "        optimisation trained on dpps_bench and on pgo_scripts."
+    echo    "        This is to distribute to linux users with various machines"
     echo    "   clang: compiles with clang++, mostly to check warnings"
     echo    "   mingw32: cross-compiles with mingw as a target format PE32"
     echo    "        using gentoo linux cross-development platform"
@@ -71,6 +77,10 @@ function build {
             cmake_options="-DNATIVE_TUNE=1"
             executable="${prog}"
             ;;
+        "distribution")
+            cmake_options="-DUSE_LTO=1 -DMULTIVERSION=1 -DBUILD_BENCHMARK=1 -DPGO_MODE=generate"
+            executable="${prog}"
+            ;;
         "scan-build")
             cmake_options="-DCMAKE_TOOLCHAIN_FILE=${REP}/src/misc/Toolchain_clang.cmake"
             executable="${prog}"
@@ -96,6 +106,14 @@ function build {
         "scan-build")
             scan-build make VERBOSE=1
             ;;
+        "distribution")
+            # instrumented build, training run, then optimised build
+            rm -rf ${REP}/bin/pgo
+            make ${makeopts} && ./dpps_bench --min-time 0.2 && \
+            for script in ${pgo_scripts} ; do ./${prog} ${script} || exit 1 ; done && \
+            cmake -DPGO_MODE=use ${REP}/src && make clean && \
+            make ${makeopts} && rename ${prog} ${prog}-$1 ${executable}
+            ;;
         *)
             make ${makeopts} && cd ${REP}/bin && rename ${prog} ${prog}-$1 ${executable}
             ;;
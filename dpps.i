@@ -56,9 +56,14 @@ typedef short signed int selection_t ;
 #include "Pattern_hard_sphere_random_packing.hh"
 #include "Polyline_factory.hh"
 #include "Pattern_factory.hh"
+#include "Pattern_cache.hh"
+#include "Pattern_packed.hh"
+#include "Pattern_store.hh"
+#include "Proximity_correction.hh"
 #include "Reader_DXF_R12.hh"
 #include "Reader_image.hh"
 #include "Reader_witec.hh"
+#include "Reader_dpps.hh"
 
 #ifdef QT_FOUND
 #include "Reader_image_Qt.hh"
@@ -68,19 +73,163 @@ typedef short signed int selection_t ;
 #include "Reader_image_png.hh"
 #endif
 
+#ifdef PNG_FOUND
+#include "Reader_image_png_stream.hh"
+#endif
+
 #include "Writer_DXF_R12.hh"
 #include "Writer_SVG.hh"
 #include "Writer_cpp.hh"
+#include "Writer_dpps.hh"
 #include "Writer_witec.hh"
 
+#ifdef PNG_FOUND
+#include "Writer_image_png.hh"
+#endif
+#include "Pipeline.hh"
+#include "profiler.hh"
+
 #include "util.hh"
+#include "bad_parametre.hh"
 #include "Matrix2x2.hh"
 #include "Matrix3x3.hh"
+#include "Affine_transform.hh"
 
 using namespace dpps;
 using namespace std;
+
+// Calls the Lua function at position index of the stack on a table of
+// coordinates, and copies back the table it returns, see
+// Pattern::map_vertices().
+struct Lua_batch_function {
+    lua_State *L ;
+    int index ;
+    void operator() (std::vector<double> &coordinates) const {
+        lua_pushvalue (L, index) ;
+        lua_createtable (L, coordinates. size (), 0) ;
+        for (size_t i = 0 ; i < coordinates. size () ; i++) {
+            lua_pushnumber (L, coordinates[i]) ;
+            lua_rawseti (L, -2, i + 1) ;
+        }
+        if (lua_pcall (L, 1, 1, 0) != 0) {
+            std::string reason {"Pattern::map_vertices, error in the Lua \
+function: " + std::string (lua_tostring (L, -1))} ;
+            lua_pop (L, 1) ;
+            throw bad_parametre (reason. c_str ()) ;
+        }
+        if (!lua_istable (L, -1)) {
+            lua_pop (L, 1) ;
+            std::string reason {"Pattern::map_vertices, the Lua function \
+must return a table of coordinates."} ;
+            throw bad_parametre (reason. c_str ()) ;
+        }
+        coordinates. resize (lua_rawlen (L, -1)) ;
+        for (size_t i = 0 ; i < coordinates. size () ; i++) {
+            lua_rawgeti (L, -1, i + 1) ;
+            coordinates[i] = lua_tonumber (L, -1) ;
+            lua_pop (L, 1) ;
+        }
+        lua_pop (L, 1) ;
+    }
+} ;
 %}
 
+/////////////////////////////////////
+// Bulk transfer of Lua arrays     //
+/////////////////////////////////////
+// The vertices of a script are passed as one flat Lua table of numbers
+// {x0, y0, x1, y1, ...}, converted in a single loop here, rather than with
+// one wrapped call to push_back (x, y) per vertex. Only the arguments with
+// these names are converted, so the other vectors are not affected.
+%typemap(in) const std::vector<double> &coordinates (std::vector<double> temp) {
+    if (!lua_istable (L, $input))
+        SWIG_fail_arg ("$symname", $argnum, "table of numbers") ;
+    size_t n = lua_rawlen (L, $input) ;
+    temp. resize (n) ;
+    for (size_t i = 0 ; i < n ; i++) {
+        lua_rawgeti (L, $input, i + 1) ;
+        if (!lua_isnumber (L, -1)) {
+            lua_pop (L, 1) ;
+            SWIG_fail_arg ("$symname", $argnum, "table of numbers") ;
+        }
+        temp[i] = lua_tonumber (L, -1) ;
+        lua_pop (L, 1) ;
+    }
+    $1 = &temp ;
+}
+// A Lua function stays on the stack during the call, where
+// Lua_batch_function finds it.
+%typemap(in) const std::function<void (std::vector<double> &)> &f (std::function<void (std::vector<double> &)> temp) {
+    if (!lua_isfunction (L, $input))
+        SWIG_fail_arg ("$symname", $argnum, "function") ;
+    temp = Lua_batch_function {L, $input} ;
+    $1 = &temp ;
+}
+
+// The interpreter runs on one thread.
+%typemap(in, numinputs=0) const bool thread_safe {
+    $1 = false ;
+}
+
+%typemap(in) const std::vector<long_unsigned_int> &sizes (std::vector<long_unsigned_int> temp) {
+    if (!lua_istable (L, $input))
+        SWIG_fail_arg ("$symname", $argnum, "table of numbers") ;
+    size_t n = lua_rawlen (L, $input) ;
+    temp. resize (n) ;
+    for (size_t i = 0 ; i < n ; i++) {
+        lua_rawgeti (L, $input, i + 1) ;
+        if ((!lua_isnumber (L, -1)) || (lua_tonumber (L, -1) < 0)) {
+            lua_pop (L, 1) ;
+            SWIG_fail_arg ("$symname", $argnum, "table of positive numbers") ;
+        }
+        temp[i] = static_cast<long_unsigned_int> (lua_tonumber (L, -1)) ;
+        lua_pop (L, 1) ;
+    }
+    $1 = &temp ;
+}
+
+// The results are returned as Lua tables, filled without wrapping each
+// value.
+%typemap(out) std::vector<double> {
+    lua_createtable (L, $1. size (), 0) ;
+    for (size_t i = 0 ; i < $1. size () ; i++) {
+        lua_pushnumber (L, $1[i]) ;
+        lua_rawseti (L, -2, i + 1) ;
+    }
+    SWIG_arg++ ;
+}
+
+%typemap(out) std::vector<long_unsigned_int> {
+    lua_createtable (L, $1. size (), 0) ;
+    for (size_t i = 0 ; i < $1. size () ; i++) {
+        lua_pushnumber (L, $1[i]) ;
+        lua_rawseti (L, -2, i + 1) ;
+    }
+    SWIG_arg++ ;
+}
+
+/////////////////////////////////////
+// Profiling                       //
+/////////////////////////////////////
+// Each wrapped call is recorded when dpps runs with --profile or DPPS_PROFILE
+// (see profiler.hh), with the size of the patterns among its arguments,
+// counted after the call so that those filled by a Reader are included.
+%exception {
+    {
+        Profiled_call profiled_call ("$name") ;
+        $action
+        if (profiled_call. is_active ()) {
+            for (int profiled_i = 1 ; profiled_i <= lua_gettop (L) ; profiled_i++) {
+                Pattern *profiled_pattern ;
+                if (lua_isuserdata (L, profiled_i) &&
+                    SWIG_IsOK (SWIG_ConvertPtr (L, profiled_i,
+                        (void **) &profiled_pattern, SWIGTYPE_p_dpps__Pattern, 0)))
+                    profiled_call. add_pattern (*profiled_pattern) ;
+            }
+        }
+    }
+}
+
 typedef enum {
     quadrant_centre,
     quadrant_pxpy,
@@ -125,9 +274,39 @@ public:
     bool is_aligned (const Vertex &v, const Vertex &w, double precision) const ;
 };
 
+class Affine_transform {
+public:
+    Affine_transform () ;
+    Affine_transform (const double a, const double b, const double c,
+                      const double d, const double e, const double f) ;
+    void display () const ;
+    std::string display_string () const ;
+    double get_coefficient (const short unsigned int i) const ;
+    void clear () ;
+    bool is_identity () const ;
+    void translate (const double x, const double y) ;
+    void rotate (const double x, const double y, const double angle) ;
+    void scale (const double x, const double y,
+                const double fx, const double fy) ;
+    void symmetry_x (const double y0) ;
+    void symmetry_y (const double x0) ;
+    void transpose () ;
+    void then (const Affine_transform &t) ;
+    Vertex apply (const Vertex &v) const ;
+} ;
+
+class Vertex_vector {
+public:
+    long_unsigned_int size () const ;
+    bool empty () const ;
+    void clear () ;
+    void push_back (const Vertex &v) ;
+    Vertex &at (long_unsigned_int i) ;
+} ;
+
 class Polyline {
 public:
-    vector<Vertex> vertices;
+    Vertex_vector vertices;
     bool closed;
     double dose;
     unsigned int reference;
@@ -154,6 +333,8 @@ public:
     void push_back_relative (const Vertex &v) ;
     void push_back (const double x, const double y) ;
     void push_back_relative (const double x, const double y) ;
+    void push_back_coordinates (const std::vector<double> &coordinates) ;
+    std::vector<double> get_coordinates () const ;
     bool operator== (const Polyline &p) const ;
     Polyline operator+ (const Vertex &v) const ;
     Polyline operator- (const Vertex &v) const ;
@@ -175,6 +356,7 @@ public:
     double vertical_size () const ;
     double maximum_distance () const ;
     double minimum_distance () const ;
+    double distance_to (const Vertex &v) const ;
     double area () const ;
     double algebraic_area () const ;
     double algebraic_length () const ;
@@ -238,7 +420,9 @@ public:
     double turning_angle_at_vertex (long_unsigned_int i) const ;
     void apply_matrix (Matrix3x3 matrix) ;
     void apply_homography (Matrix3x3 matrix) ;
+    void apply_transform (const Affine_transform &transform) ;
     void subdivide (const double distance) ;
+    void simplify (const double tolerance) ;
     void reorder_vertices_by_angle() ;
     Vertex closest_to (const Vertex &v) const ;
     long_unsigned_int closest_to_index (const Vertex &v) const ;
@@ -262,6 +446,19 @@ typedef enum {
     partial_dash_policy_fit
 } enum_partial_dash_policy ;
 
+typedef enum {
+    fill_rule_extent,
+    fill_rule_even_odd,
+    fill_rule_nonzero
+} enum_fill_rule ;
+
+typedef enum {
+    boolean_operation_union,
+    boolean_operation_intersection,
+    boolean_operation_difference,
+    boolean_operation_xor
+} enum_boolean_operation ;
+
 typedef enum {
     type_uniform_real_distribution,
     type_normal_distribution,
@@ -272,7 +469,8 @@ typedef enum {
     type_student_t_distribution,
     type_exponential_distribution,
     type_gamma_distribution,
-    type_weibull_distribution
+    type_weibull_distribution,
+    type_Poisson_disk_distribution
 } enum_distribution ;
 
 typedef enum {
@@ -364,6 +562,8 @@ typedef enum {
     progression_model_exponential
 } enum_progression_model ;
 
+class Writer ;
+
 class Pattern {
 //friend class Pattern_factory ;
 //friend class Writer ;
@@ -376,11 +576,15 @@ public:
     Pattern (const Pattern &source) ;
     Pattern &operator= (const Pattern &source) ;
 //     virtual ~Pattern () ;
+    void set_random_seed (const long_unsigned_int seed) ;
+    void set_counter_based_random (const bool counter_based) ;
 //     virtual void set_parametres (const vector<bool> &vbool,
 //                                  const vector<long_unsigned_int> &vint,
 //                                  const vector<double> &vdouble,
 //                                  const vector<string> &vstring) ;
 //     virtual void generate () ;
+    long_unsigned_int stream (Writer &writer,
+                              const bool with_polylines = false) ;
     //long_unsigned_int size_all () const ;
     void select (const enum_logical_action action,
                  const selection_t selection) ;
@@ -391,6 +595,13 @@ public:
     void select_window (const Vertex &min, const Vertex &max,
                         const bool dots_as_circles = true,
                         const selection_t selection = 0) ;
+    long_unsigned_int nearest_polyline (const Vertex &v,
+                                        const selection_t selection = -1) const ;
+    void set_spatial_index (const bool use) ;
+    void invalidate_spatial_index () ;
+    void select_inside (const Polyline &outline,
+                        const selection_t selection = 0) ;
+    void select_self_crossing (const selection_t selection = 0) ;
     void select_all (const bool status) ;
     void toggle (const selection_t) ;
     void toggle_all () ;
@@ -407,6 +618,9 @@ public:
                   const double comparison_value,
                   double tolerance,
                   const selection_t selection = 0) ;
+    void select_where (const char *expression,
+                       const double tolerance = 0.0,
+                       const selection_t selection = 0) ;
     void select_uniform_pseudorandom (const double fraction,
                                       const selection_t selection = 0) ;
     void selection_logical_operation (
@@ -486,16 +700,34 @@ public:
                                       const bool translate = true,
                                       const bool keep_initial_properties = true,
                                       const selection_t selection = -1) ;
+    long_unsigned_int add_cell (const char *name, const Pattern &pattern) ;
+    void add_instance (const long_unsigned_int cell,
+                       const double x, const double y,
+                       const double angle = 0,
+                       const double scale = 1) ;
+    void replace_polyline_by_instance (const Pattern &p,
+                                       const char *cell_name,
+                                       const bool centre = true,
+                                       const bool keep_initial_properties = true,
+                                       const selection_t selection = -1) ;
+    void flatten (const selection_t selection = -1) ;
     void replace_by_regular_polygon (const long_unsigned_int number_vertices,
                                      const double diametre,
                                      const bool keep_initial_properties = true,
                                      const selection_t selection = -1) ;
     void fill_with_lines (const double angle, const double spacing,
                           const bool keep_initial,
-                          const selection_t selection = -1) ;
+                          const selection_t selection = -1,
+                          const enum_fill_rule fill_rule = fill_rule_extent) ;
     void fill_with_lines_first_angle (const double spacing,
                                       const bool keep_initial,
-                                      const selection_t selection = -1) ;
+                                      const selection_t selection = -1,
+                                      const enum_fill_rule fill_rule =
+                                          fill_rule_extent) ;
+    void fill_region_with_lines (const double angle, const double spacing,
+                                 const enum_fill_rule fill_rule,
+                                 const bool keep_initial,
+                                 const selection_t selection = -1) ;
     void fill_with_dashes (const double angle,
                     const double spacing_longitudinal,
                     const double spacing_transversal,
@@ -504,7 +736,8 @@ public:
                     const double phase_increment,
                     const enum_partial_dash_policy partial_policy,
                     const bool keep_initial,
-                    const selection_t selection = -1) ;
+                    const selection_t selection = -1,
+                    const enum_fill_rule fill_rule = fill_rule_extent) ;
     void fill_with_dashes_first_angle (
                 const double spacing_longitudinal,
                 const double spacing_transversal,
@@ -513,7 +746,29 @@ public:
                 const double phase_increment,
                 const enum_partial_dash_policy partial_policy,
                 const bool keep_initial,
-                const selection_t selection = -1) ;
+                const selection_t selection = -1,
+                const enum_fill_rule fill_rule = fill_rule_extent) ;
+    void fill_region_with_dashes (const double angle,
+                    const double spacing_longitudinal,
+                    const double spacing_transversal,
+                    const double duty_cycle,
+                    const double phase_initial,
+                    const double phase_increment,
+                    const enum_partial_dash_policy partial_policy,
+                    const enum_fill_rule fill_rule,
+                    const bool keep_initial,
+                    const selection_t selection = -1) ;
+    void boolean_operation (const enum_boolean_operation operation,
+                            const selection_t selection_a,
+                            const selection_t selection_b,
+                            const bool keep_initial = false) ;
+    void boolean_union (const selection_t selection = -1) ;
+    void boolean_intersection (const selection_t selection_a,
+                               const selection_t selection_b) ;
+    void boolean_difference (const selection_t selection_a,
+                             const selection_t selection_b) ;
+    void boolean_xor (const selection_t selection_a,
+                      const selection_t selection_b) ;
     void duplicate (const selection_t selection = -1) ;
     void reverse_vertices (const selection_t selection = -1) ;
     void round_to (const double precision) ;
@@ -528,9 +783,14 @@ public:
     void add_to_reference (const long_unsigned_int additive_constant, const selection_t selection = -1) ;
     void subtract_to_reference (const long_unsigned_int additive_constant, const selection_t selection = -1) ;
     void erase (const selection_t selection = -1) ;
+    void compact () ;
     void set_closure (const bool closure_value, const selection_t selection = -1) ;
     void toggle_open_close (const selection_t selection = -1) ;
     void push_back (const Polyline &p) ;
+    void push_back_coordinates (const std::vector<double> &coordinates,
+                                const std::vector<long_unsigned_int> &sizes) ;
+    std::vector<double> get_coordinates (const selection_t selection = -1) const ;
+    std::vector<long_unsigned_int> get_sizes (const selection_t selection = -1) const ;
     //void push_front (const Polyline &p) ;
     Polyline pop_back () ;
     //void pop_front () ;
@@ -613,9 +873,16 @@ public:
         const double precision = std::numeric_limits<double>::epsilon(),
         const selection_t selection = -1) ;
     void subdivide (const double distance, const selection_t selection = -1) ;
+    void simplify (const double tolerance, const selection_t selection = -1) ;
     void reorder_vertices_by_angle(const selection_t selection = -1) ;
     void apply_matrix (Matrix3x3 &matrix, const selection_t selection = -1) ;
     void apply_homography (Matrix3x3 &matrix, const selection_t selection = -1) ;
+    void map_vertices (const std::function<void (std::vector<double> &)> &f,
+                       long_unsigned_int batch_size = 65536,
+                       const bool thread_safe = false,
+                       const selection_t selection = -1) ;
+    void apply_transform (const Affine_transform &transform,
+                          const selection_t selection = -1) ;
     void cycle (long_unsigned_int val, const bool forward,
                 const selection_t selection = -1) ;
     void cut_into (Polyline p,
@@ -623,6 +890,8 @@ public:
                    const long_unsigned_int pos_p,
                    const bool reverse_auto = true) ;
     void cut_into (Polyline p, const bool reverse_auto = true) ;
+    void cut_into (const Pattern &holes, const bool reverse_auto = true,
+                   const selection_t selection = -1) ;
     void check_closed(const double precision = std::numeric_limits<double>::epsilon(), const selection_t selection = -1) ;
 } ;
 
@@ -642,6 +911,9 @@ public:
 //                          const vector<long_unsigned_int> &vint,
 //                          const vector<double> &vdouble,
 //                          const vector<string> &vstring) ;
+    static long_unsigned_int Fibonacci_length (
+        const long_unsigned_int generation) ;
+    static bool Fibonacci_element (const long_unsigned_int n) ;
     void generate () ;
     void set_all_parametres (
         const bool bidimensionnal,
@@ -675,6 +947,19 @@ public:
         const double maxy,
         const double period,
         const double area_ratio) ;
+    void set_procedural (const bool procedural) ;
+    long_unsigned_int implicit_size () const ;
+    double implicit_area () const ;
+    bool implicit_limits (double &xmin, double &ymin,
+                          double &xmax, double &ymax) const ;
+    long_unsigned_int implicit_size_in_window (const double xmin,
+                                               const double ymin,
+                                               const double xmax,
+                                               const double ymax) const ;
+    void materialize_window (const double xmin, const double ymin,
+                             const double xmax, const double ymax,
+                             const selection_t selection = 0) ;
+    void materialize (const selection_t selection = 0) ;
 } ;
 
 class Pattern_hard_sphere_random_packing: public Pattern {
@@ -703,6 +988,10 @@ public:
         const double lx,
         const double ly,
         const double diametre) ;
+    void set_report_throughput (const bool report_throughput) ;
+    void set_tiles (const long_unsigned_int tiles_x,
+                    const long_unsigned_int tiles_y) ;
+    std::string get_throughput_string () const ;
 } ;
 
 class Pattern_Penrose_tiling: public Pattern {
@@ -721,6 +1010,10 @@ public:
 //                          const vector<double> &vdouble,
 //                          const vector<string> &vstring) ;
     void generate () ;
+    void stream_P3 (Writer &writer) const ;
+    void set_window (const double xmin, const double ymin,
+                     const double xmax, const double ymax) ;
+    void clear_window () ;
     void set_all_parametres (
         const long_unsigned_int generation,
         const enum_start_tile start_tile,
@@ -791,6 +1084,19 @@ public:
         const double period_x,
         const double period_y,
         const double area_ratio) ;
+    void set_procedural (const bool procedural) ;
+    long_unsigned_int implicit_size () const ;
+    double implicit_area () const ;
+    bool implicit_limits (double &xmin, double &ymin,
+                          double &xmax, double &ymax) const ;
+    long_unsigned_int implicit_size_in_window (const double xmin,
+                                               const double ymin,
+                                               const double xmax,
+                                               const double ymax) const ;
+    void materialize_window (const double xmin, const double ymin,
+                             const double xmax, const double ymax,
+                             const selection_t selection = 0) ;
+    void materialize (const selection_t selection = 0) ;
 } ;
 
 typedef enum {
@@ -911,6 +1217,107 @@ public:
         const double inner_minor_axis,
         const double inner_angle_x) ;
 
+    static long_unsigned_int number_vertices_for_tolerance (
+        const double diametre,
+        const double tolerance) ;
+    static Polyline circle (const double diametre, const double tolerance) ;
+    static Polyline ellipse (const double major_axis,
+                             const double minor_axis,
+                             const double angle_x,
+                             const double tolerance) ;
+    static Polyline arc (const double diametre,
+                         const double start_angle,
+                         const double end_angle,
+                         const double tolerance) ;
+} ;
+
+class Pattern_cache {
+public:
+    static void set_directory (const char *new_directory) ;
+    static std::string get_directory () ;
+    static bool enabled () ;
+} ;
+
+class Pattern_store {
+public:
+    Pattern_store (const char *set_directory,
+                   const long_unsigned_int set_chunk_size = 1048576) ;
+    ~Pattern_store () ;
+    void push_back (const Polyline &p) ;
+    void append (const Pattern &p) ;
+    void flush () ;
+    void clear () ;
+    long_unsigned_int size () const ;
+    long_unsigned_int vertices_size () const ;
+    long_unsigned_int number_chunks () ;
+    void translate (const double x0, const double y0,
+                    const selection_t selection = -1) ;
+    void set_dose (const double dose_value, const selection_t selection = -1) ;
+    void select_window (const double xmin, const double ymin,
+                        const double xmax, const double ymax,
+                        const selection_t selection = 0) ;
+    void append_window_to_pattern (Pattern &p,
+                                   const double xmin, const double ymin,
+                                   const double xmax, const double ymax) ;
+    void write_to (Writer &writer) ;
+} ;
+
+class Pattern_packed {
+public:
+    Pattern_packed () ;
+    Pattern_packed (const Pattern &p) ;
+    void assign (const Pattern &p) ;
+    Pattern to_Pattern (const selection_t selection = -1) const ;
+    void clear () ;
+    void push_back (const Polyline &p) ;
+    Polyline get_polyline (const long_unsigned_int i) const ;
+    long_unsigned_int size (const selection_t selection = -1) const ;
+    long_unsigned_int vertices_size (const selection_t selection = -1) const ;
+    void select (const enum_logical_action action,
+                 const selection_t selection) ;
+    void selection_logical_operation (
+                  const selection_t destination_selection,
+                  const selection_t selection_p,
+                  const selection_t selection_q,
+                  const enum_logical_operator logical_operator) ;
+    void selection_swap (const selection_t selection_p,
+                         const selection_t selection_q) ;
+    void select_window (const double xmin, const double ymin,
+                        const double xmax, const double ymax,
+                        const bool dots_as_circles = true,
+                        const selection_t selection = 0) ;
+    void translate (const double x0, const double y0,
+                    const selection_t selection = -1) ;
+    void scale (const double x0, const double y0,
+                const double fx, const double fy,
+                const selection_t selection = -1) ;
+    void rotate (const double x0, const double y0, const double angle,
+                 const selection_t selection = -1) ;
+    void set_dose (const double dose_value, const selection_t selection = -1) ;
+    double area (const selection_t selection = -1) const ;
+    double algebraic_area (const selection_t selection = -1) const ;
+    double perimeter (const selection_t selection = -1) const ;
+    double length (const selection_t selection = -1) const ;
+    Vertex lower_left (const selection_t selection = -1) const ;
+    Vertex upper_right (const selection_t selection = -1) const ;
+} ;
+
+class Proximity_correction {
+public:
+    Proximity_correction () ;
+    Proximity_correction (const double alpha,
+                          const double beta,
+                          const double eta,
+                          const double pixel_size,
+                          const long_unsigned_int iterations = 10,
+                          const double target_exposure = 0.0) ;
+    void set_all_parametres (const double alpha,
+                             const double beta,
+                             const double eta,
+                             const double pixel_size,
+                             const long_unsigned_int iterations,
+                             const double target_exposure) ;
+    void correct (Pattern &pattern, const selection_t selection = -1) ;
 } ;
 
 class Pattern_factory {
@@ -919,10 +1326,18 @@ public:
     static Pattern fill_with_lines (
                             const Polyline &polyline,
                             const double angle,
-                            const double spacing) ;
+                            const double spacing,
+                            const enum_fill_rule fill_rule = fill_rule_extent) ;
+    static Pattern fill_region_with_lines (
+                            const Pattern &pattern,
+                            const double angle,
+                            const double spacing,
+                            const enum_fill_rule fill_rule = fill_rule_even_odd,
+                            const selection_t selection = -1) ;
     static Pattern fill_with_lines_first_angle (
                             const Polyline &polyline,
-                            const double spacing) ;
+                            const double spacing,
+                            const enum_fill_rule fill_rule = fill_rule_extent) ;
     static Pattern from_initialization_list (shape list) ;
     static Pattern fill_with_dashes (
                          const Polyline &polyline,
@@ -932,7 +1347,8 @@ public:
                          const double duty_cycle,
                          const double phase_initial,
                          const double phase_increment,
-                         const enum_partial_dash_policy partial_dash_policy) ;
+                         const enum_partial_dash_policy partial_dash_policy,
+                         const enum_fill_rule fill_rule = fill_rule_extent) ;
     static Pattern fill_with_dashes_first_angle (
                            const Polyline &polyline,
                            const double period_longitudinal,
@@ -940,7 +1356,24 @@ public:
                            const double duty_cycle,
                            const double phase_initial,
                            const double phase_increment,
-                           const enum_partial_dash_policy partial_dash_policy) ;
+                           const enum_partial_dash_policy partial_dash_policy,
+                           const enum_fill_rule fill_rule = fill_rule_extent) ;
+    static Pattern fill_region_with_dashes (
+                         const Pattern &pattern,
+                         const double angle,
+                         const double period_longitudinal,
+                         const double spacing_transversal,
+                         const double duty_cycle,
+                         const double phase_initial,
+                         const double phase_increment,
+                         const enum_partial_dash_policy partial_dash_policy,
+                         const enum_fill_rule fill_rule = fill_rule_even_odd,
+                         const selection_t selection = -1) ;
+    static Pattern boolean_operation (
+                         const Pattern &pattern,
+                         const enum_boolean_operation operation,
+                         const selection_t selection_a,
+                         const selection_t selection_b) ;
     static Pattern Pattern_from_selected (Pattern &p,
                                                 selection_t selection = -1) ;
     static Pattern compare (const Pattern &pattern_old,
@@ -1001,6 +1434,9 @@ public:
 //                          const vector<double> &vdouble,
 //                          const vector<string> &vstring) ;
     bool read_polyline (Polyline &p) ;
+    void append_to_pattern_parallel (Pattern &pattern) ;
+    void append_indexed_to_pattern (Pattern &pattern,
+                                    const bool use_sidecar = true) ;
     void set_all_parametres (
         const bool set_reference_from_layer,
         const bool include_blocks,
@@ -1009,6 +1445,14 @@ public:
         const char *layers_to_read) ;
      std::vector<std::string> get_layers_read () const ;
      void close() ;
+    static void append_cached_to_pattern (
+        Pattern &pattern,
+        const char *set_filename,
+        const bool set_reference_from_layer,
+        const bool include_blocks,
+        const enum_regex regex_grammar,
+        const char *layers_to_read) ;
+    static void clear_cache () ;
 };
 
 class Reader_witec: public Reader {
@@ -1017,11 +1461,27 @@ public:
     Reader_witec (const char *set_filename,
         const bool construction_lines) ;
     bool read_polyline (Polyline &p) ;
+    Pattern verify (const Pattern &source, const double precision = 0.001) ;
     void set_all_parametres (
         const bool construction_lines) ;
      void close() ;
 } ;
 
+class Reader_dpps: public Reader {
+public:
+    Reader_dpps (const char *set_filename) ;
+    bool read_polyline (Polyline &p) ;
+    long_unsigned_int size () const ;
+    long_unsigned_int vertices_size () const ;
+    bool has_bounding_boxes () const ;
+    Polyline get_polyline (const long_unsigned_int i) const ;
+    void rewind () ;
+    void append_window_to_pattern (Pattern &p,
+                                   const double xmin, const double ymin,
+                                   const double xmax, const double ymax) const ;
+    void close () ;
+} ;
+
 #if defined (QT_FOUND) || defined (PNGPP_FOUND)
     typedef enum {
         image_reader_import_x_lines,
@@ -1029,7 +1489,8 @@ public:
         image_reader_import_dots,
         image_reader_import_x_rectangles,
         image_reader_import_y_rectangles,
-        image_reader_import_squares
+        image_reader_import_squares,
+        image_reader_import_merged_rectangles
     } enum_image_reader_mode ;
 class Reader_image: public Reader {
 public:
@@ -1047,6 +1508,12 @@ public:
         const long_unsigned_int green,
         const long_unsigned_int blue,
         const double size) ;
+    void add_palette_colour (const long_unsigned_int red,
+                             const long_unsigned_int green,
+                             const long_unsigned_int blue,
+                             const long_unsigned_int reference,
+                             const double dose = 0.0) ;
+    void clear_palette () ;
      void close() ;
 } ;
 #endif
@@ -1080,6 +1547,12 @@ public:
         const long_unsigned_int green,
         const long_unsigned_int blue,
         const double size) ;
+    void add_palette_colour (const long_unsigned_int red,
+                             const long_unsigned_int green,
+                             const long_unsigned_int blue,
+                             const long_unsigned_int reference,
+                             const double dose = 0.0) ;
+    void clear_palette () ;
      void close() ;
 } ;
 #endif
@@ -1113,17 +1586,62 @@ public:
         const long_unsigned_int green,
         const long_unsigned_int blue,
         const double size) ;
+    void add_palette_colour (const long_unsigned_int red,
+                             const long_unsigned_int green,
+                             const long_unsigned_int blue,
+                             const long_unsigned_int reference,
+                             const double dose = 0.0) ;
+    void clear_palette () ;
      void close() ;
 } ;
 #endif
 
+#ifdef PNG_FOUND
+class Reader_image_png_stream: public Reader_image {
+public:
+    Reader_image_png_stream (
+        const char *set_filename,
+        const bool only_this_colour,
+        const enum_image_reader_mode mode,
+        const long_unsigned_int red,
+        const long_unsigned_int green,
+        const long_unsigned_int blue,
+        const double size) ;
+    // image_pixel has to appear so that swig knows class is not abstract.
+    std::array<short unsigned int, 3> image_pixel (
+        const long_unsigned_int column,
+        const long_unsigned_int row) const ;
+    bool read_polyline (Polyline &p) ;
+    Reader_image_png_stream (const char *filename) ;
+    void append_to_pattern (Pattern &p) ;
+    void set_all_parametres (
+        const bool only_this_colour,
+        const enum_image_reader_mode mode,
+        const long_unsigned_int red,
+        const long_unsigned_int green,
+        const long_unsigned_int blue,
+        const double size) ;
+    void add_palette_colour (const long_unsigned_int red,
+                             const long_unsigned_int green,
+                             const long_unsigned_int blue,
+                             const long_unsigned_int reference,
+                             const double dose = 0.0) ;
+    void clear_palette () ;
+    void close () ;
+} ;
+#endif
+
 class Writer {
 public:
     Writer (const char *set_filename, const bool append) ;
     virtual void write_header () ;
     virtual void write_footer () ;
+    virtual void begin_stream () ;
+    virtual void write_Polyline_stream (const Polyline &polyline) ;
+    virtual void end_stream () ;
     virtual ~Writer () ;
     void close () ;
+    void set_asynchronous (const bool asynchronous) ;
 //     virtual void set_parametres (const vector<bool> &vbool,
 //                                  const vector<long_unsigned_int> &vint,
 //                                  const vector<double> &vdouble,
@@ -1166,6 +1684,7 @@ public:
     void set_dot_dxf_export (const enum_dot_dxf_export dot_dxf_export) ;
     void set_two_point_line_as_polyline (const bool two_point_line_as_polyline) ;
     void set_layer_colours (char *layer_colour_parametre) ;
+    void set_instances_as_blocks (const bool instances_as_blocks) ;
 } ;
 
 class Writer_SVG: public Writer {
@@ -1186,14 +1705,52 @@ public:
         const double maxx,
         const double maxy,
         const char *style) ;
+    void set_compact (const bool compact,
+                      const long_unsigned_int decimals = 3) ;
+    void set_preview (const long_unsigned_int preview_pixels,
+                      const bool density_raster = true) ;
 } ;
 
 class Writer_cpp: public Writer {
 public:
     Writer_cpp (const char *set_filename, const bool append) ;
     void write_Polyline (const Polyline &polyline) ;
+    void set_table (const bool table, const char *name = "output") ;
+} ;
+
+class Writer_dpps: public Writer {
+public:
+    Writer_dpps (const char *set_filename) ;
+    void write_Polyline (const Polyline &polyline) ;
+    void set_all_parametres (const bool bounding_boxes) ;
+    void close () ;
 } ;
 
+#ifdef PNG_FOUND
+class Writer_image_png: public Writer {
+public:
+    Writer_image_png (const char *set_filename) ;
+    Writer_image_png (const char *set_filename,
+                      const double minx,
+                      const double miny,
+                      const double maxx,
+                      const double maxy,
+                      const double pixel_size,
+                      const bool use_dose = false,
+                      const double full_scale = 1.0) ;
+    void write_Polyline (const Polyline &polyline) ;
+    void set_all_parametres (const double minx,
+                             const double miny,
+                             const double maxx,
+                             const double maxy,
+                             const double pixel_size,
+                             const bool use_dose,
+                             const double full_scale) ;
+    void set_band_rows (const long_unsigned_int band_rows) ;
+    void close () ;
+} ;
+#endif
+
 typedef enum {
     hysteresis_no_correction,
     hysteresis_quadrant_pxpy,
@@ -1212,6 +1769,7 @@ typedef enum {
 
 class Writer_witec: public Writer {
 public:
+    Writer_witec () ;
     Writer_witec (const char *set_filename, const bool append) ;
     void write_header () ;
     void write_footer () ;
@@ -1258,9 +1816,49 @@ public:
         const double piezo_y_range) ;
     void add_focus_point (const Vertex &position, const double value) ;
     void clear_focus_points () ;
+    void set_travel_planning (const bool plan_travel,
+                              const bool reverse_polylines) ;
+    void set_command_optimization (const bool optimize_commands) ;
+    void set_polyline_chaining (const bool chain_polylines,
+                                const double tolerance = 0.001) ;
+    double get_estimated_duration () const ;
+    double get_field_duration (const long signed int i,
+                               const long signed int j) const ;
+    double get_reference_duration (const long_unsigned_int reference) const ;
+    std::string get_simulation_report () const ;
+    void simulate_by_field (const Pattern &pattern,
+                            const selection_t selection = -1) ;
+    void write_Pattern_by_field (const Pattern &pattern,
+                                 const selection_t selection = -1) ;
+} ;
+
+class Pipeline {
+public:
+    Pipeline (Reader &set_reader, Writer &set_writer) ;
+    Pipeline (Pattern &set_generator, Writer &set_writer) ;
+    void translate (const double x, const double y) ;
+    void rotate (const double x, const double y, const double angle) ;
+    void scale (const double x, const double y,
+                const double fx, const double fy) ;
+    void symmetry_x (const double y0) ;
+    void symmetry_y (const double x0) ;
+    void apply_transform (const Affine_transform &transform) ;
+    void round_to (const double precision) ;
+    void subdivide (const double distance) ;
+    void simplify (const double tolerance) ;
+    void set_dose (const double dose_value) ;
+    void multiply_dose (const double multiplication_factor) ;
+    void set_reference (const long_unsigned_int reference_value) ;
+    void keep_references (const long_unsigned_int minimum,
+                          const long_unsigned_int maximum) ;
+    void keep_minimum_size (const long_unsigned_int minimum_size) ;
+    void clear () ;
+    long_unsigned_int run () ;
 } ;
 
 std::string vector_to_string (const std::vector<std::string> list, const char separator=',') ;
+void set_number_threads (const int number_threads) ;
+int get_number_threads () ;
 
 class Matrix2x2 {
 public:
@@ -0,0 +1,117 @@
+/**
+ * @file batch.cpp
+ * @author Jérôme Borme <jerome.borme@inl.int>
+ * @version 1.0
+ * @brief Runs a list of Lua files with their preprocessor expressions
+ * @date 2026-10-14 Jérôme Borme: Initial version
+ * @copyright
+ * This Source Code Form is subject to the terms of the Mozilla Public
+ * License, v. 2.0. If a copy of the MPL was not distributed with this
+ * file, You can obtain one at http://mozilla.org/MPL/2.0/.
+ * */
+
+#include <exception>
+#include <fstream>
+#include <iostream>
+#include <sstream>
+#include <string>
+#include <vector>
+
+#include "configure.h" // created by cmake
+#include "common.hh"
+#include "util.hh"
+#include "bad_io.hh"
+#include "batch.hh"
+#include "interpret_lua.hh"
+#include "preprocessor.hh"
+
+extern "C" {
+#include "lua.h"
+}
+
+#ifdef OPENMP_FOUND
+#include <omp.h>
+#endif
+
+namespace {
+struct Job {
+    long_unsigned_int line_number ;
+    // the Lua file first, as #0# of the preprocessor
+    std::vector<std::string> expressions ;
+} ;
+
+// runs a job in L, and returns the error message, empty on success
+std::string run_job (lua_State *L, Job &job) {
+    std::string error ;
+    std::string script ;
+    try {
+        script = preprocess_script (job. expressions. front (),
+                                    job. expressions) ;
+        run_lua_string (L, script, job. expressions. front (), true) ;
+    } catch (std::exception &e) {
+        error = e. what () ;
+    }
+    return error ;
+}
+} // namespace
+
+long_unsigned_int run_batch (const std::string &manifest_filename) {
+    std::ifstream manifest ;
+    manifest. open (manifest_filename, std::ios_base::in) ;
+    if (!manifest. is_open ()) {
+        std::string reason {"run_batch: File " + manifest_filename +
+                            " could not be open for input"} ;
+        throw dpps::bad_io (reason. c_str ()) ;
+    }
+    std::vector<Job> jobs ;
+    std::string line ;
+    long_unsigned_int line_number {0} ;
+    while (getline (manifest, line)) {
+        line_number++ ;
+        std::istringstream words {line} ;
+        Job job {line_number, {}} ;
+        std::string word ;
+        while (words >> word)
+            job. expressions. push_back (word) ;
+        if (job. expressions. empty () || (job. expressions[0][0] == '#'))
+            continue ;
+        jobs. push_back (job) ;
+    }
+    manifest. close () ;
+
+    // The states are created before the jobs start, since loading the
+    // wrapped module initializes tables shared by all the states.
+    long_unsigned_int number_states {static_cast<long_unsigned_int> (
+        dpps::get_number_threads ())} ;
+    std::vector<lua_State *> states ;
+    for (long_unsigned_int i {0} ; i < number_states ; i++)
+        states. push_back (new_lua_state ()) ;
+
+    long_unsigned_int failures {0} ;
+    long_unsigned_int n {jobs. size ()} ;
+#ifdef OPENMP_FOUND
+    #pragma omp parallel for schedule(dynamic, 1) num_threads(number_states)
+#endif
+    for (long_unsigned_int i = 0 ; i < n ; i++) {
+#ifdef OPENMP_FOUND
+        lua_State *L {states[omp_get_thread_num ()]} ;
+#else
+        lua_State *L {states[0]} ;
+#endif
+        std::string error {run_job (L, jobs[i])} ;
+        if (!error. empty ()) {
+#ifdef OPENMP_FOUND
+            #pragma omp critical (batch_output)
+#endif
+            {
+                std::cerr << manifest_filename << ":" << jobs[i]. line_number
+                          << ": " << jobs[i]. expressions. front () << ": "
+                          << error << "\n" ;
+                failures++ ;
+            }
+        }
+    }
+    for (auto L : states)
+        lua_close (L) ;
+    return failures ;
+}
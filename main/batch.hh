@@ -0,0 +1,39 @@
+/**
+ * @file batch.hh
+ * @author Jérôme Borme <jerome.borme@inl.int>
+ * @version 1.0
+ * @brief Runs a list of Lua files with their preprocessor expressions
+ * @date 2026-10-14 Jérôme Borme: Initial version
+ * @copyright
+ * This Source Code Form is subject to the terms of the Mozilla Public
+ * License, v. 2.0. If a copy of the MPL was not distributed with this
+ * file, You can obtain one at http://mozilla.org/MPL/2.0/.
+ * */
+
+#include <string>
+
+#include "common.hh"
+
+#ifndef DPPS_BATCH
+#define DPPS_BATCH
+
+/** @brief Runs each job of the manifest as dpps LUAFILE EXPR1 EXPR2... would,
+ * in a single process, and returns the number of jobs which failed.
+ *
+ * Each line of the manifest is a job, made of the name of the Lua file and
+ * the preprocessor expressions, separated by spaces or tabs as on the
+ * command-line (without quotes, so an expression cannot contain spaces).
+ * Empty lines and lines starting with # are ignored.
+ *
+ * Each thread (see get_number_threads()) keeps one Lua state for all its
+ * jobs, so that the libraries are loaded once per thread, and each job gets
+ * its own global variables (see run_lua_string()). The typefaces and the
+ * files imported with Reader_DXF_R12::append_cached_to_pattern() are kept
+ * in caches that all the jobs share, so they are read once for the whole
+ * batch. Without OpenMP, the jobs run one after the other.
+ *
+ * The errors of a job are written to std::cerr with its line number, and the
+ * other jobs are still run. Throws bad_io if the manifest cannot be read. */
+long_unsigned_int run_batch (const std::string &manifest_filename) ;
+
+#endif
@@ -36,21 +36,23 @@ void send_error (lua_State *L) {
     throw dpps::bad_parametre (reason. c_str ()) ;
 }
 
-void read_lua_file (
-    const std::string &configuration_filename) {
-
+lua_State *new_lua_state () {
     lua_State *L = luaL_newstate () ;
     luaL_openlibs (L) ;
 
     luaL_requiref (L, "dpps", luaopen_dpps, 1) ;
     lua_pop (L, 1) ;
+    return L ;
+}
+
+void read_lua_string (const std::string &script,
+                      const std::string &chunk_name) {
 
-    std::ifstream configuration_file ;
-    // We use double backets [[ ]] as string separator so that
-    // names with the backslash work. This is useful for certain OSes.
-    std::string line {"dofile([[" + configuration_filename + "]])"} ;
+    lua_State *L = new_lua_state () ;
 
-    int code = luaL_loadstring (L, line. c_str ()) ;
+    // The @ makes Lua quote chunk_name as a file name in its messages.
+    int code = luaL_loadbuffer (L, script. data (), script. size (),
+                                ("@" + chunk_name). c_str ()) ;
     if (code)
         send_error (L) ;
     code = lua_pcall (L, 0, 0, 0) ;
@@ -58,3 +60,29 @@ void read_lua_file (
         send_error (L) ;
     lua_close (L) ;
 }
+
+void run_lua_string (lua_State *L, const std::string &script,
+                     const std::string &chunk_name, const bool isolated) {
+    int code = luaL_loadbuffer (L, script. data (), script. size (),
+                                ("@" + chunk_name). c_str ()) ;
+    if ((!code) && isolated) {
+        // The first upvalue of a chunk is its _ENV, replaced by an empty
+        // table whose metatable reads the globals.
+        lua_newtable (L) ;
+        lua_newtable (L) ;
+        lua_pushglobaltable (L) ;
+        lua_setfield (L, -2, "__index") ;
+        lua_setmetatable (L, -2) ;
+        lua_setupvalue (L, -2, 1) ;
+    }
+    if (!code)
+        code = lua_pcall (L, 0, 0, 0) ;
+    if (code) {
+        // Unlike send_error(), L is kept open.
+        std::string reason {lua_tostring (L, -1)} ;
+        lua_pop (L, 1) ;
+        throw dpps::bad_parametre (reason. c_str ()) ;
+    }
+    // The patterns of the file are freed before the next one.
+    lua_gc (L, LUA_GCCOLLECT, 0) ;
+}
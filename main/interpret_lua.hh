@@ -15,6 +15,28 @@
 #ifndef DPPS_INTERPRET_LUA
 #define DPPS_INTERPRET_LUA
 
-void read_lua_file (const std::string &configuration_filename) ;
+// defined in lua.h
+struct lua_State ;
 
-#endif
\ No newline at end of file
+/** @brief runs script, the text of a Lua program, in a new Lua state. Error
+ * messages refer to it as chunk_name, normally the file it was read from. */
+void read_lua_string (const std::string &script,
+                      const std::string &chunk_name) ;
+
+/** @brief returns a new Lua state with the standard libraries and the dpps
+ * module loaded, to be closed with lua_close(). */
+lua_State *new_lua_state () ;
+
+/** @brief runs script in L, which remains usable afterwards, so that
+ * several scripts can be run in the same state without loading the libraries
+ * again. Error messages refer to it as chunk_name.
+ *
+ * If isolated is true, the global variables the script sets go into a table
+ * of its own, which reads the missing ones from the globals of L, so that the
+ * next script run does not see them. Files run with dofile() from the script
+ * still use the globals of L. Throws bad_parametre with the message of Lua
+ * on errors. */
+void run_lua_string (lua_State *L, const std::string &script,
+                     const std::string &chunk_name, const bool isolated) ;
+
+#endif
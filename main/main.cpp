@@ -13,13 +13,13 @@
 #include "configure.h"
 
 #include <cstdlib> // EXIT_SUCCESS
-#include <cstdio> // remove()
 #include <iostream>
 #include <string>
 
-#include "bad_io.hh"
+#include "batch.hh"
 #include "interpret_lua.hh"
 #include "preprocessor.hh"
+#include "profiler.hh"
 
 int main (int argc, char** argv) {
     std::string configuration_filename ;
@@ -35,21 +35,59 @@ int main (int argc, char** argv) {
         << "submitted to the GNU GPL version 3.0 as published by the Free "
         << "software foundation or, at your option, any later version\n."
 #endif
-        << "Syntax:\n    dpps LUAFILE EXPR1 EXPR2...\n"
-        << "    where EXPR1 EXPR2 are preprocessor expressions\n" ;
+        << "Syntax:\n    dpps [OPTIONS] LUAFILE EXPR1 EXPR2...\n"
+        << "    where EXPR1 EXPR2 are preprocessor expressions\n"
+        << "    dpps [OPTIONS] --batch MANIFEST\n"
+        << "    where each line of MANIFEST is LUAFILE EXPR1 EXPR2...\n"
+        << "Options:\n"
+        << "    --profile      writes the time spent in each dpps function\n"
+        << "                   when the scripts end (or set DPPS_PROFILE=1)\n"
+        << "    --trace FILE   also writes each call to FILE in the JSON\n"
+        << "                   trace-event format (or set DPPS_TRACE=FILE)\n" ;
         return EXIT_SUCCESS ;
     }
-    configuration_filename = argv [1] ;
-    for (int i = 1 ; i < argc ; i++) {
-        preprocessor_expressions. push_back (argv[i]) ;
+    enable_profiler_from_environment () ;
+    int first {1} ;
+    while (first < argc) {
+        std::string option {argv[first]} ;
+        if (option == "--profile")
+            enable_profiler ("") ;
+        else if (option == "--trace") {
+            if (first + 1 >= argc) {
+                std::cerr << "dpps --trace needs the name of the trace file\n" ;
+                return EXIT_FAILURE ;
+            }
+            first++ ;
+            enable_profiler (argv[first]) ;
+        }
+        else
+            break ;
+        first++ ;
+    }
+    if (first >= argc) {
+        std::cerr << "dpps needs the name of a Lua file\n" ;
+        return EXIT_FAILURE ;
     }
-    std::string temp_file {
-        preprocess_file (configuration_filename, preprocessor_expressions)} ;
-    read_lua_file (temp_file) ;
-    if (remove (temp_file. c_str ()) != 0) {
-        std::string reason {"main: file " + temp_file +
-                            " could not be removed"} ;
-        throw dpps::bad_io (reason. c_str ()) ;
+    if (std::string (argv[first]) == "--batch") {
+        if (first + 1 >= argc) {
+            std::cerr << "dpps --batch needs the name of the manifest\n" ;
+            return EXIT_FAILURE ;
+        }
+        long_unsigned_int failures {run_batch (argv[first + 1])} ;
+        write_profile (std::cerr) ;
+        if (failures > 0) {
+            std::cerr << failures << " jobs failed\n" ;
+            return EXIT_FAILURE ;
+        }
+        return EXIT_SUCCESS ;
+    }
+    configuration_filename = argv [first] ;
+    for (int i = first ; i < argc ; i++) {
+        preprocessor_expressions. push_back (argv[i]) ;
     }
+    std::string script {
+        preprocess_script (configuration_filename, preprocessor_expressions)} ;
+    read_lua_string (script, configuration_filename) ;
+    write_profile (std::cerr) ;
     return EXIT_SUCCESS ;
 }
\ No newline at end of file
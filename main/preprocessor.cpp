@@ -10,8 +10,10 @@
  * file, You can obtain one at http://mozilla.org/MPL/2.0/.
  * */
 
+#include <cctype>
 #include <fstream>
-#include <string> // getline is in <string>
+#include <iterator>
+#include <string>
 
 #include "configure.h" // created by cmake
 #include "common.hh"
@@ -21,70 +23,87 @@
 #include "bad_parametre.hh"
 #include "bad_io.hh"
 
-std::string preprocess_file (
+std::string preprocess_script (
     const std::string &configuration_filename,
     std::vector<std::string> &replacements) {
     std::ifstream infile ;
-    std::ofstream tmpfile ;
 
     infile. open (configuration_filename, std::ios_base::in) ;
     if (!infile. is_open ()) {
-        std::string reason {"preprocess_file: File " + configuration_filename +
+        std::string reason {"preprocess_script: File " + configuration_filename +
                             " could not be open for input"} ;
         throw dpps::bad_io (reason. c_str ()) ;
     }
-    std::string tmpfilename {tmpnam (nullptr)} ;
 #ifdef FILENAMES_FOR_WINDOWS
     // We escape backslashes so that the user can quote the filenames the normal
     // way with " " and not [[ ]] in the lua programs.
-    tmpfilename = ".\\" + tmpfilename ;
     for (auto &i : replacements) {
         dpps::replace_string (i, "\\", "/") ;
         dpps::replace_string (i, "/", "\\\\") ;
     }
 #endif
-    tmpfile. open (tmpfilename, std::ofstream::out|std::ofstream::trunc) ;
-    if (!tmpfile. is_open ()) {
-        std::string reason {"preprocess_file: File " + tmpfilename +
-                            " could not be open for output"} ;
-        throw dpps::bad_io (reason. c_str ()) ;
-    }
-    std::vector<std::string> expressions ;
-    std::vector<std::string> expressions_noaffix ;
     std::vector<std::string> replacements_noaffix ;
     for (long_unsigned_int i {0} ; i < replacements. size () ; i++) {
-        expressions. push_back ("#" + std::to_string (i) + "#") ;
-        expressions_noaffix. push_back ("#" + std::to_string (i) + "#noaffix#") ;
+        std::string expression {"#" + std::to_string (i) + "#"} ;
+        std::string expression_noaffix {"#" + std::to_string (i) + "#noaffix#"} ;
         replacements_noaffix. push_back (dpps::remove_affix (replacements.at(i))) ;
         for (auto &j : replacements) {
-            if (j. find (expressions. back()) != std::string::npos) {
-                std::string reason {"preprocess_file: command-line parametre "
+            if (j. find (expression) != std::string::npos) {
+                std::string reason {"preprocess_script: command-line parametre "
                     + std::to_string (i) + ": " + j + " contains special \
-sequence not allowed: " + expressions. back()} ;
+sequence not allowed: " + expression} ;
                 throw dpps::bad_parametre (reason. c_str ()) ;
             }
-            if (j. find (expressions_noaffix. back()) != std::string::npos) {
-                std::string reason {"preprocess_file: command-line parametre "
+            if (j. find (expression_noaffix) != std::string::npos) {
+                std::string reason {"preprocess_script: command-line parametre "
                     + std::to_string (i) + ": " + j + " contains special \
-sequence not allowed: " + expressions. back()} ;
+sequence not allowed: " + expression} ;
                 throw dpps::bad_parametre (reason. c_str ()) ;
             }
         }
     }
-    std::string line ;
-    bool stay {true} ;
-    while (stay) {
-        stay = getline (infile, line). good () ;
-        // It will return false on the last line.
-        // (actually it will say eof()==true which implies good()==false
-        // We will process the last line and return.
-        for (long_unsigned_int i {0} ; i < replacements. size () ; i++) {
-            dpps::replace_string (line, expressions_noaffix. at (i), replacements_noaffix. at (i)) ;
-            dpps::replace_string (line, expressions. at (i), replacements. at (i)) ;
+    std::string script {std::istreambuf_iterator<char> (infile),
+                        std::istreambuf_iterator<char> ()} ;
+    infile. close () ;
+    // Each # is looked at once: if digits and a # follow, and they are the
+    // number of a parametre written without leading zeros, the sequence
+    // (with noaffix# if it follows) is replaced, otherwise the # is copied
+    // and the scan goes on at the next character.
+    static const std::string noaffix {"noaffix#"} ;
+    std::string result ;
+    result. reserve (script. size ()) ;
+    long_unsigned_int n {script. size ()} ;
+    long_unsigned_int i {0} ;
+    while (i < n) {
+        long_unsigned_int hash {script. find ('#', i)} ;
+        if (hash == std::string::npos) {
+            result. append (script, i, std::string::npos) ;
+            break ;
+        }
+        result. append (script, i, hash - i) ;
+        long_unsigned_int end {hash + 1} ;
+        while ((end < n) && isdigit (static_cast<unsigned char> (script[end])))
+            end++ ;
+        bool replaced {false} ;
+        if ((end > hash + 1) && (end < n) && (script[end] == '#') &&
+            ((script[hash + 1] != '0') || (end == hash + 2)) &&
+            (end - hash - 1 <= std::to_string (replacements. size ()). size ())) {
+            long_unsigned_int number {std::stoul (script. substr (hash + 1, end - hash - 1))} ;
+            if (number < replacements. size ()) {
+                replaced = true ;
+                if (script. compare (end + 1, noaffix. size (), noaffix) == 0) {
+                    result += replacements_noaffix[number] ;
+                    i = end + 1 + noaffix. size () ;
+                } else {
+                    result += replacements[number] ;
+                    i = end + 1 ;
+                }
+            }
+        }
+        if (!replaced) {
+            result += '#' ;
+            i = hash + 1 ;
         }
-        tmpfile << line << "\n";
     }
-    infile. close () ;
-    tmpfile. close () ;
-    return tmpfilename ;
+    return result ;
 }
@@ -41,8 +41,13 @@
  * since special sequences start with a # sign, they are not even easy to pass
  * as argument as the shell might interpret the # sign as the beginning of a
  * comment.
+ *
+ * The file is read at once and the sequences are replaced in a single pass
+ * over it, whatever the number of parameters. The result is returned as a
+ * string, to be run from memory with read_lua_string(), so no temporary
+ * file is written.
  */
-std::string preprocess_file (
+std::string preprocess_script (
     const std::string &configuration_filename,
     std::vector<std::string> &replacements) ;
 
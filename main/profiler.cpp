@@ -0,0 +1,259 @@
+/**
+ * @file profiler.cpp
+ * @author Jérôme Borme <jerome.borme@inl.int>
+ * @version 1.0
+ * @brief Records the time and the work of the calls of the Lua scripts to
+ * the wrapped functions
+ * @date 2026-10-14 Jérôme Borme: Initial version
+ * @copyright
+ * This Source Code Form is subject to the terms of the Mozilla Public
+ * License, v. 2.0. If a copy of the MPL was not distributed with this
+ * file, You can obtain one at http://mozilla.org/MPL/2.0/.
+ * */
+
+#include <algorithm>
+#include <atomic>
+#include <cstdlib> // getenv(), malloc(), free()
+#include <fstream>
+#include <iomanip>
+#include <map>
+#include <new>
+#include <vector>
+
+#include "configure.h" // created by cmake
+#include "profiler.hh"
+
+#include "bad_io.hh"
+
+#ifdef OPENMP_FOUND
+#include <omp.h>
+#endif
+
+bool profiler_active {false} ;
+
+namespace {
+struct Statistics {
+    long_unsigned_int calls ;
+    double seconds ;
+    long_unsigned_int polylines ;
+    long_unsigned_int vertices ;
+    long long unsigned int bytes ;
+} ;
+
+struct Event {
+    const char *name ;
+    double start ;
+    double duration ;
+    int thread ;
+    long_unsigned_int polylines ;
+    long_unsigned_int vertices ;
+    long long unsigned int bytes ;
+} ;
+
+// Beyond this, the trace would take more memory than the script.
+const long_unsigned_int maximum_events {1000000} ;
+
+std::atomic<long long unsigned int> allocated_bytes {0} ;
+std::chrono::steady_clock::time_point profiler_start ;
+std::string trace_file ;
+bool trace_truncated {false} ;
+
+std::map<std::string, Statistics> &statistics () {
+    static std::map<std::string, Statistics> statistics ;
+    return statistics ;
+}
+
+std::vector<Event> &events () {
+    static std::vector<Event> events ;
+    return events ;
+}
+
+void *allocate (std::size_t size) {
+    if (profiler_active)
+        allocated_bytes. fetch_add (size, std::memory_order_relaxed) ;
+    // malloc (0) may return nullptr, but new must not.
+    void *p = malloc (size == 0 ? 1 : size) ;
+    if (p == nullptr)
+        throw std::bad_alloc () ;
+    return p ;
+}
+
+std::string json_escape (const std::string &s) {
+    std::string result ;
+    for (char c : s) {
+        if ((c == '"') || (c == '\\'))
+            result += '\\' ;
+        result += c ;
+    }
+    return result ;
+}
+} // namespace
+
+// The replaced operators count the bytes while the profiler is active.
+void *operator new (std::size_t size) {
+    return allocate (size) ;
+}
+
+void *operator new[] (std::size_t size) {
+    return allocate (size) ;
+}
+
+void *operator new (std::size_t size, const std::nothrow_t &) noexcept {
+    try {
+        return allocate (size) ;
+    } catch (std::bad_alloc &) {
+        return nullptr ;
+    }
+}
+
+void *operator new[] (std::size_t size, const std::nothrow_t &) noexcept {
+    try {
+        return allocate (size) ;
+    } catch (std::bad_alloc &) {
+        return nullptr ;
+    }
+}
+
+void operator delete (void *p) noexcept {
+    free (p) ;
+}
+
+void operator delete[] (void *p) noexcept {
+    free (p) ;
+}
+
+void operator delete (void *p, const std::nothrow_t &) noexcept {
+    free (p) ;
+}
+
+void operator delete[] (void *p, const std::nothrow_t &) noexcept {
+    free (p) ;
+}
+
+void enable_profiler (const std::string &trace_filename) {
+    if (!profiler_active)
+        profiler_start = std::chrono::steady_clock::now () ;
+    if (!trace_filename. empty ())
+        trace_file = trace_filename ;
+    profiler_active = true ;
+}
+
+void enable_profiler_from_environment () {
+    const char *profile {getenv ("DPPS_PROFILE")} ;
+    const char *trace {getenv ("DPPS_TRACE")} ;
+    std::string trace_filename {trace == nullptr ? "" : trace} ;
+    if (((profile != nullptr) && (profile[0] != '\0')) ||
+        (!trace_filename. empty ()))
+        enable_profiler (trace_filename) ;
+}
+
+void write_profile (std::ostream &output) {
+    if (!profiler_active)
+        return ;
+    std::vector<std::pair<std::string, Statistics>> sorted (
+        statistics (). begin (), statistics (). end ()) ;
+    std::sort (sorted. begin (), sorted. end (),
+        [] (const std::pair<std::string, Statistics> &a,
+            const std::pair<std::string, Statistics> &b) {
+            return a. second. seconds > b. second. seconds ;
+        }) ;
+    output << "dpps profile, sorted by total time:\n"
+           << std::left << std::setw (40) << "function" << std::right
+           << std::setw (10) << "calls" << std::setw (12) << "total (s)"
+           << std::setw (12) << "mean (ms)" << std::setw (12) << "polylines"
+           << std::setw (12) << "vertices" << std::setw (14) << "bytes"
+           << "\n" ;
+    for (auto &i : sorted) {
+        // the reference &s is used to avoid copy
+        const Statistics &s = i. second ;
+        output << std::left << std::setw (40) << i. first << std::right
+               << std::setw (10) << s. calls << std::fixed
+               << std::setprecision (3) << std::setw (12) << s. seconds
+               << std::setw (12) << 1000.0 * s. seconds / s. calls
+               << std::setw (12) << s. polylines << std::setw (12)
+               << s. vertices << std::setw (14) << s. bytes << "\n" ;
+    }
+    output. unsetf (std::ios_base::floatfield) ;
+    if (trace_file. empty ())
+        return ;
+    std::ofstream trace ;
+    trace. open (trace_file, std::ofstream::out|std::ofstream::trunc) ;
+    if (!trace. is_open ()) {
+        std::string reason {"write_profile: File " + trace_file +
+                            " could not be open for output"} ;
+        throw dpps::bad_io (reason. c_str ()) ;
+    }
+    // The times of the trace-event format are in microseconds.
+    trace << "{\"traceEvents\":[" ;
+    bool first {true} ;
+    for (auto &e : events ()) {
+        trace << (first ? "\n" : ",\n") << "{\"name\":\""
+              << json_escape (e. name) << "\",\"cat\":\"dpps\",\"ph\":\"X\""
+              << ",\"pid\":1,\"tid\":" << e. thread << std::fixed
+              << std::setprecision (3) << ",\"ts\":" << e. start * 1e6
+              << ",\"dur\":" << e. duration * 1e6 << ",\"args\":{"
+              << "\"polylines\":" << e. polylines << ",\"vertices\":"
+              << e. vertices << ",\"bytes\":" << e. bytes << "}}" ;
+        first = false ;
+    }
+    trace << "\n],\"displayTimeUnit\":\"ms\"}\n" ;
+    trace. close () ;
+    if (trace_truncated)
+        output << "The trace was limited to the first " << maximum_events
+               << " calls.\n" ;
+}
+
+Profiled_call::Profiled_call (const char *name) :
+    name (name), active (profiler_active) {
+    if (!active)
+        return ;
+    start_bytes = allocated_bytes. load (std::memory_order_relaxed) ;
+    start = std::chrono::steady_clock::now () ;
+}
+
+Profiled_call::~Profiled_call () {
+    if (!active)
+        return ;
+    std::chrono::steady_clock::time_point end {
+        std::chrono::steady_clock::now ()} ;
+    // Read before recording, which allocates too.
+    long long unsigned int bytes {
+        allocated_bytes. load (std::memory_order_relaxed) - start_bytes} ;
+    double seconds {std::chrono::duration<double> (end - start). count ()} ;
+    int thread {0} ;
+#ifdef OPENMP_FOUND
+    thread = omp_get_thread_num () ;
+#endif
+#ifdef OPENMP_FOUND
+    #pragma omp critical (profiler)
+#endif
+    {
+        // the reference &s is used to avoid copy
+        Statistics &s = statistics ()[name] ;
+        s. calls++ ;
+        s. seconds += seconds ;
+        s. polylines += polylines ;
+        s. vertices += vertices ;
+        s. bytes += bytes ;
+        if (!trace_file. empty ()) {
+            if (events (). size () < maximum_events)
+                events (). push_back ({name,
+                    std::chrono::duration<double> (start - profiler_start).
+                    count (), seconds, thread, polylines, vertices, bytes}) ;
+            else
+                trace_truncated = true ;
+        }
+    }
+}
+
+bool Profiled_call::is_active () const {
+    return active ;
+}
+
+void Profiled_call::add_pattern (const dpps::Pattern &pattern) {
+    if (!active)
+        return ;
+    polylines += pattern. polylines. size () ;
+    for (auto &p : pattern. polylines)
+        vertices += p. vertices. size () ;
+}
@@ -0,0 +1,71 @@
+/**
+ * @file profiler.hh
+ * @author Jérôme Borme <jerome.borme@inl.int>
+ * @version 1.0
+ * @brief Records the time and the work of the calls of the Lua scripts to
+ * the wrapped functions
+ * @date 2026-10-14 Jérôme Borme: Initial version
+ * @copyright
+ * This Source Code Form is subject to the terms of the Mozilla Public
+ * License, v. 2.0. If a copy of the MPL was not distributed with this
+ * file, You can obtain one at http://mozilla.org/MPL/2.0/.
+ * */
+
+#include <chrono>
+#include <iostream>
+#include <string>
+
+#include "common.hh"
+#include "Pattern.hh"
+
+#ifndef DPPS_PROFILER
+#define DPPS_PROFILER
+
+/** @brief true when the calls are recorded, see enable_profiler(). */
+extern bool profiler_active ;
+
+/** @brief starts recording the calls made through Profiled_call. If
+ * trace_filename is not empty, each call is also kept to be written there
+ * by write_profile() as a JSON trace-event file, which can be opened with
+ * the chrome://tracing page of Chrome or with Perfetto. */
+void enable_profiler (const std::string &trace_filename) ;
+
+/** @brief enables the profiler if the environment variable DPPS_PROFILE is
+ * set and not empty, with the trace file named by DPPS_TRACE if it is set.
+ * DPPS_TRACE alone is enough to enable it. */
+void enable_profiler_from_environment () ;
+
+/** @brief writes to output the summary of the recorded calls, one line per
+ * function, sorted by decreasing total time, and writes the trace file if
+ * one was requested. Does nothing if the profiler is not active. Throws
+ * bad_io if the trace file cannot be written. */
+void write_profile (std::ostream &output) ;
+
+/** @brief Records one call, from construction to destruction, under name.
+ *
+ * It is placed by dpps.i around each wrapped function, so that the Lua
+ * scripts are profiled without any change. The times are inclusive: a
+ * function called back by Pattern::map_vertices() is counted in both. The
+ * bytes are those allocated with operator new during the call, by all the
+ * threads, so they also include the other jobs in batch mode. When the
+ * profiler is not active, it only tests profiler_active. */
+class Profiled_call {
+protected:
+    const char *name ;
+    bool active ;
+    std::chrono::steady_clock::time_point start ;
+    long long unsigned int start_bytes {0} ;
+    long_unsigned_int polylines {0} ;
+    long_unsigned_int vertices {0} ;
+public:
+    Profiled_call (const char *name) ;
+    ~Profiled_call () ;
+
+    /** @brief true if the call is recorded. */
+    bool is_active () const ;
+
+    /** @brief adds the polylines and the vertices of pattern to the work
+     * of the call. */
+    void add_pattern (const dpps::Pattern &pattern) ;
+} ;
+#endif
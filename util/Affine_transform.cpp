@@ -0,0 +1,121 @@
+/**
+ * @file Affine_transform.cpp
+ * @author  Jérôme Borme <jerome.borme@inl.int>
+ * @version 1.0
+ * @brief A composition of affine transformations of the plane
+ * @date 2026-10-14 Jérôme Borme: Initial version
+ * @copyright
+ * This Source Code Form is subject to the terms of the Mozilla Public
+ * License, v. 2.0. If a copy of the MPL was not distributed with this
+ * file, You can obtain one at http://mozilla.org/MPL/2.0/.
+ */
+
+#include <cmath>
+#include <iostream>
+#include "Affine_transform.hh"
+#include "bad_parametre.hh"
+
+dpps::Affine_transform::Affine_transform () :
+    coefficients {{1, 0, 0,
+                   0, 1, 0}} {
+}
+
+dpps::Affine_transform::Affine_transform (
+    const double a, const double b, const double c,
+    const double d, const double e, const double f) :
+    coefficients {{a, b, c,
+                   d, e, f}} {
+}
+
+void dpps::Affine_transform::display () const {
+    std::cout << display_string () ;
+}
+
+std::string dpps::Affine_transform::display_string () const {
+    std::string result ;
+    for (short unsigned int i {0} ; i < length ; i++) {
+        result += std::to_string (coefficients[i]) ;
+        if (i % 3 == 2)
+            result += "\n" ;
+        else
+            result += " " ;
+    }
+    return result ;
+}
+
+double dpps::Affine_transform::get_coefficient (
+    const short unsigned int i) const {
+    if (i >= length) {
+        std::string reason {"Affine_transform::get_coefficient: index must be \
+between 0 and 5, got " + std::to_string (i)} ;
+        throw bad_parametre (reason. c_str ()) ;
+    }
+    return coefficients[i] ;
+}
+
+void dpps::Affine_transform::clear () {
+    coefficients = {{1, 0, 0,
+                     0, 1, 0}} ;
+}
+
+bool dpps::Affine_transform::is_identity () const {
+    return (coefficients[0] == 1) && (coefficients[1] == 0) &&
+           (coefficients[2] == 0) && (coefficients[3] == 0) &&
+           (coefficients[4] == 1) && (coefficients[5] == 0) ;
+}
+
+void dpps::Affine_transform::compose (
+    const double a, const double b, const double c,
+    const double d, const double e, const double f) {
+    const std::array<double, length> t (coefficients) ;
+    coefficients = {{a * t[0] + b * t[3],
+                     a * t[1] + b * t[4],
+                     a * t[2] + b * t[5] + c,
+                     d * t[0] + e * t[3],
+                     d * t[1] + e * t[4],
+                     d * t[2] + e * t[5] + f}} ;
+}
+
+void dpps::Affine_transform::translate (const double x, const double y) {
+    compose (1, 0, x,
+             0, 1, y) ;
+}
+
+void dpps::Affine_transform::rotate (const double x, const double y,
+                                     const double angle) {
+    double cos_angle {cos (angle)},
+           sin_angle {sin (angle)} ;
+    compose (cos_angle, -sin_angle, x - x * cos_angle + y * sin_angle,
+             sin_angle,  cos_angle, y - x * sin_angle - y * cos_angle) ;
+}
+
+void dpps::Affine_transform::scale (const double x, const double y,
+                                    const double fx, const double fy) {
+    compose (fx, 0, x - fx * x,
+             0, fy, y - fy * y) ;
+}
+
+void dpps::Affine_transform::symmetry_x (const double y0) {
+    compose (1,  0, 0,
+             0, -1, 2 * y0) ;
+}
+
+void dpps::Affine_transform::symmetry_y (const double x0) {
+    compose (-1, 0, 2 * x0,
+              0, 1, 0) ;
+}
+
+void dpps::Affine_transform::transpose () {
+    compose (0, 1, 0,
+             1, 0, 0) ;
+}
+
+void dpps::Affine_transform::then (const Affine_transform &t) {
+    compose (t. coefficients[0], t. coefficients[1], t. coefficients[2],
+             t. coefficients[3], t. coefficients[4], t. coefficients[5]) ;
+}
+
+dpps::Vertex dpps::Affine_transform::apply (const Vertex &v) const {
+    return Vertex (coefficients[0] * v. x + coefficients[1] * v. y + coefficients[2],
+                   coefficients[3] * v. x + coefficients[4] * v. y + coefficients[5]) ;
+}
@@ -0,0 +1,98 @@
+/**
+ * @file Affine_transform.hh
+ * @author  Jérôme Borme <jerome.borme@inl.int>
+ * @version 1.0
+ * @brief A composition of affine transformations of the plane
+ * @date 2026-10-14 Jérôme Borme: Initial version
+ * @copyright
+ * This Source Code Form is subject to the terms of the Mozilla Public
+ * License, v. 2.0. If a copy of the MPL was not distributed with this
+ * file, You can obtain one at http://mozilla.org/MPL/2.0/.
+ */
+
+#ifndef DPPS_AFFINE_TRANSFORM
+#define DPPS_AFFINE_TRANSFORM
+
+#include <array>
+#include <string>
+#include "Vertex.hh"
+
+namespace dpps {
+/** @brief An affine transformation of the plane, built by chaining the
+ * elementary transformations of Pattern.
+ *
+ * Calling translate, rotate, scale and so on on an Affine_transform does not
+ * move any vertex: the operations are composed into the six coefficients of
+ * a single transformation
+ *
+ *      x' = c0 x + c1 y + c2
+ *      y' = c3 x + c4 y + c5
+ *
+ * (the first two rows of a Matrix3x3), which is then applied in one pass over
+ * the vertices by Pattern::apply_transform() or Polyline::apply_transform().
+ * Operations are applied in the order they were added. A script which would
+ * call Pattern::translate, Pattern::rotate and Pattern::scale in sequence
+ * reads and writes every vertex once instead of three times.
+ *
+ * The _centred variants of Pattern have no counterpart here, since their
+ * centre is the one of each polyline at the time of the call.
+ *
+ * Unlike Matrix3x3, this class does not depend on GSL.
+ */
+class Affine_transform {
+protected:
+    static const constexpr int length {6} ;
+    std::array<double, length> coefficients ;
+
+    /** @brief replaces the transformation by the transformation followed by
+     * the one of coefficients a to f. */
+    void compose (const double a, const double b, const double c,
+                  const double d, const double e, const double f) ;
+public:
+    /** @brief the default constructor, creates the identity. */
+    Affine_transform () ;
+
+    /** @brief creates the transformation x' = a x + b y + c,
+     * y' = d x + e y + f. */
+    Affine_transform (const double a, const double b, const double c,
+                      const double d, const double e, const double f) ;
+
+    void display () const ;
+    std::string display_string () const ;
+
+    /** @brief returns coefficient i, between 0 and 5. */
+    double get_coefficient (const short unsigned int i) const ;
+
+    /** @brief resets to the identity. */
+    void clear () ;
+
+    /** @brief whether the transformation is exactly the identity. */
+    bool is_identity () const ;
+
+    /** @brief see Polyline::translate(). */
+    void translate (const double x, const double y) ;
+
+    /** @brief see Polyline::rotate(). */
+    void rotate (const double x, const double y, const double angle) ;
+
+    /** @brief see Polyline::scale(). */
+    void scale (const double x, const double y,
+                const double fx, const double fy) ;
+
+    /** @brief see Polyline::symmetry_x(). */
+    void symmetry_x (const double y0) ;
+
+    /** @brief see Polyline::symmetry_y(). */
+    void symmetry_y (const double x0) ;
+
+    /** @brief see Polyline::transpose(). */
+    void transpose () ;
+
+    /** @brief adds transformation t after the current one. */
+    void then (const Affine_transform &t) ;
+
+    /** @brief returns the image of v. */
+    Vertex apply (const Vertex &v) const ;
+} ;
+} // namespace dpps
+#endif
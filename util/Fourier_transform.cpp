@@ -0,0 +1,113 @@
+/**
+ * @file Fourier_transform.cpp
+ * @author  Jérôme Borme <jerome.borme@inl.int>
+ * @version 1.0
+ * @brief Fast Fourier transforms of complex arrays
+ * @date 2026-10-14 Jérôme Borme: Initial version
+ * @copyright
+ * This Source Code Form is subject to the terms of the Mozilla Public
+ * License, v. 2.0. If a copy of the MPL was not distributed with this
+ * file, You can obtain one at http://mozilla.org/MPL/2.0/.
+ */
+
+#include <cmath>
+#include <string>
+#include <utility>
+#include "Fourier_transform.hh"
+#include "bad_parametre.hh"
+
+dpps::Fourier_transform::Fourier_transform (
+    const long_unsigned_int set_size) :
+    size (set_size) {
+    if ((size == 0) || ((size & (size - 1)) != 0)) {
+        std::string reason {"Fourier_transform, the size must be a power of \
+two, got " + std::to_string (size) + "."} ;
+        throw bad_parametre (reason. c_str ()) ;
+    }
+    twiddles. reserve (size / 2) ;
+    for (long_unsigned_int k {0} ; k < size / 2 ; k++)
+        twiddles. push_back (std::polar (1.0, -2 * M_PI * k / size)) ;
+}
+
+long_unsigned_int dpps::Fourier_transform::get_size () const {
+    return size ;
+}
+
+void dpps::Fourier_transform::transform (std::complex<double> *data,
+                                         const bool inverse) const {
+    // The elements in bit-reversed order, so that the butterflies are done
+    // in place.
+    for (long_unsigned_int i {1}, j {0} ; i < size ; i++) {
+        long_unsigned_int bit {size >> 1} ;
+        for ( ; j & bit ; bit >>= 1)
+            j ^= bit ;
+        j ^= bit ;
+        if (i < j)
+            std::swap (data[i], data[j]) ;
+    }
+    for (long_unsigned_int length {2} ; length <= size ; length <<= 1) {
+        long_unsigned_int half {length / 2} ;
+        long_unsigned_int step {size / length} ;
+        for (long_unsigned_int start {0} ; start < size ; start += length)
+            for (long_unsigned_int k {0} ; k < half ; k++) {
+                std::complex<double> w {twiddles[k * step]} ;
+                if (inverse)
+                    w = std::conj (w) ;
+                std::complex<double> a {data[start + k]} ;
+                std::complex<double> b {data[start + k + half] * w} ;
+                data[start + k] = a + b ;
+                data[start + k + half] = a - b ;
+            }
+    }
+    if (inverse) {
+        double factor {1.0 / size} ;
+        for (long_unsigned_int i {0} ; i < size ; i++)
+            data[i] *= factor ;
+    }
+}
+
+long_unsigned_int dpps::Fourier_transform::next_power_of_two (
+    const long_unsigned_int n) {
+    long_unsigned_int result {1} ;
+    while (result < n)
+        result <<= 1 ;
+    return result ;
+}
+
+void dpps::Fourier_transform::transform_2d (
+    std::vector<std::complex<double>> &data,
+    const long_unsigned_int nx,
+    const long_unsigned_int ny,
+    const bool inverse) {
+    if (data. size () != nx * ny) {
+        std::string reason {"Fourier_transform::transform_2d, " +
+            std::to_string (nx) + " × " + std::to_string (ny) +
+            " elements expected, got " + std::to_string (data. size ()) +
+            "."} ;
+        throw bad_parametre (reason. c_str ()) ;
+    }
+    Fourier_transform rows {nx} ;
+    Fourier_transform columns {ny} ;
+#ifdef OPENMP_FOUND
+    #pragma omp parallel for schedule(static)
+#endif
+    for (long_unsigned_int j = 0 ; j < ny ; j++)
+        rows. transform (data. data () + j * nx, inverse) ;
+#ifdef OPENMP_FOUND
+    #pragma omp parallel
+#endif
+    {
+        // Each thread copies its columns to a contiguous buffer.
+        std::vector<std::complex<double>> column (ny) ;
+#ifdef OPENMP_FOUND
+        #pragma omp for schedule(static)
+#endif
+        for (long_unsigned_int i = 0 ; i < nx ; i++) {
+            for (long_unsigned_int j {0} ; j < ny ; j++)
+                column[j] = data[j * nx + i] ;
+            columns. transform (column. data (), inverse) ;
+            for (long_unsigned_int j {0} ; j < ny ; j++)
+                data[j * nx + i] = column[j] ;
+        }
+    }
+}
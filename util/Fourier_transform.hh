@@ -0,0 +1,62 @@
+/**
+ * @file Fourier_transform.hh
+ * @author  Jérôme Borme <jerome.borme@inl.int>
+ * @version 1.0
+ * @brief Fast Fourier transforms of complex arrays
+ * @date 2026-10-14 Jérôme Borme: Initial version
+ * @copyright
+ * This Source Code Form is subject to the terms of the Mozilla Public
+ * License, v. 2.0. If a copy of the MPL was not distributed with this
+ * file, You can obtain one at http://mozilla.org/MPL/2.0/.
+ */
+
+#ifndef DPPS_FOURIER_TRANSFORM
+#define DPPS_FOURIER_TRANSFORM
+
+#include <complex>
+#include <vector>
+#include "common.hh"
+
+namespace dpps {
+/** @brief The discrete Fourier transform of arrays whose size is a power of
+ * two, by the iterative radix-2 algorithm of Cooley and Tukey, in
+ * O(n log n).
+ *
+ * The coefficients exp (-2 i π k / n) are computed once by the
+ * constructor, so that the same object transforms many arrays of the same
+ * size, as the rows and the columns of transform_2d(). It only reads its
+ * members, and can be used by several threads at once.
+ *
+ * The direct transform is not normalised, the inverse transform is divided
+ * by n, so that the inverse of the direct transform is the identity. */
+class Fourier_transform {
+protected:
+    long_unsigned_int size ;
+
+    /** @brief exp (-2 i π k / size), for k from 0 to size / 2 - 1. */
+    std::vector<std::complex<double>> twiddles ;
+
+public:
+    /** @brief Constructor for arrays of set_size elements, which must be a
+     * power of two. */
+    Fourier_transform (const long_unsigned_int set_size) ;
+
+    long_unsigned_int get_size () const ;
+
+    /** @brief replaces the size elements from data by their transform. */
+    void transform (std::complex<double> *data,
+                    const bool inverse = false) const ;
+
+    /** @brief returns the smallest power of two not smaller than n. */
+    static long_unsigned_int next_power_of_two (const long_unsigned_int n) ;
+
+    /** @brief replaces data, made of ny rows of nx elements, by its two
+     * dimensional transform. nx and ny must be powers of two. The rows, then
+     * the columns, are transformed in parallel. */
+    static void transform_2d (std::vector<std::complex<double>> &data,
+                              const long_unsigned_int nx,
+                              const long_unsigned_int ny,
+                              const bool inverse = false) ;
+} ;
+} // namespace dpps
+#endif
@@ -548,6 +548,78 @@ dpps::Vertex dpps::Matrix3x3::apply_homography (const Vertex &v) const {
     return Vertex (x, y) ;
 }
 
+bool dpps::Matrix3x3::is_affine () const {
+    return (coefficients[6] == 0) && (coefficients[7] == 0) &&
+           (coefficients[8] == 1) ;
+}
+
+// The coefficients are copied first, so that the compiler knows that they do
+// not change when the coordinates are written, and the operations are those
+// of apply (const Vertex &) and apply_homography (const Vertex &) in the same
+// order, to give the same result.
+DPPS_MULTIVERSION
+void dpps::Matrix3x3::apply (Vertex *v, const long_unsigned_int n) const {
+    const double a {coefficients[0]}, b {coefficients[1]}, c {coefficients[2]} ;
+    const double d {coefficients[3]}, e {coefficients[4]}, f {coefficients[5]} ;
+    for (long_unsigned_int j {0} ; j < n ; j++) {
+        const double x {v[j]. x} ;
+        const double y {v[j]. y} ;
+        v[j]. x = a*x + b*y + c ;
+        v[j]. y = d*x + e*y + f ;
+    }
+}
+
+DPPS_MULTIVERSION
+void dpps::Matrix3x3::apply_homography (Vertex *v,
+                                        const long_unsigned_int n) const {
+    if (is_affine ()) {
+        apply (v, n) ;
+        return ;
+    }
+    const double a {coefficients[0]}, b {coefficients[1]}, c {coefficients[2]} ;
+    const double d {coefficients[3]}, e {coefficients[4]}, f {coefficients[5]} ;
+    const double g {coefficients[6]}, h {coefficients[7]}, i {coefficients[8]} ;
+    for (long_unsigned_int j {0} ; j < n ; j++) {
+        const double x {v[j]. x} ;
+        const double y {v[j]. y} ;
+        const double denominator {x*g + y*h + i} ;
+        v[j]. x = (x*a + y*b + c) / denominator ;
+        v[j]. y = (x*d + y*e + f) / denominator ;
+    }
+}
+
+DPPS_MULTIVERSION
+void dpps::Matrix3x3::apply (double *x, double *y,
+                             const long_unsigned_int n) const {
+    const double a {coefficients[0]}, b {coefficients[1]}, c {coefficients[2]} ;
+    const double d {coefficients[3]}, e {coefficients[4]}, f {coefficients[5]} ;
+    for (long_unsigned_int j {0} ; j < n ; j++) {
+        const double x1 {x[j]} ;
+        const double y1 {y[j]} ;
+        x[j] = a*x1 + b*y1 + c ;
+        y[j] = d*x1 + e*y1 + f ;
+    }
+}
+
+DPPS_MULTIVERSION
+void dpps::Matrix3x3::apply_homography (double *x, double *y,
+                                        const long_unsigned_int n) const {
+    if (is_affine ()) {
+        apply (x, y, n) ;
+        return ;
+    }
+    const double a {coefficients[0]}, b {coefficients[1]}, c {coefficients[2]} ;
+    const double d {coefficients[3]}, e {coefficients[4]}, f {coefficients[5]} ;
+    const double g {coefficients[6]}, h {coefficients[7]}, i {coefficients[8]} ;
+    for (long_unsigned_int j {0} ; j < n ; j++) {
+        const double x1 {x[j]} ;
+        const double y1 {y[j]} ;
+        const double denominator {x1*g + y1*h + i} ;
+        x[j] = (x1*a + y1*b + c) / denominator ;
+        y[j] = (x1*d + y1*e + f) / denominator ;
+    }
+}
+
 // dpps::Matrix3x3 dpps::Matrix3x3::matrix3x3_multiply (const Matrix3x3 &a, const Matrix3x3 &b) {
 //     return Matrix3x3(a.coefficients[0]*b.coefficients[0]+a.coefficients[1]*b.coefficients[3]+a.coefficients[2]*b.coefficients[6], a.coefficients[0]*b.coefficients[1]+a.coefficients[1]*b.coefficients[4]+a.coefficients[2]*b.coefficients[7], a.coefficients[0]*b.coefficients[2]+a.coefficients[1]*b.coefficients[5]+a.coefficients[2]*b.coefficients[8],
 //              a.coefficients[3]*b.coefficients[0]+a.coefficients[4]*b.coefficients[3]+a.coefficients[5]*b.coefficients[6], a.coefficients[3]*b.coefficients[1]+a.coefficients[4]*b.coefficients[4]+a.coefficients[5]*b.coefficients[7], a.coefficients[3]*b.coefficients[2]+a.coefficients[4]*b.coefficients[5]+a.coefficients[5]*b.coefficients[8],
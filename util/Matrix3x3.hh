@@ -184,6 +184,28 @@ static Matrix3x3 translation (const Vertex &a0, const Vertex &b0) ;
 Vertex apply (const Vertex &v) const ;
 
 Vertex apply_homography (const Vertex &v) const ;
+
+/** @brief Returns true if the last row is (0, 0, 1), so that
+ * apply_homography() gives the same result as apply(), without the
+ * division. */
+bool is_affine () const ;
+
+/** @brief Replaces each of the n vertices from v by its image by apply(),
+ * in one loop which the compiler can vectorise. */
+void apply (Vertex *v, const long_unsigned_int n) const ;
+
+/** @brief Replaces each of the n vertices from v by its image by
+ * apply_homography(). If is_affine(), it calls apply() instead. */
+void apply_homography (Vertex *v, const long_unsigned_int n) const ;
+
+/** @brief The same as apply() for the n points of coordinates x[i], y[i],
+ * stored in two arrays. */
+void apply (double *x, double *y, const long_unsigned_int n) const ;
+
+/** @brief The same as apply_homography() for the n points of coordinates
+ * x[i], y[i], stored in two arrays. */
+void apply_homography (double *x, double *y,
+                       const long_unsigned_int n) const ;
 #endif
 
 // static Matrix3x3 matrix3x3_multiply (const Matrix3x3 &a, const Matrix3x3 &b) ;
@@ -47,6 +47,20 @@
 #define M_PI 3.14159535897
 #endif
 
+// With the cmake option MULTIVERSION, the functions marked DPPS_MULTIVERSION
+// are compiled for several instruction sets, and the best one for the
+// processor is chosen when the program starts, so that one binary is fast on
+// all the machines.
+// The functions they call are compiled in each version only if inlined,
+// which DPPS_INLINE_MULTIVERSION forces.
+#ifdef MULTIVERSION_FOUND
+#define DPPS_MULTIVERSION __attribute__ ((target_clones ("avx2", "sse4.2", "default")))
+#define DPPS_INLINE_MULTIVERSION inline __attribute__ ((always_inline))
+#else
+#define DPPS_MULTIVERSION
+#define DPPS_INLINE_MULTIVERSION inline
+#endif
+
 // The type holding the selection. The number of bits will define it has
 // will define the number of selection that can be used.
 #define selection_t int8_t
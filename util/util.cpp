@@ -15,6 +15,13 @@
 #include <chrono>
 #include <iostream>
 #include <math.h> // exp
+#include <cstdio> // snprintf
+#include <cstdlib> // strtod
+#include <cctype> // tolower
+#include "configure.h"
+#ifdef OPENMP_FOUND
+#include <omp.h>
+#endif
 #include "util.hh"
 #include "bad_parametre.hh"
 
@@ -30,6 +37,14 @@ std::string dpps::remove_affix (const std::string &input) {
     }
 }
 
+bool dpps::is_gzip_filename (const std::string &filename) {
+    if (filename. size () < 3)
+        return false ;
+    std::string affix {filename. substr (filename. size () - 3)} ;
+    return (affix[0] == '.') && (tolower (affix[1]) == 'g') &&
+           (tolower (affix[2]) == 'z') ;
+}
+
 std::vector<std::string> dpps::split_string (const std::string &input,
                                              const char delimiter,
                                              const bool ignore_empty) {
@@ -80,11 +95,25 @@ void dpps::sanitize_EOL (std::string &line) {
         line. pop_back () ;
 }
 
+// The numbers are converted by snprintf rather than by an ostringstream,
+// which is several times slower. "%.*g" with precision 6 and "%.*f" are the
+// conversions used by the streams, so the result is the same.
+static std::string print_number (const char *format, const int precision,
+                                 const double value) {
+    char buffer[64] ;
+    int length {snprintf (buffer, sizeof (buffer), format, precision, value)} ;
+    if (length < static_cast<int> (sizeof (buffer)))
+        return std::string (buffer, length) ;
+    // only for large numbers in fixed notation
+    std::string result (length + 1, '\0') ;
+    snprintf (&result[0], result. size (), format, precision, value) ;
+    result. resize (length) ;
+    return result ;
+}
+
 std::string dpps::normal_number (const double value,
                                  const bool showpoint) {
-    std::ostringstream converted ;
-    converted << value ;
-    std::string result {converted. str ()} ;
+    std::string result {print_number ("%.*g", 6, value)} ;
     // We only remove extra zeros when it is using decimal representation,
     // (no exponent, so only 0-9.-+[space]) and there actually is a point
     if (result. find_first_not_of ("0123456789.-+ ") == std::string::npos) {
@@ -101,9 +130,7 @@ std::string dpps::normal_number (const double value,
 std::string dpps::fixed_number (const double value,
                                 const int precision,
                                 const bool showpoint) {
-    std::ostringstream converted ;
-    converted << std::fixed << std::setprecision (precision) << value ;
-    std::string result {converted. str ()} ;
+    std::string result {print_number ("%.*f", precision, value)} ;
     if (result. find ('.') != std::string::npos) {
         while (result. back () == '0')
             result. pop_back () ;
@@ -115,9 +142,7 @@ std::string dpps::fixed_number (const double value,
 
 double dpps::fixed_number_value (const double value, const int precision) {
     std::string number {fixed_number(value, precision, false)} ;
-    double result ;
-    std::istringstream (number) >> result ;
-    return result ;
+    return strtod (number. c_str (), nullptr) ;
 }
 
 bool dpps::logical_operation (const bool p, const bool q,
@@ -256,6 +281,26 @@ compile-time maximum, " + std::to_string ((long_unsigned_int)polyline_max_select
     }
 }
 
+void dpps::set_number_threads (const int number_threads) {
+#ifdef OPENMP_FOUND
+    static const int default_number_threads {omp_get_max_threads ()} ;
+    if (number_threads <= 0)
+        omp_set_num_threads (default_number_threads) ;
+    else
+        omp_set_num_threads (number_threads) ;
+#else
+    (void) number_threads ;
+#endif
+}
+
+int dpps::get_number_threads () {
+#ifdef OPENMP_FOUND
+    return omp_get_max_threads () ;
+#else
+    return 1 ;
+#endif
+}
+
 std::string dpps::current_date_string () {
     std::chrono::system_clock::time_point tp {
         std::chrono::system_clock::now ()} ;
@@ -279,7 +324,7 @@ bool dpps::remove_from_to (std::string &line, const std::string &from, const std
     return false ;
 }
 
-long_unsigned_int dpps::vector_string_find (const std::vector<std::string> vec, const std::string target) {
+long_unsigned_int dpps::vector_string_find (const std::vector<std::string> &vec, const std::string &target) {
     for (long_unsigned_int j = 0 ; j < vec. size () ; j++)
         if (target == vec[j])
             return j ;
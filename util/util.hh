@@ -13,6 +13,7 @@
 #include <vector>
 #include <string>
 #include <algorithm>
+#include <limits>
 
 #include "common.hh"
 
@@ -86,6 +87,10 @@ inline std::string remove_spaces_right (std::string input) {
 
 std::string remove_affix (const std::string &input) ;
 
+/** @brief returns true if filename ends with .gz, in any case, which the
+ * readers and the writers then decompress or compress. */
+bool is_gzip_filename (const std::string &filename) ;
+
 void sanitize_EOL (std::string &line) ;
 
 /** @brief returns the string representing a number in a normal representation
@@ -120,13 +125,24 @@ std::string vector_to_string (const std::vector<std::string> list, const char se
 void check_selection_not_negative_not_too_high(selection_t THE_SELECTION) ;
 void check_selection_not_too_high(selection_t THE_SELECTION) ;
 
+/** @brief sets the number of threads used by the operations of Pattern which
+ * work on each polyline independently.
+ *
+ * A value of 0 or less restores the default, which is one thread per core.
+ * Without OpenMP (cmake option USE_OPENMP), this has no effect. */
+void set_number_threads (const int number_threads) ;
+
+/** @brief returns the number of threads used by the operations of Pattern
+ * which work on each polyline independently, 1 without OpenMP. */
+int get_number_threads () ;
+
 static constexpr int polyline_max_selection {
     std::numeric_limits<selection_t>::digits} ;
 
 std::string current_date_string () ;
 
 bool remove_from_to (std::string &line, const std::string &from, const std::string &to) ;
-long_unsigned_int vector_string_find (const std::vector<std::string> vec, const std::string target) ;
+long_unsigned_int vector_string_find (const std::vector<std::string> &vec, const std::string &target) ;
 
 /** @brief downconverts from utf8 to iso8859-1, removing characters which
  * cannot be converted */